@@ -0,0 +1,514 @@
+#include "BenchReport.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace RayTraceVS::Bench
+{
+    // ============================================
+    // Minimal JSON reader (baseline files only)
+    // ============================================
+
+    namespace
+    {
+        struct JsonValue
+        {
+            enum class Type { Null, Bool, Number, String, Array, Object };
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+            std::vector<JsonValue> array;
+            std::vector<std::pair<std::string, JsonValue>> object;
+
+            const JsonValue* Find(const std::string& key) const
+            {
+                for (const auto& member : object)
+                {
+                    if (member.first == key)
+                        return &member.second;
+                }
+                return nullptr;
+            }
+        };
+
+        class JsonReader
+        {
+        public:
+            explicit JsonReader(const std::string& text) : text(text) {}
+
+            bool Parse(JsonValue& out)
+            {
+                if (!ParseValue(out))
+                    return false;
+                SkipWhitespace();
+                return pos == text.size();
+            }
+
+        private:
+            const std::string& text;
+            size_t pos = 0;
+
+            void SkipWhitespace()
+            {
+                while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos])))
+                    pos++;
+            }
+
+            bool Match(const char* literal)
+            {
+                size_t len = strlen(literal);
+                if (text.compare(pos, len, literal) != 0)
+                    return false;
+                pos += len;
+                return true;
+            }
+
+            bool ParseString(std::string& out)
+            {
+                if (pos >= text.size() || text[pos] != '"')
+                    return false;
+                pos++;
+                out.clear();
+                while (pos < text.size() && text[pos] != '"')
+                {
+                    char c = text[pos++];
+                    if (c == '\\' && pos < text.size())
+                    {
+                        char e = text[pos++];
+                        switch (e)
+                        {
+                            case 'n': out.push_back('\n'); break;
+                            case 't': out.push_back('\t'); break;
+                            case 'r': out.push_back('\r'); break;
+                            case 'b': out.push_back('\b'); break;
+                            case 'f': out.push_back('\f'); break;
+                            case 'u':
+                                // Report files are ASCII; keep the escape verbatim
+                                out += "\\u";
+                                break;
+                            default: out.push_back(e); break;
+                        }
+                    }
+                    else
+                    {
+                        out.push_back(c);
+                    }
+                }
+                if (pos >= text.size())
+                    return false;
+                pos++;
+                return true;
+            }
+
+            bool ParseValue(JsonValue& out)
+            {
+                SkipWhitespace();
+                if (pos >= text.size())
+                    return false;
+
+                char c = text[pos];
+                if (c == '{')
+                {
+                    out.type = JsonValue::Type::Object;
+                    pos++;
+                    SkipWhitespace();
+                    if (pos < text.size() && text[pos] == '}')
+                    {
+                        pos++;
+                        return true;
+                    }
+                    while (true)
+                    {
+                        SkipWhitespace();
+                        std::string key;
+                        if (!ParseString(key))
+                            return false;
+                        SkipWhitespace();
+                        if (pos >= text.size() || text[pos] != ':')
+                            return false;
+                        pos++;
+                        JsonValue value;
+                        if (!ParseValue(value))
+                            return false;
+                        out.object.emplace_back(std::move(key), std::move(value));
+                        SkipWhitespace();
+                        if (pos < text.size() && text[pos] == ',')
+                        {
+                            pos++;
+                            continue;
+                        }
+                        if (pos < text.size() && text[pos] == '}')
+                        {
+                            pos++;
+                            return true;
+                        }
+                        return false;
+                    }
+                }
+                if (c == '[')
+                {
+                    out.type = JsonValue::Type::Array;
+                    pos++;
+                    SkipWhitespace();
+                    if (pos < text.size() && text[pos] == ']')
+                    {
+                        pos++;
+                        return true;
+                    }
+                    while (true)
+                    {
+                        JsonValue value;
+                        if (!ParseValue(value))
+                            return false;
+                        out.array.push_back(std::move(value));
+                        SkipWhitespace();
+                        if (pos < text.size() && text[pos] == ',')
+                        {
+                            pos++;
+                            continue;
+                        }
+                        if (pos < text.size() && text[pos] == ']')
+                        {
+                            pos++;
+                            return true;
+                        }
+                        return false;
+                    }
+                }
+                if (c == '"')
+                {
+                    out.type = JsonValue::Type::String;
+                    return ParseString(out.string);
+                }
+                if (Match("true"))
+                {
+                    out.type = JsonValue::Type::Bool;
+                    out.boolean = true;
+                    return true;
+                }
+                if (Match("false"))
+                {
+                    out.type = JsonValue::Type::Bool;
+                    out.boolean = false;
+                    return true;
+                }
+                if (Match("null"))
+                {
+                    out.type = JsonValue::Type::Null;
+                    return true;
+                }
+
+                const char* begin = text.c_str() + pos;
+                char* end = nullptr;
+                out.number = strtod(begin, &end);
+                if (end == begin)
+                    return false;
+                out.type = JsonValue::Type::Number;
+                pos += static_cast<size_t>(end - begin);
+                return true;
+            }
+        };
+
+        std::string EscapeJson(const std::string& value)
+        {
+            std::string result;
+            result.reserve(value.size());
+            for (char c : value)
+            {
+                switch (c)
+                {
+                    case '"':  result += "\\\""; break;
+                    case '\\': result += "\\\\"; break;
+                    case '\n': result += "\\n"; break;
+                    case '\t': result += "\\t"; break;
+                    default:   result.push_back(c); break;
+                }
+            }
+            return result;
+        }
+
+        std::string FormatNumber(double value)
+        {
+            if (!std::isfinite(value))
+                return "0";
+            char buf[64];
+            sprintf_s(buf, "%.6g", value);
+            return buf;
+        }
+
+        double Mean(const std::vector<double>& values)
+        {
+            if (values.empty())
+                return 0.0;
+            double sum = 0.0;
+            for (double v : values)
+                sum += v;
+            return sum / static_cast<double>(values.size());
+        }
+
+        // Nearest-rank percentile on a sorted copy
+        double Percentile(std::vector<double> values, double p)
+        {
+            if (values.empty())
+                return 0.0;
+            std::sort(values.begin(), values.end());
+            size_t rank = static_cast<size_t>(ceil(p * static_cast<double>(values.size())));
+            rank = (std::clamp)(rank, static_cast<size_t>(1), values.size());
+            return values[rank - 1];
+        }
+
+        // Lower-is-better for timings, higher-is-better for throughput
+        bool IsHigherBetter(const std::string& metric)
+        {
+            return metric.rfind("mrays_", 0) == 0;
+        }
+    }
+
+    // ============================================
+    // Aggregation
+    // ============================================
+
+    std::string GetBenchRunKey(const BenchRun& run)
+    {
+        std::string key = run.info.name + "_" + std::to_string(run.info.requestedCount);
+        return run.backend.empty() ? key : key + "_" + run.backend;
+    }
+
+    void AggregateBenchRun(BenchRun& run, const std::vector<BenchFrameSample>& samples)
+    {
+        std::vector<double> wall, gpuFrame, buildCpu, buildGpu, photon, trace, post;
+        double radianceRays = 0.0, shadowRays = 0.0, photonRays = 0.0;
+        double traceMsTotal = 0.0, photonMsTotal = 0.0;
+        int rebuilds = 0, refits = 0;
+        bool rayCountsMeasured = !samples.empty();
+
+        for (const auto& sample : samples)
+        {
+            const auto& s = sample.stats;
+            wall.push_back(sample.wallMs);
+            buildCpu.push_back(s.accelerationStructureCpuMs);
+            rebuilds += s.accelerationStructureRebuilt ? 1 : 0;
+            refits += s.accelerationStructureRefit ? 1 : 0;
+
+            radianceRays += static_cast<double>(s.radianceRays);
+            shadowRays += static_cast<double>(s.shadowRays);
+            photonRays += static_cast<double>(s.photonRays);
+            rayCountsMeasured = rayCountsMeasured && s.rayCountsMeasured != 0;
+
+            if (s.gpuTimingValid)
+            {
+                gpuFrame.push_back(s.frameGpuMs);
+                buildGpu.push_back(s.accelerationStructureGpuMs);
+                photon.push_back(s.photonGpuMs);
+                trace.push_back(s.traceGpuMs);
+                post.push_back(s.postProcessGpuMs);
+                traceMsTotal += s.traceGpuMs;
+                photonMsTotal += s.photonGpuMs;
+            }
+            else
+            {
+                // No GPU timestamps: attribute the whole frame to tracing
+                traceMsTotal += sample.wallMs;
+            }
+        }
+
+        auto& m = run.metrics;
+        m["frame_ms_mean"] = Mean(wall);
+        m["frame_ms_p50"] = Percentile(wall, 0.50);
+        m["frame_ms_p95"] = Percentile(wall, 0.95);
+        m["frame_ms_min"] = wall.empty() ? 0.0 : *std::min_element(wall.begin(), wall.end());
+        m["frame_ms_max"] = wall.empty() ? 0.0 : *std::max_element(wall.begin(), wall.end());
+        m["first_frame_ms"] = run.firstFrameMs;
+        m["gpu_frame_ms_mean"] = Mean(gpuFrame);
+        m["as_build_cpu_ms_mean"] = Mean(buildCpu);
+        m["as_build_gpu_ms_mean"] = Mean(buildGpu);
+        m["photon_gpu_ms_mean"] = Mean(photon);
+        m["trace_gpu_ms_mean"] = Mean(trace);
+        m["post_gpu_ms_mean"] = Mean(post);
+
+        // rays / ms / 1000 = Mrays/s
+        auto MRaysPerSecond = [](double rays, double ms) { return (ms > 0.0) ? rays / ms / 1000.0 : 0.0; };
+        // The GPU radiance/shadow/thickness counts are nominal (dispatch size x settings), so
+        // dividing them by the trace time would only restate the frame time, and a change that
+        // traces fewer rays would read as a throughput gain. Per-kind throughput and ray counts
+        // are reported only where rays are counted (CPU backend); the photon count is exact.
+        if (rayCountsMeasured)
+        {
+            const double frameCount = static_cast<double>(samples.size());
+            m["rays_radiance_per_frame"] = radianceRays / frameCount;
+            m["rays_shadow_per_frame"] = shadowRays / frameCount;
+            m["mrays_radiance"] = MRaysPerSecond(radianceRays, traceMsTotal);
+            m["mrays_shadow"] = MRaysPerSecond(shadowRays, traceMsTotal);
+            m["mrays_total"] = MRaysPerSecond(radianceRays + shadowRays, traceMsTotal);
+        }
+        if (photonRays > 0.0)
+            m["mrays_photon"] = MRaysPerSecond(photonRays, photonMsTotal);
+        m["as_rebuild_ratio"] = samples.empty() ? 0.0 : static_cast<double>(rebuilds) / static_cast<double>(samples.size());
+        // Share of acceleration structure updates that were handled by refitting alone
+        m["as_refit_ratio"] = (rebuilds > 0) ? static_cast<double>(refits) / static_cast<double>(rebuilds) : 0.0;
+    }
+
+    // ============================================
+    // Report output
+    // ============================================
+
+    bool WriteBenchReport(const std::string& path, const BenchSettings& settings,
+        const std::vector<BenchRun>& runs, const std::vector<BenchComparison>* comparisons)
+    {
+        std::ostringstream json;
+        json << "{\n";
+        json << "  \"benchmark\": \"RayTraceVS.Bench\",\n";
+        json << "  \"version\": 1,\n";
+        json << "  \"settings\": { \"width\": " << settings.width
+             << ", \"height\": " << settings.height
+             << ", \"warmupFrames\": " << settings.warmupFrames
+             << ", \"frames\": " << settings.frames << " },\n";
+        json << "  \"runs\": [\n";
+        for (size_t r = 0; r < runs.size(); r++)
+        {
+            const auto& run = runs[r];
+            json << "    {\n";
+            json << "      \"key\": \"" << EscapeJson(GetBenchRunKey(run)) << "\",\n";
+            json << "      \"scene\": { \"kind\": \"" << EscapeJson(run.info.name) << "\""
+                 << ", \"requested\": " << run.info.requestedCount
+                 << ", \"spheres\": " << run.info.spheres
+                 << ", \"planes\": " << run.info.planes
+                 << ", \"boxes\": " << run.info.boxes
+                 << ", \"meshInstances\": " << run.info.meshInstances
+                 << ", \"meshTriangles\": " << run.info.meshTriangles
+                 << ", \"pagedMeshBytes\": " << run.info.pagedMeshBytes
+                 << ", \"lights\": " << run.info.lights
+                 << ", \"seed\": " << run.params.seed << " },\n";
+            json << "      \"render\": { \"samplesPerPixel\": " << run.params.samplesPerPixel
+                 << ", \"maxBounces\": " << run.params.maxBounces
+                 << ", \"russianRouletteMinDepth\": " << run.params.russianRouletteMinDepth
+                 << ", \"denoiser\": " << (run.params.enableDenoiser ? "true" : "false") << " },\n";
+            json << "      \"metrics\": {\n";
+            size_t i = 0;
+            for (const auto& metric : run.metrics)
+            {
+                json << "        \"" << EscapeJson(metric.first) << "\": " << FormatNumber(metric.second)
+                     << (++i < run.metrics.size() ? ",\n" : "\n");
+            }
+            json << "      }\n";
+            json << "    }" << (r + 1 < runs.size() ? ",\n" : "\n");
+        }
+        json << "  ]";
+
+        if (comparisons)
+        {
+            size_t regressions = 0;
+            for (const auto& c : *comparisons)
+                regressions += c.regression ? 1 : 0;
+
+            json << ",\n  \"comparison\": {\n";
+            json << "    \"regressions\": " << regressions << ",\n";
+            json << "    \"metrics\": [\n";
+            for (size_t i = 0; i < comparisons->size(); i++)
+            {
+                const auto& c = (*comparisons)[i];
+                json << "      { \"run\": \"" << EscapeJson(c.run) << "\""
+                     << ", \"metric\": \"" << EscapeJson(c.metric) << "\""
+                     << ", \"baseline\": " << FormatNumber(c.baseline)
+                     << ", \"current\": " << FormatNumber(c.current)
+                     << ", \"changePercent\": " << FormatNumber(c.changePercent)
+                     << ", \"regression\": " << (c.regression ? "true" : "false") << " }"
+                     << (i + 1 < comparisons->size() ? ",\n" : "\n");
+            }
+            json << "    ]\n";
+            json << "  }";
+        }
+        json << "\n}\n";
+
+        if (path.empty() || path == "-")
+        {
+            fputs(json.str().c_str(), stdout);
+            return true;
+        }
+
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file << json.str();
+        return file.good();
+    }
+
+    // ============================================
+    // Baseline comparison
+    // ============================================
+
+    bool LoadBenchBaseline(const std::string& path, std::map<std::string, std::map<std::string, double>>& outRuns)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string text = buffer.str();
+
+        JsonValue root;
+        JsonReader reader(text);
+        if (!reader.Parse(root) || root.type != JsonValue::Type::Object)
+            return false;
+
+        const JsonValue* runs = root.Find("runs");
+        if (!runs || runs->type != JsonValue::Type::Array)
+            return false;
+
+        for (const auto& run : runs->array)
+        {
+            const JsonValue* key = run.Find("key");
+            const JsonValue* metrics = run.Find("metrics");
+            if (!key || key->type != JsonValue::Type::String || !metrics || metrics->type != JsonValue::Type::Object)
+                continue;
+
+            auto& target = outRuns[key->string];
+            for (const auto& metric : metrics->object)
+            {
+                if (metric.second.type == JsonValue::Type::Number)
+                    target[metric.first] = metric.second.number;
+            }
+        }
+        return true;
+    }
+
+    std::vector<BenchComparison> CompareWithBaseline(const std::vector<BenchRun>& runs,
+        const std::map<std::string, std::map<std::string, double>>& baseline, double tolerancePercent)
+    {
+        std::vector<BenchComparison> result;
+        for (const auto& run : runs)
+        {
+            std::string key = GetBenchRunKey(run);
+            auto baseRun = baseline.find(key);
+            if (baseRun == baseline.end())
+                continue;
+
+            for (const auto& metric : run.metrics)
+            {
+                auto baseMetric = baseRun->second.find(metric.first);
+                if (baseMetric == baseRun->second.end() || fabs(baseMetric->second) < 1e-9)
+                    continue;
+
+                BenchComparison c;
+                c.run = key;
+                c.metric = metric.first;
+                c.baseline = baseMetric->second;
+                c.current = metric.second;
+                double delta = (c.current - c.baseline) / fabs(c.baseline) * 100.0;
+                c.changePercent = IsHigherBetter(metric.first) ? delta : -delta;
+                // Ratios and counters are informational only
+                bool comparable = metric.first.find("_ms") != std::string::npos || IsHigherBetter(metric.first);
+                c.regression = comparable && c.changePercent < -tolerancePercent;
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Benchmark result aggregation, JSON output and baseline comparison.
+
+#include "BenchScenes.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace RayTraceVS::Bench
+{
+    // One measured frame (wall clock + engine frame statistics)
+    struct BenchFrameSample
+    {
+        double wallMs = 0.0;
+        Interop::Bridge::FrameStatsNative stats = {};
+    };
+
+    struct BenchSettings
+    {
+        int width = 1280;
+        int height = 720;
+        int warmupFrames = 3;
+        int frames = 30;
+    };
+
+    // Aggregated result of one scene run
+    struct BenchRun
+    {
+        BenchSceneParams params;
+        BenchSceneInfo info;
+        std::string backend;                      // Empty = GPU, "cpu_wavefront" / "cpu_depthfirst"
+        double firstFrameMs = 0.0;                // Cold frame: AS build + first trace
+        std::map<std::string, double> metrics;    // Flat metric name -> value
+    };
+
+    struct BenchComparison
+    {
+        std::string run;
+        std::string metric;
+        double baseline = 0.0;
+        double current = 0.0;
+        double changePercent = 0.0;   // Positive = better
+        bool regression = false;
+    };
+
+    // Reduces per-frame samples to flat metrics (means, percentiles; ray counts and Mrays/s per
+    // ray kind where rays are counted, i.e. the CPU backend)
+    void AggregateBenchRun(BenchRun& run, const std::vector<BenchFrameSample>& samples);
+
+    // Writes the machine-readable report (optionally including a baseline comparison)
+    bool WriteBenchReport(const std::string& path, const BenchSettings& settings,
+        const std::vector<BenchRun>& runs, const std::vector<BenchComparison>* comparisons);
+
+    // Loads run-name -> metrics from a report previously written by WriteBenchReport
+    bool LoadBenchBaseline(const std::string& path, std::map<std::string, std::map<std::string, double>>& outRuns);
+
+    // Compares runs against a baseline; a metric regresses if it is worse by more than tolerancePercent
+    std::vector<BenchComparison> CompareWithBaseline(const std::vector<BenchRun>& runs,
+        const std::map<std::string, std::map<std::string, double>>& baseline, double tolerancePercent);
+
+    // Unique run key ("spheres_32", "wineglass_64", "glass_16_cpu_wavefront", ...)
+    std::string GetBenchRunKey(const BenchRun& run);
+}
@@ -0,0 +1,451 @@
+#include "BenchScenes.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+using namespace RayTraceVS::Interop;
+
+namespace RayTraceVS::Bench
+{
+    static const char* const WINE_GLASS_MESH_NAME = "Bench_WineGlass";
+
+    // ============================================
+    // Helpers
+    // ============================================
+
+    static Bridge::Vector3Native Vec3(float x, float y, float z)
+    {
+        return { x, y, z };
+    }
+
+    static Bridge::MaterialNative MakeDiffuse(float r, float g, float b, float roughness = 0.6f)
+    {
+        Bridge::MaterialNative m = {};
+        m.color = { r, g, b, 1.0f };
+        m.metallic = 0.0f;
+        m.roughness = roughness;
+        m.transmission = 0.0f;
+        m.ior = 1.5f;
+        m.specular = 0.5f;
+        return m;
+    }
+
+    static Bridge::MaterialNative MakeMetal(float r, float g, float b, float roughness)
+    {
+        Bridge::MaterialNative m = MakeDiffuse(r, g, b, roughness);
+        m.metallic = 1.0f;
+        return m;
+    }
+
+    static Bridge::MaterialNative MakeGlass(float absorption)
+    {
+        Bridge::MaterialNative m = MakeDiffuse(1.0f, 1.0f, 1.0f, 0.0f);
+        m.transmission = 1.0f;
+        m.ior = 1.5f;
+        m.absorption = { absorption * 0.2f, absorption * 0.05f, absorption * 0.1f };
+        return m;
+    }
+
+    static void AddGroundPlane(RayTraceVS::DXEngine::Scene* scene, BenchSceneInfo& info)
+    {
+        Bridge::PlaneDataNative plane = {};
+        plane.position = Vec3(0.0f, 0.0f, 0.0f);
+        plane.normal = Vec3(0.0f, 1.0f, 0.0f);
+        plane.material = MakeDiffuse(0.8f, 0.8f, 0.8f, 0.8f);
+        Bridge::AddPlane(scene, plane);
+        info.planes++;
+    }
+
+    // One ambient + one directional light, plus lightCount point lights on a ring
+    static void AddBenchLights(RayTraceVS::DXEngine::Scene* scene, int lightCount, float ringRadius, BenchSceneInfo& info)
+    {
+        Bridge::LightDataNative ambient = {};
+        ambient.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+        ambient.intensity = 0.1f;
+        ambient.type = 0;
+        Bridge::AddLight(scene, ambient);
+        info.lights++;
+
+        Bridge::LightDataNative sun = {};
+        sun.position = Vec3(-0.4f, -1.0f, 0.3f);
+        sun.color = { 1.0f, 0.95f, 0.9f, 1.0f };
+        sun.intensity = 1.0f;
+        sun.type = 2;
+        sun.softShadowSamples = 1.0f;
+        Bridge::AddLight(scene, sun);
+        info.lights++;
+
+        int pointLights = (std::clamp)(lightCount, 0, ENGINE_MAX_LIGHTS - info.lights);
+        for (int i = 0; i < pointLights; i++)
+        {
+            float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>((std::max)(pointLights, 1));
+            Bridge::LightDataNative light = {};
+            light.position = Vec3(cosf(angle) * ringRadius, 4.0f + 0.5f * static_cast<float>(i % 3), sinf(angle) * ringRadius);
+            light.color = { 1.0f, 0.9f + 0.1f * static_cast<float>(i % 2), 0.85f, 1.0f };
+            light.intensity = 12.0f / static_cast<float>((std::max)(pointLights, 1));
+            light.type = 1;
+            light.radius = 0.2f;
+            light.softShadowSamples = 1.0f;
+            Bridge::AddLight(scene, light);
+            info.lights++;
+        }
+    }
+
+    static void SetBenchCamera(RayTraceVS::DXEngine::Scene* scene, float extent, float aspectRatio)
+    {
+        Bridge::CameraDataNative camera = {};
+        camera.position = Vec3(0.0f, extent * 0.6f + 2.0f, -(extent * 1.2f + 4.0f));
+        camera.lookAt = Vec3(0.0f, 0.5f, 0.0f);
+        camera.up = Vec3(0.0f, 1.0f, 0.0f);
+        camera.fov = 60.0f;
+        camera.aspectRatio = aspectRatio;
+        camera.apertureSize = 0.0f;
+        camera.focusDistance = 10.0f;
+        Bridge::SetCamera(scene, camera);
+    }
+
+    // Rotation about Y (yaw) followed by X (pitch); returns the rotated basis as OBB axes
+    static void MakeBoxAxes(float yaw, float pitch, Bridge::BoxDataNative& box)
+    {
+        float cy = cosf(yaw), sy = sinf(yaw);
+        float cp = cosf(pitch), sp = sinf(pitch);
+        box.axisX = Vec3(cy, 0.0f, -sy);
+        box.axisY = Vec3(sy * sp, cp, cy * sp);
+        box.axisZ = Vec3(sy * cp, -sp, cy * cp);
+    }
+
+    // ============================================
+    // Wine glass mesh (surface of revolution)
+    // ============================================
+
+    // Builds a single-walled wine glass around +Y with its foot at y = 0.
+    // Vertex layout matches MeshCacheDataNative: pos3 + pad + normal3 + pad.
+    // detail multiplies the lathe segments and subdivides every profile segment, so the
+    // triangle count grows with its square (about 1250 triangles at 1)
+    static void BuildWineGlassMesh(std::vector<float>& vertices, std::vector<uint32_t>& indices,
+        Bridge::Vector3Native& boundsMin, Bridge::Vector3Native& boundsMax, int detail)
+    {
+        // Profile (radius, height) from the foot to the rim
+        static const float baseProfile[][2] =
+        {
+            { 0.00f, 0.00f }, { 0.30f, 0.00f }, { 0.32f, 0.02f }, { 0.20f, 0.04f },
+            { 0.05f, 0.07f }, { 0.035f, 0.20f }, { 0.035f, 0.45f }, { 0.06f, 0.52f },
+            { 0.16f, 0.58f }, { 0.25f, 0.68f }, { 0.30f, 0.82f }, { 0.31f, 0.95f },
+            { 0.29f, 1.08f }, { 0.27f, 1.15f }
+        };
+        const int baseCount = static_cast<int>(sizeof(baseProfile) / sizeof(baseProfile[0]));
+        detail = (std::max)(detail, 1);
+        const int segments = 48 * detail;
+
+        std::vector<std::array<float, 2>> profile;
+        for (int p = 0; p + 1 < baseCount; p++)
+        {
+            for (int step = 0; step < detail; step++)
+            {
+                float t = static_cast<float>(step) / static_cast<float>(detail);
+                profile.push_back({ baseProfile[p][0] + t * (baseProfile[p + 1][0] - baseProfile[p][0]),
+                    baseProfile[p][1] + t * (baseProfile[p + 1][1] - baseProfile[p][1]) });
+            }
+        }
+        profile.push_back({ baseProfile[baseCount - 1][0], baseProfile[baseCount - 1][1] });
+        const int profileCount = static_cast<int>(profile.size());
+
+        vertices.clear();
+        indices.clear();
+        vertices.reserve(static_cast<size_t>(profileCount) * (segments + 1) * 8);
+
+        float maxRadius = 0.0f;
+        float maxHeight = 0.0f;
+        for (int p = 0; p < profileCount; p++)
+        {
+            // Profile normal from the averaged tangent of the adjacent segments
+            int prev = (std::max)(p - 1, 0);
+            int next = (std::min)(p + 1, profileCount - 1);
+            float dr = profile[next][0] - profile[prev][0];
+            float dy = profile[next][1] - profile[prev][1];
+            float len = sqrtf(dr * dr + dy * dy);
+            float nr = (len > 0.0f) ? dy / len : 0.0f;
+            float ny = (len > 0.0f) ? -dr / len : 1.0f;
+
+            maxRadius = (std::max)(maxRadius, profile[p][0]);
+            maxHeight = (std::max)(maxHeight, profile[p][1]);
+
+            for (int s = 0; s <= segments; s++)
+            {
+                float angle = 6.2831853f * static_cast<float>(s) / static_cast<float>(segments);
+                float c = cosf(angle), sn = sinf(angle);
+                vertices.push_back(profile[p][0] * c);
+                vertices.push_back(profile[p][1]);
+                vertices.push_back(profile[p][0] * sn);
+                vertices.push_back(0.0f);
+                vertices.push_back(nr * c);
+                vertices.push_back(ny);
+                vertices.push_back(nr * sn);
+                vertices.push_back(0.0f);
+            }
+        }
+
+        const uint32_t ringSize = segments + 1;
+        for (int p = 0; p + 1 < profileCount; p++)
+        {
+            for (int s = 0; s < segments; s++)
+            {
+                uint32_t i0 = p * ringSize + s;
+                uint32_t i1 = i0 + 1;
+                uint32_t i2 = i0 + ringSize;
+                uint32_t i3 = i2 + 1;
+                indices.push_back(i0); indices.push_back(i2); indices.push_back(i1);
+                indices.push_back(i1); indices.push_back(i2); indices.push_back(i3);
+            }
+        }
+
+        boundsMin = Vec3(-maxRadius, 0.0f, -maxRadius);
+        boundsMax = Vec3(maxRadius, maxHeight, maxRadius);
+    }
+
+    // ============================================
+    // Generators
+    // ============================================
+
+    static void GenerateRandomSpheres(RayTraceVS::DXEngine::Scene* scene, int count, std::mt19937& rng, BenchSceneInfo& info)
+    {
+        int n = (std::clamp)(count, 1, ENGINE_MAX_SPHERES);
+        float extent = 2.0f + sqrtf(static_cast<float>(n));
+        std::uniform_real_distribution<float> pos(-extent, extent);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (int i = 0; i < n; i++)
+        {
+            Bridge::SphereDataNative sphere = {};
+            sphere.radius = 0.3f + 0.5f * unit(rng);
+            sphere.center = Vec3(pos(rng), sphere.radius, pos(rng));
+
+            float pick = unit(rng);
+            if (pick < 0.6f)
+                sphere.material = MakeDiffuse(unit(rng), unit(rng), unit(rng));
+            else if (pick < 0.85f)
+                sphere.material = MakeMetal(0.9f, 0.8f, 0.6f, 0.05f + 0.4f * unit(rng));
+            else
+                sphere.material = MakeGlass(0.5f);
+
+            Bridge::AddSphere(scene, sphere);
+            info.spheres++;
+        }
+    }
+
+    static void GenerateBoxGrid(RayTraceVS::DXEngine::Scene* scene, int count, std::mt19937& rng, BenchSceneInfo& info)
+    {
+        int n = (std::clamp)(count, 1, ENGINE_MAX_BOXES);
+        int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(n))));
+        const float spacing = 1.6f;
+        float offset = 0.5f * spacing * static_cast<float>(side - 1);
+        std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (int i = 0; i < n; i++)
+        {
+            Bridge::BoxDataNative box = {};
+            float halfSize = 0.3f + 0.2f * unit(rng);
+            box.size = Vec3(halfSize, halfSize * (0.5f + unit(rng)), halfSize);
+            box.center = Vec3(
+                static_cast<float>(i % side) * spacing - offset,
+                box.size.y + 0.3f,
+                static_cast<float>(i / side) * spacing - offset);
+            MakeBoxAxes(angle(rng), 0.5f * angle(rng), box);
+            box.material = (i % 4 == 3) ? MakeMetal(0.8f, 0.8f, 0.85f, 0.2f) : MakeDiffuse(unit(rng), unit(rng), unit(rng));
+            Bridge::AddBox(scene, box);
+            info.boxes++;
+        }
+    }
+
+    static void GenerateGlassHeavy(RayTraceVS::DXEngine::Scene* scene, int count, std::mt19937& rng, BenchSceneInfo& info)
+    {
+        int n = (std::max)(count, 2);
+        int sphereCount = (std::min)(n / 2 + n % 2, ENGINE_MAX_SPHERES);
+        int boxCount = (std::min)(n / 2, ENGINE_MAX_BOXES);
+        int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(sphereCount + boxCount))));
+        const float spacing = 1.4f;
+        float offset = 0.5f * spacing * static_cast<float>(side - 1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (int i = 0; i < sphereCount + boxCount; i++)
+        {
+            float x = static_cast<float>(i % side) * spacing - offset;
+            float z = static_cast<float>(i / side) * spacing - offset;
+            if (i < sphereCount)
+            {
+                Bridge::SphereDataNative sphere = {};
+                sphere.radius = 0.5f;
+                sphere.center = Vec3(x, sphere.radius, z);
+                sphere.material = MakeGlass(0.2f + unit(rng));
+                Bridge::AddSphere(scene, sphere);
+                info.spheres++;
+            }
+            else
+            {
+                Bridge::BoxDataNative box = {};
+                box.size = Vec3(0.4f, 0.4f, 0.4f);
+                box.center = Vec3(x, 0.45f, z);
+                MakeBoxAxes(unit(rng) * 3.14159265f, 0.0f, box);
+                box.material = MakeGlass(0.2f + unit(rng));
+                Bridge::AddBox(scene, box);
+                info.boxes++;
+            }
+        }
+    }
+
+    static void GenerateWineGlassInstances(RayTraceVS::DXEngine::Scene* scene, const BenchSceneParams& params, std::mt19937& rng, BenchSceneInfo& info)
+    {
+        if (!params.pagedMeshPath.empty())
+        {
+            // Registered from the file: only its header and chunk table are read
+            Bridge::PagedMeshInfoNative paged = {};
+            if (Bridge::AddPagedMeshCache(scene, WINE_GLASS_MESH_NAME, params.pagedMeshPath.c_str(), &paged))
+            {
+                info.meshTriangles = static_cast<int>(paged.triangleCount);
+                info.pagedMeshBytes = paged.fileBytes;
+            }
+            else
+            {
+                info.pagedMeshFailed = true;
+            }
+        }
+        else
+        {
+            std::vector<float> vertices;
+            std::vector<uint32_t> indices;
+            Bridge::MeshCacheDataNative cache = {};
+            BuildWineGlassMesh(vertices, indices, cache.boundsMin, cache.boundsMax, params.meshDetail);
+            cache.name = WINE_GLASS_MESH_NAME;
+            cache.vertices = vertices.data();
+            cache.vertexCount = static_cast<uint32_t>(vertices.size() / 8);
+            cache.indices = indices.data();
+            cache.indexCount = static_cast<uint32_t>(indices.size());
+            cache.spatialSplits = 1;    // Lathe mesh: long thin triangles along the stem
+            Bridge::AddMeshCache(scene, cache);
+            info.meshTriangles = static_cast<int>(indices.size() / 3);
+        }
+
+        int n = (std::max)(params.count, 1);
+        int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(n))));
+        const float spacing = 0.8f;
+        float offset = 0.5f * spacing * static_cast<float>(side - 1);
+        std::uniform_real_distribution<float> yaw(0.0f, 360.0f);
+
+        for (int i = 0; i < n; i++)
+        {
+            Bridge::MeshInstanceDataNative instance = {};
+            instance.meshName = WINE_GLASS_MESH_NAME;
+            instance.position = Vec3(static_cast<float>(i % side) * spacing - offset, 0.0f, static_cast<float>(i / side) * spacing - offset);
+            instance.rotation = Vec3(0.0f, yaw(rng), 0.0f);
+            instance.scale = Vec3(1.0f, 1.0f, 1.0f);
+            instance.material = MakeGlass(0.3f);
+            Bridge::AddMeshInstance(scene, instance);
+            info.meshInstances++;
+        }
+    }
+
+    // ============================================
+    // Public API
+    // ============================================
+
+    bool ParseBenchSceneKind(const std::string& text, BenchSceneKind& outKind)
+    {
+        if (text == "spheres")   { outKind = BenchSceneKind::Spheres;   return true; }
+        if (text == "boxes")     { outKind = BenchSceneKind::BoxGrid;   return true; }
+        if (text == "glass")     { outKind = BenchSceneKind::Glass;     return true; }
+        if (text == "wineglass") { outKind = BenchSceneKind::WineGlass; return true; }
+        if (text == "lights")    { outKind = BenchSceneKind::Lights;    return true; }
+        return false;
+    }
+
+    const char* GetBenchSceneKindName(BenchSceneKind kind)
+    {
+        switch (kind)
+        {
+            case BenchSceneKind::Spheres:   return "spheres";
+            case BenchSceneKind::BoxGrid:   return "boxes";
+            case BenchSceneKind::Glass:     return "glass";
+            case BenchSceneKind::WineGlass: return "wineglass";
+            case BenchSceneKind::Lights:    return "lights";
+        }
+        return "unknown";
+    }
+
+    std::vector<BenchSceneParams> GetDefaultBenchSuite()
+    {
+        std::vector<BenchSceneParams> suite;
+
+        BenchSceneParams spheres;
+        spheres.kind = BenchSceneKind::Spheres;
+        spheres.count = 32;
+        suite.push_back(spheres);
+
+        BenchSceneParams boxes;
+        boxes.kind = BenchSceneKind::BoxGrid;
+        boxes.count = 32;
+        suite.push_back(boxes);
+
+        BenchSceneParams glass;
+        glass.kind = BenchSceneKind::Glass;
+        glass.count = 16;
+        suite.push_back(glass);
+
+        BenchSceneParams wineGlass;
+        wineGlass.kind = BenchSceneKind::WineGlass;
+        wineGlass.count = 64;
+        suite.push_back(wineGlass);
+
+        BenchSceneParams lights;
+        lights.kind = BenchSceneKind::Lights;
+        lights.count = 16;
+        lights.lightCount = ENGINE_MAX_LIGHTS;
+        suite.push_back(lights);
+
+        return suite;
+    }
+
+    BenchSceneInfo BuildBenchScene(RayTraceVS::DXEngine::Scene* scene, const BenchSceneParams& params, float aspectRatio)
+    {
+        BenchSceneInfo info;
+        info.name = GetBenchSceneKindName(params.kind);
+        info.requestedCount = params.count;
+
+        std::mt19937 rng(params.seed);
+
+        Bridge::SetRenderSettings(scene,
+            params.samplesPerPixel, params.maxBounces, 2,
+            1.0f, 2, 1.0f, 1.0f, 4.0f,
+            params.enableDenoiser, 2.2f, 0, 1.0f,
+            1.0f, 0.0f, 0.01f, 2, 8.0f, 2.0f);
+        Bridge::SetEnvironment(scene, params.environmentPath.c_str(), 1.0f, !params.environmentPath.empty());
+        Bridge::SetRussianRouletteMinDepth(scene, params.russianRouletteMinDepth);
+
+        AddGroundPlane(scene, info);
+
+        switch (params.kind)
+        {
+            case BenchSceneKind::Spheres:
+                GenerateRandomSpheres(scene, params.count, rng, info);
+                break;
+            case BenchSceneKind::BoxGrid:
+                GenerateBoxGrid(scene, params.count, rng, info);
+                break;
+            case BenchSceneKind::Glass:
+                GenerateGlassHeavy(scene, params.count, rng, info);
+                break;
+            case BenchSceneKind::WineGlass:
+                GenerateWineGlassInstances(scene, params, rng, info);
+                break;
+            case BenchSceneKind::Lights:
+                GenerateRandomSpheres(scene, params.count, rng, info);
+                break;
+        }
+
+        float extent = 2.0f + sqrtf(static_cast<float>((std::max)(params.count, 1)));
+        AddBenchLights(scene, params.lightCount, extent, info);
+        SetBenchCamera(scene, extent, aspectRatio);
+        return info;
+    }
+}
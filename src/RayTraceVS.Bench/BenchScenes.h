@@ -0,0 +1,69 @@
+#pragma once
+
+// Procedural scene generators for the rendering benchmark.
+// All scenes are deterministic for a given seed so that runs are comparable.
+
+#include "NativeBridge.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RayTraceVS::Bench
+{
+    // Engine-side buffer capacities (see DXRPipeline::CreateBuffers / MAX_SCENE_LIGHTS).
+    // Generators clamp to these so oversized requests do not overrun the upload buffers.
+    static constexpr int ENGINE_MAX_SPHERES = 32;
+    static constexpr int ENGINE_MAX_PLANES = 32;
+    static constexpr int ENGINE_MAX_BOXES = 32;
+    static constexpr int ENGINE_MAX_LIGHTS = 256;
+
+    enum class BenchSceneKind
+    {
+        Spheres,     // N random spheres (diffuse / metal / glass mix)
+        BoxGrid,     // N rotated boxes (OBB) on a grid
+        Glass,       // N glass spheres and boxes with absorption
+        WineGlass,   // K instances of a shared wine-glass mesh
+        Lights       // L point lights over a small sphere field
+    };
+
+    struct BenchSceneParams
+    {
+        BenchSceneKind kind = BenchSceneKind::Spheres;
+        int count = 32;            // Spheres / boxes / mesh instances (depending on kind)
+        int lightCount = 2;        // Point lights (plus one directional)
+        uint32_t seed = 1234;
+
+        int samplesPerPixel = 1;
+        int maxBounces = 8;
+        int russianRouletteMinDepth = 3;    // Bounces after which Russian roulette may end a path
+        bool enableDenoiser = false;
+        std::wstring environmentPath;   // Radiance .hdr; empty = built-in sky (environment lighting off)
+        int meshDetail = 1;             // WineGlass: lathe segments and profile rings are multiplied by this
+        std::wstring pagedMeshPath;     // WineGlass: instance this .rtvsm instead of generating the mesh;
+                                        // its vertices are never loaded into memory (CPU only)
+    };
+
+    // What the generator actually produced (after clamping to engine limits)
+    struct BenchSceneInfo
+    {
+        std::string name;
+        int requestedCount = 0;
+        int spheres = 0;
+        int planes = 0;
+        int boxes = 0;
+        int meshInstances = 0;
+        int meshTriangles = 0;     // Triangles in the shared mesh cache(s)
+        int lights = 0;
+        uint64_t pagedMeshBytes = 0;    // Size of the registered .rtvsm (0 = mesh generated in memory)
+        bool pagedMeshFailed = false;   // pagedMeshPath could not be registered
+    };
+
+    bool ParseBenchSceneKind(const std::string& text, BenchSceneKind& outKind);
+    const char* GetBenchSceneKindName(BenchSceneKind kind);
+
+    // Default suite used by "--scene all"
+    std::vector<BenchSceneParams> GetDefaultBenchSuite();
+
+    // Fills an empty native scene (camera, settings, objects, lights)
+    BenchSceneInfo BuildBenchScene(RayTraceVS::DXEngine::Scene* scene, const BenchSceneParams& params, float aspectRatio);
+}
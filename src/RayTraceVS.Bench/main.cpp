@@ -0,0 +1,606 @@
+// RayTraceVS.Bench - rendering benchmark
+//
+// Renders procedurally generated scenes through the DXEngine bridge and reports
+// acceleration-structure build time, frame time and (CPU backend) traced rays and Mrays/s
+// per ray kind as JSON.
+//
+// Usage:
+//   RayTraceVS.Bench.exe [--scene spheres|boxes|glass|wineglass|lights|all] [--count N]
+//                        [--lights L] [--width W] [--height H] [--frames F] [--warmup W]
+//                        [--spp S] [--bounces B] [--rr-min-depth D] [--denoiser] [--seed S]
+//                        [--out result.json] [--baseline baseline.json] [--tolerance PCT]
+//                        [--cpu wavefront|depthfirst] [--env sky.hdr]
+//                        [--stream NAME] [--watch NAME] [--snapshot-dir DIR]
+//                        [--mesh-budget-mb MB] [--paged-dir DIR] [--stream-budget-mb MB]
+//                        [--mesh-detail N] [--paged-mesh FILE.rtvsm]
+//
+// With --cpu, frames are rendered by the CPU path tracer instead of the GPU pipeline and
+// run keys get a "_cpu_<mode>" suffix, so both schedules can be compared in one report.
+// With --baseline, each metric is compared to the baseline run with the same key and the
+// process exits with code 2 if any timing/throughput metric regressed beyond --tolerance.
+// --rr-min-depth sets the bounces after which Russian roulette may end a path (default 3;
+// --bounces stays the hard limit).
+// With --env, scenes are lit by the given equirectangular .hdr (environment light sampling on).
+// With --stream, every measured frame is also published to the shared-memory frame channel
+// NAME (GPU: RGBA8, CPU: RGBA32F radiance). --watch NAME runs as the viewer side instead:
+// it polls the channel, reads each frame in place and prints it, for --frames frames.
+// With --snapshot-dir, every generated scene is saved as DIR/<run>.rtvsb and the run renders
+// the scene loaded back from that snapshot (save/load times are printed).
+// --mesh-budget-mb sets the byte budget of mesh BLASes cached across runs (GPU pipeline and
+// CPU tracer); mesh residency (resident/peak MB, hits, evictions) is printed after each run.
+// With --paged-dir (CPU only), the meshes of every scene are written as paged files DIR/<key>.rtvsm
+// and streamed in chunks while rendering; --stream-budget-mb sets the memory budget of resident
+// chunks, and the streaming statistics are printed after each run.
+// --mesh-detail multiplies the wine glass tessellation (triangles grow with its square), e.g. to
+// write a large paged file with --paged-dir. --paged-mesh (CPU only) instances an existing .rtvsm
+// in the wineglass scene without ever loading its vertices; the process peak working set is then
+// checked against the file size and the exit code is 2 if it is not below it.
+
+#include <windows.h>
+#include <psapi.h>
+#include "NativeBridge.h"
+#include "BenchScenes.h"
+#include "BenchReport.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RayTraceVS;
+using namespace RayTraceVS::Bench;
+using namespace RayTraceVS::Interop;
+
+namespace
+{
+    struct BenchOptions
+    {
+        BenchSettings settings;
+        std::vector<BenchSceneParams> scenes;
+        std::string outPath = "bench_result.json";
+        std::string baselinePath;
+        double tolerancePercent = 5.0;
+        std::string cpuMode;        // Empty = GPU, otherwise "wavefront" or "depthfirst"
+        std::string streamName;     // Frame channel to publish frames to
+        std::string watchName;      // Frame channel to read frames from (viewer mode)
+        std::string snapshotDir;    // Round-trip every scene through a binary snapshot here
+        int meshBudgetMB = -1;      // < 0 = engine default
+        std::string pagedDir;       // Stream mesh geometry from paged files written here (CPU only)
+        int streamBudgetMB = -1;    // < 0 = engine default
+    };
+
+    // Peak working set of the process so far (bytes)
+    uint64_t GetPeakWorkingSetBytes()
+    {
+        PROCESS_MEMORY_COUNTERS counters = {};
+        counters.cb = sizeof(counters);
+        return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+    }
+
+    void PrintUsage()
+    {
+        fprintf(stderr,
+            "Usage: RayTraceVS.Bench [--scene spheres|boxes|glass|wineglass|lights|all] [--count N]\n"
+            "                        [--lights L] [--width W] [--height H] [--frames F] [--warmup W]\n"
+            "                        [--spp S] [--bounces B] [--rr-min-depth D] [--denoiser] [--seed S]\n"
+            "                        [--out result.json|-] [--baseline baseline.json] [--tolerance PCT]\n"
+            "                        [--cpu wavefront|depthfirst] [--env sky.hdr]\n"
+            "                        [--stream NAME] [--watch NAME] [--snapshot-dir DIR]\n"
+            "                        [--mesh-budget-mb MB] [--paged-dir DIR] [--stream-budget-mb MB]\n"
+            "                        [--mesh-detail N] [--paged-mesh FILE.rtvsm]\n");
+    }
+
+    bool ParseOptions(int argc, char** argv, BenchOptions& options)
+    {
+        std::string sceneName = "all";
+        BenchSceneParams base;
+        bool countSet = false, lightsSet = false;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto NextValue = [&]() -> const char*
+            {
+                return (i + 1 < argc) ? argv[++i] : nullptr;
+            };
+
+            const char* value = nullptr;
+            if (arg == "--denoiser")
+            {
+                base.enableDenoiser = true;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h")
+            {
+                return false;
+            }
+
+            value = NextValue();
+            if (!value)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+
+            if (arg == "--scene")           sceneName = value;
+            else if (arg == "--count")      { base.count = atoi(value); countSet = true; }
+            else if (arg == "--lights")     { base.lightCount = atoi(value); lightsSet = true; }
+            else if (arg == "--width")      options.settings.width = atoi(value);
+            else if (arg == "--height")     options.settings.height = atoi(value);
+            else if (arg == "--frames")     options.settings.frames = atoi(value);
+            else if (arg == "--warmup")     options.settings.warmupFrames = atoi(value);
+            else if (arg == "--spp")        base.samplesPerPixel = atoi(value);
+            else if (arg == "--bounces")    base.maxBounces = atoi(value);
+            else if (arg == "--rr-min-depth") base.russianRouletteMinDepth = atoi(value);
+            else if (arg == "--seed")       base.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            else if (arg == "--out")        options.outPath = value;
+            else if (arg == "--baseline")   options.baselinePath = value;
+            else if (arg == "--tolerance")  options.tolerancePercent = atof(value);
+            else if (arg == "--cpu")        options.cpuMode = value;
+            else if (arg == "--env")        base.environmentPath = std::filesystem::path(value).wstring();
+            else if (arg == "--stream")     options.streamName = value;
+            else if (arg == "--watch")      options.watchName = value;
+            else if (arg == "--snapshot-dir") options.snapshotDir = value;
+            else if (arg == "--mesh-budget-mb") options.meshBudgetMB = atoi(value);
+            else if (arg == "--paged-dir")  options.pagedDir = value;
+            else if (arg == "--stream-budget-mb") options.streamBudgetMB = atoi(value);
+            else if (arg == "--mesh-detail") base.meshDetail = atoi(value);
+            else if (arg == "--paged-mesh") base.pagedMeshPath = std::filesystem::path(value).wstring();
+            else
+            {
+                fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        if (options.settings.width <= 0 || options.settings.height <= 0 || options.settings.frames <= 0)
+        {
+            fprintf(stderr, "Invalid resolution or frame count\n");
+            return false;
+        }
+        if (options.settings.warmupFrames < 0)
+            options.settings.warmupFrames = 0;
+        if (!options.cpuMode.empty() && options.cpuMode != "wavefront" && options.cpuMode != "depthfirst")
+        {
+            fprintf(stderr, "Unknown CPU mode: %s\n", options.cpuMode.c_str());
+            return false;
+        }
+        if (!base.pagedMeshPath.empty() && options.cpuMode.empty())
+        {
+            fprintf(stderr, "--paged-mesh needs --cpu (the GPU pipeline does not render paged meshes)\n");
+            return false;
+        }
+
+        if (sceneName == "all")
+        {
+            for (auto params : GetDefaultBenchSuite())
+            {
+                params.seed = base.seed;
+                params.samplesPerPixel = base.samplesPerPixel;
+                params.maxBounces = base.maxBounces;
+                params.russianRouletteMinDepth = base.russianRouletteMinDepth;
+                params.enableDenoiser = base.enableDenoiser;
+                params.environmentPath = base.environmentPath;
+                params.meshDetail = base.meshDetail;
+                params.pagedMeshPath = base.pagedMeshPath;
+                if (lightsSet)
+                    params.lightCount = base.lightCount;
+                options.scenes.push_back(params);
+            }
+            return true;
+        }
+
+        if (!ParseBenchSceneKind(sceneName, base.kind))
+        {
+            fprintf(stderr, "Unknown scene: %s\n", sceneName.c_str());
+            return false;
+        }
+        if (!countSet && base.kind == BenchSceneKind::WineGlass)
+            base.count = 64;
+        options.scenes.push_back(base);
+        return true;
+    }
+
+    // DXContext needs a window for its swap chain; the benchmark never shows it
+    HWND CreateHiddenWindow(int width, int height)
+    {
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = DefWindowProcW;
+        wc.hInstance = GetModuleHandleW(nullptr);
+        wc.lpszClassName = L"RayTraceVSBenchWindow";
+        RegisterClassExW(&wc);
+
+        return CreateWindowExW(0, wc.lpszClassName, L"RayTraceVS.Bench", WS_OVERLAPPEDWINDOW,
+            CW_USEDEFAULT, CW_USEDEFAULT, width, height, nullptr, nullptr, wc.hInstance, nullptr);
+    }
+
+    double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Renders one frame the same way EngineWrapper::Render does and waits for completion
+    double RenderFrame(DXEngine::DXContext* context, DXEngine::DXRPipeline* pipeline,
+        DXEngine::RenderTarget* target, DXEngine::Scene* scene)
+    {
+        Bridge::WaitForGPU(context);
+        auto start = std::chrono::high_resolution_clock::now();
+        Bridge::ResetCommandList(context);
+        Bridge::RenderTestPattern(pipeline, target, scene);
+        Bridge::ExecuteCommandList(context);
+        Bridge::WaitForGPU(context);
+        return ElapsedMs(start);
+    }
+
+    // Copies the finished frame to the readback buffer and publishes it (not timed)
+    void StreamFrame(DXEngine::DXContext* context, DXEngine::RenderTarget* target, DXEngine::FrameChannel* channel)
+    {
+        Bridge::ResetCommandList(context);
+        Bridge::CopyRenderTargetToReadback(target, context);
+        Bridge::ExecuteCommandList(context);
+        Bridge::WaitForGPU(context);
+        Bridge::ResolveRenderTargetToChannel(target, channel, 0);
+    }
+
+    // Renders one frame on the CPU path tracer; its ray counts and build time are reported
+    // through the same FrameStatsNative fields as GPU frames (no GPU timings). With a
+    // channel the radiance is written straight into its next slot.
+    double RenderFrameCpu(DXEngine::CpuPathTracer* tracer, DXEngine::Scene* scene, const BenchSettings& settings,
+        const BenchSceneParams& params, bool wavefront, int frameIndex, std::vector<float>& radiance,
+        DXEngine::FrameChannel* channel, Bridge::FrameStatsNative* outStats)
+    {
+        Bridge::CpuRenderSettingsNative cpuSettings = {};
+        cpuSettings.width = settings.width;
+        cpuSettings.height = settings.height;
+        cpuSettings.samplesPerPixel = params.samplesPerPixel;
+        cpuSettings.maxBounces = params.maxBounces;
+        cpuSettings.russianRouletteMinDepth = params.russianRouletteMinDepth;
+        cpuSettings.frameIndex = frameIndex;
+        cpuSettings.wavefront = wavefront ? 1 : 0;
+        radiance.resize(static_cast<size_t>(settings.width) * settings.height * 4);
+
+        Bridge::CpuRenderStatsNative cpuStats = {};
+        auto start = std::chrono::high_resolution_clock::now();
+        if (channel)
+            Bridge::RenderSceneCpuToChannel(tracer, scene, cpuSettings, channel, &cpuStats);
+        else
+            Bridge::RenderSceneCpu(tracer, scene, cpuSettings, radiance.data(), static_cast<int>(radiance.size()), &cpuStats);
+        double wallMs = ElapsedMs(start);
+
+        if (outStats)
+        {
+            *outStats = {};
+            // As on the GPU: "rebuilt" counts any update, "refit" one without a full build
+            outStats->accelerationStructureRebuilt = (cpuStats.bvhBuilds + cpuStats.bvhRefits) > 0 ? 1 : 0;
+            outStats->accelerationStructureRefit = (cpuStats.bvhRefits > 0 && cpuStats.bvhBuilds == 0) ? 1 : 0;
+            outStats->accelerationStructureCpuMs = cpuStats.buildMs;
+            outStats->radianceRays = cpuStats.extensionRays;
+            outStats->shadowRays = cpuStats.shadowRays;
+            outStats->rayCountsMeasured = 1;
+        }
+        if (cpuStats.droppedRays > 0)
+        {
+            fprintf(stderr, "[bench] frame %d: depth-first dropped %llu child rays (work stack full)\n",
+                frameIndex, static_cast<unsigned long long>(cpuStats.droppedRays));
+        }
+        return wallMs;
+    }
+
+    // Viewer side of --stream: polls the channel and reads every new frame in place
+    int WatchFrameChannel(const std::string& name, int frames)
+    {
+        DXEngine::FrameChannel* channel = nullptr;
+        for (int attempt = 0; attempt < 100 && !channel; attempt++)
+        {
+            channel = Bridge::OpenFrameChannel(name.c_str());
+            if (!channel)
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (!channel)
+        {
+            fprintf(stderr, "Failed to open frame channel: %s\n", name.c_str());
+            return 1;
+        }
+
+        int received = 0, torn = 0;
+        auto lastFrameTime = std::chrono::high_resolution_clock::now();
+        while (received < frames && ElapsedMs(lastFrameTime) < 10000.0)
+        {
+            Bridge::FrameViewNative frame = {};
+            if (!Bridge::AcquireChannelFrame(channel, &frame))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Mean of the first channel, read directly from shared memory
+            double sum = 0.0;
+            for (int y = 0; y < frame.height; y++)
+            {
+                const unsigned char* row = frame.data + static_cast<size_t>(y) * frame.rowPitch;
+                for (int x = 0; x < frame.width; x++)
+                {
+                    if (frame.format == 2)
+                        sum += reinterpret_cast<const float*>(row)[x * 4];
+                    else
+                        sum += row[x * 4] / 255.0;
+                }
+            }
+            if (!Bridge::ReleaseChannelFrame(channel))
+            {
+                torn++;
+                continue;
+            }
+
+            const double sinceLastMs = ElapsedMs(lastFrameTime);
+            lastFrameTime = std::chrono::high_resolution_clock::now();
+            received++;
+            fprintf(stderr, "[watch] frame %llu: %dx%d format %d mean %.4f (+%.1f ms)\n",
+                static_cast<unsigned long long>(frame.frameNumber), frame.width, frame.height, frame.format,
+                sum / (static_cast<double>(frame.width) * frame.height), sinceLastMs);
+        }
+
+        fprintf(stderr, "[watch] %d frames received, %d discarded (overwritten while reading)\n", received, torn);
+        Bridge::DestroyFrameChannel(channel);
+        return received > 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (!options.watchName.empty())
+    {
+        return WatchFrameChannel(options.watchName, options.settings.frames);
+    }
+
+    const BenchSettings& settings = options.settings;
+    HWND hwnd = CreateHiddenWindow(settings.width, settings.height);
+    if (!hwnd)
+    {
+        fprintf(stderr, "Failed to create benchmark window\n");
+        return 1;
+    }
+
+    DXEngine::DXContext* context = Bridge::CreateDXContext();
+    if (!Bridge::InitializeDXContext(context, hwnd, settings.width, settings.height))
+    {
+        fprintf(stderr, "Failed to initialize DirectX context\n");
+        Bridge::DestroyDXContext(context);
+        DestroyWindow(hwnd);
+        return 1;
+    }
+
+    DXEngine::DXRPipeline* pipeline = Bridge::CreateDXRPipeline(context);
+    if (!Bridge::InitializeDXRPipeline(pipeline))
+    {
+        fprintf(stderr, "Warning: DXR pipeline initialization failed, results use the compute fallback\n");
+    }
+    const uint64_t meshBudgetBytes = options.meshBudgetMB >= 0 ? static_cast<uint64_t>(options.meshBudgetMB) << 20 : 0;
+    if (options.meshBudgetMB >= 0)
+        Bridge::SetMeshResidencyBudget(pipeline, meshBudgetBytes);
+
+    DXEngine::RenderTarget* target = Bridge::CreateRenderTarget(context);
+    if (!Bridge::InitializeRenderTarget(target, settings.width, settings.height))
+    {
+        fprintf(stderr, "Failed to initialize render target\n");
+        Bridge::DestroyRenderTarget(target);
+        Bridge::DestroyDXRPipeline(pipeline);
+        Bridge::ShutdownDXContext(context);
+        Bridge::DestroyDXContext(context);
+        DestroyWindow(hwnd);
+        return 1;
+    }
+
+    const float aspectRatio = static_cast<float>(settings.width) / static_cast<float>(settings.height);
+    const bool useCpu = !options.cpuMode.empty();
+    DXEngine::CpuPathTracer* cpuTracer = useCpu ? Bridge::CreateCpuPathTracer() : nullptr;
+    std::vector<float> cpuRadiance;
+    std::vector<BenchRun> runs;
+
+    DXEngine::FrameChannel* channel = nullptr;
+    if (!options.streamName.empty())
+    {
+        channel = Bridge::CreateFrameChannel(options.streamName.c_str(), settings.width, settings.height, useCpu ? 2 : 0, 3);
+        if (!channel)
+            fprintf(stderr, "Warning: cannot create frame channel %s, not streaming\n", options.streamName.c_str());
+    }
+
+    int exitCode = 0;
+    for (const auto& params : options.scenes)
+    {
+        // Fresh scene per run so the pipeline sees a scene change (and rebuilds everything)
+        DXEngine::Scene* scene = Bridge::CreateScene();
+
+        BenchRun run;
+        run.params = params;
+        run.info = BuildBenchScene(scene, params, aspectRatio);
+        if (useCpu)
+            run.backend = "cpu_" + options.cpuMode;
+        fprintf(stderr, "[bench] %s: spheres=%d boxes=%d planes=%d instances=%d lights=%d\n",
+            GetBenchRunKey(run).c_str(), run.info.spheres, run.info.boxes, run.info.planes,
+            run.info.meshInstances, run.info.lights);
+        if (run.info.pagedMeshFailed)
+        {
+            fprintf(stderr, "Error: cannot register paged mesh %s\n", std::filesystem::path(params.pagedMeshPath).string().c_str());
+            exitCode = 1;
+        }
+
+        if (!options.snapshotDir.empty())
+        {
+            std::filesystem::create_directories(options.snapshotDir);
+            const std::filesystem::path snapshotPath = std::filesystem::path(options.snapshotDir) / (GetBenchRunKey(run) + ".rtvsb");
+            auto saveStart = std::chrono::high_resolution_clock::now();
+            bool saved = Bridge::SaveSceneSnapshot(scene, snapshotPath.c_str());
+            double saveMs = ElapsedMs(saveStart);
+
+            DXEngine::Scene* loaded = Bridge::CreateScene();
+            auto loadStart = std::chrono::high_resolution_clock::now();
+            bool loadedOk = saved && Bridge::LoadSceneSnapshot(loaded, snapshotPath.c_str());
+            double loadMs = ElapsedMs(loadStart);
+            if (loadedOk)
+            {
+                Bridge::DestroyScene(scene);
+                scene = loaded;
+                fprintf(stderr, "[bench] %s: snapshot %.1f KB, save %.2f ms, load %.2f ms\n", GetBenchRunKey(run).c_str(),
+                    std::filesystem::file_size(snapshotPath) / 1024.0, saveMs, loadMs);
+            }
+            else
+            {
+                Bridge::DestroyScene(loaded);
+                fprintf(stderr, "Warning: snapshot round trip failed for %s, rendering the generated scene\n", snapshotPath.string().c_str());
+            }
+        }
+
+        if (useCpu && !options.pagedDir.empty())
+        {
+            std::filesystem::create_directories(options.pagedDir);
+            auto pageStart = std::chrono::high_resolution_clock::now();
+            if (Bridge::PageSceneMeshes(scene, std::filesystem::path(options.pagedDir).c_str(), 0))
+                fprintf(stderr, "[bench] %s: paged meshes in %.2f ms\n", GetBenchRunKey(run).c_str(), ElapsedMs(pageStart));
+            else
+                fprintf(stderr, "Warning: cannot page the meshes of %s, rendering them in memory\n", GetBenchRunKey(run).c_str());
+        }
+
+        // The CPU tracer keeps its acceleration structures between frames; a fresh one per
+        // scene makes the first frame pay for the full build, as on the GPU
+        if (useCpu)
+        {
+            Bridge::DestroyCpuPathTracer(cpuTracer);
+            cpuTracer = Bridge::CreateCpuPathTracer();
+            if (options.meshBudgetMB >= 0)
+                Bridge::SetCpuMeshResidencyBudget(cpuTracer, meshBudgetBytes);
+            if (options.streamBudgetMB >= 0)
+                Bridge::SetCpuGeometryStreamingBudget(cpuTracer, static_cast<uint64_t>(options.streamBudgetMB) << 20);
+        }
+        const bool wavefront = options.cpuMode == "wavefront";
+        int frameIndex = 0;
+        auto renderFrame = [&](Bridge::FrameStatsNative* outStats)
+        {
+            if (useCpu)
+                return RenderFrameCpu(cpuTracer, scene, settings, params, wavefront, frameIndex++, cpuRadiance,
+                    outStats ? channel : nullptr, outStats);
+
+            double wallMs = RenderFrame(context, pipeline, target, scene);
+            if (outStats)
+            {
+                Bridge::GetFrameStats(pipeline, outStats);
+                if (channel)
+                    StreamFrame(context, target, channel);
+            }
+            return wallMs;
+        };
+
+        run.firstFrameMs = renderFrame(nullptr);
+        for (int i = 0; i < settings.warmupFrames; i++)
+        {
+            renderFrame(nullptr);
+        }
+
+        std::vector<BenchFrameSample> samples;
+        samples.reserve(settings.frames);
+        for (int i = 0; i < settings.frames; i++)
+        {
+            BenchFrameSample sample;
+            sample.wallMs = renderFrame(&sample.stats);
+            samples.push_back(sample);
+        }
+
+        AggregateBenchRun(run, samples);
+        fprintf(stderr, "[bench] %s: frame %.3f ms (p95 %.3f), AS build %.3f ms cpu / %.3f ms gpu",
+            GetBenchRunKey(run).c_str(), run.metrics["frame_ms_mean"], run.metrics["frame_ms_p95"],
+            run.metrics["as_build_cpu_ms_mean"], run.metrics["as_build_gpu_ms_mean"]);
+        // Ray throughput only exists where rays are counted (see AggregateBenchRun)
+        const auto totalRays = run.metrics.find("mrays_total");
+        if (totalRays != run.metrics.end())
+            fprintf(stderr, ", %.1f Mrays/s", totalRays->second);
+        fprintf(stderr, "\n");
+
+        Bridge::ResidencyStatsNative residency = {};
+        if (useCpu ? Bridge::GetCpuMeshResidencyStats(cpuTracer, &residency) : Bridge::GetMeshResidencyStats(pipeline, &residency))
+        {
+            fprintf(stderr, "[bench] %s: mesh residency %.1f / %.1f MB (%d meshes, peak %.1f MB), %llu hits, %llu builds, %llu evictions\n",
+                GetBenchRunKey(run).c_str(), residency.residentBytes / 1048576.0, residency.budgetBytes / 1048576.0,
+                residency.residentCount, residency.peakResidentBytes / 1048576.0, static_cast<unsigned long long>(residency.hits),
+                static_cast<unsigned long long>(residency.misses), static_cast<unsigned long long>(residency.evictions));
+        }
+        Bridge::GeometryStreamingStatsNative streaming = {};
+        if (useCpu && (!options.pagedDir.empty() || run.info.pagedMeshBytes > 0) && Bridge::GetCpuGeometryStreamingStats(cpuTracer, &streaming))
+        {
+            fprintf(stderr, "[bench] %s: geometry streaming %.1f / %.1f MB (%d of %d chunks, peak %.1f MB), %llu loads (%.1f MB, %.1f ms), %llu evictions + %llu released\n",
+                GetBenchRunKey(run).c_str(), streaming.residency.residentBytes / 1048576.0, streaming.residency.budgetBytes / 1048576.0,
+                streaming.residency.residentCount, streaming.chunkCount, streaming.residency.peakResidentBytes / 1048576.0,
+                static_cast<unsigned long long>(streaming.chunkLoads), streaming.loadedBytes / 1048576.0, streaming.loadMs,
+                static_cast<unsigned long long>(streaming.residency.evictions), static_cast<unsigned long long>(streaming.releasedChunks));
+        }
+
+        // Out-of-core check: the geometry was never loaded, so the whole process must have
+        // stayed below the size of the paged file
+        const uint64_t peakWorkingSet = GetPeakWorkingSetBytes();
+        run.metrics["peak_working_set_mb"] = peakWorkingSet / 1048576.0;
+        if (run.info.pagedMeshBytes > 0)
+        {
+            const bool below = peakWorkingSet < run.info.pagedMeshBytes;
+            fprintf(stderr, "[bench] %s: peak working set %.1f MB, paged geometry %.1f MB (%d triangles)%s\n",
+                GetBenchRunKey(run).c_str(), peakWorkingSet / 1048576.0, run.info.pagedMeshBytes / 1048576.0,
+                run.info.meshTriangles, below ? "" : " - NOT below the geometry size");
+            if (!below)
+                exitCode = 2;
+        }
+        runs.push_back(run);
+
+        Bridge::WaitForGPU(context);
+        Bridge::DestroyScene(scene);
+    }
+
+    std::vector<BenchComparison> comparisons;
+    bool hasBaseline = false;
+    if (!options.baselinePath.empty())
+    {
+        std::map<std::string, std::map<std::string, double>> baseline;
+        if (LoadBenchBaseline(options.baselinePath, baseline))
+        {
+            hasBaseline = true;
+            comparisons = CompareWithBaseline(runs, baseline, options.tolerancePercent);
+            for (const auto& c : comparisons)
+            {
+                if (c.regression)
+                {
+                    fprintf(stderr, "[bench] REGRESSION %s.%s: %.4g -> %.4g (%+.1f%%)\n",
+                        c.run.c_str(), c.metric.c_str(), c.baseline, c.current, c.changePercent);
+                    exitCode = 2;
+                }
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to load baseline: %s\n", options.baselinePath.c_str());
+            exitCode = 1;
+        }
+    }
+
+    if (!WriteBenchReport(options.outPath, settings, runs, hasBaseline ? &comparisons : nullptr))
+    {
+        fprintf(stderr, "Failed to write report: %s\n", options.outPath.c_str());
+        exitCode = 1;
+    }
+
+    Bridge::DestroyFrameChannel(channel);
+    Bridge::DestroyCpuPathTracer(cpuTracer);
+    Bridge::WaitForGPU(context);
+    Bridge::DestroyRenderTarget(target);
+    Bridge::DestroyDXRPipeline(pipeline);
+    Bridge::ShutdownDXContext(context);
+    Bridge::DestroyDXContext(context);
+    DestroyWindow(hwnd);
+    return exitCode;
+}
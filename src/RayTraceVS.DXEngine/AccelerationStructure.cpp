@@ -4,15 +4,14 @@
 #endif
 
 #include "AccelerationStructure.h"
+#include "CpuAccelerationStructure.h"
 #include "DXContext.h"
 #include "DebugLog.h"
 #include "Scene/Scene.h"
-#include "Scene/Objects/Sphere.h"
-#include "Scene/Objects/Plane.h"
-#include "Scene/Objects/Box.h"
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace RayTraceVS::DXEngine
 {
@@ -24,80 +23,26 @@ namespace RayTraceVS::DXEngine
         }
     }
 
-    AccelerationStructure::AccelerationStructure(DXContext* context)
-        : dxContext(context)
+    // One AABB geometry over the full primitive array (inactive entries are NaN)
+    static D3D12_RAYTRACING_GEOMETRY_DESC MakeProceduralGeometryDesc(ID3D12Resource* aabbBuffer, size_t aabbCount)
     {
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
+        geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS;
+        // Allow any-hit shaders (needed for shadow/skip-self handling)
+        geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
+        geometryDesc.AABBs.AABBCount = static_cast<UINT64>(aabbCount);
+        geometryDesc.AABBs.AABBs.StartAddress = aabbBuffer->GetGPUVirtualAddress();
+        geometryDesc.AABBs.AABBs.StrideInBytes = sizeof(AABB);
+        return geometryDesc;
     }
 
-    AccelerationStructure::~AccelerationStructure()
-    {
-    }
-
-    // ============================================
-    // AABB Calculation Functions
-    // ============================================
-
-    AABB AccelerationStructure::CalculateSphereAABB(const XMFLOAT3& center, float radius)
-    {
-        AABB aabb;
-        aabb.MinX = center.x - radius;
-        aabb.MinY = center.y - radius;
-        aabb.MinZ = center.z - radius;
-        aabb.MaxX = center.x + radius;
-        aabb.MaxY = center.y + radius;
-        aabb.MaxZ = center.z + radius;
-        return aabb;
-    }
-
-    AABB AccelerationStructure::CalculatePlaneAABB(const XMFLOAT3& position, const XMFLOAT3& normal)
+    AccelerationStructure::AccelerationStructure(DXContext* context)
+        : dxContext(context)
     {
-        // Planes are infinite, so we use a large but finite AABB
-        // The AABB is a thin slab centered at the plane position
-        const float extent = 1000.0f;  // Large extent for infinite plane
-        const float thickness = 0.01f;
-
-        // Normalize the normal vector
-        XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&normal));
-        XMFLOAT3 normalizedNormal;
-        XMStoreFloat3(&normalizedNormal, n);
-
-        // Create tangent vectors for the plane
-        XMVECTOR tangent, bitangent;
-        if (std::abs(normalizedNormal.y) < 0.999f)
-        {
-            tangent = XMVector3Cross(XMVectorSet(0, 1, 0, 0), n);
-        }
-        else
-        {
-            tangent = XMVector3Cross(XMVectorSet(1, 0, 0, 0), n);
-        }
-        tangent = XMVector3Normalize(tangent);
-        bitangent = XMVector3Cross(n, tangent);
-
-        // Calculate AABB corners
-        AABB aabb;
-        aabb.MinX = position.x - extent;
-        aabb.MinY = position.y - extent;
-        aabb.MinZ = position.z - extent;
-        aabb.MaxX = position.x + extent;
-        aabb.MaxY = position.y + extent;
-        aabb.MaxZ = position.z + extent;
-
-        return aabb;
     }
 
-    AABB AccelerationStructure::CalculateBoxAABB(const XMFLOAT3& center, const XMFLOAT3& size)
+    AccelerationStructure::~AccelerationStructure()
     {
-        // size contains half-extents
-        AABB aabb;
-        aabb.MinX = center.x - size.x;
-        aabb.MinY = center.y - size.y;
-        aabb.MinZ = center.z - size.z;
-        aabb.MaxX = center.x + size.x;
-        aabb.MaxY = center.y + size.y;
-        aabb.MaxZ = center.z + size.z;
-
-        return aabb;
     }
 
     // ============================================
@@ -109,39 +54,25 @@ namespace RayTraceVS::DXEngine
         if (!scene || !dxContext->IsDXRSupported())
             return false;
 
-        auto device = dxContext->GetDevice();
         auto commandList = dxContext->GetCommandList();
         SetCommandListName(commandList, L"CmdList_BuildMeshBLAS");
         SetCommandListName(commandList, L"CmdList_BuildProceduralBLAS");
 
-        // Collect objects and calculate AABBs
-        const auto& objects = scene->GetObjects();
+        // Calculate AABBs by linear scans over the primitive pools.
+        // Order (spheres, planes, boxes) matches the shader PrimitiveIndex ordering.
+        const SpherePool& spheres = scene->GetSpheres();
+        const PlanePool& planes = scene->GetPlanes();
+        const BoxPool& boxes = scene->GetBoxes();
         std::vector<AABB> aabbs;
+        aabbs.reserve(scene->GetPrimitiveCount());
         instanceInfo.clear();
+        instanceInfo.reserve(scene->GetPrimitiveCount());
 
         UINT sphereIndex = 0, planeIndex = 0, boxIndex = 0;
 
-        // Collect objects by type to match shader PrimitiveIndex ordering
-        std::vector<Sphere*> spheres;
-        std::vector<Plane*> planes;
-        std::vector<Box*> boxes;
-        spheres.reserve(objects.size());
-        planes.reserve(objects.size());
-        boxes.reserve(objects.size());
-
-        for (const auto& obj : objects)
+        for (const SphereGeometry& sphere : spheres.geometry)
         {
-            if (auto sphere = dynamic_cast<Sphere*>(obj.get()))
-                spheres.push_back(sphere);
-            else if (auto plane = dynamic_cast<Plane*>(obj.get()))
-                planes.push_back(plane);
-            else if (auto box = dynamic_cast<Box*>(obj.get()))
-                boxes.push_back(box);
-        }
-
-        for (auto sphere : spheres)
-        {
-            AABB aabb = CalculateSphereAABB(sphere->GetCenter(), sphere->GetRadius());
+            AABB aabb = CalculateSphereAABB(sphere);
             GeometryInstanceInfo info;
             info.type = ObjectType::Sphere;
             info.objectIndex = sphereIndex++;
@@ -149,9 +80,9 @@ namespace RayTraceVS::DXEngine
             instanceInfo.push_back(info);
         }
 
-        for (auto plane : planes)
+        for (const PlaneGeometry& plane : planes.geometry)
         {
-            AABB aabb = CalculatePlaneAABB(plane->GetPosition(), plane->GetNormal());
+            AABB aabb = CalculatePlaneAABB(plane);
             GeometryInstanceInfo info;
             info.type = ObjectType::Plane;
             info.objectIndex = planeIndex++;
@@ -159,36 +90,10 @@ namespace RayTraceVS::DXEngine
             instanceInfo.push_back(info);
         }
 
-        for (auto box : boxes)
-        {
-            // Compute AABB for OBB using axes (world-space)
-            const XMFLOAT3 center = box->GetCenter();
-            const XMFLOAT3 size = box->GetSize(); // half-extents
-            XMFLOAT3 ax = box->GetAxisX();
-            XMFLOAT3 ay = box->GetAxisY();
-            XMFLOAT3 az = box->GetAxisZ();
-            // Normalize axes to be safe
-            auto norm = [](const XMFLOAT3& v) {
-                float len = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
-                if (len > 1e-6f) return XMFLOAT3(v.x / len, v.y / len, v.z / len);
-                return XMFLOAT3(0.0f, 0.0f, 0.0f);
-            };
-            ax = norm(ax);
-            ay = norm(ay);
-            az = norm(az);
-
-            // AABB half-extents = sum of absolute axis components scaled by size
-            const float hx = std::abs(ax.x) * size.x + std::abs(ay.x) * size.y + std::abs(az.x) * size.z;
-            const float hy = std::abs(ax.y) * size.x + std::abs(ay.y) * size.y + std::abs(az.y) * size.z;
-            const float hz = std::abs(ax.z) * size.x + std::abs(ay.z) * size.y + std::abs(az.z) * size.z;
-
-            AABB aabb;
-            aabb.MinX = center.x - hx;
-            aabb.MinY = center.y - hy;
-            aabb.MinZ = center.z - hz;
-            aabb.MaxX = center.x + hx;
-            aabb.MaxY = center.y + hy;
-            aabb.MaxZ = center.z + hz;
+        for (const BoxGeometry& box : boxes.geometry)
+        {
+            // Exact bounds of the rotated box
+            AABB aabb = CalculateBoxAABB(box);
 
             GeometryInstanceInfo info;
             info.type = ObjectType::Box;
@@ -197,13 +102,18 @@ namespace RayTraceVS::DXEngine
             instanceInfo.push_back(info);
         }
 
+        lastUpdateRebuilt = false;
+
         if (aabbs.empty())
         {
             // No procedural objects: treat as a valid empty BLAS state
-            aabbBuffer.Reset();
-            aabbUploadBuffer.Reset();
-            bottomLevelAS.Reset();
-            scratchBuffer.Reset();
+            staticBLAS = ProceduralBLAS();
+            dynamicBLAS = ProceduralBLAS();
+            planeBLAS = ProceduralBLAS();
+            proceduralAabbs.clear();
+            lastMovedUpdate.clear();
+            isDynamic.clear();
+            blasContentChanged = true;
             instanceInfo.clear();
             totalObjectCount = 0;
             return true;
@@ -211,56 +121,192 @@ namespace RayTraceVS::DXEngine
 
         totalObjectCount = static_cast<UINT>(aabbs.size());
 
-        // Create AABB buffer
-        UINT64 aabbBufferSize = sizeof(AABB) * aabbs.size();
-        
-        // Create default heap buffer
-        CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
-        CD3DX12_RESOURCE_DESC aabbDesc = CD3DX12_RESOURCE_DESC::Buffer(aabbBufferSize);
-        
-        if (FAILED(device->CreateCommittedResource(
-            &defaultHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &aabbDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(&aabbBuffer))))
+        // Planes occupy [sphereCount, sphereCount + planeCount) and live in planeBLAS
+        const uint32_t planeBegin = static_cast<uint32_t>(spheres.Size());
+        const uint32_t planeEnd = planeBegin + static_cast<uint32_t>(planes.Size());
+        auto isPlane = [&](uint32_t i) { return i >= planeBegin && i < planeEnd; };
+
+        // Find the primitives whose bounds changed since the last update.
+        // A count change reshuffles the indices, so everything starts over as static.
+        const size_t primitiveCount = aabbs.size();
+        const size_t boundedCount = primitiveCount - planes.Size();
+        const bool countChanged = (primitiveCount != proceduralAabbs.size());
+        proceduralUpdateCount++;
+        std::vector<uint32_t> moved;
+        bool planeMoved = false;
+        if (countChanged)
         {
+            lastMovedUpdate.assign(primitiveCount, 0);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(primitiveCount); i++)
+            {
+                if (memcmp(&aabbs[i], &proceduralAabbs[i], sizeof(AABB)) != 0)
+                {
+                    if (isPlane(i))
+                    {
+                        planeMoved = true;
+                        continue;
+                    }
+                    moved.push_back(i);
+                    lastMovedUpdate[i] = proceduralUpdateCount;
+                }
+            }
+        }
+
+        // Recently moved primitives are dynamic; they return to the static BLAS after
+        // DYNAMIC_RETENTION_UPDATES updates without motion
+        std::vector<bool> dynamic(primitiveCount, false);
+        size_t dynamicCount = 0;
+        for (size_t i = 0; i < primitiveCount; i++)
+        {
+            if (lastMovedUpdate[i] != 0 && proceduralUpdateCount - lastMovedUpdate[i] < DYNAMIC_RETENTION_UPDATES)
+            {
+                dynamic[i] = true;
+                dynamicCount++;
+            }
+        }
+        // When most of the scene moves a split buys nothing: refit one BLAS over everything
+        if (static_cast<float>(dynamicCount) > static_cast<float>(boundedCount) * DYNAMIC_FRACTION_LIMIT)
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(primitiveCount); i++)
+            {
+                dynamic[i] = !isPlane(i);
+            }
+            dynamicCount = boundedCount;
+        }
+
+        bool succeeded = true;
+        if (countChanged || planeMoved)
+        {
+            planeBLAS.primitives.clear();
+            for (uint32_t i = planeBegin; i < planeEnd; i++)
+            {
+                planeBLAS.primitives.push_back(i);
+            }
+            succeeded = BuildPartition(planeBLAS, aabbs, false);
+        }
+
+        if (succeeded && (countChanged || dynamic != isDynamic))
+        {
+            // Active/inactive AABBs may not change in an update, so a membership change
+            // needs a full build of both partitions
+            isDynamic = dynamic;
+            staticBLAS.primitives.clear();
+            dynamicBLAS.primitives.clear();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(primitiveCount); i++)
+            {
+                if (!isPlane(i))
+                    (dynamic[i] ? dynamicBLAS : staticBLAS).primitives.push_back(i);
+            }
+            LOG_DEBUGF("[BuildProceduralBLAS] Full build: %zu static, %zu dynamic, %zu plane primitives",
+                boundedCount - dynamicCount, dynamicCount, planes.Size());
+            succeeded = BuildPartition(staticBLAS, aabbs, false) && BuildPartition(dynamicBLAS, aabbs, true);
+        }
+        else if (succeeded && !moved.empty())
+        {
+            // Every moved primitive is dynamic here, so the static BLAS is still valid
+            succeeded = RefitPartition(dynamicBLAS, aabbs, moved);
+        }
+
+        if (!succeeded)
+        {
+            // Start over with a full build next time
+            proceduralAabbs.clear();
             return false;
         }
 
-        // Create upload buffer
-        CreateUploadBuffer(aabbBufferSize, &aabbUploadBuffer);
+        proceduralAabbs = std::move(aabbs);
+        return true;
+    }
+
+    bool AccelerationStructure::UploadPartitionAABBs(ProceduralBLAS& partition, const std::vector<AABB>& aabbs)
+    {
+        auto device = dxContext->GetDevice();
+        auto commandList = dxContext->GetCommandList();
+
+        // A NaN MinX marks an AABB inactive, which excludes it from the build
+        AABB inactive = {};
+        inactive.MinX = std::numeric_limits<float>::quiet_NaN();
+        std::vector<AABB> masked(aabbs.size(), inactive);
+        for (uint32_t primitive : partition.primitives)
+        {
+            masked[primitive] = aabbs[primitive];
+        }
+
+        UINT64 aabbBufferSize = sizeof(AABB) * masked.size();
+        if (!partition.aabbBuffer || partition.aabbBuffer->GetDesc().Width != aabbBufferSize)
+        {
+            // Create default heap buffer
+            CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+            CD3DX12_RESOURCE_DESC aabbDesc = CD3DX12_RESOURCE_DESC::Buffer(aabbBufferSize);
+
+            partition.aabbBuffer.Reset();
+            if (FAILED(device->CreateCommittedResource(
+                &defaultHeapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &aabbDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&partition.aabbBuffer))))
+            {
+                return false;
+            }
+
+            // Create upload buffer
+            partition.aabbUploadBuffer.Reset();
+            CreateUploadBuffer(aabbBufferSize, &partition.aabbUploadBuffer);
+        }
 
         // Upload AABB data
         void* mappedData = nullptr;
-        aabbUploadBuffer->Map(0, nullptr, &mappedData);
-        memcpy(mappedData, aabbs.data(), aabbBufferSize);
-        aabbUploadBuffer->Unmap(0, nullptr);
+        partition.aabbUploadBuffer->Map(0, nullptr, &mappedData);
+        memcpy(mappedData, masked.data(), aabbBufferSize);
+        partition.aabbUploadBuffer->Unmap(0, nullptr);
 
-        // Copy to default heap
-        commandList->CopyResource(aabbBuffer.Get(), aabbUploadBuffer.Get());
+        // Copy to default heap. Buffers decay to COMMON when a frame's command list completes,
+        // so the copy promotes a reused buffer to COPY_DEST just like a new one.
+        commandList->CopyResource(partition.aabbBuffer.Get(), partition.aabbUploadBuffer.Get());
 
         // Transition AABB buffer to non-pixel shader resource
         CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            aabbBuffer.Get(),
+            partition.aabbBuffer.Get(),
             D3D12_RESOURCE_STATE_COPY_DEST,
             D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         commandList->ResourceBarrier(1, &barrier);
 
-        // Create geometry descriptor for procedural primitives
-        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
-        geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS;
-        // Allow any-hit shaders (needed for shadow/skip-self handling)
-        geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
-        geometryDesc.AABBs.AABBCount = static_cast<UINT64>(aabbs.size());
-        geometryDesc.AABBs.AABBs.StartAddress = aabbBuffer->GetGPUVirtualAddress();
-        geometryDesc.AABBs.AABBs.StrideInBytes = sizeof(AABB);
+        return true;
+    }
+
+    bool AccelerationStructure::BuildPartition(ProceduralBLAS& partition, const std::vector<AABB>& aabbs, bool allowUpdate)
+    {
+        auto device = dxContext->GetDevice();
+        auto commandList = dxContext->GetCommandList();
+
+        partition.allowUpdate = allowUpdate;
+        blasContentChanged = true;
+        if (partition.primitives.empty())
+        {
+            partition.blas.Reset();
+            partition.scratchBuffer.Reset();
+            partition.aabbBuffer.Reset();
+            partition.aabbUploadBuffer.Reset();
+            partition.bvh.Clear();
+            return true;
+        }
+
+        if (!UploadPartitionAABBs(partition, aabbs))
+            return false;
+
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = MakeProceduralGeometryDesc(partition.aabbBuffer.Get(), aabbs.size());
 
         // Build BLAS inputs
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
         inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
         inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        if (allowUpdate)
+            inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
         inputs.NumDescs = 1;
         inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
         inputs.pGeometryDescs = &geometryDesc;
@@ -273,35 +319,112 @@ namespace RayTraceVS::DXEngine
         CreateBuffer(prebuildInfo.ResultDataMaxSizeInBytes,
             D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
             D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
-            &bottomLevelAS);
+            &partition.blas);
 
-        // Create scratch buffer
-        UINT64 scratchSize = (std::max)(prebuildInfo.ScratchDataSizeInBytes, prebuildInfo.UpdateScratchDataSizeInBytes);
+        // Create scratch buffer (large enough for later updates of refittable BLASes)
+        UINT64 scratchSize = allowUpdate
+            ? (std::max)(prebuildInfo.ScratchDataSizeInBytes, prebuildInfo.UpdateScratchDataSizeInBytes)
+            : prebuildInfo.ScratchDataSizeInBytes;
         CreateBuffer(scratchSize,
             D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-            &scratchBuffer);
+            &partition.scratchBuffer);
 
         // Build BLAS
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
         buildDesc.Inputs = inputs;
-        buildDesc.DestAccelerationStructureData = bottomLevelAS->GetGPUVirtualAddress();
-        buildDesc.ScratchAccelerationStructureData = scratchBuffer->GetGPUVirtualAddress();
+        buildDesc.DestAccelerationStructureData = partition.blas->GetGPUVirtualAddress();
+        buildDesc.ScratchAccelerationStructureData = partition.scratchBuffer->GetGPUVirtualAddress();
 
         commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
 
         // UAV barrier
         D3D12_RESOURCE_BARRIER uavBarrier = {};
         uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-        uavBarrier.UAV.pResource = bottomLevelAS.Get();
+        uavBarrier.UAV.pResource = partition.blas.Get();
         commandList->ResourceBarrier(1, &uavBarrier);
 
+        partition.bvh.Build(aabbs, partition.primitives);
+        lastUpdateRebuilt = true;
         return true;
     }
 
+    bool AccelerationStructure::RefitPartition(ProceduralBLAS& partition, const std::vector<AABB>& aabbs, const std::vector<uint32_t>& moved)
+    {
+        auto commandList = dxContext->GetCommandList();
+
+        if (!partition.blas || !partition.allowUpdate)
+            return BuildPartition(partition, aabbs, true);
+
+        // A refit keeps the topology chosen for the old positions; once the CPU mirror
+        // predicts traversal got too much slower, pay for a fresh build instead
+        partition.bvh.Refit(aabbs, moved);
+        const float degradation = partition.bvh.GetSahDegradation();
+        if (degradation > REFIT_SAH_THRESHOLD)
+        {
+            LOG_DEBUGF("[BuildProceduralBLAS] SAH cost degraded %.2fx, rebuilding dynamic BLAS", degradation);
+            return BuildPartition(partition, aabbs, true);
+        }
+
+        if (!UploadPartitionAABBs(partition, aabbs))
+            return false;
+
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = MakeProceduralGeometryDesc(partition.aabbBuffer.Get(), aabbs.size());
+
+        // Inputs must match the original build apart from PERFORM_UPDATE
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+        inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+                       D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
+                       D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+        inputs.NumDescs = 1;
+        inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        inputs.pGeometryDescs = &geometryDesc;
+
+        // Update in place
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+        buildDesc.Inputs = inputs;
+        buildDesc.SourceAccelerationStructureData = partition.blas->GetGPUVirtualAddress();
+        buildDesc.DestAccelerationStructureData = partition.blas->GetGPUVirtualAddress();
+        buildDesc.ScratchAccelerationStructureData = partition.scratchBuffer->GetGPUVirtualAddress();
+
+        commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+
+        // UAV barrier
+        D3D12_RESOURCE_BARRIER uavBarrier = {};
+        uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        uavBarrier.UAV.pResource = partition.blas.Get();
+        commandList->ResourceBarrier(1, &uavBarrier);
+
+        blasContentChanged = true;
+        return true;
+    }
+
+    void AccelerationStructure::AppendProceduralInstances(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, std::vector<AABB>& instanceBounds) const
+    {
+        for (const ProceduralBLAS* partition : { &staticBLAS, &dynamicBLAS, &planeBLAS })
+        {
+            if (!partition->blas)
+                continue;
+
+            D3D12_RAYTRACING_INSTANCE_DESC proceduralInst = {};
+            // Identity transform
+            proceduralInst.Transform[0][0] = 1.0f;
+            proceduralInst.Transform[1][1] = 1.0f;
+            proceduralInst.Transform[2][2] = 1.0f;
+            proceduralInst.InstanceID = 0;  // Not used for procedural (PrimitiveIndex is global)
+            proceduralInst.InstanceMask = 0xFF;
+            proceduralInst.InstanceContributionToHitGroupIndex = 0;  // Hit groups 0-3 (procedural)
+            proceduralInst.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
+            proceduralInst.AccelerationStructure = partition->blas->GetGPUVirtualAddress();
+            instanceDescs.push_back(proceduralInst);
+            instanceBounds.push_back(partition->bvh.GetRootBounds());
+        }
+    }
+
     bool AccelerationStructure::BuildProceduralTLAS()
     {
-        if (!bottomLevelAS || !dxContext->IsDXRSupported())
+        if ((!staticBLAS.blas && !dynamicBLAS.blas && !planeBLAS.blas) || !dxContext->IsDXRSupported())
             return false;
 
         auto device = dxContext->GetDevice();
@@ -309,22 +432,13 @@ namespace RayTraceVS::DXEngine
         SetCommandListName(commandList, L"CmdList_BuildCombinedTLAS");
         SetCommandListName(commandList, L"CmdList_BuildProceduralTLAS");
 
-        // Create single instance pointing to BLAS
-        D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
-        
-        // Identity transform
-        instanceDesc.Transform[0][0] = 1.0f;
-        instanceDesc.Transform[1][1] = 1.0f;
-        instanceDesc.Transform[2][2] = 1.0f;
-        
-        instanceDesc.InstanceID = 0;
-        instanceDesc.InstanceMask = 0xFF;
-        instanceDesc.InstanceContributionToHitGroupIndex = 0;
-        instanceDesc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-        instanceDesc.AccelerationStructure = bottomLevelAS->GetGPUVirtualAddress();
+        // One instance per procedural partition
+        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
+        std::vector<AABB> instanceBounds;
+        AppendProceduralInstances(instanceDescs, instanceBounds);
 
         // Create instance buffer (upload heap for simplicity)
-        UINT64 instanceBufferSize = sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+        UINT64 instanceBufferSize = instanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
         CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
         CD3DX12_RESOURCE_DESC instanceBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(instanceBufferSize);
 
@@ -342,14 +456,14 @@ namespace RayTraceVS::DXEngine
         // Upload instance data
         void* mappedData = nullptr;
         instanceBuffer->Map(0, nullptr, &mappedData);
-        memcpy(mappedData, &instanceDesc, sizeof(instanceDesc));
+        memcpy(mappedData, instanceDescs.data(), instanceBufferSize);
         instanceBuffer->Unmap(0, nullptr);
 
         // Build TLAS inputs
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
         inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
         inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-        inputs.NumDescs = 1;
+        inputs.NumDescs = static_cast<UINT>(instanceDescs.size());
         inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
         inputs.InstanceDescs = instanceBuffer->GetGPUVirtualAddress();
 
@@ -363,11 +477,17 @@ namespace RayTraceVS::DXEngine
             D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
             &topLevelAS);
 
+        // Create scratch buffer
+        CreateBuffer(prebuildInfo.ScratchDataSizeInBytes,
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            &tlasScratchBuffer);
+
         // Build TLAS
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
         buildDesc.Inputs = inputs;
         buildDesc.DestAccelerationStructureData = topLevelAS->GetGPUVirtualAddress();
-        buildDesc.ScratchAccelerationStructureData = scratchBuffer->GetGPUVirtualAddress();
+        buildDesc.ScratchAccelerationStructureData = tlasScratchBuffer->GetGPUVirtualAddress();
 
         commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
 
@@ -377,6 +497,8 @@ namespace RayTraceVS::DXEngine
         uavBarrier.UAV.pResource = topLevelAS.Get();
         commandList->ResourceBarrier(1, &uavBarrier);
 
+        // Not refittable: the next combined TLAS update is a full build
+        previousInstanceDescs.clear();
         return true;
     }
 
@@ -546,18 +668,23 @@ namespace RayTraceVS::DXEngine
     // Mesh BLAS Functions
     // ============================================
 
-    bool AccelerationStructure::HasMeshBLAS(const std::string& meshName) const
+    static uint64_t GetResourceBytes(const ComPtr<ID3D12Resource>& resource)
     {
-        return meshBLASMap.find(meshName) != meshBLASMap.end();
+        return resource ? resource->GetDesc().Width : 0;
     }
 
-    MeshBLASEntry* AccelerationStructure::GetMeshBLAS(const std::string& meshName)
+    bool AccelerationStructure::HasMeshBLAS(const std::string& meshKey) const
     {
-        auto it = meshBLASMap.find(meshName);
+        return meshBLASMap.find(meshKey) != meshBLASMap.end();
+    }
+
+    MeshBLASEntry* AccelerationStructure::GetMeshBLAS(const std::string& meshKey)
+    {
+        auto it = meshBLASMap.find(meshKey);
         return (it != meshBLASMap.end()) ? &it->second : nullptr;
     }
 
-    bool AccelerationStructure::BuildMeshBLAS(const std::string& meshName, const MeshCacheEntry& meshCache)
+    bool AccelerationStructure::BuildMeshBLAS(const std::string& meshKey, const MeshCacheEntry& meshCache)
     {
         if (meshCache.vertices.empty() || meshCache.indices.empty())
         {
@@ -657,7 +784,11 @@ namespace RayTraceVS::DXEngine
         commandList->ResourceBarrier(1, &barrier);
 
         // Store in map
-        meshBLASMap[meshName] = std::move(entry);
+        meshResidency.Add(meshKey, GetResourceBytes(entry.blas) + GetResourceBytes(entry.vertexBuffer) +
+            GetResourceBytes(entry.indexBuffer) + GetResourceBytes(entry.scratchBuffer));
+        meshBLASMap[meshKey] = std::move(entry);
+        blasContentChanged = true;
+        lastUpdateRebuilt = true;
 
         return true;
     }
@@ -669,181 +800,239 @@ namespace RayTraceVS::DXEngine
         auto device = dxContext->GetDevice();
         auto commandList = dxContext->GetCommandList();
 
-        // Count total instances (procedural + mesh)
-        UINT proceduralInstanceCount = (bottomLevelAS != nullptr) ? 1 : 0;
         const auto& meshInstances = scene->GetMeshInstances();
-        UINT meshInstanceCount = static_cast<UINT>(meshInstances.size());
-        UINT totalInstanceCount = proceduralInstanceCount + meshInstanceCount;
+        const auto& meshCaches = scene->GetMeshCaches();
 
-        if (totalInstanceCount == 0)
-        {
-            // No instances to render
-            topLevelAS.Reset();
-            return true;
-        }
+        // Pins the BLASes this TLAS references (BuildMeshBLAS adds new ones pinned)
+        meshResidency.BeginFrame();
 
-        // Build instance descriptors
+        // Build instance descriptors, plus world bounds for the CPU mirror
         std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
-        instanceDescs.reserve(totalInstanceCount);
+        std::vector<AABB> instanceBounds;
+        instanceDescs.reserve(2 + meshInstances.size());
+        instanceBounds.reserve(2 + meshInstances.size());
 
-        // Add procedural instance (if exists)
-        if (bottomLevelAS != nullptr)
-        {
-            D3D12_RAYTRACING_INSTANCE_DESC proceduralInst = {};
-            // Identity transform
-            proceduralInst.Transform[0][0] = 1.0f;
-            proceduralInst.Transform[1][1] = 1.0f;
-            proceduralInst.Transform[2][2] = 1.0f;
-            proceduralInst.InstanceID = 0;  // Not used for procedural
-            proceduralInst.InstanceMask = 0xFF;
-            proceduralInst.InstanceContributionToHitGroupIndex = 0;  // Hit groups 0-3 (procedural)
-            proceduralInst.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-            proceduralInst.AccelerationStructure = bottomLevelAS->GetGPUVirtualAddress();
-            instanceDescs.push_back(proceduralInst);
-        }
+        // Add procedural instances (static and dynamic partitions, if they exist)
+        AppendProceduralInstances(instanceDescs, instanceBounds);
 
-        // Add mesh instances
-        UINT meshInstanceIndex = 0;
-        char logBuf[512];
-        sprintf_s(logBuf, "[BuildCombinedTLAS] Processing %zu mesh instances", meshInstances.size());
-        LOG_INFO(logBuf);
-        
-        for (const auto& meshInst : meshInstances)
-        {
-            sprintf_s(logBuf, "[BuildCombinedTLAS] Instance '%s': pos=(%.2f,%.2f,%.2f), rot=(%.2f,%.2f,%.2f), scale=(%.2f,%.2f,%.2f)",
-                meshInst.meshName.c_str(),
-                meshInst.transform.position.x, meshInst.transform.position.y, meshInst.transform.position.z,
-                meshInst.transform.rotation.x, meshInst.transform.rotation.y, meshInst.transform.rotation.z,
-                meshInst.transform.scale.x, meshInst.transform.scale.y, meshInst.transform.scale.z);
-            LOG_INFO(logBuf);
-            
-            auto* blasEntry = GetMeshBLAS(meshInst.meshName);
-            if (!blasEntry || !blasEntry->blas)
+        // Resolve the BLAS of each distinct mesh name once (building missing ones); an
+        // instance only contributes its transform and the BLAS it resolved to
+        struct ResolvedMesh
+        {
+            MeshBLASEntry* blas = nullptr;
+            AABB bounds = {};           // Object space; a point at the origin if the cache is gone
+        };
+        std::unordered_map<std::string, ResolvedMesh> resolvedByName;
+        std::vector<MeshBLASEntry*> instanceBlases(meshInstances.size(), nullptr);
+        std::vector<AABB> objectBounds(meshInstances.size(), AABB{});
+        LOG_DEBUGF("[BuildCombinedTLAS] Processing %zu mesh instances", meshInstances.size());
+
+        for (size_t i = 0; i < meshInstances.size(); i++)
+        {
+            const std::string& meshName = meshInstances[i].meshName;
+            auto [resolvedIt, inserted] = resolvedByName.try_emplace(meshName);
+            ResolvedMesh& resolved = resolvedIt->second;
+            if (inserted)
             {
-                // Try to build BLAS if not exists
-                auto cacheIt = scene->GetMeshCaches().find(meshInst.meshName);
-                if (cacheIt != scene->GetMeshCaches().end())
+                // Instances of identical geometry share one BLAS, whatever name they use
+                const std::string* meshKey = scene->FindMeshKey(meshName);
+                auto cacheIt = meshKey ? meshCaches.find(*meshKey) : meshCaches.end();
+                auto* blasEntry = meshKey ? GetMeshBLAS(*meshKey) : nullptr;
+                if (blasEntry && blasEntry->blas)
+                {
+                    meshResidency.Use(*meshKey);
+                }
+                else if (cacheIt != meshCaches.end())
+                {
+                    // Try to build BLAS if not exists
+                    BuildMeshBLAS(*meshKey, cacheIt->second);
+                    blasEntry = GetMeshBLAS(*meshKey);
+                }
+                else
+                {
+                    LOG_WARNF("[BuildCombinedTLAS] No cache found for '%s'", meshName);
+                }
+
+                if (blasEntry && blasEntry->blas)
                 {
-                    BuildMeshBLAS(meshInst.meshName, cacheIt->second);
-                    blasEntry = GetMeshBLAS(meshInst.meshName);
+                    resolved.blas = blasEntry;
                 }
                 else
                 {
-                    char buf[256];
-                    sprintf_s(buf, "[BuildCombinedTLAS] ERROR: No cache found for '%s'\n", meshInst.meshName.c_str());
-                    OutputDebugStringA(buf);
+                    LOG_WARNF("[BuildCombinedTLAS] Skipping instances of '%s' - no BLAS available", meshName);
+                }
+                if (cacheIt != meshCaches.end())
+                {
+                    const XMFLOAT3& bmin = cacheIt->second.boundsMin;
+                    const XMFLOAT3& bmax = cacheIt->second.boundsMax;
+                    resolved.bounds = { bmin.x, bmin.y, bmin.z, bmax.x, bmax.y, bmax.z };
                 }
             }
-            
-            if (!blasEntry || !blasEntry->blas)
-            {
-                OutputDebugStringA("[BuildCombinedTLAS] WARNING: Skipping instance - no BLAS available\n");
+            instanceBlases[i] = resolved.blas;
+            objectBounds[i] = resolved.bounds;
+        }
+
+        // 3x4 transforms and world bounds of all instances in one vectorized, parallel pass
+        // (shared with the CPU acceleration structure)
+        std::vector<Transform3x4> objectToWorld(meshInstances.size());
+        std::vector<AABB> worldBounds(meshInstances.size());
+        ComputeInstanceTransforms(meshInstances, objectBounds, objectToWorld, worldBounds);
+
+        // Add mesh instances
+        UINT meshInstanceIndex = 0;
+        for (size_t i = 0; i < meshInstances.size(); i++)
+        {
+            if (!instanceBlases[i])
                 continue;  // Skip if BLAS still not available
-            }
 
             D3D12_RAYTRACING_INSTANCE_DESC meshInstDesc = {};
-            
-            // Build transform matrix from position, rotation, scale
-            XMMATRIX translation = XMMatrixTranslation(
-                meshInst.transform.position.x,
-                meshInst.transform.position.y,
-                meshInst.transform.position.z);
-            XMMATRIX rotation = XMMatrixRotationRollPitchYaw(
-                XMConvertToRadians(meshInst.transform.rotation.x),
-                XMConvertToRadians(meshInst.transform.rotation.y),
-                XMConvertToRadians(meshInst.transform.rotation.z));
-            XMMATRIX scale = XMMatrixScaling(
-                meshInst.transform.scale.x,
-                meshInst.transform.scale.y,
-                meshInst.transform.scale.z);
-            
-            XMMATRIX worldMatrix = scale * rotation * translation;
-            
-            // Copy to 3x4 row-major format
-            // DXR expects column-major style: Transform[row][col] where col=3 is translation
-            // DirectXMath stores translation in row 3 (m[3][0..2]), so we need to transpose
-            XMFLOAT4X4 worldFloat;
-            XMStoreFloat4x4(&worldFloat, XMMatrixTranspose(worldMatrix));
-            for (int row = 0; row < 3; row++)
-            {
-                meshInstDesc.Transform[row][0] = worldFloat.m[row][0];
-                meshInstDesc.Transform[row][1] = worldFloat.m[row][1];
-                meshInstDesc.Transform[row][2] = worldFloat.m[row][2];
-                meshInstDesc.Transform[row][3] = worldFloat.m[row][3];
-            }
-            
+            memcpy(meshInstDesc.Transform, objectToWorld[i].m, sizeof(meshInstDesc.Transform));
             meshInstDesc.InstanceID = meshInstanceIndex++;  // Used in shader to lookup material
             meshInstDesc.InstanceMask = 0xFF;
             meshInstDesc.InstanceContributionToHitGroupIndex = 4;  // Hit groups 4-7 (triangle)
             // Disable backface culling for thin meshes (e.g., glass) so shadow rays hit both sides.
             meshInstDesc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE;
-            meshInstDesc.AccelerationStructure = blasEntry->blas->GetGPUVirtualAddress();
+            meshInstDesc.AccelerationStructure = instanceBlases[i]->blas->GetGPUVirtualAddress();
             instanceDescs.push_back(meshInstDesc);
+            instanceBounds.push_back(worldBounds[i]);
+        }
+
+        // Release cached BLASes no instance uses, least recently used first, until the
+        // budget holds. The previous frame has completed and none of them is referenced here.
+        for (const std::string& key : meshResidency.Trim())
+        {
+            meshBLASMap.erase(key);
         }
 
         if (instanceDescs.empty())
         {
+            // No instances to render
             topLevelAS.Reset();
+            previousInstanceDescs.clear();
+            tlasBvh.Clear();
+            blasContentChanged = false;
             return true;
         }
 
-        // Create instance buffer
         UINT64 instanceBufferSize = instanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
-        ComPtr<ID3D12Resource> newInstanceBuffer;
+
+        // The same instances over the same BLASes can be refitted in place
+        bool refit = topLevelAS && instanceBuffer && tlasScratchBuffer &&
+            instanceDescs.size() == previousInstanceDescs.size();
+        for (size_t i = 0; refit && i < instanceDescs.size(); i++)
         {
-            CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-            CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(instanceBufferSize);
-            device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&newInstanceBuffer));
-            
-            void* mapped = nullptr;
-            newInstanceBuffer->Map(0, nullptr, &mapped);
-            memcpy(mapped, instanceDescs.data(), instanceBufferSize);
-            newInstanceBuffer->Unmap(0, nullptr);
+            refit = (instanceDescs[i].AccelerationStructure == previousInstanceDescs[i].AccelerationStructure);
+        }
+        if (refit)
+        {
+            if (!blasContentChanged &&
+                memcmp(instanceDescs.data(), previousInstanceDescs.data(), instanceBufferSize) == 0)
+            {
+                // Nothing the TLAS depends on changed
+                return true;
+            }
+
+            tlasBvh.Refit(instanceBounds);
+            const float degradation = tlasBvh.GetSahDegradation();
+            if (degradation > REFIT_SAH_THRESHOLD)
+            {
+                LOG_DEBUGF("[BuildCombinedTLAS] SAH cost degraded %.2fx, rebuilding TLAS", degradation);
+                refit = false;
+            }
         }
 
-        // Build TLAS
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
         inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
-        inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+                       D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
         inputs.NumDescs = static_cast<UINT>(instanceDescs.size());
         inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-        inputs.InstanceDescs = newInstanceBuffer->GetGPUVirtualAddress();
 
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo = {};
-        device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+        if (refit)
+        {
+            // The previous frame has completed, so its instance data can be overwritten
+            void* mapped = nullptr;
+            instanceBuffer->Map(0, nullptr, &mapped);
+            memcpy(mapped, instanceDescs.data(), instanceBufferSize);
+            instanceBuffer->Unmap(0, nullptr);
 
-        // Create TLAS buffer
-        ComPtr<ID3D12Resource> newTopLevelAS;
-        CreateBuffer(prebuildInfo.ResultDataMaxSizeInBytes,
-                    D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-                    D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
-                    &newTopLevelAS);
+            // Update TLAS in place
+            inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+            inputs.InstanceDescs = instanceBuffer->GetGPUVirtualAddress();
 
-        // Create scratch buffer (use member variable so it persists until GPU finishes)
-        CreateBuffer(prebuildInfo.ScratchDataSizeInBytes,
-                    D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-                    D3D12_RESOURCE_STATE_COMMON,
-                    &tlasScratchBuffer);
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            buildDesc.Inputs = inputs;
+            buildDesc.SourceAccelerationStructureData = topLevelAS->GetGPUVirtualAddress();
+            buildDesc.DestAccelerationStructureData = topLevelAS->GetGPUVirtualAddress();
+            buildDesc.ScratchAccelerationStructureData = tlasScratchBuffer->GetGPUVirtualAddress();
 
-        // Build TLAS
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
-        buildDesc.Inputs = inputs;
-        buildDesc.DestAccelerationStructureData = newTopLevelAS->GetGPUVirtualAddress();
-        buildDesc.ScratchAccelerationStructureData = tlasScratchBuffer->GetGPUVirtualAddress();
+            commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
 
-        commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
-
-        // UAV barrier
-        D3D12_RESOURCE_BARRIER barrier = {};
-        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-        barrier.UAV.pResource = newTopLevelAS.Get();
-        commandList->ResourceBarrier(1, &barrier);
+            // UAV barrier
+            D3D12_RESOURCE_BARRIER barrier = {};
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            barrier.UAV.pResource = topLevelAS.Get();
+            commandList->ResourceBarrier(1, &barrier);
+        }
+        else
+        {
+            // Create instance buffer
+            ComPtr<ID3D12Resource> newInstanceBuffer;
+            {
+                CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+                CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(instanceBufferSize);
+                device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+                    D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&newInstanceBuffer));
+                
+                void* mapped = nullptr;
+                newInstanceBuffer->Map(0, nullptr, &mapped);
+                memcpy(mapped, instanceDescs.data(), instanceBufferSize);
+                newInstanceBuffer->Unmap(0, nullptr);
+            }
 
-        // Update member variables
-        topLevelAS = std::move(newTopLevelAS);
-        instanceBuffer = std::move(newInstanceBuffer);
+            // Build TLAS
+            inputs.InstanceDescs = newInstanceBuffer->GetGPUVirtualAddress();
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo = {};
+            device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+
+            // Create TLAS buffer
+            ComPtr<ID3D12Resource> newTopLevelAS;
+            CreateBuffer(prebuildInfo.ResultDataMaxSizeInBytes,
+                        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                        D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+                        &newTopLevelAS);
+
+            // Create scratch buffer (use member variable so it persists until GPU finishes;
+            // sized for later updates as well)
+            CreateBuffer((std::max)(prebuildInfo.ScratchDataSizeInBytes, prebuildInfo.UpdateScratchDataSizeInBytes),
+                        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                        D3D12_RESOURCE_STATE_COMMON,
+                        &tlasScratchBuffer);
+
+            // Build TLAS
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            buildDesc.Inputs = inputs;
+            buildDesc.DestAccelerationStructureData = newTopLevelAS->GetGPUVirtualAddress();
+            buildDesc.ScratchAccelerationStructureData = tlasScratchBuffer->GetGPUVirtualAddress();
+
+            commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+
+            // UAV barrier
+            D3D12_RESOURCE_BARRIER barrier = {};
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            barrier.UAV.pResource = newTopLevelAS.Get();
+            commandList->ResourceBarrier(1, &barrier);
+
+            // Update member variables
+            topLevelAS = std::move(newTopLevelAS);
+            instanceBuffer = std::move(newInstanceBuffer);
+            tlasBvh.Build(instanceBounds);
+            lastUpdateRebuilt = true;
+        }
 
+        previousInstanceDescs = std::move(instanceDescs);
+        blasContentChanged = false;
         return true;
     }
 }
@@ -9,6 +9,8 @@
 #include <set>
 #include <string>
 #include <DirectXMath.h>
+#include "CpuBvh.h"
+#include "ResidencyManager.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -19,16 +21,9 @@ namespace RayTraceVS::DXEngine
     class Scene;
     struct MeshCacheEntry;
 
-    // Forward declare ObjectType from RayTracingObject.h
+    // Forward declare ObjectType from Scene/Objects/Primitives.h
     enum class ObjectType;
 
-    // AABB structure for procedural geometry (must match D3D12_RAYTRACING_AABB)
-    struct AABB
-    {
-        float MinX, MinY, MinZ;
-        float MaxX, MaxY, MaxZ;
-    };
-
     // Geometry instance info for shader access
     struct GeometryInstanceInfo
     {
@@ -56,6 +51,20 @@ namespace RayTraceVS::DXEngine
         UINT indexCount;
     };
 
+    // Procedural BLAS over one partition (static or dynamic) of the scene's primitives.
+    // Both partitions are built over the full AABB array so PrimitiveIndex() stays the
+    // global primitive index; primitives owned by the other partition are inactive (NaN).
+    struct ProceduralBLAS
+    {
+        ComPtr<ID3D12Resource> blas;
+        ComPtr<ID3D12Resource> scratchBuffer;  // Must persist until GPU finishes building
+        ComPtr<ID3D12Resource> aabbBuffer;
+        ComPtr<ID3D12Resource> aabbUploadBuffer;
+        std::vector<uint32_t> primitives;      // Active primitives (global indices)
+        CpuBvh bvh;                            // CPU mirror for refit quality tracking
+        bool allowUpdate = false;              // Built with ALLOW_UPDATE (refittable)
+    };
+
     class AccelerationStructure
     {
     public:
@@ -70,16 +79,29 @@ namespace RayTraceVS::DXEngine
         bool BuildProceduralBLAS(Scene* scene);
         bool BuildProceduralTLAS();
         
-        // Mesh BLAS support (shared BLAS per mesh type)
-        bool BuildMeshBLAS(const std::string& meshName, const MeshCacheEntry& meshCache);
-        bool HasMeshBLAS(const std::string& meshName) const;
-        MeshBLASEntry* GetMeshBLAS(const std::string& meshName);
+        // Mesh BLAS support (one BLAS per unique geometry, keyed by the Scene content key)
+        bool BuildMeshBLAS(const std::string& meshKey, const MeshCacheEntry& meshCache);
+        bool HasMeshBLAS(const std::string& meshKey) const;
+        MeshBLASEntry* GetMeshBLAS(const std::string& meshKey);
         
         // Combined TLAS (procedural + triangle meshes)
         bool BuildCombinedTLAS(Scene* scene);
 
+        // Mesh BLASes no instance uses stay cached (LRU) until they exceed the budget;
+        // BLASes of the current instances are never evicted
+        void SetMeshResidencyBudget(uint64_t budgetBytes) { meshResidency.SetBudget(budgetBytes); }
+        const ResidencyStats& GetMeshResidencyStats() const { return meshResidency.GetStats(); }
+
         ID3D12Resource* GetTLAS() const { return topLevelAS.Get(); }
-        ID3D12Resource* GetBLAS() const { return bottomLevelAS.Get(); }
+        ID3D12Resource* GetBLAS() const
+        {
+            if (staticBLAS.blas) return staticBLAS.blas.Get();
+            return dynamicBLAS.blas ? dynamicBLAS.blas.Get() : planeBLAS.blas.Get();
+        }
+
+        // True if the last BuildProceduralBLAS/BuildCombinedTLAS pair only refitted
+        // (or kept) existing structures and performed no full build
+        bool LastUpdateWasRefit() const { return !lastUpdateRebuilt; }
         
         // Get instance info for shader
         const std::vector<GeometryInstanceInfo>& GetInstanceInfo() const { return instanceInfo; }
@@ -90,15 +112,17 @@ namespace RayTraceVS::DXEngine
         void ClearMeshBLAS() { 
             topLevelAS.Reset();  // Reset TLAS first to avoid dangling BLAS references
             meshBLASMap.clear(); 
+            meshResidency.Clear();
         }
         
         // Remove mesh BLASes not in the current scene (safer than clearing all)
-        // Takes a set of mesh names that should be kept
-        void RemoveStaleMeshBLAS(const std::set<std::string>& currentMeshNames) {
+        // Takes the set of mesh content keys that should be kept
+        void RemoveStaleMeshBLAS(const std::set<std::string>& currentMeshKeys) {
             // First reset TLAS to avoid dangling references during removal
             topLevelAS.Reset();
             for (auto it = meshBLASMap.begin(); it != meshBLASMap.end(); ) {
-                if (currentMeshNames.find(it->first) == currentMeshNames.end()) {
+                if (currentMeshKeys.find(it->first) == currentMeshKeys.end()) {
+                    meshResidency.Remove(it->first);
                     it = meshBLASMap.erase(it);
                 } else {
                     ++it;
@@ -110,20 +134,40 @@ namespace RayTraceVS::DXEngine
         DXContext* dxContext;
 
         // Acceleration structures
-        ComPtr<ID3D12Resource> bottomLevelAS;       // Procedural BLAS
+        ComPtr<ID3D12Resource> bottomLevelAS;       // Legacy triangle BLAS
         ComPtr<ID3D12Resource> topLevelAS;          // Combined TLAS
-        ComPtr<ID3D12Resource> scratchBuffer;
+        ComPtr<ID3D12Resource> scratchBuffer;       // Legacy BLAS/TLAS scratch
         ComPtr<ID3D12Resource> instanceBuffer;
 
-        // AABB buffer for procedural geometry
-        ComPtr<ID3D12Resource> aabbBuffer;
-        ComPtr<ID3D12Resource> aabbUploadBuffer;
+        // Procedural BLASes: rarely moving primitives are built once for fast trace,
+        // moving ones are refitted in place every update
+        ProceduralBLAS staticBLAS;
+        ProceduralBLAS dynamicBLAS;
+        // Planes are unbounded; kept out of the sphere/box BLASes so their huge boxes do
+        // not overlap every node there. Rebuilt (never refitted) when a plane changes.
+        ProceduralBLAS planeBLAS;
+
+        // Motion tracking for the static/dynamic split
+        static constexpr uint32_t DYNAMIC_RETENTION_UPDATES = 30;  // Updates without motion before demotion to static
+        static constexpr float DYNAMIC_FRACTION_LIMIT = 0.5f;      // Above this, everything is dynamic
+        static constexpr float REFIT_SAH_THRESHOLD = 1.5f;         // SAH degradation that forces a full build
+        std::vector<AABB> proceduralAabbs;          // AABBs of the last update
+        std::vector<uint64_t> lastMovedUpdate;      // Update number of the last motion, 0 = never
+        std::vector<bool> isDynamic;                // Always false for planes
+        uint64_t proceduralUpdateCount = 0;
+
+        // TLAS refit state
+        std::vector<D3D12_RAYTRACING_INSTANCE_DESC> previousInstanceDescs;
+        CpuBvh tlasBvh;                             // Mirror over instance world bounds
+        bool blasContentChanged = false;            // A BLAS was built or refitted since the last TLAS update
+        bool lastUpdateRebuilt = false;
         
         // TLAS scratch buffer (must persist until GPU finishes building)
         ComPtr<ID3D12Resource> tlasScratchBuffer;
         
-        // Mesh BLASes (shared per mesh type, keyed by mesh name)
-        std::unordered_map<std::string, MeshBLASEntry> meshBLASMap;
+        // Mesh BLASes (one per unique geometry), cached across scenes within the budget
+        std::unordered_map<std::string, MeshBLASEntry> meshBLASMap;   // By mesh content key
+        ResidencyManager meshResidency;
 
         // Instance info for shader
         std::vector<GeometryInstanceInfo> instanceInfo;
@@ -132,10 +176,11 @@ namespace RayTraceVS::DXEngine
         // Helper functions
         void CreateBuffer(UINT64 size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState, ID3D12Resource** resource);
         void CreateUploadBuffer(UINT64 size, ID3D12Resource** resource);
-        
-        // AABB calculation for each object type
-        static AABB CalculateSphereAABB(const XMFLOAT3& center, float radius);
-        static AABB CalculatePlaneAABB(const XMFLOAT3& position, const XMFLOAT3& normal);
-        static AABB CalculateBoxAABB(const XMFLOAT3& center, const XMFLOAT3& size);
+
+        // Procedural partitions (see ProceduralBLAS)
+        bool UploadPartitionAABBs(ProceduralBLAS& partition, const std::vector<AABB>& aabbs);
+        bool BuildPartition(ProceduralBLAS& partition, const std::vector<AABB>& aabbs, bool allowUpdate);
+        bool RefitPartition(ProceduralBLAS& partition, const std::vector<AABB>& aabbs, const std::vector<uint32_t>& moved);
+        void AppendProceduralInstances(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs, std::vector<AABB>& instanceBounds) const;
     };
 }
@@ -0,0 +1,1112 @@
+#include "CpuAccelerationStructure.h"
+#include "DebugLog.h"
+#include "WorkerPool.h"
+#include "Scene/Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr uint32_t TRAVERSAL_STACK_SIZE = 64;
+        constexpr size_t FLOATS_PER_VERTEX = 8;     // pos3 + pad + normal3 + pad (MeshCacheEntry)
+
+        struct TraversalRay
+        {
+            float origin[3];
+            float direction[3];
+            float invDirection[3];
+        };
+
+        TraversalRay MakeTraversalRay(const float origin[3], const float direction[3])
+        {
+            TraversalRay ray;
+            for (int i = 0; i < 3; i++)
+            {
+                ray.origin[i] = origin[i];
+                ray.direction[i] = direction[i];
+                // IEEE division gives +-inf for axis-parallel rays, which the slab test handles
+                ray.invDirection[i] = 1.0f / direction[i];
+            }
+            return ray;
+        }
+
+        // Slab test; on a hit tEntry is where the ray enters the box (clamped to tMin)
+        bool IntersectBox(const AABB& box, const TraversalRay& ray, float tMin, float tMax, float& tEntry)
+        {
+            const float boxMin[3] = { box.MinX, box.MinY, box.MinZ };
+            const float boxMax[3] = { box.MaxX, box.MaxY, box.MaxZ };
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float t0 = (boxMin[axis] - ray.origin[axis]) * ray.invDirection[axis];
+                float t1 = (boxMax[axis] - ray.origin[axis]) * ray.invDirection[axis];
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                tMin = (t0 > tMin) ? t0 : tMin;
+                tMax = (t1 < tMax) ? t1 : tMax;
+                if (tMin > tMax)
+                    return false;
+            }
+            tEntry = tMin;
+            return true;
+        }
+
+        // Moller-Trumbore, double-sided
+        bool IntersectTriangle(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2, const TraversalRay& ray,
+            float tMin, float tMax, float& t, float& u, float& v)
+        {
+            const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+            const float* d = ray.direction;
+            const float pvec[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+            const float det = e1[0] * pvec[0] + e1[1] * pvec[1] + e1[2] * pvec[2];
+            if (std::abs(det) < 1e-12f)
+                return false;
+
+            const float invDet = 1.0f / det;
+            const float tvec[3] = { ray.origin[0] - p0.x, ray.origin[1] - p0.y, ray.origin[2] - p0.z };
+            u = (tvec[0] * pvec[0] + tvec[1] * pvec[1] + tvec[2] * pvec[2]) * invDet;
+            if (u < 0.0f || u > 1.0f)
+                return false;
+
+            const float qvec[3] = { tvec[1] * e1[2] - tvec[2] * e1[1], tvec[2] * e1[0] - tvec[0] * e1[2], tvec[0] * e1[1] - tvec[1] * e1[0] };
+            v = (d[0] * qvec[0] + d[1] * qvec[1] + d[2] * qvec[2]) * invDet;
+            if (v < 0.0f || u + v > 1.0f)
+                return false;
+
+            t = (e2[0] * qvec[0] + e2[1] * qvec[1] + e2[2] * qvec[2]) * invDet;
+            return t >= tMin && t <= tMax;
+        }
+
+        float Dot3(const float a[3], const XMFLOAT3& b)
+        {
+            return a[0] * b.x + a[1] * b.y + a[2] * b.z;
+        }
+
+        XMFLOAT3 Normalize3(const XMFLOAT3& v)
+        {
+            const float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+            if (!(length > 1e-6f))
+                return XMFLOAT3(0.0f, 0.0f, 0.0f);
+            return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+        }
+
+        // Same quadratic and root selection as SphereIntersection
+        bool IntersectSphere(const SphereGeometry& sphere, const float origin[3], const float direction[3],
+            float tMin, float tMax, float& t, XMFLOAT3& normal)
+        {
+            const float oc[3] = { origin[0] - sphere.center.x, origin[1] - sphere.center.y, origin[2] - sphere.center.z };
+            const float a = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+            const float b = 2.0f * (oc[0] * direction[0] + oc[1] * direction[1] + oc[2] * direction[2]);
+            const float c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - sphere.radius * sphere.radius;
+            const float discriminant = b * b - 4.0f * a * c;
+            if (discriminant < 0.0f)
+                return false;
+
+            const float sqrtD = std::sqrt(discriminant);
+            t = (-b - sqrtD) / (2.0f * a);
+            if (t < tMin)
+                t = (-b + sqrtD) / (2.0f * a);
+            if (!(t >= tMin && t <= tMax))
+                return false;
+
+            normal = Normalize3(XMFLOAT3(oc[0] + direction[0] * t, oc[1] + direction[1] * t, oc[2] + direction[2] * t));
+            return true;
+        }
+
+        bool IntersectPlane(const PlaneGeometry& plane, const float origin[3], const float direction[3],
+            float tMin, float tMax, float& t, XMFLOAT3& normal)
+        {
+            const XMFLOAT3 n = Normalize3(plane.normal);
+            const float denom = Dot3(direction, n);
+            if (!(std::abs(denom) > 0.0001f))
+                return false;
+
+            const float p0[3] = { plane.position.x - origin[0], plane.position.y - origin[1], plane.position.z - origin[2] };
+            t = Dot3(p0, n) / denom;
+            if (!(t >= tMin && t <= tMax))
+                return false;
+
+            normal = n;
+            return true;
+        }
+
+        // Local-space slab test of the OBB, as in the box branch of SphereIntersection
+        bool IntersectOrientedBox(const BoxGeometry& box, const float origin[3], const float direction[3],
+            float tMin, float tMax, float& t, XMFLOAT3& normal)
+        {
+            constexpr float INF = 1e20f;
+            constexpr float EPS = 1e-6f;
+
+            const float delta[3] = { origin[0] - box.center.x, origin[1] - box.center.y, origin[2] - box.center.z };
+            const XMFLOAT3* axes[3] = { &box.axisX, &box.axisY, &box.axisZ };
+            const float size[3] = { box.size.x, box.size.y, box.size.z };
+
+            float localDir[3];
+            float tNear = -INF, tFar = INF;
+            int nearAxis = 0, farAxis = 0;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float localOrigin = Dot3(delta, *axes[axis]);
+                localDir[axis] = Dot3(direction, *axes[axis]);
+
+                float t0 = -INF, t1 = INF;
+                if (std::abs(localDir[axis]) < EPS)
+                {
+                    if (localOrigin < -size[axis] || localOrigin > size[axis])
+                        return false;
+                }
+                else
+                {
+                    const float inv = 1.0f / localDir[axis];
+                    t0 = (-size[axis] - localOrigin) * inv;
+                    t1 = (size[axis] - localOrigin) * inv;
+                    if (t0 > t1)
+                        std::swap(t0, t1);
+                }
+
+                // Strict comparisons keep the first axis on ties, like the shader
+                if (axis == 0 || t0 > tNear)
+                {
+                    tNear = t0;
+                    nearAxis = axis;
+                }
+                if (axis == 0 || t1 < tFar)
+                {
+                    tFar = t1;
+                    farAxis = axis;
+                }
+            }
+
+            if (!(tNear <= tFar && tFar >= tMin))
+                return false;
+
+            t = tNear;
+            int axis = nearAxis;
+            if (t < tMin)
+            {
+                t = tFar;
+                axis = farAxis;
+            }
+            if (!(t >= tMin && t <= tMax))
+                return false;
+
+            // Face normal opposes the local direction on the entered/exited axis
+            const float sign = localDir[axis] > 0.0f ? -1.0f : 1.0f;
+            normal = Normalize3(XMFLOAT3(axes[axis]->x * sign, axes[axis]->y * sign, axes[axis]->z * sign));
+            return true;
+        }
+
+        // Visits the leaf primitives whose node boxes the ray enters, nearer child first.
+        // visitPrimitive(primitive, tMax) may shrink tMax and returns true to stop the traversal.
+        template<typename PrimitiveVisitor>
+        bool TraverseBvh(const CpuBvh& bvh, const TraversalRay& ray, float tMin, float& tMax, PrimitiveVisitor&& visitPrimitive)
+        {
+            if (bvh.Empty())
+                return false;
+
+            const std::vector<BvhNode>& nodes = bvh.GetNodes();
+            const std::vector<uint32_t>& order = bvh.GetPrimitiveOrder();
+
+            // Fixed stack for the common case; badly balanced trees spill into the vector
+            uint32_t stack[TRAVERSAL_STACK_SIZE];
+            uint32_t stackSize = 0;
+            std::vector<uint32_t> overflow;
+            auto push = [&](uint32_t node)
+            {
+                if (stackSize < TRAVERSAL_STACK_SIZE)
+                    stack[stackSize++] = node;
+                else
+                    overflow.push_back(node);
+            };
+
+            float tEntry;
+            if (!IntersectBox(nodes[0].bounds, ray, tMin, tMax, tEntry))
+                return false;
+            push(0);
+
+            while (stackSize > 0 || !overflow.empty())
+            {
+                uint32_t nodeIndex;
+                if (!overflow.empty())
+                {
+                    nodeIndex = overflow.back();
+                    overflow.pop_back();
+                }
+                else
+                {
+                    nodeIndex = stack[--stackSize];
+                }
+
+                const BvhNode& node = nodes[nodeIndex];
+                // Re-test: tMax may have shrunk since the node was pushed
+                if (!IntersectBox(node.bounds, ray, tMin, tMax, tEntry))
+                    continue;
+
+                if (node.count > 0)
+                {
+                    for (uint32_t slot = node.firstOrLeft; slot < node.firstOrLeft + node.count; slot++)
+                    {
+                        if (visitPrimitive(order[slot], tMax))
+                            return true;
+                    }
+                    continue;
+                }
+
+                float tLeft, tRight;
+                const uint32_t left = node.firstOrLeft;
+                const uint32_t right = node.firstOrLeft + 1;
+                const bool hitLeft = IntersectBox(nodes[left].bounds, ray, tMin, tMax, tLeft);
+                const bool hitRight = IntersectBox(nodes[right].bounds, ray, tMin, tMax, tRight);
+                if (hitLeft && hitRight)
+                {
+                    // Push the farther child first so the nearer one is visited next
+                    push(tLeft <= tRight ? right : left);
+                    push(tLeft <= tRight ? left : right);
+                }
+                else if (hitLeft)
+                {
+                    push(left);
+                }
+                else if (hitRight)
+                {
+                    push(right);
+                }
+            }
+            return false;
+        }
+
+        // Object-space ray of an instance; the direction is not renormalized, so t stays in world units
+        TraversalRay MakeObjectRay(const Transform3x4& worldToObject, const float origin[3], const float direction[3])
+        {
+            const auto& w2o = worldToObject.m;
+            float objectOrigin[3], objectDirection[3];
+            for (int row = 0; row < 3; row++)
+            {
+                objectOrigin[row] = w2o[row][0] * origin[0] + w2o[row][1] * origin[1] + w2o[row][2] * origin[2] + w2o[row][3];
+                objectDirection[row] = w2o[row][0] * direction[0] + w2o[row][1] * direction[1] + w2o[row][2] * direction[2];
+            }
+            return MakeTraversalRay(objectOrigin, objectDirection);
+        }
+
+        // Object-space face normal to world space with the inverse transpose
+        XMFLOAT3 NormalToWorld(const Transform3x4& worldToObject, const XMFLOAT3& n)
+        {
+            const auto& w2o = worldToObject.m;
+            return Normalize3(XMFLOAT3(
+                w2o[0][0] * n.x + w2o[1][0] * n.y + w2o[2][0] * n.z,
+                w2o[0][1] * n.x + w2o[1][1] * n.y + w2o[2][1] * n.z,
+                w2o[0][2] * n.x + w2o[1][2] * n.y + w2o[2][2] * n.z));
+        }
+
+        // Closest (or, without hit, any) triangle of an indexed triangle BVH; tMax becomes the
+        // hit distance. With hit, t, barycentrics and the triangle (through triangleIds when
+        // given) are filled in and objectNormal gets the unnormalized object-space face normal.
+        bool IntersectTriangles(const CpuBvh& bvh, const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices,
+            const std::vector<uint32_t>* triangleIds, const TraversalRay& ray, float tMin, float& tMax,
+            CpuRayHit* hit, XMFLOAT3& objectNormal)
+        {
+            bool found = false;
+            uint32_t closest = 0;
+            TraverseBvh(bvh, ray, tMin, tMax, [&](uint32_t triangle, float& currentMax)
+            {
+                const uint32_t* tri = &indices[triangle * 3];
+                float t, u, v;
+                if (!IntersectTriangle(positions[tri[0]], positions[tri[1]], positions[tri[2]],
+                        ray, tMin, currentMax, t, u, v))
+                {
+                    return false;
+                }
+
+                found = true;
+                currentMax = t;
+                if (!hit)
+                    return true;    // Any hit is enough
+
+                hit->t = t;
+                hit->barycentrics[0] = u;
+                hit->barycentrics[1] = v;
+                closest = triangle;
+                return false;
+            });
+
+            if (found && hit)
+            {
+                const uint32_t* tri = &indices[closest * 3];
+                const XMFLOAT3& p0 = positions[tri[0]];
+                const XMFLOAT3& p1 = positions[tri[1]];
+                const XMFLOAT3& p2 = positions[tri[2]];
+                const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+                const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+                objectNormal = XMFLOAT3(e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]);
+                hit->primitiveIndex = triangleIds ? (*triangleIds)[closest] : closest;
+            }
+            return found;
+        }
+    }
+
+    // ============================================
+    // Transforms
+    // ============================================
+
+    namespace
+    {
+        // Fewer instances than this per pool task are not worth the hand-off
+        constexpr size_t INSTANCES_PER_TRANSFORM_CHUNK = 4096;
+
+        // scale * rotation * translation (row vectors). The scale and translation matrices are
+        // diagonal and identity-but-last-row, so the products reduce to scaling the rotation rows
+        // and setting row 3.
+        XMMATRIX InstanceMatrix(const MeshTransform& transform)
+        {
+            const XMMATRIX rotation = XMMatrixRotationRollPitchYaw(
+                XMConvertToRadians(transform.rotation.x),
+                XMConvertToRadians(transform.rotation.y),
+                XMConvertToRadians(transform.rotation.z));
+
+            XMMATRIX world;
+            world.r[0] = XMVectorScale(rotation.r[0], transform.scale.x);
+            world.r[1] = XMVectorScale(rotation.r[1], transform.scale.y);
+            world.r[2] = XMVectorScale(rotation.r[2], transform.scale.z);
+            world.r[3] = XMVectorSet(transform.position.x, transform.position.y, transform.position.z, 1.0f);
+            return world;
+        }
+
+        // DirectXMath stores translation in row 3 (m[3][0..2]); transpose so that
+        // Transform[row][3] holds it, as DXR expects
+        Transform3x4 StoreTransform3x4(const XMMATRIX& world)
+        {
+            const XMMATRIX transposed = XMMatrixTranspose(world);
+            Transform3x4 result;
+            for (int row = 0; row < 3; row++)
+            {
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(result.m[row]), transposed.r[row]);
+            }
+            return result;
+        }
+
+        // TransformAABB on the untransposed matrix: each row is the image of one object axis
+        AABB TransformAABBRows(const AABB& box, const XMMATRIX& world)
+        {
+            XMVECTOR outMin = world.r[3];
+            XMVECTOR outMax = world.r[3];
+            const float boxMin[3] = { box.MinX, box.MinY, box.MinZ };
+            const float boxMax[3] = { box.MaxX, box.MaxY, box.MaxZ };
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const XMVECTOR a = XMVectorScale(world.r[axis], boxMin[axis]);
+                const XMVECTOR b = XMVectorScale(world.r[axis], boxMax[axis]);
+                outMin = XMVectorAdd(outMin, XMVectorMin(a, b));
+                outMax = XMVectorAdd(outMax, XMVectorMax(a, b));
+            }
+
+            XMFLOAT3 minF, maxF;
+            XMStoreFloat3(&minF, outMin);
+            XMStoreFloat3(&maxF, outMax);
+            return { minF.x, minF.y, minF.z, maxF.x, maxF.y, maxF.z };
+        }
+    }
+
+    Transform3x4 GetInstanceTransform(const MeshTransform& transform)
+    {
+        return StoreTransform3x4(InstanceMatrix(transform));
+    }
+
+    void ComputeInstanceTransforms(std::span<const MeshInstance> instances, std::span<const AABB> objectBounds,
+        std::span<Transform3x4> objectToWorld, std::span<AABB> worldBounds, std::span<Transform3x4> worldToObject)
+    {
+        const size_t count = instances.size();
+        const size_t chunkCount = (count + INSTANCES_PER_TRANSFORM_CHUNK - 1) / INSTANCES_PER_TRANSFORM_CHUNK;
+        ParallelChunks(count, chunkCount, 0, [&](size_t, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const XMMATRIX world = InstanceMatrix(instances[i].transform);
+                objectToWorld[i] = StoreTransform3x4(world);
+                worldBounds[i] = TransformAABBRows(objectBounds[i], world);
+                if (!worldToObject.empty())
+                    worldToObject[i] = InverseTransform(objectToWorld[i]);
+            }
+        });
+    }
+
+    Transform3x4 InverseTransform(const Transform3x4& transform)
+    {
+        const auto& a = transform.m;
+        // Inverse of the linear part via cofactors
+        const float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+        const float c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+        const float c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+        const float det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+
+        Transform3x4 result = {};
+        if (std::abs(det) < 1e-20f)
+        {
+            // Zero scale: the instance has no volume, leave the inverse zero so rays miss it
+            return result;
+        }
+
+        const float invDet = 1.0f / det;
+        auto& r = result.m;
+        r[0][0] = c00 * invDet;
+        r[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * invDet;
+        r[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * invDet;
+        r[1][0] = c01 * invDet;
+        r[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * invDet;
+        r[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * invDet;
+        r[2][0] = c02 * invDet;
+        r[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * invDet;
+        r[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * invDet;
+
+        // Inverse translation = -R^-1 * t
+        for (int row = 0; row < 3; row++)
+        {
+            r[row][3] = -(r[row][0] * a[0][3] + r[row][1] * a[1][3] + r[row][2] * a[2][3]);
+        }
+        return result;
+    }
+
+    AABB TransformAABB(const AABB& box, const Transform3x4& transform)
+    {
+        // Per output axis, each input axis contributes its smaller/larger product (Arvo)
+        const float boxMin[3] = { box.MinX, box.MinY, box.MinZ };
+        const float boxMax[3] = { box.MaxX, box.MaxY, box.MaxZ };
+        float outMin[3], outMax[3];
+        for (int row = 0; row < 3; row++)
+        {
+            outMin[row] = outMax[row] = transform.m[row][3];
+            for (int col = 0; col < 3; col++)
+            {
+                const float a = transform.m[row][col] * boxMin[col];
+                const float b = transform.m[row][col] * boxMax[col];
+                outMin[row] += (std::min)(a, b);
+                outMax[row] += (std::max)(a, b);
+            }
+        }
+        return { outMin[0], outMin[1], outMin[2], outMax[0], outMax[1], outMax[2] };
+    }
+
+    // ============================================
+    // Procedural bounds
+    // ============================================
+
+    AABB CalculateSphereAABB(const SphereGeometry& sphere)
+    {
+        const XMFLOAT3& c = sphere.center;
+        const float r = sphere.radius;
+        return { c.x - r, c.y - r, c.z - r, c.x + r, c.y + r, c.z + r };
+    }
+
+    AABB CalculateBoxAABB(const BoxGeometry& box)
+    {
+        const XMFLOAT3 ax = Normalize3(box.axisX);
+        const XMFLOAT3 ay = Normalize3(box.axisY);
+        const XMFLOAT3 az = Normalize3(box.axisZ);
+        const XMFLOAT3& size = box.size;   // half-extents
+
+        // Each world axis gets the projections of the three local half-extent vectors
+        const float hx = std::abs(ax.x) * size.x + std::abs(ay.x) * size.y + std::abs(az.x) * size.z;
+        const float hy = std::abs(ax.y) * size.x + std::abs(ay.y) * size.y + std::abs(az.y) * size.z;
+        const float hz = std::abs(ax.z) * size.x + std::abs(ay.z) * size.y + std::abs(az.z) * size.z;
+
+        const XMFLOAT3& c = box.center;
+        return { c.x - hx, c.y - hy, c.z - hz, c.x + hx, c.y + hy, c.z + hz };
+    }
+
+    AABB CalculatePlaneAABB(const PlaneGeometry& plane)
+    {
+        XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&plane.normal));
+        XMFLOAT3 normal;
+        XMStoreFloat3(&normal, n);
+
+        // Tangent frame of the plane
+        XMVECTOR tangent = (std::abs(normal.y) < 0.999f)
+            ? XMVector3Cross(XMVectorSet(0, 1, 0, 0), n)
+            : XMVector3Cross(XMVectorSet(1, 0, 0, 0), n);
+        tangent = XMVector3Normalize(tangent);
+        XMVECTOR bitangent = XMVector3Cross(n, tangent);
+        XMFLOAT3 t, b;
+        XMStoreFloat3(&t, tangent);
+        XMStoreFloat3(&b, bitangent);
+
+        // Bounds of the square of half-size PLANE_BOUNDS_EXTENT spanned by the tangents,
+        // thickened along the normal: an axis-aligned floor gets a slab, not a cube
+        const float hx = PLANE_BOUNDS_EXTENT * (std::abs(t.x) + std::abs(b.x)) + PLANE_BOUNDS_THICKNESS * std::abs(normal.x);
+        const float hy = PLANE_BOUNDS_EXTENT * (std::abs(t.y) + std::abs(b.y)) + PLANE_BOUNDS_THICKNESS * std::abs(normal.y);
+        const float hz = PLANE_BOUNDS_EXTENT * (std::abs(t.z) + std::abs(b.z)) + PLANE_BOUNDS_THICKNESS * std::abs(normal.z);
+
+        const XMFLOAT3& p = plane.position;
+        return { p.x - hx, p.y - hy, p.z - hz, p.x + hx, p.y + hy, p.z + hz };
+    }
+
+    // ============================================
+    // Build
+    // ============================================
+
+    static uint64_t GetBLASBytes(const CpuMeshBLAS& blas)
+    {
+        return blas.positions.size() * sizeof(XMFLOAT3) + blas.indices.size() * sizeof(uint32_t) +
+            blas.bvh.GetNodeCount() * sizeof(BvhNode) + blas.bvh.GetPrimitiveCount() * sizeof(uint32_t);
+    }
+
+    void CpuAccelerationStructure::Clear()
+    {
+        blases.clear();
+        cachedBlases.clear();
+        meshResidency.Clear();
+        instances.clear();
+        topLevel.Clear();
+        instanceBounds.clear();
+        geometryStreamer.Clear();
+        hasPagedGeometry = false;
+        spheres.clear();
+        boxes.clear();
+        planes.clear();
+        staticProceduralBvh.Clear();
+        dynamicProceduralBvh.Clear();
+        staticPrimitives.clear();
+        dynamicPrimitives.clear();
+        proceduralBounds.clear();
+        lastMovedUpdate.clear();
+        isDynamic.clear();
+        updateStats = {};
+    }
+
+    void CpuAccelerationStructure::BuildMeshBLASes(const Scene& scene)
+    {
+        // Keys are content hashes, so a cached BLAS stays valid for its key. The previous
+        // scene's BLASes join the cache; the ones this scene needs are taken back out.
+        for (CpuMeshBLAS& blas : blases)
+        {
+            std::string key = blas.meshKey;
+            cachedBlases.insert_or_assign(std::move(key), std::move(blas));
+        }
+
+        // Instances reference BLASes by index
+        blases.clear();
+        instances.clear();
+        topLevel.Clear();
+        meshResidency.BeginFrame();
+
+        size_t reused = 0;
+        for (const auto& [key, cache] : scene.GetMeshCaches())
+        {
+            auto kept = cachedBlases.find(key);
+            if (kept != cachedBlases.end())
+            {
+                blases.push_back(std::move(kept->second));
+                cachedBlases.erase(kept);
+                meshResidency.Use(key);
+                reused++;
+                continue;
+            }
+
+            const std::string& name = cache.name;
+            CpuMeshBLAS blas;
+            blas.meshKey = key;
+            if (!cache.pagedFile.empty())
+            {
+                // Only the chunk bounds are needed up front; chunks load when rays reach them
+                blas.pagedMesh = geometryStreamer.OpenMesh(cache.pagedFile);
+                if (blas.pagedMesh == CpuBvh::INVALID_INDEX)
+                {
+                    LOG_WARNF("[CpuAccelerationStructure] Paged mesh '%s' cannot be opened, skipped", name);
+                    continue;
+                }
+                const PagedMeshFile& file = geometryStreamer.GetMesh(blas.pagedMesh);
+                std::vector<AABB> chunkBounds;
+                for (const PagedMeshChunkRecord& chunk : file.GetChunks())
+                    chunkBounds.push_back(chunk.bounds);
+                blas.firstChunk = geometryStreamer.GetFirstChunk(blas.pagedMesh);
+                blas.bvh.Build(chunkBounds);
+                blas.bounds = file.GetBounds();
+                meshResidency.Add(key, GetBLASBytes(blas));
+                blases.push_back(std::move(blas));
+                continue;
+            }
+
+            const size_t vertexCount = cache.vertices.size() / FLOATS_PER_VERTEX;
+            const size_t triangleCount = cache.indices.size() / 3;
+            if (vertexCount == 0 || triangleCount == 0)
+                continue;
+
+            blas.positions.resize(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                const float* vertex = &cache.vertices[v * FLOATS_PER_VERTEX];
+                blas.positions[v] = XMFLOAT3(vertex[0], vertex[1], vertex[2]);
+            }
+            blas.indices.assign(cache.indices.begin(), cache.indices.begin() + triangleCount * 3);
+
+            std::vector<AABB> triangleBounds(triangleCount);
+            blas.bounds = EmptyAABB();
+            bool valid = true;
+            for (size_t tri = 0; tri < triangleCount && valid; tri++)
+            {
+                AABB bounds = EmptyAABB();
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    const uint32_t index = blas.indices[tri * 3 + corner];
+                    if (index >= vertexCount)
+                    {
+                        valid = false;
+                        break;
+                    }
+                    const XMFLOAT3& p = blas.positions[index];
+                    ExpandAABB(bounds, { p.x, p.y, p.z, p.x, p.y, p.z });
+                }
+                triangleBounds[tri] = bounds;
+                ExpandAABB(blas.bounds, bounds);
+            }
+            if (!valid)
+            {
+                LOG_WARNF("[CpuAccelerationStructure] Mesh '%s' has out-of-range indices, skipped", name);
+                continue;
+            }
+
+            if (cache.spatialSplits)
+            {
+                std::vector<float> triangleVertices(triangleCount * 9);
+                for (size_t i = 0; i < triangleCount * 3; i++)
+                {
+                    const XMFLOAT3& p = blas.positions[blas.indices[i]];
+                    triangleVertices[i * 3 + 0] = p.x;
+                    triangleVertices[i * 3 + 1] = p.y;
+                    triangleVertices[i * 3 + 2] = p.z;
+                }
+                blas.bvh.BuildSpatial(triangleBounds, triangleVertices);
+                LOG_DEBUGF("[CpuAccelerationStructure] SBVH for '%s': %zu references for %zu triangles",
+                    name, blas.bvh.GetPrimitiveCount(), triangleCount);
+            }
+            else
+            {
+                blas.bvh.Build(triangleBounds);
+            }
+            meshResidency.Add(key, GetBLASBytes(blas));
+            blases.push_back(std::move(blas));
+        }
+
+        // Drop cached BLASes beyond the budget, least recently used first
+        for (const std::string& key : meshResidency.Trim())
+        {
+            cachedBlases.erase(key);
+        }
+
+        LOG_DEBUGF("[CpuAccelerationStructure] %zu mesh BLASes (%zu reused, %zu triangles)",
+            blases.size(), reused, GetUniqueTriangleCount());
+    }
+
+    void CpuAccelerationStructure::BuildInstances(const Scene& scene)
+    {
+        instances.clear();
+        hasPagedGeometry = false;
+
+        std::unordered_map<std::string, uint32_t> blasIndexByKey;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(blases.size()); i++)
+        {
+            blasIndexByKey[blases[i].meshKey] = i;
+        }
+
+        // Resolve each instance's BLAS, then transform all of them in one pass
+        const auto& meshInstances = scene.GetMeshInstances();
+        const size_t count = meshInstances.size();
+        std::vector<uint32_t> blasIndices(count, CpuBvh::INVALID_INDEX);
+        std::vector<AABB> objectBounds(count, AABB{});
+        for (size_t i = 0; i < count; i++)
+        {
+            const std::string* key = scene.FindMeshKey(meshInstances[i].meshName);
+            auto it = key ? blasIndexByKey.find(*key) : blasIndexByKey.end();
+            if (it == blasIndexByKey.end())
+                continue;
+            blasIndices[i] = it->second;
+            objectBounds[i] = blases[it->second].bounds;
+        }
+
+        std::vector<Transform3x4> transforms(count);
+        std::vector<Transform3x4> inverseTransforms(count);
+        std::vector<AABB> worldBounds(count);
+        ComputeInstanceTransforms(meshInstances, objectBounds, transforms, worldBounds, inverseTransforms);
+
+        instances.reserve(count);
+        std::vector<AABB> bounds;
+        bounds.reserve(count);
+        uint32_t instanceId = 0;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(count); i++)
+        {
+            if (blasIndices[i] == CpuBvh::INVALID_INDEX)
+                continue;
+
+            CpuMeshInstance instance;
+            instance.objectToWorld = transforms[i];
+            instance.worldToObject = inverseTransforms[i];
+            instance.blasIndex = blasIndices[i];
+            instance.instanceId = instanceId++;
+            instance.sceneIndex = i;
+            instance.materialIndex = scene.GetMeshMaterialIndex(i);
+            instances.push_back(instance);
+            bounds.push_back(worldBounds[i]);
+            hasPagedGeometry |= blases[blasIndices[i]].pagedMesh != CpuBvh::INVALID_INDEX;
+        }
+
+        // Leaf i is instance i whatever its mesh, so any edit that keeps the count
+        // (moves, mesh swaps, rebuilt BLASes) only changes leaf bounds
+        if (!topLevel.Empty() && bounds.size() == instanceBounds.size())
+        {
+            std::vector<uint32_t> changed;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(bounds.size()); i++)
+            {
+                if (memcmp(&bounds[i], &instanceBounds[i], sizeof(AABB)) != 0)
+                    changed.push_back(i);
+            }
+            if (!changed.empty())
+                RefitBvh(topLevel, bounds, changed, nullptr, "top-level");
+        }
+        else
+        {
+            BuildBvh(topLevel, bounds, nullptr);
+        }
+        instanceBounds = std::move(bounds);
+
+        LOG_DEBUGF("[CpuAccelerationStructure] %zu instances over %zu BLASes (%zu unique triangles)",
+            instances.size(), blases.size(), GetUniqueTriangleCount());
+    }
+
+    void CpuAccelerationStructure::UpdateInstanceMaterials(const Scene& scene)
+    {
+        for (CpuMeshInstance& instance : instances)
+            instance.materialIndex = scene.GetMeshMaterialIndex(instance.sceneIndex);
+    }
+
+    void CpuAccelerationStructure::BuildProcedural(const Scene& scene)
+    {
+        // Sphere and box counts, not just their sum: the index ranges must keep their meaning
+        const bool countChanged = scene.GetSpheres().Size() != spheres.size() || scene.GetBoxes().Size() != boxes.size() ||
+            spheres.size() + boxes.size() != proceduralBounds.size();
+        spheres = scene.GetSpheres().geometry;
+        boxes = scene.GetBoxes().geometry;
+        planes = scene.GetPlanes().geometry;
+
+        std::vector<AABB> bounds;
+        bounds.reserve(spheres.size() + boxes.size());
+        for (const SphereGeometry& sphere : spheres)
+            bounds.push_back(CalculateSphereAABB(sphere));
+        for (const BoxGeometry& box : boxes)
+            bounds.push_back(CalculateBoxAABB(box));
+
+        // Find the primitives whose bounds changed since the last update.
+        // A count change reshuffles the indices, so everything starts over as static.
+        const size_t primitiveCount = bounds.size();
+        proceduralUpdateCount++;
+        std::vector<uint32_t> moved;
+        if (countChanged)
+        {
+            lastMovedUpdate.assign(primitiveCount, 0);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(primitiveCount); i++)
+            {
+                if (memcmp(&bounds[i], &proceduralBounds[i], sizeof(AABB)) != 0)
+                {
+                    moved.push_back(i);
+                    lastMovedUpdate[i] = proceduralUpdateCount;
+                }
+            }
+        }
+
+        // Recently moved primitives are dynamic; they return to the static BVH after
+        // DYNAMIC_RETENTION_UPDATES updates without motion
+        std::vector<bool> dynamic(primitiveCount, false);
+        size_t dynamicCount = 0;
+        for (size_t i = 0; i < primitiveCount; i++)
+        {
+            if (lastMovedUpdate[i] != 0 && proceduralUpdateCount - lastMovedUpdate[i] < DYNAMIC_RETENTION_UPDATES)
+            {
+                dynamic[i] = true;
+                dynamicCount++;
+            }
+        }
+        // When most of the scene moves a split buys nothing: refit one BVH over everything
+        if (static_cast<float>(dynamicCount) > static_cast<float>(primitiveCount) * DYNAMIC_FRACTION_LIMIT)
+        {
+            dynamic.assign(primitiveCount, true);
+            dynamicCount = primitiveCount;
+        }
+
+        if (countChanged || dynamic != isDynamic)
+        {
+            isDynamic = dynamic;
+            staticPrimitives.clear();
+            dynamicPrimitives.clear();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(primitiveCount); i++)
+                (dynamic[i] ? dynamicPrimitives : staticPrimitives).push_back(i);
+            BuildBvh(staticProceduralBvh, bounds, &staticPrimitives);
+            BuildBvh(dynamicProceduralBvh, bounds, &dynamicPrimitives);
+            LOG_DEBUGF("[CpuAccelerationStructure] Procedural BVHs: %zu static, %zu dynamic spheres/boxes, %zu unbounded planes",
+                staticPrimitives.size(), dynamicPrimitives.size(), planes.size());
+        }
+        else if (!moved.empty())
+        {
+            // Every moved primitive is dynamic here, so the static BVH is still valid
+            RefitBvh(dynamicProceduralBvh, bounds, moved, &dynamicPrimitives, "dynamic procedural");
+        }
+
+        proceduralBounds = std::move(bounds);
+    }
+
+    void CpuAccelerationStructure::BuildBvh(CpuBvh& bvh, const std::vector<AABB>& bounds, const std::vector<uint32_t>* primitives)
+    {
+        if (primitives)
+            bvh.Build(bounds, *primitives);
+        else
+            bvh.Build(bounds);
+        updateStats.builds++;
+    }
+
+    void CpuAccelerationStructure::RefitBvh(CpuBvh& bvh, const std::vector<AABB>& bounds, const std::vector<uint32_t>& changed,
+        const std::vector<uint32_t>* primitives, const char* name)
+    {
+        // A refit keeps the topology chosen for the old bounds; once traversal is predicted
+        // to have got too much slower, pay for a fresh build instead
+        bvh.Refit(bounds, changed);
+        const float degradation = bvh.GetSahDegradation();
+        if (degradation > REFIT_SAH_THRESHOLD)
+        {
+            LOG_DEBUGF("[CpuAccelerationStructure] SAH cost degraded %.2fx, rebuilding %s BVH", degradation, name);
+            BuildBvh(bvh, bounds, primitives);
+            return;
+        }
+        updateStats.refits++;
+    }
+
+    size_t CpuAccelerationStructure::GetUniqueTriangleCount() const
+    {
+        size_t count = 0;
+        for (const CpuMeshBLAS& blas : blases)
+        {
+            count += blas.pagedMesh != CpuBvh::INVALID_INDEX
+                ? static_cast<size_t>(geometryStreamer.GetMesh(blas.pagedMesh).GetTriangleCount())
+                : blas.indices.size() / 3;
+        }
+        return count;
+    }
+
+    // ============================================
+    // Ray queries
+    // ============================================
+
+    bool CpuAccelerationStructure::IntersectInstance(uint32_t instanceIndex, const float origin[3], const float direction[3],
+        float tMin, float& tMax, CpuRayHit* hit, std::vector<CpuPendingChunk>* pending) const
+    {
+        const CpuMeshInstance& instance = instances[instanceIndex];
+        const TraversalRay ray = MakeObjectRay(instance.worldToObject, origin, direction);
+        const CpuMeshBLAS& blas = blases[instance.blasIndex];
+        XMFLOAT3 objectNormal;
+        bool found = false;
+        if (blas.pagedMesh == CpuBvh::INVALID_INDEX)
+        {
+            found = IntersectTriangles(blas.bvh, blas.positions, blas.indices, nullptr, ray, tMin, tMax, hit, objectNormal);
+        }
+        else
+        {
+            // Chunks in near-to-far order; each has its own BVH once it is in memory
+            TraverseBvh(blas.bvh, ray, tMin, tMax, [&](uint32_t chunkIndex, float& currentMax)
+            {
+                const uint32_t chunk = blas.firstChunk + chunkIndex;
+                float tEntry;
+                if (!IntersectBox(geometryStreamer.GetChunkBounds(chunk), ray, tMin, currentMax, tEntry))
+                    return false;
+
+                const PagedMeshChunk* data = pending ? geometryStreamer.Find(chunk) : geometryStreamer.Load(chunk);
+                if (!data)
+                {
+                    pending->push_back({ instanceIndex, chunk, tEntry });
+                    return false;
+                }
+                if (!IntersectTriangles(data->bvh, data->positions, data->indices, &data->triangleIds,
+                        ray, tMin, currentMax, hit, objectNormal))
+                {
+                    return false;
+                }
+                found = true;
+                return !hit;
+            });
+        }
+
+        if (found && hit)
+            hit->normal = NormalToWorld(instance.worldToObject, objectNormal);
+        return found;
+    }
+
+    bool CpuAccelerationStructure::IntersectProcedural(uint32_t primitive, const float origin[3], const float direction[3],
+        float tMin, float& tMax, CpuRayHit* hit) const
+    {
+        const uint32_t sphereCount = static_cast<uint32_t>(spheres.size());
+        float t;
+        XMFLOAT3 normal;
+        const bool isSphere = primitive < sphereCount;
+        const bool found = isSphere
+            ? IntersectSphere(spheres[primitive], origin, direction, tMin, tMax, t, normal)
+            : IntersectOrientedBox(boxes[primitive - sphereCount], origin, direction, tMin, tMax, t, normal);
+        if (!found)
+            return false;
+
+        tMax = t;
+        if (hit)
+        {
+            hit->t = t;
+            hit->isMesh = false;
+            hit->objectType = isSphere ? ObjectType::Sphere : ObjectType::Box;
+            hit->objectIndex = isSphere ? primitive : primitive - sphereCount;
+            hit->normal = normal;
+        }
+        return true;
+    }
+
+    bool CpuAccelerationStructure::IntersectPlanes(const float origin[3], const float direction[3],
+        float tMin, float& tMax, CpuRayHit* hit) const
+    {
+        bool found = false;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(planes.size()); i++)
+        {
+            float t;
+            XMFLOAT3 normal;
+            if (!IntersectPlane(planes[i], origin, direction, tMin, tMax, t, normal))
+                continue;
+
+            found = true;
+            tMax = t;
+            if (!hit)
+                return true;
+
+            hit->t = t;
+            hit->isMesh = false;
+            hit->objectType = ObjectType::Plane;
+            hit->objectIndex = i;
+            hit->normal = normal;
+        }
+        return found;
+    }
+
+    bool CpuAccelerationStructure::QueryResident(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, CpuRayHit* hit, std::vector<CpuPendingChunk>* pending) const
+    {
+        if (hit)
+            *hit = CpuRayHit();
+        const float o[3] = { origin.x, origin.y, origin.z };
+        const float d[3] = { direction.x, direction.y, direction.z };
+        const TraversalRay ray = MakeTraversalRay(o, d);
+
+        // Planes first: a close floor hit shortens every traversal below
+        bool found = IntersectPlanes(o, d, tMin, tMax, hit);
+        if (found && !hit)
+            return true;
+
+        for (const CpuBvh* bvh : { &staticProceduralBvh, &dynamicProceduralBvh })
+        {
+            TraverseBvh(*bvh, ray, tMin, tMax, [&](uint32_t primitive, float& currentMax)
+            {
+                if (!IntersectProcedural(primitive, o, d, tMin, currentMax, hit))
+                    return false;
+                found = true;
+                return !hit;
+            });
+            if (found && !hit)
+                return true;
+        }
+
+        const size_t firstPending = pending ? pending->size() : 0;
+        TraverseBvh(topLevel, ray, tMin, tMax, [&](uint32_t instanceIndex, float& currentMax)
+        {
+            if (!IntersectInstance(instanceIndex, o, d, tMin, currentMax, hit, pending))
+                return false;
+            found = true;
+            if (!hit)
+                return true;
+            hit->isMesh = true;
+            hit->objectIndex = instanceIndex;
+            return false;
+        });
+
+        if (pending)
+        {
+            // Chunks beyond the closest resident hit cannot change the result, and an
+            // occluded shadow ray needs none of them
+            auto kept = (found && !hit)
+                ? pending->begin() + firstPending
+                : std::remove_if(pending->begin() + firstPending, pending->end(),
+                    [&](const CpuPendingChunk& chunk) { return chunk.tEntry > tMax; });
+            pending->erase(kept, pending->end());
+            for (size_t i = firstPending; i < pending->size(); i++)
+                geometryStreamer.Prefetch((*pending)[i].chunk);
+        }
+        return found;
+    }
+
+    bool CpuAccelerationStructure::QueryPending(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, const CpuPendingChunk& pending, CpuRayHit* hit) const
+    {
+        if (hit && hit->IsHit())
+            tMax = (std::min)(tMax, hit->t);
+        if (pending.tEntry > tMax)
+            return false;
+
+        const float o[3] = { origin.x, origin.y, origin.z };
+        const float d[3] = { direction.x, direction.y, direction.z };
+        const CpuMeshInstance& instance = instances[pending.instance];
+        const TraversalRay ray = MakeObjectRay(instance.worldToObject, o, d);
+        const PagedMeshChunk* data = geometryStreamer.Load(pending.chunk);
+        XMFLOAT3 objectNormal;
+        if (!IntersectTriangles(data->bvh, data->positions, data->indices, &data->triangleIds, ray, tMin, tMax, hit, objectNormal))
+            return false;
+
+        if (hit)
+        {
+            hit->isMesh = true;
+            hit->objectIndex = pending.instance;
+            hit->normal = NormalToWorld(instance.worldToObject, objectNormal);
+        }
+        return true;
+    }
+
+    bool CpuAccelerationStructure::Intersect(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, CpuRayHit& hit) const
+    {
+        return QueryResident(origin, direction, tMin, tMax, &hit, nullptr);
+    }
+
+    bool CpuAccelerationStructure::IsOccluded(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax) const
+    {
+        return QueryResident(origin, direction, tMin, tMax, nullptr, nullptr);
+    }
+
+    bool CpuAccelerationStructure::IntersectResident(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, CpuRayHit& hit, std::vector<CpuPendingChunk>& pending) const
+    {
+        return QueryResident(origin, direction, tMin, tMax, &hit, &pending);
+    }
+
+    bool CpuAccelerationStructure::IsOccludedResident(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, std::vector<CpuPendingChunk>& pending) const
+    {
+        return QueryResident(origin, direction, tMin, tMax, nullptr, &pending);
+    }
+
+    bool CpuAccelerationStructure::IntersectPending(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, const CpuPendingChunk& pending, CpuRayHit& hit) const
+    {
+        return QueryPending(origin, direction, tMin, tMax, pending, &hit);
+    }
+
+    bool CpuAccelerationStructure::IsOccludedPending(const XMFLOAT3& origin, const XMFLOAT3& direction,
+        float tMin, float tMax, const CpuPendingChunk& pending) const
+    {
+        return QueryPending(origin, direction, tMin, tMax, pending, nullptr);
+    }
+}
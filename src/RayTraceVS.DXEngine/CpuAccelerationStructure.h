@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include "CpuBvh.h"
+#include "PagedMesh.h"
+#include "ResidencyManager.h"
+#include "Scene/Objects/Primitives.h"
+
+// ============================================
+// CPU acceleration structure
+// ============================================
+//
+// Two-level structure mirroring the GPU layout: one triangle BLAS per mesh cache,
+// shared by every instance of that mesh, and a top-level BVH over the instances'
+// world bounds. An instance is only a pair of 3x4 transforms and a BLAS index, so
+// N instances of one mesh cost N small records rather than N copies of its triangles.
+// Rays are moved into object space per instance; t stays in world units.
+//
+// Out-of-core meshes (MeshCacheEntry::pagedFile) get a BLAS over their chunk bounds; the
+// chunks themselves are streamed in by a GeometryStreamer when a ray first reaches them.
+// The *Resident queries never wait for that I/O: chunks that are not in memory yet are
+// handed back as CpuPendingChunk records, and the caller finishes the query with
+// *Pending once they have arrived. Intersect and IsOccluded wait for the loads instead.
+//
+// Spheres and boxes get their own BVHs, split like the GPU's procedural BLASes: recently
+// moved primitives sit in a dynamic BVH that is refitted in place, the rest in a static one
+// that is only rebuilt when its membership changes. The top-level BVH is refitted too while
+// the instance count holds. Either is rebuilt once refitting has degraded its SAH cost past
+// REFIT_SAH_THRESHOLD. Planes are unbounded, so instead of a huge AABB that would overlap
+// every node they sit in a short list tested by every ray.
+// Procedural intersection mirrors Intersection.hlsl.
+
+namespace RayTraceVS::DXEngine
+{
+    class Scene;
+    struct MeshCacheEntry;
+    struct MeshTransform;
+    struct MeshInstance;
+
+    // Row-major 3x4 affine transform, column 3 is the translation
+    // (same layout as D3D12_RAYTRACING_INSTANCE_DESC::Transform)
+    struct Transform3x4
+    {
+        float m[3][4];
+    };
+
+    // Object-to-world transform of a mesh instance (scale, then rotation, then translation)
+    Transform3x4 GetInstanceTransform(const MeshTransform& transform);
+    Transform3x4 InverseTransform(const Transform3x4& transform);
+    // Tight bounds of the transformed box
+    AABB TransformAABB(const AABB& box, const Transform3x4& transform);
+    // GetInstanceTransform and TransformAABB (and InverseTransform, if worldToObject is not
+    // empty) for every instance at once (objectBounds[i] is the object-space bounds of
+    // instance i's mesh): DirectXMath vector math, split across the shared WorkerPool for
+    // large instance counts. Results match the per-instance functions.
+    void ComputeInstanceTransforms(std::span<const MeshInstance> instances, std::span<const AABB> objectBounds,
+        std::span<Transform3x4> objectToWorld, std::span<AABB> worldBounds, std::span<Transform3x4> worldToObject = {});
+
+    // World bounds of procedural primitives (shared by the GPU BLAS and the CPU BVH)
+    AABB CalculateSphereAABB(const SphereGeometry& sphere);
+    // Exact bounds of the oriented box (axes are normalized first)
+    AABB CalculateBoxAABB(const BoxGeometry& box);
+    // Planes are infinite; this is the finite slab the GPU BLAS uses for them:
+    // PLANE_BOUNDS_EXTENT along the plane, PLANE_BOUNDS_THICKNESS across it
+    AABB CalculatePlaneAABB(const PlaneGeometry& plane);
+    constexpr float PLANE_BOUNDS_EXTENT = 1000.0f;
+    constexpr float PLANE_BOUNDS_THICKNESS = 0.01f;
+
+    // Triangle BLAS of one unique mesh geometry
+    struct CpuMeshBLAS
+    {
+        std::string meshKey;                        // Scene content key (shared by all aliases)
+        std::vector<DirectX::XMFLOAT3> positions;   // De-interleaved from MeshCacheEntry::vertices
+        std::vector<uint32_t> indices;
+        CpuBvh bvh;                                 // Over triangle bounds (primitive = triangle index)
+        AABB bounds;                                // Object space
+        // Paged geometry: positions/indices stay empty and bvh is over the chunk bounds
+        uint32_t pagedMesh = CpuBvh::INVALID_INDEX; // GeometryStreamer mesh
+        uint32_t firstChunk = 0;                    // GeometryStreamer chunk id of chunk 0
+    };
+
+    struct CpuMeshInstance
+    {
+        Transform3x4 objectToWorld;
+        Transform3x4 worldToObject;
+        uint32_t blasIndex;
+        uint32_t instanceId;        // InstanceID() of the GPU instance (index into MeshInstances)
+        uint32_t sceneIndex;        // Index into Scene::GetMeshInstances()
+        uint32_t materialIndex;     // Index into Scene::GetMeshMaterials() (the GPU MaterialIndex)
+    };
+
+    struct CpuRayHit
+    {
+        float t = std::numeric_limits<float>::infinity();
+        bool isMesh = false;
+        ObjectType objectType = ObjectType::Sphere;         // Procedural hits only
+        uint32_t objectIndex = CpuBvh::INVALID_INDEX;       // Mesh: index into GetInstances(); else index into the type's pool
+        uint32_t primitiveIndex = CpuBvh::INVALID_INDEX;    // Mesh: triangle index within the BLAS
+        float barycentrics[2] = { 0.0f, 0.0f };             // Mesh: weights of vertices 1 and 2
+        DirectX::XMFLOAT3 normal = { 0.0f, 0.0f, 0.0f };    // World space, normalized (geometric for meshes)
+
+        bool IsHit() const { return objectIndex != CpuBvh::INVALID_INDEX; }
+    };
+
+    // A chunk of paged geometry a query reached but could not test because it was not resident
+    struct CpuPendingChunk
+    {
+        uint32_t instance;          // Index into GetInstances()
+        uint32_t chunk;             // GeometryStreamer chunk id
+        float tEntry;               // Where the ray enters the chunk bounds
+    };
+
+    // BVHs updated by the Build* calls since the last ResetUpdateStats
+    struct CpuBvhUpdateStats
+    {
+        uint32_t builds = 0;        // Built from scratch
+        uint32_t refits = 0;        // Refitted in place
+    };
+
+    class CpuAccelerationStructure
+    {
+    public:
+        // One BLAS per unique mesh geometry (call when SceneChange_MeshCaches is reported).
+        // BLASes of geometry that left the scene stay cached within the residency budget,
+        // so they are reused rather than rebuilt when the geometry comes back.
+        void BuildMeshBLASes(const Scene& scene);
+        // Instance records and the top-level BVH (update on SceneChange_MeshInstances);
+        // instances whose mesh has no BLAS are skipped, as on the GPU. The BVH is refitted
+        // when the instance count is unchanged.
+        void BuildInstances(const Scene& scene);
+        // Re-reads the instances' material indices (SceneChange_MeshMaterials alone)
+        void UpdateInstanceMaterials(const Scene& scene);
+        // Sphere/box BVHs and the plane list (update on SceneChange_Geometry). With unchanged
+        // sphere and box counts only the dynamic BVH is refitted, unless motion moved
+        // primitives between the partitions.
+        void BuildProcedural(const Scene& scene);
+        void Clear();
+
+        // Closest hit in [tMin, tMax]; triangles are double-sided (culling is disabled on the GPU too)
+        bool Intersect(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, CpuRayHit& hit) const;
+        // Any hit in [tMin, tMax] (shadow rays)
+        bool IsOccluded(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax) const;
+
+        // Same queries over the resident geometry only. Chunks the ray would still have to
+        // test are prefetched (queued while they fit in the streaming budget) and appended to pending (nothing is appended when the
+        // resident result already decides the query); the result is final once every
+        // pending chunk has been passed to the matching *Pending call.
+        bool IntersectResident(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, CpuRayHit& hit, std::vector<CpuPendingChunk>& pending) const;
+        bool IsOccludedResident(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, std::vector<CpuPendingChunk>& pending) const;
+        // Tests one pending chunk (waiting for it if it is still loading); hit is replaced if closer
+        bool IntersectPending(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, const CpuPendingChunk& pending, CpuRayHit& hit) const;
+        bool IsOccludedPending(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, const CpuPendingChunk& pending) const;
+
+        const std::vector<CpuMeshBLAS>& GetBLASes() const { return blases; }
+        const std::vector<CpuMeshInstance>& GetInstances() const { return instances; }
+        const CpuBvh& GetTopLevelBvh() const { return topLevel; }
+        const CpuBvh& GetStaticProceduralBvh() const { return staticProceduralBvh; }
+        const CpuBvh& GetDynamicProceduralBvh() const { return dynamicProceduralBvh; }
+        const CpuBvhUpdateStats& GetUpdateStats() const { return updateStats; }
+        void ResetUpdateStats() { updateStats = {}; }
+        size_t GetUnboundedPrimitiveCount() const { return planes.size(); }
+        // Triangles stored once per mesh, regardless of the instance count
+        size_t GetUniqueTriangleCount() const;
+
+        // Applied at the next BuildMeshBLASes
+        void SetMeshResidencyBudget(uint64_t budgetBytes) { meshResidency.SetBudget(budgetBytes); }
+        const ResidencyStats& GetMeshResidencyStats() const { return meshResidency.GetStats(); }
+
+        // Some instance references paged geometry (the *Resident queries can defer)
+        bool HasPagedGeometry() const { return hasPagedGeometry; }
+        GeometryStreamer& GetGeometryStreamer() { return geometryStreamer; }
+        // Byte budget of resident chunks, applied at the next GeometryStreamer::EndPass
+        void SetGeometryStreamingBudget(uint64_t budgetBytes) { geometryStreamer.SetBudget(budgetBytes); }
+        GeometryStreamingStats GetGeometryStreamingStats() const { return geometryStreamer.GetStats(); }
+
+    private:
+        // pending == nullptr waits for non-resident chunks
+        bool IntersectInstance(uint32_t instanceIndex, const float origin[3], const float direction[3],
+            float tMin, float& tMax, CpuRayHit* hit, std::vector<CpuPendingChunk>* pending) const;
+        bool QueryResident(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, CpuRayHit* hit, std::vector<CpuPendingChunk>* pending) const;
+        bool QueryPending(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+            float tMin, float tMax, const CpuPendingChunk& pending, CpuRayHit* hit) const;
+        // Spheres and boxes: index < spheres.size() is a sphere, the rest are boxes
+        bool IntersectProcedural(uint32_t primitive, const float origin[3], const float direction[3],
+            float tMin, float& tMax, CpuRayHit* hit) const;
+        bool IntersectPlanes(const float origin[3], const float direction[3],
+            float tMin, float& tMax, CpuRayHit* hit) const;
+        // Refits bvh for the changed primitives, rebuilding over primitives (all when empty)
+        // if that degraded the SAH cost past REFIT_SAH_THRESHOLD
+        void RefitBvh(CpuBvh& bvh, const std::vector<AABB>& bounds, const std::vector<uint32_t>& changed,
+            const std::vector<uint32_t>* primitives, const char* name);
+        void BuildBvh(CpuBvh& bvh, const std::vector<AABB>& bounds, const std::vector<uint32_t>* primitives);
+
+        std::vector<CpuMeshBLAS> blases;
+        std::unordered_map<std::string, CpuMeshBLAS> cachedBlases;   // Not in the scene, by key
+        ResidencyManager meshResidency;
+        std::vector<CpuMeshInstance> instances;
+        CpuBvh topLevel;                            // Over instance world bounds
+        std::vector<AABB> instanceBounds;           // World bounds the top level was last updated with
+        mutable GeometryStreamer geometryStreamer;  // Loads chunks on behalf of the const queries
+        bool hasPagedGeometry = false;
+
+        std::vector<SphereGeometry> spheres;
+        std::vector<BoxGeometry> boxes;
+        std::vector<PlaneGeometry> planes;          // Always tested, outside any hierarchy
+        CpuBvh staticProceduralBvh;                 // Over sphere and box bounds (primitive = sphere, then box index)
+        CpuBvh dynamicProceduralBvh;
+        std::vector<uint32_t> staticPrimitives;
+        std::vector<uint32_t> dynamicPrimitives;
+
+        // Motion tracking for the static/dynamic split (same policy as AccelerationStructure)
+        static constexpr uint32_t DYNAMIC_RETENTION_UPDATES = 30;  // Updates without motion before demotion to static
+        static constexpr float DYNAMIC_FRACTION_LIMIT = 0.5f;      // Above this, everything is dynamic
+        static constexpr float REFIT_SAH_THRESHOLD = 1.5f;         // SAH degradation that forces a full build
+        std::vector<AABB> proceduralBounds;         // Bounds of the last update
+        std::vector<uint64_t> lastMovedUpdate;      // Update number of the last motion, 0 = never
+        std::vector<bool> isDynamic;
+        uint64_t proceduralUpdateCount = 0;
+        CpuBvhUpdateStats updateStats;
+    };
+}
@@ -0,0 +1,773 @@
+#include "CpuBvh.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        // SAH constants: cost of one traversal step relative to one primitive test
+        constexpr float TRAVERSAL_COST = 1.0f;
+        constexpr float INTERSECTION_COST = 1.0f;
+
+        float AxisMin(const AABB& box, int axis)
+        {
+            return axis == 0 ? box.MinX : (axis == 1 ? box.MinY : box.MinZ);
+        }
+
+        float AxisMax(const AABB& box, int axis)
+        {
+            return axis == 0 ? box.MaxX : (axis == 1 ? box.MaxY : box.MaxZ);
+        }
+
+        float Centroid(const AABB& box, int axis)
+        {
+            return 0.5f * (AxisMin(box, axis) + AxisMax(box, axis));
+        }
+
+        struct SahBin
+        {
+            AABB bounds = EmptyAABB();
+            uint32_t count = 0;
+        };
+
+        // Best binned-SAH object split of a primitive range
+        struct ObjectSplit
+        {
+            int axis = -1;              // -1: every centroid coincides
+            uint32_t bin = 0;           // Bins [0, bin] go left
+            float cost = std::numeric_limits<float>::max();    // Sum of child area * count
+            AABB leftBounds = EmptyAABB();
+            AABB rightBounds = EmptyAABB();
+            float axisMin = 0.0f;
+            float scale = 0.0f;
+        };
+
+        uint32_t ObjectBin(const ObjectSplit& split, const AABB& box)
+        {
+            return (std::min)(CpuBvh::SAH_BIN_COUNT - 1,
+                static_cast<uint32_t>((Centroid(box, split.axis) - split.axisMin) * split.scale));
+        }
+
+        // boundsAt(i) returns the box of the i-th of count primitives
+        template<typename BoundsAt>
+        ObjectSplit FindObjectSplit(uint32_t count, BoundsAt&& boundsAt)
+        {
+            constexpr uint32_t BIN_COUNT = CpuBvh::SAH_BIN_COUNT;
+
+            AABB centroidBounds = EmptyAABB();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const AABB& box = boundsAt(i);
+                AABB centroid = { Centroid(box, 0), Centroid(box, 1), Centroid(box, 2),
+                                  Centroid(box, 0), Centroid(box, 1), Centroid(box, 2) };
+                ExpandAABB(centroidBounds, centroid);
+            }
+
+            // Binned SAH: evaluate BIN_COUNT - 1 candidate planes per axis
+            ObjectSplit best;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float axisMin = AxisMin(centroidBounds, axis);
+                const float extent = AxisMax(centroidBounds, axis) - axisMin;
+                if (!(extent > 0.0f))
+                    continue;
+
+                ObjectSplit candidate;
+                candidate.axis = axis;
+                candidate.axisMin = axisMin;
+                candidate.scale = static_cast<float>(BIN_COUNT) / extent;
+
+                SahBin bins[BIN_COUNT];
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const AABB& box = boundsAt(i);
+                    uint32_t bin = ObjectBin(candidate, box);
+                    bins[bin].count++;
+                    ExpandAABB(bins[bin].bounds, box);
+                }
+
+                // Sweep from the right, then evaluate each plane while sweeping from the left
+                AABB rightBounds[BIN_COUNT];
+                uint32_t rightCount[BIN_COUNT] = {};
+                AABB accumulated = EmptyAABB();
+                uint32_t accumulatedCount = 0;
+                for (uint32_t i = BIN_COUNT - 1; i > 0; i--)
+                {
+                    ExpandAABB(accumulated, bins[i].bounds);
+                    accumulatedCount += bins[i].count;
+                    rightBounds[i] = accumulated;
+                    rightCount[i] = accumulatedCount;
+                }
+
+                accumulated = EmptyAABB();
+                accumulatedCount = 0;
+                for (uint32_t i = 0; i < BIN_COUNT - 1; i++)
+                {
+                    ExpandAABB(accumulated, bins[i].bounds);
+                    accumulatedCount += bins[i].count;
+                    if (accumulatedCount == 0 || rightCount[i + 1] == 0)
+                        continue;
+
+                    float cost = SurfaceArea(accumulated) * accumulatedCount + SurfaceArea(rightBounds[i + 1]) * rightCount[i + 1];
+                    if (cost < best.cost)
+                    {
+                        best = candidate;
+                        best.bin = i;
+                        best.cost = cost;
+                        best.leftBounds = accumulated;
+                        best.rightBounds = rightBounds[i + 1];
+                    }
+                }
+            }
+            return best;
+        }
+
+        // ============================================
+        // Spatial split helpers
+        // ============================================
+
+        constexpr uint32_t SPATIAL_BIN_COUNT = 16;
+
+        // A primitive as seen by one node: after spatial splits only a clipped part of it
+        struct BvhReference
+        {
+            AABB bounds;
+            uint32_t primitive;
+        };
+
+        struct SpatialSplit
+        {
+            int axis = -1;
+            uint32_t bin = 0;           // The plane is the upper side of this bin
+            float cost = std::numeric_limits<float>::max();
+            float axisMin = 0.0f;
+            float binWidth = 0.0f;
+        };
+
+        AABB IntersectAABB(const AABB& a, const AABB& b)
+        {
+            AABB result = {
+                (std::max)(a.MinX, b.MinX), (std::max)(a.MinY, b.MinY), (std::max)(a.MinZ, b.MinZ),
+                (std::min)(a.MaxX, b.MaxX), (std::min)(a.MaxY, b.MaxY), (std::min)(a.MaxZ, b.MaxZ) };
+            if (result.MinX > result.MaxX || result.MinY > result.MaxY || result.MinZ > result.MaxZ)
+                return EmptyAABB();
+            return result;
+        }
+
+        // Bounds of the part of a reference's triangle inside lower <= x[axis] <= upper
+        AABB ClipReference(const BvhReference& reference, const std::vector<float>& triangleVertices,
+            int axis, float lower, float upper)
+        {
+            const float* v = &triangleVertices[static_cast<size_t>(reference.primitive) * 9];
+            AABB clipped = EmptyAABB();
+            auto addPoint = [&](const float p[3])
+            {
+                ExpandAABB(clipped, { p[0], p[1], p[2], p[0], p[1], p[2] });
+            };
+
+            for (int edge = 0; edge < 3; edge++)
+            {
+                const float* a = v + edge * 3;
+                const float* b = v + ((edge + 1) % 3) * 3;
+                if (a[axis] >= lower && a[axis] <= upper)
+                    addPoint(a);
+
+                for (float plane : { lower, upper })
+                {
+                    if ((a[axis] < plane && b[axis] > plane) || (a[axis] > plane && b[axis] < plane))
+                    {
+                        const float t = (plane - a[axis]) / (b[axis] - a[axis]);
+                        float p[3] = { a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, a[2] + (b[2] - a[2]) * t };
+                        p[axis] = plane;
+                        addPoint(p);
+                    }
+                }
+            }
+
+            // Earlier clips already narrowed the reference
+            return IntersectAABB(clipped, reference.bounds);
+        }
+
+        uint32_t SpatialBin(const SpatialSplit& split, float position)
+        {
+            const float bin = (position - split.axisMin) / split.binWidth;
+            if (!(bin > 0.0f))
+                return 0;
+            return (std::min)(SPATIAL_BIN_COUNT - 1, static_cast<uint32_t>(bin));
+        }
+
+        SpatialSplit FindSpatialSplit(const std::vector<BvhReference>& references, const AABB& nodeBounds,
+            const std::vector<float>& triangleVertices)
+        {
+            SpatialSplit best;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                SpatialSplit candidate;
+                candidate.axis = axis;
+                candidate.axisMin = AxisMin(nodeBounds, axis);
+                const float extent = AxisMax(nodeBounds, axis) - candidate.axisMin;
+                if (!(extent > 0.0f))
+                    continue;
+                candidate.binWidth = extent / static_cast<float>(SPATIAL_BIN_COUNT);
+
+                // Each reference is clipped into every bin it spans; entries/exits count
+                // where it starts and ends
+                AABB bins[SPATIAL_BIN_COUNT];
+                uint32_t entries[SPATIAL_BIN_COUNT] = {};
+                uint32_t exits[SPATIAL_BIN_COUNT] = {};
+                for (uint32_t i = 0; i < SPATIAL_BIN_COUNT; i++)
+                    bins[i] = EmptyAABB();
+
+                for (const BvhReference& reference : references)
+                {
+                    const uint32_t first = SpatialBin(candidate, AxisMin(reference.bounds, axis));
+                    const uint32_t last = SpatialBin(candidate, AxisMax(reference.bounds, axis));
+                    entries[first]++;
+                    exits[last]++;
+                    if (first == last)
+                    {
+                        ExpandAABB(bins[first], reference.bounds);
+                        continue;
+                    }
+                    for (uint32_t bin = first; bin <= last; bin++)
+                    {
+                        const float lower = candidate.axisMin + candidate.binWidth * bin;
+                        const float upper = (bin == SPATIAL_BIN_COUNT - 1)
+                            ? AxisMax(nodeBounds, axis) : lower + candidate.binWidth;
+                        ExpandAABB(bins[bin], ClipReference(reference, triangleVertices, axis, lower, upper));
+                    }
+                }
+
+                float rightArea[SPATIAL_BIN_COUNT] = {};
+                uint32_t rightCount[SPATIAL_BIN_COUNT] = {};
+                AABB accumulated = EmptyAABB();
+                uint32_t accumulatedCount = 0;
+                for (uint32_t i = SPATIAL_BIN_COUNT - 1; i > 0; i--)
+                {
+                    ExpandAABB(accumulated, bins[i]);
+                    accumulatedCount += exits[i];
+                    rightArea[i] = SurfaceArea(accumulated);
+                    rightCount[i] = accumulatedCount;
+                }
+
+                accumulated = EmptyAABB();
+                accumulatedCount = 0;
+                for (uint32_t i = 0; i < SPATIAL_BIN_COUNT - 1; i++)
+                {
+                    ExpandAABB(accumulated, bins[i]);
+                    accumulatedCount += entries[i];
+                    if (accumulatedCount == 0 || rightCount[i + 1] == 0)
+                        continue;
+
+                    float cost = SurfaceArea(accumulated) * accumulatedCount + rightArea[i + 1] * rightCount[i + 1];
+                    if (cost < best.cost)
+                    {
+                        best = candidate;
+                        best.bin = i;
+                        best.cost = cost;
+                    }
+                }
+            }
+            return best;
+        }
+    }
+
+    AABB EmptyAABB()
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        return { inf, inf, inf, -inf, -inf, -inf };
+    }
+
+    void ExpandAABB(AABB& target, const AABB& other)
+    {
+        target.MinX = (std::min)(target.MinX, other.MinX);
+        target.MinY = (std::min)(target.MinY, other.MinY);
+        target.MinZ = (std::min)(target.MinZ, other.MinZ);
+        target.MaxX = (std::max)(target.MaxX, other.MaxX);
+        target.MaxY = (std::max)(target.MaxY, other.MaxY);
+        target.MaxZ = (std::max)(target.MaxZ, other.MaxZ);
+    }
+
+    float SurfaceArea(const AABB& box)
+    {
+        const float dx = box.MaxX - box.MinX;
+        const float dy = box.MaxY - box.MinY;
+        const float dz = box.MaxZ - box.MinZ;
+        if (!(dx >= 0.0f && dy >= 0.0f && dz >= 0.0f))
+            return 0.0f;
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    // ============================================
+    // Build
+    // ============================================
+
+    void CpuBvh::Clear()
+    {
+        nodes.clear();
+        primitiveOrder.clear();
+        leafOfPrimitive.clear();
+        builtSahCost = 0.0f;
+        spatialSplits = false;
+    }
+
+    void CpuBvh::Build(const std::vector<AABB>& bounds)
+    {
+        std::vector<uint32_t> primitives(bounds.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(primitives.size()); i++)
+            primitives[i] = i;
+        Build(bounds, primitives);
+    }
+
+    void CpuBvh::Build(const std::vector<AABB>& bounds, const std::vector<uint32_t>& primitives)
+    {
+        Clear();
+        if (primitives.empty())
+            return;
+
+        primitiveOrder = primitives;
+        leafOfPrimitive.assign(bounds.size(), INVALID_INDEX);
+        // A binary tree with at least one primitive per leaf has fewer than 2N nodes
+        nodes.reserve(primitives.size() * 2);
+
+        BvhNode root = {};
+        root.firstOrLeft = 0;
+        root.count = static_cast<uint32_t>(primitives.size());
+        root.parent = INVALID_INDEX;
+        root.bounds = ComputeLeafBounds(root, bounds);
+        nodes.push_back(root);
+
+        std::vector<uint32_t> stack = { 0 };
+        while (!stack.empty())
+        {
+            uint32_t nodeIndex = stack.back();
+            stack.pop_back();
+            if (Split(nodeIndex, bounds))
+            {
+                stack.push_back(nodes[nodeIndex].firstOrLeft);
+                stack.push_back(nodes[nodeIndex].firstOrLeft + 1);
+            }
+        }
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(nodes.size()); i++)
+        {
+            const BvhNode& node = nodes[i];
+            for (uint32_t slot = node.firstOrLeft; node.count > 0 && slot < node.firstOrLeft + node.count; slot++)
+            {
+                leafOfPrimitive[primitiveOrder[slot]] = i;
+            }
+        }
+
+        builtSahCost = ComputeSahCost();
+    }
+
+    bool CpuBvh::Split(uint32_t nodeIndex, const std::vector<AABB>& bounds)
+    {
+        const uint32_t first = nodes[nodeIndex].firstOrLeft;
+        const uint32_t count = nodes[nodeIndex].count;
+        if (count <= 1)
+            return false;
+
+        const ObjectSplit split = FindObjectSplit(count, [&](uint32_t i) -> const AABB&
+        {
+            return bounds[primitiveOrder[first + i]];
+        });
+
+        const float nodeArea = SurfaceArea(nodes[nodeIndex].bounds);
+        uint32_t middle = first + count / 2;
+        if (split.axis < 0)
+        {
+            // Every centroid coincides: split by count once the leaf gets too large
+            if (count <= MAX_LEAF_SIZE)
+                return false;
+        }
+        else
+        {
+            const float splitCost = TRAVERSAL_COST * nodeArea + INTERSECTION_COST * split.cost;
+            const float leafCost = INTERSECTION_COST * nodeArea * count;
+            if (count <= MAX_LEAF_SIZE && splitCost >= leafCost)
+                return false;
+
+            auto begin = primitiveOrder.begin() + first;
+            auto end = std::partition(begin, begin + count, [&](uint32_t primitive)
+            {
+                return ObjectBin(split, bounds[primitive]) <= split.bin;
+            });
+            uint32_t partitioned = first + static_cast<uint32_t>(end - begin);
+            if (partitioned > first && partitioned < first + count)
+                middle = partitioned;
+        }
+
+        const uint32_t left = static_cast<uint32_t>(nodes.size());
+        BvhNode leftNode = {};
+        leftNode.firstOrLeft = first;
+        leftNode.count = middle - first;
+        leftNode.parent = nodeIndex;
+        leftNode.bounds = ComputeLeafBounds(leftNode, bounds);
+
+        BvhNode rightNode = {};
+        rightNode.firstOrLeft = middle;
+        rightNode.count = first + count - middle;
+        rightNode.parent = nodeIndex;
+        rightNode.bounds = ComputeLeafBounds(rightNode, bounds);
+
+        nodes.push_back(leftNode);
+        nodes.push_back(rightNode);
+        nodes[nodeIndex].firstOrLeft = left;
+        nodes[nodeIndex].count = 0;
+        return true;
+    }
+
+    // ============================================
+    // Spatial split build
+    // ============================================
+
+    void CpuBvh::BuildSpatial(const std::vector<AABB>& bounds, const std::vector<float>& triangleVertices,
+        const BvhSpatialSplitSettings& settings)
+    {
+        Clear();
+        if (bounds.empty() || triangleVertices.size() < bounds.size() * 9)
+            return;
+
+        spatialSplits = true;
+        leafOfPrimitive.assign(bounds.size(), INVALID_INDEX);
+        const size_t referenceBudget = bounds.size() +
+            static_cast<size_t>(static_cast<float>(bounds.size()) * (std::max)(settings.maxReferenceGrowth, 0.0f));
+        size_t referenceCount = bounds.size();
+        nodes.reserve(bounds.size() * 2);
+        primitiveOrder.reserve(referenceBudget);
+
+        struct WorkItem
+        {
+            uint32_t node;
+            std::vector<BvhReference> references;
+        };
+
+        WorkItem rootItem;
+        rootItem.node = 0;
+        rootItem.references.reserve(bounds.size());
+        BvhNode root = {};
+        root.parent = INVALID_INDEX;
+        root.bounds = EmptyAABB();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(bounds.size()); i++)
+        {
+            rootItem.references.push_back({ bounds[i], i });
+            ExpandAABB(root.bounds, bounds[i]);
+        }
+        nodes.push_back(root);
+        const float rootArea = SurfaceArea(root.bounds);
+
+        // Breadth-first, so the reference budget goes to the upper levels of every subtree
+        // instead of being used up by the first one
+        std::deque<WorkItem> queue;
+        queue.push_back(std::move(rootItem));
+        while (!queue.empty())
+        {
+            WorkItem item = std::move(queue.front());
+            queue.pop_front();
+            std::vector<BvhReference>& references = item.references;
+            const uint32_t count = static_cast<uint32_t>(references.size());
+            const AABB nodeBounds = nodes[item.node].bounds;
+            const float nodeArea = SurfaceArea(nodeBounds);
+
+            std::vector<BvhReference> left, right;
+            AABB leftBounds = EmptyAABB(), rightBounds = EmptyAABB();
+            if (count > 1)
+            {
+                const ObjectSplit objectSplit = FindObjectSplit(count, [&](uint32_t i) -> const AABB&
+                {
+                    return references[i].bounds;
+                });
+                float bestCost = objectSplit.cost;
+
+                // Spatial splits only pay off where the object split leaves the children overlapping
+                SpatialSplit spatialSplit;
+                if (objectSplit.axis >= 0 && referenceCount < referenceBudget && rootArea > 0.0f &&
+                    SurfaceArea(IntersectAABB(objectSplit.leftBounds, objectSplit.rightBounds)) > settings.minOverlapRatio * rootArea)
+                {
+                    spatialSplit = FindSpatialSplit(references, nodeBounds, triangleVertices);
+                }
+
+                const bool canSplit = objectSplit.axis >= 0 || spatialSplit.axis >= 0;
+                bestCost = (std::min)(bestCost, spatialSplit.cost);
+                const float splitCost = TRAVERSAL_COST * nodeArea + INTERSECTION_COST * bestCost;
+                const float leafCost = INTERSECTION_COST * nodeArea * count;
+                const bool makeLeaf = count <= MAX_LEAF_SIZE && (!canSplit || splitCost >= leafCost);
+
+                if (!makeLeaf && spatialSplit.axis >= 0 && spatialSplit.cost < objectSplit.cost)
+                {
+                    const int axis = spatialSplit.axis;
+                    const float plane = spatialSplit.axisMin + spatialSplit.binWidth * (spatialSplit.bin + 1);
+                    std::vector<BvhReference> straddling;
+                    for (const BvhReference& reference : references)
+                    {
+                        const uint32_t first = SpatialBin(spatialSplit, AxisMin(reference.bounds, axis));
+                        const uint32_t last = SpatialBin(spatialSplit, AxisMax(reference.bounds, axis));
+                        if (last <= spatialSplit.bin)
+                        {
+                            left.push_back(reference);
+                            ExpandAABB(leftBounds, reference.bounds);
+                        }
+                        else if (first > spatialSplit.bin)
+                        {
+                            right.push_back(reference);
+                            ExpandAABB(rightBounds, reference.bounds);
+                        }
+                        else
+                        {
+                            straddling.push_back(reference);
+                        }
+                    }
+
+                    // Reference unsplitting: keep a straddler whole on one side when that is cheaper
+                    float leftCount = static_cast<float>(left.size() + straddling.size());
+                    float rightCount = static_cast<float>(right.size() + straddling.size());
+                    size_t duplicates = 0;
+                    for (const BvhReference& reference : straddling)
+                    {
+                        BvhReference leftPart = { ClipReference(reference, triangleVertices, axis, AxisMin(reference.bounds, axis), plane), reference.primitive };
+                        BvhReference rightPart = { ClipReference(reference, triangleVertices, axis, plane, AxisMax(reference.bounds, axis)), reference.primitive };
+                        AABB splitLeft = leftBounds, splitRight = rightBounds;
+                        ExpandAABB(splitLeft, leftPart.bounds);
+                        ExpandAABB(splitRight, rightPart.bounds);
+                        AABB wholeLeft = leftBounds, wholeRight = rightBounds;
+                        ExpandAABB(wholeLeft, reference.bounds);
+                        ExpandAABB(wholeRight, reference.bounds);
+
+                        // A part clipped away by rounding means the triangle only touches the plane
+                        const bool degenerate = leftPart.bounds.MinX > leftPart.bounds.MaxX ||
+                                                rightPart.bounds.MinX > rightPart.bounds.MaxX;
+                        const float costSplit = degenerate ? std::numeric_limits<float>::max()
+                            : SurfaceArea(splitLeft) * leftCount + SurfaceArea(splitRight) * rightCount;
+                        const float costLeft = SurfaceArea(wholeLeft) * leftCount + SurfaceArea(rightBounds) * (rightCount - 1.0f);
+                        const float costRight = SurfaceArea(leftBounds) * (leftCount - 1.0f) + SurfaceArea(wholeRight) * rightCount;
+                        if (costSplit < costLeft && costSplit < costRight)
+                        {
+                            left.push_back(leftPart);
+                            right.push_back(rightPart);
+                            leftBounds = splitLeft;
+                            rightBounds = splitRight;
+                            duplicates++;
+                        }
+                        else if (costLeft <= costRight)
+                        {
+                            left.push_back(reference);
+                            leftBounds = wholeLeft;
+                            rightCount -= 1.0f;
+                        }
+                        else
+                        {
+                            right.push_back(reference);
+                            rightBounds = wholeRight;
+                            leftCount -= 1.0f;
+                        }
+                    }
+
+                    // Over budget or everything on one side: fall back to the object split.
+                    // Children may both hold every reference; their clipped bounds are still
+                    // smaller, and the budget bounds the recursion.
+                    if (referenceCount + duplicates > referenceBudget || left.empty() || right.empty())
+                    {
+                        left.clear();
+                        right.clear();
+                        leftBounds = EmptyAABB();
+                        rightBounds = EmptyAABB();
+                    }
+                    else
+                    {
+                        referenceCount += duplicates;
+                    }
+                }
+
+                if (!makeLeaf && left.empty())
+                {
+                    if (objectSplit.axis >= 0)
+                    {
+                        for (const BvhReference& reference : references)
+                        {
+                            const bool toLeft = ObjectBin(objectSplit, reference.bounds) <= objectSplit.bin;
+                            (toLeft ? left : right).push_back(reference);
+                            ExpandAABB(toLeft ? leftBounds : rightBounds, reference.bounds);
+                        }
+                    }
+                    if (left.empty() || right.empty())
+                    {
+                        // Every centroid coincides: split by count once the leaf gets too large
+                        left.clear();
+                        right.clear();
+                        leftBounds = EmptyAABB();
+                        rightBounds = EmptyAABB();
+                        if (count > MAX_LEAF_SIZE)
+                        {
+                            for (uint32_t i = 0; i < count; i++)
+                            {
+                                (i < count / 2 ? left : right).push_back(references[i]);
+                                ExpandAABB(i < count / 2 ? leftBounds : rightBounds, references[i].bounds);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (left.empty())
+            {
+                BvhNode& leaf = nodes[item.node];
+                leaf.firstOrLeft = static_cast<uint32_t>(primitiveOrder.size());
+                leaf.count = count;
+                for (const BvhReference& reference : references)
+                {
+                    primitiveOrder.push_back(reference.primitive);
+                    leafOfPrimitive[reference.primitive] = item.node;
+                }
+                continue;
+            }
+
+            const uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+            BvhNode leftNode = {};
+            leftNode.parent = item.node;
+            leftNode.bounds = leftBounds;
+            BvhNode rightNode = leftNode;
+            rightNode.bounds = rightBounds;
+            nodes.push_back(leftNode);
+            nodes.push_back(rightNode);
+            nodes[item.node].firstOrLeft = leftIndex;
+            nodes[item.node].count = 0;
+
+            references.clear();
+            references.shrink_to_fit();
+            queue.push_back({ leftIndex, std::move(left) });
+            queue.push_back({ leftIndex + 1, std::move(right) });
+        }
+
+        builtSahCost = ComputeSahCost();
+    }
+
+    bool CpuBvh::Assign(std::vector<BvhNode> prebuiltNodes, std::vector<uint32_t> prebuiltOrder,
+        uint32_t primitiveCount, bool prebuiltSpatialSplits)
+    {
+        Clear();
+        const uint32_t nodeCount = static_cast<uint32_t>(prebuiltNodes.size());
+        const uint32_t referenceCount = static_cast<uint32_t>(prebuiltOrder.size());
+        for (uint32_t primitive : prebuiltOrder)
+        {
+            if (primitive >= primitiveCount)
+                return false;
+        }
+
+        // Children always follow their parent, which also rules out cycles
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            const BvhNode& node = prebuiltNodes[i];
+            const bool valid = node.count > 0
+                ? node.firstOrLeft <= referenceCount && node.count <= referenceCount - node.firstOrLeft
+                : node.firstOrLeft > i && node.firstOrLeft < nodeCount - 1;
+            if (!valid)
+                return false;
+        }
+
+        nodes = std::move(prebuiltNodes);
+        primitiveOrder = std::move(prebuiltOrder);
+        spatialSplits = prebuiltSpatialSplits;
+        leafOfPrimitive.assign(primitiveCount, INVALID_INDEX);
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            const BvhNode& node = nodes[i];
+            for (uint32_t slot = node.firstOrLeft; node.count > 0 && slot < node.firstOrLeft + node.count; slot++)
+            {
+                leafOfPrimitive[primitiveOrder[slot]] = i;
+            }
+        }
+
+        builtSahCost = ComputeSahCost();
+        return true;
+    }
+
+    AABB CpuBvh::ComputeLeafBounds(const BvhNode& leaf, const std::vector<AABB>& bounds) const
+    {
+        AABB result = EmptyAABB();
+        for (uint32_t slot = leaf.firstOrLeft; slot < leaf.firstOrLeft + leaf.count; slot++)
+        {
+            ExpandAABB(result, bounds[primitiveOrder[slot]]);
+        }
+        return result;
+    }
+
+    // ============================================
+    // Refit
+    // ============================================
+
+    void CpuBvh::Refit(const std::vector<AABB>& bounds)
+    {
+        // Children are always allocated after their parent, so a reverse sweep is bottom-up
+        for (size_t i = nodes.size(); i-- > 0;)
+        {
+            BvhNode& node = nodes[i];
+            if (node.count > 0)
+            {
+                node.bounds = ComputeLeafBounds(node, bounds);
+            }
+            else
+            {
+                node.bounds = nodes[node.firstOrLeft].bounds;
+                ExpandAABB(node.bounds, nodes[node.firstOrLeft + 1].bounds);
+            }
+        }
+    }
+
+    void CpuBvh::Refit(const std::vector<AABB>& bounds, const std::vector<uint32_t>& changedPrimitives)
+    {
+        // Walking many paths to the root costs more than one full sweep; after spatial
+        // splits a primitive has several leaves, so only a full sweep finds them all
+        if (spatialSplits || changedPrimitives.size() * 4 > nodes.size())
+        {
+            Refit(bounds);
+            return;
+        }
+
+        for (uint32_t primitive : changedPrimitives)
+        {
+            if (primitive >= leafOfPrimitive.size() || leafOfPrimitive[primitive] == INVALID_INDEX)
+                continue;
+
+            uint32_t nodeIndex = leafOfPrimitive[primitive];
+            nodes[nodeIndex].bounds = ComputeLeafBounds(nodes[nodeIndex], bounds);
+            for (nodeIndex = nodes[nodeIndex].parent; nodeIndex != INVALID_INDEX; nodeIndex = nodes[nodeIndex].parent)
+            {
+                BvhNode& node = nodes[nodeIndex];
+                node.bounds = nodes[node.firstOrLeft].bounds;
+                ExpandAABB(node.bounds, nodes[node.firstOrLeft + 1].bounds);
+            }
+        }
+    }
+
+    // ============================================
+    // Quality
+    // ============================================
+
+    float CpuBvh::ComputeSahCost() const
+    {
+        if (nodes.empty())
+            return 0.0f;
+
+        const float rootArea = SurfaceArea(nodes[0].bounds);
+        if (!(rootArea > 0.0f))
+            return INTERSECTION_COST * static_cast<float>(primitiveOrder.size());
+
+        float cost = 0.0f;
+        for (const BvhNode& node : nodes)
+        {
+            const float area = SurfaceArea(node.bounds);
+            cost += (node.count > 0) ? INTERSECTION_COST * area * node.count : TRAVERSAL_COST * area;
+        }
+        return cost / rootArea;
+    }
+
+    float CpuBvh::GetSahDegradation() const
+    {
+        if (!(builtSahCost > 0.0f))
+            return 1.0f;
+        return ComputeSahCost() / builtSahCost;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================
+// CPU BVH
+// ============================================
+//
+// Binned-SAH bounding volume hierarchy over axis-aligned boxes, with bottom-up refit.
+// The driver builds the real acceleration structures; this mirror of their inputs tells
+// how far a refitted (PERFORM_UPDATE) structure has drifted from a fresh build, so the
+// caller knows when an update is no longer good enough. Standard library only.
+//
+// Triangle meshes can also be built as a spatial-split BVH (SBVH, Stich et al. 2009):
+// where object splits leave children overlapping, long thin triangles are clipped at a
+// split plane and referenced from both children, within a cap on reference growth.
+
+namespace RayTraceVS::DXEngine
+{
+    // Axis-aligned box (layout must match D3D12_RAYTRACING_AABB)
+    struct AABB
+    {
+        float MinX, MinY, MinZ;
+        float MaxX, MaxY, MaxZ;
+    };
+
+    // Inverted box, the identity element of ExpandAABB
+    AABB EmptyAABB();
+    void ExpandAABB(AABB& target, const AABB& other);
+    // 0 for empty boxes
+    float SurfaceArea(const AABB& box);
+
+    struct BvhSpatialSplitSettings
+    {
+        float maxReferenceGrowth = 1.0f;    // Extra references allowed, as a fraction of the primitive count
+        float minOverlapRatio = 1e-5f;      // Child overlap (relative to the root area) worth a spatial split
+    };
+
+    struct BvhNode
+    {
+        AABB bounds;
+        uint32_t firstOrLeft;   // Leaf: first slot in the primitive order; inner: left child (right = left + 1)
+        uint32_t count;         // Primitives in the leaf, 0 for inner nodes
+        uint32_t parent;        // INVALID_INDEX for the root
+    };
+
+    class CpuBvh
+    {
+    public:
+        static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr uint32_t SAH_BIN_COUNT = 12;
+
+        // Builds over the listed primitives (indices into bounds); other entries are ignored
+        void Build(const std::vector<AABB>& bounds, const std::vector<uint32_t>& primitives);
+        void Build(const std::vector<AABB>& bounds);
+        // SBVH over triangles; triangleVertices holds 9 floats (3 positions) per primitive.
+        // A primitive may then appear in several leaves.
+        void BuildSpatial(const std::vector<AABB>& bounds, const std::vector<float>& triangleVertices,
+            const BvhSpatialSplitSettings& settings = {});
+        void Clear();
+        // Adopts a tree built elsewhere (e.g. read back from a PagedMeshFile) over primitiveCount
+        // primitives; false, leaving the BVH empty, if the nodes or references are inconsistent
+        bool Assign(std::vector<BvhNode> prebuiltNodes, std::vector<uint32_t> prebuiltOrder,
+            uint32_t primitiveCount, bool prebuiltSpatialSplits);
+
+        // Recomputes node bounds bottom-up from the primitives' current bounds; the tree
+        // topology is kept. With a list of changed primitives only their ancestors are visited.
+        // After BuildSpatial leaves get the full (unclipped) primitive bounds back.
+        void Refit(const std::vector<AABB>& bounds);
+        void Refit(const std::vector<AABB>& bounds, const std::vector<uint32_t>& changedPrimitives);
+
+        // Surface area heuristic cost, normalized by the root surface area (lower is better)
+        float ComputeSahCost() const;
+        // Current cost relative to the cost right after Build (1 = as good as a fresh build)
+        float GetSahDegradation() const;
+
+        bool Empty() const { return nodes.empty(); }
+        size_t GetNodeCount() const { return nodes.size(); }
+        // Leaf references; more than the primitive count after spatial splits
+        size_t GetPrimitiveCount() const { return primitiveOrder.size(); }
+        bool HasSpatialSplits() const { return spatialSplits; }
+        AABB GetRootBounds() const { return nodes.empty() ? EmptyAABB() : nodes[0].bounds; }
+        const std::vector<BvhNode>& GetNodes() const { return nodes; }
+        // Primitive indices in leaf order (leaves reference ranges of this array)
+        const std::vector<uint32_t>& GetPrimitiveOrder() const { return primitiveOrder; }
+
+    private:
+        // Splits nodes[nodeIndex] if that lowers the SAH cost; returns false for leaves
+        bool Split(uint32_t nodeIndex, const std::vector<AABB>& bounds);
+        AABB ComputeLeafBounds(const BvhNode& leaf, const std::vector<AABB>& bounds) const;
+
+        std::vector<BvhNode> nodes;
+        std::vector<uint32_t> primitiveOrder;
+        std::vector<uint32_t> leafOfPrimitive;  // Indexed by primitive, INVALID_INDEX if not in the tree
+        float builtSahCost = 0.0f;
+        bool spatialSplits = false;             // Primitives may be referenced from several leaves
+    };
+}
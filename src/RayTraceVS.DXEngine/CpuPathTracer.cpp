@@ -0,0 +1,1356 @@
+#include "CpuPathTracer.h"
+#include "DebugLog.h"
+#include "Sampler.h"
+#include "WorkerPool.h"
+#include "Scene/Scene.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr float RAY_T_MIN = 0.001f;
+        constexpr float RAY_T_MAX = 10000.0f;
+        constexpr float SURFACE_OFFSET = 0.001f;
+        constexpr uint32_t WORK_STACK_SIZE = 8;             // WORK_QUEUE_STRIDE in Common.hlsli
+        constexpr uint32_t CHUNKS_PER_THREAD = 8;
+        constexpr uint32_t STREAMING_BANDS = 16;            // Residency passes per depth-first frame over paged geometry
+        constexpr float PI = 3.14159265f;
+
+        // ============================================
+        // Small vector helpers
+        // ============================================
+
+        XMFLOAT3 Add(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x + b.x, a.y + b.y, a.z + b.z); }
+        XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+        XMFLOAT3 Mul(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x * b.x, a.y * b.y, a.z * b.z); }
+        XMFLOAT3 Scale(const XMFLOAT3& a, float s) { return XMFLOAT3(a.x * s, a.y * s, a.z * s); }
+        float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        float MaxComponent(const XMFLOAT3& a) { return (std::max)(a.x, (std::max)(a.y, a.z)); }
+
+        XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+        {
+            return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        }
+
+        XMFLOAT3 Normalize(const XMFLOAT3& a)
+        {
+            const float length = std::sqrt(Dot(a, a));
+            return length > 0.0f ? Scale(a, 1.0f / length) : a;
+        }
+
+        XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t)
+        {
+            return Add(a, Scale(Sub(b, a), t));
+        }
+
+        float Saturate(float x) { return (std::min)((std::max)(x, 0.0f), 1.0f); }
+
+        // ============================================
+        // Rays and materials
+        // ============================================
+
+        struct PathRay
+        {
+            XMFLOAT3 origin;
+            XMFLOAT3 direction;
+            XMFLOAT3 throughput;
+            uint32_t pixel;
+            uint32_t sequenceIndex;     // frameIndex * samplesPerPixel + sample (Sampler.h)
+            uint32_t depth;
+            float bsdfPdf;              // Solid-angle pdf of the BSDF sample that spawned it (0 = not MIS-weighted)
+            XMFLOAT3 bsdfNormal;        // Shading normal where it was sampled (light pick pmf of the MIS weight)
+        };
+
+        struct ShadowRay
+        {
+            XMFLOAT3 origin;
+            XMFLOAT3 direction;
+            float tMax;
+            XMFLOAT3 contribution;      // Added to the pixel when the light is visible
+            uint32_t pixel;
+        };
+
+        struct PixelContribution
+        {
+            uint32_t pixel;
+            XMFLOAT3 radiance;
+        };
+
+        struct SurfaceMaterial
+        {
+            XMFLOAT3 color;
+            float metallic;
+            float roughness;
+            float transmission;
+            float ior;
+            float specular;
+            XMFLOAT3 emission;
+            XMFLOAT3 absorption;
+        };
+
+        template<typename Material>
+        SurfaceMaterial ToSurfaceMaterial(const Material& material)
+        {
+            return { XMFLOAT3(material.color.x, material.color.y, material.color.z), material.metallic, material.roughness,
+                material.transmission, material.ior, material.specular, material.emission, material.absorption };
+        }
+
+        SurfaceMaterial GetSurfaceMaterial(const Scene& scene, const CpuAccelerationStructure& accelerationStructure, const CpuRayHit& hit)
+        {
+            if (hit.isMesh)
+            {
+                const CpuMeshInstance& instance = accelerationStructure.GetInstances()[hit.objectIndex];
+                return ToSurfaceMaterial(scene.GetMeshMaterials()[instance.materialIndex]);
+            }
+            switch (hit.objectType)
+            {
+            case ObjectType::Sphere: return ToSurfaceMaterial(scene.GetSpheres().materials[hit.objectIndex]);
+            case ObjectType::Plane:  return ToSurfaceMaterial(scene.GetPlanes().materials[hit.objectIndex]);
+            default:                 return ToSurfaceMaterial(scene.GetBoxes().materials[hit.objectIndex]);
+            }
+        }
+
+        // ============================================
+        // BSDF kinds
+        // ============================================
+        // Every material falls into one BSDF kind, and each kind is its own compile-time
+        // specialization of ShadeHit: lobes the kind does not have are not compiled in, so a
+        // batch of one kind runs without per-hit material branches.
+        enum BsdfKind : uint32_t
+        {
+            Bsdf_SmoothDielectric,      // Glass: Fresnel-weighted reflect/refract, Beer absorption inside
+            Bsdf_RoughDielectric,       // Glass with jittered reflect/refract directions (PerturbReflection)
+            Bsdf_Conductor,             // metallic = 1: glossy reflection tinted by the color
+            Bsdf_Opaque,                // metallic = 0: Lambert diffuse + specular highlight
+            Bsdf_Mixed,                 // 0 < metallic < 1: diffuse or glossy, picked per sample
+            Bsdf_Count
+        };
+
+        BsdfKind ClassifyBsdf(const SurfaceMaterial& material)
+        {
+            if (material.transmission > 0.01f)
+                return material.roughness > 0.01f ? Bsdf_RoughDielectric : Bsdf_SmoothDielectric;
+            if (material.metallic <= 0.0f)
+                return Bsdf_Opaque;
+            if (material.metallic >= 1.0f)
+                return Bsdf_Conductor;
+            return Bsdf_Mixed;
+        }
+
+        // Calls fn(std::integral_constant<BsdfKind, kind>) so fn can instantiate the kind's kernel
+        template<typename Fn>
+        decltype(auto) DispatchBsdf(BsdfKind kind, Fn&& fn)
+        {
+            switch (kind)
+            {
+            case Bsdf_SmoothDielectric: return fn(std::integral_constant<BsdfKind, Bsdf_SmoothDielectric>{});
+            case Bsdf_RoughDielectric:  return fn(std::integral_constant<BsdfKind, Bsdf_RoughDielectric>{});
+            case Bsdf_Conductor:        return fn(std::integral_constant<BsdfKind, Bsdf_Conductor>{});
+            case Bsdf_Opaque:           return fn(std::integral_constant<BsdfKind, Bsdf_Opaque>{});
+            default:                    return fn(std::integral_constant<BsdfKind, Bsdf_Mixed>{});
+            }
+        }
+
+        // BSDF kind first (each kind is a different kernel), then object type, then the
+        // material itself; the ray index keeps equal keys in pixel order
+        constexpr uint32_t SORT_KEY_BSDF_SHIFT = 61;
+        constexpr uint32_t SORT_KEY_OBJECT_SHIFT = 59;
+        static_assert(Bsdf_Count <= (1u << (64 - SORT_KEY_BSDF_SHIFT)), "BSDF kind does not fit the sort key");
+
+        uint64_t ShadingSortKey(const Scene& scene, const CpuAccelerationStructure& accelerationStructure,
+            const CpuRayHit& hit)
+        {
+            const SurfaceMaterial material = GetSurfaceMaterial(scene, accelerationStructure, hit);
+            const uint64_t bsdf = ClassifyBsdf(material);
+            const uint64_t objectKind = hit.isMesh ? 3 : static_cast<uint64_t>(hit.objectType);
+            // Meshes: the deduplicated material, so instances sharing one shade as a batch
+            const uint64_t materialIndex = hit.isMesh
+                ? accelerationStructure.GetInstances()[hit.objectIndex].materialIndex
+                : hit.objectIndex;
+            return (bsdf << SORT_KEY_BSDF_SHIFT) | (objectKind << SORT_KEY_OBJECT_SHIFT) |
+                (materialIndex & ((1ull << SORT_KEY_OBJECT_SHIFT) - 1));
+        }
+
+        BsdfKind SortKeyBsdf(uint64_t key)
+        {
+            return static_cast<BsdfKind>(key >> SORT_KEY_BSDF_SHIFT);
+        }
+
+        XMFLOAT3 CosineSampleHemisphere(const XMFLOAT3& normal, float u1, float u2)
+        {
+            const float r = std::sqrt(u1);
+            const float phi = 2.0f * PI * u2;
+            const XMFLOAT3 helper = std::abs(normal.x) > 0.9f ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+            const XMFLOAT3 tangent = Normalize(Cross(helper, normal));
+            const XMFLOAT3 bitangent = Cross(normal, tangent);
+            return Normalize(Add(Add(Scale(tangent, r * std::cos(phi)), Scale(bitangent, r * std::sin(phi))),
+                Scale(normal, std::sqrt((std::max)(0.0f, 1.0f - u1)))));
+        }
+
+        XMFLOAT3 Reflect(const XMFLOAT3& direction, const XMFLOAT3& normal)
+        {
+            return Sub(direction, Scale(normal, 2.0f * Dot(direction, normal)));
+        }
+
+        // PerturbReflection (Common.hlsli): offsets the direction within a disc of radius
+        // roughness^2 and mirrors it back if it ends up below the surface
+        XMFLOAT3 PerturbDirection(const XMFLOAT3& direction, const XMFLOAT3& normal, float roughness, Sampler& sampler)
+        {
+            const float r1 = sampler.Next();
+            const float r2 = sampler.Next();
+            const XMFLOAT3 helper = std::abs(normal.x) > 0.9f ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+            const XMFLOAT3 tangent = Normalize(Cross(normal, helper));
+            const XMFLOAT3 bitangent = Cross(normal, tangent);
+            const float angle = r1 * 2.0f * PI;
+            const float radius = roughness * roughness * r2;
+            const XMFLOAT3 offset = Scale(Add(Scale(tangent, std::cos(angle)), Scale(bitangent, std::sin(angle))), radius);
+            const XMFLOAT3 perturbed = Normalize(Add(direction, offset));
+            return Dot(perturbed, normal) < 0.0f ? Reflect(perturbed, normal) : perturbed;
+        }
+
+        // Solid-angle pdf of the glossy lobe's direction normalize(mirror + jitter * scale), jitter
+        // uniform in [-1, 1]^3. The jitter cube meets the line along direction in a segment
+        // [t0, t1], so the pdf is the integral of t^2 / (2 * scale)^3 over it.
+        float GlossyPdf(const XMFLOAT3& mirror, const XMFLOAT3& direction, float scale)
+        {
+            const float m[3] = { mirror.x, mirror.y, mirror.z };
+            const float d[3] = { direction.x, direction.y, direction.z };
+            float t0 = 0.0f, t1 = std::numeric_limits<float>::max();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (std::abs(d[axis]) < 1e-12f)
+                {
+                    if (std::abs(m[axis]) > scale)
+                        return 0.0f;
+                    continue;
+                }
+                const float a = (m[axis] - scale) / d[axis];
+                const float b = (m[axis] + scale) / d[axis];
+                t0 = (std::max)(t0, (std::min)(a, b));
+                t1 = (std::min)(t1, (std::max)(a, b));
+            }
+            if (t1 <= t0)
+                return 0.0f;
+            // t1^3 - t0^3 without the cancellation
+            return (t1 - t0) * (t1 * t1 + t1 * t0 + t0 * t0) / (24.0f * scale * scale * scale);
+        }
+
+        // 1 - cos of the half-angle a sphere subtends at `distance` from its center (0 inside it),
+        // in a form that stays accurate for small, far spheres
+        float SphereConeSpread(float radius, float distance)
+        {
+            if (distance <= radius)
+                return 0.0f;
+            const float sin2 = radius * radius / (distance * distance);
+            return sin2 / (1.0f + std::sqrt(1.0f - sin2));
+        }
+
+        // Direction uniform in the cone around axis whose half-angle has 1 - cos = spread
+        XMFLOAT3 SampleCone(const XMFLOAT3& axis, float spread, float u1, float u2)
+        {
+            const float cosTheta = 1.0f - u1 * spread;
+            const float sinTheta = std::sqrt((std::max)(0.0f, 1.0f - cosTheta * cosTheta));
+            const float phi = 2.0f * PI * u2;
+            const XMFLOAT3 helper = std::abs(axis.x) > 0.9f ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+            const XMFLOAT3 tangent = Normalize(Cross(helper, axis));
+            const XMFLOAT3 bitangent = Cross(axis, tangent);
+            return Normalize(Add(Add(Scale(tangent, sinTheta * std::cos(phi)), Scale(bitangent, sinTheta * std::sin(phi))),
+                Scale(axis, cosTheta)));
+        }
+
+        // Distance along a unit direction to the near side of a sphere (toCenter from the ray
+        // origin), or -1 if the ray misses it
+        float SphereDistance(const XMFLOAT3& toCenter, float radius, const XMFLOAT3& direction)
+        {
+            const float along = Dot(direction, toCenter);
+            const XMFLOAT3 perpendicular = Sub(toCenter, Scale(direction, along));
+            const float discriminant = radius * radius - Dot(perpendicular, perpendicular);
+            if (along <= 0.0f || discriminant < 0.0f)
+                return -1.0f;
+            return along - std::sqrt(discriminant);
+        }
+
+        struct ShadingContext
+        {
+            const Scene& scene;
+            const CpuAccelerationStructure& accelerationStructure;
+            const EnvironmentMap& environment;
+            uint32_t width;             // Image width, to recover pixel coordinates for the sampler
+            uint32_t russianRouletteMinDepth;
+            uint32_t maxBounces;
+            const LightBvh& emitters;                   // Emissive spheres and boxes
+            const std::vector<uint32_t>& sphereEmitters;
+            const std::vector<uint32_t>& boxEmitters;
+        };
+
+        // Random numbers are keyed by (pixel, sequence index, depth, salt) rather than by
+        // processing order, so both schedules (and RayGen.hlsl) draw the same numbers
+        Sampler MakeSampler(const ShadingContext& context, const PathRay& ray, uint32_t salt)
+        {
+            return Sampler(ray.pixel % context.width, ray.pixel / context.width, ray.sequenceIndex, ray.depth, salt);
+        }
+
+        // Power heuristic (beta = 2)
+        float PowerHeuristic(float pdf, float otherPdf)
+        {
+            const float a = pdf * pdf;
+            const float b = otherPdf * otherPdf;
+            return a + b > 0.0f ? a / (a + b) : 0.0f;
+        }
+
+        // Radiance of a ray that left the scene. With environment lighting on, BSDF-sampled
+        // rays share the environment with its light samples in ShadeHit, so their share is
+        // MIS-weighted here.
+        XMFLOAT3 EnvironmentRadiance(const ShadingContext& context, const PathRay& ray)
+        {
+            XMFLOAT3 radiance = Mul(ray.throughput, context.environment.Lookup(ray.direction));
+            if (ray.bsdfPdf > 0.0f && context.environment.GetLighting())
+                radiance = Scale(radiance, PowerHeuristic(ray.bsdfPdf, context.environment.Pdf(ray.direction)));
+            return radiance;
+        }
+
+        // ============================================
+        // Emissive primitives as lights
+        // ============================================
+
+        struct EmitterSample
+        {
+            XMFLOAT3 direction;
+            float distance;             // To the sampled point on the emitter
+            float pdf;                  // Solid angle, given the emitter
+            XMFLOAT3 emission;
+        };
+
+        bool IsInsideBox(const BoxGeometry& box, const XMFLOAT3& point)
+        {
+            const XMFLOAT3 offset = Sub(point, box.center);
+            return std::abs(Dot(offset, box.axisX)) < box.size.x && std::abs(Dot(offset, box.axisY)) < box.size.y &&
+                std::abs(Dot(offset, box.axisZ)) < box.size.z;
+        }
+
+        // Spheres: a direction uniform in the cone they subtend. Boxes: a point uniform over
+        // their surface (like EvaluateLightEmitter in Common.hlsli), rejected if it faces away.
+        bool SampleEmitter(const ShadingContext& context, uint32_t emitter, const XMFLOAT3& origin, Sampler& sampler,
+            EmitterSample& sample)
+        {
+            const GPULightEmitter& source = context.emitters.GetEmitters()[emitter];
+            if (source.Type == LightEmitter_Sphere)
+            {
+                const SphereGeometry& sphere = context.scene.GetSpheres().geometry[source.SourceIndex];
+                const XMFLOAT3 toCenter = Sub(sphere.center, origin);
+                const float distance = std::sqrt(Dot(toCenter, toCenter));
+                const float spread = SphereConeSpread(sphere.radius, distance);
+                if (spread <= 0.0f)
+                    return false;
+                const float u1 = sampler.Next();
+                const float u2 = sampler.Next();
+                sample.direction = SampleCone(Scale(toCenter, 1.0f / distance), spread, u1, u2);
+                // Inside the cone, so it hits up to rounding at the silhouette
+                sample.distance = (std::max)(SphereDistance(toCenter, sphere.radius, sample.direction), 0.0f);
+                sample.pdf = 1.0f / (2.0f * PI * spread);
+                sample.emission = context.scene.GetSpheres().materials[source.SourceIndex].emission;
+                return true;
+            }
+
+            const BoxGeometry& box = context.scene.GetBoxes().geometry[source.SourceIndex];
+            const XMFLOAT3 faceArea(box.size.y * box.size.z, box.size.z * box.size.x, box.size.x * box.size.y);
+            const float pick = sampler.Next() * (faceArea.x + faceArea.y + faceArea.z);
+            const float side = sampler.Next() < 0.5f ? -1.0f : 1.0f;
+            const float u = sampler.Next() * 2.0f - 1.0f;
+            const float v = sampler.Next() * 2.0f - 1.0f;
+            XMFLOAT3 local, faceNormal;
+            if (pick < faceArea.x)
+            {
+                local = XMFLOAT3(side, u, v);
+                faceNormal = Scale(box.axisX, side);
+            }
+            else if (pick < faceArea.x + faceArea.y)
+            {
+                local = XMFLOAT3(u, side, v);
+                faceNormal = Scale(box.axisY, side);
+            }
+            else
+            {
+                local = XMFLOAT3(u, v, side);
+                faceNormal = Scale(box.axisZ, side);
+            }
+            local = Mul(local, box.size);
+            const XMFLOAT3 point = Add(box.center, Add(Add(Scale(box.axisX, local.x), Scale(box.axisY, local.y)),
+                Scale(box.axisZ, local.z)));
+            const XMFLOAT3 toPoint = Sub(point, origin);
+            sample.distance = std::sqrt(Dot(toPoint, toPoint));
+            if (sample.distance <= 0.0f)
+                return false;
+            sample.direction = Scale(toPoint, 1.0f / sample.distance);
+            const float cosLight = -Dot(faceNormal, sample.direction);
+            if (cosLight <= 0.0f)
+                return false;
+            sample.pdf = sample.distance * sample.distance / (cosLight * source.Area);
+            sample.emission = context.scene.GetBoxes().materials[source.SourceIndex].emission;
+            return true;
+        }
+
+        // MIS weight of emission reached by a BSDF-sampled ray, against the light sample taken
+        // where the ray started (1 if that could not have picked this surface)
+        float EmissionWeight(const ShadingContext& context, const PathRay& ray, const CpuRayHit& hit)
+        {
+            if (ray.bsdfPdf <= 0.0f || hit.isMesh || hit.objectType == ObjectType::Plane)
+                return 1.0f;
+            const std::vector<uint32_t>& lookup = hit.objectType == ObjectType::Sphere ? context.sphereEmitters : context.boxEmitters;
+            const uint32_t emitter = hit.objectIndex < lookup.size() ? lookup[hit.objectIndex] : LightBvh::INVALID_INDEX;
+            if (emitter == LightBvh::INVALID_INDEX)
+                return 1.0f;
+
+            // Solid-angle pdf of SampleEmitter returning this point
+            float pdf = 0.0f;
+            if (hit.objectType == ObjectType::Sphere)
+            {
+                const SphereGeometry& sphere = context.scene.GetSpheres().geometry[hit.objectIndex];
+                const XMFLOAT3 toCenter = Sub(sphere.center, ray.origin);
+                const float spread = SphereConeSpread(sphere.radius, std::sqrt(Dot(toCenter, toCenter)));
+                pdf = spread > 0.0f ? 1.0f / (2.0f * PI * spread) : 0.0f;
+            }
+            else if (!IsInsideBox(context.scene.GetBoxes().geometry[hit.objectIndex], ray.origin))
+            {
+                // Entered from outside: the face normal is the outward one, facing the ray
+                const float cosLight = -Dot(hit.normal, ray.direction);
+                if (cosLight > 0.0f)
+                    pdf = hit.t * hit.t / (cosLight * context.emitters.GetEmitters()[emitter].Area);
+            }
+            const float lightPdf = context.emitters.Pmf(ray.origin, ray.bsdfNormal, emitter) * pdf;
+            return PowerHeuristic(ray.bsdfPdf, lightPdf);
+        }
+
+        // ============================================
+        // Shading kernels (shared by both schedules)
+        // ============================================
+        // Returns radiance added at this hit; light samples go to emitShadow and
+        // continuation rays to emitChild. Kind must be ClassifyBsdf(material).
+        template<BsdfKind Kind, typename EmitShadow, typename EmitChild>
+        XMFLOAT3 ShadeHit(const ShadingContext& context, const PathRay& ray, const CpuRayHit& hit,
+            const SurfaceMaterial& material, EmitShadow&& emitShadow, EmitChild&& emitChild)
+        {
+            const XMFLOAT3 position = Add(ray.origin, Scale(ray.direction, hit.t));
+            const bool frontFace = Dot(hit.normal, ray.direction) < 0.0f;
+            const XMFLOAT3 normal = frontFace ? hit.normal : Scale(hit.normal, -1.0f);
+            XMFLOAT3 radiance = Mul(ray.throughput, material.emission);
+            if (MaxComponent(material.emission) > 0.0f)
+                radiance = Scale(radiance, EmissionWeight(context, ray, hit));
+
+            // Russian roulette from russianRouletteMinDepth on: a child whose throughput (which
+            // already carries the lobe's albedo) is below 1 survives with that probability and
+            // is scaled back up, so the image is unchanged in expectation. One number per child,
+            // in spawn order, so both schedules make the same decisions.
+            Sampler rouletteSampler = MakeSampler(context, ray, SamplerSalt_RussianRoulette);
+            auto spawn = [&](const XMFLOAT3& origin, const XMFLOAT3& direction, XMFLOAT3 throughput,
+                float bsdfPdf = 0.0f)
+            {
+                const float survival = MaxComponent(throughput);
+                if (survival <= 0.0f)
+                    return;
+                if (ray.depth >= context.russianRouletteMinDepth && survival < 1.0f)
+                {
+                    if (rouletteSampler.Next() >= survival)
+                        return;
+                    throughput = Scale(throughput, 1.0f / survival);
+                }
+                emitChild(PathRay{ origin, direction, throughput, ray.pixel, ray.sequenceIndex, ray.depth + 1, bsdfPdf, normal });
+            };
+
+            if constexpr (Kind == Bsdf_SmoothDielectric || Kind == Bsdf_RoughDielectric)
+            {
+                // Glass: split into reflected and refracted children weighted by Fresnel
+                XMFLOAT3 throughput = ray.throughput;
+                if (!frontFace)
+                {
+                    // Beer-Lambert over the distance travelled inside the medium
+                    throughput = Mul(throughput, XMFLOAT3(std::exp(-material.absorption.x * hit.t),
+                        std::exp(-material.absorption.y * hit.t), std::exp(-material.absorption.z * hit.t)));
+                }
+
+                const float eta = frontFace ? 1.0f / material.ior : material.ior;
+                const float cosI = -Dot(ray.direction, normal);
+                const float k = 1.0f - eta * eta * (1.0f - cosI * cosI);
+                const XMFLOAT3 above = Add(position, Scale(normal, SURFACE_OFFSET));
+                XMFLOAT3 reflected = Normalize(Reflect(ray.direction, normal));
+                if constexpr (Kind == Bsdf_RoughDielectric)
+                {
+                    Sampler reflectSampler = MakeSampler(context, ray, SamplerSalt_Reflect);
+                    reflected = PerturbDirection(reflected, normal, material.roughness, reflectSampler);
+                }
+                if (k < 0.0f)
+                {
+                    spawn(above, reflected, throughput);        // Total internal reflection
+                    return radiance;
+                }
+
+                const float f0 = std::pow((material.ior - 1.0f) / (material.ior + 1.0f), 2.0f);
+                const float fresnel = f0 + (1.0f - f0) * std::pow(1.0f - Saturate(cosI), 5.0f);
+                XMFLOAT3 refracted = Normalize(Add(Scale(ray.direction, eta), Scale(normal, eta * cosI - std::sqrt(k))));
+                if constexpr (Kind == Bsdf_RoughDielectric)
+                {
+                    Sampler refractSampler = MakeSampler(context, ray, SamplerSalt_Refract);
+                    refracted = PerturbDirection(refracted, Scale(normal, -1.0f), material.roughness, refractSampler);
+                }
+                const XMFLOAT3 tint = frontFace ? material.color : XMFLOAT3(1.0f, 1.0f, 1.0f);
+                spawn(above, reflected, Scale(throughput, fresnel));
+                spawn(Sub(position, Scale(normal, SURFACE_OFFSET)), refracted,
+                    Mul(Scale(throughput, 1.0f - fresnel), tint));
+                return radiance;
+            }
+            else
+            {
+                // Opaque surfaces: a diffuse lobe weighted by 1 - metallic and a glossy
+                // reflection weighted by metallic; Opaque and Conductor have only one of them
+                constexpr bool hasDiffuse = Kind != Bsdf_Conductor;
+                constexpr bool hasGlossy = Kind != Bsdf_Opaque;
+                XMFLOAT3 diffuseColor;
+                if constexpr (Kind == Bsdf_Opaque)
+                    diffuseColor = material.color;
+                else if constexpr (Kind == Bsdf_Conductor)
+                    diffuseColor = XMFLOAT3(0.0f, 0.0f, 0.0f);
+                else
+                    diffuseColor = Scale(material.color, 1.0f - material.metallic);
+                const XMFLOAT3 f0 = Lerp(XMFLOAT3(0.04f, 0.04f, 0.04f), material.color, material.metallic);
+                const float shininess = (std::max)(8.0f, 512.0f * (1.0f - material.roughness));
+                const XMFLOAT3 viewDir = Scale(ray.direction, -1.0f);
+                const XMFLOAT3 shadowOrigin = Add(position, Scale(normal, SURFACE_OFFSET));
+
+                // The BSDF the continuation ray below samples, as f * cos and its solid-angle pdf:
+                // the diffuse lobe with probability diffuseProbability, the glossy jitter around
+                // the mirror direction otherwise. A mirror-like glossy lobe (roughness 0) is a
+                // delta; only the continuation ray finds light through it.
+                const float diffuseProbability = Kind == Bsdf_Opaque ? 1.0f : 1.0f - material.metallic;
+                const float glossyProbability = Kind == Bsdf_Conductor ? 1.0f : (Kind == Bsdf_Mixed ? material.metallic : 0.0f);
+                const XMFLOAT3 mirror = Reflect(ray.direction, normal);
+                const float glossyScale = material.roughness * material.roughness;
+                auto evaluateBsdf = [&](const XMFLOAT3& direction, float& pdf)
+                {
+                    XMFLOAT3 fCos(0.0f, 0.0f, 0.0f);
+                    pdf = 0.0f;
+                    const float nDotL = Dot(normal, direction);
+                    if (nDotL <= 0.0f)
+                        return fCos;
+                    if constexpr (hasDiffuse)
+                    {
+                        fCos = Scale(diffuseColor, nDotL / PI);
+                        pdf = diffuseProbability * nDotL / PI;
+                    }
+                    if constexpr (hasGlossy)
+                    {
+                        if (material.roughness > 0.0f)
+                        {
+                            const float glossyPdf = glossyProbability * GlossyPdf(mirror, direction, glossyScale);
+                            fCos = Add(fCos, Scale(f0, glossyPdf));
+                            pdf += glossyPdf;
+                        }
+                    }
+                    return fCos;
+                };
+                // Light samples are weighted against a continuation ray only if it will be traced
+                const bool childTraced = ray.depth + 1 < context.maxBounces;
+
+                XMFLOAT3 ambientAlbedo;
+                if constexpr (Kind == Bsdf_Opaque)
+                    ambientAlbedo = diffuseColor;
+                else if constexpr (Kind == Bsdf_Conductor)
+                    ambientAlbedo = Scale(material.color, 0.3f);
+                else
+                    ambientAlbedo = Lerp(diffuseColor, Scale(material.color, 0.3f), material.metallic);
+
+                auto highlight = [&](const XMFLOAT3& toLight)
+                {
+                    const XMFLOAT3 halfDir = Normalize(Add(toLight, viewDir));
+                    return Scale(f0, std::pow((std::max)(0.0f, Dot(normal, halfDir)), shininess) * material.specular);
+                };
+
+                Sampler lightSampler = MakeSampler(context, ray, SamplerSalt_Shadow);
+                for (const Light& light : context.scene.GetLights())
+                {
+                    const XMFLOAT4 color4 = light.GetColor();
+                    const XMFLOAT3 lightColor = Scale(XMFLOAT3(color4.x, color4.y, color4.z), light.GetIntensity());
+                    if (light.GetType() == LightType::Ambient)
+                    {
+                        radiance = Add(radiance, Mul(ray.throughput, Mul(lightColor, ambientAlbedo)));
+                        continue;
+                    }
+
+                    XMFLOAT3 toLight;
+                    float distance = RAY_T_MAX;
+                    float attenuation = 1.0f;
+                    if (light.GetType() == LightType::Directional)
+                    {
+                        toLight = Normalize(Scale(light.GetPosition(), -1.0f));
+                    }
+                    else
+                    {
+                        const XMFLOAT3 delta = Sub(light.GetPosition(), position);
+                        distance = std::sqrt(Dot(delta, delta));
+                        toLight = Scale(delta, 1.0f / (std::max)(distance, 1e-6f));
+                        attenuation = 1.0f / (std::max)(context.scene.GetLightAttenuationConstant() +
+                            context.scene.GetLightAttenuationLinear() * distance +
+                            context.scene.GetLightAttenuationQuadratic() * distance * distance, 0.0001f);
+
+                        const float spread = light.GetRadius() > 0.001f ? SphereConeSpread(light.GetRadius(), distance) : 0.0f;
+                        if (spread > 0.0f)
+                        {
+                            // Spherical area light: radiance lightColor * attenuation / (2 * spread) over
+                            // the cone it subtends, which a far light sees as the point light. Its diffuse
+                            // share takes a light sample and a cosine-weighted BSDF sample, combined by the
+                            // power heuristic; the highlight is a light-sample term only.
+                            const float lightPdf = 1.0f / (2.0f * PI * spread);
+                            const XMFLOAT3 radianceScale = Scale(lightColor, attenuation);
+                            const float u1 = lightSampler.Next();
+                            const float u2 = lightSampler.Next();
+                            const XMFLOAT3 direction = SampleCone(toLight, spread, u1, u2);
+                            const float nDotL = Dot(normal, direction);
+                            if (nDotL > 0.0f)
+                            {
+                                XMFLOAT3 brdf = highlight(direction);
+                                if constexpr (hasDiffuse)
+                                    brdf = Add(brdf, Scale(diffuseColor, nDotL * PowerHeuristic(lightPdf, nDotL / PI)));
+                                const XMFLOAT3 contribution = Mul(ray.throughput, Mul(radianceScale, brdf));
+                                const float sampleDistance = (std::max)(SphereDistance(delta, light.GetRadius(), direction), 0.0f);
+                                if (MaxComponent(contribution) > 0.0f)
+                                    emitShadow(ShadowRay{ shadowOrigin, direction, sampleDistance - SURFACE_OFFSET, contribution, ray.pixel });
+                            }
+                            if constexpr (hasDiffuse)
+                            {
+                                const float v1 = lightSampler.Next();
+                                const float v2 = lightSampler.Next();
+                                const XMFLOAT3 bsdfDirection = CosineSampleHemisphere(normal, v1, v2);
+                                const float hitDistance = SphereDistance(delta, light.GetRadius(), bsdfDirection);
+                                const float bsdfPdf = Dot(normal, bsdfDirection) / PI;
+                                if (hitDistance > 0.0f && bsdfPdf > 0.0f)
+                                {
+                                    const float weight = PowerHeuristic(bsdfPdf, lightPdf);
+                                    const XMFLOAT3 contribution = Mul(ray.throughput, Mul(radianceScale,
+                                        Scale(diffuseColor, weight / (2.0f * spread))));
+                                    if (MaxComponent(contribution) > 0.0f)
+                                        emitShadow(ShadowRay{ shadowOrigin, bsdfDirection, hitDistance - SURFACE_OFFSET, contribution, ray.pixel });
+                                }
+                            }
+                            continue;
+                        }
+                    }
+
+                    const float nDotL = Dot(normal, toLight);
+                    if (nDotL <= 0.0f)
+                        continue;
+
+                    XMFLOAT3 brdf = highlight(toLight);
+                    if constexpr (hasDiffuse)
+                        brdf = Add(Scale(diffuseColor, nDotL), brdf);
+                    const XMFLOAT3 contribution = Mul(ray.throughput, Mul(Scale(lightColor, attenuation), brdf));
+                    if (MaxComponent(contribution) <= 0.0f)
+                        continue;
+                    emitShadow(ShadowRay{ shadowOrigin, toLight, distance - SURFACE_OFFSET, contribution, ray.pixel });
+                }
+
+                // One emissive sphere or box, picked by the light BVH and sampled by solid angle
+                if (!context.emitters.GetNodes().empty())
+                {
+                    Sampler emitterSampler = MakeSampler(context, ray, SamplerSalt_LightPick);
+                    float pmf = 0.0f;
+                    const uint32_t emitter = context.emitters.Sample(shadowOrigin, normal, emitterSampler.Next(), pmf);
+                    EmitterSample sample;
+                    if (emitter != LightBvh::INVALID_INDEX && pmf > 0.0f &&
+                        SampleEmitter(context, emitter, shadowOrigin, emitterSampler, sample))
+                    {
+                        float bsdfPdf = 0.0f;
+                        const XMFLOAT3 fCos = evaluateBsdf(sample.direction, bsdfPdf);
+                        const float lightPdf = pmf * sample.pdf;
+                        const float weight = childTraced ? PowerHeuristic(lightPdf, bsdfPdf) : 1.0f;
+                        const XMFLOAT3 contribution = Mul(ray.throughput, Mul(sample.emission, Scale(fCos, weight / lightPdf)));
+                        if (MaxComponent(contribution) > 0.0f)
+                        {
+                            // Stop short of the emitter itself
+                            emitShadow(ShadowRay{ shadowOrigin, sample.direction, sample.distance * 0.999f - SURFACE_OFFSET,
+                                contribution, ray.pixel });
+                        }
+                    }
+                }
+
+                // Environment light sample, MIS-weighted against the continuation ray
+                if (context.environment.GetLighting())
+                {
+                    Sampler environmentSampler = MakeSampler(context, ray, SamplerSalt_Environment);
+                    const float u1 = environmentSampler.Next(), u2 = environmentSampler.Next();
+                    const float u3 = environmentSampler.Next(), u4 = environmentSampler.Next();
+                    float environmentPdf = 0.0f;
+                    const XMFLOAT3 direction = context.environment.Sample(u1, u2, u3, u4, environmentPdf);
+                    if (environmentPdf > 0.0f)
+                    {
+                        float bsdfPdf = 0.0f;
+                        const XMFLOAT3 fCos = evaluateBsdf(direction, bsdfPdf);
+                        const float weight = PowerHeuristic(environmentPdf, bsdfPdf);
+                        const XMFLOAT3 contribution = Mul(ray.throughput, Mul(context.environment.Lookup(direction),
+                            Scale(fCos, weight / environmentPdf)));
+                        if (MaxComponent(contribution) > 0.0f)
+                            emitShadow(ShadowRay{ shadowOrigin, direction, RAY_T_MAX, contribution, ray.pixel });
+                    }
+                }
+
+                // One continuation ray: glossy reflection for the metallic share, diffuse otherwise.
+                // The direction takes the best stratified pair of dimensions, the lobe the third.
+                Sampler brdfSampler = MakeSampler(context, ray, SamplerSalt_Brdf);
+                const float u1 = brdfSampler.Next();
+                const float u2 = brdfSampler.Next();
+                bool glossy = hasGlossy;
+                if constexpr (Kind == Bsdf_Mixed)
+                    glossy = brdfSampler.Next() < material.metallic;
+                if (glossy)
+                {
+                    XMFLOAT3 direction = mirror;
+                    if (material.roughness > 0.0f)
+                    {
+                        // Skip the number the mixed kernel spends on the lobe choice, so a
+                        // conductor draws the same jitter whichever kernel shades it
+                        if constexpr (Kind != Bsdf_Mixed)
+                            brdfSampler.Next();
+                        const XMFLOAT3 jitter(u1 * 2.0f - 1.0f, u2 * 2.0f - 1.0f, brdfSampler.Next() * 2.0f - 1.0f);
+                        direction = Add(direction, Scale(jitter, glossyScale));
+                    }
+                    direction = Normalize(direction);
+                    if (Dot(direction, normal) > 0.0f)
+                    {
+                        float bsdfPdf = 0.0f;
+                        if (material.roughness > 0.0f)
+                            evaluateBsdf(direction, bsdfPdf);
+                        spawn(shadowOrigin, direction, Mul(ray.throughput, f0), bsdfPdf);
+                    }
+                }
+                else
+                {
+                    const XMFLOAT3 direction = CosineSampleHemisphere(normal, u1, u2);
+                    float bsdfPdf = 0.0f;
+                    evaluateBsdf(direction, bsdfPdf);
+                    spawn(shadowOrigin, direction, Mul(ray.throughput, material.color), bsdfPdf);
+                }
+                return radiance;
+            }
+        }
+
+        // Looks up the material and runs its kind's kernel (one branch per hit, outside the kernel)
+        template<typename EmitShadow, typename EmitChild>
+        XMFLOAT3 ShadeHit(const ShadingContext& context, const PathRay& ray, const CpuRayHit& hit,
+            EmitShadow&& emitShadow, EmitChild&& emitChild)
+        {
+            const SurfaceMaterial material = GetSurfaceMaterial(context.scene, context.accelerationStructure, hit);
+            return DispatchBsdf(ClassifyBsdf(material), [&](auto kind)
+            {
+                return ShadeHit<decltype(kind)::value>(context, ray, hit, material, emitShadow, emitChild);
+            });
+        }
+
+        // ============================================
+        // Parallel helpers
+        // ============================================
+
+        uint32_t ResolveThreadCount(uint32_t requested)
+        {
+            if (requested > 0)
+                return requested;
+            return (std::max)(1u, std::thread::hardware_concurrency());
+        }
+
+        // Stages run through ParallelChunks (WorkerPool.h): fixed chunks, merged in chunk order
+        size_t ChunkCountFor(size_t count, uint32_t threadCount)
+        {
+            return (std::min)(count, static_cast<size_t>(threadCount) * CHUNKS_PER_THREAD);
+        }
+
+        // Concatenates per-chunk outputs in chunk order (stream compaction)
+        template<typename T>
+        void Compact(std::vector<std::vector<T>>& chunks, std::vector<T>& output)
+        {
+            size_t total = 0;
+            for (const auto& chunk : chunks)
+                total += chunk.size();
+            output.clear();
+            output.reserve(total);
+            for (auto& chunk : chunks)
+            {
+                output.insert(output.end(), chunk.begin(), chunk.end());
+                chunk.clear();
+            }
+        }
+
+        double ElapsedMs(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        PathRay GenerateCameraRay(const Scene& scene, const CpuPathTracerSettings& settings, uint32_t pixel, uint32_t sample)
+        {
+            // Same basis and projection as DXRPipeline / RayGen.hlsl
+            const Camera& camera = scene.GetCamera();
+            const XMFLOAT3 position = camera.GetPosition();
+            const XMFLOAT3 forward = Normalize(Sub(camera.GetLookAt(), position));
+            const XMFLOAT3 right = Normalize(Cross(camera.GetUp(), forward));
+            const XMFLOAT3 up = Normalize(Cross(forward, right));
+            const float tanHalfFov = std::tan(camera.GetFieldOfView() * 0.5f * PI / 180.0f);
+            const float aspectRatio = static_cast<float>(settings.width) / static_cast<float>(settings.height);
+
+            const uint32_t sequenceIndex = settings.frameIndex * settings.samplesPerPixel + sample;
+            float offsetX = 0.5f, offsetY = 0.5f;
+            if (settings.samplesPerPixel > 1)
+            {
+                Sampler sampler(pixel % settings.width, pixel / settings.width, sequenceIndex, 0, SamplerSalt_AntiAliasing);
+                offsetX = sampler.Next();
+                offsetY = sampler.Next();
+            }
+            const float ndcX = (static_cast<float>(pixel % settings.width) + offsetX) / static_cast<float>(settings.width) * 2.0f - 1.0f;
+            const float ndcY = -((static_cast<float>(pixel / settings.width) + offsetY) / static_cast<float>(settings.height) * 2.0f - 1.0f);
+
+            const XMFLOAT3 direction = Normalize(Add(Add(forward, Scale(right, ndcX * tanHalfFov * aspectRatio)),
+                Scale(up, ndcY * tanHalfFov)));
+            return PathRay{ position, direction, XMFLOAT3(1.0f, 1.0f, 1.0f), pixel, sequenceIndex, 0, 0.0f,
+                XMFLOAT3(0.0f, 0.0f, 0.0f) };
+        }
+
+        // ============================================
+        // Deferred queries (paged geometry)
+        // ============================================
+
+        // A query that reached chunks still on disk: one record per chunk, grouped by query
+        struct DeferredQuery
+        {
+            uint32_t query;             // Index into the stage's queue
+            CpuPendingChunk chunk;
+        };
+
+        // Per-chunk ray queues: a query resumes, resume(chunk, first, last) over its records, as
+        // soon as the last chunk it waits on is resident, so shading the early arrivals overlaps
+        // with the loads still in flight. Loads are queued as they fit in the streaming budget,
+        // and chunks no waiting query needs are released to make room, so the chunks of one
+        // stage never all have to be in memory at once. The time blocked on I/O goes to
+        // stats.streamWaitMs.
+        template<typename Resume>
+        void ResolveDeferred(const std::vector<DeferredQuery>& deferred, GeometryStreamer& streamer, uint32_t threadCount,
+            CpuPathTracerStats& stats, Resume&& resume)
+        {
+            struct Group
+            {
+                size_t begin;
+                size_t end;
+                uint32_t waiting;       // Distinct chunks not resident yet
+            };
+            std::vector<Group> groups;
+            std::unordered_map<uint32_t, std::vector<uint32_t>> queues;
+            std::unordered_map<uint32_t, uint32_t> users;      // Records of queries not resumed yet, per chunk
+            for (size_t begin = 0; begin < deferred.size();)
+            {
+                size_t end = begin;
+                while (end < deferred.size() && deferred[end].query == deferred[begin].query)
+                    end++;
+                const uint32_t group = static_cast<uint32_t>(groups.size());
+                groups.push_back({ begin, end, 0 });
+                for (size_t i = begin; i < end; i++)
+                {
+                    users[deferred[i].chunk.chunk]++;
+                    std::vector<uint32_t>& queue = queues[deferred[i].chunk.chunk];
+                    if (queue.empty() || queue.back() != group)
+                    {
+                        queue.push_back(group);
+                        groups.back().waiting++;
+                    }
+                }
+                begin = end;
+            }
+            stats.deferredRays += groups.size();
+
+            // Queues the awaited chunks query by query, so the queries complete in order and
+            // hand their chunks back, for as long as they fit in the budget; room is made by
+            // releasing chunks no waiting query needs. With nothing in flight at least one is
+            // queued, so a budget filled by chunks that waiting queries hold still advances.
+            size_t nextGroup = 0;       // Groups before it have every chunk queued or resident
+            auto loadAwaited = [&](bool idle)
+            {
+                for (; nextGroup < groups.size(); nextGroup++)
+                {
+                    // Groups the prefetch already completed have resumed and given their chunks back
+                    if (groups[nextGroup].waiting == 0)
+                        continue;
+                    for (size_t i = groups[nextGroup].begin; i < groups[nextGroup].end; i++)
+                    {
+                        const uint32_t chunk = deferred[i].chunk.chunk;
+                        if (streamer.Prefetch(chunk))
+                            continue;
+                        streamer.Release(streamer.GetChunkBytes(chunk), [&](uint32_t held) { return users.count(held) != 0; });
+                        if (streamer.Prefetch(chunk))
+                            continue;
+                        if (!idle)
+                            return;
+                        streamer.Request(chunk);
+                        idle = false;
+                    }
+                }
+            };
+
+            if (!groups.empty())
+                loadAwaited(false);
+
+            std::vector<uint32_t> ready;
+            while (!queues.empty())
+            {
+                ready.clear();
+                for (auto it = queues.begin(); it != queues.end();)
+                {
+                    if (!streamer.IsResident(it->first))
+                    {
+                        ++it;
+                        continue;
+                    }
+                    for (uint32_t group : it->second)
+                    {
+                        if (--groups[group].waiting == 0)
+                            ready.push_back(group);
+                    }
+                    it = queues.erase(it);
+                }
+
+                if (ready.empty())
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    if (!streamer.WaitForLoads())
+                        loadAwaited(true);
+                    stats.streamWaitMs += ElapsedMs(start);
+                    continue;
+                }
+
+                ParallelChunks(ready.size(), ChunkCountFor(ready.size(), threadCount), threadCount,
+                    [&](size_t chunk, size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            const Group& group = groups[ready[i]];
+                            resume(chunk, deferred.data() + group.begin, deferred.data() + group.end);
+                        }
+                    });
+
+                // The resumed queries are done with their chunks
+                for (uint32_t group : ready)
+                {
+                    for (size_t i = groups[group].begin; i < groups[group].end; i++)
+                    {
+                        auto user = users.find(deferred[i].chunk.chunk);
+                        if (--user->second == 0)
+                            users.erase(user);
+                    }
+                }
+                if (!queues.empty())
+                    loadAwaited(false);
+            }
+        }
+    }
+
+    // ============================================
+    // Frame
+    // ============================================
+
+    void CpuPathTracer::UpdateAccelerationStructure(const Scene& scene)
+    {
+        const uint32_t changes = built ? scene.GetChangesSince(lastGeneration) : SceneChange_All;
+        lastGeneration = scene.GetGeneration();
+        built = true;
+
+        accelerationStructure.ResetUpdateStats();
+        if (changes & SceneChange_Geometry)
+            accelerationStructure.BuildProcedural(scene);
+        if (changes & SceneChange_MeshCaches)
+            accelerationStructure.BuildMeshBLASes(scene);
+        if (changes & (SceneChange_MeshCaches | SceneChange_MeshInstances))
+            accelerationStructure.BuildInstances(scene);
+        else if (changes & SceneChange_MeshMaterials)
+            accelerationStructure.UpdateInstanceMaterials(scene);
+        if (changes & (SceneChange_Geometry | SceneChange_Materials))
+            BuildEmitters(scene);
+        stats.bvhBuilds = accelerationStructure.GetUpdateStats().builds;
+        stats.bvhRefits = accelerationStructure.GetUpdateStats().refits;
+    }
+
+    void CpuPathTracer::BuildEmitters(const Scene& scene)
+    {
+        // Lights keep their own loop in ShadeHit; the BVH holds emissive spheres and boxes only
+        LightBvhLimits limits;
+        limits.maxLights = 0;
+        emitters.Build(scene, limits);
+
+        sphereEmitters.assign(scene.GetSpheres().Size(), LightBvh::INVALID_INDEX);
+        boxEmitters.assign(scene.GetBoxes().Size(), LightBvh::INVALID_INDEX);
+        const std::vector<GPULightEmitter>& sources = emitters.GetEmitters();
+        for (uint32_t i = 0; i < sources.size(); i++)
+        {
+            if (sources[i].Type == LightEmitter_Sphere)
+                sphereEmitters[sources[i].SourceIndex] = i;
+            else if (sources[i].Type == LightEmitter_Box)
+                boxEmitters[sources[i].SourceIndex] = i;
+        }
+    }
+
+    bool CpuPathTracer::Render(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<XMFLOAT4>& radiance)
+    {
+        radiance.resize(static_cast<size_t>(settings.width) * settings.height);
+        FrameBufferView target;
+        target.data = reinterpret_cast<uint8_t*>(radiance.data());
+        target.width = settings.width;
+        target.height = settings.height;
+        target.rowPitch = settings.width * static_cast<uint32_t>(sizeof(XMFLOAT4));
+        target.format = FrameFormat::Rgba32Float;
+        return Render(scene, settings, target);
+    }
+
+    bool CpuPathTracer::Render(const Scene& scene, const CpuPathTracerSettings& settings, const FrameBufferView& target)
+    {
+        if (settings.width == 0 || settings.height == 0)
+            return false;
+        if (!target.data || target.width != settings.width || target.height != settings.height ||
+            target.format != FrameFormat::Rgba32Float)
+        {
+            LOG_WARN("CpuPathTracer::Render: target must be an Rgba32Float image of the render size");
+            return false;
+        }
+
+        const auto frameStart = std::chrono::steady_clock::now();
+        stats = CpuPathTracerStats();
+        UpdateAccelerationStructure(scene);
+        environment.Update(scene);
+        stats.buildMs = ElapsedMs(frameStart);
+
+        const size_t pixelCount = static_cast<size_t>(settings.width) * settings.height;
+        std::vector<XMFLOAT3> accumulated(pixelCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+        if (settings.mode == CpuTraceMode::Wavefront)
+            RenderWavefront(scene, settings, accumulated);
+        else
+            RenderDepthFirst(scene, settings, accumulated);
+
+        const float invSamples = 1.0f / static_cast<float>((std::max)(settings.samplesPerPixel, 1u));
+        for (uint32_t y = 0; y < settings.height; y++)
+        {
+            XMFLOAT4* row = reinterpret_cast<XMFLOAT4*>(target.GetRow(y));
+            for (uint32_t x = 0; x < settings.width; x++)
+            {
+                const XMFLOAT3 color = Scale(accumulated[static_cast<size_t>(y) * settings.width + x], invSamples);
+                row[x] = XMFLOAT4(color.x, color.y, color.z, 1.0f);
+            }
+        }
+
+        stats.totalMs = ElapsedMs(frameStart);
+        LOG_DEBUGF("[CpuPathTracer] %s %ux%u: %llu extension + %llu shadow rays, %u waves, %.1f ms",
+            settings.mode == CpuTraceMode::Wavefront ? "wavefront" : "depth-first", settings.width, settings.height,
+            static_cast<unsigned long long>(stats.extensionRays), static_cast<unsigned long long>(stats.shadowRays),
+            stats.waves, stats.totalMs);
+        if (stats.droppedRays > 0)
+            LOG_WARNF("[CpuPathTracer] depth-first: %llu child rays dropped (work stack of %u full)",
+                static_cast<unsigned long long>(stats.droppedRays), WORK_STACK_SIZE);
+        return true;
+    }
+
+    // ============================================
+    // Depth-first schedule
+    // ============================================
+
+    void CpuPathTracer::RenderDepthFirst(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<XMFLOAT3>& accumulated)
+    {
+        const ShadingContext context = { scene, accelerationStructure, environment, settings.width,
+            settings.russianRouletteMinDepth, settings.maxBounces, emitters, sphereEmitters, boxEmitters };
+        const uint32_t threadCount = ResolveThreadCount(settings.threadCount);
+        const size_t pixelCount = accumulated.size();
+        std::atomic<uint64_t> extensionRays = 0, shadowRays = 0, droppedRays = 0;
+
+        // Paged geometry is loaded on demand and stays until the end of its residency pass;
+        // each band of rows is one pass, so the chunks of a band can go before the next
+        const bool streaming = accelerationStructure.HasPagedGeometry();
+        GeometryStreamer& streamer = accelerationStructure.GetGeometryStreamer();
+        const size_t bandCount = streaming ? (std::min)(pixelCount, static_cast<size_t>(STREAMING_BANDS)) : 1;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t band = 0; band < bandCount; band++)
+        {
+            const size_t bandBegin = pixelCount * band / bandCount;
+            const size_t bandEnd = pixelCount * (band + 1) / bandCount;
+            if (streaming)
+                streamer.BeginPass();
+            ParallelChunks(bandEnd - bandBegin, ChunkCountFor(bandEnd - bandBegin, threadCount), threadCount, [&](size_t, size_t begin, size_t end)
+            {
+                uint64_t localExtension = 0, localShadow = 0, localDropped = 0;
+                for (size_t pixel = bandBegin + begin; pixel < bandBegin + end; pixel++)
+                {
+                    XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+                    for (uint32_t sample = 0; sample < settings.samplesPerPixel; sample++)
+                    {
+                        // Per-sample stack, like RayGen's WorkQueue: children are processed before siblings
+                        PathRay stack[WORK_STACK_SIZE];
+                        uint32_t stackSize = 0;
+                        stack[stackSize++] = GenerateCameraRay(scene, settings, static_cast<uint32_t>(pixel), sample);
+                        while (stackSize > 0)
+                        {
+                            const PathRay ray = stack[--stackSize];
+                            if (ray.depth >= settings.maxBounces)
+                            {
+                                sum = Add(sum, EnvironmentRadiance(context, ray));
+                                continue;
+                            }
+
+                            CpuRayHit hit;
+                            localExtension++;
+                            if (!accelerationStructure.Intersect(ray.origin, ray.direction, RAY_T_MIN, RAY_T_MAX, hit))
+                            {
+                                sum = Add(sum, EnvironmentRadiance(context, ray));
+                                continue;
+                            }
+
+                            sum = Add(sum, ShadeHit(context, ray, hit,
+                                [&](const ShadowRay& shadow)
+                                {
+                                    localShadow++;
+                                    if (!accelerationStructure.IsOccluded(shadow.origin, shadow.direction, 0.0f, shadow.tMax))
+                                        sum = Add(sum, shadow.contribution);
+                                },
+                                [&](const PathRay& child)
+                                {
+                                    if (stackSize < WORK_STACK_SIZE)
+                                        stack[stackSize++] = child;
+                                    else
+                                        localDropped++;
+                                }));
+                        }
+                    }
+                    accumulated[pixel] = sum;
+                }
+                extensionRays += localExtension;
+                shadowRays += localShadow;
+                droppedRays += localDropped;
+            });
+            if (streaming)
+                streamer.EndPass();
+        }
+
+        stats.extendMs = ElapsedMs(start);
+        stats.extensionRays = extensionRays;
+        stats.shadowRays = shadowRays;
+        stats.droppedRays = droppedRays;
+    }
+
+    // ============================================
+    // Wavefront schedule
+    // ============================================
+
+    void CpuPathTracer::RenderWavefront(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<XMFLOAT3>& accumulated)
+    {
+        const ShadingContext context = { scene, accelerationStructure, environment, settings.width,
+            settings.russianRouletteMinDepth, settings.maxBounces, emitters, sphereEmitters, boxEmitters };
+        const uint32_t threadCount = ResolveThreadCount(settings.threadCount);
+        const size_t maxChunks = static_cast<size_t>(threadCount) * CHUNKS_PER_THREAD;
+
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t ray;
+        };
+
+        std::vector<PathRay> rays, nextRays;
+        std::vector<CpuRayHit> hits;
+        std::vector<SortEntry> order;
+        std::vector<ShadowRay> shadowRays;
+        std::vector<std::vector<PathRay>> chunkRays(maxChunks);
+        std::vector<std::vector<ShadowRay>> chunkShadows(maxChunks);
+        std::vector<std::vector<SortEntry>> chunkOrder(maxChunks);
+        std::vector<std::vector<PixelContribution>> chunkRadiance(maxChunks);
+
+        // Rays that reach paged geometry still on disk wait in per-chunk queues while the rest
+        // of the wave is traced; every wave is one residency pass
+        const bool streaming = accelerationStructure.HasPagedGeometry();
+        GeometryStreamer& streamer = accelerationStructure.GetGeometryStreamer();
+        std::vector<DeferredQuery> deferred;
+        std::vector<std::vector<DeferredQuery>> chunkDeferred(maxChunks);
+
+        auto accumulate = [&]()
+        {
+            for (auto& contributions : chunkRadiance)
+            {
+                for (const PixelContribution& contribution : contributions)
+                    accumulated[contribution.pixel] = Add(accumulated[contribution.pixel], contribution.radiance);
+                contributions.clear();
+            }
+        };
+
+        // Generate: one camera ray per pixel sample
+        auto stageStart = std::chrono::steady_clock::now();
+        const size_t primaryCount = accumulated.size() * settings.samplesPerPixel;
+        rays.resize(primaryCount);
+        ParallelChunks(primaryCount, ChunkCountFor(primaryCount, threadCount), threadCount, [&](size_t, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                rays[i] = GenerateCameraRay(scene, settings, static_cast<uint32_t>(i / settings.samplesPerPixel),
+                    static_cast<uint32_t>(i % settings.samplesPerPixel));
+            }
+        });
+        stats.generateMs = ElapsedMs(stageStart);
+
+        while (!rays.empty())
+        {
+            stats.waves++;
+            stats.maxQueueLength = (std::max)(stats.maxQueueLength, static_cast<uint32_t>(rays.size()));
+            if (streaming)
+                streamer.BeginPass();
+
+            // Extend: closest hit for the whole queue; misses and terminated paths resolve
+            // to the sky, hits get a shading key
+            stageStart = std::chrono::steady_clock::now();
+            hits.resize(rays.size());
+            size_t chunkCount = ChunkCountFor(rays.size(), threadCount);
+            std::atomic<uint64_t> traced = 0;
+            ParallelChunks(rays.size(), chunkCount, threadCount, [&](size_t chunk, size_t begin, size_t end)
+            {
+                uint64_t localTraced = 0;
+                std::vector<CpuPendingChunk> pending;
+                for (size_t i = begin; i < end; i++)
+                {
+                    const PathRay& ray = rays[i];
+                    if (ray.depth < settings.maxBounces)
+                    {
+                        localTraced++;
+                        const bool found = streaming
+                            ? accelerationStructure.IntersectResident(ray.origin, ray.direction, RAY_T_MIN, RAY_T_MAX, hits[i], pending)
+                            : accelerationStructure.Intersect(ray.origin, ray.direction, RAY_T_MIN, RAY_T_MAX, hits[i]);
+                        if (!pending.empty())
+                        {
+                            for (const CpuPendingChunk& waiting : pending)
+                                chunkDeferred[chunk].push_back({ static_cast<uint32_t>(i), waiting });
+                            pending.clear();
+                            continue;
+                        }
+                        if (found)
+                        {
+                            chunkOrder[chunk].push_back({ ShadingSortKey(scene, accelerationStructure, hits[i]), static_cast<uint32_t>(i) });
+                            continue;
+                        }
+                    }
+                    chunkRadiance[chunk].push_back({ ray.pixel, EnvironmentRadiance(context, ray) });
+                }
+                traced += localTraced;
+            });
+            stats.extensionRays += traced;
+
+            // Deferred rays keep their closest resident hit and finish on the chunks they wait for
+            Compact(chunkDeferred, deferred);
+            ResolveDeferred(deferred, streamer, threadCount, stats,
+                [&](size_t chunk, const DeferredQuery* first, const DeferredQuery* last)
+                {
+                    const uint32_t i = first->query;
+                    const PathRay& ray = rays[i];
+                    for (const DeferredQuery* query = first; query != last; query++)
+                        accelerationStructure.IntersectPending(ray.origin, ray.direction, RAY_T_MIN, RAY_T_MAX, query->chunk, hits[i]);
+                    if (hits[i].IsHit())
+                        chunkOrder[chunk].push_back({ ShadingSortKey(scene, accelerationStructure, hits[i]), i });
+                    else
+                        chunkRadiance[chunk].push_back({ ray.pixel, EnvironmentRadiance(context, ray) });
+                });
+            Compact(chunkOrder, order);
+            accumulate();
+            stats.extendMs += ElapsedMs(stageStart);
+
+            // Sort hits by BSDF kind, object type and material
+            stageStart = std::chrono::steady_clock::now();
+            std::sort(order.begin(), order.end(), [](const SortEntry& a, const SortEntry& b)
+            {
+                return a.key != b.key ? a.key < b.key : a.ray < b.ray;
+            });
+            stats.sortMs += ElapsedMs(stageStart);
+
+            // Shade: coherent batches; shadow rays and continuation rays are compacted
+            // into the next global queues. The order is grouped by BSDF kind, so a chunk is a
+            // few runs of one kind, each shaded by that kind's kernel.
+            stageStart = std::chrono::steady_clock::now();
+            chunkCount = ChunkCountFor(order.size(), threadCount);
+            ParallelChunks(order.size(), chunkCount, threadCount, [&](size_t chunk, size_t begin, size_t end)
+            {
+                auto emitShadow = [&](const ShadowRay& shadow) { chunkShadows[chunk].push_back(shadow); };
+                auto emitChild = [&](const PathRay& child) { chunkRays[chunk].push_back(child); };
+                for (size_t runBegin = begin; runBegin < end; )
+                {
+                    const BsdfKind kind = SortKeyBsdf(order[runBegin].key);
+                    size_t runEnd = runBegin + 1;
+                    while (runEnd < end && SortKeyBsdf(order[runEnd].key) == kind)
+                        runEnd++;
+
+                    DispatchBsdf(kind, [&](auto bsdf)
+                    {
+                        for (size_t i = runBegin; i < runEnd; i++)
+                        {
+                            const PathRay& ray = rays[order[i].ray];
+                            const CpuRayHit& hit = hits[order[i].ray];
+                            const SurfaceMaterial material = GetSurfaceMaterial(scene, accelerationStructure, hit);
+                            const XMFLOAT3 emitted = ShadeHit<decltype(bsdf)::value>(context, ray, hit, material, emitShadow, emitChild);
+                            if (MaxComponent(emitted) > 0.0f)
+                                chunkRadiance[chunk].push_back({ ray.pixel, emitted });
+                        }
+                    });
+                    runBegin = runEnd;
+                }
+            });
+            Compact(chunkShadows, shadowRays);
+            Compact(chunkRays, nextRays);
+            accumulate();
+            stats.shadeMs += ElapsedMs(stageStart);
+
+            // Shadow: any-hit queries for every light sample of the wave
+            stageStart = std::chrono::steady_clock::now();
+            chunkCount = ChunkCountFor(shadowRays.size(), threadCount);
+            ParallelChunks(shadowRays.size(), chunkCount, threadCount, [&](size_t chunk, size_t begin, size_t end)
+            {
+                std::vector<CpuPendingChunk> pending;
+                for (size_t i = begin; i < end; i++)
+                {
+                    const ShadowRay& shadow = shadowRays[i];
+                    const bool occluded = streaming
+                        ? accelerationStructure.IsOccludedResident(shadow.origin, shadow.direction, 0.0f, shadow.tMax, pending)
+                        : accelerationStructure.IsOccluded(shadow.origin, shadow.direction, 0.0f, shadow.tMax);
+                    if (!pending.empty())
+                    {
+                        for (const CpuPendingChunk& waiting : pending)
+                            chunkDeferred[chunk].push_back({ static_cast<uint32_t>(i), waiting });
+                        pending.clear();
+                    }
+                    else if (!occluded)
+                    {
+                        chunkRadiance[chunk].push_back({ shadow.pixel, shadow.contribution });
+                    }
+                }
+            });
+            stats.shadowRays += shadowRays.size();
+
+            Compact(chunkDeferred, deferred);
+            ResolveDeferred(deferred, streamer, threadCount, stats,
+                [&](size_t chunk, const DeferredQuery* first, const DeferredQuery* last)
+                {
+                    const ShadowRay& shadow = shadowRays[first->query];
+                    for (const DeferredQuery* query = first; query != last; query++)
+                    {
+                        if (accelerationStructure.IsOccludedPending(shadow.origin, shadow.direction, 0.0f, shadow.tMax, query->chunk))
+                            return;
+                    }
+                    chunkRadiance[chunk].push_back({ shadow.pixel, shadow.contribution });
+                });
+            accumulate();
+            stats.shadowMs += ElapsedMs(stageStart);
+            if (streaming)
+                streamer.EndPass();
+
+            rays.swap(nextRays);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "CpuAccelerationStructure.h"
+#include "EnvironmentMap.h"
+#include "FrameSink.h"
+#include "LightBvh.h"
+
+// ============================================
+// CPU path tracer
+// ============================================
+//
+// Software backend over CpuAccelerationStructure with the same scene inputs as the GPU
+// pipeline (environment map, lights, light attenuation, materials). Two schedules share one
+// shading kernel and one per-path random sequence, so they trace the same paths:
+//
+// - DepthFirst: each pixel sample walks its own work stack, like RayGen.hlsl's WorkQueue.
+//   The stack holds WORK_STACK_SIZE (8) rays like the GPU queue, and a child that does not
+//   fit is dropped (counted in CpuPathTracerStats::droppedRays). A sample has at most
+//   maxBounces + 1 rays pending, so this only happens from 8 bounces on, when glass splits
+//   the path at every bounce; the image then loses that energy and differs from Wavefront.
+// - Wavefront: every live ray of the frame is processed stage by stage (generate, extend,
+//   shade, shadow). Rays are compacted into global queues between stages and hits are
+//   sorted by BSDF kind, object type and material before shading, so each kernel runs over
+//   a coherent batch even after glass has split paths into reflect/refract children.
+//
+// Shading is split by BSDF kind (smooth glass, rough glass, conductor, opaque, mixed metallic),
+// each a compile-time specialization of one kernel without the lobes it does not have. The
+// wavefront shade stage runs each kind's kernel over its run of the sorted queue.
+//
+// Direct light is sampled at every opaque hit and combined with the continuation ray by
+// multiple importance sampling (power heuristic). Emissive spheres and boxes are lights: one
+// of them is picked per hit through a LightBvh and sampled by solid angle, and a continuation
+// ray that hits one instead is weighted against that. Spherical area lights are not geometry,
+// so each gets a light sample and a diffuse BSDF sample of its own. Point lights without a
+// radius and directional lights stay plain light samples.
+//
+// Paths end at maxBounces or earlier by Russian roulette: past russianRouletteMinDepth a
+// continuation ray survives with probability equal to its largest throughput component and
+// is divided by it, so dim paths stop early without biasing the image.
+//
+// Paged (out-of-core) meshes are streamed in chunk by chunk. A wavefront ray that reaches
+// a chunk still on disk is parked in that chunk's queue with its closest resident hit and
+// resumes once the chunk has loaded, while the rest of the wave keeps tracing; depth-first
+// rays simply wait for the load. Both give the same hits as in-memory geometry.
+
+namespace RayTraceVS::DXEngine
+{
+    class Scene;
+
+    enum class CpuTraceMode
+    {
+        DepthFirst,
+        Wavefront
+    };
+
+    struct CpuPathTracerSettings
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t samplesPerPixel = 1;
+        uint32_t maxBounces = 4;
+        uint32_t russianRouletteMinDepth = 3;   // Bounces before Russian roulette may end a path
+        uint32_t frameIndex = 0;        // Advances the sample sequence between frames (Sampler.h)
+        uint32_t threadCount = 0;       // 0 = hardware concurrency
+        CpuTraceMode mode = CpuTraceMode::Wavefront;
+    };
+
+    struct CpuPathTracerStats
+    {
+        uint64_t extensionRays = 0;     // Closest-hit queries (camera and bounce rays)
+        uint64_t shadowRays = 0;        // Any-hit queries
+        uint32_t waves = 0;             // Wavefront iterations (0 in DepthFirst mode)
+        uint32_t maxQueueLength = 0;    // Largest extension queue of a wave
+        uint64_t deferredRays = 0;      // Wavefront queries that waited for paged geometry to load
+        uint64_t droppedRays = 0;       // DepthFirst children dropped because the work stack was full
+        uint32_t bvhBuilds = 0;         // Procedural/top-level BVHs built from scratch this frame
+        uint32_t bvhRefits = 0;         // ... and refitted in place
+        double buildMs = 0.0;           // Acceleration structure updates
+        double generateMs = 0.0;
+        double extendMs = 0.0;
+        double sortMs = 0.0;
+        double shadeMs = 0.0;
+        double shadowMs = 0.0;
+        double streamWaitMs = 0.0;      // Blocked on paged geometry loads (part of extend/shadow)
+        double totalMs = 0.0;
+    };
+
+    class CpuPathTracer
+    {
+    public:
+        // Renders linear HDR radiance (width * height, alpha = 1). Acceleration structures
+        // are updated from the scene's change tracking, so repeated frames only pay for edits:
+        // moved primitives and instances are refitted in place (see CpuAccelerationStructure).
+        bool Render(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<DirectX::XMFLOAT4>& radiance);
+        // Same, written straight into caller memory (Rgba32Float, settings.width x settings.height,
+        // any row pitch), e.g. a FrameSink buffer
+        bool Render(const Scene& scene, const CpuPathTracerSettings& settings, const FrameBufferView& target);
+
+        const CpuPathTracerStats& GetStats() const { return stats; }
+        const CpuAccelerationStructure& GetAccelerationStructure() const { return accelerationStructure; }
+        const EnvironmentMap& GetEnvironment() const { return environment; }
+
+        // Byte budget of mesh BLASes cached for geometry the scene no longer uses
+        void SetMeshResidencyBudget(uint64_t budgetBytes) { accelerationStructure.SetMeshResidencyBudget(budgetBytes); }
+        // Byte budget of paged geometry chunks kept in memory between waves/frames
+        void SetGeometryStreamingBudget(uint64_t budgetBytes) { accelerationStructure.SetGeometryStreamingBudget(budgetBytes); }
+
+    private:
+        void UpdateAccelerationStructure(const Scene& scene);
+        void BuildEmitters(const Scene& scene);
+        void RenderDepthFirst(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<DirectX::XMFLOAT3>& accumulated);
+        void RenderWavefront(const Scene& scene, const CpuPathTracerSettings& settings, std::vector<DirectX::XMFLOAT3>& accumulated);
+
+        CpuAccelerationStructure accelerationStructure;
+        EnvironmentMap environment;
+        LightBvh emitters;                      // Emissive spheres and boxes (lights are sampled one by one)
+        std::vector<uint32_t> sphereEmitters;   // Per sphere / box: index into emitters, or LightBvh::INVALID_INDEX
+        std::vector<uint32_t> boxEmitters;
+        uint64_t lastGeneration = 0;
+        bool built = false;
+        CpuPathTracerStats stats;
+    };
+}
@@ -4,13 +4,11 @@
 #include "AccelerationStructure.h"
 #include "Denoiser/NRDDenoiser.h"
 #include "ShaderCache.h"
+#include "Sampler.h"
 #include "DebugLog.h"
 #include "Scene/Scene.h"
 #include "Scene/Camera.h"
 #include "Scene/Light.h"
-#include "Scene/Objects/Sphere.h"
-#include "Scene/Objects/Plane.h"
-#include "Scene/Objects/Box.h"
 #include <d3dcompiler.h>
 #include <d3d12sdklayers.h>
 #include <dxcapi.h>
@@ -19,11 +17,13 @@
 #include <string>
 #include <fstream>
 #include <map>
-#include <wincodec.h>
+#include <unordered_map>
+#include <chrono>
+#include <climits>
+#include <cstring>
 
 #pragma comment(lib, "dxcompiler.lib")
 #pragma comment(lib, "d3dcompiler.lib")
-#pragma comment(lib, "windowscodecs.lib")
 
 namespace RayTraceVS::DXEngine
 {
@@ -39,6 +39,20 @@ namespace RayTraceVS::DXEngine
         return result;
     }
 
+    static GPUMeshMaterial ToGPUMeshMaterial(const MeshMaterial& material)
+    {
+        GPUMeshMaterial mat = {};
+        mat.Color = material.color;
+        mat.Metallic = material.metallic;
+        mat.Roughness = material.roughness;
+        mat.Transmission = material.transmission;
+        mat.IOR = material.ior;
+        mat.Specular = material.specular;
+        mat.Emission = material.emission;
+        mat.Absorption = material.absorption;
+        return mat;
+    }
+
     static void SetCommandListName(ID3D12GraphicsCommandList* commandList, const wchar_t* name)
     {
         if (commandList && name)
@@ -366,7 +380,7 @@ namespace RayTraceVS::DXEngine
     bool DXRPipeline::Initialize()
     {
         // Enable log file in Debug builds so initialization failures (NRD, shaders, etc.)
-        // are visible in C:\git\RayTraceVS\debug.log.
+        // are visible in the log file (C:\git\RayTraceVS\debug.log unless SetLogFilePath was called).
 #if defined(_DEBUG)
         SetLogEnabled(1);
 #endif
@@ -392,12 +406,13 @@ namespace RayTraceVS::DXEngine
         }
         LOG_INFO("Shader cache initialized");
         
-        // Pre-compile all shaders if needed (first run or driver change)
+        // Load/compile all shaders on worker threads. Each pipeline below waits only
+        // for the shaders it uses (RayTraceCompute, the DXR libraries, Composite, ...)
         if (shaderCache->NeedsRecompilation())
         {
-            LOG_INFO("Shaders need compilation, pre-compiling all...");
-            shaderCache->PrecompileAll();
+            LOG_INFO("Shaders need compilation, compiling in background...");
         }
+        shaderCache->PrecompileAllAsync();
         
         // Always create compute pipeline (fallback)
         bool computeResult = CreateComputePipeline();
@@ -431,8 +446,11 @@ namespace RayTraceVS::DXEngine
     
     void DXRPipeline::Render(RenderTarget* renderTarget, Scene* scene)
     {
+        frameStats = FrameStats();
+        timestampsResolved = false;
+
         // If scene has no geometry, use compute path to render sky/background safely
-        if (scene && scene->GetObjects().empty() && scene->GetMeshInstances().empty())
+        if (scene && !scene->HasPrimitives() && scene->GetMeshInstances().empty())
         {
             RenderWithComputeShader(renderTarget, scene);
             return;
@@ -441,6 +459,7 @@ namespace RayTraceVS::DXEngine
         if (dxrPipelineReady)
         {
             RenderWithDXR(renderTarget, scene);
+            ResolveTimestamps();
         }
         else
         {
@@ -614,10 +633,10 @@ namespace RayTraceVS::DXEngine
         if (!device)
             return false;
 
-        const UINT maxSpheres = 32;
+        const UINT maxSpheres = MAX_SCENE_SPHERES;
         const UINT maxPlanes = 32;
-        const UINT maxBoxes = 32;
-        const UINT maxLights = 8;
+        const UINT maxBoxes = MAX_SCENE_BOXES;
+        const UINT maxLights = MAX_SCENE_LIGHTS;
 
         CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
         CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
@@ -703,6 +722,42 @@ namespace RayTraceVS::DXEngine
             return false;
         }
 
+        // Create light BVH buffers (nodes and emitters, rebuilt when lights or emissive primitives change)
+        CD3DX12_RESOURCE_DESC lightBvhNodeDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(GPULightBvhNode) * MAX_LIGHT_BVH_NODES);
+        CD3DX12_RESOURCE_DESC lightEmitterDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(GPULightEmitter) * MAX_LIGHT_EMITTERS);
+
+        hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &lightBvhNodeDesc,
+            D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&lightBvhNodeBuffer));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create light BVH node buffer", hr);
+            return false;
+        }
+        resourceStateTracker.RegisterResource(lightBvhNodeBuffer.Get(), D3D12_RESOURCE_STATE_COMMON);
+        hr = device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &lightBvhNodeDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&lightBvhNodeUploadBuffer));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create light BVH node upload buffer", hr);
+            return false;
+        }
+
+        hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &lightEmitterDesc,
+            D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&lightEmitterBuffer));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create light emitter buffer", hr);
+            return false;
+        }
+        resourceStateTracker.RegisterResource(lightEmitterBuffer.Get(), D3D12_RESOURCE_STATE_COMMON);
+        hr = device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &lightEmitterDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&lightEmitterUploadBuffer));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create light emitter upload buffer", hr);
+            return false;
+        }
+
         return true;
     }
 
@@ -778,7 +833,7 @@ namespace RayTraceVS::DXEngine
         mappedConstantData->ShadowAbsorptionScale = scene->GetShadowAbsorptionScale();
         static UINT s_frameCounter = 0;
         mappedConstantData->FrameIndex = s_frameCounter++;  // Increment each render call
-        mappedConstantData->ShadowPadding = 0;
+        mappedConstantData->RussianRouletteMinDepth = static_cast<UINT>((std::max)(scene->GetRussianRouletteMinDepth(), 0));
         
         // Light attenuation parameters (P1-1: Physical-based)
         mappedConstantData->LightAttenuationConstant = scene->GetLightAttenuationConstant();
@@ -801,110 +856,112 @@ namespace RayTraceVS::DXEngine
         XMStoreFloat4x4(&mappedConstantData->ViewProjection, XMMatrixTranspose(viewProj));
         XMStoreFloat4x4(&mappedConstantData->PrevViewProjection, XMMatrixTranspose(prevViewProj));
 
-        // Get objects from scene
-        const auto& objects = scene->GetObjects();
+        // Get primitives from scene (SoA pools: geometry and material are separate arrays)
+        const SpherePool& spherePool = scene->GetSpheres();
+        const PlanePool& planePool = scene->GetPlanes();
+        const BoxPool& boxPool = scene->GetBoxes();
         const auto& lights = scene->GetLights();
 
-        std::vector<GPUSphere> spheres;
-        std::vector<GPUPlane> planes;
-        std::vector<GPUBox> Boxes;
+        std::vector<GPUSphere> spheres(spherePool.Size());
+        std::vector<GPUPlane> planes(planePool.Size());
+        std::vector<GPUBox> Boxes(boxPool.Size());
         std::vector<GPULight> gpuLights;
 
-        for (const auto& obj : objects)
-        {
-            if (auto sphere = dynamic_cast<Sphere*>(obj.get()))
-            {
-                GPUSphere gs;
-                gs.Center = sphere->GetCenter();
-                gs.Radius = sphere->GetRadius();
-                const Material& mat = sphere->GetMaterial();
-                gs.Color = mat.color;
-                gs.Metallic = mat.metallic;
-                gs.Roughness = mat.roughness;
-                gs.Transmission = mat.transmission;
-                gs.IOR = mat.ior;
-                gs.Specular = mat.specular;
-                gs.Padding1 = 0;
-                gs.Padding2 = 0;
-                gs.Padding3 = 0;
-                gs.Emission = mat.emission;
-                gs.Padding4 = 0;
-                gs.Absorption = mat.absorption;
-                gs.Padding5 = 0;
-                spheres.push_back(gs);
-            }
-            else if (auto plane = dynamic_cast<Plane*>(obj.get()))
-            {
-                GPUPlane gp;
-                gp.Position = plane->GetPosition();
-                gp.Normal = plane->GetNormal();
-                const Material& mat = plane->GetMaterial();
-                gp.Color = mat.color;
-                gp.Metallic = mat.metallic;
-                gp.Roughness = mat.roughness;
-                gp.Transmission = mat.transmission;
-                gp.IOR = mat.ior;
-                gp.Specular = mat.specular;
-                gp.Padding1 = 0;
-                gp.Emission = mat.emission;
-                gp.Padding2 = 0;
-                gp.Absorption = mat.absorption;
-                gp.Padding3 = 0;
-                planes.push_back(gp);
-            }
-            else if (auto box = dynamic_cast<Box*>(obj.get()))
+        for (size_t i = 0; i < spherePool.Size(); i++)
+        {
+            const SphereGeometry& geom = spherePool.geometry[i];
+            const ObjectMaterial& mat = spherePool.materials[i];
+            GPUSphere& gs = spheres[i];
+            gs.Center = geom.center;
+            gs.Radius = geom.radius;
+            gs.Color = mat.color;
+            gs.Metallic = mat.metallic;
+            gs.Roughness = mat.roughness;
+            gs.Transmission = mat.transmission;
+            gs.IOR = mat.ior;
+            gs.Specular = mat.specular;
+            gs.Padding1 = 0;
+            gs.Padding2 = 0;
+            gs.Padding3 = 0;
+            gs.Emission = mat.emission;
+            gs.Padding4 = 0;
+            gs.Absorption = mat.absorption;
+            gs.Padding5 = 0;
+        }
+
+        for (size_t i = 0; i < planePool.Size(); i++)
+        {
+            const PlaneGeometry& geom = planePool.geometry[i];
+            const ObjectMaterial& mat = planePool.materials[i];
+            GPUPlane& gp = planes[i];
+            gp.Position = geom.position;
+            gp.Normal = geom.normal;
+            gp.Color = mat.color;
+            gp.Metallic = mat.metallic;
+            gp.Roughness = mat.roughness;
+            gp.Transmission = mat.transmission;
+            gp.IOR = mat.ior;
+            gp.Specular = mat.specular;
+            gp.Padding1 = 0;
+            gp.Emission = mat.emission;
+            gp.Padding2 = 0;
+            gp.Absorption = mat.absorption;
+            gp.Padding3 = 0;
+        }
+
+        for (size_t i = 0; i < boxPool.Size(); i++)
+        {
+            const BoxGeometry& geom = boxPool.geometry[i];
+            const ObjectMaterial& mat = boxPool.materials[i];
+            GPUBox& gb = Boxes[i];
+            gb.Center = geom.center;
+            gb.Padding1 = 0;
+            gb.Size = geom.size;
+            gb.Padding2 = 0;
+            // OBB local axes
+            gb.AxisX = geom.axisX;
+            gb.Padding3 = 0;
+            gb.AxisY = geom.axisY;
+            gb.Padding4 = 0;
+            gb.AxisZ = geom.axisZ;
+            gb.Padding5 = 0;
+            gb.Color = mat.color;
+            gb.Metallic = mat.metallic;
+            gb.Roughness = mat.roughness;
+            gb.Transmission = mat.transmission;
+            gb.IOR = mat.ior;
+            gb.Specular = mat.specular;
+            gb.Padding6 = 0;
+            gb.Padding7 = 0;
+            gb.Padding8 = 0;
+            gb.Emission = mat.emission;
+            gb.Padding9 = 0;
+            gb.Absorption = mat.absorption;
+            gb.Padding10 = 0;
+            
+            // DEBUG: Log box axes orthonormality check
+            if (IsLogLevelEnabled(LogLevel::Info))
             {
-                GPUBox gb;
-                gb.Center = box->GetCenter();
-                gb.Padding1 = 0;
-                gb.Size = box->GetSize();
-                gb.Padding2 = 0;
-                // OBB local axes
-                gb.AxisX = box->GetAxisX();
-                gb.Padding3 = 0;
-                gb.AxisY = box->GetAxisY();
-                gb.Padding4 = 0;
-                gb.AxisZ = box->GetAxisZ();
-                gb.Padding5 = 0;
-                const Material& mat = box->GetMaterial();
-                gb.Color = mat.color;
-                gb.Metallic = mat.metallic;
-                gb.Roughness = mat.roughness;
-                gb.Transmission = mat.transmission;
-                gb.IOR = mat.ior;
-                gb.Specular = mat.specular;
-                gb.Padding6 = 0;
-                gb.Padding7 = 0;
-                gb.Padding8 = 0;
-                gb.Emission = mat.emission;
-                gb.Padding9 = 0;
-                gb.Absorption = mat.absorption;
-                gb.Padding10 = 0;
-                
-                // DEBUG: Log box axes orthonormality check
-                char debugBuf[512];
                 float lenX = sqrtf(gb.AxisX.x * gb.AxisX.x + gb.AxisX.y * gb.AxisX.y + gb.AxisX.z * gb.AxisX.z);
                 float lenY = sqrtf(gb.AxisY.x * gb.AxisY.x + gb.AxisY.y * gb.AxisY.y + gb.AxisY.z * gb.AxisY.z);
                 float lenZ = sqrtf(gb.AxisZ.x * gb.AxisZ.x + gb.AxisZ.y * gb.AxisZ.y + gb.AxisZ.z * gb.AxisZ.z);
                 float dotXY = gb.AxisX.x * gb.AxisY.x + gb.AxisX.y * gb.AxisY.y + gb.AxisX.z * gb.AxisY.z;
                 float dotXZ = gb.AxisX.x * gb.AxisZ.x + gb.AxisX.y * gb.AxisZ.y + gb.AxisX.z * gb.AxisZ.z;
                 float dotYZ = gb.AxisY.x * gb.AxisZ.x + gb.AxisY.y * gb.AxisZ.y + gb.AxisY.z * gb.AxisZ.z;
-                sprintf_s(debugBuf, "BOX[%zu] Axes: lenX=%.4f, lenY=%.4f, lenZ=%.4f, dotXY=%.4f, dotXZ=%.4f, dotYZ=%.4f", 
-                    Boxes.size(), lenX, lenY, lenZ, dotXY, dotXZ, dotYZ);
-                LOG_INFO(debugBuf);
-                sprintf_s(debugBuf, "BOX[%zu] AxisX=(%.4f,%.4f,%.4f) AxisY=(%.4f,%.4f,%.4f) AxisZ=(%.4f,%.4f,%.4f)", 
-                    Boxes.size(), gb.AxisX.x, gb.AxisX.y, gb.AxisX.z, gb.AxisY.x, gb.AxisY.y, gb.AxisY.z, gb.AxisZ.x, gb.AxisZ.y, gb.AxisZ.z);
-                LOG_INFO(debugBuf);
-                sprintf_s(debugBuf, "BOX[%zu] Material: BaseColor=(%.3f,%.3f,%.3f) Metallic=%.3f Roughness=%.3f Transmission=%.3f IOR=%.3f Specular=%.3f",
-                    Boxes.size(), gb.Color.x, gb.Color.y, gb.Color.z, gb.Metallic, gb.Roughness, gb.Transmission, gb.IOR, gb.Specular);
-                LOG_INFO(debugBuf);
-                
-                Boxes.push_back(gb);
+                LOG_INFOF("BOX[%zu] Axes: lenX=%.4f, lenY=%.4f, lenZ=%.4f, dotXY=%.4f, dotXZ=%.4f, dotYZ=%.4f", 
+                    i, lenX, lenY, lenZ, dotXY, dotXZ, dotYZ);
+                LOG_INFOF("BOX[%zu] AxisX=(%.4f,%.4f,%.4f) AxisY=(%.4f,%.4f,%.4f) AxisZ=(%.4f,%.4f,%.4f)", 
+                    i, gb.AxisX.x, gb.AxisX.y, gb.AxisX.z, gb.AxisY.x, gb.AxisY.y, gb.AxisY.z, gb.AxisZ.x, gb.AxisZ.y, gb.AxisZ.z);
+                LOG_INFOF("BOX[%zu] Material: BaseColor=(%.3f,%.3f,%.3f) Metallic=%.3f Roughness=%.3f Transmission=%.3f IOR=%.3f Specular=%.3f",
+                    i, gb.Color.x, gb.Color.y, gb.Color.z, gb.Metallic, gb.Roughness, gb.Transmission, gb.IOR, gb.Specular);
             }
         }
 
         for (const auto& light : lights)
         {
+            // Lights past the buffer capacity are dropped (the light BVH uses the same limit)
+            if (gpuLights.size() == MAX_SCENE_LIGHTS)
+                break;
             GPULight gl;
             gl.Position = light.GetPosition();
             gl.Intensity = light.GetIntensity();
@@ -943,6 +1000,38 @@ namespace RayTraceVS::DXEngine
         mappedConstantData->NumBoxes = (UINT)Boxes.size();
         mappedConstantData->NumLights = (UINT)gpuLights.size();
 
+        // Light BVH: rebuilt when lights, emissive primitives or attenuation change
+        const bool lightBvhDirty = (scene != lightBvhScene) ||
+            (scene->GetChangesSince(lightBvhGeneration) &
+             (SceneChange_Geometry | SceneChange_Materials | SceneChange_Lights | SceneChange_Settings)) != 0;
+        if (lightBvhDirty)
+        {
+            LightBvhLimits limits;
+            limits.maxLights = MAX_SCENE_LIGHTS;
+            limits.maxSpheres = MAX_SCENE_SPHERES;
+            limits.maxBoxes = MAX_SCENE_BOXES;
+            lightBvh.Build(*scene, limits);
+            lightBvhScene = scene;
+            lightBvhGeneration = scene->GetGeneration();
+        }
+        const auto& lightEmitters = lightBvh.GetEmitters();
+        const auto& lightBvhNodes = lightBvh.GetNodes();
+        mappedConstantData->NumLightEmitters = (UINT)lightEmitters.size();
+        mappedConstantData->NumDirectionalEmitters = lightBvh.GetDirectionalCount();
+        mappedConstantData->LightBvhNodeCount = (UINT)lightBvhNodes.size();
+        mappedConstantData->AmbientLight = lightBvh.GetAmbient();
+        mappedConstantData->AmbientPadding = 0.0f;
+
+        // Environment map: the table is only reloaded when the scene names another file
+        if (environmentMap.Update(*scene) && !UploadEnvironmentMap(commandList))
+        {
+            LOG_WARN("UpdateSceneData: Failed to upload the environment map - the sky will be black");
+        }
+        mappedConstantData->EnvironmentWidth = environmentTexture ? environmentMap.GetWidth() : 0;
+        mappedConstantData->EnvironmentHeight = environmentTexture ? environmentMap.GetHeight() : 0;
+        mappedConstantData->EnvironmentIntensity = environmentMap.GetIntensity();
+        mappedConstantData->EnvironmentLighting = environmentMap.GetLighting() ? 1u : 0u;
+
         // Check if object counts changed - trigger acceleration structure rebuild
         UINT currentSphereCount = (UINT)spheres.size();
         UINT currentPlaneCount = (UINT)planes.size();
@@ -1080,6 +1169,38 @@ namespace RayTraceVS::DXEngine
             TransitionToSrv(lightBuffer.Get());
             resourceStateTracker.Flush(commandList);
         }
+
+        if (lightBvhDirty && !lightEmitters.empty() && lightEmitterUploadBuffer && lightBvhNodeUploadBuffer)
+        {
+            TransitionForCopy(lightEmitterBuffer.Get());
+            TransitionForCopy(lightBvhNodeBuffer.Get());
+            resourceStateTracker.Flush(commandList);
+
+            void* mapped = nullptr;
+            if (SUCCEEDED(lightEmitterUploadBuffer->Map(0, nullptr, &mapped)) && mapped)
+            {
+                memcpy(mapped, lightEmitters.data(), sizeof(GPULightEmitter) * lightEmitters.size());
+                lightEmitterUploadBuffer->Unmap(0, nullptr);
+            }
+            commandList->CopyBufferRegion(lightEmitterBuffer.Get(), 0, lightEmitterUploadBuffer.Get(), 0,
+                sizeof(GPULightEmitter) * lightEmitters.size());
+
+            if (!lightBvhNodes.empty())
+            {
+                mapped = nullptr;
+                if (SUCCEEDED(lightBvhNodeUploadBuffer->Map(0, nullptr, &mapped)) && mapped)
+                {
+                    memcpy(mapped, lightBvhNodes.data(), sizeof(GPULightBvhNode) * lightBvhNodes.size());
+                    lightBvhNodeUploadBuffer->Unmap(0, nullptr);
+                }
+                commandList->CopyBufferRegion(lightBvhNodeBuffer.Get(), 0, lightBvhNodeUploadBuffer.Get(), 0,
+                    sizeof(GPULightBvhNode) * lightBvhNodes.size());
+            }
+
+            TransitionToSrv(lightEmitterBuffer.Get());
+            TransitionToSrv(lightBvhNodeBuffer.Get());
+            resourceStateTracker.Flush(commandList);
+        }
         
         // ============================================
         // Mesh Buffer Processing (FBX Support)
@@ -1097,26 +1218,38 @@ namespace RayTraceVS::DXEngine
         
         mappedConstantData->NumMeshInstances = currentMeshInstanceCount;
         
-        if (!meshCaches.empty() && !meshInstances.empty())
+        // The buffers below only depend on mesh caches, instances and their materials
+        const bool meshBuffersDirty = (scene != meshBufferScene) ||
+            (scene->GetChangesSince(meshBufferGeneration) &
+             (SceneChange_MeshCaches | SceneChange_MeshInstances | SceneChange_MeshMaterials)) != 0;
+        meshBufferScene = scene;
+        meshBufferGeneration = scene->GetGeneration();
+
+        if (meshBuffersDirty && !meshCaches.empty() && !meshInstances.empty())
         {
             // Build combined vertex/index buffers and mesh info
             std::vector<GPUMeshVertex> allVertices;
             std::vector<uint32_t> allIndices;
             std::vector<GPUMeshInfo> meshInfos;
-            std::map<std::string, UINT> meshTypeIndexMap;  // meshName -> index in meshInfos
+            std::map<std::string, UINT> meshTypeIndexMap;  // Mesh content key -> index in meshInfos
             
             UINT vertexOffset = 0;
             UINT indexOffset = 0;
             
-            for (const auto& [name, cache] : meshCaches)
+            // One copy per unique geometry; aliases resolve to the same mesh type. Geometry
+            // without in-memory data (paged meshes) gets no BLAS, so no instance refers to it.
+            for (const auto& [key, cache] : meshCaches)
             {
+                if (cache.vertices.empty() || cache.indices.empty())
+                    continue;
+
                 GPUMeshInfo info = {};
                 info.VertexOffset = vertexOffset;
                 info.IndexOffset = indexOffset;
                 info.VertexCount = static_cast<UINT>(cache.vertices.size() / 8);  // 8 floats per vertex
                 info.IndexCount = static_cast<UINT>(cache.indices.size());
                 
-                meshTypeIndexMap[name] = static_cast<UINT>(meshInfos.size());
+                meshTypeIndexMap[key] = static_cast<UINT>(meshInfos.size());
                 meshInfos.push_back(info);
                 
                 // Copy vertices (already in GPUMeshVertex format: 8 floats = 32 bytes)
@@ -1137,37 +1270,38 @@ namespace RayTraceVS::DXEngine
                 indexOffset += info.IndexCount;
             }
             
-            // Build instance info and materials
+            // Build instance info and the material table. The scene deduplicates materials by value,
+            // so instances sharing a material (the common case with many instances) share one entry.
             std::vector<GPUMeshInstanceInfo> instanceInfos;
             std::vector<GPUMeshMaterial> materials;
+            std::unordered_map<std::string, UINT> meshTypeByName;   // Mesh name -> index in meshInfos (UINT_MAX = none)
+            instanceInfos.reserve(meshInstances.size());
+            materials.reserve(scene->GetMeshMaterials().size());
+            for (const MeshMaterial& material : scene->GetMeshMaterials())
+            {
+                materials.push_back(ToGPUMeshMaterial(material));
+            }
             
-            for (const auto& inst : meshInstances)
+            for (size_t instanceIndex = 0; instanceIndex < meshInstances.size(); instanceIndex++)
             {
-                auto it = meshTypeIndexMap.find(inst.meshName);
-                if (it == meshTypeIndexMap.end())
+                const MeshInstance& inst = meshInstances[instanceIndex];
+                auto [nameIt, newName] = meshTypeByName.try_emplace(inst.meshName, UINT_MAX);
+                if (newName)
+                {
+                    const std::string* meshKey = scene->FindMeshKey(inst.meshName);
+                    auto it = meshKey ? meshTypeIndexMap.find(*meshKey) : meshTypeIndexMap.end();
+                    if (it != meshTypeIndexMap.end())
+                        nameIt->second = it->second;
+                }
+                if (nameIt->second == UINT_MAX)
                     continue;  // Skip if mesh not found
                 
                 GPUMeshInstanceInfo instInfo = {};
-                instInfo.MeshTypeIndex = it->second;
-                instInfo.MaterialIndex = static_cast<UINT>(materials.size());
+                instInfo.MeshTypeIndex = nameIt->second;
+                instInfo.MaterialIndex = scene->GetMeshMaterialIndex(instanceIndex);
                 instanceInfos.push_back(instInfo);
-                
-                GPUMeshMaterial mat = {};
-                mat.Color = inst.material.color;
-                mat.Metallic = inst.material.metallic;
-                mat.Roughness = inst.material.roughness;
-                mat.Transmission = inst.material.transmission;
-                mat.IOR = inst.material.ior;
-                mat.Specular = inst.material.specular;
-                mat.Padding1 = 0;
-                mat.Padding2 = 0;
-                mat.Emission = inst.material.emission;
-                mat.Padding3 = 0;
-                mat.Padding4 = 0;
-                mat.Absorption = inst.material.absorption;
-                mat.Padding5 = 0;
-                materials.push_back(mat);
             }
+            LOG_DEBUGF("UpdateSceneData: %zu mesh instances share %zu materials", instanceInfos.size(), materials.size());
             
             // Create/Update GPU buffers
             CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
@@ -1356,7 +1490,7 @@ namespace RayTraceVS::DXEngine
         cpuHandle.Offset(1, srvUavDescriptorSize);
 
         // SRV for lights
-        srvDesc.Buffer.NumElements = 8;
+        srvDesc.Buffer.NumElements = MAX_SCENE_LIGHTS;
         srvDesc.Buffer.StructureByteStride = sizeof(GPULight);
         device->CreateShaderResourceView(lightBuffer.Get(), &srvDesc, cpuHandle);
 
@@ -1369,7 +1503,7 @@ namespace RayTraceVS::DXEngine
         commandList->SetDescriptorHeaps(1, heaps);
 
         // If scene is empty, clear output to sky color to avoid stale frame
-        if (scene->GetObjects().empty() && scene->GetMeshInstances().empty())
+        if (!scene->HasPrimitives() && scene->GetMeshInstances().empty())
         {
             if (!computeUavCpuHeap)
             {
@@ -1514,93 +1648,18 @@ namespace RayTraceVS::DXEngine
         commandList->ResourceBarrier(1, &barrier);
     }
 
-    bool DXRPipeline::LoadBlueNoiseTexture(ID3D12GraphicsCommandList* commandList)
+    bool DXRPipeline::UploadBlueNoiseRanks(ID3D12GraphicsCommandList* commandList)
     {
         if (blueNoiseReady)
             return true;
         if (!commandList)
             return false;
 
-        const std::wstring texturePath = L"C:\\git\\RayTraceVS\\Resource\\Texture\\BlueNoise16.png";
-
-        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-        const bool coInitOk = SUCCEEDED(hr);
-        if (FAILED(hr) && hr != RPC_E_CHANGED_MODE)
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: CoInitializeEx failed");
-            return false;
-        }
-
-        ComPtr<IWICImagingFactory> factory;
-        hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to create WIC factory");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
-
-        ComPtr<IWICBitmapDecoder> decoder;
-        hr = factory->CreateDecoderFromFilename(texturePath.c_str(), nullptr, GENERIC_READ,
-            WICDecodeMetadataCacheOnLoad, &decoder);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to open BlueNoise16.png");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
-
-        ComPtr<IWICBitmapFrameDecode> frame;
-        hr = decoder->GetFrame(0, &frame);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to get PNG frame");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
-
-        UINT width = 0;
-        UINT height = 0;
-        frame->GetSize(&width, &height);
-        if (width != 16 || height != 16)
-        {
-            LOG_WARN("LoadBlueNoiseTexture: Expected 16x16 BlueNoise16.png");
-        }
-
-        ComPtr<IWICFormatConverter> converter;
-        hr = factory->CreateFormatConverter(&converter);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to create format converter");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
-
-        hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA,
-            WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to convert PNG to RGBA");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
-
-        const UINT pixelStride = 4;
-        const UINT rowSize = width * pixelStride;
-        std::vector<uint8_t> pixels(rowSize * height);
-        hr = converter->CopyPixels(nullptr, rowSize, static_cast<UINT>(pixels.size()), pixels.data());
-        if (FAILED(hr))
-        {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to read PNG pixels");
-            if (coInitOk)
-                CoUninitialize();
-            return false;
-        }
+        // Generated by the sampler, so RayGen and the CPU path tracer shift by the same ranks
+        const auto& pixels = Sampler::GetRankTile();
+        const UINT width = Sampler::RANK_TILE_SIZE;
+        const UINT height = Sampler::RANK_TILE_SIZE;
+        const UINT rowSize = width * 4;
 
         auto device = dxContext->GetDevice();
 
@@ -1616,7 +1675,7 @@ namespace RayTraceVS::DXEngine
         texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
         CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
-        hr = device->CreateCommittedResource(
+        HRESULT hr = device->CreateCommittedResource(
             &defaultHeapProps,
             D3D12_HEAP_FLAG_NONE,
             &texDesc,
@@ -1625,12 +1684,10 @@ namespace RayTraceVS::DXEngine
             IID_PPV_ARGS(&blueNoiseTexture));
         if (FAILED(hr))
         {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to create texture resource");
-            if (coInitOk)
-                CoUninitialize();
+            LOG_ERROR("UploadBlueNoiseRanks: Failed to create texture resource");
             return false;
         }
-        blueNoiseTexture->SetName(L"BlueNoise16");
+        blueNoiseTexture->SetName(L"BlueNoiseRanks");
 
         UINT64 uploadSize = 0;
         D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
@@ -1649,9 +1706,7 @@ namespace RayTraceVS::DXEngine
             IID_PPV_ARGS(&blueNoiseUpload));
         if (FAILED(hr))
         {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to create upload buffer");
-            if (coInitOk)
-                CoUninitialize();
+            LOG_ERROR("UploadBlueNoiseRanks: Failed to create upload buffer");
             return false;
         }
 
@@ -1659,9 +1714,7 @@ namespace RayTraceVS::DXEngine
         hr = blueNoiseUpload->Map(0, nullptr, &mapped);
         if (FAILED(hr))
         {
-            LOG_ERROR("LoadBlueNoiseTexture: Failed to map upload buffer");
-            if (coInitOk)
-                CoUninitialize();
+            LOG_ERROR("UploadBlueNoiseRanks: Failed to map upload buffer");
             return false;
         }
 
@@ -1691,9 +1744,127 @@ namespace RayTraceVS::DXEngine
         commandList->ResourceBarrier(1, &barrier);
 
         blueNoiseReady = true;
+        return true;
+    }
+
+
+    bool DXRPipeline::UploadEnvironmentMap(ID3D12GraphicsCommandList* commandList)
+    {
+        auto device = dxContext->GetDevice();
+        const UINT width = environmentMap.GetWidth();
+        const UINT height = environmentMap.GetHeight();
+        const auto& texels = environmentMap.GetTexels();
+        const auto& aliasTable = environmentMap.GetAliasTable();
+        if (width == 0 || height == 0 || aliasTable.empty())
+            return false;
+
+        D3D12_RESOURCE_DESC texDesc = {};
+        texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        texDesc.Width = width;
+        texDesc.Height = height;
+        texDesc.DepthOrArraySize = 1;
+        texDesc.MipLevels = 1;
+        texDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        texDesc.SampleDesc.Count = 1;
+        texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+        UINT64 uploadSize = 0;
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        UINT numRows = 0;
+        UINT64 rowSizeInBytes = 0;
+        device->GetCopyableFootprints(&texDesc, 0, 1, 0, &footprint, &numRows, &rowSizeInBytes, &uploadSize);
+        const UINT64 aliasSize = sizeof(GPUEnvironmentAliasEntry) * aliasTable.size();
+
+        // Resources are recreated only when the resolution changes
+        const bool sizeChanged = !environmentTexture ||
+            environmentTexture->GetDesc().Width != width || environmentTexture->GetDesc().Height != height;
+        if (sizeChanged)
+        {
+            environmentTexture.Reset();
+            environmentUpload.Reset();
+            environmentAliasBuffer.Reset();
+            environmentAliasUpload.Reset();
+
+            CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+            CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+            CD3DX12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadSize);
+            CD3DX12_RESOURCE_DESC aliasDesc = CD3DX12_RESOURCE_DESC::Buffer(aliasSize);
+
+            HRESULT hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+                D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&environmentTexture));
+            if (FAILED(hr))
+            {
+                LOG_ERROR_HR("UploadEnvironmentMap: Failed to create texture resource", hr);
+                return false;
+            }
+            environmentTexture->SetName(L"EnvironmentMap");
+            resourceStateTracker.RegisterResource(environmentTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+            hr = device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &uploadDesc,
+                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&environmentUpload));
+            if (SUCCEEDED(hr))
+            {
+                hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &aliasDesc,
+                    D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&environmentAliasBuffer));
+            }
+            if (SUCCEEDED(hr))
+            {
+                resourceStateTracker.RegisterResource(environmentAliasBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+                hr = device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &aliasDesc,
+                    D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&environmentAliasUpload));
+            }
+            if (FAILED(hr))
+            {
+                LOG_ERROR_HR("UploadEnvironmentMap: Failed to create upload or alias table buffers", hr);
+                environmentTexture.Reset();
+                return false;
+            }
+        }
+
+        void* mapped = nullptr;
+        if (FAILED(environmentUpload->Map(0, nullptr, &mapped)) || !mapped)
+        {
+            LOG_ERROR("UploadEnvironmentMap: Failed to map texture upload buffer");
+            return false;
+        }
+        uint8_t* dst = static_cast<uint8_t*>(mapped);
+        const size_t rowSize = sizeof(XMFLOAT4) * width;
+        for (UINT y = 0; y < height; ++y)
+        {
+            memcpy(dst + y * footprint.Footprint.RowPitch, texels.data() + static_cast<size_t>(y) * width, rowSize);
+        }
+        environmentUpload->Unmap(0, nullptr);
+
+        mapped = nullptr;
+        if (FAILED(environmentAliasUpload->Map(0, nullptr, &mapped)) || !mapped)
+        {
+            LOG_ERROR("UploadEnvironmentMap: Failed to map alias table upload buffer");
+            return false;
+        }
+        memcpy(mapped, aliasTable.data(), aliasSize);
+        environmentAliasUpload->Unmap(0, nullptr);
+
+        resourceStateTracker.Transition(environmentTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+        resourceStateTracker.Transition(environmentAliasBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+        resourceStateTracker.Flush(commandList);
+
+        D3D12_TEXTURE_COPY_LOCATION src = {};
+        src.pResource = environmentUpload.Get();
+        src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        src.PlacedFootprint = footprint;
+
+        D3D12_TEXTURE_COPY_LOCATION dstLoc = {};
+        dstLoc.pResource = environmentTexture.Get();
+        dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dstLoc.SubresourceIndex = 0;
 
-        if (coInitOk)
-            CoUninitialize();
+        commandList->CopyTextureRegion(&dstLoc, 0, 0, 0, &src, nullptr);
+        commandList->CopyBufferRegion(environmentAliasBuffer.Get(), 0, environmentAliasUpload.Get(), 0, aliasSize);
+
+        resourceStateTracker.Transition(environmentTexture.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        resourceStateTracker.Transition(environmentAliasBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        resourceStateTracker.Flush(commandList);
         return true;
     }
 
@@ -1732,6 +1903,7 @@ namespace RayTraceVS::DXEngine
         
         // Create acceleration structure object
         accelerationStructure = std::make_unique<AccelerationStructure>(dxContext);
+        accelerationStructure->SetMeshResidencyBudget(meshResidencyBudget);
         
         // Initialize photon mapping for caustics (disabled by default)
         if (causticsEnabled)
@@ -1781,8 +1953,10 @@ namespace RayTraceVS::DXEngine
         // [18-19] UAV - WorkItem queue (u12-u13)
         // [20-24] SRV - Mesh buffers (t5-t9)
         // [25] SRV - Blue noise texture (t10)
+        // [26-27] SRV - Light BVH nodes and emitters (t11-t12)
+        // [28-29] SRV - Environment map and its alias tables (t13-t14)
         
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[26];
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[30];
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);  // u0 - Output
         ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);  // t0 - TLAS
         ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);  // b0 - Constants
@@ -1811,15 +1985,32 @@ namespace RayTraceVS::DXEngine
         ranges[23].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 8);  // t8 - MeshInfos
         ranges[24].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 9);  // t9 - MeshInstances
         ranges[25].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 10); // t10 - BlueNoise
+        // Light BVH for many-light selection
+        ranges[26].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 11); // t11 - LightBvhNodes
+        ranges[27].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 12); // t12 - LightEmitters
+        // Environment map
+        ranges[28].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 13); // t13 - EnvironmentTex
+        ranges[29].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 14); // t14 - EnvironmentAlias
         
-        CD3DX12_ROOT_PARAMETER1 rootParameters[26];
-        for (int i = 0; i < 26; i++)
+        CD3DX12_ROOT_PARAMETER1 rootParameters[30];
+        for (int i = 0; i < 30; i++)
         {
             rootParameters[i].InitAsDescriptorTable(1, &ranges[i]);
         }
 
+        // s0: EnvironmentSampler (lat-long: wraps around the horizon, clamps at the poles)
+        D3D12_STATIC_SAMPLER_DESC environmentSampler = {};
+        environmentSampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+        environmentSampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        environmentSampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        environmentSampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        environmentSampler.MaxLOD = D3D12_FLOAT32_MAX;
+        environmentSampler.ShaderRegister = 0;
+        environmentSampler.RegisterSpace = 0;
+        environmentSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr,
+        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 1, &environmentSampler,
             D3D12_ROOT_SIGNATURE_FLAG_NONE);
 
         ComPtr<ID3DBlob> signature;
@@ -2052,7 +2243,8 @@ namespace RayTraceVS::DXEngine
         
         ComPtr<ID3DBlob> anyHitShadowShader;
         ComPtr<ID3DBlob> anyHitSkipSelfShader;
-        if (!LoadOrCompileDXRShader(L"RayGen", &rayGenShader) ||
+        // rayGenShader already holds the variant when a permutation is being built
+        if ((!rayGenShader && !LoadOrCompileDXRShader(L"RayGen", &rayGenShader)) ||
             !LoadOrCompileDXRShader(L"Miss", &missShader) ||
             !LoadOrCompileDXRShader(L"ClosestHit", &closestHitShader) ||
             !LoadOrCompileDXRShader(L"ClosestHit_Triangle", &closestHitTriangleShader) ||
@@ -2212,8 +2404,10 @@ namespace RayTraceVS::DXEngine
         // [18-19] UAVs: WorkItem queue (u12-u13)
         // [20-24] SRVs: Mesh buffers (t5-t9)
         // [25] SRV: Blue noise texture (t10)
+        // [26-27] SRVs: Light BVH nodes and emitters (t11-t12)
+        // [28-29] SRVs: Environment map and alias tables (t13-t14)
         D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-        heapDesc.NumDescriptors = 26;  // 18 + 2 + 5 + 1 (blue noise)
+        heapDesc.NumDescriptors = 30;  // 18 + 2 + 5 + 1 (blue noise) + 2 (light BVH) + 2 (environment)
         heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
@@ -2325,6 +2519,103 @@ namespace RayTraceVS::DXEngine
         return true;
     }
 
+    // ============================================
+    // RayGen Permutations
+    // ============================================
+
+    void DXRPipeline::SelectShaderPermutation(Scene* scene)
+    {
+        if (!shaderCache || !stateObject)
+            return;
+
+        ShaderFeatureInputs inputs;
+        inputs.apertureSize = mappedConstantData->ApertureSize;
+        inputs.photonMapSize = mappedConstantData->PhotonMapSize;
+        inputs.photonDebugMode = mappedConstantData->PhotonDebugMode;
+        inputs.meshInstanceCount = scene->GetMeshInstances().size();
+        inputs.denoiserActive = denoiserEnabled && denoiser && denoiser->IsReady();
+        const uint32_t required = SelectShaderFeatures(inputs);
+
+        if (required == activeShaderFeatures)
+            return;
+
+        // Until the minimal variant has compiled (in the background), keep the active
+        // variant if it still covers this frame, otherwise use the full one
+        uint32_t target = IsShaderFeatureSuperset(activeShaderFeatures, required) ?
+            activeShaderFeatures : static_cast<uint32_t>(ShaderFeature_All);
+        ComPtr<ID3DBlob> variantShader;
+        if (failedPermutations.count(required) == 0)
+        {
+            if (dxrPermutations.count(required) != 0 ||
+                shaderCache->TryGetShaderVariant(L"RayGen", required, &variantShader))
+            {
+                target = required;
+            }
+            else
+            {
+                shaderCache->RequestShaderVariant(L"RayGen", required);
+            }
+        }
+
+        if (target != activeShaderFeatures)
+        {
+            ActivateShaderPermutation(target, variantShader.Get());
+        }
+    }
+
+    bool DXRPipeline::ActivateShaderPermutation(uint32_t features, ID3DBlob* rayGenVariant)
+    {
+        // Park the active variant; it may still be referenced by submitted work
+        const DXRPermutation previous = {
+            rayGenShader, stateObject, stateObjectProperties,
+            rayGenShaderTable, missShaderTable, hitGroupShaderTable
+        };
+        dxrPermutations[activeShaderFeatures] = previous;
+
+        auto it = dxrPermutations.find(features);
+        if (it != dxrPermutations.end())
+        {
+            rayGenShader = it->second.rayGenShader;
+            stateObject = it->second.stateObject;
+            stateObjectProperties = it->second.stateObjectProperties;
+            rayGenShaderTable = it->second.rayGenShaderTable;
+            missShaderTable = it->second.missShaderTable;
+            hitGroupShaderTable = it->second.hitGroupShaderTable;
+        }
+        else
+        {
+            if (!rayGenVariant)
+                return false;
+
+            auto buildStart = std::chrono::high_resolution_clock::now();
+            rayGenShader = rayGenVariant;
+            if (!CreateDXRStateObject() || !CreateDXRShaderTables())
+            {
+                LOG_WARNF("Failed to build RayGen permutation (%s), keeping the current one",
+                    DescribeShaderFeatures(features).c_str());
+                failedPermutations.insert(features);
+                rayGenShader = previous.rayGenShader;
+                stateObject = previous.stateObject;
+                stateObjectProperties = previous.stateObjectProperties;
+                rayGenShaderTable = previous.rayGenShaderTable;
+                missShaderTable = previous.missShaderTable;
+                hitGroupShaderTable = previous.hitGroupShaderTable;
+                return false;
+            }
+
+            dxrPermutations[features] = {
+                rayGenShader, stateObject, stateObjectProperties,
+                rayGenShaderTable, missShaderTable, hitGroupShaderTable
+            };
+            LOG_INFOF("Built RayGen permutation in %.1f ms",
+                std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count());
+        }
+
+        activeShaderFeatures = features;
+        LOG_INFOF("RayGen permutation: %s", DescribeShaderFeatures(features).c_str());
+        return true;
+    }
+
     bool DXRPipeline::BuildAccelerationStructures(Scene* scene)
     {
         if (!accelerationStructure)
@@ -2452,7 +2743,7 @@ namespace RayTraceVS::DXEngine
         cpuHandle.Offset(1, dxrDescriptorSize);
         
         // Lights
-        bufferSrvDesc.Buffer.NumElements = 8;
+        bufferSrvDesc.Buffer.NumElements = MAX_SCENE_LIGHTS;
         bufferSrvDesc.Buffer.StructureByteStride = sizeof(GPULight);
         device->CreateShaderResourceView(lightBuffer.Get(), &bufferSrvDesc, cpuHandle);
         cpuHandle.Offset(1, dxrDescriptorSize);
@@ -2544,8 +2835,8 @@ namespace RayTraceVS::DXEngine
             cpuHandle.Offset(1, dxrDescriptorSize);
 
             // IMPORTANT:
-            // DXR global root signature binds 26 descriptor tables in a fixed order
-            // (root parameter 0..25), and we set them by walking the heap linearly:
+            // DXR global root signature binds 30 descriptor tables in a fixed order
+            // (root parameter 0..29), and we set them by walking the heap linearly:
             //   rootParam[i] <- heap[i]
             // Therefore the descriptor HEAP ORDER here must match `CreateGlobalRootSignature()` ranges order.
             //
@@ -2665,7 +2956,7 @@ namespace RayTraceVS::DXEngine
         }
         cpuHandle.Offset(1, dxrDescriptorSize);
         
-        // [22] t7 - MeshMaterials (GPUMeshMaterial = 64 bytes)
+        // [22] t7 - MeshMaterials (GPUMeshMaterial = 80 bytes)
         if (meshMaterialBuffer)
         {
             D3D12_RESOURCE_DESC desc = meshMaterialBuffer->GetDesc();
@@ -2722,6 +3013,34 @@ namespace RayTraceVS::DXEngine
             blueNoiseSrv.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
             device->CreateShaderResourceView(blueNoiseTexture.Get(), &blueNoiseSrv, cpuHandle);
         }
+        cpuHandle.Offset(1, dxrDescriptorSize);
+        
+        // [26] t11 - LightBvhNodes, [27] t12 - LightEmitters
+        bufferSrvDesc.Buffer.NumElements = MAX_LIGHT_BVH_NODES;
+        bufferSrvDesc.Buffer.StructureByteStride = sizeof(GPULightBvhNode);
+        device->CreateShaderResourceView(lightBvhNodeBuffer.Get(), &bufferSrvDesc, cpuHandle);
+        cpuHandle.Offset(1, dxrDescriptorSize);
+        
+        bufferSrvDesc.Buffer.NumElements = MAX_LIGHT_EMITTERS;
+        bufferSrvDesc.Buffer.StructureByteStride = sizeof(GPULightEmitter);
+        device->CreateShaderResourceView(lightEmitterBuffer.Get(), &bufferSrvDesc, cpuHandle);
+        cpuHandle.Offset(1, dxrDescriptorSize);
+        
+        // [28] t13 - Environment map, [29] t14 - its alias tables (null views until uploaded)
+        {
+            D3D12_SHADER_RESOURCE_VIEW_DESC environmentSrv = {};
+            environmentSrv.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            environmentSrv.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            environmentSrv.Texture2D.MipLevels = 1;
+            environmentSrv.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+            device->CreateShaderResourceView(environmentTexture.Get(), &environmentSrv, cpuHandle);
+        }
+        cpuHandle.Offset(1, dxrDescriptorSize);
+        
+        bufferSrvDesc.Buffer.NumElements = environmentAliasBuffer
+            ? static_cast<UINT>(environmentAliasBuffer->GetDesc().Width / sizeof(GPUEnvironmentAliasEntry)) : 1;
+        bufferSrvDesc.Buffer.StructureByteStride = sizeof(GPUEnvironmentAliasEntry);
+        device->CreateShaderResourceView(environmentAliasBuffer.Get(), &bufferSrvDesc, cpuHandle);
     }
 
     void DXRPipeline::RenderWithDXR(RenderTarget* renderTarget, Scene* scene)
@@ -2755,6 +3074,15 @@ namespace RayTraceVS::DXEngine
             }
         }
 
+        // Frame profiling: Begin -> AfterBuild covers scene uploads and BLAS/TLAS builds
+        if (!timestampInitAttempted)
+        {
+            timestampInitAttempted = true;
+            CreateTimestampResources();
+        }
+        frameStats.usedDXR = true;
+        WriteTimestamp(FrameTimestamp_Begin);
+
         // Update scene data (also refreshes denoiserEnabled from UI/scene settings)
         UpdateSceneData(scene, width, height);
 
@@ -2783,97 +3111,48 @@ namespace RayTraceVS::DXEngine
             }
         }
         
-        // Check if mesh instances exist - if so, always rebuild TLAS to reflect transform changes
-        bool hasMeshInstances = !scene->GetMeshInstances().empty();
-        
-        // Check if any primitive objects exist - they might have moved
-        // For simplicity, always rebuild if there are any objects (position may have changed)
-        bool hasPrimitives = !scene->GetObjects().empty();
-        
-        // Calculate scene content checksum to detect position/transform changes
-        // This is a simple FNV-1a style hash of object positions
-        uint64_t currentChecksum = 0x811c9dc5ULL; // FNV offset basis
-        const uint64_t fnvPrime = 0x01000193ULL;
-        
-        // Hash primitive object positions
-        const auto& objects = scene->GetObjects();
-        for (const auto& obj : objects)
-        {
-            auto sphere = std::dynamic_pointer_cast<Sphere>(obj);
-            auto plane = std::dynamic_pointer_cast<Plane>(obj);
-            auto box = std::dynamic_pointer_cast<Box>(obj);
-            
-            if (sphere)
-            {
-                auto center = sphere->GetCenter();
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.x);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.y);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.z);
-                currentChecksum *= fnvPrime;
-                float radius = sphere->GetRadius();
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&radius);
-                currentChecksum *= fnvPrime;
-            }
-            else if (plane)
-            {
-                auto pos = plane->GetPosition();
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&pos.x);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&pos.y);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&pos.z);
-                currentChecksum *= fnvPrime;
-            }
-            else if (box)
-            {
-                auto center = box->GetCenter();
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.x);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.y);
-                currentChecksum *= fnvPrime;
-                currentChecksum ^= *reinterpret_cast<uint32_t*>(&center.z);
-                currentChecksum *= fnvPrime;
-            }
-        }
-        
-        // Hash mesh instance transforms
-        const auto& meshInstances = scene->GetMeshInstances();
-        for (const auto& inst : meshInstances)
-        {
-            currentChecksum ^= *reinterpret_cast<const uint32_t*>(&inst.transform.position.x);
-            currentChecksum *= fnvPrime;
-            currentChecksum ^= *reinterpret_cast<const uint32_t*>(&inst.transform.position.y);
-            currentChecksum *= fnvPrime;
-            currentChecksum ^= *reinterpret_cast<const uint32_t*>(&inst.transform.position.z);
-            currentChecksum *= fnvPrime;
-        }
-        
-        // Detect scene content change
-        bool sceneContentChanged = (currentChecksum != lastSceneChecksum);
+        // Exact change detection from the scene's generation counters (O(1), independent of scene size)
+        const bool sceneSwitched = (scene != lastScene);
+        const uint32_t sceneChanges = sceneSwitched ? SceneChange_All : scene->GetChangesSince(lastSceneGeneration);
+        lastSceneGeneration = scene->GetGeneration();
+
+        // Geometry, transforms and materials invalidate the denoiser history; camera motion is
+        // handled by motion vectors and settings do not move anything
+        const bool sceneContentChanged = (sceneChanges &
+            (SceneChange_Geometry | SceneChange_Materials | SceneChange_Lights |
+             SceneChange_MeshCaches | SceneChange_MeshInstances | SceneChange_MeshMaterials)) != 0;
         if (sceneContentChanged)
         {
-            LOG_DEBUG("RenderWithDXR: scene content changed (checksum mismatch), resetting NRD history");
+            LOG_DEBUGF("RenderWithDXR: scene content changed (flags=0x%02X), resetting NRD history", sceneChanges);
         }
-        lastSceneChecksum = currentChecksum;
         
-        // Rebuild acceleration structures if needed
-        // Always rebuild if any objects exist (transform/position may have changed)
-        if (needsAccelerationStructureRebuild || scene != lastScene || hasMeshInstances || hasPrimitives)
+        // Rebuild acceleration structures only when something they contain changed
+        const bool accelerationStructureDirty = (sceneChanges &
+            (SceneChange_Geometry | SceneChange_MeshCaches | SceneChange_MeshInstances)) != 0;
+        if (needsAccelerationStructureRebuild || sceneSwitched || accelerationStructureDirty)
         {
             LOG_DEBUG("RenderWithDXR: building acceleration structures");
+            auto buildStart = std::chrono::high_resolution_clock::now();
             if (!BuildAccelerationStructures(scene))
             {
                 LOG_ERROR("Failed to build acceleration structures, falling back to compute");
+                frameStats.usedDXR = false;
+                // Force a retry next frame even if the scene does not change
+                needsAccelerationStructureRebuild = true;
                 RenderWithComputeShader(renderTarget, scene);
                 return;
             }
+            auto buildEnd = std::chrono::high_resolution_clock::now();
+            frameStats.accelerationStructureRebuilt = true;
+            frameStats.accelerationStructureRefit = accelerationStructure->LastUpdateWasRefit();
+            frameStats.accelerationStructureCpuMs =
+                std::chrono::duration<double, std::milli>(buildEnd - buildStart).count();
         }
+        WriteTimestamp(FrameTimestamp_AfterBuild);
         
         // Reset NRD history when scene changes to avoid ghosting artifacts
         // This ensures the denoiser doesn't accumulate data from old object positions
-        if (needsAccelerationStructureRebuild || scene != lastScene || sceneContentChanged)
+        if (sceneSwitched || sceneContentChanged)
         {
             isFirstFrame = true;
             LOG_DEBUG("RenderWithDXR: resetting NRD history");
@@ -2890,15 +3169,19 @@ namespace RayTraceVS::DXEngine
         {
             mappedConstantData->PhotonMapSize = 0;
         }
+        WriteTimestamp(FrameTimestamp_AfterPhotons);
+        
+        // Pick the smallest RayGen variant for this frame (PhotonMapSize is final now)
+        SelectShaderPermutation(scene);
         
         // ============================================
         // Pass 2: Main Rendering
         // ============================================
         if (!blueNoiseReady)
         {
-            if (!LoadBlueNoiseTexture(commandList))
+            if (!UploadBlueNoiseRanks(commandList))
             {
-                LOG_WARN("BlueNoise16.png not loaded - continuing without blue noise");
+                LOG_WARN("Blue-noise ranks not uploaded - continuing with unshifted samples");
                 blueNoiseReady = true; // avoid repeated attempts per frame
             }
         }
@@ -2910,7 +3193,7 @@ namespace RayTraceVS::DXEngine
         commandList->SetComputeRootSignature(globalRootSignature.Get());
         
         CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(dxrSrvUavHeap->GetGPUDescriptorHandleForHeapStart());
-        for (int i = 0; i < 26; i++)
+        for (int i = 0; i < 30; i++)
         {
             commandList->SetComputeRootDescriptorTable(i, gpuHandle);
             gpuHandle.Offset(1, dxrDescriptorSize);
@@ -2936,6 +3219,8 @@ namespace RayTraceVS::DXEngine
         commandList->SetPipelineState1(stateObject.Get());
         commandList->DispatchRays(&dispatchDesc);
         LOG_DEBUG("RenderWithDXR: DispatchRays done");
+        WriteTimestamp(FrameTimestamp_AfterTrace);
+        EstimateFrameRayCounts(scene, width, height);
 
         // Ray tracing writes G-Buffer as UAVs; sync NRD state tracking
         if (denoiser && denoiser->IsReady())
@@ -2982,6 +3267,174 @@ namespace RayTraceVS::DXEngine
         }
     }
 
+    // ============================================
+    // Frame Statistics
+    // ============================================
+
+    bool DXRPipeline::CreateTimestampResources()
+    {
+        auto device = dxContext->GetDevice();
+        auto commandQueue = dxContext->GetCommandQueue();
+        if (!device || !commandQueue)
+            return false;
+
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = FrameTimestamp_Count;
+        HRESULT hr = device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&timestampQueryHeap));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create timestamp query heap", hr);
+            return false;
+        }
+
+        CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+        auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT64) * FrameTimestamp_Count);
+        hr = device->CreateCommittedResource(
+            &readbackHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &readbackDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&timestampReadbackBuffer));
+        if (FAILED(hr))
+        {
+            LOG_ERROR_HR("Failed to create timestamp readback buffer", hr);
+            timestampQueryHeap.Reset();
+            return false;
+        }
+        timestampReadbackBuffer->SetName(L"TimestampReadback");
+
+        hr = commandQueue->GetTimestampFrequency(&timestampFrequency);
+        if (FAILED(hr) || timestampFrequency == 0)
+        {
+            LOG_WARN("GetTimestampFrequency failed - GPU frame timings disabled");
+            timestampQueryHeap.Reset();
+            timestampReadbackBuffer.Reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    void DXRPipeline::WriteTimestamp(FrameTimestamp slot)
+    {
+        if (!timestampQueryHeap)
+            return;
+
+        dxContext->GetCommandList()->EndQuery(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot);
+    }
+
+    void DXRPipeline::ResolveTimestamps()
+    {
+        if (!frameStats.usedDXR || !timestampQueryHeap || !timestampReadbackBuffer)
+            return;
+
+        auto commandList = dxContext->GetCommandList();
+        WriteTimestamp(FrameTimestamp_End);
+        commandList->ResolveQueryData(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+            0, FrameTimestamp_Count, timestampReadbackBuffer.Get(), 0);
+        timestampsResolved = true;
+    }
+
+    void DXRPipeline::EstimateFrameRayCounts(Scene* scene, UINT width, UINT height)
+    {
+        // Mirror the sample/bounce clamps in RayGen.hlsl
+        const UINT maxRaysPerPixel = 128;
+        int spp = scene->GetSamplesPerPixel();
+        int bounces = scene->GetMaxBounces();
+        UINT sampleCount = static_cast<UINT>((std::clamp)(spp, 1, 64));
+        UINT maxBounces = (bounces > 0) ? (std::min)(static_cast<UINT>(bounces), 32u) : 8u;
+        if (sampleCount * maxBounces > maxRaysPerPixel)
+        {
+            sampleCount = (std::max)(1u, maxRaysPerPixel / maxBounces);
+        }
+
+        // SelectLightEmitters draws MaxShadowLights emitters per hit (0 means the default of 2,
+        // at most MAX_LIGHT_SAMPLES = 4), each with one shadow ray; fewer emitters are all taken
+        UINT maxShadowLights = static_cast<UINT>((std::max)(scene->GetMaxShadowLights(), 0));
+        maxShadowLights = (std::min)(maxShadowLights == 0 ? 2u : maxShadowLights, 4u);
+        UINT shadowLights = (std::min)(static_cast<UINT>(lightBvh.GetEmitters().size()), maxShadowLights);
+
+        auto anyTransmissive = [](const std::vector<ObjectMaterial>& materials)
+        {
+            return std::any_of(materials.begin(), materials.end(),
+                [](const ObjectMaterial& mat) { return mat.transmission > 0.01f; });
+        };
+        bool hasTransmissive = anyTransmissive(scene->GetSpheres().materials) ||
+            anyTransmissive(scene->GetPlanes().materials) ||
+            anyTransmissive(scene->GetBoxes().materials);
+        if (!hasTransmissive)
+        {
+            for (const auto& inst : scene->GetMeshInstances())
+            {
+                if (inst.material.transmission > 0.01f)
+                {
+                    hasTransmissive = true;
+                    break;
+                }
+            }
+        }
+
+        const uint64_t pixelCount = static_cast<uint64_t>(width) * height;
+        frameStats.radianceRays = pixelCount * sampleCount * maxBounces;
+        frameStats.shadowRays = frameStats.radianceRays * shadowLights;
+        frameStats.thicknessRays = hasTransmissive ? frameStats.radianceRays : 0;
+        frameStats.photonRays = mappedConstantData ? mappedConstantData->NumPhotons : 0;
+    }
+
+    bool DXRPipeline::ReadFrameStats(FrameStats& outStats)
+    {
+        outStats = frameStats;
+        if (!timestampsResolved || !timestampReadbackBuffer || timestampFrequency == 0)
+            return frameStats.usedDXR;
+
+        UINT64* timestamps = nullptr;
+        D3D12_RANGE readRange = { 0, sizeof(UINT64) * FrameTimestamp_Count };
+        if (FAILED(timestampReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&timestamps))))
+        {
+            LOG_WARN("ReadFrameStats: failed to map timestamp readback buffer");
+            return frameStats.usedDXR;
+        }
+
+        const double ticksToMs = 1000.0 / static_cast<double>(timestampFrequency);
+        auto Delta = [&](FrameTimestamp from, FrameTimestamp to)
+        {
+            return (timestamps[to] > timestamps[from])
+                ? static_cast<double>(timestamps[to] - timestamps[from]) * ticksToMs
+                : 0.0;
+        };
+
+        outStats.accelerationStructureGpuMs = Delta(FrameTimestamp_Begin, FrameTimestamp_AfterBuild);
+        outStats.photonGpuMs = Delta(FrameTimestamp_AfterBuild, FrameTimestamp_AfterPhotons);
+        outStats.traceGpuMs = Delta(FrameTimestamp_AfterPhotons, FrameTimestamp_AfterTrace);
+        outStats.postProcessGpuMs = Delta(FrameTimestamp_AfterTrace, FrameTimestamp_End);
+        outStats.frameGpuMs = Delta(FrameTimestamp_Begin, FrameTimestamp_End);
+        outStats.gpuTimingValid = outStats.frameGpuMs > 0.0;
+
+        D3D12_RANGE writtenRange = { 0, 0 };
+        timestampReadbackBuffer->Unmap(0, &writtenRange);
+        return true;
+    }
+
+    void DXRPipeline::SetMeshResidencyBudget(uint64_t budgetBytes)
+    {
+        meshResidencyBudget = budgetBytes;
+        if (accelerationStructure)
+            accelerationStructure->SetMeshResidencyBudget(budgetBytes);
+    }
+
+    ResidencyStats DXRPipeline::GetMeshResidencyStats() const
+    {
+        if (!accelerationStructure)
+        {
+            ResidencyStats stats;
+            stats.budgetBytes = meshResidencyBudget;
+            return stats;
+        }
+        return accelerationStructure->GetMeshResidencyStats();
+    }
+
     // ============================================
     // Legacy Functions (kept for compatibility)
     // ============================================
@@ -3484,7 +3937,7 @@ namespace RayTraceVS::DXEngine
         device->CreateShaderResourceView(boxBuffer.Get(), &bufferSrvDesc, cpuHandle);
         cpuHandle.Offset(1, dxrDescriptorSize);
         
-        bufferSrvDesc.Buffer.NumElements = 8;
+        bufferSrvDesc.Buffer.NumElements = MAX_SCENE_LIGHTS;
         bufferSrvDesc.Buffer.StructureByteStride = sizeof(GPULight);
         device->CreateShaderResourceView(lightBuffer.Get(), &bufferSrvDesc, cpuHandle);
         cpuHandle.Offset(1, dxrDescriptorSize);
@@ -3514,10 +3967,10 @@ namespace RayTraceVS::DXEngine
             return;
 
         // Skip photon pass if there are no specular/transmissive materials or no non-ambient lights
-        const auto& objects = scene->GetObjects();
         const auto& meshInstances = scene->GetMeshInstances();
         const auto& lights = scene->GetLights();
-        const UINT objectCount = static_cast<UINT>(objects.size() + meshInstances.size());
+        const size_t primitiveCount = scene->GetPrimitiveCount();
+        const UINT objectCount = static_cast<UINT>(primitiveCount + meshInstances.size());
 
         UINT nonAmbientLights = 0;
         UINT pointLights = 0;
@@ -3533,16 +3986,14 @@ namespace RayTraceVS::DXEngine
             }
         }
 
-        bool hasSpecular = false;
-        for (const auto& obj : objects)
+        auto anySpecular = [](const std::vector<ObjectMaterial>& materials)
         {
-            const auto mat = obj->GetMaterial();
-            if (mat.transmission > 0.01f || mat.metallic > 0.5f)
-            {
-                hasSpecular = true;
-                break;
-            }
-        }
+            return std::any_of(materials.begin(), materials.end(),
+                [](const ObjectMaterial& mat) { return mat.transmission > 0.01f || mat.metallic > 0.5f; });
+        };
+        bool hasSpecular = anySpecular(scene->GetSpheres().materials) ||
+            anySpecular(scene->GetPlanes().materials) ||
+            anySpecular(scene->GetBoxes().materials);
         if (!hasSpecular)
         {
             for (const auto& inst : meshInstances)
@@ -3557,15 +4008,12 @@ namespace RayTraceVS::DXEngine
 
         if (!hasSpecular || nonAmbientLights == 0)
         {
-            char buf[256];
-            sprintf_s(buf,
-                "EmitPhotons skipped: hasSpecular=%d nonAmbient=%u point=%u objects=%zu mesh=%zu",
+            LOG_DEBUGF("EmitPhotons skipped: hasSpecular=%d nonAmbient=%u point=%u objects=%zu mesh=%zu",
                 hasSpecular ? 1 : 0,
                 nonAmbientLights,
                 pointLights,
-                objects.size(),
+                primitiveCount,
                 meshInstances.size());
-            LOG_DEBUG(buf);
 
             mappedConstantData->NumPhotons = 0;
             mappedConstantData->PhotonMapSize = 0;
@@ -3625,10 +4073,8 @@ namespace RayTraceVS::DXEngine
         }
         if (totalPhotons > safeCap)
         {
-            char buf[256];
-            sprintf_s(buf, "EmitPhotons safety cap: total=%u -> %u (objects=%u, point=%u)",
+            LOG_WARNF("EmitPhotons safety cap: total=%u -> %u (objects=%u, point=%u)",
                 totalPhotons, safeCap, objectCount, pointLights);
-            LOG_WARN(buf);
             totalPhotons = safeCap;
         }
 
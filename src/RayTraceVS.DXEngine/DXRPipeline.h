@@ -3,8 +3,14 @@
 #include <d3d12.h>
 #include "d3dx12.h"
 #include "ResourceStateTracker.h"
+#include "ShaderPermutation.h"
+#include "LightBvh.h"
+#include "EnvironmentMap.h"
+#include "ResidencyManager.h"
 #include <wrl/client.h>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <DirectXMath.h>
 #include <string>
@@ -60,7 +66,7 @@ namespace RayTraceVS::DXEngine
         float ShadowStrength;       // 0.0 = no shadow, 1.0 = normal, >1.0 = darker
         float ShadowAbsorptionScale; // Beer absorption scale for colored transparent shadows
         UINT FrameIndex;            // Frame counter for temporal noise variation
-        UINT ShadowPadding;         // Padding for 16-byte alignment
+        UINT RussianRouletteMinDepth;   // Bounces after which Russian roulette may end a path
         // Light attenuation parameters (physical-based)
         float LightAttenuationConstant;   // Constant term (usually 1.0)
         float LightAttenuationLinear;     // Linear term (distance proportional)
@@ -68,7 +74,17 @@ namespace RayTraceVS::DXEngine
         UINT MaxShadowLights;             // Maximum lights for shadow calculation (optimization)
         // Mesh instance count
         UINT NumMeshInstances;      // Number of FBX mesh instances
-        UINT MeshPadding[3];        // Padding for 16-byte alignment
+        // Light BVH (many-light selection)
+        UINT NumLightEmitters;      // Entries in LightEmitters (directional first)
+        UINT NumDirectionalEmitters;
+        UINT LightBvhNodeCount;     // 0 = no bounded emitters
+        XMFLOAT3 AmbientLight;      // Sum of the ambient lights (color * intensity)
+        float AmbientPadding;
+        // Environment map (t13, alias tables t14)
+        UINT EnvironmentWidth;      // 0 = not uploaded
+        UINT EnvironmentHeight;
+        float EnvironmentIntensity;
+        UINT EnvironmentLighting;   // 1 = sample the environment as a light on diffuse surfaces
         // Matrices for motion vectors (column-major for HLSL)
         XMFLOAT4X4 ViewProjection;
         XMFLOAT4X4 PrevViewProjection;
@@ -107,6 +123,14 @@ namespace RayTraceVS::DXEngine
     // Spatial Hash for Photon Gathering
     // ============================================
     
+    // Scene light capacity. Direct lighting picks a few of them per hit through the light
+    // BVH, so the cost no longer grows with this number.
+    static constexpr UINT MAX_SCENE_LIGHTS = 256;
+    static constexpr UINT MAX_SCENE_SPHERES = 32;
+    static constexpr UINT MAX_SCENE_BOXES = 32;
+    static constexpr UINT MAX_LIGHT_EMITTERS = MAX_SCENE_LIGHTS + MAX_SCENE_SPHERES + MAX_SCENE_BOXES;
+    static constexpr UINT MAX_LIGHT_BVH_NODES = MAX_LIGHT_EMITTERS * 2 - 1;
+
     static constexpr UINT PHOTON_HASH_TABLE_SIZE = 65536;   // 2^16 hash buckets
     static constexpr UINT MAX_PHOTONS_PER_CELL = 64;        // Max photons per cell
     
@@ -219,7 +243,7 @@ namespace RayTraceVS::DXEngine
         UINT IndexCount;        // 4 - index count for this mesh type -> 16
     };
 
-    // GPU mesh material - 64 bytes (per instance)
+    // GPU mesh material - 80 bytes (one per distinct material; instances index it)
     struct alignas(16) GPUMeshMaterial
     {
         XMFLOAT4 Color;         // 16 -> 16
@@ -302,6 +326,50 @@ namespace RayTraceVS::DXEngine
         float Padding;
     };
 
+    // ============================================
+    // Frame statistics (profiling / benchmark)
+    // ============================================
+
+    // GPU timestamp slots written by RenderWithDXR
+    enum FrameTimestamp : UINT
+    {
+        FrameTimestamp_Begin = 0,
+        FrameTimestamp_AfterBuild,
+        FrameTimestamp_AfterPhotons,
+        FrameTimestamp_AfterTrace,
+        FrameTimestamp_End,
+        FrameTimestamp_Count
+    };
+
+    // Per-frame statistics of the last DXR frame.
+    // GPU times are only valid after the frame's command list has completed (see ReadFrameStats).
+    // Ray counts are nominal launch counts derived from the dispatch size and render settings,
+    // mirroring the clamps in RayGen.hlsl; bounce/shadow/thickness counts are upper bounds
+    // because paths may terminate early on the GPU.
+    struct FrameStats
+    {
+        bool usedDXR = false;
+        bool accelerationStructureRebuilt = false;
+        bool accelerationStructureRefit = false;   // The update refitted existing BLAS/TLAS, no full build
+        bool gpuTimingValid = false;
+
+        double accelerationStructureCpuMs = 0.0;   // Host-side BLAS/TLAS recording + uploads
+        double accelerationStructureGpuMs = 0.0;   // Begin -> AfterBuild
+        double photonGpuMs = 0.0;                  // AfterBuild -> AfterPhotons
+        double traceGpuMs = 0.0;                   // AfterPhotons -> AfterTrace
+        double postProcessGpuMs = 0.0;             // AfterTrace -> End (NRD + composite)
+        double frameGpuMs = 0.0;                   // Begin -> End
+
+        // Nominal upper bounds from the dispatch size and settings, not counted on the GPU:
+        // paths ended early (Russian roulette, misses) still count as full-length. Only the
+        // photon count is exact (one ray per emitted photon).
+        uint64_t radianceRays = 0;
+        uint64_t shadowRays = 0;
+        uint64_t thicknessRays = 0;
+        uint64_t photonRays = 0;
+        bool rayCountsMeasured = false;            // The counts above are traced rays (CPU backend)
+    };
+
     class DXRPipeline
     {
     public:
@@ -338,6 +406,16 @@ namespace RayTraceVS::DXEngine
         // Get denoiser for direct access (if needed)
         NRDDenoiser* GetDenoiser() const { return denoiser.get(); }
 
+        // Statistics of the last rendered frame.
+        // Call after the frame's command list has been executed and the GPU has been waited on;
+        // resolves the GPU timestamps into millisecond timings.
+        bool ReadFrameStats(FrameStats& outStats);
+
+        // Byte budget of mesh BLASes kept for meshes the scene no longer instances
+        // (see ResidencyManager); applied at the next acceleration structure update
+        void SetMeshResidencyBudget(uint64_t budgetBytes);
+        ResidencyStats GetMeshResidencyStats() const;
+
     private:
         DXContext* dxContext;
         bool dxrPipelineReady = false;
@@ -387,6 +465,22 @@ namespace RayTraceVS::DXEngine
         ComPtr<ID3D12Resource> boxUploadBuffer;
         ComPtr<ID3D12Resource> lightUploadBuffer;
 
+        // Light BVH over lights and emissive primitives (t11, t12)
+        LightBvh lightBvh;
+        ComPtr<ID3D12Resource> lightBvhNodeBuffer;
+        ComPtr<ID3D12Resource> lightEmitterBuffer;
+        ComPtr<ID3D12Resource> lightBvhNodeUploadBuffer;
+        ComPtr<ID3D12Resource> lightEmitterUploadBuffer;
+        Scene* lightBvhScene = nullptr;
+        uint64_t lightBvhGeneration = 0;
+
+        // Environment map and its sampling tables (t13, t14); re-uploaded when the file changes
+        EnvironmentMap environmentMap;
+        ComPtr<ID3D12Resource> environmentTexture;
+        ComPtr<ID3D12Resource> environmentUpload;
+        ComPtr<ID3D12Resource> environmentAliasBuffer;
+        ComPtr<ID3D12Resource> environmentAliasUpload;
+
         // ============================================
         // SoA Buffers (for DXR - optimized memory access)
         // ============================================
@@ -413,9 +507,11 @@ namespace RayTraceVS::DXEngine
         
         ComPtr<ID3D12Resource> meshVertexBuffer;      // t5 - Combined vertex data for all mesh types
         ComPtr<ID3D12Resource> meshIndexBuffer;       // t6 - Combined index data for all mesh types
-        ComPtr<ID3D12Resource> meshMaterialBuffer;    // t7 - Material per instance
+        ComPtr<ID3D12Resource> meshMaterialBuffer;    // t7 - Deduplicated materials, indexed by MeshInstanceInfo
         ComPtr<ID3D12Resource> meshInfoBuffer;        // t8 - MeshInfo per mesh type
         ComPtr<ID3D12Resource> meshInstanceBuffer;    // t9 - MeshInstanceInfo per instance
+        Scene* meshBufferScene = nullptr;             // Scene and generation the buffers above were built from
+        uint64_t meshBufferGeneration = 0;
 
         // ============================================
         // DXR Pipeline Resources
@@ -436,14 +532,31 @@ namespace RayTraceVS::DXEngine
         
         UINT shaderTableRecordSize = 0;
         
+        // RayGen permutations (see ShaderPermutation.h). The active variant lives in the
+        // members above; variants already built are parked here, so switching back costs
+        // nothing and command lists still in flight keep their state object alive.
+        struct DXRPermutation
+        {
+            ComPtr<ID3DBlob> rayGenShader;
+            ComPtr<ID3D12StateObject> stateObject;
+            ComPtr<ID3D12StateObjectProperties> stateObjectProperties;
+            ComPtr<ID3D12Resource> rayGenShaderTable;
+            ComPtr<ID3D12Resource> missShaderTable;
+            ComPtr<ID3D12Resource> hitGroupShaderTable;
+        };
+        std::unordered_map<uint32_t, DXRPermutation> dxrPermutations;
+        std::unordered_set<uint32_t> failedPermutations;    // State object creation failed
+        uint32_t activeShaderFeatures = ShaderFeature_All;
+        
         // Acceleration structure
         std::unique_ptr<AccelerationStructure> accelerationStructure;
+        uint64_t meshResidencyBudget = DEFAULT_MESH_RESIDENCY_BUDGET;
         
         // DXR descriptor heap
         ComPtr<ID3D12DescriptorHeap> dxrSrvUavHeap;
         UINT dxrDescriptorSize = 0;
         
-        // Blue noise texture for AA/DoF (SRV t10)
+        // Blue-noise rank tile of the sampler (SRV t10, Sampler.h)
         ComPtr<ID3D12Resource> blueNoiseTexture;
         ComPtr<ID3D12Resource> blueNoiseUpload;
         bool blueNoiseReady = false;
@@ -528,8 +641,24 @@ namespace RayTraceVS::DXEngine
         UINT lastBoxCount = 0;
         UINT lastMeshInstanceCount = 0;
         
-        // Scene content checksum for detecting position/transform changes
-        uint64_t lastSceneChecksum = 0;
+        // Scene generation seen by the last frame (see Scene::GetChangesSince)
+        uint64_t lastSceneGeneration = 0;
+
+        // ============================================
+        // Frame Statistics (GPU timestamps)
+        // ============================================
+
+        ComPtr<ID3D12QueryHeap> timestampQueryHeap;
+        ComPtr<ID3D12Resource> timestampReadbackBuffer;
+        UINT64 timestampFrequency = 0;
+        bool timestampInitAttempted = false;
+        bool timestampsResolved = false;
+        FrameStats frameStats;
+
+        bool CreateTimestampResources();
+        void WriteTimestamp(FrameTimestamp slot);
+        void ResolveTimestamps();
+        void EstimateFrameRayCounts(Scene* scene, UINT width, UINT height);
 
         // ============================================
         // Shader Cache System
@@ -605,7 +734,12 @@ namespace RayTraceVS::DXEngine
         bool CreateDXRDescriptorHeap();
         bool BuildAccelerationStructures(Scene* scene);
         void UpdateDXRDescriptors(RenderTarget* renderTarget);
-        bool LoadBlueNoiseTexture(ID3D12GraphicsCommandList* commandList);
+        bool UploadBlueNoiseRanks(ID3D12GraphicsCommandList* commandList);
+        bool UploadEnvironmentMap(ID3D12GraphicsCommandList* commandList);
+        
+        // RayGen permutations
+        void SelectShaderPermutation(Scene* scene);
+        bool ActivateShaderPermutation(uint32_t features, ID3DBlob* rayGenVariant);
         
         // Photon mapping (for caustics)
         bool CreatePhotonMappingResources();
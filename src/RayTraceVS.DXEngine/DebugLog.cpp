@@ -0,0 +1,446 @@
+#include "DebugLog.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <share.h>
+#endif
+
+namespace RayTraceVS::DXEngine
+{
+    namespace LogDetail
+    {
+        // One ring slot. sequence follows the bounded MPMC queue scheme (D. Vyukov):
+        //   sequence == position             -> free, producer may claim it
+        //   sequence == position + 1         -> committed, writer may consume it
+        //   sequence == position + capacity  -> released for the next lap
+        struct alignas(64) LogRecord
+        {
+            std::atomic<uint64_t> sequence;
+            uint64_t position;
+            LogLevel level;
+            LogFormatFn format;     // nullptr = payload is a plain string
+            alignas(16) unsigned char payload[LOG_PAYLOAD_SIZE];
+        };
+    }
+
+    namespace
+    {
+        using LogDetail::LogRecord;
+        using LogDetail::LOG_PAYLOAD_SIZE;
+
+        static constexpr uint64_t LOG_RING_CAPACITY = 2048;     // Power of two
+        static constexpr size_t LOG_LINE_SIZE = 1024;
+        static constexpr auto LOG_WRITER_IDLE_WAIT = std::chrono::milliseconds(100);
+        static constexpr auto LOG_FLUSH_TIMEOUT = std::chrono::milliseconds(2000);
+#ifdef _WIN32
+        static const char* DEFAULT_LOG_PATH = "C:\\git\\RayTraceVS\\debug.log";
+#else
+        static const char* DEFAULT_LOG_PATH = "debug.log";
+#endif
+
+        // Shared so the log can be tailed while the engine runs
+        FILE* OpenLogFile(const std::string& path, const char* mode)
+        {
+#ifdef _WIN32
+            return _fsopen(path.c_str(), mode, _SH_DENYNO);
+#else
+            return fopen(path.c_str(), mode);
+#endif
+        }
+
+        const char* GetLevelPrefix(LogLevel level)
+        {
+            switch (level)
+            {
+            case LogLevel::Error: return "[ERROR] ";
+            case LogLevel::Warn:  return "[WARN] ";
+            case LogLevel::Info:  return "[INFO] ";
+            default:              return "[DEBUG] ";
+            }
+        }
+
+        class AsyncLogger
+        {
+        public:
+            static AsyncLogger& Get()
+            {
+                static AsyncLogger instance;
+                return instance;
+            }
+
+            LogRecord* Begin(LogLevel level, LogDetail::LogFormatFn format)
+            {
+                uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    LogRecord& record = ring[pos & (LOG_RING_CAPACITY - 1)];
+                    uint64_t seq = record.sequence.load(std::memory_order_acquire);
+                    int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+                    if (diff == 0)
+                    {
+                        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            record.position = pos;
+                            record.level = level;
+                            record.format = format;
+                            return &record;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // Ring full - never block the caller
+                        droppedCount.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;
+                    }
+                    else
+                    {
+                        pos = enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void Commit(LogRecord* record)
+            {
+                record->sequence.store(record->position + 1, std::memory_order_release);
+
+                if (stopRequested.load(std::memory_order_acquire))
+                {
+                    // Writer is gone (ShutdownLog) - write synchronously
+                    std::lock_guard<std::mutex> lock(consumerMutex);
+                    DrainLocked();
+                    return;
+                }
+
+                // A wakeup lost between the writer's check and its wait is bounded by LOG_WRITER_IDLE_WAIT
+                if (writerIdle.load(std::memory_order_seq_cst))
+                {
+                    wakeCondition.notify_one();
+                }
+            }
+
+            void SetFilePath(const char* path)
+            {
+                std::lock_guard<std::mutex> lock(consumerMutex);
+                DrainLocked();
+                CloseFileLocked();
+                filePath = (path && path[0]) ? path : DEFAULT_LOG_PATH;
+            }
+
+            std::string GetFilePath()
+            {
+                std::lock_guard<std::mutex> lock(consumerMutex);
+                return filePath;
+            }
+
+            void Flush()
+            {
+                uint64_t target = enqueuePos.load(std::memory_order_acquire);
+                if (writtenPos.load(std::memory_order_acquire) >= target)
+                    return;
+
+                if (stopRequested.load(std::memory_order_acquire))
+                {
+                    std::lock_guard<std::mutex> lock(consumerMutex);
+                    DrainLocked();
+                    return;
+                }
+
+                wakeCondition.notify_one();
+                auto deadline = std::chrono::steady_clock::now() + LOG_FLUSH_TIMEOUT;
+                while (writtenPos.load(std::memory_order_acquire) < target)
+                {
+                    if (std::chrono::steady_clock::now() > deadline)
+                        break;  // A producer stalled between claim and commit
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            void Clear()
+            {
+                Flush();
+
+                std::lock_guard<std::mutex> lock(consumerMutex);
+                CloseFileLocked();
+                FILE* truncated = OpenLogFile(filePath, "w");
+                if (truncated)
+                {
+                    fclose(truncated);
+                }
+            }
+
+            void Shutdown()
+            {
+                stopRequested.store(true, std::memory_order_release);
+                wakeCondition.notify_one();
+                if (writerThread.joinable())
+                {
+                    writerThread.join();
+                }
+
+                std::lock_guard<std::mutex> lock(consumerMutex);
+                DrainLocked();
+                CloseFileLocked();
+            }
+
+        private:
+            AsyncLogger()
+                : ring(new LogRecord[LOG_RING_CAPACITY])
+                , filePath(DEFAULT_LOG_PATH)
+            {
+                for (uint64_t i = 0; i < LOG_RING_CAPACITY; i++)
+                {
+                    ring[i].sequence.store(i, std::memory_order_relaxed);
+                }
+                writerThread = std::thread([this]() { WriterLoop(); });
+            }
+
+            ~AsyncLogger()
+            {
+                // Runs at DLL_PROCESS_DETACH with the loader lock held: joining would deadlock,
+                // and at process exit the writer thread has already been terminated (possibly
+                // while holding consumerMutex), so only drain if the lock is free.
+                stopRequested.store(true, std::memory_order_release);
+                if (writerThread.joinable())
+                {
+                    writerThread.detach();
+                }
+
+                if (consumerMutex.try_lock())
+                {
+                    DrainLocked();
+                    CloseFileLocked();
+                    consumerMutex.unlock();
+                }
+            }
+
+            AsyncLogger(const AsyncLogger&) = delete;
+            AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+            void WriterLoop()
+            {
+                while (!stopRequested.load(std::memory_order_acquire))
+                {
+                    size_t written = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(consumerMutex);
+                        written = DrainLocked();
+                    }
+                    if (written > 0)
+                        continue;
+
+                    std::unique_lock<std::mutex> lock(wakeMutex);
+                    writerIdle.store(true, std::memory_order_seq_cst);
+                    if (!HasPendingRecords() && !stopRequested.load(std::memory_order_acquire))
+                    {
+                        wakeCondition.wait_for(lock, LOG_WRITER_IDLE_WAIT);
+                    }
+                    writerIdle.store(false, std::memory_order_relaxed);
+                }
+            }
+
+            bool HasPendingRecords() const
+            {
+                return writtenPos.load(std::memory_order_acquire) != enqueuePos.load(std::memory_order_seq_cst);
+            }
+
+            // Consumes every committed record in order. Caller holds consumerMutex.
+            size_t DrainLocked()
+            {
+                char line[LOG_LINE_SIZE];
+                size_t count = 0;
+
+                for (;;)
+                {
+                    LogRecord& record = ring[dequeuePos & (LOG_RING_CAPACITY - 1)];
+                    if (record.sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+                        break;
+
+                    const char* prefix = GetLevelPrefix(record.level);
+                    size_t prefixLength = strlen(prefix);
+                    memcpy(line, prefix, prefixLength);
+                    if (record.format)
+                    {
+                        record.format(line + prefixLength, LOG_LINE_SIZE - prefixLength, record.payload);
+                    }
+                    else
+                    {
+                        snprintf(line + prefixLength, LOG_LINE_SIZE - prefixLength, "%s",
+                            reinterpret_cast<const char*>(record.payload));
+                    }
+                    bool isError = record.level == LogLevel::Error;
+
+                    record.sequence.store(dequeuePos + LOG_RING_CAPACITY, std::memory_order_release);
+                    dequeuePos++;
+
+                    WriteLineLocked(line, isError);
+                    writtenPos.store(dequeuePos, std::memory_order_release);
+                    count++;
+                }
+
+                uint64_t dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+                if (dropped > 0)
+                {
+                    snprintf(line, sizeof(line), "[WARN] Log queue full, %llu messages dropped", static_cast<unsigned long long>(dropped));
+                    WriteLineLocked(line, false);
+                }
+
+                if (file && (count > 0 || dropped > 0))
+                {
+                    fflush(file);
+                }
+                return count;
+            }
+
+            void WriteLineLocked(const char* line, bool isError)
+            {
+                if (!file)
+                {
+                    file = OpenLogFile(filePath, "a");
+                }
+                if (file)
+                {
+                    fputs(line, file);
+                    fputc('\n', file);
+                }
+
+                if (isError)
+                {
+#ifdef _WIN32
+                    OutputDebugStringA(line);
+                    OutputDebugStringA("\n");
+#else
+                    fputs(line, stderr);
+                    fputc('\n', stderr);
+#endif
+                }
+            }
+
+            void CloseFileLocked()
+            {
+                if (file)
+                {
+                    fclose(file);
+                    file = nullptr;
+                }
+            }
+
+            std::unique_ptr<LogRecord[]> ring;
+            alignas(64) std::atomic<uint64_t> enqueuePos{ 0 };
+            alignas(64) std::atomic<uint64_t> writtenPos{ 0 };
+            std::atomic<uint64_t> droppedCount{ 0 };
+            uint64_t dequeuePos = 0;                // Guarded by consumerMutex
+
+            std::atomic<bool> writerIdle{ false };
+            std::atomic<bool> stopRequested{ false };
+            std::mutex wakeMutex;
+            std::condition_variable wakeCondition;
+
+            // Taken by the writer thread and by control calls only - never by producers
+            // unless the writer has been shut down
+            std::mutex consumerMutex;
+            std::string filePath;
+            FILE* file = nullptr;
+
+            std::thread writerThread;
+        };
+    }
+
+    namespace LogDetail
+    {
+        uint32_t LogPayloadWriter::AppendWideString(const wchar_t* s)
+        {
+            // Encode whole code points into the room left, then append as a C string
+            size_t room = (used < LOG_PAYLOAD_SIZE) ? LOG_PAYLOAD_SIZE - used : 0;
+            if (room == 0)
+                return static_cast<uint32_t>(LOG_PAYLOAD_SIZE - 1);  // Points at the terminating zero
+
+            char utf8[LOG_PAYLOAD_SIZE];
+            size_t length = 0;
+            for (const wchar_t* p = s; p && *p; p++)
+            {
+                uint32_t cp = static_cast<uint32_t>(*p);
+                if (cp >= 0xD800 && cp <= 0xDBFF && p[1] >= 0xDC00 && p[1] <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<uint32_t>(p[1]) - 0xDC00);
+                    p++;
+                }
+                else if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+                {
+                    cp = 0xFFFD;
+                }
+
+                const size_t bytes = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+                if (length + bytes > room - 1)
+                    break;
+                if (bytes == 1)
+                {
+                    utf8[length++] = static_cast<char>(cp);
+                    continue;
+                }
+                static constexpr uint8_t LEAD[5] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+                for (size_t i = bytes; i-- > 1;)
+                {
+                    utf8[length + i] = static_cast<char>(0x80 | (cp & 0x3F));
+                    cp >>= 6;
+                }
+                utf8[length] = static_cast<char>(LEAD[bytes] | cp);
+                length += bytes;
+            }
+            utf8[length] = '\0';
+            return AppendString(utf8);
+        }
+
+        LogRecord* BeginRecord(LogLevel level, LogFormatFn format, unsigned char** outPayload)
+        {
+            LogRecord* record = AsyncLogger::Get().Begin(level, format);
+            *outPayload = record ? record->payload : nullptr;
+            return record;
+        }
+
+        void CommitRecord(LogRecord* record)
+        {
+            AsyncLogger::Get().Commit(record);
+        }
+
+        void LogMessage(LogLevel level, const char* message)
+        {
+            LogRecord* record = AsyncLogger::Get().Begin(level, nullptr);
+            if (!record)
+                return;
+
+            size_t length = message ? strnlen(message, LOG_PAYLOAD_SIZE - 1) : 0;
+            if (length > 0)
+                memcpy(record->payload, message, length);
+            record->payload[length] = '\0';
+            AsyncLogger::Get().Commit(record);
+        }
+    }
+
+    void SetLogFilePath(const char* path)
+    {
+        AsyncLogger::Get().SetFilePath(path);
+    }
+
+    std::string GetLogFilePath()
+    {
+        return AsyncLogger::Get().GetFilePath();
+    }
+
+    void FlushLog()
+    {
+        AsyncLogger::Get().Flush();
+    }
+
+    void ClearLogFile()
+    {
+        AsyncLogger::Get().Clear();
+    }
+
+    void ShutdownLog()
+    {
+        AsyncLogger::Get().Shutdown();
+    }
+}
@@ -1,93 +1,267 @@
 #pragma once
 
-#include <fstream>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+
+// ============================================
+// Asynchronous logger
+// ============================================
+//
+// Producers (render thread, bridge calls) push fixed-size records into a lock-free
+// MPSC ring buffer; a background writer thread formats them and appends to the sink
+// file. Formatting for LOG_*F is deferred: the format string pointer and the raw
+// arguments are copied into the record and snprintf runs on the writer thread, so
+// strings are copied by content (wide strings as UTF-8) and other pointers are rejected.
+// If the ring is full, records are dropped (and counted) instead of blocking.
+//
+// Filtering happens twice:
+//   - compile time: RAYTRACEVS_LOG_MAX_LEVEL removes levels above it entirely
+//   - runtime:      SetLogEnabled / SetDebugMode (errors are always logged)
+
+// 0 = errors only, 1 = +warn, 2 = +info, 3 = +debug
+#ifndef RAYTRACEVS_LOG_MAX_LEVEL
+#define RAYTRACEVS_LOG_MAX_LEVEL 3
+#endif
 
 namespace RayTraceVS::DXEngine
 {
+    enum class LogLevel : uint32_t
+    {
+        Error = 0,
+        Warn = 1,
+        Info = 2,
+        Debug = 3
+    };
+
     // Logging control: 0 = errors only, 1 = enable info/warn/debug
-    inline int g_LogEnabled = 0;
+    inline std::atomic<int> g_LogEnabled = 0;
     // Debug mode flag: 0 = debug disabled, 1 = debug enabled
-    inline int g_DebugMode = 0;
+    inline std::atomic<int> g_DebugMode = 0;
 
     // Set logging mode (call from NativeBridge or application startup)
-    inline void SetLogEnabled(int enabled) { g_LogEnabled = enabled; }
-    inline int GetLogEnabled() { return g_LogEnabled; }
+    inline void SetLogEnabled(int enabled) { g_LogEnabled.store(enabled, std::memory_order_relaxed); }
+    inline int GetLogEnabled() { return g_LogEnabled.load(std::memory_order_relaxed); }
     // Set debug mode (call from NativeBridge or application startup)
-    inline void SetDebugMode(int mode) { g_DebugMode = mode; }
-    inline int GetDebugMode() { return g_DebugMode; }
+    inline void SetDebugMode(int mode) { g_DebugMode.store(mode, std::memory_order_relaxed); }
+    inline int GetDebugMode() { return g_DebugMode.load(std::memory_order_relaxed); }
 
-    // Internal log function - writes to file
-    inline void WriteLogToFile(const char* prefix, const char* message)
+    constexpr bool IsLogLevelCompiled(LogLevel level)
     {
-        std::ofstream log("C:\\git\\RayTraceVS\\debug.log", std::ios::app);
-        if (log.is_open())
+        return static_cast<int>(level) <= RAYTRACEVS_LOG_MAX_LEVEL;
+    }
+
+    // Runtime filter - the only cost paid by a disabled log call
+    inline bool IsLogLevelEnabled(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Error:
+            return true;
+        case LogLevel::Warn:
+        case LogLevel::Info:
+            return GetLogEnabled() > 0;
+        default:
+            return GetLogEnabled() > 0 && GetDebugMode() > 0;
+        }
+    }
+
+    // Sink configuration (default: C:\git\RayTraceVS\debug.log; debug.log in the working directory off Windows)
+    void SetLogFilePath(const char* path);
+    std::string GetLogFilePath();
+
+    // Blocks until every record queued before the call has been written
+    void FlushLog();
+    // Flushes pending records and truncates the sink file (call at startup)
+    void ClearLogFile();
+    // Flushes and joins the writer thread. Call before unloading the DLL explicitly;
+    // at process exit the remaining records are drained without joining.
+    void ShutdownLog();
+
+    namespace LogDetail
+    {
+        // Record payload size; longer messages are truncated
+        static constexpr size_t LOG_PAYLOAD_SIZE = 480;
+
+        // Formats a deferred record into out (runs on the writer thread)
+        using LogFormatFn = void (*)(char* out, size_t outSize, const unsigned char* payload);
+
+        // Appends C strings behind the packed arguments so they outlive the call site
+        struct LogPayloadWriter
+        {
+            // Wide strings are stored as UTF-8 (UTF-16 on Windows, UTF-32 elsewhere)
+            uint32_t AppendWideString(const wchar_t* s);
+
+            unsigned char* data;
+            size_t used;
+
+            uint32_t AppendString(const char* s)
+            {
+                uint32_t offset = static_cast<uint32_t>(used);
+                size_t room = (used < LOG_PAYLOAD_SIZE) ? LOG_PAYLOAD_SIZE - used : 0;
+                if (room == 0)
+                    return static_cast<uint32_t>(LOG_PAYLOAD_SIZE - 1);  // Points at the terminating zero
+                size_t length = s ? strnlen(s, room - 1) : 0;
+                if (length > 0)
+                    memcpy(data + used, s, length);
+                data[used + length] = '\0';
+                used += length + 1;
+                return offset;
+            }
+        };
+
+        // How an argument is stored in the record: values by copy, strings by content
+        template<typename T>
+        struct LogArg
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "LOG_*F arguments must be trivially copyable or strings");
+            // The record would keep only the address, read after the caller's data may be gone
+            static_assert(!std::is_pointer_v<T>, "LOG_*F pointer arguments must be strings; cast other pointers to uintptr_t");
+            using Stored = T;
+            static Stored Store(T value, LogPayloadWriter&) { return value; }
+            static T Load(Stored value, const unsigned char*) { return value; }
+        };
+
+        template<>
+        struct LogArg<const char*>
+        {
+            using Stored = uint32_t;
+            static Stored Store(const char* value, LogPayloadWriter& writer) { return writer.AppendString(value); }
+            static const char* Load(Stored offset, const unsigned char* payload) { return reinterpret_cast<const char*>(payload + offset); }
+        };
+
+        template<>
+        struct LogArg<char*> : LogArg<const char*>
+        {
+        };
+
+        template<>
+        struct LogArg<std::string>
+        {
+            using Stored = uint32_t;
+            static Stored Store(const std::string& value, LogPayloadWriter& writer) { return writer.AppendString(value.c_str()); }
+            static const char* Load(Stored offset, const unsigned char* payload) { return reinterpret_cast<const char*>(payload + offset); }
+        };
+
+        // Wide strings are converted on the calling thread; format them with %s, not %ls
+        template<>
+        struct LogArg<const wchar_t*>
+        {
+            using Stored = uint32_t;
+            static Stored Store(const wchar_t* value, LogPayloadWriter& writer) { return writer.AppendWideString(value); }
+            static const char* Load(Stored offset, const unsigned char* payload) { return reinterpret_cast<const char*>(payload + offset); }
+        };
+
+        template<>
+        struct LogArg<wchar_t*> : LogArg<const wchar_t*>
         {
-            log << prefix << message << std::endl;
-            log.close();
+        };
+
+        template<>
+        struct LogArg<std::wstring>
+        {
+            using Stored = uint32_t;
+            static Stored Store(const std::wstring& value, LogPayloadWriter& writer) { return writer.AppendWideString(value.c_str()); }
+            static const char* Load(Stored offset, const unsigned char* payload) { return reinterpret_cast<const char*>(payload + offset); }
+        };
+
+        template<typename T>
+        using LogArgOf = LogArg<std::decay_t<T>>;
+
+        template<typename... Args>
+        struct LogPack
+        {
+            const char* format;
+            std::tuple<typename LogArgOf<Args>::Stored...> args;
+        };
+
+        template<typename... Args, size_t... I>
+        void FormatPackedImpl(char* out, size_t outSize, const unsigned char* payload, std::index_sequence<I...>)
+        {
+            const auto* pack = reinterpret_cast<const LogPack<Args...>*>(payload);
+            snprintf(out, outSize, pack->format, LogArgOf<Args>::Load(std::get<I>(pack->args), payload)...);
+        }
+
+        template<typename... Args>
+        void FormatPacked(char* out, size_t outSize, const unsigned char* payload)
+        {
+            FormatPackedImpl<Args...>(out, outSize, payload, std::index_sequence_for<Args...>{});
+        }
+
+        // Reserves a record in the ring; returns nullptr (and counts a drop) when full
+        struct LogRecord;
+        LogRecord* BeginRecord(LogLevel level, LogFormatFn format, unsigned char** outPayload);
+        void CommitRecord(LogRecord* record);
+
+        void LogMessage(LogLevel level, const char* message);
+
+        template<typename... Args>
+        void LogFormat(LogLevel level, const char* format, Args&&... args)
+        {
+            static_assert(sizeof(LogPack<Args...>) < LOG_PAYLOAD_SIZE, "Too many LOG_*F arguments");
+            static_assert(alignof(LogPack<Args...>) <= 16, "Over-aligned LOG_*F argument");
+
+            unsigned char* payload = nullptr;
+            LogRecord* record = BeginRecord(level, &FormatPacked<Args...>, &payload);
+            if (!record)
+                return;
+
+            LogPayloadWriter writer{ payload, sizeof(LogPack<Args...>) };
+            new (payload) LogPack<Args...>{ format, { LogArgOf<Args>::Store(args, writer)... } };
+            CommitRecord(record);
         }
     }
 
     // ERROR log - Always output (critical errors that need immediate attention)
     inline void LogError(const char* message)
     {
-        WriteLogToFile("[ERROR] ", message);
-        OutputDebugStringA("[ERROR] ");
-        OutputDebugStringA(message);
-        OutputDebugStringA("\n");
+        LogDetail::LogMessage(LogLevel::Error, message);
     }
 
+#ifdef _WIN32
     inline void LogError(const char* message, HRESULT hr)
     {
-        char buf[512];
-        sprintf_s(buf, "%s: 0x%08X", message, hr);
-        LogError(buf);
+        LogDetail::LogFormat(LogLevel::Error, "%s: 0x%08X", message, static_cast<unsigned int>(hr));
     }
+#endif
 
     // WARN log - Output only when logging is enabled
     inline void LogWarn(const char* message)
     {
-        if (g_LogEnabled > 0)
-        {
-            WriteLogToFile("[WARN] ", message);
-        }
+        if (IsLogLevelCompiled(LogLevel::Warn) && IsLogLevelEnabled(LogLevel::Warn))
+            LogDetail::LogMessage(LogLevel::Warn, message);
     }
 
     // INFO log - Output only when logging is enabled
     inline void LogInfo(const char* message)
     {
-        if (g_LogEnabled > 0)
-        {
-            WriteLogToFile("[INFO] ", message);
-        }
+        if (IsLogLevelCompiled(LogLevel::Info) && IsLogLevelEnabled(LogLevel::Info))
+            LogDetail::LogMessage(LogLevel::Info, message);
     }
 
     // DEBUG log - Output only when logging and debug mode are enabled
     inline void LogDebug(const char* message)
     {
-        if (g_LogEnabled > 0 && g_DebugMode > 0)
-        {
-            WriteLogToFile("[DEBUG] ", message);
-        }
+        if (IsLogLevelCompiled(LogLevel::Debug) && IsLogLevelEnabled(LogLevel::Debug))
+            LogDetail::LogMessage(LogLevel::Debug, message);
     }
 
+#ifdef _WIN32
     inline void LogDebug(const char* message, HRESULT hr)
     {
-        if (g_LogEnabled > 0 && g_DebugMode > 0)
-        {
-            char buf[512];
-            sprintf_s(buf, "%s: 0x%08X", message, hr);
-            LogDebug(buf);
-        }
-    }
-
-    // Clear log file (call at startup)
-    inline void ClearLogFile()
-    {
-        std::ofstream log("C:\\git\\RayTraceVS\\debug.log", std::ios::trunc);
-        log.close();
+        if (IsLogLevelCompiled(LogLevel::Debug) && IsLogLevelEnabled(LogLevel::Debug))
+            LogDetail::LogFormat(LogLevel::Debug, "%s: 0x%08X", message, static_cast<unsigned int>(hr));
     }
+#endif
 }
 
 // Convenience macros
@@ -97,3 +271,19 @@ namespace RayTraceVS::DXEngine
 #define LOG_INFO(msg) RayTraceVS::DXEngine::LogInfo(msg)
 #define LOG_DEBUG(msg) RayTraceVS::DXEngine::LogDebug(msg)
 #define LOG_DEBUG_HR(msg, hr) RayTraceVS::DXEngine::LogDebug(msg, hr)
+
+// Deferred-format macros: printf-style, formatted on the writer thread.
+// Arguments are only evaluated when the level passes both filters.
+// String arguments (const char*, std::string) are copied; wide strings (const wchar_t*, std::wstring)
+// are copied as UTF-8 and take %s. Everything else must be trivially copyable and not a pointer.
+#define RAYTRACEVS_LOG_FORMAT(level, fmt, ...) \
+    do \
+    { \
+        if (RayTraceVS::DXEngine::IsLogLevelCompiled(level) && RayTraceVS::DXEngine::IsLogLevelEnabled(level)) \
+            RayTraceVS::DXEngine::LogDetail::LogFormat(level, fmt, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_ERRORF(fmt, ...) RAYTRACEVS_LOG_FORMAT(RayTraceVS::DXEngine::LogLevel::Error, fmt, __VA_ARGS__)
+#define LOG_WARNF(fmt, ...) RAYTRACEVS_LOG_FORMAT(RayTraceVS::DXEngine::LogLevel::Warn, fmt, __VA_ARGS__)
+#define LOG_INFOF(fmt, ...) RAYTRACEVS_LOG_FORMAT(RayTraceVS::DXEngine::LogLevel::Info, fmt, __VA_ARGS__)
+#define LOG_DEBUGF(fmt, ...) RAYTRACEVS_LOG_FORMAT(RayTraceVS::DXEngine::LogLevel::Debug, fmt, __VA_ARGS__)
@@ -779,16 +779,13 @@ namespace RayTraceVS::DXEngine
             return;
         }
 
-        char buf[256];
-        sprintf_s(buf, "NRDDenoiser::Denoise - NRD_ENABLED=%d, m_initialized=%d", NRD_ENABLED, m_initialized ? 1 : 0);
-        LOG_DEBUG(buf);
+        LOG_DEBUGF("NRDDenoiser::Denoise - NRD_ENABLED=%d, m_initialized=%d", NRD_ENABLED, m_initialized ? 1 : 0);
 
 #if NRD_ENABLED
         if (!m_nrdInstance || m_pipelineStates.empty())
         {
-            sprintf_s(buf, "NRD: Denoise not ready - instance=%p, pipelineStates.size=%zu", 
-                m_nrdInstance, m_pipelineStates.size());
-            LOG_DEBUG(buf);
+            LOG_DEBUGF("NRD: Denoise not ready - instance=0x%llx, pipelineStates.size=%zu", 
+                static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(m_nrdInstance)), m_pipelineStates.size());
             return;
         }
         LOG_DEBUG("NRDDenoiser::Denoise - NRD path active, proceeding...");
@@ -834,22 +831,18 @@ namespace RayTraceVS::DXEngine
         commonSettings.enableValidation = settings.EnableValidation;
         
         // Log NRD settings for debugging
-        sprintf_s(buf, "NRD Settings: frameIndex=%d, denoisingRange=%.1f, accumulationMode=%d (firstFrame=%d)",
+        LOG_DEBUGF("NRD Settings: frameIndex=%d, denoisingRange=%.1f, accumulationMode=%d (firstFrame=%d)",
             commonSettings.frameIndex, commonSettings.denoisingRange, (int)commonSettings.accumulationMode,
             settings.IsFirstFrame ? 1 : 0);
-        LOG_DEBUG(buf);
-        sprintf_s(buf, "NRD Settings: resourceSize=%ux%u, rectSize=%ux%u",
+        LOG_DEBUGF("NRD Settings: resourceSize=%ux%u, rectSize=%ux%u",
             commonSettings.resourceSize[0], commonSettings.resourceSize[1],
             commonSettings.rectSize[0], commonSettings.rectSize[1]);
-        LOG_DEBUG(buf);
-        sprintf_s(buf, "NRD Settings: viewToClip[0]=[%.3f, %.3f, %.3f, %.3f]",
+        LOG_DEBUGF("NRD Settings: viewToClip[0]=[%.3f, %.3f, %.3f, %.3f]",
             commonSettings.viewToClipMatrix[0], commonSettings.viewToClipMatrix[1],
             commonSettings.viewToClipMatrix[2], commonSettings.viewToClipMatrix[3]);
-        LOG_DEBUG(buf);
-        sprintf_s(buf, "NRD Settings: worldToView[0]=[%.3f, %.3f, %.3f, %.3f]",
+        LOG_DEBUGF("NRD Settings: worldToView[0]=[%.3f, %.3f, %.3f, %.3f]",
             commonSettings.worldToViewMatrix[0], commonSettings.worldToViewMatrix[1],
             commonSettings.worldToViewMatrix[2], commonSettings.worldToViewMatrix[3]);
-        LOG_DEBUG(buf);
 
         nrd::SetCommonSettings(*m_nrdInstance, commonSettings);
 
@@ -916,8 +909,7 @@ namespace RayTraceVS::DXEngine
         
         nrd::Result result = nrd::GetComputeDispatches(*m_nrdInstance, identifiers, numIdentifiers, dispatchDescs, dispatchDescsNum);
         
-        sprintf_s(buf, "NRD: GetComputeDispatches result=%d, dispatchDescsNum=%u", (int)result, dispatchDescsNum);
-        LOG_DEBUG(buf);
+        LOG_DEBUGF("NRD: GetComputeDispatches result=%d, dispatchDescsNum=%u", (int)result, dispatchDescsNum);
         
         if (result != nrd::Result::SUCCESS || dispatchDescsNum == 0)
         {
@@ -943,19 +935,17 @@ namespace RayTraceVS::DXEngine
             bool isSigmaDispatch = dispatch.name && strstr(dispatch.name, "SIGMA") != nullptr;
             if (i < 3 || isSigmaDispatch)
             {
-                sprintf_s(buf, "NRD Dispatch[%d]: name=%s, pipeline=%d, grid=%dx%d, resources=%d",
+                LOG_DEBUGF("NRD Dispatch[%d]: name=%s, pipeline=%d, grid=%dx%d, resources=%d",
                     i, dispatch.name ? dispatch.name : "null", dispatch.pipelineIndex,
                     dispatch.gridWidth, dispatch.gridHeight, dispatch.resourcesNum);
-                LOG_DEBUG(buf);
                 
                 if (i < 3)
                 {
                     for (uint32_t r = 0; r < min(dispatch.resourcesNum, 5u); r++)
                     {
                         const nrd::ResourceDesc& res = dispatch.resources[r];
-                        sprintf_s(buf, "  Resource[%d]: type=%d, indexInPool=%d",
+                        LOG_DEBUGF("  Resource[%d]: type=%d, indexInPool=%d",
                             r, (int)res.type, res.indexInPool);
-                        LOG_DEBUG(buf);
                     }
                 }
             }
@@ -969,8 +959,7 @@ namespace RayTraceVS::DXEngine
             auto psoIt = m_pipelineStates.find(dispatch.pipelineIndex);
             if (psoIt == m_pipelineStates.end())
             {
-                sprintf_s(buf, "NRD: Missing PSO for pipeline %d", dispatch.pipelineIndex);
-                LOG_DEBUG(buf);
+                LOG_DEBUGF("NRD: Missing PSO for pipeline %d", dispatch.pipelineIndex);
                 skippedCount++;
                 continue;
             }
@@ -1044,15 +1033,13 @@ namespace RayTraceVS::DXEngine
                         else if (resource.type == nrd::ResourceType::IN_PENUMBRA) typeName = "IN_PENUMBRA";
                         else if (resource.type == nrd::ResourceType::IN_TRANSLUCENCY) typeName = "IN_TRANSLUCENCY";
                         
-                        sprintf_s(buf, "NRD: Binding %s (type=%d), ptr=%p, dispatch=%s",
-                            typeName, (int)resource.type, (void*)d3dResource, dispatch.name);
-                        LOG_DEBUG(buf);
+                        LOG_DEBUGF("NRD: Binding %s (type=%d), ptr=0x%llx, dispatch=%s",
+                            typeName, (int)resource.type, static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(d3dResource)), dispatch.name);
                     }
                     
                     if (!d3dResource)
                     {
-                        sprintf_s(buf, "NRD: NULL resource for type=%d, indexInPool=%d", (int)resource.type, resource.indexInPool);
-                        LOG_DEBUG(buf);
+                        LOG_DEBUGF("NRD: NULL resource for type=%d, indexInPool=%d", (int)resource.type, resource.indexInPool);
                         continue;
                     }
 
@@ -1155,9 +1142,8 @@ namespace RayTraceVS::DXEngine
             m_resourceStateTracker.Flush(cmdList);
         }
 
-        sprintf_s(buf, "NRD: Dispatched %d, Skipped %d (PSO count=%zu)", 
+        LOG_DEBUGF("NRD: Dispatched %d, Skipped %d (PSO count=%zu)", 
             dispatchedCount, skippedCount, m_pipelineStates.size());
-        LOG_DEBUG(buf);
 
         // Ensure NRD outputs and Albedo are in SRV state for composite
         auto ToSrv = [&](ID3D12Resource* res)
@@ -1246,9 +1232,7 @@ namespace RayTraceVS::DXEngine
             break;
         default:
             {
-                char buf[128];
-                sprintf_s(buf, "NRD: Unknown resource type %d requested", (int)resource.type);
-                LOG_DEBUG(buf);
+                LOG_DEBUGF("NRD: Unknown resource type %d requested", (int)resource.type);
             }
             break;
         }
@@ -1256,10 +1240,8 @@ namespace RayTraceVS::DXEngine
         // Log if resource is null (potential crash cause)
         if (!result)
         {
-            char buf[256];
-            sprintf_s(buf, "NRD WARNING: NULL resource for %s (type=%d, indexInPool=%d)", 
+            LOG_DEBUGF("NRD WARNING: NULL resource for %s (type=%d, indexInPool=%d)", 
                 resourceName, (int)resource.type, resource.indexInPool);
-            LOG_DEBUG(buf);
         }
         
         return result;
@@ -0,0 +1,392 @@
+#include "EnvironmentMap.h"
+#include "DebugLog.h"
+#include "Scene/Scene.h"
+#include "ShaderCacheCore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr float PI = 3.14159265f;
+
+        float Saturate(float x) { return (std::min)((std::max)(x, 0.0f), 1.0f); }
+
+        float SmoothStep(float edge0, float edge1, float x)
+        {
+            const float t = Saturate((x - edge0) / (edge1 - edge0));
+            return t * t * (3.0f - 2.0f * t);
+        }
+
+        XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t)
+        {
+            return XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+        }
+
+        float Luminance(float r, float g, float b)
+        {
+            return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+        }
+
+        // Direction at lat-long coordinates (u, v) in [0, 1]
+        XMFLOAT3 DirectionFromUv(float u, float v)
+        {
+            const float phi = u * 2.0f * PI - PI;
+            const float theta = v * PI;
+            const float sinTheta = std::sin(theta);
+            return XMFLOAT3(sinTheta * std::cos(phi), std::cos(theta), sinTheta * std::sin(phi));
+        }
+
+        void UvFromDirection(const XMFLOAT3& direction, float& u, float& v)
+        {
+            const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+            const float y = length > 0.0f ? direction.y / length : 1.0f;
+            u = (std::atan2(direction.z, direction.x) + PI) / (2.0f * PI);
+            v = std::acos((std::clamp)(y, -1.0f, 1.0f)) / PI;
+        }
+
+        // One RGBE pixel (Ward's shared-exponent format)
+        XMFLOAT4 DecodeRgbe(const uint8_t rgbe[4])
+        {
+            if (rgbe[3] == 0)
+                return XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+            const float scale = std::ldexp(1.0f, static_cast<int>(rgbe[3]) - (128 + 8));
+            return XMFLOAT4(rgbe[0] * scale, rgbe[1] * scale, rgbe[2] * scale, 1.0f);
+        }
+
+        bool ReadHdrLine(std::istream& stream, std::string& line)
+        {
+            if (!std::getline(stream, line))
+                return false;
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            return true;
+        }
+
+        // One scanline: new-style run-length encoding (four planar channels) or flat RGBE
+        bool ReadHdrScanline(std::istream& stream, uint32_t width, std::vector<uint8_t>& scanline)
+        {
+            scanline.resize(static_cast<size_t>(width) * 4);
+            uint8_t header[4];
+            if (!stream.read(reinterpret_cast<char*>(header), 4))
+                return false;
+
+            const bool runLength = width >= 8 && width < 32768 && header[0] == 2 && header[1] == 2 &&
+                ((static_cast<uint32_t>(header[2]) << 8) | header[3]) == width;
+            if (!runLength)
+            {
+                memcpy(scanline.data(), header, 4);
+                return static_cast<bool>(stream.read(reinterpret_cast<char*>(scanline.data()) + 4,
+                    static_cast<std::streamsize>(scanline.size() - 4)));
+            }
+
+            for (uint32_t channel = 0; channel < 4; channel++)
+            {
+                uint32_t x = 0;
+                while (x < width)
+                {
+                    uint8_t count = 0;
+                    if (!stream.read(reinterpret_cast<char*>(&count), 1))
+                        return false;
+                    if (count > 128)
+                    {
+                        // Run of one value
+                        const uint32_t run = count - 128u;
+                        uint8_t value = 0;
+                        if (run > width - x || !stream.read(reinterpret_cast<char*>(&value), 1))
+                            return false;
+                        for (uint32_t i = 0; i < run; i++)
+                            scanline[(x++) * 4 + channel] = value;
+                    }
+                    else
+                    {
+                        // Literal values
+                        if (count == 0 || count > width - x)
+                            return false;
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            uint8_t value = 0;
+                            if (!stream.read(reinterpret_cast<char*>(&value), 1))
+                                return false;
+                            scanline[(x++) * 4 + channel] = value;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    XMFLOAT3 EvaluateProceduralSky(const XMFLOAT3& direction)
+    {
+        const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        const float elevation = length > 0.0f ? direction.y / length : 0.0f;
+        const float t = Saturate(elevation);
+        const float tBelow = Saturate(-elevation);
+
+        const XMFLOAT3 zenithColor(0.15f, 0.35f, 0.75f);
+        const XMFLOAT3 skyMidColor(0.35f, 0.55f, 0.90f);
+        const XMFLOAT3 horizonColor(0.70f, 0.80f, 0.95f);
+        const XMFLOAT3 horizonGlow(0.95f, 0.85f, 0.70f);
+        const XMFLOAT3 groundColor(0.25f, 0.28f, 0.35f);
+
+        if (elevation >= 0.0f)
+        {
+            const float horizonFade = SmoothStep(0.0f, 0.15f, t);
+            const float zenithFade = SmoothStep(0.4f, 1.0f, t);
+            XMFLOAT3 skyColor = horizonColor;
+            skyColor = Lerp(skyColor, horizonGlow, (1.0f - SmoothStep(0.0f, 0.08f, t)) * 0.4f);
+            skyColor = Lerp(skyColor, skyMidColor, horizonFade);
+            skyColor = Lerp(skyColor, zenithColor, zenithFade);
+            return Lerp(skyColor, horizonColor, std::exp(-t * 8.0f) * 0.3f);
+        }
+
+        const float groundFade = SmoothStep(0.0f, 0.3f, tBelow);
+        const XMFLOAT3 ground = Lerp(horizonColor, groundColor, groundFade);
+        const float darken = 0.8f + (0.4f - 0.8f) * groundFade;
+        return XMFLOAT3(ground.x * darken, ground.y * darken, ground.z * darken);
+    }
+
+    // ============================================
+    // Loading
+    // ============================================
+
+    bool EnvironmentMap::Update(const Scene& scene)
+    {
+        intensity = scene.GetEnvironmentIntensity();
+        lighting = scene.GetEnvironmentLighting();
+
+        const std::wstring& path = scene.GetEnvironmentPath();
+        if (loaded && path == loadedPath)
+            return false;
+        loaded = true;
+        loadedPath = path;
+
+        if (!path.empty() && LoadHdr(path))
+        {
+            procedural = false;
+            LOG_INFOF("[EnvironmentMap] Loaded %s (%ux%u)", ToUtf8(path), width, height);
+        }
+        else
+        {
+            if (!path.empty())
+                LOG_WARNF("[EnvironmentMap] Could not load %s - using the built-in sky", ToUtf8(path));
+            BakeProceduralSky();
+            procedural = true;
+        }
+        BuildAliasTables();
+        return true;
+    }
+
+    bool EnvironmentMap::LoadHdr(const std::wstring& path)
+    {
+        std::ifstream stream(std::filesystem::path(path), std::ios::binary);
+        if (!stream)
+            return false;
+
+        std::string line;
+        if (!ReadHdrLine(stream, line) || (line.rfind("#?RADIANCE", 0) != 0 && line.rfind("#?RGBE", 0) != 0))
+            return false;
+
+        // Header lines up to the blank separator; only RGBE pixels are supported
+        while (ReadHdrLine(stream, line) && !line.empty())
+        {
+            if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe")
+                return false;
+        }
+
+        // Resolution string; only the standard top-to-bottom, left-to-right orientation
+        if (!ReadHdrLine(stream, line))
+            return false;
+        std::istringstream resolution(line);
+        std::string yAxis, xAxis;
+        uint32_t fileHeight = 0, fileWidth = 0;
+        if (!(resolution >> yAxis >> fileHeight >> xAxis >> fileWidth) || yAxis != "-Y" || xAxis != "+X" ||
+            fileWidth == 0 || fileHeight == 0)
+        {
+            return false;
+        }
+
+        std::vector<XMFLOAT4> pixels(static_cast<size_t>(fileWidth) * fileHeight);
+        std::vector<uint8_t> scanline;
+        for (uint32_t y = 0; y < fileHeight; y++)
+        {
+            if (!ReadHdrScanline(stream, fileWidth, scanline))
+                return false;
+            for (uint32_t x = 0; x < fileWidth; x++)
+                pixels[static_cast<size_t>(y) * fileWidth + x] = DecodeRgbe(&scanline[static_cast<size_t>(x) * 4]);
+        }
+
+        texels.swap(pixels);
+        width = fileWidth;
+        height = fileHeight;
+        return true;
+    }
+
+    void EnvironmentMap::BakeProceduralSky()
+    {
+        width = PROCEDURAL_WIDTH;
+        height = PROCEDURAL_HEIGHT;
+        texels.resize(static_cast<size_t>(width) * height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const XMFLOAT3 color = EvaluateProceduralSky(DirectionFromUv((x + 0.5f) / width, (y + 0.5f) / height));
+                texels[static_cast<size_t>(y) * width + x] = XMFLOAT4(color.x, color.y, color.z, 1.0f);
+            }
+        }
+    }
+
+    // ============================================
+    // Sampling tables
+    // ============================================
+
+    void EnvironmentMap::BuildAliasTables()
+    {
+        aliasTable.assign(height + static_cast<size_t>(width) * height, GPUEnvironmentAliasEntry{});
+
+        // Vose's alias method over weights[0..count) into aliasTable[offset..offset + count)
+        std::vector<double> scaled;
+        std::vector<uint32_t> small, large;
+        auto build = [&](uint32_t offset, const double* weights, uint32_t count)
+        {
+            double total = 0.0;
+            for (uint32_t i = 0; i < count; i++)
+                total += weights[i];
+
+            scaled.resize(count);
+            small.clear();
+            large.clear();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                // All-black tables fall back to uniform so sampling stays well defined
+                const double probability = total > 0.0 ? weights[i] / total : 1.0 / count;
+                aliasTable[offset + i].Pdf = static_cast<float>(probability);
+                aliasTable[offset + i].Alias = i;
+                scaled[i] = probability * count;
+                (scaled[i] < 1.0 ? small : large).push_back(i);
+            }
+
+            while (!small.empty() && !large.empty())
+            {
+                const uint32_t less = small.back();
+                small.pop_back();
+                const uint32_t more = large.back();
+                aliasTable[offset + less].Threshold = static_cast<float>(scaled[less]);
+                aliasTable[offset + less].Alias = more;
+                scaled[more] -= 1.0 - scaled[less];
+                if (scaled[more] < 1.0)
+                {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+            // Leftovers are 1 up to rounding
+            for (uint32_t i : small)
+                aliasTable[offset + i].Threshold = 1.0f;
+            for (uint32_t i : large)
+                aliasTable[offset + i].Threshold = 1.0f;
+        };
+
+        std::vector<double> rowWeights(height);
+        std::vector<double> texelWeights(width);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const double sinTheta = std::sin((y + 0.5) / height * PI);
+            double rowTotal = 0.0;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const XMFLOAT4& texel = texels[static_cast<size_t>(y) * width + x];
+                texelWeights[x] = (std::max)(Luminance(texel.x, texel.y, texel.z), 0.0f) * sinTheta;
+                rowTotal += texelWeights[x];
+            }
+            rowWeights[y] = rowTotal;
+            build(height + y * width, texelWeights.data(), width);
+        }
+        build(0, rowWeights.data(), height);
+    }
+
+    uint32_t EnvironmentMap::SampleAlias(uint32_t offset, uint32_t count, float u) const
+    {
+        const float scaled = u * count;
+        const uint32_t index = (std::min)(static_cast<uint32_t>(scaled), count - 1);
+        const GPUEnvironmentAliasEntry& entry = aliasTable[offset + index];
+        return (scaled - index) < entry.Threshold ? index : entry.Alias;
+    }
+
+    // ============================================
+    // Queries
+    // ============================================
+
+    XMFLOAT3 EnvironmentMap::Lookup(const XMFLOAT3& direction) const
+    {
+        if (texels.empty())
+            return XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+        float u, v;
+        UvFromDirection(direction, u, v);
+        const float x = u * width - 0.5f;
+        const float y = (std::clamp)(v * height - 0.5f, 0.0f, static_cast<float>(height - 1));
+        const float x0f = std::floor(x);
+        const float y0f = std::floor(y);
+        const float fx = x - x0f;
+        const float fy = y - y0f;
+        const uint32_t x0 = static_cast<uint32_t>(static_cast<int32_t>(x0f) + static_cast<int32_t>(width)) % width;
+        const uint32_t x1 = (x0 + 1) % width;
+        const uint32_t y0 = static_cast<uint32_t>(y0f);
+        const uint32_t y1 = (std::min)(y0 + 1, height - 1);
+
+        auto at = [&](uint32_t tx, uint32_t ty) -> const XMFLOAT4& { return texels[static_cast<size_t>(ty) * width + tx]; };
+        const XMFLOAT4& a = at(x0, y0);
+        const XMFLOAT4& b = at(x1, y0);
+        const XMFLOAT4& c = at(x0, y1);
+        const XMFLOAT4& d = at(x1, y1);
+        const float wa = (1.0f - fx) * (1.0f - fy), wb = fx * (1.0f - fy), wc = (1.0f - fx) * fy, wd = fx * fy;
+        return XMFLOAT3((a.x * wa + b.x * wb + c.x * wc + d.x * wd) * intensity,
+            (a.y * wa + b.y * wb + c.y * wc + d.y * wd) * intensity,
+            (a.z * wa + b.z * wb + c.z * wc + d.z * wd) * intensity);
+    }
+
+    XMFLOAT3 EnvironmentMap::Sample(float u1, float u2, float u3, float u4, float& pdf) const
+    {
+        pdf = 0.0f;
+        if (aliasTable.empty())
+            return XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+        const uint32_t row = SampleAlias(0, height, u1);
+        const uint32_t column = SampleAlias(height + row * width, width, u2);
+        const float u = (column + u3) / width;
+        const float v = (row + u4) / height;
+        const float sinTheta = std::sin(v * PI);
+        if (sinTheta > 0.0f)
+        {
+            const float pmf = aliasTable[row].Pdf * aliasTable[height + row * width + column].Pdf;
+            pdf = pmf * width * height / (2.0f * PI * PI * sinTheta);
+        }
+        return DirectionFromUv(u, v);
+    }
+
+    float EnvironmentMap::Pdf(const XMFLOAT3& direction) const
+    {
+        if (aliasTable.empty())
+            return 0.0f;
+
+        float u, v;
+        UvFromDirection(direction, u, v);
+        const float sinTheta = std::sin(v * PI);
+        if (sinTheta <= 0.0f)
+            return 0.0f;
+        const uint32_t column = (std::min)(static_cast<uint32_t>(u * width), width - 1);
+        const uint32_t row = (std::min)(static_cast<uint32_t>(v * height), height - 1);
+        const float pmf = aliasTable[row].Pdf * aliasTable[height + row * width + column].Pdf;
+        return pmf * width * height / (2.0f * PI * PI * sinTheta);
+    }
+}
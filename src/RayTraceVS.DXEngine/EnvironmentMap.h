@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+// ============================================
+// Environment map
+// ============================================
+//
+// Radiance arriving from infinitely far away, stored as an equirectangular (lat-long)
+// table. It comes from a Radiance .hdr file, or, when the scene names none (or the file
+// cannot be read), from the built-in sky gradient baked into a small table. Either way a
+// miss is one filtered table fetch instead of evaluating the analytic sky per ray.
+//
+// Mapping: u = (atan2(z, x) + pi) / 2pi, v = acos(y) / pi, so row 0 is the zenith.
+//
+// For sampling, texels are weighted by luminance * sin(theta) (their solid angle) and
+// put into alias tables: one over the rows (marginal) and one per row (conditional), so
+// drawing a direction is two O(1) lookups. Sample() and Pdf() agree exactly, which is what
+// MIS against BSDF sampling needs. The GPU layouts must match EnvironmentAliasEntry and
+// the environment lookups in Common.hlsli.
+
+namespace RayTraceVS::DXEngine
+{
+    class Scene;
+
+    struct alignas(16) GPUEnvironmentAliasEntry
+    {
+        float Threshold;                // Keep this entry when the in-bucket uniform is below it
+        uint32_t Alias;                 // Otherwise take this one
+        float Pdf;                      // Discrete probability of the entry within its table
+        float Padding;
+    };
+
+    // Built-in sky gradient (formerly GetSkyColor in Common.hlsli); baked when no .hdr is set
+    DirectX::XMFLOAT3 EvaluateProceduralSky(const DirectX::XMFLOAT3& direction);
+
+    class EnvironmentMap
+    {
+    public:
+        static constexpr uint32_t PROCEDURAL_WIDTH = 256;
+        static constexpr uint32_t PROCEDURAL_HEIGHT = 128;
+
+        // Follows the scene's environment settings. Returns true when the texels (and with
+        // them the sampling tables) changed; intensity and lighting never reload the table.
+        bool Update(const Scene& scene);
+
+        // Radiance towards the direction (bilinear, wrapping in u and clamped in v), including intensity
+        DirectX::XMFLOAT3 Lookup(const DirectX::XMFLOAT3& direction) const;
+        // Importance-samples a direction from four uniforms in [0, 1); pdf is per solid angle
+        DirectX::XMFLOAT3 Sample(float u1, float u2, float u3, float u4, float& pdf) const;
+        // Solid-angle density with which Sample produces the direction
+        float Pdf(const DirectX::XMFLOAT3& direction) const;
+
+        uint32_t GetWidth() const { return width; }
+        uint32_t GetHeight() const { return height; }
+        float GetIntensity() const { return intensity; }
+        bool GetLighting() const { return lighting; }
+        bool IsProcedural() const { return procedural; }
+        // Linear RGB, width * height, row 0 at the zenith (alpha unused)
+        const std::vector<DirectX::XMFLOAT4>& GetTexels() const { return texels; }
+        // Marginal table over the rows (height entries), then one conditional table per row (width entries each)
+        const std::vector<GPUEnvironmentAliasEntry>& GetAliasTable() const { return aliasTable; }
+
+    private:
+        bool LoadHdr(const std::wstring& path);
+        void BakeProceduralSky();
+        void BuildAliasTables();
+        uint32_t SampleAlias(uint32_t offset, uint32_t count, float u) const;
+
+        std::vector<DirectX::XMFLOAT4> texels;
+        std::vector<GPUEnvironmentAliasEntry> aliasTable;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        float intensity = 1.0f;
+        bool lighting = false;
+        bool procedural = true;
+        bool loaded = false;
+        std::wstring loadedPath;
+    };
+}
@@ -0,0 +1,274 @@
+#include "FrameChannel.h"
+#include "DebugLog.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr uint64_t PIXEL_ALIGNMENT = 256;
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    FrameChannel::~FrameChannel()
+    {
+        Close();
+    }
+
+    bool FrameChannel::Create(const std::string& name, uint32_t width, uint32_t height, FrameFormat format, uint32_t slotCount)
+    {
+        Close();
+        if (name.empty() || width == 0 || height == 0 || slotCount < MIN_SLOTS || slotCount > MAX_SLOTS)
+        {
+            LOG_WARNF("FrameChannel::Create: invalid size %ux%u or slot count %u", width, height, slotCount);
+            return false;
+        }
+
+        const uint64_t slotBytes = AlignUp(static_cast<uint64_t>(width) * height * GetFrameFormatBytesPerPixel(format), PIXEL_ALIGNMENT);
+        const uint64_t pixelOffset = AlignUp(sizeof(Header), PIXEL_ALIGNMENT);
+        if (!Map(name, pixelOffset + slotBytes * slotCount, true))
+            return false;
+
+        // Fresh header; magic last so a reader never sees a half-initialized channel
+        std::memset(static_cast<void*>(header), 0, sizeof(Header));
+        header->version = VERSION;
+        header->slotCount = slotCount;
+        header->slotBytes = slotBytes;
+        header->pixelOffset = pixelOffset;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = MAGIC;
+
+        writer = true;
+        publishedFrames = 0;
+        LOG_INFOF("FrameChannel: created '%s' (%u slots of %llu bytes)", name.c_str(), slotCount,
+            static_cast<unsigned long long>(slotBytes));
+        return true;
+    }
+
+    bool FrameChannel::Open(const std::string& name)
+    {
+        Close();
+        if (name.empty() || !Map(name, 0, false))
+            return false;
+
+        const bool valid = mappedSize >= sizeof(Header) && header->magic == MAGIC && header->version == VERSION &&
+            header->slotCount >= MIN_SLOTS && header->slotCount <= MAX_SLOTS &&
+            header->pixelOffset + header->slotBytes * header->slotCount <= mappedSize;
+        if (!valid)
+        {
+            LOG_WARNF("FrameChannel::Open: '%s' is not a frame channel (or a different version)", name.c_str());
+            Close();
+            return false;
+        }
+
+        lastReadFrame = 0;
+        return true;
+    }
+
+    void FrameChannel::Close()
+    {
+        if (!header)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(header);
+        CloseHandle(static_cast<HANDLE>(mapping));
+#else
+        munmap(header, mappedSize);
+        if (writer)
+            shm_unlink(shmName.c_str());
+#endif
+        header = nullptr;
+        mapping = nullptr;
+        mappedSize = 0;
+        shmName.clear();
+        writer = writing = reading = false;
+    }
+
+    bool FrameChannel::Map(const std::string& name, uint64_t size, bool create)
+    {
+#ifdef _WIN32
+        const std::string objectName = "Local\\RayTraceVS." + name;
+        HANDLE handle = create
+            ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), objectName.c_str())
+            : OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, objectName.c_str());
+        if (!handle)
+        {
+            LOG_WARNF("FrameChannel: cannot %s '%s' (error %lu)", create ? "create" : "open", objectName.c_str(), GetLastError());
+            return false;
+        }
+
+        void* view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(size));
+        if (!view)
+        {
+            // An existing mapping of another size (a previous writer) cannot be resized
+            LOG_WARNF("FrameChannel: cannot map '%s' (error %lu)", objectName.c_str(), GetLastError());
+            CloseHandle(handle);
+            return false;
+        }
+        if (!create)
+        {
+            MEMORY_BASIC_INFORMATION info = {};
+            VirtualQuery(view, &info, sizeof(info));
+            size = info.RegionSize;
+        }
+        mapping = handle;
+#else
+        const std::string objectName = "/RayTraceVS." + name;
+        int fd = shm_open(objectName.c_str(), create ? (O_CREAT | O_RDWR) : O_RDWR, 0600);
+        if (fd < 0)
+        {
+            LOG_WARNF("FrameChannel: cannot %s '%s'", create ? "create" : "open", objectName.c_str());
+            return false;
+        }
+
+        struct stat info = {};
+        if ((create && ftruncate(fd, static_cast<off_t>(size)) != 0) || fstat(fd, &info) != 0)
+        {
+            LOG_WARNF("FrameChannel: cannot size '%s'", objectName.c_str());
+            close(fd);
+            return false;
+        }
+        size = static_cast<uint64_t>(info.st_size);
+
+        void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            LOG_WARNF("FrameChannel: cannot map '%s'", objectName.c_str());
+            return false;
+        }
+        shmName = objectName;
+#endif
+        header = static_cast<Header*>(view);
+        mappedSize = size;
+        return true;
+    }
+
+    uint8_t* FrameChannel::GetSlotPixels(uint32_t slot) const
+    {
+        return reinterpret_cast<uint8_t*>(header) + header->pixelOffset + header->slotBytes * slot;
+    }
+
+    bool FrameChannel::BeginWrite(uint32_t width, uint32_t height, FrameFormat format, FrameBufferView& view)
+    {
+        if (!header || !writer || writing)
+            return false;
+
+        const uint32_t rowPitch = width * GetFrameFormatBytesPerPixel(format);
+        if (width == 0 || height == 0 || static_cast<uint64_t>(rowPitch) * height > header->slotBytes)
+        {
+            LOG_WARNF("FrameChannel::BeginWrite: %ux%u does not fit a slot", width, height);
+            return false;
+        }
+
+        // Oldest slot of the ring; a reader still on it sees the odd sequence in EndRead
+        writeSlot = static_cast<uint32_t>(publishedFrames % header->slotCount);
+        Slot& slot = header->slots[writeSlot];
+        slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.width.store(width, std::memory_order_relaxed);
+        slot.height.store(height, std::memory_order_relaxed);
+        slot.format.store(static_cast<uint32_t>(format), std::memory_order_relaxed);
+
+        view.data = GetSlotPixels(writeSlot);
+        view.width = width;
+        view.height = height;
+        view.rowPitch = rowPitch;
+        view.format = format;
+        writing = true;
+        return true;
+    }
+
+    void FrameChannel::EndWrite(bool publish)
+    {
+        if (!writing)
+            return;
+
+        Slot& slot = header->slots[writeSlot];
+        if (publish)
+            slot.frameIndex.store(++publishedFrames, std::memory_order_relaxed);
+        else
+            slot.frameIndex.store(0, std::memory_order_relaxed);
+        slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        if (publish)
+        {
+            header->latestSlot.store(writeSlot, std::memory_order_release);
+            header->latestFrame.store(publishedFrames, std::memory_order_release);
+        }
+        writing = false;
+    }
+
+    bool FrameChannel::BeginRead(FrameBufferView& view, uint64_t& frameIndex)
+    {
+        if (!header || writer || reading || header->latestFrame.load(std::memory_order_acquire) == 0)
+            return false;
+
+        const uint32_t slotIndex = header->latestSlot.load(std::memory_order_acquire);
+        if (slotIndex >= header->slotCount)
+            return false;
+
+        const Slot& slot = header->slots[slotIndex];
+        const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            return false;       // Being rewritten; poll again
+
+        const uint32_t width = slot.width.load(std::memory_order_relaxed);
+        const uint32_t height = slot.height.load(std::memory_order_relaxed);
+        const uint32_t format = slot.format.load(std::memory_order_relaxed);
+        const uint64_t index = slot.frameIndex.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+            return false;
+
+        // Any other index is new (a restarted writer counts from 1 again)
+        if (index == 0 || index == lastReadFrame || format > static_cast<uint32_t>(FrameFormat::Rgba32Float))
+            return false;
+        const uint32_t rowPitch = width * GetFrameFormatBytesPerPixel(static_cast<FrameFormat>(format));
+        if (static_cast<uint64_t>(rowPitch) * height > header->slotBytes)
+            return false;
+
+        view.data = GetSlotPixels(slotIndex);
+        view.width = width;
+        view.height = height;
+        view.rowPitch = rowPitch;
+        view.format = static_cast<FrameFormat>(format);
+        frameIndex = index;
+
+        readSlot = slotIndex;
+        readSequence = sequence;
+        lastReadFrame = index;
+        reading = true;
+        return true;
+    }
+
+    bool FrameChannel::EndRead()
+    {
+        if (!reading)
+            return false;
+
+        reading = false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return header->slots[readSlot].sequence.load(std::memory_order_relaxed) == readSequence;
+    }
+
+    uint64_t FrameChannel::GetLatestFrameIndex() const
+    {
+        return header ? header->latestFrame.load(std::memory_order_acquire) : 0;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FrameSink.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// ============================================
+// Shared-memory frame channel
+// ============================================
+//
+// Streams finished frames from a renderer process to a viewer process through a named
+// shared-memory region (Windows: page-file backed file mapping, POSIX: shm_open), so a
+// slow frame in the renderer never blocks the viewer's UI thread.
+//
+// The region is a small header followed by a ring of frame slots. Each slot carries its
+// own seqlock: the writer makes the sequence odd, writes dimensions, format, frame index
+// and pixels, then makes it even again. A reader takes the latest published slot and
+// reads the pixels in place (no copy); EndRead re-checks the sequence and reports
+// whether the writer lapped the ring while the frame was being consumed. With
+// slotCount slots the reader has slotCount - 1 frame times before that happens.
+//
+// The writer side hands out a FrameBufferView into the slot, so RenderTarget::ReadPixels
+// and CpuPathTracer::Render write straight into shared memory as well.
+
+namespace RayTraceVS::DXEngine
+{
+    class FrameChannel
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x43465652;      // 'RVFC'
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t MIN_SLOTS = 2;
+        static constexpr uint32_t MAX_SLOTS = 8;
+
+        FrameChannel() = default;
+        ~FrameChannel();
+        FrameChannel(const FrameChannel&) = delete;
+        FrameChannel& operator=(const FrameChannel&) = delete;
+
+        // Producer: creates (or takes over) the channel. Every slot holds one frame of up
+        // to width * height pixels of format.
+        bool Create(const std::string& name, uint32_t width, uint32_t height, FrameFormat format, uint32_t slotCount);
+        // Consumer: opens a channel created by another process
+        bool Open(const std::string& name);
+        void Close();
+
+        // Producer: the next slot of the ring, marked as being written. Frames may be
+        // smaller than the channel size; the row pitch is width * bytes-per-pixel.
+        bool BeginWrite(uint32_t width, uint32_t height, FrameFormat format, FrameBufferView& view);
+        void EndWrite(bool publish);
+
+        // Consumer (poll): the latest published frame if it is newer than the last one
+        // returned. view points into shared memory and stays readable until EndRead.
+        bool BeginRead(FrameBufferView& view, uint64_t& frameIndex);
+        // false if the frame was overwritten while it was being read (discard it)
+        bool EndRead();
+
+        bool IsOpen() const { return header != nullptr; }
+        bool IsWriter() const { return writer; }
+        uint64_t GetLatestFrameIndex() const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint32_t> sequence;     // Odd while being written
+            std::atomic<uint32_t> width;
+            std::atomic<uint32_t> height;
+            std::atomic<uint32_t> format;
+            std::atomic<uint64_t> frameIndex;
+        };
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t slotCount;
+            uint32_t reserved;
+            uint64_t slotBytes;                 // Pixel bytes per slot
+            uint64_t pixelOffset;               // From the start of the region to slot 0
+            std::atomic<uint64_t> latestFrame;  // 0 = nothing published yet
+            std::atomic<uint32_t> latestSlot;
+            uint32_t padding;
+            Slot slots[MAX_SLOTS];
+        };
+
+        static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+            "the frame channel header is shared between processes and needs address-free atomics");
+
+        bool Map(const std::string& name, uint64_t size, bool create);
+        uint8_t* GetSlotPixels(uint32_t slot) const;
+
+        Header* header = nullptr;
+        uint64_t mappedSize = 0;
+        void* mapping = nullptr;                // Windows: file mapping handle
+        std::string shmName;                    // POSIX: name to unlink on Close (writer)
+        bool writer = false;
+
+        uint32_t writeSlot = 0;
+        bool writing = false;
+        uint64_t publishedFrames = 0;
+
+        uint32_t readSlot = 0;
+        uint32_t readSequence = 0;
+        bool reading = false;
+        uint64_t lastReadFrame = 0;
+    };
+}
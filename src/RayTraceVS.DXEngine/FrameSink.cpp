@@ -0,0 +1,123 @@
+#include "FrameSink.h"
+#include "DebugLog.h"
+
+namespace RayTraceVS::DXEngine
+{
+    uint32_t GetFrameFormatBytesPerPixel(FrameFormat format)
+    {
+        return format == FrameFormat::Rgba32Float ? 16u : 4u;
+    }
+
+    bool FrameSink::Configure(uint32_t newWidth, uint32_t newHeight, FrameFormat newFormat, uint32_t newRowPitch,
+        uint8_t* const* newBuffers, uint32_t newBufferCount)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bufferCount = 0;
+        writing = reading = latest = NO_BUFFER;
+
+        if (newWidth == 0 || newHeight == 0 || !newBuffers ||
+            newBufferCount < MIN_BUFFERS || newBufferCount > MAX_BUFFERS)
+        {
+            LOG_WARNF("FrameSink::Configure: invalid size %ux%u or buffer count %u", newWidth, newHeight, newBufferCount);
+            return false;
+        }
+        if (newRowPitch < newWidth * GetFrameFormatBytesPerPixel(newFormat))
+        {
+            LOG_WARNF("FrameSink::Configure: row pitch %u is smaller than a row", newRowPitch);
+            return false;
+        }
+        for (uint32_t i = 0; i < newBufferCount; i++)
+        {
+            if (!newBuffers[i])
+            {
+                LOG_WARNF("FrameSink::Configure: buffer %u is null", i);
+                return false;
+            }
+            buffers[i] = newBuffers[i];
+        }
+
+        width = newWidth;
+        height = newHeight;
+        format = newFormat;
+        rowPitch = newRowPitch;
+        bufferCount = newBufferCount;
+        return true;
+    }
+
+    void FrameSink::Reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bufferCount = 0;
+        writing = reading = latest = NO_BUFFER;
+    }
+
+    bool FrameSink::BeginWrite(FrameBufferView& view)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (bufferCount == 0 || writing != NO_BUFFER)
+            return false;
+
+        uint32_t candidate = NO_BUFFER;
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            if (i == reading)
+                continue;
+            if (i != latest)
+            {
+                candidate = i;
+                break;
+            }
+            candidate = i;      // Only the unread latest frame is free (two buffers)
+        }
+        if (candidate == NO_BUFFER)
+            return false;
+        if (candidate == latest)
+            latest = NO_BUFFER;
+
+        writing = candidate;
+        view = MakeView(candidate);
+        return true;
+    }
+
+    void FrameSink::EndWrite(bool publish)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (writing == NO_BUFFER)
+            return;
+        if (publish)
+        {
+            latest = writing;
+            latestFrame = ++publishedFrames;
+        }
+        writing = NO_BUFFER;
+    }
+
+    bool FrameSink::BeginRead(FrameBufferView& view, uint64_t& frameNumber)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (reading != NO_BUFFER || latest == NO_BUFFER)
+            return false;
+
+        reading = latest;
+        frameNumber = latestFrame;
+        view = MakeView(reading);
+        return true;
+    }
+
+    void FrameSink::EndRead()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reading = NO_BUFFER;
+    }
+
+    FrameBufferView FrameSink::MakeView(uint32_t index) const
+    {
+        FrameBufferView view;
+        view.data = buffers[index];
+        view.width = width;
+        view.height = height;
+        view.rowPitch = rowPitch;
+        view.format = format;
+        return view;
+    }
+}
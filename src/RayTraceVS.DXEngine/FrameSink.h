@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+// ============================================
+// Frame sink
+// ============================================
+//
+// Destination for finished frames in memory owned by the caller. The caller registers
+// two or three buffers with an explicit row pitch; a backend writes the next frame
+// straight into one of them (GPU: RenderTarget::ReadPixels from the mapped readback
+// heap, CPU: CpuPathTracer::Render), and the consumer reads the latest completed one.
+// The buffer being read is never handed to the writer, so with three buffers the next
+// frame renders while the previous one is still being consumed. With two buffers a
+// published but unread frame may be overwritten by a newer one.
+//
+// Nothing is allocated per frame; the sink only rotates indices under a mutex.
+
+namespace RayTraceVS::DXEngine
+{
+    enum class FrameFormat : uint32_t
+    {
+        Rgba8 = 0,          // Render target layout
+        Bgra8 = 1,          // WPF Bgra32 (swizzled while copying)
+        Rgba32Float = 2     // Linear HDR radiance (CPU path tracer)
+    };
+
+    uint32_t GetFrameFormatBytesPerPixel(FrameFormat format);
+
+    // A caller-owned image: rows of rowPitch bytes, width * bytes-per-pixel of them used
+    struct FrameBufferView
+    {
+        uint8_t* data = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t rowPitch = 0;
+        FrameFormat format = FrameFormat::Rgba8;
+
+        uint8_t* GetRow(uint32_t y) const { return data + static_cast<size_t>(y) * rowPitch; }
+    };
+
+    class FrameSink
+    {
+    public:
+        static constexpr uint32_t MIN_BUFFERS = 2;
+        static constexpr uint32_t MAX_BUFFERS = 3;
+        static constexpr uint32_t NO_BUFFER = 0xFFFFFFFFu;
+
+        // buffers: bufferCount blocks of at least height * rowPitch bytes each. They stay
+        // owned by the caller and must outlive the sink (or the next Configure).
+        bool Configure(uint32_t width, uint32_t height, FrameFormat format, uint32_t rowPitch,
+            uint8_t* const* buffers, uint32_t bufferCount);
+        void Reset();
+
+        // Producer: a buffer that is not being read, preferring one that does not hold the
+        // latest frame. EndWrite(true) publishes it as the latest frame.
+        bool BeginWrite(FrameBufferView& view);
+        void EndWrite(bool publish);
+
+        // Consumer: the latest published frame. It stays untouched until EndRead; reading
+        // again without a newer frame returns the same frame number.
+        bool BeginRead(FrameBufferView& view, uint64_t& frameNumber);
+        void EndRead();
+
+        bool IsConfigured() const { return bufferCount > 0; }
+        uint32_t GetWidth() const { return width; }
+        uint32_t GetHeight() const { return height; }
+        FrameFormat GetFormat() const { return format; }
+
+    private:
+        FrameBufferView MakeView(uint32_t index) const;
+
+        std::mutex mutex;
+        uint8_t* buffers[MAX_BUFFERS] = {};
+        uint32_t bufferCount = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t rowPitch = 0;
+        FrameFormat format = FrameFormat::Rgba8;
+
+        uint32_t writing = NO_BUFFER;
+        uint32_t reading = NO_BUFFER;
+        uint32_t latest = NO_BUFFER;
+        uint64_t latestFrame = 0;
+        uint64_t publishedFrames = 0;
+    };
+}
@@ -0,0 +1,548 @@
+#include "LightBvh.h"
+#include "CpuAccelerationStructure.h"
+#include "Scene/Scene.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr float PI = 3.14159265f;
+
+        float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        float Length(const XMFLOAT3& a) { return std::sqrt(Dot(a, a)); }
+
+        XMFLOAT3 Normalize(const XMFLOAT3& a)
+        {
+            const float length = Length(a);
+            return length > 0.0f ? XMFLOAT3(a.x / length, a.y / length, a.z / length) : XMFLOAT3(0.0f, 0.0f, 1.0f);
+        }
+
+        XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+        {
+            return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        }
+
+        float Luminance(float r, float g, float b)
+        {
+            return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+        }
+
+        float SafeSqrt(float x) { return std::sqrt((std::max)(x, 0.0f)); }
+        float SafeAcos(float x) { return std::acos((std::clamp)(x, -1.0f, 1.0f)); }
+
+        // cos(max(0, a - b)) from the cosines and sines of a and b
+        float CosSubClamped(float sinA, float cosA, float sinB, float cosB)
+        {
+            return (cosA > cosB) ? 1.0f : cosA * cosB + sinA * sinB;
+        }
+
+        // sin(max(0, a - b))
+        float SinSubClamped(float sinA, float cosA, float sinB, float cosB)
+        {
+            return (cosA > cosB) ? 0.0f : sinA * cosB - cosA * sinB;
+        }
+
+        // ============================================
+        // Orientation cones
+        // ============================================
+
+        struct Cone
+        {
+            XMFLOAT3 axis = { 0.0f, 0.0f, 1.0f };
+            float cosThetaO = 1.0f;
+            float cosThetaE = 0.0f;
+            bool empty = true;
+        };
+
+        // Emitters here radiate from every point of their surface in all directions:
+        // normals cover the whole sphere, each one emitting over a hemisphere
+        Cone OmnidirectionalCone()
+        {
+            Cone cone;
+            cone.cosThetaO = -1.0f;
+            cone.cosThetaE = 0.0f;
+            cone.empty = false;
+            return cone;
+        }
+
+        XMFLOAT3 RotateAround(const XMFLOAT3& v, const XMFLOAT3& axis, float angle)
+        {
+            // Rodrigues' rotation formula
+            const float c = std::cos(angle);
+            const float s = std::sin(angle);
+            const XMFLOAT3 k = Normalize(axis);
+            const XMFLOAT3 kxv = Cross(k, v);
+            const float kdv = Dot(k, v);
+            return XMFLOAT3(v.x * c + kxv.x * s + k.x * kdv * (1.0f - c),
+                v.y * c + kxv.y * s + k.y * kdv * (1.0f - c),
+                v.z * c + kxv.z * s + k.z * kdv * (1.0f - c));
+        }
+
+        // Smallest cone holding both (Conty Estevez and Kulla, Algorithm 1)
+        Cone Union(const Cone& a, const Cone& b)
+        {
+            if (a.empty)
+                return b;
+            if (b.empty)
+                return a;
+
+            Cone result;
+            result.empty = false;
+            result.cosThetaE = (std::min)(a.cosThetaE, b.cosThetaE);
+
+            const float thetaA = SafeAcos(a.cosThetaO);
+            const float thetaB = SafeAcos(b.cosThetaO);
+            const float thetaD = SafeAcos(Dot(a.axis, b.axis));
+            if ((std::min)(thetaD + thetaB, PI) <= thetaA)
+            {
+                result.axis = a.axis;
+                result.cosThetaO = a.cosThetaO;
+                return result;
+            }
+            if ((std::min)(thetaD + thetaA, PI) <= thetaB)
+            {
+                result.axis = b.axis;
+                result.cosThetaO = b.cosThetaO;
+                return result;
+            }
+
+            const float thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+            const XMFLOAT3 rotationAxis = Cross(a.axis, b.axis);
+            if (thetaO >= PI || Dot(rotationAxis, rotationAxis) < 1e-12f)
+            {
+                result.axis = a.axis;
+                result.cosThetaO = -1.0f;
+                return result;
+            }
+            result.axis = Normalize(RotateAround(a.axis, rotationAxis, thetaO - thetaA));
+            result.cosThetaO = std::cos(thetaO);
+            return result;
+        }
+
+        // Orientation measure M_Omega of the SAOH
+        float OrientationMeasure(const Cone& cone)
+        {
+            const float thetaO = SafeAcos(cone.cosThetaO);
+            const float thetaE = SafeAcos(cone.cosThetaE);
+            const float thetaW = (std::min)(thetaO + thetaE, PI);
+            const float sinThetaO = SafeSqrt(1.0f - cone.cosThetaO * cone.cosThetaO);
+            return 2.0f * PI * (1.0f - cone.cosThetaO) +
+                PI * 0.5f * (2.0f * thetaW * sinThetaO - std::cos(thetaO - 2.0f * thetaW) -
+                    2.0f * thetaO * sinThetaO + cone.cosThetaO);
+        }
+
+        float Center(const AABB& box, int axis)
+        {
+            return axis == 0 ? (box.MinX + box.MaxX) * 0.5f : (axis == 1 ? (box.MinY + box.MaxY) * 0.5f : (box.MinZ + box.MaxZ) * 0.5f);
+        }
+
+        float Component(const XMFLOAT3& v, int axis)
+        {
+            return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+        }
+
+        AABB PointBounds(const XMFLOAT3& p, float radius)
+        {
+            return { p.x - radius, p.y - radius, p.z - radius, p.x + radius, p.y + radius, p.z + radius };
+        }
+    }
+
+    // ============================================
+    // Build
+    // ============================================
+
+    void LightBvh::Clear()
+    {
+        emitters.clear();
+        nodes.clear();
+        parents.clear();
+        emitterLeaves.clear();
+        directions.clear();
+        directionalCount = 0;
+        ambient = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    }
+
+    void LightBvh::Build(const Scene& scene, const LightBvhLimits& limits)
+    {
+        Clear();
+        attenuationConstant = scene.GetLightAttenuationConstant();
+        attenuationLinear = scene.GetLightAttenuationLinear();
+        attenuationQuadratic = scene.GetLightAttenuationQuadratic();
+
+        const auto& lights = scene.GetLights();
+        const uint32_t lightCount = static_cast<uint32_t>((std::min)(lights.size(), static_cast<size_t>(limits.maxLights)));
+
+        // Directional lights and ambient first; they stay outside the tree
+        for (uint32_t i = 0; i < lightCount; i++)
+        {
+            const Light& light = lights[i];
+            const XMFLOAT4 color = light.GetColor();
+            if (light.GetType() == LightType::Ambient)
+            {
+                ambient.x += color.x * light.GetIntensity();
+                ambient.y += color.y * light.GetIntensity();
+                ambient.z += color.z * light.GetIntensity();
+            }
+            else if (light.GetType() == LightType::Directional)
+            {
+                const XMFLOAT3 position = light.GetPosition();
+                const float power = Luminance(color.x, color.y, color.z) * light.GetIntensity();
+                if (power <= 0.0f)
+                    continue;
+                emitters.push_back({ LightEmitter_Light, i, power, 0.0f });
+                directions.push_back(Normalize(XMFLOAT3(-position.x, -position.y, -position.z)));
+            }
+        }
+        directionalCount = static_cast<uint32_t>(emitters.size());
+
+        // Bounded emitters. Surfaces get power = luminance(emission) * area / 4: the mean
+        // projected area of a convex body is a quarter of its surface area, which puts them
+        // on the same footing as point lights (intensity * attenuation)
+        std::vector<BuildEmitter> items;
+        auto addBounded = [&](LightEmitterType type, uint32_t source, float power, float area, const AABB& bounds)
+        {
+            if (power <= 0.0f)
+                return;
+            BuildEmitter item;
+            item.bounds = bounds;
+            item.centroid = XMFLOAT3(Center(bounds, 0), Center(bounds, 1), Center(bounds, 2));
+            item.power = power;
+            const Cone cone = OmnidirectionalCone();
+            item.coneAxis = cone.axis;
+            item.cosThetaO = cone.cosThetaO;
+            item.cosThetaE = cone.cosThetaE;
+            item.emitter = static_cast<uint32_t>(emitters.size());
+            emitters.push_back({ type, source, power, area });
+            items.push_back(item);
+        };
+
+        for (uint32_t i = 0; i < lightCount; i++)
+        {
+            const Light& light = lights[i];
+            if (light.GetType() != LightType::Point)
+                continue;
+            const XMFLOAT4 color = light.GetColor();
+            addBounded(LightEmitter_Light, i, Luminance(color.x, color.y, color.z) * light.GetIntensity(), 0.0f,
+                PointBounds(light.GetPosition(), (std::max)(light.GetRadius(), 0.0f)));
+        }
+
+        const SpherePool& spheres = scene.GetSpheres();
+        const uint32_t sphereCount = static_cast<uint32_t>((std::min)(spheres.Size(), static_cast<size_t>(limits.maxSpheres)));
+        for (uint32_t i = 0; i < sphereCount; i++)
+        {
+            const XMFLOAT3& emission = spheres.materials[i].emission;
+            const float radius = spheres.geometry[i].radius;
+            const float area = 4.0f * PI * radius * radius;
+            addBounded(LightEmitter_Sphere, i, Luminance(emission.x, emission.y, emission.z) * area * 0.25f, area,
+                CalculateSphereAABB(spheres.geometry[i]));
+        }
+
+        const BoxPool& boxes = scene.GetBoxes();
+        const uint32_t boxCount = static_cast<uint32_t>((std::min)(boxes.Size(), static_cast<size_t>(limits.maxBoxes)));
+        for (uint32_t i = 0; i < boxCount; i++)
+        {
+            const XMFLOAT3& emission = boxes.materials[i].emission;
+            const XMFLOAT3& size = boxes.geometry[i].size;
+            const float area = 8.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+            addBounded(LightEmitter_Box, i, Luminance(emission.x, emission.y, emission.z) * area * 0.25f, area,
+                CalculateBoxAABB(boxes.geometry[i]));
+        }
+
+        emitterLeaves.assign(emitters.size(), INVALID_INDEX);
+        if (!items.empty())
+        {
+            nodes.reserve(items.size() * 2 - 1);
+            parents.reserve(items.size() * 2 - 1);
+            BuildRecursive(items, 0, items.size());
+        }
+    }
+
+    uint32_t LightBvh::BuildRecursive(std::vector<BuildEmitter>& items, size_t begin, size_t end)
+    {
+        const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({});
+        parents.push_back(INVALID_INDEX);
+
+        AABB bounds = EmptyAABB();
+        AABB centroidBounds = EmptyAABB();
+        Cone cone;
+        float power = 0.0f;
+        for (size_t i = begin; i < end; i++)
+        {
+            ExpandAABB(bounds, items[i].bounds);
+            ExpandAABB(centroidBounds, PointBounds(items[i].centroid, 0.0f));
+            cone = Union(cone, Cone{ items[i].coneAxis, items[i].cosThetaO, items[i].cosThetaE, false });
+            power += items[i].power;
+        }
+
+        GPULightBvhNode node = {};
+        node.BoundsMin = XMFLOAT3(bounds.MinX, bounds.MinY, bounds.MinZ);
+        node.BoundsMax = XMFLOAT3(bounds.MaxX, bounds.MaxY, bounds.MaxZ);
+        node.Power = power;
+        node.ConeAxis = cone.axis;
+        node.CosThetaO = cone.cosThetaO;
+        node.CosThetaE = cone.cosThetaE;
+
+        if (end - begin == 1)
+        {
+            node.IsLeaf = 1;
+            node.SecondChildOrEmitter = items[begin].emitter;
+            emitterLeaves[items[begin].emitter] = nodeIndex;
+            nodes[nodeIndex] = node;
+            return nodeIndex;
+        }
+
+        // Binned SAOH: cost = sum over children of power * area * orientation measure,
+        // scaled by how thin the split axis is relative to the widest one
+        const float extent[3] = {
+            centroidBounds.MaxX - centroidBounds.MinX,
+            centroidBounds.MaxY - centroidBounds.MinY,
+            centroidBounds.MaxZ - centroidBounds.MinZ };
+        const float minCorner[3] = { centroidBounds.MinX, centroidBounds.MinY, centroidBounds.MinZ };
+        const float maxExtent = (std::max)(extent[0], (std::max)(extent[1], extent[2]));
+        const float areaFloor = SurfaceArea(bounds) * 1e-4f + 1e-12f;
+
+        int bestAxis = -1;
+        uint32_t bestSplit = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0.0f)
+                continue;
+
+            struct Bin
+            {
+                AABB bounds = EmptyAABB();
+                Cone cone;
+                float power = 0.0f;
+            } bins[SAOH_BIN_COUNT];
+
+            for (size_t i = begin; i < end; i++)
+            {
+                uint32_t b = static_cast<uint32_t>((Component(items[i].centroid, axis) - minCorner[axis]) / extent[axis] * SAOH_BIN_COUNT);
+                b = (std::min)(b, SAOH_BIN_COUNT - 1);
+                ExpandAABB(bins[b].bounds, items[i].bounds);
+                bins[b].cone = Union(bins[b].cone, Cone{ items[i].coneAxis, items[i].cosThetaO, items[i].cosThetaE, false });
+                bins[b].power += items[i].power;
+            }
+
+            // Sweep from the right once so every split reads its right side in O(1)
+            Bin suffix[SAOH_BIN_COUNT];
+            suffix[SAOH_BIN_COUNT - 1] = bins[SAOH_BIN_COUNT - 1];
+            for (uint32_t b = SAOH_BIN_COUNT - 1; b-- > 0;)
+            {
+                suffix[b] = suffix[b + 1];
+                ExpandAABB(suffix[b].bounds, bins[b].bounds);
+                suffix[b].cone = Union(suffix[b].cone, bins[b].cone);
+                suffix[b].power += bins[b].power;
+            }
+
+            const float regularization = maxExtent / extent[axis];
+            Bin left;
+            for (uint32_t split = 1; split < SAOH_BIN_COUNT; split++)
+            {
+                ExpandAABB(left.bounds, bins[split - 1].bounds);
+                left.cone = Union(left.cone, bins[split - 1].cone);
+                left.power += bins[split - 1].power;
+                const Bin& right = suffix[split];
+                if (left.cone.empty || right.cone.empty)
+                    continue;
+
+                const float cost = regularization *
+                    (left.power * (SurfaceArea(left.bounds) + areaFloor) * OrientationMeasure(left.cone) +
+                     right.power * (SurfaceArea(right.bounds) + areaFloor) * OrientationMeasure(right.cone));
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        size_t middle = begin;
+        if (bestAxis >= 0)
+        {
+            auto it = std::partition(items.begin() + begin, items.begin() + end, [&](const BuildEmitter& item)
+            {
+                uint32_t b = static_cast<uint32_t>((Component(item.centroid, bestAxis) - minCorner[bestAxis]) / extent[bestAxis] * SAOH_BIN_COUNT);
+                return (std::min)(b, SAOH_BIN_COUNT - 1) < bestSplit;
+            });
+            middle = static_cast<size_t>(it - items.begin());
+        }
+        if (middle == begin || middle == end)
+        {
+            // Coincident centroids: split by count
+            middle = begin + (end - begin) / 2;
+        }
+
+        BuildRecursive(items, begin, middle);
+        const uint32_t second = BuildRecursive(items, middle, end);
+        parents[nodeIndex + 1] = nodeIndex;
+        parents[second] = nodeIndex;
+        node.SecondChildOrEmitter = second;
+        node.IsLeaf = 0;
+        nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    // ============================================
+    // Sampling
+    // ============================================
+
+    float LightBvh::Attenuation(float distance) const
+    {
+        // Same form as ComputeAttenuation in Common.hlsli
+        return 1.0f / (std::max)(attenuationConstant + attenuationLinear * distance +
+            attenuationQuadratic * distance * distance, 0.0001f);
+    }
+
+    float LightBvh::NodeImportance(const GPULightBvhNode& node, const XMFLOAT3& position, const XMFLOAT3& normal) const
+    {
+        if (node.Power <= 0.0f)
+            return 0.0f;
+
+        const XMFLOAT3 center((node.BoundsMin.x + node.BoundsMax.x) * 0.5f,
+            (node.BoundsMin.y + node.BoundsMax.y) * 0.5f, (node.BoundsMin.z + node.BoundsMax.z) * 0.5f);
+        const XMFLOAT3 halfDiagonal((node.BoundsMax.x - node.BoundsMin.x) * 0.5f,
+            (node.BoundsMax.y - node.BoundsMin.y) * 0.5f, (node.BoundsMax.z - node.BoundsMin.z) * 0.5f);
+        const float radius = Length(halfDiagonal);
+        const XMFLOAT3 offset(position.x - center.x, position.y - center.y, position.z - center.z);
+        const float distance = Length(offset);
+
+        // Angle subtended by the node's bounding sphere
+        float sinThetaB = 1.0f, cosThetaB = -1.0f;
+        if (distance > radius)
+        {
+            sinThetaB = radius / distance;
+            cosThetaB = SafeSqrt(1.0f - sinThetaB * sinThetaB);
+        }
+
+        const XMFLOAT3 toPoint = distance > 0.0f
+            ? XMFLOAT3(offset.x / distance, offset.y / distance, offset.z / distance)
+            : node.ConeAxis;
+
+        // Emission term: angle between the cone and the point, minus the cone and the bounds
+        const float cosThetaW = Dot(node.ConeAxis, toPoint);
+        const float sinThetaW = SafeSqrt(1.0f - cosThetaW * cosThetaW);
+        const float sinThetaO = SafeSqrt(1.0f - node.CosThetaO * node.CosThetaO);
+        const float cosThetaX = CosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.CosThetaO);
+        const float sinThetaX = SinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.CosThetaO);
+        const float cosThetaP = CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+        if (cosThetaP <= node.CosThetaE)
+            return 0.0f;
+
+        // Receiver term: the most favourable incidence over the bounds
+        const float cosThetaI = -Dot(normal, toPoint);
+        const float sinThetaI = SafeSqrt(1.0f - cosThetaI * cosThetaI);
+        const float cosThetaIP = CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+        if (cosThetaIP <= 0.0f)
+            return 0.0f;
+
+        return node.Power * cosThetaP * cosThetaIP * Attenuation((std::max)(distance, radius));
+    }
+
+    float LightBvh::DirectionalImportance(uint32_t emitter, const XMFLOAT3& normal) const
+    {
+        return emitters[emitter].Power * (std::max)(Dot(normal, directions[emitter]), 0.0f);
+    }
+
+    uint32_t LightBvh::Sample(const XMFLOAT3& position, const XMFLOAT3& normal, float u, float& pmf) const
+    {
+        pmf = 0.0f;
+        float directionalTotal = 0.0f;
+        for (uint32_t i = 0; i < directionalCount; i++)
+            directionalTotal += DirectionalImportance(i, normal);
+        const float treeImportance = nodes.empty() ? 0.0f : NodeImportance(nodes[0], position, normal);
+        const float total = directionalTotal + treeImportance;
+        if (total <= 0.0f)
+            return INVALID_INDEX;
+
+        const float directionalProbability = directionalTotal / total;
+        if (u < directionalProbability)
+        {
+            // Directional lights, proportional to their importance
+            u = (std::min)(u / directionalProbability, 0.99999994f);
+            float target = u * directionalTotal;
+            for (uint32_t i = 0; i < directionalCount; i++)
+            {
+                const float importance = DirectionalImportance(i, normal);
+                if (target < importance || i + 1 == directionalCount)
+                {
+                    pmf = importance / total;
+                    return importance > 0.0f ? i : INVALID_INDEX;
+                }
+                target -= importance;
+            }
+            return INVALID_INDEX;
+        }
+
+        // Tree descent: u is rescaled at every level so one number drives the whole walk
+        u = (std::min)((u - directionalProbability) / (1.0f - directionalProbability), 0.99999994f);
+        pmf = 1.0f - directionalProbability;
+        uint32_t nodeIndex = 0;
+        while (!nodes[nodeIndex].IsLeaf)
+        {
+            const uint32_t first = nodeIndex + 1;
+            const uint32_t second = nodes[nodeIndex].SecondChildOrEmitter;
+            const float importanceFirst = NodeImportance(nodes[first], position, normal);
+            const float importanceSecond = NodeImportance(nodes[second], position, normal);
+            const float sum = importanceFirst + importanceSecond;
+            if (sum <= 0.0f)
+            {
+                pmf = 0.0f;
+                return INVALID_INDEX;
+            }
+
+            const float probabilityFirst = importanceFirst / sum;
+            if (u < probabilityFirst)
+            {
+                u = (std::min)(u / probabilityFirst, 0.99999994f);
+                pmf *= probabilityFirst;
+                nodeIndex = first;
+            }
+            else
+            {
+                u = (std::min)((u - probabilityFirst) / (1.0f - probabilityFirst), 0.99999994f);
+                pmf *= 1.0f - probabilityFirst;
+                nodeIndex = second;
+            }
+        }
+        return nodes[nodeIndex].SecondChildOrEmitter;
+    }
+
+    float LightBvh::Pmf(const XMFLOAT3& position, const XMFLOAT3& normal, uint32_t emitter) const
+    {
+        if (emitter >= emitters.size())
+            return 0.0f;
+
+        float directionalTotal = 0.0f;
+        for (uint32_t i = 0; i < directionalCount; i++)
+            directionalTotal += DirectionalImportance(i, normal);
+        const float treeImportance = nodes.empty() ? 0.0f : NodeImportance(nodes[0], position, normal);
+        const float total = directionalTotal + treeImportance;
+        if (total <= 0.0f)
+            return 0.0f;
+
+        if (emitter < directionalCount)
+            return DirectionalImportance(emitter, normal) / total;
+
+        // Walk up from the leaf, multiplying the probability of each branch taken
+        float pmf = treeImportance / total;
+        for (uint32_t nodeIndex = emitterLeaves[emitter]; parents[nodeIndex] != INVALID_INDEX; nodeIndex = parents[nodeIndex])
+        {
+            const uint32_t parent = parents[nodeIndex];
+            const uint32_t sibling = (nodeIndex == parent + 1) ? nodes[parent].SecondChildOrEmitter : parent + 1;
+            const float importance = NodeImportance(nodes[nodeIndex], position, normal);
+            const float sum = importance + NodeImportance(nodes[sibling], position, normal);
+            if (sum <= 0.0f)
+                return 0.0f;
+            pmf *= importance / sum;
+        }
+        return pmf;
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <DirectXMath.h>
+#include "CpuBvh.h"
+
+// ============================================
+// Light BVH
+// ============================================
+//
+// Hierarchy over the scene's emitters for stochastic light selection (Conty Estevez and
+// Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting", 2018). Every
+// node stores the bounds, summed power and orientation cone of what it contains. A shading
+// point walks down from the root and picks a child with probability proportional to its
+// estimated contribution, so choosing one of N emitters costs O(log N) importance
+// evaluations and the probability of the pick is known exactly (no bias).
+//
+// Point / spherical area lights and emissive spheres and boxes live in the tree.
+// Directional lights have no position; they are a short flat list in front of the tree
+// and compete with the root by the same importance measure. Ambient lights are not
+// sampled at all, their sum is passed as a constant.
+//
+// The GPU layouts must match LightEmitter / LightBvhNode in Common.hlsli, and Sample()
+// walks the tree exactly like SampleLightEmitter there.
+
+namespace RayTraceVS::DXEngine
+{
+    class Scene;
+
+    enum LightEmitterType : uint32_t
+    {
+        LightEmitter_Light = 0,         // Point, area or directional light: Lights[SourceIndex]
+        LightEmitter_Sphere = 1,        // Emissive sphere: Spheres[SourceIndex]
+        LightEmitter_Box = 2            // Emissive box: Boxes[SourceIndex]
+    };
+
+    struct alignas(16) GPULightEmitter
+    {
+        uint32_t Type;                  // LightEmitterType
+        uint32_t SourceIndex;
+        float Power;                    // Luminance-weighted power used by the importance estimate
+        float Area;                     // Surface area (emissive primitives)
+    };
+
+    struct alignas(16) GPULightBvhNode
+    {
+        DirectX::XMFLOAT3 BoundsMin;
+        float Power;
+        DirectX::XMFLOAT3 BoundsMax;
+        float CosThetaO;                // Cone around ConeAxis holding every emitter normal
+        DirectX::XMFLOAT3 ConeAxis;
+        float CosThetaE;                // Emission spread beyond that cone (pi/2 for diffuse emitters)
+        uint32_t SecondChildOrEmitter;  // Inner: second child (the first is the next node); leaf: emitter index
+        uint32_t IsLeaf;
+        uint32_t Padding[2];
+    };
+
+    // Buffer capacities; emitters whose source index does not fit are left out
+    struct LightBvhLimits
+    {
+        uint32_t maxLights = std::numeric_limits<uint32_t>::max();
+        uint32_t maxSpheres = std::numeric_limits<uint32_t>::max();
+        uint32_t maxBoxes = std::numeric_limits<uint32_t>::max();
+    };
+
+    class LightBvh
+    {
+    public:
+        static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+        static constexpr uint32_t SAOH_BIN_COUNT = 12;
+
+        // Collects the emitters of the scene and builds the tree (binned surface area
+        // orientation heuristic, one emitter per leaf)
+        void Build(const Scene& scene, const LightBvhLimits& limits = {});
+        void Clear();
+
+        // Picks an emitter for a shading point; u in [0, 1). Returns INVALID_INDEX when no
+        // emitter can reach the point, otherwise pmf is the probability of the pick.
+        uint32_t Sample(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, float u, float& pmf) const;
+        // Probability that Sample returns the emitter at this point
+        float Pmf(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, uint32_t emitter) const;
+
+        // Directional lights first (GetDirectionalCount of them), then the tree's emitters
+        const std::vector<GPULightEmitter>& GetEmitters() const { return emitters; }
+        const std::vector<GPULightBvhNode>& GetNodes() const { return nodes; }
+        uint32_t GetDirectionalCount() const { return directionalCount; }
+        // Sum of color * intensity over the ambient lights
+        DirectX::XMFLOAT3 GetAmbient() const { return ambient; }
+
+    private:
+        struct BuildEmitter
+        {
+            AABB bounds;
+            DirectX::XMFLOAT3 centroid;
+            float power;
+            DirectX::XMFLOAT3 coneAxis;     // Orientation cone of the emitter's normals
+            float cosThetaO;
+            float cosThetaE;
+            uint32_t emitter;
+        };
+
+        uint32_t BuildRecursive(std::vector<BuildEmitter>& items, size_t begin, size_t end);
+        float NodeImportance(const GPULightBvhNode& node, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal) const;
+        float DirectionalImportance(uint32_t emitter, const DirectX::XMFLOAT3& normal) const;
+        float Attenuation(float distance) const;
+
+        std::vector<GPULightEmitter> emitters;
+        std::vector<GPULightBvhNode> nodes;
+        std::vector<uint32_t> parents;              // Per node, INVALID_INDEX for the root
+        std::vector<uint32_t> emitterLeaves;        // Per emitter, its leaf (INVALID_INDEX for directional lights)
+        std::vector<DirectX::XMFLOAT3> directions;  // Per directional emitter: unit vector towards the light
+        uint32_t directionalCount = 0;
+        DirectX::XMFLOAT3 ambient = { 0.0f, 0.0f, 0.0f };
+
+        // Scene light attenuation (the importance distance term)
+        float attenuationConstant = 1.0f;
+        float attenuationLinear = 0.0f;
+        float attenuationQuadratic = 0.0f;
+    };
+}
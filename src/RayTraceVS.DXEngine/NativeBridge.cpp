@@ -4,14 +4,17 @@
 #include <wrl/client.h>
 #include <stdio.h>
 #include <fstream>
+#include <algorithm>
 #include "DXContext.h"
 #include "DXRPipeline.h"
 #include "RenderTarget.h"
+#include "CpuPathTracer.h"
+#include "FrameSink.h"
+#include "FrameChannel.h"
+#include "SceneSnapshot.h"
+#include "PagedMesh.h"
 #include "DebugLog.h"
 #include "Scene/Scene.h"
-#include "Scene/Objects/Sphere.h"
-#include "Scene/Objects/Plane.h"
-#include "Scene/Objects/Box.h"
 #include "Scene/Camera.h"
 #include "Scene/Light.h"
 #include "NativeBridge.h"
@@ -31,9 +34,9 @@ namespace RayTraceVS::Interop::Bridge
         return XMFLOAT4(c.r, c.g, c.b, c.a);
     }
 
-    static RayTraceVS::DXEngine::Material ToMaterial(const MaterialNative& m)
+    static RayTraceVS::DXEngine::ObjectMaterial ToMaterial(const MaterialNative& m)
     {
-        RayTraceVS::DXEngine::Material material;
+        RayTraceVS::DXEngine::ObjectMaterial material;
         material.color = ToXMFLOAT4(m.color);
         material.metallic = m.metallic;
         material.roughness = m.roughness;
@@ -92,6 +95,61 @@ namespace RayTraceVS::Interop::Bridge
         pipeline->DispatchRays(width, height);
     }
 
+    bool GetFrameStats(RayTraceVS::DXEngine::DXRPipeline* pipeline, FrameStatsNative* outStats)
+    {
+        if (!pipeline || !outStats)
+            return false;
+
+        RayTraceVS::DXEngine::FrameStats stats;
+        bool result = pipeline->ReadFrameStats(stats);
+
+        outStats->usedDXR = stats.usedDXR ? 1 : 0;
+        outStats->accelerationStructureRebuilt = stats.accelerationStructureRebuilt ? 1 : 0;
+        outStats->accelerationStructureRefit = stats.accelerationStructureRefit ? 1 : 0;
+        outStats->gpuTimingValid = stats.gpuTimingValid ? 1 : 0;
+        outStats->accelerationStructureCpuMs = stats.accelerationStructureCpuMs;
+        outStats->accelerationStructureGpuMs = stats.accelerationStructureGpuMs;
+        outStats->photonGpuMs = stats.photonGpuMs;
+        outStats->traceGpuMs = stats.traceGpuMs;
+        outStats->postProcessGpuMs = stats.postProcessGpuMs;
+        outStats->frameGpuMs = stats.frameGpuMs;
+        outStats->radianceRays = stats.radianceRays;
+        outStats->shadowRays = stats.shadowRays;
+        outStats->thicknessRays = stats.thicknessRays;
+        outStats->photonRays = stats.photonRays;
+        outStats->rayCountsMeasured = stats.rayCountsMeasured ? 1 : 0;
+        return result;
+    }
+
+    static void CopyResidencyStats(const RayTraceVS::DXEngine::ResidencyStats& stats, ResidencyStatsNative* outStats)
+    {
+        outStats->budgetBytes = stats.budgetBytes;
+        outStats->residentBytes = stats.residentBytes;
+        outStats->pinnedBytes = stats.pinnedBytes;
+        outStats->peakResidentBytes = stats.peakResidentBytes;
+        outStats->residentCount = static_cast<int>(stats.residentCount);
+        outStats->pinnedCount = static_cast<int>(stats.pinnedCount);
+        outStats->hits = stats.hits;
+        outStats->misses = stats.misses;
+        outStats->evictions = stats.evictions;
+        outStats->evictedBytes = stats.evictedBytes;
+    }
+
+    void SetMeshResidencyBudget(RayTraceVS::DXEngine::DXRPipeline* pipeline, uint64_t budgetBytes)
+    {
+        if (pipeline)
+            pipeline->SetMeshResidencyBudget(budgetBytes);
+    }
+
+    bool GetMeshResidencyStats(RayTraceVS::DXEngine::DXRPipeline* pipeline, ResidencyStatsNative* outStats)
+    {
+        if (!pipeline || !outStats)
+            return false;
+
+        CopyResidencyStats(pipeline->GetMeshResidencyStats(), outStats);
+        return true;
+    }
+
     // Scene functions
     RayTraceVS::DXEngine::Scene* CreateScene()
     {
@@ -128,37 +186,41 @@ namespace RayTraceVS::Interop::Bridge
             lightAttenuationConstant, lightAttenuationLinear, lightAttenuationQuadratic, maxShadowLights, nrdBypassDistance, nrdBypassBlendRange);
     }
 
+    void SetEnvironment(RayTraceVS::DXEngine::Scene* scene, const wchar_t* hdrPath, float intensity, bool lighting)
+    {
+        scene->SetEnvironment(hdrPath ? std::wstring(hdrPath) : std::wstring(), intensity, lighting);
+    }
+
+    void SetRussianRouletteMinDepth(RayTraceVS::DXEngine::Scene* scene, int depth)
+    {
+        scene->SetRussianRouletteMinDepth((std::max)(depth, 0));
+    }
+
     void AddSphere(RayTraceVS::DXEngine::Scene* scene, const SphereDataNative& sphere)
     {
-        auto nativeSphere = std::make_shared<RayTraceVS::DXEngine::Sphere>(
-            ToXMFLOAT3(sphere.center),
-            sphere.radius
-        );
-        nativeSphere->SetMaterial(ToMaterial(sphere.material));
-        scene->AddObject(nativeSphere);
+        RayTraceVS::DXEngine::SphereGeometry geometry;
+        geometry.center = ToXMFLOAT3(sphere.center);
+        geometry.radius = sphere.radius;
+        scene->AddSphere(geometry, ToMaterial(sphere.material));
     }
 
     void AddPlane(RayTraceVS::DXEngine::Scene* scene, const PlaneDataNative& plane)
     {
-        auto nativePlane = std::make_shared<RayTraceVS::DXEngine::Plane>(
-            ToXMFLOAT3(plane.position),
-            ToXMFLOAT3(plane.normal)
-        );
-        nativePlane->SetMaterial(ToMaterial(plane.material));
-        scene->AddObject(nativePlane);
+        RayTraceVS::DXEngine::PlaneGeometry geometry;
+        geometry.position = ToXMFLOAT3(plane.position);
+        geometry.normal = ToXMFLOAT3(plane.normal);
+        scene->AddPlane(geometry, ToMaterial(plane.material));
     }
 
     void AddBox(RayTraceVS::DXEngine::Scene* scene, const BoxDataNative& box)
     {
-        auto nativeBox = std::make_shared<RayTraceVS::DXEngine::Box>(
-            ToXMFLOAT3(box.center),
-            ToXMFLOAT3(box.size),
-            ToXMFLOAT3(box.axisX),
-            ToXMFLOAT3(box.axisY),
-            ToXMFLOAT3(box.axisZ)
-        );
-        nativeBox->SetMaterial(ToMaterial(box.material));
-        scene->AddObject(nativeBox);
+        RayTraceVS::DXEngine::BoxGeometry geometry;
+        geometry.center = ToXMFLOAT3(box.center);
+        geometry.size = ToXMFLOAT3(box.size);
+        geometry.axisX = ToXMFLOAT3(box.axisX);
+        geometry.axisY = ToXMFLOAT3(box.axisY);
+        geometry.axisZ = ToXMFLOAT3(box.axisZ);
+        scene->AddBox(geometry, ToMaterial(box.material));
     }
 
     void AddLight(RayTraceVS::DXEngine::Scene* scene, const LightDataNative& light)
@@ -196,6 +258,7 @@ namespace RayTraceVS::Interop::Bridge
         
         entry.boundsMin = ToXMFLOAT3(meshCache.boundsMin);
         entry.boundsMax = ToXMFLOAT3(meshCache.boundsMax);
+        entry.spatialSplits = meshCache.spatialSplits != 0;
         
         scene->AddMeshCache(entry);
     }
@@ -221,6 +284,54 @@ namespace RayTraceVS::Interop::Bridge
         scene->AddMeshInstance(instance);
     }
 
+    bool SaveSceneSnapshot(RayTraceVS::DXEngine::Scene* scene, const wchar_t* path)
+    {
+        if (!scene || !path)
+            return false;
+        return RayTraceVS::DXEngine::SceneSnapshot::Save(*scene, path);
+    }
+
+    bool LoadSceneSnapshot(RayTraceVS::DXEngine::Scene* scene, const wchar_t* path)
+    {
+        if (!scene || !path)
+            return false;
+
+        RayTraceVS::DXEngine::SceneSnapshot snapshot;
+        return snapshot.Open(path) && snapshot.Apply(*scene);
+    }
+
+    bool PageSceneMeshes(RayTraceVS::DXEngine::Scene* scene, const wchar_t* directory, int trianglesPerChunk)
+    {
+        if (!scene || !directory)
+            return false;
+
+        const uint32_t chunkTriangles = trianglesPerChunk > 0
+            ? static_cast<uint32_t>(trianglesPerChunk)
+            : RayTraceVS::DXEngine::DEFAULT_PAGED_CHUNK_TRIANGLES;
+        return RayTraceVS::DXEngine::PageSceneMeshes(*scene, directory, chunkTriangles);
+    }
+
+    bool AddPagedMeshCache(RayTraceVS::DXEngine::Scene* scene, const char* name, const wchar_t* path, PagedMeshInfoNative* outInfo)
+    {
+        if (!scene || !name || !path)
+            return false;
+
+        RayTraceVS::DXEngine::PagedMeshFileHeader header = {};
+        if (!RayTraceVS::DXEngine::AddPagedMeshCache(*scene, name, path, &header))
+            return false;
+
+        if (outInfo)
+        {
+            outInfo->triangleCount = header.triangleCount;
+            outInfo->fileBytes = header.fileSize;
+            outInfo->chunkCount = static_cast<int>(header.chunkCount);
+            outInfo->spatialSplits = header.spatialSplits != 0 ? 1 : 0;
+            outInfo->boundsMin = { header.bounds.MinX, header.bounds.MinY, header.bounds.MinZ };
+            outInfo->boundsMax = { header.bounds.MaxX, header.bounds.MaxY, header.bounds.MaxZ };
+        }
+        return true;
+    }
+
     // RenderTarget functions
     RayTraceVS::DXEngine::RenderTarget* CreateRenderTarget(RayTraceVS::DXEngine::DXContext* context)
     {
@@ -263,6 +374,18 @@ namespace RayTraceVS::Interop::Bridge
         return target->CopyToReadback(context->GetCommandList());
     }
 
+    // Debug fill for ReadRenderTargetPixels failures (the caller always gets an image)
+    static void FillDebugColor(unsigned char* outData, int dataSize, unsigned char r, unsigned char g, unsigned char b)
+    {
+        for (int j = 0; j + 3 < dataSize; j += 4)
+        {
+            outData[j + 0] = r;
+            outData[j + 1] = g;
+            outData[j + 2] = b;
+            outData[j + 3] = 255;
+        }
+    }
+
     bool ReadRenderTargetPixels(RayTraceVS::DXEngine::RenderTarget* target, unsigned char* outData, int dataSize)
     {
         try
@@ -271,73 +394,50 @@ namespace RayTraceVS::Interop::Bridge
             {
                 return false;
             }
-            
-            std::vector<unsigned char> pixels;
-            if (!target->ReadPixels(pixels))
+
+            const int imageSize = static_cast<int>(target->GetWidth() * target->GetHeight() * 4);
+            if (imageSize == 0)
             {
-                // ReadPixels failed - fill with green
-                for (int j = 0; j < dataSize; j += 4)
-                {
-                    outData[j + 0] = 0;
-                    outData[j + 1] = 255;
-                    outData[j + 2] = 0;
-                    outData[j + 3] = 255;
-                }
+                // Zero size - fill with red
+                FillDebugColor(outData, dataSize, 255, 0, 0);
                 return true;
             }
-
-            if (pixels.size() == 0)
+            if (dataSize < imageSize)
             {
-                // Zero size - fill with red
-                for (int j = 0; j < dataSize; j += 4)
-                {
-                    outData[j + 0] = 255;
-                    outData[j + 1] = 0;
-                    outData[j + 2] = 0;
-                    outData[j + 3] = 255;
-                }
+                // Buffer too small - fill with yellow
+                FillDebugColor(outData, dataSize, 255, 255, 0);
                 return true;
             }
 
-            if (dataSize < static_cast<int>(pixels.size()))
+            // Straight from the mapped readback buffer into the caller's memory
+            RayTraceVS::DXEngine::FrameBufferView view;
+            view.data = outData;
+            view.width = target->GetWidth();
+            view.height = target->GetHeight();
+            view.rowPitch = target->GetWidth() * 4;
+            view.format = RayTraceVS::DXEngine::FrameFormat::Rgba8;
+            if (!target->ReadPixels(view))
             {
-                // Buffer too small - fill with yellow
-                for (int j = 0; j < dataSize; j += 4)
-                {
-                    outData[j + 0] = 255;
-                    outData[j + 1] = 255;
-                    outData[j + 2] = 0;
-                    outData[j + 3] = 255;
-                }
+                // ReadPixels failed - fill with green
+                FillDebugColor(outData, dataSize, 0, 255, 0);
                 return true;
             }
 
-            // Check if all zeros (scan full buffer with early exit)
+            // Check if all zeros (early exit on the first non-zero byte)
             bool allZero = true;
-            for (size_t k = 0; k < pixels.size(); ++k)
+            for (int k = 0; k < imageSize; ++k)
             {
-                if (pixels[k] != 0)
+                if (outData[k] != 0)
                 {
                     allZero = false;
                     break;
                 }
             }
-            
             if (allZero)
             {
                 // All zeros - fill with orange
-                for (int j = 0; j < dataSize; j += 4)
-                {
-                    outData[j + 0] = 255;
-                    outData[j + 1] = 128;
-                    outData[j + 2] = 0;
-                    outData[j + 3] = 255;
-                }
-                return true;
+                FillDebugColor(outData, dataSize, 255, 128, 0);
             }
-
-            // Success: copy actual pixel data
-            memcpy(outData, pixels.data(), pixels.size());
             return true;
         }
         catch (...)
@@ -345,18 +445,314 @@ namespace RayTraceVS::Interop::Bridge
             // Exception - fill with magenta
             if (outData && dataSize > 0)
             {
-                for (int j = 0; j < dataSize; j += 4)
-                {
-                    outData[j + 0] = 255;
-                    outData[j + 1] = 0;
-                    outData[j + 2] = 255;
-                    outData[j + 3] = 255;
-                }
+                FillDebugColor(outData, dataSize, 255, 0, 255);
             }
             return true;
         }
     }
 
+    // Frame sink (caller-owned, double/triple-buffered destination)
+    RayTraceVS::DXEngine::FrameSink* CreateFrameSink()
+    {
+        return new RayTraceVS::DXEngine::FrameSink();
+    }
+
+    void DestroyFrameSink(RayTraceVS::DXEngine::FrameSink* sink)
+    {
+        delete sink;
+    }
+
+    bool ConfigureFrameSink(RayTraceVS::DXEngine::FrameSink* sink, int width, int height, int format, int rowPitch,
+        unsigned char* const* buffers, int bufferCount)
+    {
+        if (!sink)
+            return false;
+        if (bufferCount == 0)
+        {
+            sink->Reset();
+            return true;
+        }
+        if (width <= 0 || height <= 0 || rowPitch <= 0 || bufferCount < 0 ||
+            format < 0 || format > static_cast<int>(RayTraceVS::DXEngine::FrameFormat::Rgba32Float))
+            return false;
+        return sink->Configure(static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+            static_cast<RayTraceVS::DXEngine::FrameFormat>(format), static_cast<uint32_t>(rowPitch),
+            buffers, static_cast<uint32_t>(bufferCount));
+    }
+
+    bool ResolveRenderTargetToSink(RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::FrameSink* sink)
+    {
+        if (!target || !sink)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        if (!sink->BeginWrite(view))
+            return false;
+        const bool written = target->ReadPixels(view);
+        sink->EndWrite(written);
+        return written;
+    }
+
+    bool AcquireFrame(RayTraceVS::DXEngine::FrameSink* sink, FrameViewNative* outFrame)
+    {
+        if (!sink || !outFrame)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        uint64_t frameNumber = 0;
+        if (!sink->BeginRead(view, frameNumber))
+            return false;
+        outFrame->data = view.data;
+        outFrame->width = static_cast<int>(view.width);
+        outFrame->height = static_cast<int>(view.height);
+        outFrame->rowPitch = static_cast<int>(view.rowPitch);
+        outFrame->format = static_cast<int>(view.format);
+        outFrame->frameNumber = frameNumber;
+        return true;
+    }
+
+    void ReleaseFrame(RayTraceVS::DXEngine::FrameSink* sink)
+    {
+        if (sink)
+            sink->EndRead();
+    }
+
+    // Frame channel (shared memory between processes)
+    RayTraceVS::DXEngine::FrameChannel* CreateFrameChannel(const char* name, int width, int height, int format, int slotCount)
+    {
+        if (!name || width <= 0 || height <= 0 || slotCount <= 0 ||
+            format < 0 || format > static_cast<int>(RayTraceVS::DXEngine::FrameFormat::Rgba32Float))
+            return nullptr;
+
+        auto* channel = new RayTraceVS::DXEngine::FrameChannel();
+        if (!channel->Create(name, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+            static_cast<RayTraceVS::DXEngine::FrameFormat>(format), static_cast<uint32_t>(slotCount)))
+        {
+            delete channel;
+            return nullptr;
+        }
+        return channel;
+    }
+
+    RayTraceVS::DXEngine::FrameChannel* OpenFrameChannel(const char* name)
+    {
+        if (!name)
+            return nullptr;
+
+        auto* channel = new RayTraceVS::DXEngine::FrameChannel();
+        if (!channel->Open(name))
+        {
+            delete channel;
+            return nullptr;
+        }
+        return channel;
+    }
+
+    void DestroyFrameChannel(RayTraceVS::DXEngine::FrameChannel* channel)
+    {
+        delete channel;
+    }
+
+    bool ResolveRenderTargetToChannel(RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::FrameChannel* channel, int format)
+    {
+        if (!target || !channel)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        const auto frameFormat = format == static_cast<int>(RayTraceVS::DXEngine::FrameFormat::Bgra8)
+            ? RayTraceVS::DXEngine::FrameFormat::Bgra8
+            : RayTraceVS::DXEngine::FrameFormat::Rgba8;
+        if (!channel->BeginWrite(target->GetWidth(), target->GetHeight(), frameFormat, view))
+            return false;
+        const bool written = target->ReadPixels(view);
+        channel->EndWrite(written);
+        return written;
+    }
+
+    bool AcquireChannelFrame(RayTraceVS::DXEngine::FrameChannel* channel, FrameViewNative* outFrame)
+    {
+        if (!channel || !outFrame)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        uint64_t frameIndex = 0;
+        if (!channel->BeginRead(view, frameIndex))
+            return false;
+        outFrame->data = view.data;
+        outFrame->width = static_cast<int>(view.width);
+        outFrame->height = static_cast<int>(view.height);
+        outFrame->rowPitch = static_cast<int>(view.rowPitch);
+        outFrame->format = static_cast<int>(view.format);
+        outFrame->frameNumber = frameIndex;
+        return true;
+    }
+
+    bool ReleaseChannelFrame(RayTraceVS::DXEngine::FrameChannel* channel)
+    {
+        return channel && channel->EndRead();
+    }
+
+    // CPU rendering
+    RayTraceVS::DXEngine::CpuPathTracer* CreateCpuPathTracer()
+    {
+        return new RayTraceVS::DXEngine::CpuPathTracer();
+    }
+
+    void DestroyCpuPathTracer(RayTraceVS::DXEngine::CpuPathTracer* tracer)
+    {
+        delete tracer;
+    }
+
+    void SetCpuMeshResidencyBudget(RayTraceVS::DXEngine::CpuPathTracer* tracer, uint64_t budgetBytes)
+    {
+        if (tracer)
+            tracer->SetMeshResidencyBudget(budgetBytes);
+    }
+
+    bool GetCpuMeshResidencyStats(RayTraceVS::DXEngine::CpuPathTracer* tracer, ResidencyStatsNative* outStats)
+    {
+        if (!tracer || !outStats)
+            return false;
+
+        CopyResidencyStats(tracer->GetAccelerationStructure().GetMeshResidencyStats(), outStats);
+        return true;
+    }
+
+    void SetCpuGeometryStreamingBudget(RayTraceVS::DXEngine::CpuPathTracer* tracer, uint64_t budgetBytes)
+    {
+        if (tracer)
+            tracer->SetGeometryStreamingBudget(budgetBytes);
+    }
+
+    bool GetCpuGeometryStreamingStats(RayTraceVS::DXEngine::CpuPathTracer* tracer, GeometryStreamingStatsNative* outStats)
+    {
+        if (!tracer || !outStats)
+            return false;
+
+        const RayTraceVS::DXEngine::GeometryStreamingStats stats = tracer->GetAccelerationStructure().GetGeometryStreamingStats();
+        CopyResidencyStats(stats.residency, &outStats->residency);
+        outStats->meshCount = static_cast<int>(stats.meshCount);
+        outStats->chunkCount = static_cast<int>(stats.chunkCount);
+        outStats->chunkLoads = stats.chunkLoads;
+        outStats->loadedBytes = stats.loadedBytes;
+        outStats->failedLoads = stats.failedLoads;
+        outStats->releasedChunks = stats.releasedChunks;
+        outStats->loadMs = stats.loadMs;
+        return true;
+    }
+
+    static RayTraceVS::DXEngine::CpuPathTracerSettings ToCpuPathTracerSettings(const CpuRenderSettingsNative& settings)
+    {
+        RayTraceVS::DXEngine::CpuPathTracerSettings cpuSettings;
+        cpuSettings.width = static_cast<uint32_t>(settings.width);
+        cpuSettings.height = static_cast<uint32_t>(settings.height);
+        cpuSettings.samplesPerPixel = static_cast<uint32_t>((std::max)(settings.samplesPerPixel, 1));
+        cpuSettings.maxBounces = static_cast<uint32_t>((std::max)(settings.maxBounces, 1));
+        cpuSettings.frameIndex = static_cast<uint32_t>(settings.frameIndex);
+        cpuSettings.threadCount = static_cast<uint32_t>((std::max)(settings.threadCount, 0));
+        cpuSettings.russianRouletteMinDepth = static_cast<uint32_t>((std::max)(settings.russianRouletteMinDepth, 0));
+        cpuSettings.mode = settings.wavefront
+            ? RayTraceVS::DXEngine::CpuTraceMode::Wavefront
+            : RayTraceVS::DXEngine::CpuTraceMode::DepthFirst;
+        return cpuSettings;
+    }
+
+    static void CopyCpuRenderStats(const RayTraceVS::DXEngine::CpuPathTracer* tracer, CpuRenderStatsNative* outStats)
+    {
+        if (!outStats)
+            return;
+
+        const RayTraceVS::DXEngine::CpuPathTracerStats& stats = tracer->GetStats();
+        outStats->extensionRays = stats.extensionRays;
+        outStats->shadowRays = stats.shadowRays;
+        outStats->waves = static_cast<int>(stats.waves);
+        outStats->maxQueueLength = static_cast<int>(stats.maxQueueLength);
+        outStats->buildMs = stats.buildMs;
+        outStats->generateMs = stats.generateMs;
+        outStats->extendMs = stats.extendMs;
+        outStats->sortMs = stats.sortMs;
+        outStats->shadeMs = stats.shadeMs;
+        outStats->shadowMs = stats.shadowMs;
+        outStats->totalMs = stats.totalMs;
+        outStats->deferredRays = stats.deferredRays;
+        outStats->streamWaitMs = stats.streamWaitMs;
+        outStats->droppedRays = stats.droppedRays;
+        outStats->bvhBuilds = static_cast<int>(stats.bvhBuilds);
+        outStats->bvhRefits = static_cast<int>(stats.bvhRefits);
+    }
+
+    bool RenderSceneCpu(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, float* outRadiance, int floatCount, CpuRenderStatsNative* outStats)
+    {
+        if (!tracer || !scene || !outRadiance || settings.width <= 0 || settings.height <= 0)
+            return false;
+        if (floatCount < settings.width * settings.height * 4)
+            return false;
+
+        // The tracer resolves straight into the caller's array
+        RayTraceVS::DXEngine::FrameBufferView view;
+        view.data = reinterpret_cast<uint8_t*>(outRadiance);
+        view.width = static_cast<uint32_t>(settings.width);
+        view.height = static_cast<uint32_t>(settings.height);
+        view.rowPitch = static_cast<uint32_t>(settings.width) * 4 * sizeof(float);
+        view.format = RayTraceVS::DXEngine::FrameFormat::Rgba32Float;
+        if (!tracer->Render(*scene, ToCpuPathTracerSettings(settings), view))
+            return false;
+
+        CopyCpuRenderStats(tracer, outStats);
+        return true;
+    }
+
+    bool RenderSceneCpuToSink(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, RayTraceVS::DXEngine::FrameSink* sink, CpuRenderStatsNative* outStats)
+    {
+        if (!tracer || !scene || !sink || settings.width <= 0 || settings.height <= 0)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        if (!sink->BeginWrite(view))
+            return false;
+        const bool rendered = tracer->Render(*scene, ToCpuPathTracerSettings(settings), view);
+        sink->EndWrite(rendered);
+        if (rendered)
+            CopyCpuRenderStats(tracer, outStats);
+        return rendered;
+    }
+
+    bool RenderSceneCpuToChannel(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, RayTraceVS::DXEngine::FrameChannel* channel, CpuRenderStatsNative* outStats)
+    {
+        if (!tracer || !scene || !channel || settings.width <= 0 || settings.height <= 0)
+            return false;
+
+        RayTraceVS::DXEngine::FrameBufferView view;
+        if (!channel->BeginWrite(static_cast<uint32_t>(settings.width), static_cast<uint32_t>(settings.height),
+            RayTraceVS::DXEngine::FrameFormat::Rgba32Float, view))
+            return false;
+        const bool rendered = tracer->Render(*scene, ToCpuPathTracerSettings(settings), view);
+        channel->EndWrite(rendered);
+        if (rendered)
+            CopyCpuRenderStats(tracer, outStats);
+        return rendered;
+    }
+
+    // Logging
+    void SetLogOptions(int logEnabled, int debugMode)
+    {
+        RayTraceVS::DXEngine::SetLogEnabled(logEnabled);
+        RayTraceVS::DXEngine::SetDebugMode(debugMode);
+    }
+
+    void SetLogFilePath(const char* path)
+    {
+        RayTraceVS::DXEngine::SetLogFilePath(path);
+    }
+
+    void FlushLog()
+    {
+        RayTraceVS::DXEngine::FlushLog();
+    }
+
     void ExecuteCommandList(RayTraceVS::DXEngine::DXContext* context)
     {
         try
@@ -22,6 +22,9 @@ namespace RayTraceVS::DXEngine
     class Plane;
     class Box;
     class RenderTarget;
+    class CpuPathTracer;
+    class FrameSink;
+    class FrameChannel;
 }
 
 namespace RayTraceVS::Interop::Bridge
@@ -104,6 +107,18 @@ namespace RayTraceVS::Interop::Bridge
         uint32_t indexCount;
         Vector3Native boundsMin;
         Vector3Native boundsMax;
+        int spatialSplits;          // 1 = spatial-split BVH on the CPU side (long thin triangles)
+    };
+
+    // A paged mesh file registered by AddPagedMeshCache
+    struct PagedMeshInfoNative
+    {
+        uint64_t triangleCount;
+        uint64_t fileBytes;
+        int chunkCount;
+        int spatialSplits;
+        Vector3Native boundsMin;
+        Vector3Native boundsMax;
     };
 
     // Mesh instance data (per-instance transform + material)
@@ -116,6 +131,98 @@ namespace RayTraceVS::Interop::Bridge
         MaterialNative material;
     };
 
+    // Statistics of the last rendered frame (see DXEngine::FrameStats)
+    struct FrameStatsNative
+    {
+        int usedDXR;
+        int accelerationStructureRebuilt;
+        int accelerationStructureRefit;
+        int gpuTimingValid;
+        double accelerationStructureCpuMs;
+        double accelerationStructureGpuMs;
+        double photonGpuMs;
+        double traceGpuMs;
+        double postProcessGpuMs;
+        double frameGpuMs;
+        uint64_t radianceRays;
+        uint64_t shadowRays;
+        uint64_t thicknessRays;
+        uint64_t photonRays;
+        int rayCountsMeasured;      // 0 = nominal GPU estimates, 1 = traced rays
+    };
+
+    // CPU path tracer (see DXEngine::CpuPathTracerSettings)
+    struct CpuRenderSettingsNative
+    {
+        int width;
+        int height;
+        int samplesPerPixel;
+        int maxBounces;
+        int frameIndex;
+        int threadCount;            // 0 = hardware concurrency
+        int wavefront;              // 1 = wavefront queues, 0 = depth-first per pixel
+        int russianRouletteMinDepth;    // Bounces after which Russian roulette may end a path
+    };
+
+    struct CpuRenderStatsNative
+    {
+        uint64_t extensionRays;
+        uint64_t shadowRays;
+        int waves;
+        int maxQueueLength;
+        double buildMs;
+        double generateMs;
+        double extendMs;
+        double sortMs;
+        double shadeMs;
+        double shadowMs;
+        double totalMs;
+        uint64_t deferredRays;      // Waited for paged geometry to load
+        double streamWaitMs;
+        uint64_t droppedRays;       // DepthFirst: children dropped by a full work stack
+        int bvhBuilds;              // Procedural/top-level BVHs built from scratch
+        int bvhRefits;              // ... and refitted in place
+    };
+
+    // Mesh BLAS cache usage (see DXEngine::ResidencyStats)
+    struct ResidencyStatsNative
+    {
+        uint64_t budgetBytes;
+        uint64_t residentBytes;
+        uint64_t pinnedBytes;
+        uint64_t peakResidentBytes;
+        int residentCount;
+        int pinnedCount;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t evictedBytes;
+    };
+
+    // Out-of-core geometry streaming (see DXEngine::GeometryStreamingStats)
+    struct GeometryStreamingStatsNative
+    {
+        ResidencyStatsNative residency;     // Entries are chunks
+        int meshCount;
+        int chunkCount;
+        uint64_t chunkLoads;
+        uint64_t loadedBytes;
+        uint64_t failedLoads;
+        uint64_t releasedChunks;            // Evicted within a pass
+        double loadMs;
+    };
+
+    // A frame acquired from a FrameSink; data stays valid until ReleaseFrame
+    struct FrameViewNative
+    {
+        unsigned char* data;
+        int width;
+        int height;
+        int rowPitch;
+        int format;                 // 0 = RGBA8, 1 = BGRA8, 2 = RGBA32F (FrameFormat)
+        uint64_t frameNumber;       // Increases with every published frame
+    };
+
     // Bridge functions (fully native)
     DXENGINE_API RayTraceVS::DXEngine::DXContext* CreateDXContext();
     DXENGINE_API bool InitializeDXContext(RayTraceVS::DXEngine::DXContext* context, void* hwnd, int width, int height);
@@ -127,6 +234,10 @@ namespace RayTraceVS::Interop::Bridge
     DXENGINE_API bool InitializeDXRPipeline(RayTraceVS::DXEngine::DXRPipeline* pipeline);
     DXENGINE_API void DestroyDXRPipeline(RayTraceVS::DXEngine::DXRPipeline* pipeline);
     DXENGINE_API void DispatchRays(RayTraceVS::DXEngine::DXRPipeline* pipeline, int width, int height);
+    DXENGINE_API bool GetFrameStats(RayTraceVS::DXEngine::DXRPipeline* pipeline, FrameStatsNative* outStats);
+    // Byte budget of mesh BLASes cached for meshes no instance uses (LRU eviction beyond it)
+    DXENGINE_API void SetMeshResidencyBudget(RayTraceVS::DXEngine::DXRPipeline* pipeline, uint64_t budgetBytes);
+    DXENGINE_API bool GetMeshResidencyStats(RayTraceVS::DXEngine::DXRPipeline* pipeline, ResidencyStatsNative* outStats);
 
     DXENGINE_API RayTraceVS::DXEngine::Scene* CreateScene();
     DXENGINE_API void DestroyScene(RayTraceVS::DXEngine::Scene* scene);
@@ -134,12 +245,25 @@ namespace RayTraceVS::Interop::Bridge
     DXENGINE_API void SetCamera(RayTraceVS::DXEngine::Scene* scene, const CameraDataNative& camera);
     DXENGINE_API void SetRenderSettings(RayTraceVS::DXEngine::Scene* scene, int samplesPerPixel, int maxBounces, int traceRecursionDepth, float exposure, int toneMapOperator, float denoiserStabilization, float shadowStrength, float shadowAbsorptionScale, bool enableDenoiser, float gamma, int photonDebugMode, float photonDebugScale,
         float lightAttenuationConstant, float lightAttenuationLinear, float lightAttenuationQuadratic, int maxShadowLights, float nrdBypassDistance, float nrdBypassBlendRange);
+    // hdrPath: Radiance .hdr (equirectangular); null or empty selects the built-in sky
+    DXENGINE_API void SetEnvironment(RayTraceVS::DXEngine::Scene* scene, const wchar_t* hdrPath, float intensity, bool lighting);
+    // Bounces after which Russian roulette may end a GPU path (CPU: CpuRenderSettingsNative)
+    DXENGINE_API void SetRussianRouletteMinDepth(RayTraceVS::DXEngine::Scene* scene, int depth);
     DXENGINE_API void AddSphere(RayTraceVS::DXEngine::Scene* scene, const SphereDataNative& sphere);
     DXENGINE_API void AddPlane(RayTraceVS::DXEngine::Scene* scene, const PlaneDataNative& plane);
     DXENGINE_API void AddBox(RayTraceVS::DXEngine::Scene* scene, const BoxDataNative& box);
     DXENGINE_API void AddLight(RayTraceVS::DXEngine::Scene* scene, const LightDataNative& light);
     DXENGINE_API void AddMeshCache(RayTraceVS::DXEngine::Scene* scene, const MeshCacheDataNative& meshCache);
     DXENGINE_API void AddMeshInstance(RayTraceVS::DXEngine::Scene* scene, const MeshInstanceDataNative& meshInstance);
+    // Binary scene snapshot (.rtvsb, see SceneSnapshot.h): the evaluated scene, loaded by mapping the file
+    DXENGINE_API bool SaveSceneSnapshot(RayTraceVS::DXEngine::Scene* scene, const wchar_t* path);
+    DXENGINE_API bool LoadSceneSnapshot(RayTraceVS::DXEngine::Scene* scene, const wchar_t* path);
+    // Writes every mesh as a paged file (.rtvsm, see PagedMesh.h) into directory and makes the scene
+    // reference the files instead of in-memory geometry (CPU path tracer only); trianglesPerChunk <= 0 = default
+    DXENGINE_API bool PageSceneMeshes(RayTraceVS::DXEngine::Scene* scene, const wchar_t* directory, int trianglesPerChunk);
+    // Registers an existing paged file (.rtvsm) as the geometry of a mesh name without loading its
+    // vertices; bounds and the SBVH flag come from the file (CPU path tracer only). outInfo may be null.
+    DXENGINE_API bool AddPagedMeshCache(RayTraceVS::DXEngine::Scene* scene, const char* name, const wchar_t* path, PagedMeshInfoNative* outInfo);
 
     // Render target related
     DXENGINE_API RayTraceVS::DXEngine::RenderTarget* CreateRenderTarget(RayTraceVS::DXEngine::DXContext* context);
@@ -148,7 +272,52 @@ namespace RayTraceVS::Interop::Bridge
     DXENGINE_API void RenderTestPattern(RayTraceVS::DXEngine::DXRPipeline* pipeline, RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::Scene* scene);
     DXENGINE_API bool CopyRenderTargetToReadback(RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::DXContext* context);
     DXENGINE_API bool ReadRenderTargetPixels(RayTraceVS::DXEngine::RenderTarget* target, unsigned char* outData, int dataSize);
+
+    // Frame sink: 2-3 caller-owned buffers of height * rowPitch bytes, written by a backend
+    // and read by the consumer without per-frame allocation (see FrameSink.h). bufferCount 0 detaches.
+    DXENGINE_API RayTraceVS::DXEngine::FrameSink* CreateFrameSink();
+    DXENGINE_API void DestroyFrameSink(RayTraceVS::DXEngine::FrameSink* sink);
+    DXENGINE_API bool ConfigureFrameSink(RayTraceVS::DXEngine::FrameSink* sink, int width, int height, int format, int rowPitch,
+        unsigned char* const* buffers, int bufferCount);
+    // After CopyRenderTargetToReadback has completed on the GPU; format RGBA8 or BGRA8
+    DXENGINE_API bool ResolveRenderTargetToSink(RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::FrameSink* sink);
+    DXENGINE_API bool AcquireFrame(RayTraceVS::DXEngine::FrameSink* sink, FrameViewNative* outFrame);
+    DXENGINE_API void ReleaseFrame(RayTraceVS::DXEngine::FrameSink* sink);
+
+    // Shared-memory frame channel between a renderer process and a viewer process (see FrameChannel.h).
+    // Create = producer side (slots of width x height in format), Open = consumer side.
+    DXENGINE_API RayTraceVS::DXEngine::FrameChannel* CreateFrameChannel(const char* name, int width, int height, int format, int slotCount);
+    DXENGINE_API RayTraceVS::DXEngine::FrameChannel* OpenFrameChannel(const char* name);
+    DXENGINE_API void DestroyFrameChannel(RayTraceVS::DXEngine::FrameChannel* channel);
+    // After CopyRenderTargetToReadback has completed on the GPU; format RGBA8 or BGRA8
+    DXENGINE_API bool ResolveRenderTargetToChannel(RayTraceVS::DXEngine::RenderTarget* target, RayTraceVS::DXEngine::FrameChannel* channel, int format);
+    // Consumer: polls for a frame newer than the last one; data points into shared memory
+    DXENGINE_API bool AcquireChannelFrame(RayTraceVS::DXEngine::FrameChannel* channel, FrameViewNative* outFrame);
+    // false if the producer overwrote the frame while it was being read
+    DXENGINE_API bool ReleaseChannelFrame(RayTraceVS::DXEngine::FrameChannel* channel);
+
+    // CPU rendering (no device required); outRadiance receives width * height linear RGBA floats
+    DXENGINE_API RayTraceVS::DXEngine::CpuPathTracer* CreateCpuPathTracer();
+    DXENGINE_API void DestroyCpuPathTracer(RayTraceVS::DXEngine::CpuPathTracer* tracer);
+    DXENGINE_API bool RenderSceneCpu(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, float* outRadiance, int floatCount, CpuRenderStatsNative* outStats);
+    // Same into the next buffer of a sink configured as RGBA32F
+    DXENGINE_API bool RenderSceneCpuToSink(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, RayTraceVS::DXEngine::FrameSink* sink, CpuRenderStatsNative* outStats);
+    // Same into the next slot of a frame channel (RGBA32F)
+    DXENGINE_API bool RenderSceneCpuToChannel(RayTraceVS::DXEngine::CpuPathTracer* tracer, RayTraceVS::DXEngine::Scene* scene,
+        const CpuRenderSettingsNative& settings, RayTraceVS::DXEngine::FrameChannel* channel, CpuRenderStatsNative* outStats);
+    DXENGINE_API void SetCpuMeshResidencyBudget(RayTraceVS::DXEngine::CpuPathTracer* tracer, uint64_t budgetBytes);
+    DXENGINE_API bool GetCpuMeshResidencyStats(RayTraceVS::DXEngine::CpuPathTracer* tracer, ResidencyStatsNative* outStats);
+    // Byte budget of paged geometry chunks kept in memory
+    DXENGINE_API void SetCpuGeometryStreamingBudget(RayTraceVS::DXEngine::CpuPathTracer* tracer, uint64_t budgetBytes);
+    DXENGINE_API bool GetCpuGeometryStreamingStats(RayTraceVS::DXEngine::CpuPathTracer* tracer, GeometryStreamingStatsNative* outStats);
     
+    // Logging (asynchronous; see DebugLog.h)
+    DXENGINE_API void SetLogOptions(int logEnabled, int debugMode);
+    DXENGINE_API void SetLogFilePath(const char* path);
+    DXENGINE_API void FlushLog();
+
     // Command list execution and GPU wait
     DXENGINE_API void ExecuteCommandList(RayTraceVS::DXEngine::DXContext* context);
     DXENGINE_API void WaitForGPU(RayTraceVS::DXEngine::DXContext* context);
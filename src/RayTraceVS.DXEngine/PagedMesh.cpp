@@ -0,0 +1,736 @@
+#include "PagedMesh.h"
+#include "DebugLog.h"
+#include "Scene/Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr size_t FLOATS_PER_VERTEX = 8;     // pos3 + pad + normal3 + pad (MeshCacheEntry)
+
+        static_assert(sizeof(PagedMeshFileHeader) % 8 == 0, "PagedMeshFileHeader must keep the chunk table aligned");
+        static_assert(sizeof(PagedMeshChunkRecord) % 8 == 0, "PagedMeshChunkRecord must keep its 64-bit fields aligned in an array");
+        static_assert(sizeof(BvhNode) == 9 * sizeof(uint32_t), "BvhNode must not contain padding");
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        uint64_t GetChunkPayloadBytes(const PagedMeshChunkRecord& record)
+        {
+            return static_cast<uint64_t>(record.vertexCount) * sizeof(XMFLOAT3) +
+                static_cast<uint64_t>(record.triangleCount) * 4 * sizeof(uint32_t) +
+                static_cast<uint64_t>(record.nodeCount) * sizeof(BvhNode) +
+                static_cast<uint64_t>(record.referenceCount) * sizeof(uint32_t);
+        }
+
+        uint64_t GetChunkMemoryBytes(const PagedMeshChunk& chunk)
+        {
+            return chunk.positions.size() * sizeof(XMFLOAT3) + chunk.indices.size() * sizeof(uint32_t) +
+                chunk.triangleIds.size() * sizeof(uint32_t) + chunk.bvh.GetNodeCount() * sizeof(BvhNode) +
+                chunk.bvh.GetPrimitiveCount() * sizeof(uint32_t);
+        }
+
+        template<typename T>
+        void ReadArray(const uint8_t*& cursor, std::vector<T>& out, size_t count)
+        {
+            out.resize(count);
+            if (count > 0)
+                memcpy(out.data(), cursor, count * sizeof(T));
+            cursor += count * sizeof(T);
+        }
+    }
+
+    // ============================================
+    // Writing
+    // ============================================
+
+    bool PagedMeshFile::Write(const MeshCacheEntry& mesh, const std::filesystem::path& path, uint32_t trianglesPerChunk)
+    {
+        const size_t vertexCount = mesh.vertices.size() / FLOATS_PER_VERTEX;
+        const size_t triangleCount = mesh.indices.size() / 3;
+        if (vertexCount == 0 || triangleCount == 0 || trianglesPerChunk == 0)
+        {
+            LOG_WARNF("PagedMeshFile::Write: mesh '%s' has no geometry in memory", mesh.name);
+            return false;
+        }
+
+        std::vector<XMFLOAT3> positions(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            const float* vertex = &mesh.vertices[v * FLOATS_PER_VERTEX];
+            positions[v] = XMFLOAT3(vertex[0], vertex[1], vertex[2]);
+        }
+
+        std::vector<AABB> triangleBounds(triangleCount);
+        std::vector<XMFLOAT3> centroids(triangleCount);
+        AABB meshBounds = EmptyAABB();
+        for (size_t tri = 0; tri < triangleCount; tri++)
+        {
+            AABB bounds = EmptyAABB();
+            for (int corner = 0; corner < 3; corner++)
+            {
+                const uint32_t index = mesh.indices[tri * 3 + corner];
+                if (index >= vertexCount)
+                {
+                    LOG_WARNF("PagedMeshFile::Write: mesh '%s' has out-of-range indices", mesh.name);
+                    return false;
+                }
+                const XMFLOAT3& p = positions[index];
+                ExpandAABB(bounds, { p.x, p.y, p.z, p.x, p.y, p.z });
+            }
+            triangleBounds[tri] = bounds;
+            centroids[tri] = XMFLOAT3((bounds.MinX + bounds.MaxX) * 0.5f, (bounds.MinY + bounds.MaxY) * 0.5f,
+                (bounds.MinZ + bounds.MaxZ) * 0.5f);
+            ExpandAABB(meshBounds, bounds);
+        }
+
+        // Spatially coherent chunks: median splits on the longest axis of the centroid bounds,
+        // left before right so neighbouring chunks also sit close together in the file
+        struct Range
+        {
+            size_t begin;
+            size_t end;
+        };
+        std::vector<uint32_t> order(triangleCount);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(triangleCount); i++)
+            order[i] = i;
+        std::vector<Range> ranges;
+        std::vector<Range> stack = { { 0, triangleCount } };
+        while (!stack.empty())
+        {
+            const Range range = stack.back();
+            stack.pop_back();
+            if (range.end - range.begin <= trianglesPerChunk)
+            {
+                ranges.push_back(range);
+                continue;
+            }
+
+            AABB centroidBounds = EmptyAABB();
+            for (size_t i = range.begin; i < range.end; i++)
+            {
+                const XMFLOAT3& c = centroids[order[i]];
+                ExpandAABB(centroidBounds, { c.x, c.y, c.z, c.x, c.y, c.z });
+            }
+            const float extent[3] = { centroidBounds.MaxX - centroidBounds.MinX, centroidBounds.MaxY - centroidBounds.MinY,
+                centroidBounds.MaxZ - centroidBounds.MinZ };
+            const int axis = extent[0] >= extent[1] && extent[0] >= extent[2] ? 0 : (extent[1] >= extent[2] ? 1 : 2);
+            const size_t middle = range.begin + (range.end - range.begin) / 2;
+            std::nth_element(order.begin() + range.begin, order.begin() + middle, order.begin() + range.end,
+                [&](uint32_t a, uint32_t b)
+                {
+                    const float ca = axis == 0 ? centroids[a].x : (axis == 1 ? centroids[a].y : centroids[a].z);
+                    const float cb = axis == 0 ? centroids[b].x : (axis == 1 ? centroids[b].y : centroids[b].z);
+                    return ca != cb ? ca < cb : a < b;
+                });
+            stack.push_back({ middle, range.end });
+            stack.push_back({ range.begin, middle });
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            LOG_WARNF("PagedMeshFile::Write: cannot create %s", path.string().c_str());
+            return false;
+        }
+
+        // Header and chunk table are written last, once the offsets are known
+        PagedMeshFileHeader header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.chunkCount = static_cast<uint32_t>(ranges.size());
+        header.chunkTableOffset = sizeof(PagedMeshFileHeader);
+        header.triangleCount = triangleCount;
+        header.bounds = meshBounds;
+        header.spatialSplits = mesh.spatialSplits ? 1u : 0u;
+        std::vector<PagedMeshChunkRecord> records(ranges.size());
+        uint64_t position = header.chunkTableOffset + records.size() * sizeof(PagedMeshChunkRecord);
+
+        std::vector<uint32_t> localIndex(vertexCount, CpuBvh::INVALID_INDEX);
+        const std::vector<char> padding(CHUNK_ALIGNMENT, 0);
+        auto write = [&](const void* data, size_t bytes)
+        {
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            position += bytes;
+        };
+
+        const std::vector<char> placeholder(static_cast<size_t>(position), 0);
+        file.write(placeholder.data(), static_cast<std::streamsize>(placeholder.size()));
+
+        for (size_t c = 0; c < ranges.size(); c++)
+        {
+            PagedMeshChunk chunk;
+            std::vector<AABB> bounds;
+            AABB chunkBounds = EmptyAABB();
+            for (size_t i = ranges[c].begin; i < ranges[c].end; i++)
+            {
+                const uint32_t tri = order[i];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    const uint32_t index = mesh.indices[static_cast<size_t>(tri) * 3 + corner];
+                    if (localIndex[index] == CpuBvh::INVALID_INDEX)
+                    {
+                        localIndex[index] = static_cast<uint32_t>(chunk.positions.size());
+                        chunk.positions.push_back(positions[index]);
+                    }
+                    chunk.indices.push_back(localIndex[index]);
+                }
+                chunk.triangleIds.push_back(tri);
+                bounds.push_back(triangleBounds[tri]);
+                ExpandAABB(chunkBounds, triangleBounds[tri]);
+            }
+            // Reset only the entries this chunk used
+            for (size_t i = ranges[c].begin; i < ranges[c].end; i++)
+            {
+                for (int corner = 0; corner < 3; corner++)
+                    localIndex[mesh.indices[static_cast<size_t>(order[i]) * 3 + corner]] = CpuBvh::INVALID_INDEX;
+            }
+
+            if (mesh.spatialSplits)
+            {
+                std::vector<float> triangleVertices(chunk.indices.size() * 3);
+                for (size_t i = 0; i < chunk.indices.size(); i++)
+                {
+                    const XMFLOAT3& p = chunk.positions[chunk.indices[i]];
+                    triangleVertices[i * 3 + 0] = p.x;
+                    triangleVertices[i * 3 + 1] = p.y;
+                    triangleVertices[i * 3 + 2] = p.z;
+                }
+                chunk.bvh.BuildSpatial(bounds, triangleVertices);
+            }
+            else
+            {
+                chunk.bvh.Build(bounds);
+            }
+
+            PagedMeshChunkRecord& record = records[c];
+            record.bounds = chunkBounds;
+            record.vertexCount = static_cast<uint32_t>(chunk.positions.size());
+            record.triangleCount = static_cast<uint32_t>(chunk.triangleIds.size());
+            record.nodeCount = static_cast<uint32_t>(chunk.bvh.GetNodeCount());
+            record.referenceCount = static_cast<uint32_t>(chunk.bvh.GetPrimitiveCount());
+            record.offset = AlignUp(position, CHUNK_ALIGNMENT);
+            record.bytes = GetChunkPayloadBytes(record);
+
+            write(padding.data(), static_cast<size_t>(record.offset - position));
+            write(chunk.positions.data(), chunk.positions.size() * sizeof(XMFLOAT3));
+            write(chunk.indices.data(), chunk.indices.size() * sizeof(uint32_t));
+            write(chunk.triangleIds.data(), chunk.triangleIds.size() * sizeof(uint32_t));
+            write(chunk.bvh.GetNodes().data(), chunk.bvh.GetNodeCount() * sizeof(BvhNode));
+            write(chunk.bvh.GetPrimitiveOrder().data(), chunk.bvh.GetPrimitiveCount() * sizeof(uint32_t));
+        }
+
+        header.fileSize = position;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(PagedMeshChunkRecord)));
+        if (!file.good())
+        {
+            LOG_WARNF("PagedMeshFile::Write: write to %s failed", path.string().c_str());
+            return false;
+        }
+
+        LOG_INFOF("PagedMeshFile: wrote '%s' as %zu chunks (%zu triangles, %.1f MB) to %s", mesh.name, records.size(),
+            triangleCount, static_cast<double>(position) / (1024.0 * 1024.0), path.string().c_str());
+        return true;
+    }
+
+    // ============================================
+    // Mapping
+    // ============================================
+
+    PagedMeshFile::~PagedMeshFile()
+    {
+        Close();
+    }
+
+    bool PagedMeshFile::Open(const std::filesystem::path& path)
+    {
+        Close();
+
+#ifdef _WIN32
+        // Random access: chunks are read in the order rays reach them
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            LOG_WARNF("PagedMeshFile::Open: cannot open %s", path.string().c_str());
+            return false;
+        }
+        LARGE_INTEGER size = {};
+        GetFileSizeEx(file, &size);
+        HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            LOG_WARNF("PagedMeshFile::Open: cannot map %s", path.string().c_str());
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+        fileHandle = file;
+        mappingHandle = mapping;
+        fileSize = static_cast<uint64_t>(size.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info = {};
+        if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            LOG_WARNF("PagedMeshFile::Open: cannot open %s", path.string().c_str());
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            LOG_WARNF("PagedMeshFile::Open: cannot map %s", path.string().c_str());
+            return false;
+        }
+        madvise(view, static_cast<size_t>(info.st_size), MADV_RANDOM);
+        fileSize = static_cast<uint64_t>(info.st_size);
+#endif
+        base = static_cast<const uint8_t*>(view);
+
+        const auto* fileHeader = reinterpret_cast<const PagedMeshFileHeader*>(base);
+        bool valid = fileSize >= sizeof(PagedMeshFileHeader) && fileHeader->magic == MAGIC && fileHeader->version == VERSION &&
+            fileHeader->fileSize == fileSize && fileHeader->chunkTableOffset % 8 == 0 &&
+            fileHeader->chunkTableOffset <= fileSize &&
+            fileHeader->chunkCount <= (fileSize - fileHeader->chunkTableOffset) / sizeof(PagedMeshChunkRecord);
+        if (valid)
+        {
+            header = fileHeader;
+            chunks = std::span<const PagedMeshChunkRecord>(
+                reinterpret_cast<const PagedMeshChunkRecord*>(base + header->chunkTableOffset), header->chunkCount);
+            for (const PagedMeshChunkRecord& record : chunks)
+            {
+                valid = valid && record.offset % CHUNK_ALIGNMENT == 0 && record.offset <= fileSize &&
+                    record.bytes <= fileSize - record.offset && record.bytes == GetChunkPayloadBytes(record);
+            }
+        }
+        if (!valid)
+        {
+            LOG_WARNF("PagedMeshFile::Open: %s is not a valid paged mesh (version %u expected)", path.string().c_str(), VERSION);
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void PagedMeshFile::Close()
+    {
+        if (base)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+            CloseHandle(static_cast<HANDLE>(mappingHandle));
+            CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+            munmap(const_cast<uint8_t*>(base), fileSize);
+#endif
+        }
+        base = nullptr;
+        fileSize = 0;
+        fileHandle = mappingHandle = nullptr;
+        header = nullptr;
+        chunks = {};
+    }
+
+    bool PagedMeshFile::ReadChunk(uint32_t chunk, PagedMeshChunk& out) const
+    {
+        out = PagedMeshChunk();
+        if (chunk >= chunks.size())
+            return false;
+
+        // Sizes were checked against the file in Open
+        const PagedMeshChunkRecord& record = chunks[chunk];
+        const uint8_t* cursor = base + record.offset;
+        std::vector<BvhNode> nodes;
+        std::vector<uint32_t> references;
+        ReadArray(cursor, out.positions, record.vertexCount);
+        ReadArray(cursor, out.indices, static_cast<size_t>(record.triangleCount) * 3);
+        ReadArray(cursor, out.triangleIds, record.triangleCount);
+        ReadArray(cursor, nodes, record.nodeCount);
+        ReadArray(cursor, references, record.referenceCount);
+
+        for (uint32_t index : out.indices)
+        {
+            if (index >= record.vertexCount)
+                return false;
+        }
+        for (uint32_t triangle : out.triangleIds)
+        {
+            if (triangle >= header->triangleCount)
+                return false;
+        }
+        // The mapped pages would otherwise stay in the working set until the system trims it,
+        // and a pass over the whole mesh would hold the file in memory next to the copies
+        void* pages = const_cast<uint8_t*>(base + record.offset);
+#ifdef _WIN32
+        // Unlocking a range that is not locked removes its pages from the working set
+        VirtualUnlock(pages, static_cast<SIZE_T>(record.bytes));
+#else
+        madvise(pages, static_cast<size_t>(record.bytes), MADV_DONTNEED);
+#endif
+
+        return out.bvh.Assign(std::move(nodes), std::move(references), record.triangleCount, header->spatialSplits != 0);
+    }
+
+    bool PageSceneMeshes(Scene& scene, const std::filesystem::path& directory, uint32_t trianglesPerChunk)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        // One file per unique geometry; already paged caches are kept as they are
+        std::unordered_map<std::string, MeshCacheEntry> pagedByKey;
+        for (const auto& [key, cache] : scene.GetMeshCaches())
+        {
+            if (!cache.pagedFile.empty())
+                continue;
+
+            const std::filesystem::path path = directory / (key + ".rtvsm");
+            if (!PagedMeshFile::Write(cache, path, trianglesPerChunk))
+                return false;
+
+            MeshCacheEntry paged;
+            paged.boundsMin = cache.boundsMin;
+            paged.boundsMax = cache.boundsMax;
+            paged.spatialSplits = cache.spatialSplits;
+            paged.pagedFile = path.wstring();
+            pagedByKey.emplace(key, std::move(paged));
+        }
+
+        // Re-adding a name drops its in-memory geometry once no other name references it
+        const std::vector<std::pair<std::string, std::string>> aliases(scene.GetMeshAliases().begin(), scene.GetMeshAliases().end());
+        for (const auto& [name, key] : aliases)
+        {
+            auto it = pagedByKey.find(key);
+            if (it == pagedByKey.end())
+                continue;
+
+            MeshCacheEntry paged = it->second;
+            paged.name = name;
+            scene.AddMeshCache(paged);
+        }
+
+        LOG_INFOF("PageSceneMeshes: %zu meshes written to %s", pagedByKey.size(), directory.string().c_str());
+        return true;
+    }
+
+    bool AddPagedMeshCache(Scene& scene, const std::string& name, const std::filesystem::path& path,
+        PagedMeshFileHeader* outFile)
+    {
+        // Open only maps the file and validates the chunk table; no chunk is read
+        PagedMeshFile file;
+        if (!file.Open(path))
+            return false;
+
+        // Absolute, so snapshots and other working directories still find the file
+        std::error_code error;
+        const std::filesystem::path absolutePath = std::filesystem::absolute(path, error);
+
+        MeshCacheEntry paged;
+        paged.name = name;
+        const AABB bounds = file.GetBounds();
+        paged.boundsMin = XMFLOAT3(bounds.MinX, bounds.MinY, bounds.MinZ);
+        paged.boundsMax = XMFLOAT3(bounds.MaxX, bounds.MaxY, bounds.MaxZ);
+        paged.spatialSplits = file.HasSpatialSplits();
+        paged.pagedFile = (error ? path : absolutePath).wstring();
+        scene.AddMeshCache(paged);
+
+        if (outFile)
+            *outFile = *file.GetHeader();
+        LOG_INFOF("AddPagedMeshCache: '%s' from %s (%llu triangles, %u chunks)", name.c_str(), path.string().c_str(),
+            static_cast<unsigned long long>(file.GetTriangleCount()), file.GetChunkCount());
+        return true;
+    }
+
+    // ============================================
+    // Streaming
+    // ============================================
+
+    GeometryStreamer::GeometryStreamer(uint64_t budgetBytes)
+        : residency(budgetBytes)
+    {
+    }
+
+    GeometryStreamer::~GeometryStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workReady.notify_all();
+        if (loader.joinable())
+            loader.join();
+    }
+
+    uint32_t GeometryStreamer::OpenMesh(const std::filesystem::path& path)
+    {
+        auto existing = meshByPath.find(path.wstring());
+        if (existing != meshByPath.end())
+            return existing->second;
+
+        auto file = std::make_unique<PagedMeshFile>();
+        if (!file->Open(path))
+            return CpuBvh::INVALID_INDEX;
+
+        const uint32_t mesh = static_cast<uint32_t>(meshes.size());
+        const uint32_t firstChunk = static_cast<uint32_t>(slots.size());
+        for (uint32_t c = 0; c < file->GetChunkCount(); c++)
+        {
+            Slot& slot = slots.emplace_back();
+            slot.mesh = mesh;
+            slot.chunk = c;
+            slot.bounds = file->GetChunks()[c].bounds;
+            slot.bytes = GetChunkPayloadBytes(file->GetChunks()[c]);
+        }
+        meshes.push_back({ std::move(file), firstChunk });
+        meshByPath[path.wstring()] = mesh;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.meshCount = static_cast<uint32_t>(meshes.size());
+        stats.chunkCount = static_cast<uint32_t>(slots.size());
+        return mesh;
+    }
+
+    void GeometryStreamer::Clear()
+    {
+        {
+            // Queued chunks are dropped; the one being loaded is waited for
+            std::unique_lock<std::mutex> lock(mutex);
+            for (uint32_t chunk : queue)
+            {
+                slots[chunk].state.store(Slot_NotResident, std::memory_order_relaxed);
+                queuedBytes -= slots[chunk].bytes;
+            }
+            inFlight -= static_cast<uint32_t>(queue.size());
+            queue.clear();
+            loadDone.wait(lock, [&] { return inFlight == 0; });
+
+            residency.Clear();
+            stats.meshCount = 0;
+            stats.chunkCount = 0;
+        }
+        slots.clear();
+        meshes.clear();
+        meshByPath.clear();
+    }
+
+    const PagedMeshChunk* GeometryStreamer::Find(uint32_t chunk)
+    {
+        Slot& slot = slots[chunk];
+        if (slot.state.load(std::memory_order_acquire) != Slot_Resident)
+            return nullptr;
+
+        const uint64_t current = pass.load(std::memory_order_relaxed);
+        if (slot.lastPass.load(std::memory_order_relaxed) != current)
+            slot.lastPass.store(current, std::memory_order_relaxed);
+        return slot.data.get();
+    }
+
+    void GeometryStreamer::Request(uint32_t chunk)
+    {
+        if (slots[chunk].state.load(std::memory_order_acquire) != Slot_NotResident)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!Enqueue(chunk))
+                return;
+        }
+        workReady.notify_one();
+    }
+
+    bool GeometryStreamer::Prefetch(uint32_t chunk)
+    {
+        if (slots[chunk].state.load(std::memory_order_acquire) != Slot_NotResident)
+            return true;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (residency.GetStats().residentBytes + queuedBytes + slots[chunk].bytes > residency.GetBudget())
+                return false;
+            if (!Enqueue(chunk))
+                return true;
+        }
+        workReady.notify_one();
+        return true;
+    }
+
+    bool GeometryStreamer::Enqueue(uint32_t chunk)
+    {
+        uint32_t expected = Slot_NotResident;
+        if (!slots[chunk].state.compare_exchange_strong(expected, Slot_Queued, std::memory_order_acq_rel))
+            return false;
+
+        queue.push_back(chunk);
+        inFlight++;
+        queuedBytes += slots[chunk].bytes;
+        if (!loader.joinable())
+            loader = std::thread(&GeometryStreamer::LoaderMain, this);
+        return true;
+    }
+
+    bool GeometryStreamer::IsResident(uint32_t chunk) const
+    {
+        return slots[chunk].state.load(std::memory_order_acquire) == Slot_Resident;
+    }
+
+    const PagedMeshChunk* GeometryStreamer::Load(uint32_t chunk)
+    {
+        if (const PagedMeshChunk* resident = Find(chunk))
+            return resident;
+
+        Request(chunk);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            loadDone.wait(lock, [&] { return IsResident(chunk); });
+        }
+        return Find(chunk);
+    }
+
+    bool GeometryStreamer::WaitForLoads()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (inFlight == 0)
+            return false;
+
+        const uint64_t seen = completedLoads;
+        loadDone.wait(lock, [&] { return completedLoads != seen || inFlight == 0; });
+        return true;
+    }
+
+    void GeometryStreamer::BeginPass()
+    {
+        pass.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void GeometryStreamer::EndPass()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const uint64_t current = pass.load(std::memory_order_relaxed);
+        for (uint32_t chunk = 0; chunk < static_cast<uint32_t>(slots.size()); chunk++)
+        {
+            const Slot& slot = slots[chunk];
+            if (slot.state.load(std::memory_order_relaxed) == Slot_Resident && slot.lastPass.load(std::memory_order_relaxed) == current)
+                residency.Use(std::to_string(chunk));
+        }
+
+        // No query needs the chunks any more: unpin everything and trim to the budget. Only
+        // resident chunks are in the residency manager, so no load races the eviction.
+        residency.BeginFrame();
+        for (const std::string& key : residency.Trim())
+        {
+            Slot& slot = slots[std::stoul(key)];
+            slot.state.store(Slot_NotResident, std::memory_order_relaxed);
+            slot.data.reset();
+        }
+    }
+
+    void GeometryStreamer::Release(uint64_t requestBytes, const std::function<bool(uint32_t)>& stillNeeded)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto fits = [&]() { return residency.GetStats().residentBytes + queuedBytes + requestBytes <= residency.GetBudget(); };
+        if (fits())
+            return;
+
+        // Resident chunks are only written by the loader before they become resident, and
+        // no query holds a pointer between the stages of a pass
+        std::vector<uint32_t> candidates;
+        for (uint32_t chunk = 0; chunk < static_cast<uint32_t>(slots.size()); chunk++)
+        {
+            if (slots[chunk].state.load(std::memory_order_relaxed) == Slot_Resident && !stillNeeded(chunk))
+                candidates.push_back(chunk);
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+        {
+            return slots[a].lastPass.load(std::memory_order_relaxed) < slots[b].lastPass.load(std::memory_order_relaxed);
+        });
+
+        for (uint32_t chunk : candidates)
+        {
+            if (fits())
+                break;
+            Slot& slot = slots[chunk];
+            residency.Remove(std::to_string(chunk));
+            slot.state.store(Slot_NotResident, std::memory_order_relaxed);
+            slot.data.reset();
+            stats.releasedChunks++;
+        }
+    }
+
+    void GeometryStreamer::SetBudget(uint64_t budgetBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        residency.SetBudget(budgetBytes);
+    }
+
+    GeometryStreamingStats GeometryStreamer::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        GeometryStreamingStats result = stats;
+        result.residency = residency.GetStats();
+        return result;
+    }
+
+    void GeometryStreamer::LoaderMain()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            workReady.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+
+            const uint32_t chunk = queue.front();
+            queue.pop_front();
+            Slot& slot = slots[chunk];
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            auto data = std::make_unique<PagedMeshChunk>();
+            const bool loaded = meshes[slot.mesh].file->ReadChunk(slot.chunk, *data);
+            if (!loaded)
+            {
+                // Resident but empty, so rays waiting on it are released rather than stuck
+                LOG_WARNF("[GeometryStreamer] Chunk %u of mesh %u is corrupt, treated as empty", slot.chunk, slot.mesh);
+                *data = PagedMeshChunk();
+            }
+            const uint64_t bytes = GetChunkMemoryBytes(*data);
+            const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            slot.data = std::move(data);
+            residency.Add(std::to_string(chunk), bytes);
+            stats.chunkLoads++;
+            stats.loadedBytes += bytes;
+            stats.failedLoads += loaded ? 0 : 1;
+            stats.loadMs += loadMs;
+            slot.lastPass.store(pass.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            slot.state.store(Slot_Resident, std::memory_order_release);
+            inFlight--;
+            queuedBytes -= slot.bytes;
+            completedLoads++;
+            loadDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include "CpuBvh.h"
+#include "ResidencyManager.h"
+
+// ============================================
+// Out-of-core mesh geometry (.rtvsm)
+// ============================================
+//
+// A mesh too large to keep in memory is written once as a paged file: its triangles are
+// split into spatially coherent chunks (median splits on the longest centroid axis), and
+// each chunk stores its own vertices, indices and prebuilt BVH in a page-aligned block.
+// The file is memory-mapped; a chunk is copied out of the mapping (the page faults are the
+// I/O) on a loader thread only when a ray reaches its bounds.
+//
+// GeometryStreamer owns the open files, the loader and the chunk residency (a
+// ResidencyManager whose keys are chunk ids). Queries never wait for I/O unless they ask
+// to: Find returns nullptr for a chunk that is not resident, and the caller defers the
+// ray and calls Prefetch, which only queues what fits in the budget. Chunks are evicted at
+// the end of a pass (BeginPass/EndPass, one per wavefront wave or band of a depth-first
+// frame), least recently used first, so chunk pointers stay valid until then and a pass
+// whose working set exceeds the budget still completes. Between the queries of a pass,
+// Release evicts chunks the pass is done with to make room for the ones it still waits for.
+//
+// Scenes reference paged geometry through MeshCacheEntry::pagedFile, either by paging
+// meshes they hold (PageSceneMeshes) or by registering an existing file (AddPagedMeshCache),
+// which never brings the vertices into memory. Only the CPU path tracer streams it; the
+// GPU pipeline skips such meshes. Little-endian only.
+
+namespace RayTraceVS::DXEngine
+{
+    class Scene;
+    struct MeshCacheEntry;
+
+    constexpr uint32_t DEFAULT_PAGED_CHUNK_TRIANGLES = 16384;
+    constexpr uint64_t DEFAULT_GEOMETRY_STREAMING_BUDGET = 512ull << 20;     // 512 MiB
+
+    struct PagedMeshFileHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t chunkCount;
+        uint64_t fileSize;
+        uint64_t chunkTableOffset;
+        uint64_t triangleCount;
+        AABB bounds;                // Object space
+        uint32_t spatialSplits;     // Chunk BVHs were built as SBVHs
+        uint32_t padding;
+    };
+
+    // Chunk payload, in this order: XMFLOAT3 positions[vertexCount], uint32_t indices[3 * triangleCount],
+    // uint32_t triangleIds[triangleCount], BvhNode nodes[nodeCount], uint32_t references[referenceCount]
+    struct PagedMeshChunkRecord
+    {
+        AABB bounds;
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+        uint32_t nodeCount;
+        uint32_t referenceCount;
+        uint64_t offset;            // From the start of the file, CHUNK_ALIGNMENT aligned
+        uint64_t bytes;
+    };
+
+    // In-memory copy of one chunk
+    struct PagedMeshChunk
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t> indices;          // Into positions, 3 per triangle
+        std::vector<uint32_t> triangleIds;      // Triangle index in the source mesh
+        CpuBvh bvh;                             // Over the chunk's triangles
+    };
+
+    class PagedMeshFile
+    {
+    public:
+        static constexpr uint64_t MAGIC = 0x314D475053565452ull;     // "RTVSPGM1"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint64_t CHUNK_ALIGNMENT = 4096;
+
+        PagedMeshFile() = default;
+        ~PagedMeshFile();
+        PagedMeshFile(const PagedMeshFile&) = delete;
+        PagedMeshFile& operator=(const PagedMeshFile&) = delete;
+
+        // Splits the mesh into chunks of at most trianglesPerChunk triangles and writes them
+        static bool Write(const MeshCacheEntry& mesh, const std::filesystem::path& path,
+            uint32_t trianglesPerChunk = DEFAULT_PAGED_CHUNK_TRIANGLES);
+
+        // Maps the file read-only and validates the chunk table
+        bool Open(const std::filesystem::path& path);
+        void Close();
+        bool IsOpen() const { return base != nullptr; }
+
+        // Copies a chunk out of the mapping and drops its mapped pages from the working set
+        // (the copy is what stays resident); false if its payload is inconsistent
+        bool ReadChunk(uint32_t chunk, PagedMeshChunk& out) const;
+
+        uint32_t GetChunkCount() const { return static_cast<uint32_t>(chunks.size()); }
+        std::span<const PagedMeshChunkRecord> GetChunks() const { return chunks; }
+        uint64_t GetTriangleCount() const { return header ? header->triangleCount : 0; }
+        AABB GetBounds() const { return header ? header->bounds : EmptyAABB(); }
+        bool HasSpatialSplits() const { return header && header->spatialSplits != 0; }
+        // Null unless open
+        const PagedMeshFileHeader* GetHeader() const { return header; }
+        uint64_t GetFileSize() const { return fileSize; }
+
+    private:
+        const uint8_t* base = nullptr;
+        uint64_t fileSize = 0;
+        void* fileHandle = nullptr;         // Windows: file and mapping handles
+        void* mappingHandle = nullptr;
+        const PagedMeshFileHeader* header = nullptr;
+        std::span<const PagedMeshChunkRecord> chunks;
+    };
+
+    // Writes every mesh cache of the scene as <directory>/<content key>.rtvsm and replaces
+    // the in-memory geometry of each mesh name with a reference to its file
+    bool PageSceneMeshes(Scene& scene, const std::filesystem::path& directory,
+        uint32_t trianglesPerChunk = DEFAULT_PAGED_CHUNK_TRIANGLES);
+
+    // Registers an existing paged file as the geometry of a mesh name. Only the header and
+    // chunk table are read: bounds and the SBVH flag come from the file, and the vertices stay
+    // on disk until the CPU path tracer streams them. outFile (optional) receives the file
+    // header. False if the file cannot be opened or is not a valid paged mesh.
+    bool AddPagedMeshCache(Scene& scene, const std::string& name, const std::filesystem::path& path,
+        PagedMeshFileHeader* outFile = nullptr);
+
+    struct GeometryStreamingStats
+    {
+        ResidencyStats residency;           // Entries are chunks, bytes their in-memory copies
+        uint32_t meshCount = 0;
+        uint32_t chunkCount = 0;
+        uint64_t chunkLoads = 0;
+        uint64_t loadedBytes = 0;
+        uint64_t failedLoads = 0;
+        uint64_t releasedChunks = 0;        // Evicted by Release, within a pass
+        double loadMs = 0.0;                // Loader thread time
+    };
+
+    class GeometryStreamer
+    {
+    public:
+        explicit GeometryStreamer(uint64_t budgetBytes = DEFAULT_GEOMETRY_STREAMING_BUDGET);
+        ~GeometryStreamer();
+        GeometryStreamer(const GeometryStreamer&) = delete;
+        GeometryStreamer& operator=(const GeometryStreamer&) = delete;
+
+        // Opens a paged file (an already open path is shared); INVALID_INDEX on failure.
+        // Not thread-safe against queries: call between frames.
+        uint32_t OpenMesh(const std::filesystem::path& path);
+        const PagedMeshFile& GetMesh(uint32_t mesh) const { return *meshes[mesh].file; }
+        // Chunk ids of a mesh are GetFirstChunk(mesh) + its chunk index
+        uint32_t GetFirstChunk(uint32_t mesh) const { return meshes[mesh].firstChunk; }
+        uint32_t GetMeshCount() const { return static_cast<uint32_t>(meshes.size()); }
+        const AABB& GetChunkBounds(uint32_t chunk) const { return slots[chunk].bounds; }
+        // Size of the chunk's in-memory copy
+        uint64_t GetChunkBytes(uint32_t chunk) const { return slots[chunk].bytes; }
+        // Waits for the loader, frees every chunk and closes every file
+        void Clear();
+
+        // Query side, safe from any number of threads
+        // Resident chunk (marked as used by this pass) or nullptr; never blocks
+        const PagedMeshChunk* Find(uint32_t chunk);
+        // Queues a non-resident chunk for the loader (no-op if it is resident or queued)
+        void Request(uint32_t chunk);
+        // Request, but only if the chunk fits in the budget next to the resident and queued
+        // chunks; false if it was left on disk
+        bool Prefetch(uint32_t chunk);
+        bool IsResident(uint32_t chunk) const;
+        // Find, or Request and wait for the load
+        const PagedMeshChunk* Load(uint32_t chunk);
+        // Blocks until at least one outstanding load completes; false if none is in flight
+        bool WaitForLoads();
+
+        // Pass boundaries, with no query running. EndPass marks the chunks used since
+        // BeginPass as most recent, then evicts chunks beyond the budget
+        void BeginPass();
+        void EndPass();
+        // Between the queries of a pass: evicts resident chunks that stillNeeded rejects,
+        // oldest first, until requestBytes more fit in the budget next to the resident and
+        // queued chunks
+        void Release(uint64_t requestBytes, const std::function<bool(uint32_t)>& stillNeeded);
+
+        void SetBudget(uint64_t budgetBytes);
+        GeometryStreamingStats GetStats() const;
+
+    private:
+        enum SlotState : uint32_t
+        {
+            Slot_NotResident,
+            Slot_Queued,
+            Slot_Resident
+        };
+
+        struct Mesh
+        {
+            std::unique_ptr<PagedMeshFile> file;
+            uint32_t firstChunk;
+        };
+
+        struct Slot
+        {
+            uint32_t mesh = 0;
+            uint32_t chunk = 0;             // Within the mesh
+            AABB bounds = {};
+            uint64_t bytes = 0;             // In-memory copy, from the chunk record
+            std::atomic<uint32_t> state = Slot_NotResident;
+            std::atomic<uint64_t> lastPass = 0;
+            std::unique_ptr<PagedMeshChunk> data;   // Written by the loader before state becomes Resident
+        };
+
+        // With the mutex held: queues a non-resident chunk; false if it was resident or queued
+        bool Enqueue(uint32_t chunk);
+        void LoaderMain();
+
+        std::vector<Mesh> meshes;
+        std::unordered_map<std::wstring, uint32_t> meshByPath;
+        std::deque<Slot> slots;             // Indexed by chunk id; a deque never moves its elements
+        std::atomic<uint64_t> pass = 1;
+
+        mutable std::mutex mutex;           // Guards everything below
+        std::condition_variable workReady;
+        std::condition_variable loadDone;
+        std::deque<uint32_t> queue;
+        uint32_t inFlight = 0;              // Queued or being loaded
+        uint64_t queuedBytes = 0;           // Of the chunks in flight
+        uint64_t completedLoads = 0;
+        bool stopping = false;
+        std::thread loader;                 // Started by the first Request
+        ResidencyManager residency;
+        GeometryStreamingStats stats;
+    };
+}
@@ -1,12 +1,14 @@
 #include "RenderTarget.h"
 #include "DXContext.h"
+#include "FrameSink.h"
+#include "DebugLog.h"
 #include <stdexcept>
 #include <stdio.h>
 
 namespace RayTraceVS::DXEngine
 {
     RenderTarget::RenderTarget(DXContext* context)
-        : dxContext(context), width(0), height(0), readbackMappedData(nullptr)
+        : dxContext(context), readbackMappedData(nullptr), readbackRowPitch(0), width(0), height(0)
     {
     }
 
@@ -26,7 +28,7 @@ namespace RayTraceVS::DXEngine
         height = h;
 
         // Create UAV resource (R8G8B8A8 for DXR UAV compatibility)
-        // RGBA->BGRA conversion is done in ReadPixels for WPF compatibility
+        // RGBA->BGRA conversion is done in ReadPixels for Bgra8 sinks (WPF)
         CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
         CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(
             DXGI_FORMAT_R8G8B8A8_UNORM,
@@ -61,6 +63,7 @@ namespace RayTraceVS::DXEngine
             &rowPitch,
             &totalSize);
 
+        readbackRowPitch = layout.Footprint.RowPitch;
         CD3DX12_RESOURCE_DESC readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(totalSize);
 
         if (FAILED(dxContext->GetDevice()->CreateCommittedResource(
@@ -131,67 +134,37 @@ namespace RayTraceVS::DXEngine
         return true;
     }
 
-    bool RenderTarget::ReadPixels(std::vector<unsigned char>& outData)
+    bool RenderTarget::ReadPixels(const FrameBufferView& target)
     {
-        try
+        if (!resource || !readbackBuffer || !readbackMappedData)
+            return false;
+        if (!target.data || target.width != width || target.height != height)
+            return false;
+        if (target.format == FrameFormat::Rgba32Float)
         {
-            if (!readbackBuffer)
-            {
-                // Error code 1: readbackBuffer is null
-                outData.resize(4);
-                outData[0] = 1;
-                return false;
-            }
-            
-            if (!resource)
-            {
-                // Error code 2: resource is null
-                outData.resize(4);
-                outData[0] = 2;
-                return false;
-            }
+            LOG_WARN("RenderTarget::ReadPixels: the render target is 8-bit; use an Rgba8 or Bgra8 sink");
+            return false;
+        }
 
-            if (!readbackMappedData)
+        // Copy per row (skipping the readback padding), swizzling for Bgra8 on the way
+        const UINT imageRowSize = width * 4;
+        for (UINT y = 0; y < height; ++y)
+        {
+            const uint8_t* source = static_cast<const uint8_t*>(readbackMappedData) + static_cast<size_t>(y) * readbackRowPitch;
+            uint8_t* destination = target.GetRow(y);
+            if (target.format == FrameFormat::Rgba8)
             {
-                // Error code 4: mappedData is null
-                outData.resize(4);
-                outData[0] = 4;
-                return false;
+                memcpy(destination, source, imageRowSize);
+                continue;
             }
-
-            // Copy pixel data
-            D3D12_RESOURCE_DESC desc = resource->GetDesc();
-            
-            // Get footprint information to calculate rowPitch
-            D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
-            dxContext->GetDevice()->GetCopyableFootprints(
-                &desc,
-                0, 1, 0,
-                &layout,
-                nullptr, nullptr, nullptr);
-
-            UINT rowPitch = layout.Footprint.RowPitch;
-            UINT imageRowPitch = width * 4; // RGBA
-
-            outData.resize(imageRowPitch * height);
-
-            // Copy per row (excluding padding)
-            for (UINT y = 0; y < height; ++y)
+            for (UINT x = 0; x < imageRowSize; x += 4)
             {
-                memcpy(
-                    &outData[y * imageRowPitch],
-                    static_cast<unsigned char*>(readbackMappedData) + y * rowPitch,
-                    imageRowPitch);
+                destination[x + 0] = source[x + 2];
+                destination[x + 1] = source[x + 1];
+                destination[x + 2] = source[x + 0];
+                destination[x + 3] = source[x + 3];
             }
-
-            return true;
-        }
-        catch (...)
-        {
-            // Error code 5: exception
-            outData.resize(4);
-            outData[0] = 5;
-            return false;
         }
+        return true;
     }
 }
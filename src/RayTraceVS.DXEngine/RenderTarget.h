@@ -3,13 +3,13 @@
 #include <d3d12.h>
 #include "d3dx12.h"
 #include <wrl/client.h>
-#include <vector>
 
 using Microsoft::WRL::ComPtr;
 
 namespace RayTraceVS::DXEngine
 {
     class DXContext;
+    struct FrameBufferView;
 
     class RenderTarget
     {
@@ -23,8 +23,9 @@ namespace RayTraceVS::DXEngine
         // Copy from render target to readback buffer
         bool CopyToReadback(ID3D12GraphicsCommandList* commandList);
         
-        // Read pixel data from readback buffer
-        bool ReadPixels(std::vector<unsigned char>& outData);
+        // Copy the readback buffer into caller memory (Rgba8 or Bgra8, any row pitch);
+        // the only CPU copy between the GPU and the consumer
+        bool ReadPixels(const FrameBufferView& target);
         
         ID3D12Resource* GetResource() const { return resource.Get(); }
         UINT GetWidth() const { return width; }
@@ -35,6 +36,7 @@ namespace RayTraceVS::DXEngine
         ComPtr<ID3D12Resource> resource;
         ComPtr<ID3D12Resource> readbackBuffer;
         void* readbackMappedData;
+        UINT readbackRowPitch;
         UINT width;
         UINT height;
     };
@@ -0,0 +1,127 @@
+#include "ResidencyManager.h"
+#include "DebugLog.h"
+#include <algorithm>
+
+namespace RayTraceVS::DXEngine
+{
+    ResidencyManager::ResidencyManager(uint64_t budgetBytes)
+    {
+        stats.budgetBytes = budgetBytes;
+    }
+
+    void ResidencyManager::SetBudget(uint64_t budgetBytes)
+    {
+        stats.budgetBytes = budgetBytes;
+    }
+
+    void ResidencyManager::BeginFrame()
+    {
+        frame++;
+        stats.pinnedBytes = 0;
+        stats.pinnedCount = 0;
+    }
+
+    void ResidencyManager::Pin(Entry& entry)
+    {
+        if (entry.frame != frame)
+        {
+            entry.frame = frame;
+            stats.pinnedBytes += entry.bytes;
+            stats.pinnedCount++;
+        }
+    }
+
+    bool ResidencyManager::Use(const std::string& key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return false;
+
+        lru.splice(lru.begin(), lru, it->second);
+        Pin(*it->second);
+        stats.hits++;
+        return true;
+    }
+
+    void ResidencyManager::Add(const std::string& key, uint64_t bytes)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            // Rebuilt in place: replace the size, keep the pin state consistent
+            Entry& entry = *it->second;
+            stats.residentBytes -= entry.bytes;
+            if (entry.frame == frame)
+                stats.pinnedBytes -= entry.bytes;
+            else
+                stats.pinnedCount++;
+            entry.bytes = bytes;
+            entry.frame = frame;
+            stats.pinnedBytes += bytes;
+            lru.splice(lru.begin(), lru, it->second);
+        }
+        else
+        {
+            lru.push_front({ key, bytes, 0 });
+            entries[key] = lru.begin();
+            Pin(lru.front());
+            stats.residentCount++;
+        }
+
+        stats.residentBytes += bytes;
+        stats.peakResidentBytes = (std::max)(stats.peakResidentBytes, stats.residentBytes);
+        stats.misses++;
+    }
+
+    void ResidencyManager::Remove(const std::string& key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return;
+
+        const Entry& entry = *it->second;
+        stats.residentBytes -= entry.bytes;
+        stats.residentCount--;
+        if (entry.frame == frame)
+        {
+            stats.pinnedBytes -= entry.bytes;
+            stats.pinnedCount--;
+        }
+        lru.erase(it->second);
+        entries.erase(it);
+    }
+
+    void ResidencyManager::Clear()
+    {
+        lru.clear();
+        entries.clear();
+        stats.residentBytes = 0;
+        stats.residentCount = 0;
+        stats.pinnedBytes = 0;
+        stats.pinnedCount = 0;
+    }
+
+    std::vector<std::string> ResidencyManager::Trim()
+    {
+        std::vector<std::string> evicted;
+        while (stats.residentBytes > stats.budgetBytes && !lru.empty() && lru.back().frame != frame)
+        {
+            // Used entries are spliced to the front, so the back is the oldest unpinned one
+            Entry& entry = lru.back();
+            stats.residentBytes -= entry.bytes;
+            stats.residentCount--;
+            stats.evictions++;
+            stats.evictedBytes += entry.bytes;
+            entries.erase(entry.key);
+            evicted.push_back(std::move(entry.key));
+            lru.pop_back();
+        }
+
+        if (!evicted.empty())
+        {
+            LOG_DEBUGF("[ResidencyManager] Evicted %zu entries, %llu of %llu bytes resident", evicted.size(),
+                static_cast<unsigned long long>(stats.residentBytes), static_cast<unsigned long long>(stats.budgetBytes));
+        }
+        return evicted;
+    }
+}
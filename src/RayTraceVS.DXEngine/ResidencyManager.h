@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================
+// Memory-budgeted residency (LRU)
+// ============================================
+//
+// Bookkeeping for caches of per-mesh resources (GPU BLASes and buffers, CPU BVHs) that
+// outlive the scene that created them, so a mesh that comes back is not rebuilt. Each
+// entry is a key (the Scene mesh content key) and its size in bytes. Owners start every
+// build with BeginFrame and Add/Use the keys the build needs; those are pinned until the
+// next BeginFrame. Trim then hands back the least recently used unpinned keys whose
+// release brings the resident total within the budget; the owner frees them.
+//
+// Pinned entries are never evicted, so a scene larger than the budget still renders and
+// only shows up as residentBytes > budgetBytes in the statistics.
+
+namespace RayTraceVS::DXEngine
+{
+    constexpr uint64_t DEFAULT_MESH_RESIDENCY_BUDGET = 1ull << 30;    // 1 GiB
+
+    struct ResidencyStats
+    {
+        uint64_t budgetBytes = 0;
+        uint64_t residentBytes = 0;
+        uint64_t pinnedBytes = 0;           // Used since the last BeginFrame
+        uint64_t peakResidentBytes = 0;
+        uint32_t residentCount = 0;
+        uint32_t pinnedCount = 0;
+        uint64_t hits = 0;                  // Use of a resident entry
+        uint64_t misses = 0;                // Add (the resource had to be built)
+        uint64_t evictions = 0;
+        uint64_t evictedBytes = 0;
+    };
+
+    class ResidencyManager
+    {
+    public:
+        explicit ResidencyManager(uint64_t budgetBytes = DEFAULT_MESH_RESIDENCY_BUDGET);
+
+        // Takes effect at the next Trim
+        void SetBudget(uint64_t budgetBytes);
+        uint64_t GetBudget() const { return stats.budgetBytes; }
+
+        // Unpins every entry
+        void BeginFrame();
+        // Marks a resident entry as used (pinned, most recent); false if it is not resident
+        bool Use(const std::string& key);
+        // Registers a newly built entry (pinned), or updates the size of an existing one
+        void Add(const std::string& key, uint64_t bytes);
+        void Remove(const std::string& key);
+        void Clear();
+        bool Contains(const std::string& key) const { return entries.find(key) != entries.end(); }
+
+        // Evicts unpinned entries, least recently used first, until the total fits the
+        // budget; returns their keys (already forgotten by the manager)
+        std::vector<std::string> Trim();
+
+        const ResidencyStats& GetStats() const { return stats; }
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            uint64_t bytes;
+            uint64_t frame;                 // Last BeginFrame epoch that used it
+        };
+
+        void Pin(Entry& entry);
+
+        std::list<Entry> lru;               // Front = most recently used
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+        uint64_t frame = 1;
+        ResidencyStats stats;
+    };
+}
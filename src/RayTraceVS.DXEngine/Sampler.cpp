@@ -0,0 +1,245 @@
+#include "Sampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        // Sobol direction numbers (Joe and Kuo) of the first four dimensions, one per
+        // index bit, as 32-bit fixed point. SobolDirections in Common.hlsli holds the same.
+        constexpr uint32_t SOBOL_DIRECTIONS[Sampler::SOBOL_DIMENSIONS][Sampler::SOBOL_INDEX_BITS] =
+        {
+            { 0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+              0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+              0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u },
+            { 0x80000000u, 0xC0000000u, 0xA0000000u, 0xF0000000u, 0x88000000u, 0xCC000000u, 0xAA000000u, 0xFF000000u,
+              0x80800000u, 0xC0C00000u, 0xA0A00000u, 0xF0F00000u, 0x88880000u, 0xCCCC0000u, 0xAAAA0000u, 0xFFFF0000u,
+              0x80008000u, 0xC000C000u, 0xA000A000u, 0xF000F000u, 0x88008800u, 0xCC00CC00u, 0xAA00AA00u, 0xFF00FF00u },
+            { 0x80000000u, 0xC0000000u, 0x60000000u, 0x90000000u, 0xE8000000u, 0x5C000000u, 0x8E000000u, 0xC5000000u,
+              0x68800000u, 0x9CC00000u, 0xEE600000u, 0x55900000u, 0x80680000u, 0xC09C0000u, 0x60EE0000u, 0x90550000u,
+              0xE8808000u, 0x5CC0C000u, 0x8E606000u, 0xC5909000u, 0x6868E800u, 0x9C9C5C00u, 0xEEEE8E00u, 0x5555C500u },
+            { 0x80000000u, 0xC0000000u, 0x20000000u, 0x50000000u, 0xF8000000u, 0x74000000u, 0xA2000000u, 0x93000000u,
+              0xD8800000u, 0x25400000u, 0x59E00000u, 0xE6D00000u, 0x78080000u, 0xB40C0000u, 0x82020000u, 0xC3050000u,
+              0x208F8000u, 0x51474000u, 0xFBEA2000u, 0x75D93000u, 0xA0858800u, 0x914E5400u, 0xDBE79E00u, 0x25DB6D00u }
+        };
+
+        uint32_t DimensionSeed(uint32_t seed, uint32_t dimension)
+        {
+            return Sampler::Hash(seed ^ (0x9E3779B9u * (dimension + 1)));
+        }
+
+        uint32_t ReverseBits(uint32_t x)
+        {
+            x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+            x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+            x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+            x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        // ============================================
+        // Blue-noise ranking (void and cluster)
+        // ============================================
+        // Ulichney, "The void-and-cluster method for dither array generation", 1993.
+        // Every prefix of the ranking is an evenly spread point set on the torus.
+
+        constexpr uint32_t TILE = Sampler::RANK_TILE_SIZE;
+        constexpr uint32_t TILE_TEXELS = TILE * TILE;
+        constexpr float RANK_SIGMA = 1.5f;
+
+        std::array<uint8_t, TILE_TEXELS> GenerateRanking(uint32_t seed)
+        {
+            float kernel[TILE][TILE];
+            for (uint32_t y = 0; y < TILE; y++)
+            {
+                for (uint32_t x = 0; x < TILE; x++)
+                {
+                    const float dx = static_cast<float>((std::min)(x, TILE - x));
+                    const float dy = static_cast<float>((std::min)(y, TILE - y));
+                    kernel[y][x] = std::exp(-(dx * dx + dy * dy) / (2.0f * RANK_SIGMA * RANK_SIGMA));
+                }
+            }
+
+            std::array<bool, TILE_TEXELS> pattern = {};
+            std::array<float, TILE_TEXELS> energy = {};
+            auto splat = [&](uint32_t texel, float sign)
+            {
+                const uint32_t px = texel % TILE, py = texel / TILE;
+                for (uint32_t q = 0; q < TILE_TEXELS; q++)
+                    energy[q] += sign * kernel[(q / TILE - py) & (TILE - 1)][(q % TILE - px) & (TILE - 1)];
+            };
+            auto tightestCluster = [&]()
+            {
+                uint32_t best = 0;
+                float bestEnergy = -1.0f;
+                for (uint32_t q = 0; q < TILE_TEXELS; q++)
+                {
+                    if (pattern[q] && energy[q] > bestEnergy)
+                    {
+                        best = q;
+                        bestEnergy = energy[q];
+                    }
+                }
+                return best;
+            };
+            auto largestVoid = [&]()
+            {
+                uint32_t best = 0;
+                float bestEnergy = 1e30f;
+                for (uint32_t q = 0; q < TILE_TEXELS; q++)
+                {
+                    if (!pattern[q] && energy[q] < bestEnergy)
+                    {
+                        best = q;
+                        bestEnergy = energy[q];
+                    }
+                }
+                return best;
+            };
+
+            // Initial pattern: a tenth of the texels at random, relaxed until moving the
+            // tightest cluster into the largest void changes nothing
+            const uint32_t initialCount = TILE_TEXELS / 10;
+            uint32_t state = seed;
+            for (uint32_t placed = 0; placed < initialCount;)
+            {
+                state = Sampler::Hash(state);
+                const uint32_t texel = state % TILE_TEXELS;
+                if (pattern[texel])
+                    continue;
+                pattern[texel] = true;
+                splat(texel, 1.0f);
+                placed++;
+            }
+            for (uint32_t iteration = 0; iteration < TILE_TEXELS * 4; iteration++)
+            {
+                const uint32_t cluster = tightestCluster();
+                pattern[cluster] = false;
+                splat(cluster, -1.0f);
+                const uint32_t voidTexel = largestVoid();
+                pattern[voidTexel] = true;
+                splat(voidTexel, 1.0f);
+                if (voidTexel == cluster)
+                    break;
+            }
+
+            std::array<uint8_t, TILE_TEXELS> rank = {};
+            const std::array<bool, TILE_TEXELS> initialPattern = pattern;
+            const std::array<float, TILE_TEXELS> initialEnergy = energy;
+
+            // Ranks below the initial count: take points out, tightest cluster first
+            for (uint32_t r = initialCount; r-- > 0;)
+            {
+                const uint32_t cluster = tightestCluster();
+                pattern[cluster] = false;
+                splat(cluster, -1.0f);
+                rank[cluster] = static_cast<uint8_t>(r);
+            }
+
+            // The rest: fill the largest void first
+            pattern = initialPattern;
+            energy = initialEnergy;
+            for (uint32_t r = initialCount; r < TILE_TEXELS; r++)
+            {
+                const uint32_t voidTexel = largestVoid();
+                pattern[voidTexel] = true;
+                splat(voidTexel, 1.0f);
+                rank[voidTexel] = static_cast<uint8_t>(r);
+            }
+            return rank;
+        }
+    }
+
+    // ============================================
+    // Stream
+    // ============================================
+
+    Sampler::Sampler(uint32_t pixelX, uint32_t pixelY, uint32_t sequenceIndex, uint32_t depth, uint32_t salt)
+    {
+        const uint32_t dimensionSet = depth * SamplerSalt_Count + salt;
+        const uint32_t tileSeed = Hash((pixelX / RANK_TILE_SIZE) ^ Hash(pixelY / RANK_TILE_SIZE + 0x68E31DA4u));
+        seed = Hash(tileSeed ^ Hash(dimensionSet + 0x27D4EB2Fu));
+        // The shuffle keeps the low SOBOL_INDEX_BITS of distinct indices distinct
+        index = NestedUniformScramble(sequenceIndex, seed) & ((1u << SOBOL_INDEX_BITS) - 1u);
+        state = Hash(pixelX * 1973u + pixelY * 9277u + sequenceIndex * 26699u + dimensionSet * 911u);
+
+        // Each dimension set reads the rank tile at its own toroidal offset
+        const uint32_t offset = Hash(dimensionSet * 0x85EBCA6Bu);
+        const uint32_t x = (pixelX + (offset & (RANK_TILE_SIZE - 1))) & (RANK_TILE_SIZE - 1);
+        const uint32_t y = (pixelY + ((offset >> 4) & (RANK_TILE_SIZE - 1))) & (RANK_TILE_SIZE - 1);
+        const auto& ranks = GetRankTile();
+        for (uint32_t d = 0; d < SOBOL_DIMENSIONS; d++)
+            shift[d] = static_cast<uint32_t>(ranks[(y * RANK_TILE_SIZE + x) * 4 + d]) << 24;
+    }
+
+    float Sampler::Next()
+    {
+        uint32_t bits;
+        if (dimension < SOBOL_DIMENSIONS)
+        {
+            // Toroidal shift in fixed point, so the result never rounds up to 1
+            bits = NestedUniformScramble(Sobol(index, dimension), DimensionSeed(seed, dimension)) + shift[dimension];
+            dimension++;
+        }
+        else
+        {
+            state = Hash(state);
+            bits = state;
+        }
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // ============================================
+    // Building blocks
+    // ============================================
+
+    uint32_t Sampler::Hash(uint32_t x)
+    {
+        // PCG output permutation (PcgHash in Common.hlsli)
+        uint32_t state = x * 747796405u + 2891336453u;
+        uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    uint32_t Sampler::Sobol(uint32_t index, uint32_t dimension)
+    {
+        uint32_t result = 0;
+        for (uint32_t bit = 0; index != 0 && bit < SOBOL_INDEX_BITS; bit++, index >>= 1)
+        {
+            if (index & 1u)
+                result ^= SOBOL_DIRECTIONS[dimension][bit];
+        }
+        return result;
+    }
+
+    uint32_t Sampler::NestedUniformScramble(uint32_t x, uint32_t seed)
+    {
+        // The Laine-Karras permutation only lets lower bits affect higher ones; applied
+        // to the reversed value every bit is flipped depending on the more significant
+        // bits only, which is Owen scrambling.
+        x = ReverseBits(x);
+        x += seed;
+        x ^= x * 0x6C50B47Cu;
+        x ^= x * 0xB82F1E52u;
+        x ^= x * 0xC7AFE638u;
+        x ^= x * 0x8D22F6E6u;
+        return ReverseBits(x);
+    }
+
+    const std::array<uint8_t, Sampler::RANK_TILE_SIZE * Sampler::RANK_TILE_SIZE * 4>& Sampler::GetRankTile()
+    {
+        static const std::array<uint8_t, TILE_TEXELS * 4> tile = []()
+        {
+            std::array<uint8_t, TILE_TEXELS * 4> texels = {};
+            for (uint32_t channel = 0; channel < 4; channel++)
+            {
+                const std::array<uint8_t, TILE_TEXELS> rank = GenerateRanking(0x9E3779B9u * (channel + 1));
+                for (uint32_t texel = 0; texel < TILE_TEXELS; texel++)
+                    texels[texel * 4 + channel] = rank[texel];
+            }
+            return texels;
+        }();
+        return tile;
+    }
+}
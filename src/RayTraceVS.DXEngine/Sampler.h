@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// ============================================
+// Low-discrepancy sampler
+// ============================================
+//
+// Every random decision of a path vertex draws from a stream identified by
+// (pixel, sequence index, bounce depth, salt). The first SOBOL_DIMENSIONS numbers of a
+// stream are a point of an Owen-scrambled Sobol sequence (Burley, "Practical Hash-based
+// Owen Scrambling", 2020); further numbers fall back to a PCG hash chain.
+//
+//   - sequence index = frame * samplesPerPixel + sample, so the samples of one pixel
+//     progress along the sequence over samples and frames and stay stratified.
+//   - Each (depth, salt) is its own dimension set with its own index shuffle and
+//     scramble seeds, which decorrelates them (padding).
+//   - Seeds are shared by the pixels of a 16x16 tile. Pixels are told apart by a
+//     toroidal shift taken from a blue-noise rank tile (void-and-cluster), so within a
+//     tile neighbouring pixels sit in different strata and the error is spread as blue
+//     noise in screen space rather than white noise.
+//
+// The same functions and tables are in the RNG section of Common.hlsli; the CPU path
+// tracer and the DXR shaders draw identical numbers for the same stream.
+
+namespace RayTraceVS::DXEngine
+{
+    // Dimension sets within a bounce; the values are RNG_SALT_* in Common.hlsli
+    enum SamplerSalt : uint32_t
+    {
+        SamplerSalt_AntiAliasing = 1,
+        SamplerSalt_DepthOfField = 2,
+        SamplerSalt_LightPick = 3,
+        SamplerSalt_Brdf = 4,
+        SamplerSalt_RussianRoulette = 5,
+        SamplerSalt_Shadow = 6,
+        SamplerSalt_Reflect = 7,
+        SamplerSalt_Refract = 8,
+        SamplerSalt_Environment = 9,
+        SamplerSalt_Count = 10          // Stride between bounces (RNG_SALT_COUNT)
+    };
+
+    class Sampler
+    {
+    public:
+        static constexpr uint32_t SOBOL_DIMENSIONS = 4;
+        static constexpr uint32_t SOBOL_INDEX_BITS = 24;    // Enough for 24-bit float output
+        static constexpr uint32_t RANK_TILE_SIZE = 16;
+
+        Sampler(uint32_t pixelX, uint32_t pixelY, uint32_t sequenceIndex, uint32_t depth, uint32_t salt);
+
+        // Next number of the stream in [0, 1)
+        float Next();
+
+        static uint32_t Hash(uint32_t x);
+        // Sobol point (32-bit fixed point) of an index for dimension 0..SOBOL_DIMENSIONS-1
+        static uint32_t Sobol(uint32_t index, uint32_t dimension);
+        // Owen scrambling of a 32-bit fixed point value (bit-reversed Laine-Karras permutation)
+        static uint32_t NestedUniformScramble(uint32_t x, uint32_t seed);
+
+        // RANK_TILE_SIZE^2 texels of RGBA8; every channel is an independent blue-noise
+        // ranking (0..255) of the tile. Uploaded as BlueNoiseTex (t10).
+        static const std::array<uint8_t, RANK_TILE_SIZE * RANK_TILE_SIZE * 4>& GetRankTile();
+
+    private:
+        uint32_t index;                 // Shuffled sequence index
+        uint32_t seed;                  // Scramble seed of the dimension set
+        uint32_t dimension = 0;         // Next Sobol dimension, then the hash chain
+        uint32_t state;                 // Hash chain beyond SOBOL_DIMENSIONS
+        uint32_t shift[SOBOL_DIMENSIONS];
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace RayTraceVS::DXEngine
+{
+    enum class ObjectType
+    {
+        Sphere,
+        Plane,
+        Box
+    };
+
+    // ============================================
+    // Primitive data (Structure of Arrays)
+    // ============================================
+    // Each primitive type lives in its own pool. Geometry (read by AABB/BVH builds,
+    // change detection and GPU uploads) is kept apart from the material (read only
+    // when shading data is uploaded), so geometry passes stream through contiguous
+    // memory without touching material bytes.
+
+    struct SphereGeometry
+    {
+        XMFLOAT3 center;
+        float radius;
+    };
+
+    struct PlaneGeometry
+    {
+        XMFLOAT3 position;
+        XMFLOAT3 normal;
+    };
+
+    // OBB: center, half-extents and local axes (rotation matrix columns) in world space
+    struct BoxGeometry
+    {
+        XMFLOAT3 center;
+        XMFLOAT3 size;  // half-extents
+        XMFLOAT3 axisX = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        XMFLOAT3 axisY = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        XMFLOAT3 axisZ = XMFLOAT3(0.0f, 0.0f, 1.0f);
+    };
+
+    struct ObjectMaterial
+    {
+        XMFLOAT4 color;
+        float metallic;     // 0.0 = dielectric, 1.0 = metal
+        float roughness;    // 0.0 = smooth, 1.0 = rough
+        float transmission; // 0.0 = opaque, 1.0 = fully transparent (glass)
+        float ior;          // Index of Refraction (default 1.5 for glass)
+        float specular;     // Specular intensity (0.0 = none, 1.0 = full)
+        XMFLOAT3 emission;  // Emissive color (self-illumination)
+        XMFLOAT3 absorption; // Beer-Lambert sigmaA
+    };
+
+    // Contiguous storage for one primitive type. Index i of every array refers to the
+    // same primitive, and matches the shader's per-type buffer index.
+    template<typename Geometry>
+    struct PrimitivePool
+    {
+        std::vector<Geometry> geometry;         // Hot: bounds, traversal, GPU geometry
+        std::vector<ObjectMaterial> materials;  // Cold: shading only
+        std::vector<uint64_t> generations;      // Scene generation of the last change
+
+        size_t Size() const { return geometry.size(); }
+        bool Empty() const { return geometry.empty(); }
+
+        void Add(const Geometry& geom, const ObjectMaterial& material, uint64_t generation)
+        {
+            geometry.push_back(geom);
+            materials.push_back(material);
+            generations.push_back(generation);
+        }
+
+        void Clear()
+        {
+            geometry.clear();
+            materials.clear();
+            generations.clear();
+        }
+    };
+
+    using SpherePool = PrimitivePool<SphereGeometry>;
+    using PlanePool = PrimitivePool<PlaneGeometry>;
+    using BoxPool = PrimitivePool<BoxGeometry>;
+}
@@ -1,7 +1,114 @@
 #include "Scene.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 
 namespace RayTraceVS::DXEngine
 {
+    namespace
+    {
+        // Shared by all scenes so a generation never repeats, even when a Scene is
+        // destroyed and a new one is allocated at the same address
+        std::atomic<uint64_t> s_nextGeneration{ 0 };
+
+        // Bitwise comparison: exact, and NaN-safe for change detection
+        template<typename T>
+        bool SameBits(const T& a, const T& b)
+        {
+            return memcmp(&a, &b, sizeof(T)) == 0;
+        }
+
+        // Primitive geometry and materials are tightly packed floats, so whole-struct compares are exact
+        static_assert(sizeof(SphereGeometry) == 4 * sizeof(float), "SphereGeometry must not contain padding");
+        static_assert(sizeof(PlaneGeometry) == 6 * sizeof(float), "PlaneGeometry must not contain padding");
+        static_assert(sizeof(BoxGeometry) == 15 * sizeof(float), "BoxGeometry must not contain padding");
+        static_assert(sizeof(ObjectMaterial) == 15 * sizeof(float), "ObjectMaterial must not contain padding");
+        static_assert(sizeof(MeshMaterial) == 15 * sizeof(float), "MeshMaterial must not contain padding");
+
+        bool SameLight(const Light& a, const Light& b)
+        {
+            return SameBits(a.GetPosition(), b.GetPosition()) &&
+                SameBits(a.GetColor(), b.GetColor()) &&
+                SameBits(a.GetIntensity(), b.GetIntensity()) &&
+                a.GetType() == b.GetType() &&
+                SameBits(a.GetRadius(), b.GetRadius()) &&
+                SameBits(a.GetSoftShadowSamples(), b.GetSoftShadowSamples());
+        }
+
+        bool SameCamera(const Camera& a, const Camera& b)
+        {
+            return SameBits(a.GetPosition(), b.GetPosition()) &&
+                SameBits(a.GetLookAt(), b.GetLookAt()) &&
+                SameBits(a.GetUp(), b.GetUp()) &&
+                SameBits(a.GetFieldOfView(), b.GetFieldOfView()) &&
+                SameBits(a.GetApertureSize(), b.GetApertureSize()) &&
+                SameBits(a.GetFocusDistance(), b.GetFocusDistance());
+        }
+
+        bool SameMeshTransform(const MeshTransform& a, const MeshTransform& b)
+        {
+            return SameBits(a.position, b.position) && SameBits(a.rotation, b.rotation) && SameBits(a.scale, b.scale);
+        }
+
+        bool SameMeshMaterial(const MeshMaterial& a, const MeshMaterial& b)
+        {
+            return SameBits(a.color, b.color) &&
+                SameBits(a.metallic, b.metallic) &&
+                SameBits(a.roughness, b.roughness) &&
+                SameBits(a.transmission, b.transmission) &&
+                SameBits(a.ior, b.ior) &&
+                SameBits(a.specular, b.specular) &&
+                SameBits(a.emission, b.emission) &&
+                SameBits(a.absorption, b.absorption);
+        }
+
+        bool SameMeshCache(const MeshCacheEntry& a, const MeshCacheEntry& b)
+        {
+            return SameBits(a.boundsMin, b.boundsMin) &&
+                SameBits(a.boundsMax, b.boundsMax) &&
+                a.spatialSplits == b.spatialSplits &&
+                a.pagedFile == b.pagedFile &&
+                a.vertices.size() == b.vertices.size() &&
+                a.indices.size() == b.indices.size() &&
+                (a.vertices.empty() || memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(float)) == 0) &&
+                (a.indices.empty() || memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0);
+        }
+
+        // 64-bit FNV-1a over the vertex and index words (and the path of paged geometry), as
+        // 16 hex digits. Not collision resistant: geometry is only shared after SameMeshCache
+        // confirms the match.
+        std::string MeshContentKey(const MeshCacheEntry& cache)
+        {
+            uint64_t hash = 0xCBF29CE484222325ull;
+            auto mix = [&hash](uint32_t word)
+            {
+                hash = (hash ^ word) * 0x100000001B3ull;
+            };
+
+            mix(static_cast<uint32_t>(cache.vertices.size()));
+            mix(static_cast<uint32_t>(cache.indices.size()));
+            mix(cache.spatialSplits ? 1u : 0u);
+            for (float value : cache.vertices)
+            {
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                mix(bits);
+            }
+            for (uint32_t index : cache.indices)
+            {
+                mix(index);
+            }
+            for (wchar_t c : cache.pagedFile)
+            {
+                mix(static_cast<uint32_t>(c));
+            }
+
+            char key[17];
+            snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+            return key;
+        }
+    }
+
     Scene::Scene()
     {
     }
@@ -10,32 +117,269 @@ namespace RayTraceVS::DXEngine
     {
     }
 
-    void Scene::AddObject(std::shared_ptr<RayTracingObject> obj)
+    void Scene::SetCamera(const Camera& cam)
     {
-        objects.push_back(obj);
+        if (SameCamera(camera, cam))
+            return;
+        camera = cam;
+        MarkChanged(SceneChange_Camera);
+    }
+
+    template<typename Geometry>
+    void Scene::AddPrimitive(PrimitivePool<Geometry>& pool, const PrimitivePool<Geometry>& previous,
+        const Geometry& geometry, const ObjectMaterial& material)
+    {
+        size_t index = pool.Size();
+
+        uint32_t changes = SceneChange_Geometry | SceneChange_Materials;
+        if (rebuildPending && index < previous.Size())
+        {
+            changes = 0;
+            if (!SameBits(previous.geometry[index], geometry))
+                changes |= SceneChange_Geometry;
+            if (!SameBits(previous.materials[index], material))
+                changes |= SceneChange_Materials;
+        }
+        pool.Add(geometry, material, changes ? MarkChanged(changes) : previous.generations[index]);
+    }
+
+    void Scene::AddSphere(const SphereGeometry& geometry, const ObjectMaterial& material)
+    {
+        AddPrimitive(spheres, previousSpheres, geometry, material);
+    }
+
+    void Scene::AddPlane(const PlaneGeometry& geometry, const ObjectMaterial& material)
+    {
+        AddPrimitive(planes, previousPlanes, geometry, material);
+    }
+
+    void Scene::AddBox(const BoxGeometry& geometry, const ObjectMaterial& material)
+    {
+        AddPrimitive(boxes, previousBoxes, geometry, material);
     }
 
     void Scene::AddLight(const Light& light)
     {
+        size_t index = lights.size();
         lights.push_back(light);
+
+        bool unchanged = rebuildPending && index < previousLights.size() && SameLight(previousLights[index], light);
+        lightGenerations.push_back(unchanged ? previousLightGenerations[index] : MarkChanged(SceneChange_Lights));
     }
 
     void Scene::AddMeshCache(const MeshCacheEntry& cache)
     {
-        // Store by name for lookup by instances
-        meshCaches[cache.name] = cache;
+        // A name re-added with the same content keeps its key without rehashing.
+        // Removed names are caught by the size checks in FinalizeRebuild.
+        const auto& referenceAliases = rebuildPending ? previousMeshAliases : meshAliases;
+        const auto& referenceCaches = rebuildPending ? previousMeshCaches : meshCaches;
+        std::string key;
+        auto alias = referenceAliases.find(cache.name);
+        if (alias != referenceAliases.end())
+        {
+            auto it = referenceCaches.find(alias->second);
+            if (it != referenceCaches.end() && SameMeshCache(it->second, cache))
+                key = alias->second;
+        }
+        bool unchanged = false;
+        if (!key.empty())
+        {
+            // The key may have gone to other content if colliding meshes were re-added in another order
+            auto [it, inserted] = meshCaches.try_emplace(key, cache);
+            unchanged = inserted || SameMeshCache(it->second, cache);
+        }
+
+        if (!unchanged)
+        {
+            // Share an entry with identical content; a hash collision gets a suffixed key
+            const std::string contentKey = MeshContentKey(cache);
+            for (int suffix = 0; ; suffix++)
+            {
+                key = suffix ? contentKey + "#" + std::to_string(suffix) : contentKey;
+                auto [it, inserted] = meshCaches.try_emplace(key, cache);
+                if (inserted || SameMeshCache(it->second, cache))
+                    break;
+            }
+        }
+
+        auto [it, inserted] = meshAliases.try_emplace(cache.name, key);
+        if (!inserted && it->second != key)
+        {
+            // Name re-added with new content outside a rebuild: drop the old geometry if orphaned
+            std::string oldKey = std::move(it->second);
+            it->second = key;
+            bool referenced = false;
+            for (const auto& [name, aliasKey] : meshAliases)
+            {
+                if (aliasKey == oldKey)
+                {
+                    referenced = true;
+                    break;
+                }
+            }
+            if (!referenced)
+                meshCaches.erase(oldKey);
+        }
+
+        if (!unchanged)
+        {
+            MarkChanged(SceneChange_MeshCaches);
+        }
+    }
+
+    const std::string* Scene::FindMeshKey(const std::string& meshName) const
+    {
+        auto it = meshAliases.find(meshName);
+        return (it != meshAliases.end()) ? &it->second : nullptr;
+    }
+
+    const MeshCacheEntry* Scene::FindMeshCache(const std::string& meshName) const
+    {
+        const std::string* key = FindMeshKey(meshName);
+        if (!key)
+            return nullptr;
+        auto it = meshCaches.find(*key);
+        return (it != meshCaches.end()) ? &it->second : nullptr;
+    }
+
+    size_t MeshMaterialHash::operator()(const MeshMaterial& material) const
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&material);
+        uint64_t hash = 14695981039346656037ull;    // FNV-1a
+        for (size_t i = 0; i < sizeof(MeshMaterial); i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    bool MeshMaterialEqual::operator()(const MeshMaterial& a, const MeshMaterial& b) const
+    {
+        return SameMeshMaterial(a, b);
     }
 
     void Scene::AddMeshInstance(const MeshInstance& instance)
     {
+        size_t index = meshInstances.size();
         meshInstances.push_back(instance);
+
+        auto [materialIt, newMaterial] = meshMaterialIndexMap.try_emplace(
+            instance.material, static_cast<uint32_t>(meshMaterials.size()));
+        if (newMaterial)
+            meshMaterials.push_back(instance.material);
+        meshMaterialIndices.push_back(materialIt->second);
+
+        uint32_t changes = SceneChange_MeshInstances | SceneChange_MeshMaterials;
+        if (rebuildPending && index < previousMeshInstances.size())
+        {
+            const MeshInstance& previous = previousMeshInstances[index];
+            changes = 0;
+            if (previous.meshName != instance.meshName || !SameMeshTransform(previous.transform, instance.transform))
+                changes |= SceneChange_MeshInstances;
+            if (!SameMeshMaterial(previous.material, instance.material))
+                changes |= SceneChange_MeshMaterials;
+        }
+        meshInstanceGenerations.push_back(changes ? MarkChanged(changes) : previousMeshInstanceGenerations[index]);
     }
 
     void Scene::Clear()
     {
-        objects.clear();
+        FinalizeRebuild();
+
+        // Keep the old content until the scene has been re-added so unchanged entries keep their generation
+        std::swap(previousSpheres, spheres);
+        std::swap(previousPlanes, planes);
+        std::swap(previousBoxes, boxes);
+        previousLights = std::move(lights);
+        previousLightGenerations = std::move(lightGenerations);
+        previousMeshInstances = std::move(meshInstances);
+        previousMeshInstanceGenerations = std::move(meshInstanceGenerations);
+        previousMeshCaches = std::move(meshCaches);
+        previousMeshAliases = std::move(meshAliases);
+        rebuildPending = true;
+
+        spheres.Clear();
+        planes.Clear();
+        boxes.Clear();
         lights.clear();
+        lightGenerations.clear();
         meshCaches.clear();
+        meshAliases.clear();
         meshInstances.clear();
+        meshInstanceGenerations.clear();
+        meshMaterials.clear();
+        meshMaterialIndices.clear();
+        meshMaterialIndexMap.clear();
+    }
+
+    // ============================================
+    // Change tracking
+    // ============================================
+
+    uint64_t Scene::MarkChanged(uint32_t changes) const
+    {
+        generation = s_nextGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+        for (size_t i = 0; i < SCENE_CHANGE_CATEGORY_COUNT; i++)
+        {
+            if (changes & (1u << i))
+            {
+                categoryGenerations[i] = generation;
+            }
+        }
+        return generation;
+    }
+
+    void Scene::FinalizeRebuild() const
+    {
+        if (!rebuildPending)
+            return;
+
+        uint32_t changes = 0;
+        if (spheres.Size() < previousSpheres.Size() ||
+            planes.Size() < previousPlanes.Size() ||
+            boxes.Size() < previousBoxes.Size())
+            changes |= SceneChange_Geometry | SceneChange_Materials;
+        if (lights.size() < previousLights.size())
+            changes |= SceneChange_Lights;
+        if (meshInstances.size() < previousMeshInstances.size())
+            changes |= SceneChange_MeshInstances | SceneChange_MeshMaterials;
+        if (meshCaches.size() != previousMeshCaches.size() || meshAliases.size() != previousMeshAliases.size())
+            changes |= SceneChange_MeshCaches;
+        if (changes)
+        {
+            MarkChanged(changes);
+        }
+
+        previousSpheres.Clear();
+        previousPlanes.Clear();
+        previousBoxes.Clear();
+        previousLights.clear();
+        previousLightGenerations.clear();
+        previousMeshInstances.clear();
+        previousMeshInstanceGenerations.clear();
+        previousMeshCaches.clear();
+        previousMeshAliases.clear();
+        rebuildPending = false;
+    }
+
+    uint64_t Scene::GetGeneration() const
+    {
+        FinalizeRebuild();
+        return generation;
+    }
+
+    uint32_t Scene::GetChangesSince(uint64_t sinceGeneration) const
+    {
+        FinalizeRebuild();
+
+        uint32_t changes = SceneChange_None;
+        for (size_t i = 0; i < SCENE_CHANGE_CATEGORY_COUNT; i++)
+        {
+            if (categoryGenerations[i] > sinceGeneration)
+            {
+                changes |= (1u << i);
+            }
+        }
+        return changes;
     }
 }
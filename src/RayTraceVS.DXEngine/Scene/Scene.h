@@ -7,7 +7,7 @@
 #include <DirectXMath.h>
 #include "Camera.h"
 #include "Light.h"
-#include "Objects/RayTracingObject.h"
+#include "Objects/Primitives.h"
 
 namespace RayTraceVS::DXEngine
 {
@@ -18,11 +18,14 @@ namespace RayTraceVS::DXEngine
     // Raw mesh data from cache (interleaved vertex format)
     struct MeshCacheEntry
     {
-        std::string name;
+        std::string name;               // Scene: first name the geometry was added under
         std::vector<float> vertices;    // 8 floats per vertex (pos3 + pad + normal3 + pad)
         std::vector<uint32_t> indices;
         DirectX::XMFLOAT3 boundsMin;
         DirectX::XMFLOAT3 boundsMax;
+        bool spatialSplits = false;     // Build the CPU BVH as an SBVH (meshes with long thin triangles)
+        std::wstring pagedFile;         // Out-of-core geometry (PagedMesh.h): vertices/indices stay empty,
+                                        // only the CPU path tracer renders it
     };
 
     // Material for a mesh instance
@@ -38,6 +41,17 @@ namespace RayTraceVS::DXEngine
         DirectX::XMFLOAT3 absorption = { 0.0f, 0.0f, 0.0f };
     };
 
+    // Value hash/equality of mesh materials (bitwise, like the scene's change detection)
+    struct MeshMaterialHash
+    {
+        size_t operator()(const MeshMaterial& material) const;
+    };
+
+    struct MeshMaterialEqual
+    {
+        bool operator()(const MeshMaterial& a, const MeshMaterial& b) const;
+    };
+
     // Transform for a mesh instance
     struct MeshTransform
     {
@@ -49,18 +63,33 @@ namespace RayTraceVS::DXEngine
     // A mesh instance in the scene
     struct MeshInstance
     {
-        std::string meshName;       // Reference to MeshCacheEntry by name
+        std::string meshName;       // Reference to MeshCacheEntry by name (see Scene::FindMeshKey)
         MeshTransform transform;
         MeshMaterial material;
     };
 
+    // Change categories reported by Scene::GetChangesSince
+    enum SceneChangeFlags : uint32_t
+    {
+        SceneChange_None          = 0,
+        SceneChange_Geometry      = 1u << 0,    // Primitive count, type, shape or placement
+        SceneChange_Materials     = 1u << 1,    // Primitive materials
+        SceneChange_Lights        = 1u << 2,
+        SceneChange_MeshCaches    = 1u << 3,
+        SceneChange_MeshInstances = 1u << 4,    // Instance count, mesh reference or transform
+        SceneChange_MeshMaterials = 1u << 5,
+        SceneChange_Camera        = 1u << 6,
+        SceneChange_Settings      = 1u << 7,
+        SceneChange_All           = 0xFFu
+    };
+
     class Scene
     {
     public:
         Scene();
         ~Scene();
 
-        void SetCamera(const Camera& cam) { camera = cam; }
+        void SetCamera(const Camera& cam);
         Camera& GetCamera() { return camera; }
         const Camera& GetCamera() const { return camera; }
 
@@ -68,25 +97,30 @@ namespace RayTraceVS::DXEngine
                                float lightAttenConst = 1.0f, float lightAttenLinear = 0.0f, float lightAttenQuad = 0.01f, int maxShadowLights = 2,
                                float nrdBypassDist = 8.0f, float nrdBypassRange = 2.0f)
         {
-            samplesPerPixel = samples;
-            maxBounces = bounces;
-            traceRecursionDepth = traceRecursion;
-            exposure = exp;
-            toneMapOperator = tone;
-            denoiserStabilization = stab;
-            shadowStrength = shadow;
-            shadowAbsorptionScale = shadowAbsorb;
-            enableDenoiser = denoiser;
-            gamma = gam;
-            photonDebugMode = photonDebug;
-            photonDebugScale = photonDebugScaleVal;
+            bool changed = false;
+            changed |= AssignSetting(samplesPerPixel, samples);
+            changed |= AssignSetting(maxBounces, bounces);
+            changed |= AssignSetting(traceRecursionDepth, traceRecursion);
+            changed |= AssignSetting(exposure, exp);
+            changed |= AssignSetting(toneMapOperator, tone);
+            changed |= AssignSetting(denoiserStabilization, stab);
+            changed |= AssignSetting(shadowStrength, shadow);
+            changed |= AssignSetting(shadowAbsorptionScale, shadowAbsorb);
+            changed |= AssignSetting(enableDenoiser, denoiser);
+            changed |= AssignSetting(gamma, gam);
+            changed |= AssignSetting(photonDebugMode, photonDebug);
+            changed |= AssignSetting(photonDebugScale, photonDebugScaleVal);
             // P1 optimization settings
-            lightAttenuationConstant = lightAttenConst;
-            lightAttenuationLinear = lightAttenLinear;
-            lightAttenuationQuadratic = lightAttenQuad;
-            this->maxShadowLights = maxShadowLights;
-            nrdBypassDistanceThreshold = nrdBypassDist;
-            nrdBypassBlendRange = nrdBypassRange;
+            changed |= AssignSetting(lightAttenuationConstant, lightAttenConst);
+            changed |= AssignSetting(lightAttenuationLinear, lightAttenLinear);
+            changed |= AssignSetting(lightAttenuationQuadratic, lightAttenQuad);
+            changed |= AssignSetting(this->maxShadowLights, maxShadowLights);
+            changed |= AssignSetting(nrdBypassDistanceThreshold, nrdBypassDist);
+            changed |= AssignSetting(nrdBypassBlendRange, nrdBypassRange);
+            if (changed)
+            {
+                MarkChanged(SceneChange_Settings);
+            }
         }
         int GetSamplesPerPixel() const { return samplesPerPixel; }
         int GetMaxBounces() const { return maxBounces; }
@@ -109,30 +143,121 @@ namespace RayTraceVS::DXEngine
         float GetNRDBypassDistanceThreshold() const { return nrdBypassDistanceThreshold; }
         float GetNRDBypassBlendRange() const { return nrdBypassBlendRange; }
 
-        void AddObject(std::shared_ptr<RayTracingObject> obj);
+        // Environment map (see EnvironmentMap.h). An empty path selects the built-in sky;
+        // lighting additionally samples the environment as a light on diffuse surfaces.
+        void SetEnvironment(const std::wstring& path, float intensity = 1.0f, bool lighting = false)
+        {
+            bool changed = false;
+            changed |= AssignSetting(environmentPath, path);
+            changed |= AssignSetting(environmentIntensity, intensity);
+            changed |= AssignSetting(environmentLighting, lighting);
+            if (changed)
+            {
+                MarkChanged(SceneChange_Settings);
+            }
+        }
+        const std::wstring& GetEnvironmentPath() const { return environmentPath; }
+        float GetEnvironmentIntensity() const { return environmentIntensity; }
+        bool GetEnvironmentLighting() const { return environmentLighting; }
+
+        // Bounces after which Russian roulette may end a path on the GPU (the CPU path tracer
+        // takes it from CpuPathTracerSettings); maxBounces stays the hard limit
+        void SetRussianRouletteMinDepth(int depth)
+        {
+            if (AssignSetting(russianRouletteMinDepth, depth))
+            {
+                MarkChanged(SceneChange_Settings);
+            }
+        }
+        int GetRussianRouletteMinDepth() const { return russianRouletteMinDepth; }
+
+        // Primitives are stored per type in SoA pools (see Objects/Primitives.h)
+        void AddSphere(const SphereGeometry& geometry, const ObjectMaterial& material);
+        void AddPlane(const PlaneGeometry& geometry, const ObjectMaterial& material);
+        void AddBox(const BoxGeometry& geometry, const ObjectMaterial& material);
         void AddLight(const Light& light);
 
         // Mesh support
+        // Geometry is stored once per content: identical vertex/index data added under
+        // several names becomes one entry, and each name is an alias of its content key.
+        // BLASes, CPU BVHs and GPU buffers are keyed by content key, so they are shared too.
         void AddMeshCache(const MeshCacheEntry& cache);
         void AddMeshInstance(const MeshInstance& instance);
         
+        // Unique geometry by content key
         const std::unordered_map<std::string, MeshCacheEntry>& GetMeshCaches() const { return meshCaches; }
+        // Mesh name -> content key
+        const std::unordered_map<std::string, std::string>& GetMeshAliases() const { return meshAliases; }
+        const std::string* FindMeshKey(const std::string& meshName) const;
+        const MeshCacheEntry* FindMeshCache(const std::string& meshName) const;
         const std::vector<MeshInstance>& GetMeshInstances() const { return meshInstances; }
         size_t GetMeshInstanceCount() const { return meshInstances.size(); }
+        // Instance materials deduplicated by value, so instances sharing a material share one
+        // entry (the GPU material table; the CPU tracer sorts and shades by the same indices)
+        const std::vector<MeshMaterial>& GetMeshMaterials() const { return meshMaterials; }
+        // Index into GetMeshMaterials() of mesh instance instanceIndex
+        uint32_t GetMeshMaterialIndex(size_t instanceIndex) const { return meshMaterialIndices[instanceIndex]; }
 
         void Clear();
 
-        const std::vector<std::shared_ptr<RayTracingObject>>& GetObjects() const { return objects; }
+        const SpherePool& GetSpheres() const { return spheres; }
+        const PlanePool& GetPlanes() const { return planes; }
+        const BoxPool& GetBoxes() const { return boxes; }
+        size_t GetPrimitiveCount() const { return spheres.Size() + planes.Size() + boxes.Size(); }
+        bool HasPrimitives() const { return GetPrimitiveCount() > 0; }
         const std::vector<Light>& GetLights() const { return lights; }
 
+        // ============================================
+        // Change tracking
+        // ============================================
+        // Every mutator that actually changes content advances the scene generation and
+        // stamps the affected category. Clear() followed by re-adding the same content
+        // (the bridge's per-update pattern) compares against the previous content and
+        // leaves generations untouched, so only real edits are reported.
+
+        // Current generation; remember it and pass it to GetChangesSince next frame
+        uint64_t GetGeneration() const;
+        // SceneChangeFlags for every category modified after the given generation (O(1))
+        uint32_t GetChangesSince(uint64_t sinceGeneration) const;
+        // Generation at which an individual light / mesh instance last changed
+        // (primitives carry theirs in PrimitivePool::generations)
+        uint64_t GetLightGeneration(size_t index) const { return index < lightGenerations.size() ? lightGenerations[index] : 0; }
+        uint64_t GetMeshInstanceGeneration(size_t index) const { return index < meshInstanceGenerations.size() ? meshInstanceGenerations[index] : 0; }
+
     private:
+        static constexpr size_t SCENE_CHANGE_CATEGORY_COUNT = 8;
+
+        template<typename T>
+        static bool AssignSetting(T& target, const T& value)
+        {
+            if (target == value)
+                return false;
+            target = value;
+            return true;
+        }
+
+        // Advances the generation and stamps each category in changes; returns the new generation
+        uint64_t MarkChanged(uint32_t changes) const;
+        // Detects removals left over from the last Clear() once the rebuild is complete
+        void FinalizeRebuild() const;
+
+        template<typename Geometry>
+        void AddPrimitive(PrimitivePool<Geometry>& pool, const PrimitivePool<Geometry>& previous,
+            const Geometry& geometry, const ObjectMaterial& material);
+
         Camera camera;
-        std::vector<std::shared_ptr<RayTracingObject>> objects;
+        SpherePool spheres;
+        PlanePool planes;
+        BoxPool boxes;
         std::vector<Light> lights;
         
         // Mesh data
-        std::unordered_map<std::string, MeshCacheEntry> meshCaches;  // Shared mesh geometry by name
+        std::unordered_map<std::string, MeshCacheEntry> meshCaches;  // Shared mesh geometry by content key
+        std::unordered_map<std::string, std::string> meshAliases;    // Mesh name -> content key
         std::vector<MeshInstance> meshInstances;  // Instances referencing mesh caches
+        std::vector<MeshMaterial> meshMaterials;  // Unique instance materials
+        std::vector<uint32_t> meshMaterialIndices;                // Per instance, into meshMaterials
+        std::unordered_map<MeshMaterial, uint32_t, MeshMaterialHash, MeshMaterialEqual> meshMaterialIndexMap;
         
         int samplesPerPixel = 1;
         int maxBounces = 6;
@@ -154,5 +279,28 @@ namespace RayTraceVS::DXEngine
         int maxShadowLights = 2;
         float nrdBypassDistanceThreshold = 8.0f;
         float nrdBypassBlendRange = 2.0f;
+        int russianRouletteMinDepth = 3;
+
+        std::wstring environmentPath;
+        float environmentIntensity = 1.0f;
+        bool environmentLighting = false;
+
+        // Change tracking state (mutable: FinalizeRebuild runs lazily from the const queries)
+        mutable uint64_t generation = 0;
+        mutable uint64_t categoryGenerations[SCENE_CHANGE_CATEGORY_COUNT] = {};
+        std::vector<uint64_t> lightGenerations;
+        std::vector<uint64_t> meshInstanceGenerations;
+
+        // Content before the last Clear(), compared against while the scene is re-added
+        mutable bool rebuildPending = false;
+        mutable SpherePool previousSpheres;
+        mutable PlanePool previousPlanes;
+        mutable BoxPool previousBoxes;
+        mutable std::vector<Light> previousLights;
+        mutable std::vector<uint64_t> previousLightGenerations;
+        mutable std::vector<MeshInstance> previousMeshInstances;
+        mutable std::vector<uint64_t> previousMeshInstanceGenerations;
+        mutable std::unordered_map<std::string, MeshCacheEntry> previousMeshCaches;
+        mutable std::unordered_map<std::string, std::string> previousMeshAliases;
     };
 }
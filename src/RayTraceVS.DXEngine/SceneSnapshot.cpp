@@ -0,0 +1,533 @@
+#include "SceneSnapshot.h"
+#include "ShaderCacheCore.h"
+#include "DebugLog.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        constexpr uint32_t SECTION_COUNT = static_cast<uint32_t>(SnapshotSectionType::PagedMeshes);
+
+        static_assert(sizeof(MeshTransform) == 9 * sizeof(float), "MeshTransform must not contain padding");
+        static_assert(sizeof(MeshMaterial) == 15 * sizeof(float), "MeshMaterial must not contain padding");
+        static_assert(sizeof(SnapshotMesh) % 8 == 0, "SnapshotMesh must keep its 64-bit fields aligned in an array");
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // Builds the file in memory: header, section table, then one aligned section per type
+        class SnapshotWriter
+        {
+        public:
+            SnapshotWriter()
+            {
+                bytes.resize(AlignUp(sizeof(SnapshotFileHeader) + SECTION_COUNT * sizeof(SnapshotSection), SceneSnapshot::SECTION_ALIGNMENT));
+            }
+
+            template<typename T>
+            void AddSection(SnapshotSectionType type, const T* data, size_t count)
+            {
+                SnapshotSection section = {};
+                section.type = static_cast<uint32_t>(type);
+                section.elementSize = static_cast<uint32_t>(sizeof(T));
+                section.offset = bytes.size();
+                section.count = count;
+                sections.push_back(section);
+
+                if (count > 0)
+                {
+                    bytes.insert(bytes.end(), reinterpret_cast<const uint8_t*>(data),
+                        reinterpret_cast<const uint8_t*>(data) + count * sizeof(T));
+                }
+                bytes.resize(AlignUp(bytes.size(), SceneSnapshot::SECTION_ALIGNMENT));
+            }
+
+            const std::vector<uint8_t>& Finish()
+            {
+                SnapshotFileHeader header = {};
+                header.magic = SceneSnapshot::MAGIC;
+                header.version = SceneSnapshot::VERSION;
+                header.sectionCount = static_cast<uint32_t>(sections.size());
+                header.fileSize = bytes.size();
+                header.sectionTableOffset = sizeof(SnapshotFileHeader);
+                memcpy(bytes.data(), &header, sizeof(header));
+                memcpy(bytes.data() + header.sectionTableOffset, sections.data(), sections.size() * sizeof(SnapshotSection));
+                return bytes;
+            }
+
+        private:
+            std::vector<uint8_t> bytes;
+            std::vector<SnapshotSection> sections;
+        };
+
+        uint32_t AddString(std::string& strings, const std::string& value)
+        {
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings += value;
+            return offset;
+        }
+    }
+
+    SceneSnapshot::~SceneSnapshot()
+    {
+        Close();
+    }
+
+    bool SceneSnapshot::Save(const Scene& scene, const std::filesystem::path& path)
+    {
+        std::string strings;
+
+        SnapshotSettings settings = {};
+        settings.samplesPerPixel = scene.GetSamplesPerPixel();
+        settings.maxBounces = scene.GetMaxBounces();
+        settings.traceRecursionDepth = scene.GetTraceRecursionDepth();
+        settings.exposure = scene.GetExposure();
+        settings.toneMapOperator = scene.GetToneMapOperator();
+        settings.denoiserStabilization = scene.GetDenoiserStabilization();
+        settings.shadowStrength = scene.GetShadowStrength();
+        settings.shadowAbsorptionScale = scene.GetShadowAbsorptionScale();
+        settings.enableDenoiser = scene.GetEnableDenoiser() ? 1u : 0u;
+        settings.gamma = scene.GetGamma();
+        settings.photonDebugMode = scene.GetPhotonDebugMode();
+        settings.photonDebugScale = scene.GetPhotonDebugScale();
+        settings.lightAttenuationConstant = scene.GetLightAttenuationConstant();
+        settings.lightAttenuationLinear = scene.GetLightAttenuationLinear();
+        settings.lightAttenuationQuadratic = scene.GetLightAttenuationQuadratic();
+        settings.maxShadowLights = scene.GetMaxShadowLights();
+        settings.nrdBypassDistanceThreshold = scene.GetNRDBypassDistanceThreshold();
+        settings.nrdBypassBlendRange = scene.GetNRDBypassBlendRange();
+        const std::string environmentPath = ToUtf8(scene.GetEnvironmentPath());
+        settings.environmentPathOffset = AddString(strings, environmentPath);
+        settings.environmentPathLength = static_cast<uint32_t>(environmentPath.size());
+        settings.environmentIntensity = scene.GetEnvironmentIntensity();
+        settings.environmentLighting = scene.GetEnvironmentLighting() ? 1u : 0u;
+        settings.russianRouletteMinDepth = scene.GetRussianRouletteMinDepth();
+
+        const Camera& sceneCamera = scene.GetCamera();
+        SnapshotCamera camera = {};
+        camera.position = sceneCamera.GetPosition();
+        camera.lookAt = sceneCamera.GetLookAt();
+        camera.up = sceneCamera.GetUp();
+        camera.fieldOfView = sceneCamera.GetFieldOfView();
+        camera.apertureSize = sceneCamera.GetApertureSize();
+        camera.focusDistance = sceneCamera.GetFocusDistance();
+
+        std::vector<SnapshotLight> lights;
+        lights.reserve(scene.GetLights().size());
+        for (const Light& light : scene.GetLights())
+        {
+            SnapshotLight record = {};
+            record.position = light.GetPosition();
+            record.color = light.GetColor();
+            record.intensity = light.GetIntensity();
+            record.type = static_cast<uint32_t>(light.GetType());
+            record.radius = light.GetRadius();
+            record.softShadowSamples = light.GetSoftShadowSamples();
+            lights.push_back(record);
+        }
+
+        // Meshes in name order (deterministic output); aliases of one scene geometry share
+        // its vertex/index range, and the SHA-256 is computed once per geometry
+        std::map<std::string, const std::string*> sortedAliases;
+        for (const auto& [name, key] : scene.GetMeshAliases())
+            sortedAliases[name] = &key;
+
+        std::vector<SnapshotMesh> meshes;
+        std::vector<SnapshotPagedMesh> pagedMeshes;
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        std::map<std::string, size_t> meshByKey;
+        std::map<std::string, uint32_t> meshIndexByName;
+        for (const auto& [name, key] : sortedAliases)
+        {
+            const MeshCacheEntry* cache = scene.FindMeshCache(name);
+            if (!cache)
+                continue;
+
+            SnapshotMesh record = {};
+            record.nameOffset = AddString(strings, name);
+            record.nameLength = static_cast<uint32_t>(name.size());
+            record.boundsMin = cache->boundsMin;
+            record.boundsMax = cache->boundsMax;
+            record.spatialSplits = cache->spatialSplits ? 1u : 0u;
+            const std::string pagedPath = ToUtf8(cache->pagedFile);
+
+            auto shared = meshByKey.find(*key);
+            if (shared != meshByKey.end())
+            {
+                const SnapshotMesh& original = meshes[shared->second];
+                memcpy(record.contentHash, original.contentHash, sizeof(record.contentHash));
+                record.firstVertexFloat = original.firstVertexFloat;
+                record.vertexFloatCount = original.vertexFloatCount;
+                record.firstIndex = original.firstIndex;
+                record.indexCount = original.indexCount;
+            }
+            else
+            {
+                // Paged geometry stays in its file (and has no vertices here): the path is its content
+                Sha256 hasher;
+                hasher.Update(cache->vertices.data(), cache->vertices.size() * sizeof(float));
+                hasher.Update(cache->indices.data(), cache->indices.size() * sizeof(uint32_t));
+                hasher.Update(pagedPath.data(), pagedPath.size());
+                const std::string hash = hasher.FinishHex();
+                memcpy(record.contentHash, hash.data(), (std::min)(hash.size(), sizeof(record.contentHash)));
+
+                record.firstVertexFloat = vertices.size();
+                record.vertexFloatCount = cache->vertices.size();
+                record.firstIndex = indices.size();
+                record.indexCount = cache->indices.size();
+                vertices.insert(vertices.end(), cache->vertices.begin(), cache->vertices.end());
+                indices.insert(indices.end(), cache->indices.begin(), cache->indices.end());
+                meshByKey[*key] = meshes.size();
+            }
+            if (!pagedPath.empty())
+            {
+                SnapshotPagedMesh paged = {};
+                paged.meshIndex = static_cast<uint32_t>(meshes.size());
+                paged.pathOffset = AddString(strings, pagedPath);
+                paged.pathLength = static_cast<uint32_t>(pagedPath.size());
+                pagedMeshes.push_back(paged);
+            }
+            meshIndexByName[name] = static_cast<uint32_t>(meshes.size());
+            meshes.push_back(record);
+        }
+
+        std::vector<SnapshotMeshInstance> instances;
+        instances.reserve(scene.GetMeshInstanceCount());
+        for (const MeshInstance& instance : scene.GetMeshInstances())
+        {
+            auto mesh = meshIndexByName.find(instance.meshName);
+            if (mesh == meshIndexByName.end())
+            {
+                LOG_WARNF("SceneSnapshot::Save: instance of unknown mesh '%s' skipped", instance.meshName.c_str());
+                continue;
+            }
+            SnapshotMeshInstance record = {};
+            record.meshIndex = mesh->second;
+            record.transform = instance.transform;
+            record.material = instance.material;
+            instances.push_back(record);
+        }
+
+        // Sections in SnapshotSectionType order
+        SnapshotWriter writer;
+        writer.AddSection(SnapshotSectionType::Settings, &settings, 1);
+        writer.AddSection(SnapshotSectionType::Camera, &camera, 1);
+        writer.AddSection(SnapshotSectionType::Lights, lights.data(), lights.size());
+        writer.AddSection(SnapshotSectionType::SphereGeometry, scene.GetSpheres().geometry.data(), scene.GetSpheres().Size());
+        writer.AddSection(SnapshotSectionType::SphereMaterials, scene.GetSpheres().materials.data(), scene.GetSpheres().Size());
+        writer.AddSection(SnapshotSectionType::PlaneGeometry, scene.GetPlanes().geometry.data(), scene.GetPlanes().Size());
+        writer.AddSection(SnapshotSectionType::PlaneMaterials, scene.GetPlanes().materials.data(), scene.GetPlanes().Size());
+        writer.AddSection(SnapshotSectionType::BoxGeometry, scene.GetBoxes().geometry.data(), scene.GetBoxes().Size());
+        writer.AddSection(SnapshotSectionType::BoxMaterials, scene.GetBoxes().materials.data(), scene.GetBoxes().Size());
+        writer.AddSection(SnapshotSectionType::Meshes, meshes.data(), meshes.size());
+        writer.AddSection(SnapshotSectionType::MeshInstances, instances.data(), instances.size());
+        writer.AddSection(SnapshotSectionType::Vertices, vertices.data(), vertices.size());
+        writer.AddSection(SnapshotSectionType::Indices, indices.data(), indices.size());
+        writer.AddSection(SnapshotSectionType::Strings, strings.data(), strings.size());
+        writer.AddSection(SnapshotSectionType::PagedMeshes, pagedMeshes.data(), pagedMeshes.size());
+        const std::vector<uint8_t>& bytes = writer.Finish();
+
+        // Write next to the target and rename, so a reader never maps a partial file
+        std::filesystem::path tempPath = path;
+        tempPath += L".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+            {
+                LOG_WARNF("SceneSnapshot::Save: cannot write %s", tempPath.string().c_str());
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            LOG_WARNF("SceneSnapshot::Save: cannot replace %s", path.string().c_str());
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        LOG_INFOF("SceneSnapshot: saved %s (%llu bytes, %zu meshes, %zu unique, %zu paged)", path.string().c_str(),
+            static_cast<unsigned long long>(bytes.size()), meshes.size(), meshByKey.size(), pagedMeshes.size());
+        return true;
+    }
+
+    bool SceneSnapshot::Open(const std::filesystem::path& path)
+    {
+        Close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            LOG_WARNF("SceneSnapshot::Open: cannot open %s", path.string().c_str());
+            return false;
+        }
+        LARGE_INTEGER size = {};
+        GetFileSizeEx(file, &size);
+        HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            LOG_WARNF("SceneSnapshot::Open: cannot map %s", path.string().c_str());
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+        fileHandle = file;
+        mappingHandle = mapping;
+        fileSize = static_cast<uint64_t>(size.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info = {};
+        if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            LOG_WARNF("SceneSnapshot::Open: cannot open %s", path.string().c_str());
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        const void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            LOG_WARNF("SceneSnapshot::Open: cannot map %s", path.string().c_str());
+            return false;
+        }
+        fileSize = static_cast<uint64_t>(info.st_size);
+#endif
+        base = static_cast<const uint8_t*>(view);
+
+        if (!Resolve())
+        {
+            LOG_WARNF("SceneSnapshot::Open: %s is not a valid scene snapshot (version %u expected)", path.string().c_str(), VERSION);
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void SceneSnapshot::Close()
+    {
+        if (base)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+            CloseHandle(static_cast<HANDLE>(mappingHandle));
+            CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+            munmap(const_cast<uint8_t*>(base), fileSize);
+#endif
+        }
+        base = nullptr;
+        fileSize = 0;
+        fileHandle = mappingHandle = nullptr;
+        settings = nullptr;
+        camera = nullptr;
+        lights = {};
+        sphereGeometry = {};
+        sphereMaterials = {};
+        planeGeometry = {};
+        planeMaterials = {};
+        boxGeometry = {};
+        boxMaterials = {};
+        meshes = {};
+        meshInstances = {};
+        vertices = {};
+        indices = {};
+        strings = {};
+        pagedMeshes = {};
+    }
+
+    // Pointer fix-up: validates the table and turns every section into a typed span
+    bool SceneSnapshot::Resolve()
+    {
+        if (fileSize < sizeof(SnapshotFileHeader))
+            return false;
+        const auto* header = reinterpret_cast<const SnapshotFileHeader*>(base);
+        if (header->magic != MAGIC || header->version != VERSION || header->fileSize != fileSize ||
+            header->sectionCount != SECTION_COUNT ||
+            header->sectionTableOffset % alignof(SnapshotSection) != 0 || header->sectionTableOffset > fileSize ||
+            static_cast<uint64_t>(SECTION_COUNT) * sizeof(SnapshotSection) > fileSize - header->sectionTableOffset)
+            return false;
+
+        const auto* table = reinterpret_cast<const SnapshotSection*>(base + header->sectionTableOffset);
+        auto section = [&]<typename T>(SnapshotSectionType type, std::span<const T>& out) -> bool
+        {
+            const SnapshotSection& entry = table[static_cast<uint32_t>(type) - 1];
+            if (entry.type != static_cast<uint32_t>(type) || entry.elementSize != sizeof(T) ||
+                entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > fileSize ||
+                entry.count > (fileSize - entry.offset) / sizeof(T))
+                return false;
+            out = std::span<const T>(reinterpret_cast<const T*>(base + entry.offset), static_cast<size_t>(entry.count));
+            return true;
+        };
+
+        std::span<const SnapshotSettings> settingsSection;
+        std::span<const SnapshotCamera> cameraSection;
+        bool valid =
+            section(SnapshotSectionType::Settings, settingsSection) &&
+            section(SnapshotSectionType::Camera, cameraSection) &&
+            section(SnapshotSectionType::Lights, lights) &&
+            section(SnapshotSectionType::SphereGeometry, sphereGeometry) &&
+            section(SnapshotSectionType::SphereMaterials, sphereMaterials) &&
+            section(SnapshotSectionType::PlaneGeometry, planeGeometry) &&
+            section(SnapshotSectionType::PlaneMaterials, planeMaterials) &&
+            section(SnapshotSectionType::BoxGeometry, boxGeometry) &&
+            section(SnapshotSectionType::BoxMaterials, boxMaterials) &&
+            section(SnapshotSectionType::Meshes, meshes) &&
+            section(SnapshotSectionType::MeshInstances, meshInstances) &&
+            section(SnapshotSectionType::Vertices, vertices) &&
+            section(SnapshotSectionType::Indices, indices) &&
+            section(SnapshotSectionType::Strings, strings) &&
+            section(SnapshotSectionType::PagedMeshes, pagedMeshes);
+        if (!valid || settingsSection.size() != 1 || cameraSection.size() != 1 ||
+            sphereGeometry.size() != sphereMaterials.size() ||
+            planeGeometry.size() != planeMaterials.size() ||
+            boxGeometry.size() != boxMaterials.size())
+            return false;
+        settings = &settingsSection[0];
+        camera = &cameraSection[0];
+
+        // Cross references, so Apply and the accessors never read outside the file
+        auto validString = [&](uint32_t offset, uint32_t length)
+        {
+            return static_cast<uint64_t>(offset) + length <= strings.size();
+        };
+        if (!validString(settings->environmentPathOffset, settings->environmentPathLength))
+            return false;
+        for (const SnapshotMesh& mesh : meshes)
+        {
+            if (!validString(mesh.nameOffset, mesh.nameLength) ||
+                mesh.firstVertexFloat > vertices.size() || mesh.vertexFloatCount > vertices.size() - mesh.firstVertexFloat ||
+                mesh.firstIndex > indices.size() || mesh.indexCount > indices.size() - mesh.firstIndex)
+                return false;
+        }
+        for (const SnapshotMeshInstance& instance : meshInstances)
+        {
+            if (instance.meshIndex >= meshes.size())
+                return false;
+        }
+        for (const SnapshotPagedMesh& paged : pagedMeshes)
+        {
+            if (paged.meshIndex >= meshes.size() || !validString(paged.pathOffset, paged.pathLength) ||
+                meshes[paged.meshIndex].vertexFloatCount != 0 || meshes[paged.meshIndex].indexCount != 0)
+                return false;
+        }
+        return true;
+    }
+
+    std::span<const float> SceneSnapshot::GetMeshVertices(const SnapshotMesh& mesh) const
+    {
+        return vertices.subspan(static_cast<size_t>(mesh.firstVertexFloat), static_cast<size_t>(mesh.vertexFloatCount));
+    }
+
+    std::span<const uint32_t> SceneSnapshot::GetMeshIndices(const SnapshotMesh& mesh) const
+    {
+        return indices.subspan(static_cast<size_t>(mesh.firstIndex), static_cast<size_t>(mesh.indexCount));
+    }
+
+    std::string_view SceneSnapshot::GetString(uint32_t offset, uint32_t length) const
+    {
+        return std::string_view(strings.data() + offset, length);
+    }
+
+    bool SceneSnapshot::Apply(Scene& scene) const
+    {
+        if (!base)
+            return false;
+
+        scene.Clear();
+
+        Camera sceneCamera;
+        sceneCamera.SetPosition(camera->position);
+        sceneCamera.SetLookAt(camera->lookAt);
+        sceneCamera.SetUp(camera->up);
+        sceneCamera.SetFieldOfView(camera->fieldOfView);
+        sceneCamera.SetApertureSize(camera->apertureSize);
+        sceneCamera.SetFocusDistance(camera->focusDistance);
+        scene.SetCamera(sceneCamera);
+
+        scene.SetRenderSettings(settings->samplesPerPixel, settings->maxBounces, settings->traceRecursionDepth,
+            settings->exposure, settings->toneMapOperator, settings->denoiserStabilization,
+            settings->shadowStrength, settings->shadowAbsorptionScale, settings->enableDenoiser != 0,
+            settings->gamma, settings->photonDebugMode, settings->photonDebugScale,
+            settings->lightAttenuationConstant, settings->lightAttenuationLinear, settings->lightAttenuationQuadratic,
+            settings->maxShadowLights, settings->nrdBypassDistanceThreshold, settings->nrdBypassBlendRange);
+        scene.SetEnvironment(FromUtf8(std::string(GetString(settings->environmentPathOffset, settings->environmentPathLength))),
+            settings->environmentIntensity, settings->environmentLighting != 0);
+        scene.SetRussianRouletteMinDepth(settings->russianRouletteMinDepth);
+
+        for (size_t i = 0; i < sphereGeometry.size(); i++)
+            scene.AddSphere(sphereGeometry[i], sphereMaterials[i]);
+        for (size_t i = 0; i < planeGeometry.size(); i++)
+            scene.AddPlane(planeGeometry[i], planeMaterials[i]);
+        for (size_t i = 0; i < boxGeometry.size(); i++)
+            scene.AddBox(boxGeometry[i], boxMaterials[i]);
+
+        for (const SnapshotLight& record : lights)
+        {
+            Light light;
+            light.SetPosition(record.position);
+            light.SetColor(record.color);
+            light.SetIntensity(record.intensity);
+            light.SetType(static_cast<LightType>(record.type));
+            light.SetRadius(record.radius);
+            light.SetSoftShadowSamples(record.softShadowSamples);
+            scene.AddLight(light);
+        }
+
+        std::vector<const SnapshotPagedMesh*> pagedByMesh(meshes.size(), nullptr);
+        for (const SnapshotPagedMesh& paged : pagedMeshes)
+            pagedByMesh[paged.meshIndex] = &paged;
+
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const SnapshotMesh& mesh = meshes[i];
+            MeshCacheEntry entry;
+            entry.name = GetString(mesh.nameOffset, mesh.nameLength);
+            if (pagedByMesh[i])
+            {
+                // The file is opened when the CPU path tracer builds its acceleration structure
+                entry.pagedFile = FromUtf8(std::string(GetString(pagedByMesh[i]->pathOffset, pagedByMesh[i]->pathLength)));
+            }
+            std::span<const float> meshVertices = GetMeshVertices(mesh);
+            std::span<const uint32_t> meshIndices = GetMeshIndices(mesh);
+            entry.vertices.assign(meshVertices.begin(), meshVertices.end());
+            entry.indices.assign(meshIndices.begin(), meshIndices.end());
+            entry.boundsMin = mesh.boundsMin;
+            entry.boundsMax = mesh.boundsMax;
+            entry.spatialSplits = mesh.spatialSplits != 0;
+            scene.AddMeshCache(entry);
+        }
+
+        for (const SnapshotMeshInstance& record : meshInstances)
+        {
+            const SnapshotMesh& mesh = meshes[record.meshIndex];
+            MeshInstance instance;
+            instance.meshName = GetString(mesh.nameOffset, mesh.nameLength);
+            instance.transform = record.transform;
+            instance.material = record.material;
+            scene.AddMeshInstance(instance);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "Scene/Scene.h"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+// ============================================
+// Binary scene snapshot (.rtvsb)
+// ============================================
+//
+// The evaluated Scene in a flat, memory-mappable file: no node graph, no parsing. The
+// file is a header, a section table and 16-byte aligned sections, each a tightly packed
+// array of one POD record type (primitive geometry and materials are the SoA pools
+// verbatim). Loading maps the file and turns section offsets into typed spans; nothing
+// is decoded or copied until Apply fills a Scene.
+//
+// Mesh caches are referenced by content (SHA-256 of vertices + indices, lowercase hex):
+// meshes with identical data under different names share one vertex/index range, and
+// the hash is the key a farm-side mesh store can use to skip transfers it already has.
+// Paged meshes (PagedMesh.h) keep their geometry in the .rtvsm file: the snapshot stores
+// only the file reference, and loading registers it without reading the vertices.
+//
+// Little-endian only; VERSION changes whenever a record layout changes.
+
+namespace RayTraceVS::DXEngine
+{
+    enum class SnapshotSectionType : uint32_t
+    {
+        Settings = 1,
+        Camera,
+        Lights,
+        SphereGeometry,
+        SphereMaterials,
+        PlaneGeometry,
+        PlaneMaterials,
+        BoxGeometry,
+        BoxMaterials,
+        Meshes,
+        MeshInstances,
+        Vertices,       // float, 8 per vertex (MeshCacheEntry layout)
+        Indices,        // uint32_t
+        Strings,        // UTF-8, referenced by offset + length
+        PagedMeshes     // .rtvsm references of out-of-core meshes
+    };
+
+    struct SnapshotFileHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t sectionCount;
+        uint64_t fileSize;
+        uint64_t sectionTableOffset;
+    };
+
+    struct SnapshotSection
+    {
+        uint32_t type;          // SnapshotSectionType
+        uint32_t elementSize;   // sizeof the record, checked on load
+        uint64_t offset;        // From the start of the file
+        uint64_t count;
+    };
+
+    struct SnapshotSettings
+    {
+        int32_t samplesPerPixel;
+        int32_t maxBounces;
+        int32_t traceRecursionDepth;
+        float exposure;
+        int32_t toneMapOperator;
+        float denoiserStabilization;
+        float shadowStrength;
+        float shadowAbsorptionScale;
+        uint32_t enableDenoiser;
+        float gamma;
+        int32_t photonDebugMode;
+        float photonDebugScale;
+        float lightAttenuationConstant;
+        float lightAttenuationLinear;
+        float lightAttenuationQuadratic;
+        int32_t maxShadowLights;
+        float nrdBypassDistanceThreshold;
+        float nrdBypassBlendRange;
+        uint32_t environmentPathOffset;     // Strings (UTF-8), length 0 = built-in sky
+        uint32_t environmentPathLength;
+        float environmentIntensity;
+        uint32_t environmentLighting;
+        int32_t russianRouletteMinDepth;
+    };
+
+    struct SnapshotCamera
+    {
+        XMFLOAT3 position;
+        XMFLOAT3 lookAt;
+        XMFLOAT3 up;
+        float fieldOfView;
+        float apertureSize;
+        float focusDistance;
+    };
+
+    struct SnapshotLight
+    {
+        XMFLOAT3 position;
+        XMFLOAT4 color;
+        float intensity;
+        uint32_t type;          // LightType
+        float radius;
+        float softShadowSamples;
+    };
+
+    struct SnapshotMesh
+    {
+        char contentHash[64];   // SHA-256 hex of the vertex then index bytes (paged: of the file path)
+        uint32_t nameOffset;    // Strings
+        uint32_t nameLength;
+        uint64_t firstVertexFloat;
+        uint64_t vertexFloatCount;
+        uint64_t firstIndex;
+        uint64_t indexCount;
+        XMFLOAT3 boundsMin;
+        XMFLOAT3 boundsMax;
+        uint32_t spatialSplits;
+        uint32_t padding;
+    };
+
+    // A Meshes record without vertices or indices whose geometry is a paged file
+    struct SnapshotPagedMesh
+    {
+        uint32_t meshIndex;     // Into the Meshes section
+        uint32_t pathOffset;    // Strings
+        uint32_t pathLength;
+        uint32_t padding;
+    };
+
+    struct SnapshotMeshInstance
+    {
+        uint32_t meshIndex;     // Into the Meshes section
+        MeshTransform transform;
+        MeshMaterial material;
+    };
+
+    class SceneSnapshot
+    {
+    public:
+        static constexpr uint64_t MAGIC = 0x31534E5353565452ull;     // "RTVSSNS1"
+        static constexpr uint32_t VERSION = 3;
+        static constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+        SceneSnapshot() = default;
+        ~SceneSnapshot();
+        SceneSnapshot(const SceneSnapshot&) = delete;
+        SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+
+        static bool Save(const Scene& scene, const std::filesystem::path& path);
+
+        // Maps the file read-only and resolves every section; false if it is not a valid snapshot
+        bool Open(const std::filesystem::path& path);
+        void Close();
+        bool IsOpen() const { return base != nullptr; }
+
+        // Replaces the scene content (Clear + Add*, so change tracking sees only real edits)
+        bool Apply(Scene& scene) const;
+
+        // Zero-copy views into the mapping, valid until Close
+        const SnapshotSettings& GetSettings() const { return *settings; }
+        const SnapshotCamera& GetCamera() const { return *camera; }
+        std::span<const SnapshotLight> GetLights() const { return lights; }
+        std::span<const SphereGeometry> GetSphereGeometry() const { return sphereGeometry; }
+        std::span<const ObjectMaterial> GetSphereMaterials() const { return sphereMaterials; }
+        std::span<const PlaneGeometry> GetPlaneGeometry() const { return planeGeometry; }
+        std::span<const ObjectMaterial> GetPlaneMaterials() const { return planeMaterials; }
+        std::span<const BoxGeometry> GetBoxGeometry() const { return boxGeometry; }
+        std::span<const ObjectMaterial> GetBoxMaterials() const { return boxMaterials; }
+        std::span<const SnapshotMesh> GetMeshes() const { return meshes; }
+        std::span<const SnapshotMeshInstance> GetMeshInstances() const { return meshInstances; }
+        std::span<const SnapshotPagedMesh> GetPagedMeshes() const { return pagedMeshes; }
+        std::span<const float> GetMeshVertices(const SnapshotMesh& mesh) const;
+        std::span<const uint32_t> GetMeshIndices(const SnapshotMesh& mesh) const;
+        std::string_view GetString(uint32_t offset, uint32_t length) const;
+        uint64_t GetFileSize() const { return fileSize; }
+
+    private:
+        bool Resolve();
+
+        const uint8_t* base = nullptr;
+        uint64_t fileSize = 0;
+        void* fileHandle = nullptr;         // Windows: file and mapping handles
+        void* mappingHandle = nullptr;
+
+        const SnapshotSettings* settings = nullptr;
+        const SnapshotCamera* camera = nullptr;
+        std::span<const SnapshotLight> lights;
+        std::span<const SphereGeometry> sphereGeometry;
+        std::span<const ObjectMaterial> sphereMaterials;
+        std::span<const PlaneGeometry> planeGeometry;
+        std::span<const ObjectMaterial> planeMaterials;
+        std::span<const BoxGeometry> boxGeometry;
+        std::span<const ObjectMaterial> boxMaterials;
+        std::span<const SnapshotMesh> meshes;
+        std::span<const SnapshotMeshInstance> meshInstances;
+        std::span<const float> vertices;
+        std::span<const uint32_t> indices;
+        std::span<const char> strings;
+        std::span<const SnapshotPagedMesh> pagedMeshes;
+    };
+}
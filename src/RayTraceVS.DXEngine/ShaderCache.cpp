@@ -6,59 +6,15 @@
 #include <filesystem>
 #include <chrono>
 #include <iomanip>
-#include <bcrypt.h>
 
-#pragma comment(lib, "bcrypt.lib")
 #pragma comment(lib, "dxcompiler.lib")
 
 namespace RayTraceVS::DXEngine
 {
-    // Simple JSON parser/writer for metadata
-    // (Avoiding external dependencies like nlohmann/json)
-    namespace JsonHelper
-    {
-        std::string EscapeString(const std::string& s)
-        {
-            std::string result;
-            for (char c : s)
-            {
-                switch (c)
-                {
-                    case '"': result += "\\\""; break;
-                    case '\\': result += "\\\\"; break;
-                    case '\n': result += "\\n"; break;
-                    case '\r': result += "\\r"; break;
-                    case '\t': result += "\\t"; break;
-                    default: result += c; break;
-                }
-            }
-            return result;
-        }
-
-        std::string WStringToString(const std::wstring& ws)
-        {
-            if (ws.empty()) return "";
-            int size = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, nullptr, 0, nullptr, nullptr);
-            std::string result(size - 1, 0);
-            WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, &result[0], size, nullptr, nullptr);
-            return result;
-        }
-
-        std::wstring StringToWString(const std::string& s)
-        {
-            if (s.empty()) return L"";
-            int size = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
-            std::wstring result(size - 1, 0);
-            MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &result[0], size);
-            return result;
-        }
-    }
-
     // ShaderCache log helper - uses centralized logging
     static void ShaderCacheLog(const char* message)
     {
-        std::string prefixedMsg = std::string("[ShaderCache] ") + message;
-        LOG_INFO(prefixedMsg.c_str());
+        LOG_INFOF("[ShaderCache] %s", message);
     }
 
     ShaderCache::ShaderCache(DXContext* context)
@@ -68,6 +24,8 @@ namespace RayTraceVS::DXEngine
 
     ShaderCache::~ShaderCache()
     {
+        // Joins the workers (pending jobs are dropped) before the state they use goes away
+        compileQueue.reset();
     }
 
     void ShaderCache::Log(const char* message)
@@ -77,9 +35,7 @@ namespace RayTraceVS::DXEngine
 
     void ShaderCache::Log(const char* message, HRESULT hr)
     {
-        char buf[512];
-        sprintf_s(buf, "%s: 0x%08X", message, hr);
-        ShaderCacheLog(buf);
+        LOG_INFOF("[ShaderCache] %s: 0x%08X", message, static_cast<unsigned int>(hr));
     }
 
     bool ShaderCache::Initialize(const std::wstring& cacheDirectory, const std::wstring& sourceDirectory)
@@ -100,8 +56,11 @@ namespace RayTraceVS::DXEngine
             return false;
         }
 
-        // Register known shaders
+        // Register known shaders and discover their includes
         RegisterShaders();
+        ScanSources();
+
+        compileQueue = std::make_unique<ShaderCompileQueue>();
 
         // Load existing metadata
         metadataLoaded = LoadMetadata();
@@ -112,12 +71,12 @@ namespace RayTraceVS::DXEngine
         if (!globalCacheValid)
         {
             Log("Global cache invalid (driver changed or first run) - will recompile all shaders");
-            statusMessage = L"Shaders need recompilation (driver changed or first run)";
+            SetStatusMessage(L"Shaders need recompilation (driver changed or first run)");
         }
         else
         {
             Log("Global cache valid - checking individual shaders");
-            statusMessage = L"Shader cache initialized";
+            SetStatusMessage(L"Shader cache initialized");
         }
 
         Log("ShaderCache::Initialize completed");
@@ -128,134 +87,198 @@ namespace RayTraceVS::DXEngine
     {
         // DXR library shaders
         shaderDefinitions[L"RayGen"] = {
-            L"RayGen", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli", L"NRDEncoding.hlsli" }
+            L"RayGen", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"ClosestHit"] = {
-            L"ClosestHit", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli", L"NRDEncoding.hlsli" }
+            L"ClosestHit", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"ClosestHit_Triangle"] = {
-            L"ClosestHit_Triangle", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli", L"NRDEncoding.hlsli" }
+            L"ClosestHit_Triangle", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"Miss"] = {
-            L"Miss", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"Miss", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"Intersection"] = {
-            L"Intersection", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"Intersection", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"AnyHit_Shadow"] = {
-            L"AnyHit_Shadow", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"AnyHit_Shadow", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"AnyHit_SkipSelf"] = {
-            L"AnyHit_SkipSelf", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"AnyHit_SkipSelf", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"PhotonEmit"] = {
-            L"PhotonEmit", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"PhotonEmit", ShaderType::DXRLibrary, L""
         };
 
         shaderDefinitions[L"PhotonTrace"] = {
-            L"PhotonTrace", ShaderType::DXRLibrary, L"",
-            { L"Common.hlsli" }
+            L"PhotonTrace", ShaderType::DXRLibrary, L""
         };
 
         // Photon hash table compute shaders (spatial hash for O(1) photon lookup)
         shaderDefinitions[L"BuildPhotonHashClear"] = {
-            L"BuildPhotonHash", ShaderType::Compute, L"ClearPhotonHash",
-            {}
+            L"BuildPhotonHash", ShaderType::Compute, L"ClearPhotonHash"
         };
 
         shaderDefinitions[L"BuildPhotonHashBuild"] = {
-            L"BuildPhotonHash", ShaderType::Compute, L"BuildPhotonHash",
-            {}
+            L"BuildPhotonHash", ShaderType::Compute, L"BuildPhotonHash"
         };
 
         // Compute shaders
         shaderDefinitions[L"RayTraceCompute"] = {
-            L"RayTraceCompute", ShaderType::Compute, L"CSMain",
-            {}
+            L"RayTraceCompute", ShaderType::Compute, L"CSMain"
         };
 
         shaderDefinitions[L"Composite"] = {
-            L"Composite", ShaderType::Compute, L"CSMain",
-            {}
+            L"Composite", ShaderType::Compute, L"CSMain"
         };
     }
 
+    void ShaderCache::ScanSources()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::filesystem::path> roots;
+        roots.reserve(shaderDefinitions.size());
+        for (const auto& [name, def] : shaderDefinitions)
+        {
+            roots.push_back(GetSourcePath(name));
+        }
+
+        // Same search order as the compilers: including file's directory, then -I sourceDir
+        sourceGraph.Clear();
+        sourceGraph.SetIncludeDirectories({ std::filesystem::path(sourceDir) });
+        sourceGraph.Scan(roots);
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFOF("[ShaderCache] Scanned %u source files in %.2f ms",
+            static_cast<unsigned int>(sourceGraph.GetFileCount()), elapsedMs);
+    }
+
+    bool ShaderCache::GetSourceState(const std::wstring& shaderName, std::string& sourceHash, std::vector<ShaderDependency>& dependencies)
+    {
+        std::filesystem::path sourcePath = GetSourcePath(shaderName);
+        std::lock_guard<std::mutex> lock(sourceGraphMutex);
+
+        // Shaders requested by name without registration are scanned on first use
+        if (!sourceGraph.Contains(sourcePath))
+        {
+            sourceGraph.Scan({ sourcePath });
+        }
+
+        sourceHash = sourceGraph.GetHash(sourcePath);
+        dependencies.clear();
+
+        std::filesystem::path sourceRoot = ShaderSourceGraph::Normalize(sourceDir);
+        for (const auto& dep : sourceGraph.GetDependencies(sourcePath))
+        {
+            // Relative names keep the metadata valid when the checkout moves
+            std::filesystem::path relative = dep.lexically_relative(sourceRoot);
+            ShaderDependency depInfo;
+            depInfo.filename = (relative.empty() ? dep : relative).generic_wstring();
+            depInfo.hash = sourceGraph.GetHash(dep);
+            dependencies.push_back(std::move(depInfo));
+        }
+
+        return !sourceHash.empty();
+    }
+
     bool ShaderCache::GetShader(const std::wstring& shaderName, ID3DBlob** shader)
     {
         auto it = shaderDefinitions.find(shaderName);
         if (it == shaderDefinitions.end())
         {
-            Log(("Unknown shader: " + JsonHelper::WStringToString(shaderName)).c_str());
+            Log(("Unknown shader: " + ToUtf8(shaderName)).c_str());
             return false;
         }
 
+        if (compileQueue && compileQueue->Contains(shaderName))
+        {
+            return WaitForQueuedShader(shaderName, shader);
+        }
+
         const auto& def = it->second;
+        return ResolveShader(shaderName, def.type, def.entryPoint, shader);
+    }
 
-        // Check if cache is valid for this shader
-        if (globalCacheValid && IsCacheValid(shaderName))
+    bool ShaderCache::GetComputeShader(const std::wstring& shaderName, const std::wstring& entryPoint, ID3DBlob** shader)
+    {
+        // The queued job compiled the registered entry point - only reuse it if it matches
+        auto it = shaderDefinitions.find(shaderName);
+        if (it != shaderDefinitions.end() && it->second.entryPoint == entryPoint &&
+            compileQueue && compileQueue->Contains(shaderName))
         {
-            // Try to load from cache
-            if (LoadFromCache(shaderName, shader))
-            {
-                Log(("Loaded shader from cache: " + JsonHelper::WStringToString(shaderName)).c_str());
-                return true;
-            }
+            return WaitForQueuedShader(shaderName, shader);
         }
 
-        // Cache invalid or failed to load - compile and cache
-        Log(("Compiling shader: " + JsonHelper::WStringToString(shaderName)).c_str());
+        return ResolveShader(shaderName, ShaderType::Compute, entryPoint, shader);
+    }
 
-        if (def.type == ShaderType::DXRLibrary)
+    bool ShaderCache::WaitForQueuedShader(const std::wstring& shaderName, ID3DBlob** shader)
+    {
+        // Only this shader's job is waited on; if no worker has started it yet,
+        // the calling thread runs it
+        if (!compileQueue->Wait(shaderName))
         {
-            return CompileAndCache(shaderName, shader);
+            return false;
         }
-        else
+
+        std::lock_guard<std::mutex> lock(compiledShadersMutex);
+        auto it = compiledShaders.find(shaderName);
+        if (it == compiledShaders.end() || !it->second)
         {
-            return CompileComputeAndCache(shaderName, def.entryPoint, shader);
+            return false;
         }
+        return SUCCEEDED(it->second.CopyTo(shader));
     }
 
-    bool ShaderCache::GetComputeShader(const std::wstring& shaderName, const std::wstring& entryPoint, ID3DBlob** shader)
+    bool ShaderCache::ResolveShader(const std::wstring& shaderName, ShaderType type, const std::wstring& entryPoint, ID3DBlob** shader)
     {
-        // Check if cache is valid
+        // Check if cache is valid for this shader
         if (globalCacheValid && IsCacheValid(shaderName))
         {
+            // Try to load from cache
             if (LoadFromCache(shaderName, shader))
             {
-                Log(("Loaded compute shader from cache: " + JsonHelper::WStringToString(shaderName)).c_str());
+                Log(("Loaded shader from cache: " + ToUtf8(shaderName)).c_str());
                 return true;
             }
         }
 
-        return CompileComputeAndCache(shaderName, entryPoint, shader);
+        // Cache invalid or failed to load - compile and cache
+        Log(("Compiling shader: " + ToUtf8(shaderName)).c_str());
+
+        if (type == ShaderType::DXRLibrary)
+        {
+            return CompileAndCache(shaderName, shader);
+        }
+        else
+        {
+            return CompileComputeAndCache(shaderName, entryPoint, shader);
+        }
     }
 
     bool ShaderCache::IsCacheValid(const std::wstring& shaderName)
     {
         // Check if we have metadata for this shader
-        auto it = metadata.shaders.find(shaderName);
-        if (it == metadata.shaders.end())
+        ShaderCacheInfo cached;
         {
-            return false;
+            std::lock_guard<std::mutex> lock(metadataMutex);
+            auto it = metadata.shaders.find(shaderName);
+            if (it == metadata.shaders.end())
+            {
+                return false;
+            }
+            cached = it->second;
         }
 
-        const auto& info = it->second;
-
         // Check if cached file exists
         std::wstring cachePath = GetCachePath(shaderName);
         if (!std::filesystem::exists(cachePath))
@@ -263,54 +286,16 @@ namespace RayTraceVS::DXEngine
             return false;
         }
 
-        // Check source file hash
-        std::wstring sourcePath = GetSourcePath(shaderName);
-        std::string currentHash = CalculateFileHash(sourcePath);
-        
-        // ハッシュが空の場合はファイルが読めなかった = キャッシュ無効として再コンパイル
-        if (currentHash.empty())
-        {
-            Log(("Failed to hash source: " + JsonHelper::WStringToString(sourcePath)).c_str());
-            return false;
-        }
-        
-        if (currentHash != info.sourceHash)
-        {
-            Log(("Source changed: " + JsonHelper::WStringToString(shaderName)).c_str());
-            return false;
-        }
+        // Compare source and include hashes (computed once in ScanSources)
+        std::string sourceHash;
+        std::vector<ShaderDependency> dependencies;
+        GetSourceState(shaderName, sourceHash, dependencies);
 
-        // Check dependency hashes
-        auto defIt = shaderDefinitions.find(shaderName);
-        if (defIt != shaderDefinitions.end())
+        std::string reason;
+        if (!IsCacheEntryCurrent(cached, sourceHash, dependencies, &reason))
         {
-            const auto& deps = defIt->second.dependencies;
-            
-            // 依存関係の個数が変わったらキャッシュ無効
-            if (deps.size() != info.dependencies.size())
-            {
-                Log(("Dependency count changed for: " + JsonHelper::WStringToString(shaderName)).c_str());
-                return false;
-            }
-            
-            for (size_t i = 0; i < deps.size(); i++)
-            {
-                std::wstring depPath = sourceDir + deps[i];
-                std::string depHash = CalculateFileHash(depPath);
-                
-                // 依存ファイルのハッシュが空の場合もキャッシュ無効
-                if (depHash.empty())
-                {
-                    Log(("Failed to hash dependency: " + JsonHelper::WStringToString(deps[i])).c_str());
-                    return false;
-                }
-                
-                if (depHash != info.dependencies[i].hash)
-                {
-                    Log(("Dependency changed: " + JsonHelper::WStringToString(deps[i])).c_str());
-                    return false;
-                }
-            }
+            Log(("Cache stale for " + ToUtf8(shaderName) + ": " + reason).c_str());
+            return false;
         }
 
         return true;
@@ -323,6 +308,13 @@ namespace RayTraceVS::DXEngine
             return false;
         }
 
+        if (metadata.version != CacheMetadata::CURRENT_VERSION)
+        {
+            Log(("Cache metadata version changed: " + std::to_string(metadata.version) + " -> " +
+                 std::to_string(CacheMetadata::CURRENT_VERSION)).c_str());
+            return false;
+        }
+
         // Check driver version
         std::string currentDriverVersion = GetDriverVersion();
         if (currentDriverVersion != metadata.driverVersion)
@@ -346,9 +338,12 @@ namespace RayTraceVS::DXEngine
     {
         std::wstring sourcePath = GetSourcePath(shaderName);
 
-        if (!CompileDXRLibrary(sourcePath, shader))
+        ShaderDefinition def;
+        uint32_t features = FindDefinition(shaderName, def) ? def.features : ShaderFeature_All;
+
+        if (!CompileDXRLibrary(sourcePath, features, shader))
         {
-            Log(("Failed to compile DXR shader: " + JsonHelper::WStringToString(shaderName)).c_str());
+            Log(("Failed to compile DXR shader: " + ToUtf8(shaderName)).c_str());
             return false;
         }
 
@@ -356,36 +351,13 @@ namespace RayTraceVS::DXEngine
         std::wstring cachePath = GetCachePath(shaderName);
         if (!SaveShaderToFile(*shader, cachePath))
         {
-            Log(("Failed to save shader to cache: " + JsonHelper::WStringToString(shaderName)).c_str());
+            Log(("Failed to save shader to cache: " + ToUtf8(shaderName)).c_str());
             // Continue anyway - shader is compiled
         }
 
-        // Update metadata
-        ShaderCacheInfo info;
-        info.sourceHash = CalculateFileHash(sourcePath);
-        info.compiledAt = GetCurrentTimestamp();
+        UpdateCacheEntry(shaderName);
 
-        // Calculate dependency hashes
-        auto defIt = shaderDefinitions.find(shaderName);
-        if (defIt != shaderDefinitions.end())
-        {
-            for (const auto& dep : defIt->second.dependencies)
-            {
-                std::wstring depPath = sourceDir + dep;
-                ShaderDependency depInfo;
-                depInfo.filename = dep;
-                depInfo.hash = CalculateFileHash(depPath);
-                info.dependencies.push_back(depInfo);
-            }
-        }
-
-        metadata.shaders[shaderName] = info;
-        metadata.driverVersion = GetDriverVersion();
-        metadata.adapterLUID = GetAdapterLUID();
-
-        SaveMetadata();
-
-        Log(("Compiled and cached: " + JsonHelper::WStringToString(shaderName)).c_str());
+        Log(("Compiled and cached: " + ToUtf8(shaderName)).c_str());
         return true;
     }
 
@@ -395,7 +367,7 @@ namespace RayTraceVS::DXEngine
 
         if (!CompileComputeShader(sourcePath, entryPoint, shader))
         {
-            Log(("Failed to compile compute shader: " + JsonHelper::WStringToString(shaderName)).c_str());
+            Log(("Failed to compile compute shader: " + ToUtf8(shaderName)).c_str());
             return false;
         }
 
@@ -403,22 +375,31 @@ namespace RayTraceVS::DXEngine
         std::wstring cachePath = GetCachePath(shaderName);
         if (!SaveShaderToFile(*shader, cachePath))
         {
-            Log(("Failed to save compute shader to cache: " + JsonHelper::WStringToString(shaderName)).c_str());
+            Log(("Failed to save compute shader to cache: " + ToUtf8(shaderName)).c_str());
         }
 
-        // Update metadata
+        UpdateCacheEntry(shaderName);
+
+        Log(("Compiled and cached compute shader: " + ToUtf8(shaderName)).c_str());
+        return true;
+    }
+
+    void ShaderCache::UpdateCacheEntry(const std::wstring& shaderName)
+    {
+        // Hashes come from the snapshot taken at Initialize. If a file was edited since,
+        // the next run sees a mismatch and recompiles - stale entries are never trusted.
         ShaderCacheInfo info;
-        info.sourceHash = CalculateFileHash(sourcePath);
+        GetSourceState(shaderName, info.sourceHash, info.dependencies);
         info.compiledAt = GetCurrentTimestamp();
 
-        metadata.shaders[shaderName] = info;
+        // Serializes concurrent compile jobs writing shader_cache.json
+        std::lock_guard<std::mutex> lock(metadataMutex);
+        metadata.version = CacheMetadata::CURRENT_VERSION;
+        metadata.shaders[shaderName] = std::move(info);
         metadata.driverVersion = GetDriverVersion();
         metadata.adapterLUID = GetAdapterLUID();
 
         SaveMetadata();
-
-        Log(("Compiled and cached compute shader: " + JsonHelper::WStringToString(shaderName)).c_str());
-        return true;
     }
 
     bool ShaderCache::LoadFromCache(const std::wstring& shaderName, ID3DBlob** shader)
@@ -458,7 +439,7 @@ namespace RayTraceVS::DXEngine
     bool ShaderCache::LoadMetadata()
     {
         std::wstring metadataPath = cacheDir + L"shader_cache.json";
-        std::ifstream file(metadataPath);
+        std::ifstream file(metadataPath, std::ios::binary);
         if (!file.is_open())
         {
             return false;
@@ -466,209 +447,32 @@ namespace RayTraceVS::DXEngine
 
         std::stringstream buffer;
         buffer << file.rdbuf();
-        std::string content = buffer.str();
-
-        // Simple JSON parsing (minimal implementation)
-        // Looking for: version, driverVersion, adapterLUID, shaders
-        
-        auto findValue = [&content](const std::string& key) -> std::string {
-            std::string searchKey = "\"" + key + "\":";
-            size_t pos = content.find(searchKey);
-            if (pos == std::string::npos) return "";
-            pos += searchKey.length();
-            while (pos < content.length() && (content[pos] == ' ' || content[pos] == '\t')) pos++;
-            if (pos >= content.length()) return "";
-            
-            if (content[pos] == '"')
-            {
-                pos++;
-                size_t end = content.find('"', pos);
-                if (end == std::string::npos) return "";
-                return content.substr(pos, end - pos);
-            }
-            else
-            {
-                size_t end = pos;
-                while (end < content.length() && content[end] != ',' && content[end] != '}' && content[end] != '\n')
-                    end++;
-                std::string val = content.substr(pos, end - pos);
-                // Trim whitespace
-                while (!val.empty() && (val.back() == ' ' || val.back() == '\t' || val.back() == '\r'))
-                    val.pop_back();
-                return val;
-            }
-        };
 
-        try
+        std::string error;
+        if (!ParseCacheMetadata(buffer.str(), metadata, &error))
         {
-            std::string versionStr = findValue("version");
-            if (!versionStr.empty())
-                metadata.version = std::stoi(versionStr);
-
-            metadata.driverVersion = findValue("driverVersion");
-
-            std::string luidStr = findValue("adapterLUID");
-            if (!luidStr.empty())
-                metadata.adapterLUID = std::stoull(luidStr);
-
-            // Parse shaders section (simplified - just looking for shader names and hashes)
-            size_t shadersPos = content.find("\"shaders\"");
-            if (shadersPos != std::string::npos)
-            {
-                size_t startBrace = content.find('{', shadersPos);
-                if (startBrace != std::string::npos)
-                {
-                    // Find each shader entry
-                    size_t pos = startBrace;
-                    while (pos < content.length())
-                    {
-                        // Find shader name
-                        size_t nameStart = content.find('"', pos + 1);
-                        if (nameStart == std::string::npos) break;
-                        nameStart++;
-                        size_t nameEnd = content.find('"', nameStart);
-                        if (nameEnd == std::string::npos) break;
-
-                        std::string shaderName = content.substr(nameStart, nameEnd - nameStart);
-                        
-                        // Skip if it's a known key
-                        if (shaderName == "sourceHash" || shaderName == "dependencies" || 
-                            shaderName == "compiledAt" || shaderName == "version" ||
-                            shaderName == "driverVersion" || shaderName == "adapterLUID" ||
-                            shaderName == "shaders")
-                        {
-                            pos = nameEnd + 1;
-                            continue;
-                        }
-
-                        // Find sourceHash for this shader
-                        size_t shaderSection = content.find('{', nameEnd);
-                        if (shaderSection == std::string::npos) break;
-                        
-                        size_t sectionEnd = content.find('}', shaderSection);
-                        if (sectionEnd == std::string::npos) break;
-
-                        std::string section = content.substr(shaderSection, sectionEnd - shaderSection + 1);
-                        
-                        ShaderCacheInfo info;
-                        
-                        // Find sourceHash in section
-                        size_t hashPos = section.find("\"sourceHash\"");
-                        if (hashPos != std::string::npos)
-                        {
-                            size_t hashStart = section.find('"', hashPos + 12);
-                            if (hashStart != std::string::npos)
-                            {
-                                hashStart++;
-                                size_t hashEnd = section.find('"', hashStart);
-                                if (hashEnd != std::string::npos)
-                                {
-                                    info.sourceHash = section.substr(hashStart, hashEnd - hashStart);
-                                }
-                            }
-                        }
-
-                        // Parse dependencies
-                        size_t depsPos = section.find("\"dependencies\"");
-                        if (depsPos != std::string::npos)
-                        {
-                            size_t depsStart = section.find('{', depsPos);
-                            size_t depsEnd = section.find('}', depsStart);
-                            if (depsStart != std::string::npos && depsEnd != std::string::npos)
-                            {
-                                std::string depsSection = section.substr(depsStart + 1, depsEnd - depsStart - 1);
-                                
-                                // Parse each dependency
-                                size_t depPos = 0;
-                                while (depPos < depsSection.length())
-                                {
-                                    size_t depNameStart = depsSection.find('"', depPos);
-                                    if (depNameStart == std::string::npos) break;
-                                    depNameStart++;
-                                    size_t depNameEnd = depsSection.find('"', depNameStart);
-                                    if (depNameEnd == std::string::npos) break;
-                                    
-                                    std::string depName = depsSection.substr(depNameStart, depNameEnd - depNameStart);
-                                    
-                                    size_t depHashStart = depsSection.find('"', depNameEnd + 1);
-                                    if (depHashStart == std::string::npos) break;
-                                    depHashStart++;
-                                    size_t depHashEnd = depsSection.find('"', depHashStart);
-                                    if (depHashEnd == std::string::npos) break;
-                                    
-                                    ShaderDependency dep;
-                                    dep.filename = JsonHelper::StringToWString(depName);
-                                    dep.hash = depsSection.substr(depHashStart, depHashEnd - depHashStart);
-                                    info.dependencies.push_back(dep);
-                                    
-                                    depPos = depHashEnd + 1;
-                                }
-                            }
-                        }
-
-                        metadata.shaders[JsonHelper::StringToWString(shaderName)] = info;
-                        pos = sectionEnd + 1;
-                    }
-                }
-            }
-
-            Log(("Loaded metadata: driver=" + metadata.driverVersion + 
-                 ", shaders=" + std::to_string(metadata.shaders.size())).c_str());
-            return true;
-        }
-        catch (const std::exception& e)
-        {
-            Log(("Failed to parse metadata: " + std::string(e.what())).c_str());
+            Log(("Failed to parse metadata: " + error).c_str());
+            metadata = CacheMetadata();
             return false;
         }
+
+        Log(("Loaded metadata: driver=" + metadata.driverVersion +
+             ", shaders=" + std::to_string(metadata.shaders.size())).c_str());
+        return true;
     }
 
     bool ShaderCache::SaveMetadata()
     {
         std::wstring metadataPath = cacheDir + L"shader_cache.json";
-        std::ofstream file(metadataPath);
+        std::ofstream file(metadataPath, std::ios::binary);
         if (!file.is_open())
         {
             Log("Failed to open metadata file for writing");
             return false;
         }
 
-        // Write JSON manually
-        file << "{\n";
-        file << "  \"version\": " << metadata.version << ",\n";
-        file << "  \"driverVersion\": \"" << JsonHelper::EscapeString(metadata.driverVersion) << "\",\n";
-        file << "  \"adapterLUID\": " << metadata.adapterLUID << ",\n";
-        file << "  \"shaders\": {\n";
-
-        bool first = true;
-        for (const auto& [name, info] : metadata.shaders)
-        {
-            if (!first) file << ",\n";
-            first = false;
-
-            file << "    \"" << JsonHelper::WStringToString(name) << "\": {\n";
-            file << "      \"sourceHash\": \"" << JsonHelper::EscapeString(info.sourceHash) << "\",\n";
-            file << "      \"compiledAt\": \"" << JsonHelper::EscapeString(info.compiledAt) << "\",\n";
-            file << "      \"dependencies\": {";
-
-            bool firstDep = true;
-            for (const auto& dep : info.dependencies)
-            {
-                if (!firstDep) file << ",";
-                firstDep = false;
-                file << "\n        \"" << JsonHelper::WStringToString(dep.filename) 
-                     << "\": \"" << JsonHelper::EscapeString(dep.hash) << "\"";
-            }
-
-            if (!info.dependencies.empty()) file << "\n      ";
-            file << "}\n";
-            file << "    }";
-        }
-
-        file << "\n  }\n";
-        file << "}\n";
-
-        return true;
+        file << SerializeCacheMetadata(metadata);
+        return file.good();
     }
 
     std::string ShaderCache::GetDriverVersion()
@@ -715,78 +519,14 @@ namespace RayTraceVS::DXEngine
                static_cast<uint64_t>(desc.AdapterLuid.LowPart);
     }
 
-    std::string ShaderCache::CalculateFileHash(const std::wstring& path)
-    {
-        // Read file contents
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open())
-        {
-            return "";
-        }
-
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string content = buffer.str();
-
-        // Calculate SHA-256 using BCrypt
-        BCRYPT_ALG_HANDLE hAlg = nullptr;
-        BCRYPT_HASH_HANDLE hHash = nullptr;
-        NTSTATUS status;
-
-        status = BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_SHA256_ALGORITHM, nullptr, 0);
-        if (!BCRYPT_SUCCESS(status))
-        {
-            return "";
-        }
-
-        DWORD hashLength = 0;
-        DWORD resultLength = 0;
-        BCryptGetProperty(hAlg, BCRYPT_HASH_LENGTH, (PUCHAR)&hashLength, sizeof(hashLength), &resultLength, 0);
-
-        std::vector<BYTE> hash(hashLength);
-
-        status = BCryptCreateHash(hAlg, &hHash, nullptr, 0, nullptr, 0, 0);
-        if (!BCRYPT_SUCCESS(status))
-        {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
-            return "";
-        }
-
-        status = BCryptHashData(hHash, (PUCHAR)content.data(), (ULONG)content.size(), 0);
-        if (!BCRYPT_SUCCESS(status))
-        {
-            BCryptDestroyHash(hHash);
-            BCryptCloseAlgorithmProvider(hAlg, 0);
-            return "";
-        }
-
-        status = BCryptFinishHash(hHash, hash.data(), hashLength, 0);
-        BCryptDestroyHash(hHash);
-        BCryptCloseAlgorithmProvider(hAlg, 0);
-
-        if (!BCRYPT_SUCCESS(status))
-        {
-            return "";
-        }
-
-        // Convert to hex string
-        std::stringstream ss;
-        for (BYTE b : hash)
-        {
-            ss << std::hex << std::setfill('0') << std::setw(2) << (int)b;
-        }
-
-        return ss.str();
-    }
-
     std::wstring ShaderCache::GetSourcePath(const std::wstring& shaderName) const
     {
         // shaderDefinitions から実際のソースファイル名を取得
-        // (例: BuildPhotonHashClear -> BuildPhotonHash.hlsl)
-        auto it = shaderDefinitions.find(shaderName);
-        if (it != shaderDefinitions.end())
+        // (例: BuildPhotonHashClear -> BuildPhotonHash.hlsl, RayGen_DOF0 -> RayGen.hlsl)
+        ShaderDefinition def;
+        if (FindDefinition(shaderName, def))
         {
-            return sourceDir + it->second.name + L".hlsl";
+            return sourceDir + def.name + L".hlsl";
         }
         // フォールバック: shaderName をそのまま使用
         return sourceDir + shaderName + L".hlsl";
@@ -809,7 +549,7 @@ namespace RayTraceVS::DXEngine
         return ss.str();
     }
 
-    bool ShaderCache::CompileDXRLibrary(const std::wstring& sourcePath, ID3DBlob** shader)
+    bool ShaderCache::CompileDXRLibrary(const std::wstring& sourcePath, uint32_t features, ID3DBlob** shader)
     {
         ComPtr<IDxcUtils> utils;
         ComPtr<IDxcCompiler3> compiler;
@@ -863,6 +603,18 @@ namespace RayTraceVS::DXEngine
         arguments.push_back(L"-D");
         arguments.push_back(L"ENABLE_NRD_GBUFFER=1");
 
+        // Permutation defines (kept alive until Compile returns)
+        std::vector<std::wstring> featureDefines;
+        for (const auto& [define, value] : GetShaderFeatureDefines(features))
+        {
+            featureDefines.push_back(define + L"=" + value);
+        }
+        for (const auto& define : featureDefines)
+        {
+            arguments.push_back(L"-D");
+            arguments.push_back(define.c_str());
+        }
+
         ComPtr<IDxcResult> result;
         hr = compiler->Compile(
             &sourceBuffer,
@@ -918,7 +670,7 @@ namespace RayTraceVS::DXEngine
     bool ShaderCache::CompileComputeShader(const std::wstring& sourcePath, const std::wstring& entryPoint, ID3DBlob** shader)
     {
         ComPtr<ID3DBlob> errorBlob;
-        std::string entryPointStr = JsonHelper::WStringToString(entryPoint);
+        std::string entryPointStr = ToUtf8(entryPoint);
 
         HRESULT hr = D3DCompileFromFile(
             sourcePath.c_str(),
@@ -960,6 +712,19 @@ namespace RayTraceVS::DXEngine
     {
         Log("Clearing shader cache");
 
+        // Let running jobs finish so they do not write into the cleared cache
+        if (compileQueue)
+        {
+            compileQueue->ForgetAll();
+        }
+        {
+            std::lock_guard<std::mutex> lock(compiledShadersMutex);
+            compiledShaders.clear();
+        }
+        precompiledCount = 0;
+
+        std::lock_guard<std::mutex> lock(metadataMutex);
+
         // Delete all .cso files and metadata
         try
         {
@@ -986,6 +751,7 @@ namespace RayTraceVS::DXEngine
         if (!globalCacheValid)
             return true;
 
+        std::lock_guard<std::mutex> lock(metadataMutex);
         for (const auto& [name, def] : shaderDefinitions)
         {
             auto it = metadata.shaders.find(name);
@@ -1003,42 +769,145 @@ namespace RayTraceVS::DXEngine
 
     std::wstring ShaderCache::GetStatusMessage() const
     {
+        std::lock_guard<std::mutex> lock(statusMutex);
         return statusMessage;
     }
 
-    bool ShaderCache::PrecompileAll()
+    void ShaderCache::SetStatusMessage(const std::wstring& message)
     {
-        Log("Pre-compiling all shaders...");
-        statusMessage = L"Compiling shaders...";
+        std::lock_guard<std::mutex> lock(statusMutex);
+        statusMessage = message;
+    }
+
+    void ShaderCache::PrecompileAllAsync()
+    {
+        if (!compileQueue)
+        {
+            Log("PrecompileAllAsync called before Initialize");
+            return;
+        }
 
-        bool success = true;
-        int compiled = 0;
         int total = static_cast<int>(shaderDefinitions.size());
+        LOG_INFOF("[ShaderCache] Queueing %d shaders on %u compile workers",
+            total, compileQueue->GetWorkerCount());
+        SetStatusMessage(L"Compiling shaders...");
 
         for (const auto& [name, def] : shaderDefinitions)
         {
-            ComPtr<ID3DBlob> shader;
-            if (!GetShader(name, &shader))
+            ShaderCompileQueue::Job compile = MakeCompileJob(name, def.type, def.entryPoint);
+            compileQueue->Submit(name, [this, compile, total]()
             {
-                Log(("Failed to compile: " + JsonHelper::WStringToString(name)).c_str());
-                success = false;
-            }
-            else
+                if (!compile())
+                {
+                    return false;
+                }
+
+                int done = ++precompiledCount;
+                SetStatusMessage(L"Compiled " + std::to_wstring(done) + L"/" + std::to_wstring(total) + L" shaders");
+                return true;
+            });
+        }
+    }
+
+    ShaderCompileQueue::Job ShaderCache::MakeCompileJob(const std::wstring& shaderName, ShaderType type, const std::wstring& entryPoint)
+    {
+        // Copies: the job may outlive the caller on a worker thread
+        return [this, shaderName, type, entryPoint]()
+        {
+            ComPtr<ID3DBlob> shader;
+            if (!ResolveShader(shaderName, type, entryPoint, &shader))
             {
-                compiled++;
+                Log(("Failed to compile: " + ToUtf8(shaderName)).c_str());
+                return false;
             }
 
-            statusMessage = L"Compiled " + std::to_wstring(compiled) + L"/" + std::to_wstring(total) + L" shaders";
+            std::lock_guard<std::mutex> lock(compiledShadersMutex);
+            compiledShaders[shaderName] = shader;
+            return true;
+        };
+    }
+
+    bool ShaderCache::FindDefinition(const std::wstring& shaderName, ShaderDefinition& definition) const
+    {
+        // shaderDefinitions is only written by RegisterShaders (before any job runs)
+        auto it = shaderDefinitions.find(shaderName);
+        if (it != shaderDefinitions.end())
+        {
+            definition = it->second;
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(variantMutex);
+        auto variant = variantDefinitions.find(shaderName);
+        if (variant == variantDefinitions.end())
+        {
+            return false;
+        }
+        definition = variant->second;
+        return true;
+    }
+
+    bool ShaderCache::RequestShaderVariant(const std::wstring& shaderName, uint32_t features)
+    {
+        auto it = shaderDefinitions.find(shaderName);
+        if (it == shaderDefinitions.end() || it->second.type != ShaderType::DXRLibrary)
+        {
+            Log(("Permutations are only supported for DXR libraries: " + ToUtf8(shaderName)).c_str());
+            return false;
         }
+        if (!compileQueue)
+        {
+            return false;
+        }
+
+        features &= ShaderFeature_All;
+        std::wstring variantName = GetShaderVariantName(shaderName, features);
+        if (compileQueue->Contains(variantName))
+        {
+            return true;
+        }
+
+        if (features != ShaderFeature_All)
+        {
+            ShaderDefinition variant = it->second;
+            variant.features = features;
+            std::lock_guard<std::mutex> lock(variantMutex);
+            variantDefinitions[variantName] = variant;
+        }
+
+        LOG_INFOF("[ShaderCache] Queueing variant %s (%s)",
+            ToUtf8(variantName).c_str(), DescribeShaderFeatures(features).c_str());
+        compileQueue->Submit(variantName, MakeCompileJob(variantName, it->second.type, it->second.entryPoint));
+        return true;
+    }
+
+    bool ShaderCache::TryGetShaderVariant(const std::wstring& shaderName, uint32_t features, ID3DBlob** shader)
+    {
+        std::wstring variantName = GetShaderVariantName(shaderName, features & ShaderFeature_All);
+        if (!compileQueue || !compileQueue->IsFinished(variantName))
+        {
+            return false;
+        }
+
+        // Finished, so this only takes the blob
+        return WaitForQueuedShader(variantName, shader);
+    }
+
+    bool ShaderCache::PrecompileAll()
+    {
+        Log("Pre-compiling all shaders...");
+
+        PrecompileAllAsync();
+        bool success = compileQueue && compileQueue->WaitAll();
 
         if (success)
         {
-            statusMessage = L"All shaders compiled successfully";
+            SetStatusMessage(L"All shaders compiled successfully");
             Log("All shaders compiled successfully");
         }
         else
         {
-            statusMessage = L"Some shaders failed to compile";
+            SetStatusMessage(L"Some shaders failed to compile");
             Log("Some shaders failed to compile");
         }
 
@@ -4,10 +4,15 @@
 #include <d3dcompiler.h>
 #include <dxcapi.h>
 #include <wrl/client.h>
+#include "ShaderCacheCore.h"
+#include "ShaderCompileQueue.h"
+#include "ShaderPermutation.h"
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 using Microsoft::WRL::ComPtr;
 
@@ -22,37 +27,14 @@ namespace RayTraceVS::DXEngine
         Compute         // cs_5_1 for compute shaders
     };
 
-    // Shader dependency information
-    struct ShaderDependency
-    {
-        std::wstring filename;
-        std::string hash;
-    };
-
-    // Per-shader cache information
-    struct ShaderCacheInfo
-    {
-        std::string sourceHash;
-        std::vector<ShaderDependency> dependencies;
-        std::string compiledAt;
-    };
-
-    // Cache metadata structure
-    struct CacheMetadata
-    {
-        int version = 1;
-        std::string driverVersion;
-        uint64_t adapterLUID = 0;
-        std::unordered_map<std::wstring, ShaderCacheInfo> shaders;
-    };
-
     // Shader definition for registration
     struct ShaderDefinition
     {
         std::wstring name;
         ShaderType type;
         std::wstring entryPoint;  // Only for compute shaders
-        std::vector<std::wstring> dependencies;
+        uint32_t features = ShaderFeature_All;  // Permutation (DXR libraries only, see ShaderPermutation.h)
+        // Dependencies are discovered from the #include graph (see ShaderSourceGraph)
     };
 
     class ShaderCache
@@ -68,6 +50,7 @@ namespace RayTraceVS::DXEngine
 
         // Get a compiled shader (from cache or compile if needed)
         // Returns true if successful, shader blob returned in 'shader'
+        // If the shader was queued by PrecompileAllAsync, waits for that shader only.
         bool GetShader(const std::wstring& shaderName, ID3DBlob** shader);
 
         // Get a compute shader with specific entry point
@@ -82,16 +65,51 @@ namespace RayTraceVS::DXEngine
         // Get compilation status message (for UI display)
         std::wstring GetStatusMessage() const;
 
-        // Pre-compile all registered shaders
+        // Pre-compile all registered shaders (blocks until every shader is done)
         bool PrecompileAll();
 
+        // Queue every registered shader on the compile workers and return immediately.
+        // Independent shaders load/compile concurrently.
+        void PrecompileAllAsync();
+
+        // Queue a feature-specialized variant of a registered DXR library on the compile
+        // workers. Never blocks; repeated requests for the same variant are ignored.
+        bool RequestShaderVariant(const std::wstring& shaderName, uint32_t features);
+
+        // Returns the variant's blob once its compile job has finished successfully.
+        // Never blocks: false while the variant is queued or compiling, or if it failed.
+        bool TryGetShaderVariant(const std::wstring& shaderName, uint32_t features, ID3DBlob** shader);
+
         // Read a numeric #define from an HLSL source file
         bool TryGetHlslDefineUInt(const std::wstring& sourcePath, const std::string& defineName, uint32_t* outValue);
 
     private:
-        // Register known shaders and their dependencies
+        // Register known shaders
         void RegisterShaders();
 
+        // Scan the #include graph of every registered shader, hashing each file once
+        void ScanSources();
+
+        // Current source hash and (transitive) include hashes of a shader
+        bool GetSourceState(const std::wstring& shaderName, std::string& sourceHash, std::vector<ShaderDependency>& dependencies);
+
+        // Record a freshly compiled shader in the metadata and save it
+        void UpdateCacheEntry(const std::wstring& shaderName);
+
+        // Load from cache or compile (runs on the calling thread or a compile worker)
+        bool ResolveShader(const std::wstring& shaderName, ShaderType type, const std::wstring& entryPoint, ID3DBlob** shader);
+
+        // Job that resolves a shader and stores its blob in compiledShaders
+        ShaderCompileQueue::Job MakeCompileJob(const std::wstring& shaderName, ShaderType type, const std::wstring& entryPoint);
+
+        // Registered shaders first, then requested variants
+        bool FindDefinition(const std::wstring& shaderName, ShaderDefinition& definition) const;
+
+        // Wait for a shader queued by PrecompileAllAsync and take its blob
+        bool WaitForQueuedShader(const std::wstring& shaderName, ID3DBlob** shader);
+
+        void SetStatusMessage(const std::wstring& message);
+
         // Check if a specific shader's cache is valid
         bool IsCacheValid(const std::wstring& shaderName);
 
@@ -115,9 +133,6 @@ namespace RayTraceVS::DXEngine
         std::string GetDriverVersion();
         uint64_t GetAdapterLUID();
 
-        // Calculate SHA-256 hash of a file
-        std::string CalculateFileHash(const std::wstring& path);
-
         // Get the full path for a shader source file
         std::wstring GetSourcePath(const std::wstring& shaderName) const;
 
@@ -128,7 +143,8 @@ namespace RayTraceVS::DXEngine
         std::string GetCurrentTimestamp();
 
         // Compile DXR library shader using DXC
-        bool CompileDXRLibrary(const std::wstring& sourcePath, ID3DBlob** shader);
+        // features: permutation; disabled features are passed as -D NAME=0
+        bool CompileDXRLibrary(const std::wstring& sourcePath, uint32_t features, ID3DBlob** shader);
 
         // Compile compute shader using D3DCompile
         bool CompileComputeShader(const std::wstring& sourcePath, const std::wstring& entryPoint, ID3DBlob** shader);
@@ -151,7 +167,27 @@ namespace RayTraceVS::DXEngine
         // Registered shader definitions
         std::unordered_map<std::wstring, ShaderDefinition> shaderDefinitions;
 
+        // Variants keyed by variant name (see GetShaderVariantName); added while jobs run
+        std::unordered_map<std::wstring, ShaderDefinition> variantDefinitions;
+        mutable std::mutex variantMutex;
+
+        // Source files and their hashes, snapshotted at Initialize
+        ShaderSourceGraph sourceGraph;
+
         // Status message for UI
         std::wstring statusMessage;
+
+        // Compile workers and the blobs they produced. Jobs call back into this
+        // object, so the queue is destroyed first (see ~ShaderCache).
+        std::unique_ptr<ShaderCompileQueue> compileQueue;
+        std::unordered_map<std::wstring, ComPtr<ID3DBlob>> compiledShaders;
+        std::atomic<int> precompiledCount{ 0 };
+
+        // Compile jobs run concurrently: metadata/shader_cache.json, the source graph,
+        // compiled blobs and the status message each have their own lock
+        mutable std::mutex metadataMutex;
+        std::mutex sourceGraphMutex;
+        std::mutex compiledShadersMutex;
+        mutable std::mutex statusMutex;
     };
 }
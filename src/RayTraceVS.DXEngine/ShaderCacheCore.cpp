@@ -0,0 +1,1169 @@
+#include "ShaderCacheCore.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        bool ReadWholeFile(const std::filesystem::path& path, std::string& out)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open())
+                return false;
+
+            out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return !file.bad();
+        }
+    }
+
+    namespace
+    {
+        static constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+        void AppendUtf8(std::string& out, uint32_t cp)
+        {
+            if (cp < 0x80)
+            {
+                out += static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+
+        void AppendWide(std::wstring& out, uint32_t cp)
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (cp >= 0x10000)
+                {
+                    cp -= 0x10000;
+                    out += static_cast<wchar_t>(0xD800 + (cp >> 10));
+                    out += static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+                    return;
+                }
+            }
+            out += static_cast<wchar_t>(cp);
+        }
+    }
+
+    // Explicit conversions: std::filesystem::path would go through the C locale for
+    // wide strings on POSIX and throw on anything outside it. wchar_t is UTF-16 on
+    // Windows and UTF-32 elsewhere; invalid input becomes U+FFFD.
+    std::string ToUtf8(const std::wstring& ws)
+    {
+        std::string out;
+        out.reserve(ws.size());
+        for (size_t i = 0; i < ws.size(); i++)
+        {
+            uint32_t cp = static_cast<uint32_t>(ws[i]);
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < ws.size() &&
+                static_cast<uint32_t>(ws[i + 1]) >= 0xDC00 && static_cast<uint32_t>(ws[i + 1]) <= 0xDFFF)
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<uint32_t>(ws[++i]) - 0xDC00);
+            }
+            else if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+            {
+                cp = REPLACEMENT_CHARACTER;
+            }
+            AppendUtf8(out, cp);
+        }
+        return out;
+    }
+
+    std::wstring FromUtf8(const std::string& s)
+    {
+        std::wstring out;
+        out.reserve(s.size());
+        size_t i = 0;
+        while (i < s.size())
+        {
+            const uint8_t lead = static_cast<uint8_t>(s[i]);
+            uint32_t cp;
+            size_t length;
+            if (lead < 0x80)       { cp = lead;        length = 1; }
+            else if (lead >= 0xF8) { cp = REPLACEMENT_CHARACTER; length = 1; }
+            else if (lead >= 0xF0) { cp = lead & 0x07; length = 4; }
+            else if (lead >= 0xE0) { cp = lead & 0x0F; length = 3; }
+            else if (lead >= 0xC0) { cp = lead & 0x1F; length = 2; }
+            else                   { cp = REPLACEMENT_CHARACTER; length = 1; }     // Stray continuation byte
+
+            size_t consumed = 1;
+            for (; consumed < length && i + consumed < s.size(); consumed++)
+            {
+                const uint8_t next = static_cast<uint8_t>(s[i + consumed]);
+                if ((next & 0xC0) != 0x80)
+                    break;
+                cp = (cp << 6) | (next & 0x3F);
+            }
+
+            static constexpr uint32_t MIN_FOR_LENGTH[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+            if (consumed < length || cp < MIN_FOR_LENGTH[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+                cp = REPLACEMENT_CHARACTER;     // Truncated, overlong or not a scalar value
+            AppendWide(out, cp);
+            i += consumed;
+        }
+        return out;
+    }
+
+    // ============================================
+    // SHA-256
+    // ============================================
+
+    namespace
+    {
+        static constexpr uint32_t SHA256_K[64] =
+        {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        inline uint32_t RotateRight(uint32_t x, uint32_t n)
+        {
+            return (x >> n) | (x << (32 - n));
+        }
+    }
+
+    Sha256::Sha256()
+    {
+        Reset();
+    }
+
+    void Sha256::Reset()
+    {
+        state[0] = 0x6a09e667;
+        state[1] = 0xbb67ae85;
+        state[2] = 0x3c6ef372;
+        state[3] = 0xa54ff53a;
+        state[4] = 0x510e527f;
+        state[5] = 0x9b05688c;
+        state[6] = 0x1f83d9ab;
+        state[7] = 0x5be0cd19;
+        totalBytes = 0;
+        bufferSize = 0;
+    }
+
+    void Sha256::Transform(const uint8_t* block)
+    {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+        {
+            w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+                   (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+                   static_cast<uint32_t>(block[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t S1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + S1 + ch + SHA256_K[i] + w[i];
+            uint32_t S0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = S0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    void Sha256::Update(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        totalBytes += size;
+
+        if (bufferSize > 0)
+        {
+            size_t take = (std::min)(size, sizeof(buffer) - bufferSize);
+            memcpy(buffer + bufferSize, bytes, take);
+            bufferSize += take;
+            bytes += take;
+            size -= take;
+            if (bufferSize < sizeof(buffer))
+                return;
+            Transform(buffer);
+            bufferSize = 0;
+        }
+
+        while (size >= sizeof(buffer))
+        {
+            Transform(bytes);
+            bytes += sizeof(buffer);
+            size -= sizeof(buffer);
+        }
+
+        if (size > 0)
+        {
+            memcpy(buffer, bytes, size);
+            bufferSize = size;
+        }
+    }
+
+    std::string Sha256::FinishHex()
+    {
+        uint64_t bitLength = totalBytes * 8;
+
+        // Padding: 0x80, zeros up to 56 mod 64, then the big-endian bit length
+        uint8_t padding[72] = { 0x80 };
+        size_t padLength = (bufferSize < 56) ? (56 - bufferSize) : (120 - bufferSize);
+        for (int i = 0; i < 8; i++)
+        {
+            padding[padLength + i] = static_cast<uint8_t>(bitLength >> (56 - i * 8));
+        }
+        Update(padding, padLength + 8);
+
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+        std::string hex(64, '0');
+        for (int i = 0; i < 8; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                uint8_t byte = static_cast<uint8_t>(state[i] >> (24 - j * 8));
+                hex[(i * 4 + j) * 2] = HEX_DIGITS[byte >> 4];
+                hex[(i * 4 + j) * 2 + 1] = HEX_DIGITS[byte & 0x0F];
+            }
+        }
+        return hex;
+    }
+
+    std::string Sha256::HashHex(const void* data, size_t size)
+    {
+        Sha256 sha;
+        sha.Update(data, size);
+        return sha.FinishHex();
+    }
+
+    std::string Sha256::HashFileHex(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return "";
+
+        Sha256 sha;
+        char chunk[64 * 1024];
+        while (file)
+        {
+            file.read(chunk, sizeof(chunk));
+            std::streamsize got = file.gcount();
+            if (got > 0)
+                sha.Update(chunk, static_cast<size_t>(got));
+        }
+        if (file.bad())
+            return "";
+        return sha.FinishHex();
+    }
+
+    // ============================================
+    // JSON
+    // ============================================
+
+    JsonValue::JsonValue() : type(Type::Null) {}
+    JsonValue::JsonValue(bool value) : type(Type::Bool), boolValue(value) {}
+    JsonValue::JsonValue(int value) : type(Type::Number), text(std::to_string(value)) {}
+    JsonValue::JsonValue(int64_t value) : type(Type::Number), text(std::to_string(value)) {}
+    JsonValue::JsonValue(uint64_t value) : type(Type::Number), text(std::to_string(value)) {}
+    JsonValue::JsonValue(const char* value) : type(Type::String), text(value ? value : "") {}
+    JsonValue::JsonValue(const std::string& value) : type(Type::String), text(value) {}
+
+    JsonValue::JsonValue(double value) : type(Type::Number)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        text = buffer;
+    }
+
+    JsonValue JsonValue::MakeArray()
+    {
+        JsonValue value;
+        value.type = Type::Array;
+        return value;
+    }
+
+    JsonValue JsonValue::MakeObject()
+    {
+        JsonValue value;
+        value.type = Type::Object;
+        return value;
+    }
+
+    bool JsonValue::AsBool(bool fallback) const
+    {
+        return type == Type::Bool ? boolValue : fallback;
+    }
+
+    double JsonValue::AsDouble(double fallback) const
+    {
+        return type == Type::Number ? strtod(text.c_str(), nullptr) : fallback;
+    }
+
+    int64_t JsonValue::AsInt64(int64_t fallback) const
+    {
+        if (type != Type::Number)
+            return fallback;
+        if (text.find_first_of(".eE") != std::string::npos)
+            return static_cast<int64_t>(AsDouble());
+        return strtoll(text.c_str(), nullptr, 10);
+    }
+
+    uint64_t JsonValue::AsUInt64(uint64_t fallback) const
+    {
+        if (type != Type::Number || text.empty() || text[0] == '-')
+            return fallback;
+        if (text.find_first_of(".eE") != std::string::npos)
+            return static_cast<uint64_t>(AsDouble());
+        return strtoull(text.c_str(), nullptr, 10);
+    }
+
+    const std::string& JsonValue::AsString() const
+    {
+        static const std::string empty;
+        return type == Type::String ? text : empty;
+    }
+
+    size_t JsonValue::Size() const
+    {
+        if (type == Type::Array)
+            return elements.size();
+        if (type == Type::Object)
+            return members.size();
+        return 0;
+    }
+
+    const JsonValue& JsonValue::At(size_t index) const
+    {
+        static const JsonValue null;
+        return (type == Type::Array && index < elements.size()) ? elements[index] : null;
+    }
+
+    void JsonValue::Append(JsonValue value)
+    {
+        if (type == Type::Null)
+            type = Type::Array;
+        if (type == Type::Array)
+            elements.push_back(std::move(value));
+    }
+
+    const std::vector<JsonMember>& JsonValue::Members() const
+    {
+        return members;
+    }
+
+    const JsonValue* JsonValue::Find(const std::string& key) const
+    {
+        if (type != Type::Object)
+            return nullptr;
+        for (const auto& member : members)
+        {
+            if (member.key == key)
+                return &member.value;
+        }
+        return nullptr;
+    }
+
+    JsonValue& JsonValue::Set(const std::string& key, JsonValue value)
+    {
+        if (type == Type::Null)
+            type = Type::Object;
+        for (auto& member : members)
+        {
+            if (member.key == key)
+            {
+                member.value = std::move(value);
+                return member.value;
+            }
+        }
+        members.push_back({ key, std::move(value) });
+        return members.back().value;
+    }
+
+    namespace
+    {
+        void AppendEscaped(std::string& out, const std::string& s)
+        {
+            out += '"';
+            for (unsigned char c : s)
+            {
+                switch (c)
+                {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\b': out += "\\b"; break;
+                    case '\f': out += "\\f"; break;
+                    default:
+                        if (c < 0x20)
+                        {
+                            char escape[8];
+                            snprintf(escape, sizeof(escape), "\\u%04x", c);
+                            out += escape;
+                        }
+                        else
+                        {
+                            out += static_cast<char>(c);
+                        }
+                        break;
+                }
+            }
+            out += '"';
+        }
+
+        void AppendNewline(std::string& out, int indent, int depth)
+        {
+            if (indent < 0)
+                return;
+            out += '\n';
+            out.append(static_cast<size_t>(indent) * depth, ' ');
+        }
+    }
+
+    void JsonValue::SerializeTo(std::string& out, int indent, int depth) const
+    {
+        switch (type)
+        {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += boolValue ? "true" : "false";
+            break;
+        case Type::Number:
+            out += text;
+            break;
+        case Type::String:
+            AppendEscaped(out, text);
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < elements.size(); i++)
+            {
+                if (i > 0)
+                    out += ',';
+                AppendNewline(out, indent, depth + 1);
+                elements[i].SerializeTo(out, indent, depth + 1);
+            }
+            if (!elements.empty())
+                AppendNewline(out, indent, depth);
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < members.size(); i++)
+            {
+                if (i > 0)
+                    out += ',';
+                AppendNewline(out, indent, depth + 1);
+                AppendEscaped(out, members[i].key);
+                out += indent < 0 ? ":" : ": ";
+                members[i].value.SerializeTo(out, indent, depth + 1);
+            }
+            if (!members.empty())
+                AppendNewline(out, indent, depth);
+            out += '}';
+            break;
+        }
+    }
+
+    std::string JsonValue::Serialize(int indent) const
+    {
+        std::string out;
+        SerializeTo(out, indent, 0);
+        return out;
+    }
+
+    // Recursive descent parser (RFC 8259)
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& input) : text(input) {}
+
+        bool ParseDocument(JsonValue& out)
+        {
+            SkipWhitespace();
+            if (!ParseValue(out, 0))
+                return false;
+            SkipWhitespace();
+            if (pos != text.size())
+                return Fail("Unexpected trailing characters");
+            return true;
+        }
+
+        std::string GetError() const
+        {
+            return error + " at offset " + std::to_string(pos);
+        }
+
+    private:
+        static constexpr int MAX_DEPTH = 256;
+
+        bool Fail(const char* message)
+        {
+            if (error.empty())
+                error = message;
+            return false;
+        }
+
+        void SkipWhitespace()
+        {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                pos++;
+        }
+
+        bool Consume(const char* literal)
+        {
+            size_t length = strlen(literal);
+            if (text.compare(pos, length, literal) != 0)
+                return false;
+            pos += length;
+            return true;
+        }
+
+        bool ParseValue(JsonValue& out, int depth)
+        {
+            if (depth > MAX_DEPTH)
+                return Fail("Nesting too deep");
+            if (pos >= text.size())
+                return Fail("Unexpected end of input");
+
+            char c = text[pos];
+            if (c == '{')
+                return ParseObject(out, depth);
+            if (c == '[')
+                return ParseArray(out, depth);
+            if (c == '"')
+            {
+                out = JsonValue();
+                out.type = JsonValue::Type::String;
+                return ParseString(out.text);
+            }
+            if (c == '-' || (c >= '0' && c <= '9'))
+                return ParseNumber(out);
+            if (Consume("true"))
+            {
+                out = JsonValue(true);
+                return true;
+            }
+            if (Consume("false"))
+            {
+                out = JsonValue(false);
+                return true;
+            }
+            if (Consume("null"))
+            {
+                out = JsonValue();
+                return true;
+            }
+            return Fail("Unexpected character");
+        }
+
+        bool ParseObject(JsonValue& out, int depth)
+        {
+            out = JsonValue::MakeObject();
+            pos++;  // '{'
+            SkipWhitespace();
+            if (pos < text.size() && text[pos] == '}')
+            {
+                pos++;
+                return true;
+            }
+
+            for (;;)
+            {
+                SkipWhitespace();
+                if (pos >= text.size() || text[pos] != '"')
+                    return Fail("Expected member name");
+
+                std::string key;
+                if (!ParseString(key))
+                    return false;
+
+                SkipWhitespace();
+                if (pos >= text.size() || text[pos] != ':')
+                    return Fail("Expected ':'");
+                pos++;
+                SkipWhitespace();
+
+                JsonValue value;
+                if (!ParseValue(value, depth + 1))
+                    return false;
+                out.Set(key, std::move(value));
+
+                SkipWhitespace();
+                if (pos < text.size() && text[pos] == ',')
+                {
+                    pos++;
+                    continue;
+                }
+                if (pos < text.size() && text[pos] == '}')
+                {
+                    pos++;
+                    return true;
+                }
+                return Fail("Expected ',' or '}'");
+            }
+        }
+
+        bool ParseArray(JsonValue& out, int depth)
+        {
+            out = JsonValue::MakeArray();
+            pos++;  // '['
+            SkipWhitespace();
+            if (pos < text.size() && text[pos] == ']')
+            {
+                pos++;
+                return true;
+            }
+
+            for (;;)
+            {
+                SkipWhitespace();
+                JsonValue value;
+                if (!ParseValue(value, depth + 1))
+                    return false;
+                out.elements.push_back(std::move(value));
+
+                SkipWhitespace();
+                if (pos < text.size() && text[pos] == ',')
+                {
+                    pos++;
+                    continue;
+                }
+                if (pos < text.size() && text[pos] == ']')
+                {
+                    pos++;
+                    return true;
+                }
+                return Fail("Expected ',' or ']'");
+            }
+        }
+
+        bool ParseNumber(JsonValue& out)
+        {
+            size_t start = pos;
+            if (text[pos] == '-')
+                pos++;
+
+            auto digits = [this]()
+            {
+                size_t begin = pos;
+                while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+                    pos++;
+                return pos > begin;
+            };
+
+            if (pos < text.size() && text[pos] == '0')
+                pos++;
+            else if (!digits())
+                return Fail("Invalid number");
+
+            if (pos < text.size() && text[pos] == '.')
+            {
+                pos++;
+                if (!digits())
+                    return Fail("Invalid number");
+            }
+            if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+            {
+                pos++;
+                if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+                    pos++;
+                if (!digits())
+                    return Fail("Invalid number");
+            }
+
+            out = JsonValue();
+            out.type = JsonValue::Type::Number;
+            out.text = text.substr(start, pos - start);
+            return true;
+        }
+
+        bool ParseHex4(uint32_t& value)
+        {
+            if (pos + 4 > text.size())
+                return Fail("Truncated \\u escape");
+            value = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = text[pos++];
+                value <<= 4;
+                if (c >= '0' && c <= '9') value |= c - '0';
+                else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+                else return Fail("Invalid \\u escape");
+            }
+            return true;
+        }
+
+        bool ParseString(std::string& out)
+        {
+            pos++;  // '"'
+            out.clear();
+            while (pos < text.size())
+            {
+                char c = text[pos++];
+                if (c == '"')
+                    return true;
+                if (static_cast<unsigned char>(c) < 0x20)
+                    return Fail("Control character in string");
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+
+                if (pos >= text.size())
+                    break;
+                char escape = text[pos++];
+                switch (escape)
+                {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t cp = 0;
+                        if (!ParseHex4(cp))
+                            return false;
+                        if (cp >= 0xD800 && cp <= 0xDBFF)
+                        {
+                            uint32_t low = 0;
+                            if (!Consume("\\u") || !ParseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+                                return Fail("Invalid surrogate pair");
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        else if (cp >= 0xDC00 && cp <= 0xDFFF)
+                        {
+                            return Fail("Invalid surrogate pair");
+                        }
+                        AppendUtf8(out, cp);
+                        break;
+                    }
+                    default:
+                        return Fail("Invalid escape");
+                }
+            }
+            return Fail("Unterminated string");
+        }
+
+        const std::string& text;
+        size_t pos = 0;
+        std::string error;
+    };
+
+    bool JsonValue::Parse(const std::string& text, JsonValue& out, std::string* error)
+    {
+        JsonParser parser(text);
+        JsonValue result;
+        if (!parser.ParseDocument(result))
+        {
+            if (error)
+                *error = parser.GetError();
+            return false;
+        }
+        out = std::move(result);
+        return true;
+    }
+
+    // ============================================
+    // Cache metadata
+    // ============================================
+
+    bool ParseCacheMetadata(const std::string& json, CacheMetadata& out, std::string* error)
+    {
+        JsonValue root;
+        if (!JsonValue::Parse(json, root, error))
+            return false;
+        if (!root.IsObject())
+        {
+            if (error)
+                *error = "Metadata root is not an object";
+            return false;
+        }
+
+        CacheMetadata result;
+        const JsonValue* version = root.Find("version");
+        result.version = static_cast<int>(version ? version->AsInt64(1) : 1);
+        if (const JsonValue* driver = root.Find("driverVersion"))
+            result.driverVersion = driver->AsString();
+        if (const JsonValue* luid = root.Find("adapterLUID"))
+            result.adapterLUID = luid->AsUInt64();
+
+        if (const JsonValue* shaders = root.Find("shaders"))
+        {
+            for (const auto& shader : shaders->Members())
+            {
+                ShaderCacheInfo info;
+                if (const JsonValue* sourceHash = shader.value.Find("sourceHash"))
+                    info.sourceHash = sourceHash->AsString();
+                if (const JsonValue* compiledAt = shader.value.Find("compiledAt"))
+                    info.compiledAt = compiledAt->AsString();
+                if (const JsonValue* dependencies = shader.value.Find("dependencies"))
+                {
+                    for (const auto& dep : dependencies->Members())
+                    {
+                        info.dependencies.push_back({ FromUtf8(dep.key), dep.value.AsString() });
+                    }
+                }
+                result.shaders[FromUtf8(shader.key)] = std::move(info);
+            }
+        }
+
+        out = std::move(result);
+        return true;
+    }
+
+    std::string SerializeCacheMetadata(const CacheMetadata& metadata)
+    {
+        // Sorted so that unchanged caches produce identical files
+        std::vector<const std::pair<const std::wstring, ShaderCacheInfo>*> entries;
+        entries.reserve(metadata.shaders.size());
+        for (const auto& entry : metadata.shaders)
+            entries.push_back(&entry);
+        std::sort(entries.begin(), entries.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+
+        JsonValue shaders = JsonValue::MakeObject();
+        for (const auto* entry : entries)
+        {
+            const ShaderCacheInfo& info = entry->second;
+
+            JsonValue dependencies = JsonValue::MakeObject();
+            for (const auto& dep : info.dependencies)
+                dependencies.Set(ToUtf8(dep.filename), dep.hash);
+
+            JsonValue shader = JsonValue::MakeObject();
+            shader.Set("sourceHash", info.sourceHash);
+            shader.Set("compiledAt", info.compiledAt);
+            shader.Set("dependencies", std::move(dependencies));
+            shaders.Set(ToUtf8(entry->first), std::move(shader));
+        }
+
+        JsonValue root = JsonValue::MakeObject();
+        root.Set("version", metadata.version);
+        root.Set("driverVersion", metadata.driverVersion);
+        root.Set("adapterLUID", metadata.adapterLUID);
+        root.Set("shaders", std::move(shaders));
+        return root.Serialize(2) + "\n";
+    }
+
+    // ============================================
+    // #include graph
+    // ============================================
+
+    void ExtractIncludes(const std::string& source, std::vector<std::pair<std::string, bool>>& outIncludes)
+    {
+        const size_t length = source.size();
+        bool inBlockComment = false;
+        bool atLineStart = true;    // Only whitespace (or comments) seen since the last newline
+        size_t i = 0;
+
+        while (i < length)
+        {
+            char c = source[i];
+
+            if (inBlockComment)
+            {
+                if (c == '*' && i + 1 < length && source[i + 1] == '/')
+                {
+                    inBlockComment = false;
+                    i += 2;
+                    continue;
+                }
+                if (c == '\n')
+                    atLineStart = true;
+                i++;
+                continue;
+            }
+
+            if (c == '\n')
+            {
+                atLineStart = true;
+                i++;
+                continue;
+            }
+            if (c == ' ' || c == '\t' || c == '\r')
+            {
+                i++;
+                continue;
+            }
+            if (c == '/' && i + 1 < length && source[i + 1] == '*')
+            {
+                inBlockComment = true;
+                i += 2;
+                continue;
+            }
+            if (c == '/' && i + 1 < length && source[i + 1] == '/')
+            {
+                while (i < length && source[i] != '\n')
+                    i++;
+                continue;
+            }
+
+            if (c == '#' && atLineStart)
+            {
+                size_t p = i + 1;
+                while (p < length && (source[p] == ' ' || source[p] == '\t'))
+                    p++;
+                if (source.compare(p, 7, "include") == 0)
+                {
+                    p += 7;
+                    while (p < length && (source[p] == ' ' || source[p] == '\t'))
+                        p++;
+                    if (p < length && (source[p] == '"' || source[p] == '<'))
+                    {
+                        char close = source[p] == '"' ? '"' : '>';
+                        size_t end = source.find_first_of(std::string(1, close) + "\n", p + 1);
+                        if (end != std::string::npos && source[end] == close && end > p + 1)
+                        {
+                            outIncludes.emplace_back(source.substr(p + 1, end - p - 1), close == '"');
+                        }
+                    }
+                }
+            }
+
+            // Rest of the line is not a directive start; string literals containing "//" or
+            // "/*" are not expected in shader sources
+            atLineStart = false;
+            i++;
+        }
+    }
+
+    void ShaderSourceGraph::SetIncludeDirectories(std::vector<Path> directories)
+    {
+        includeDirs = std::move(directories);
+    }
+
+    void ShaderSourceGraph::Clear()
+    {
+        nodes.clear();
+    }
+
+    ShaderSourceGraph::Path ShaderSourceGraph::Normalize(const Path& file)
+    {
+        std::error_code ec;
+        Path absolute = std::filesystem::absolute(file, ec);
+        return (ec ? file : absolute).lexically_normal();
+    }
+
+    bool ShaderSourceGraph::ResolveInclude(const Path& includingDir, const std::string& name, bool quoted, Path& resolved) const
+    {
+        Path relative = std::filesystem::path(std::u8string(name.begin(), name.end()));
+        std::error_code ec;
+
+        if (quoted)
+        {
+            Path candidate = includingDir / relative;
+            if (std::filesystem::is_regular_file(candidate, ec))
+            {
+                resolved = Normalize(candidate);
+                return true;
+            }
+        }
+
+        for (const auto& dir : includeDirs)
+        {
+            Path candidate = dir / relative;
+            if (std::filesystem::is_regular_file(candidate, ec))
+            {
+                resolved = Normalize(candidate);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ShaderSourceGraph::FileNode ShaderSourceGraph::ReadNode(const Path& file) const
+    {
+        FileNode node;
+        std::string content;
+        try
+        {
+            if (!ReadWholeFile(file, content))
+                return node;
+
+            node.hash = Sha256::HashHex(content.data(), content.size());
+
+            std::vector<std::pair<std::string, bool>> includes;
+            ExtractIncludes(content, includes);
+
+            Path includingDir = file.parent_path();
+            for (const auto& [name, quoted] : includes)
+            {
+                // Unresolved includes are left to the compiler to report
+                Path resolved;
+                if (ResolveInclude(includingDir, name, quoted, resolved))
+                    node.includes.push_back(resolved.native());
+            }
+        }
+        catch (...)
+        {
+            node = FileNode();
+        }
+        return node;
+    }
+
+    void ShaderSourceGraph::Scan(const std::vector<Path>& roots)
+    {
+        std::vector<Path> frontier;
+        std::unordered_set<Path::string_type> queued;
+        for (const auto& root : roots)
+        {
+            Path normalized = Normalize(root);
+            if (nodes.find(normalized.native()) == nodes.end() && queued.insert(normalized.native()).second)
+                frontier.push_back(std::move(normalized));
+        }
+
+        while (!frontier.empty())
+        {
+            std::vector<FileNode> results(frontier.size());
+            ParallelFor(frontier.size(), [&](size_t i) { results[i] = ReadNode(frontier[i]); });
+
+            std::vector<Path> next;
+            for (size_t i = 0; i < frontier.size(); i++)
+            {
+                for (const auto& include : results[i].includes)
+                {
+                    if (nodes.find(include) == nodes.end() && queued.insert(include).second)
+                        next.emplace_back(include);
+                }
+                nodes[frontier[i].native()] = std::move(results[i]);
+            }
+            frontier = std::move(next);
+        }
+    }
+
+    bool ShaderSourceGraph::Contains(const Path& file) const
+    {
+        return nodes.find(Normalize(file).native()) != nodes.end();
+    }
+
+    std::string ShaderSourceGraph::GetHash(const Path& file) const
+    {
+        auto it = nodes.find(Normalize(file).native());
+        return it != nodes.end() ? it->second.hash : std::string();
+    }
+
+    std::vector<ShaderSourceGraph::Path> ShaderSourceGraph::GetDependencies(const Path& root) const
+    {
+        Path::string_type rootKey = Normalize(root).native();
+        std::unordered_set<Path::string_type> visited{ rootKey };
+        std::vector<Path::string_type> stack{ rootKey };
+        std::vector<Path> dependencies;
+
+        while (!stack.empty())
+        {
+            Path::string_type current = std::move(stack.back());
+            stack.pop_back();
+
+            auto it = nodes.find(current);
+            if (it == nodes.end())
+                continue;
+
+            for (const auto& include : it->second.includes)
+            {
+                if (visited.insert(include).second)
+                {
+                    dependencies.emplace_back(include);
+                    stack.push_back(include);
+                }
+            }
+        }
+
+        std::sort(dependencies.begin(), dependencies.end());
+        return dependencies;
+    }
+
+    // ============================================
+    // Validation
+    // ============================================
+
+    bool IsCacheEntryCurrent(const ShaderCacheInfo& cached,
+                             const std::string& sourceHash,
+                             const std::vector<ShaderDependency>& dependencies,
+                             std::string* reason)
+    {
+        auto setReason = [reason](const std::string& text)
+        {
+            if (reason)
+                *reason = text;
+            return false;
+        };
+
+        // An empty hash means the file could not be read - never trust the cache then
+        if (sourceHash.empty())
+            return setReason("source unreadable");
+        if (sourceHash != cached.sourceHash)
+            return setReason("source changed");
+
+        if (dependencies.size() != cached.dependencies.size())
+            return setReason("dependency set changed");
+
+        for (const auto& dep : dependencies)
+        {
+            if (dep.hash.empty())
+                return setReason("dependency unreadable: " + ToUtf8(dep.filename));
+
+            auto it = std::find_if(cached.dependencies.begin(), cached.dependencies.end(),
+                [&dep](const ShaderDependency& c) { return c.filename == dep.filename; });
+            if (it == cached.dependencies.end())
+                return setReason("new dependency: " + ToUtf8(dep.filename));
+            if (it->hash != dep.hash)
+                return setReason("dependency changed: " + ToUtf8(dep.filename));
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ============================================
+// Shader cache core
+// ============================================
+//
+// Platform-independent part of the shader cache: hashing, metadata (de)serialization,
+// #include graph discovery and cache entry validation. Uses only the standard library
+// so it can be built and exercised without D3D / Windows headers.
+
+namespace RayTraceVS::DXEngine
+{
+    // Shader dependency information
+    struct ShaderDependency
+    {
+        std::wstring filename;  // Relative to the shader source directory
+        std::string hash;
+    };
+
+    // Per-shader cache information
+    struct ShaderCacheInfo
+    {
+        std::string sourceHash;
+        std::vector<ShaderDependency> dependencies;
+        std::string compiledAt;
+    };
+
+    // Cache metadata structure
+    struct CacheMetadata
+    {
+        // 2: dependencies discovered from the #include graph (compute shaders included)
+        static constexpr int CURRENT_VERSION = 2;
+
+        int version = CURRENT_VERSION;
+        std::string driverVersion;
+        uint64_t adapterLUID = 0;
+        std::unordered_map<std::wstring, ShaderCacheInfo> shaders;
+    };
+
+    // UTF-8 <-> wide string conversion
+    std::string ToUtf8(const std::wstring& ws);
+    std::wstring FromUtf8(const std::string& s);
+
+    // ============================================
+    // SHA-256 (FIPS 180-4)
+    // ============================================
+    class Sha256
+    {
+    public:
+        Sha256();
+
+        void Update(const void* data, size_t size);
+        // Finalizes the digest and returns it as lowercase hex. The object must be Reset() before reuse.
+        std::string FinishHex();
+        void Reset();
+
+        static std::string HashHex(const void* data, size_t size);
+        // Returns an empty string if the file cannot be read
+        static std::string HashFileHex(const std::filesystem::path& path);
+
+    private:
+        void Transform(const uint8_t* block);
+
+        uint32_t state[8];
+        uint8_t buffer[64];
+        uint64_t totalBytes;
+        size_t bufferSize;
+    };
+
+    // ============================================
+    // JSON
+    // ============================================
+    struct JsonMember;
+
+    // Minimal JSON DOM. Numbers keep their source text so 64-bit integers round-trip
+    // exactly; object members keep insertion order.
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        JsonValue();
+        JsonValue(bool value);
+        JsonValue(int value);
+        JsonValue(int64_t value);
+        JsonValue(uint64_t value);
+        JsonValue(double value);
+        JsonValue(const char* value);
+        JsonValue(const std::string& value);
+
+        static JsonValue MakeArray();
+        static JsonValue MakeObject();
+
+        Type GetType() const { return type; }
+        bool IsNull() const { return type == Type::Null; }
+        bool IsNumber() const { return type == Type::Number; }
+        bool IsString() const { return type == Type::String; }
+        bool IsArray() const { return type == Type::Array; }
+        bool IsObject() const { return type == Type::Object; }
+
+        // Typed accessors return the fallback when the value has a different type
+        bool AsBool(bool fallback = false) const;
+        double AsDouble(double fallback = 0.0) const;
+        int64_t AsInt64(int64_t fallback = 0) const;
+        uint64_t AsUInt64(uint64_t fallback = 0) const;
+        const std::string& AsString() const;
+
+        // Array access
+        size_t Size() const;
+        const JsonValue& At(size_t index) const;
+        void Append(JsonValue value);
+
+        // Object access
+        const std::vector<JsonMember>& Members() const;
+        const JsonValue* Find(const std::string& key) const;
+        // Inserts (or replaces) a member; converts a null value into an object
+        JsonValue& Set(const std::string& key, JsonValue value);
+
+        // Returns false and fills error (with the byte offset) on malformed input
+        static bool Parse(const std::string& text, JsonValue& out, std::string* error = nullptr);
+        // indent < 0 writes compact JSON
+        std::string Serialize(int indent = 2) const;
+
+    private:
+        friend class JsonParser;
+        void SerializeTo(std::string& out, int indent, int depth) const;
+
+        Type type;
+        bool boolValue = false;
+        std::string text;                   // String value, or number literal
+        std::vector<JsonValue> elements;
+        std::vector<JsonMember> members;
+    };
+
+    struct JsonMember
+    {
+        std::string key;
+        JsonValue value;
+    };
+
+    // shader_cache.json <-> CacheMetadata
+    bool ParseCacheMetadata(const std::string& json, CacheMetadata& out, std::string* error = nullptr);
+    std::string SerializeCacheMetadata(const CacheMetadata& metadata);
+
+    // ============================================
+    // #include graph
+    // ============================================
+    //
+    // Reads each source file once, hashing it and extracting its #include directives.
+    // Includes are resolved relative to the including file first, then against the
+    // include directories (same order as DXC/FXC). Files are processed breadth-first,
+    // each level in parallel. Conditional compilation is ignored, so the dependency set
+    // is a superset of what the compiler actually opens.
+    class ShaderSourceGraph
+    {
+    public:
+        using Path = std::filesystem::path;
+
+        void SetIncludeDirectories(std::vector<Path> directories);
+
+        // Scans roots and every file reachable from them. Already scanned files are not read again.
+        void Scan(const std::vector<Path>& roots);
+        void Clear();
+
+        bool Contains(const Path& file) const;
+        // SHA-256 of a scanned file; empty if the file was unreadable or not scanned
+        std::string GetHash(const Path& file) const;
+        // All files transitively included by root (root excluded), sorted by path
+        std::vector<Path> GetDependencies(const Path& root) const;
+        size_t GetFileCount() const { return nodes.size(); }
+
+        // Normalized absolute form used as graph key
+        static Path Normalize(const Path& file);
+
+    private:
+        struct FileNode
+        {
+            std::string hash;
+            std::vector<Path::string_type> includes;  // Resolved, normalized
+        };
+
+        FileNode ReadNode(const Path& file) const;
+        bool ResolveInclude(const Path& includingDir, const std::string& name, bool quoted, Path& resolved) const;
+
+        std::vector<Path> includeDirs;
+        std::unordered_map<Path::string_type, FileNode> nodes;
+    };
+
+    // Extracts #include targets as (name, quoted) pairs; commented-out directives are skipped
+    void ExtractIncludes(const std::string& source, std::vector<std::pair<std::string, bool>>& outIncludes);
+
+    // Compares a cache entry against the current sources. On mismatch returns false and
+    // describes the first difference in reason.
+    bool IsCacheEntryCurrent(const ShaderCacheInfo& cached,
+                             const std::string& sourceHash,
+                             const std::vector<ShaderDependency>& dependencies,
+                             std::string* reason = nullptr);
+}
@@ -0,0 +1,202 @@
+#include "ShaderCompileQueue.h"
+#include <algorithm>
+
+namespace RayTraceVS::DXEngine
+{
+    ShaderCompileQueue::ShaderCompileQueue(unsigned int workerCount)
+    {
+        if (workerCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        workers.reserve(workerCount);
+        for (unsigned int i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ShaderCompileQueue::~ShaderCompileQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+        }
+        workAvailable.notify_all();
+
+        for (auto& worker : workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    bool ShaderCompileQueue::Submit(const std::wstring& name, Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || entries.find(name) != entries.end())
+                return false;
+
+            auto entry = std::make_shared<Entry>();
+            entry->job = std::move(job);
+            entries[name] = entry;
+            pending.push_back(std::move(entry));
+        }
+        workAvailable.notify_one();
+        return true;
+    }
+
+    bool ShaderCompileQueue::Contains(const std::wstring& name) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.find(name) != entries.end();
+    }
+
+    bool ShaderCompileQueue::IsFinished(const std::wstring& name) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(name);
+        return it != entries.end() && it->second->state == JobState::Finished;
+    }
+
+    void ShaderCompileQueue::Run(const std::shared_ptr<Entry>& entry, std::unique_lock<std::mutex>& lock)
+    {
+        Job job = std::move(entry->job);
+        lock.unlock();
+
+        bool result = false;
+        try
+        {
+            result = job();
+        }
+        catch (...)
+        {
+            result = false;
+        }
+
+        lock.lock();
+        entry->result = result;
+        entry->state = JobState::Finished;
+        finishedCount++;
+        jobFinished.notify_all();
+    }
+
+    void ShaderCompileQueue::WaitFinishedLocked(const std::shared_ptr<Entry>& entry, std::unique_lock<std::mutex>& lock)
+    {
+        if (entry->state == JobState::Pending)
+        {
+            // Nobody has started it - run it here rather than queueing behind other jobs
+            entry->state = JobState::Running;
+            Run(entry, lock);
+            return;
+        }
+
+        jobFinished.wait(lock, [&entry]() { return entry->state == JobState::Finished; });
+    }
+
+    bool ShaderCompileQueue::Wait(const std::wstring& name)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = entries.find(name);
+        if (it == entries.end())
+            return false;
+
+        std::shared_ptr<Entry> entry = it->second;
+        WaitFinishedLocked(entry, lock);
+        return entry->result;
+    }
+
+    bool ShaderCompileQueue::WaitAll()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Snapshot: entries may be forgotten or added while the lock is released
+        std::vector<std::shared_ptr<Entry>> snapshot;
+        snapshot.reserve(entries.size());
+        for (const auto& [name, entry] : entries)
+            snapshot.push_back(entry);
+
+        bool allSucceeded = true;
+        for (const auto& entry : snapshot)
+        {
+            WaitFinishedLocked(entry, lock);
+            allSucceeded = allSucceeded && entry->result;
+        }
+        return allSucceeded;
+    }
+
+    void ShaderCompileQueue::Forget(const std::wstring& name)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = entries.find(name);
+        if (it == entries.end())
+            return;
+
+        std::shared_ptr<Entry> entry = it->second;
+        WaitFinishedLocked(entry, lock);
+
+        // The name may have been forgotten and resubmitted while unlocked
+        it = entries.find(name);
+        if (it != entries.end() && it->second == entry)
+        {
+            entries.erase(it);
+            finishedCount--;
+        }
+    }
+
+    void ShaderCompileQueue::ForgetAll()
+    {
+        WaitAll();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second->state == JobState::Finished)
+            {
+                it = entries.erase(it);
+                finishedCount--;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    size_t ShaderCompileQueue::GetSubmittedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    size_t ShaderCompileQueue::GetFinishedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return finishedCount;
+    }
+
+    void ShaderCompileQueue::WorkerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            workAvailable.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (stopping)
+                return;
+
+            std::shared_ptr<Entry> entry = std::move(pending.front());
+            pending.pop_front();
+
+            // Already taken over by a thread in Wait
+            if (entry->state != JobState::Pending)
+                continue;
+
+            entry->state = JobState::Running;
+            Run(entry, lock);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ============================================
+// Shader compile queue
+// ============================================
+//
+// Runs named, independent compile jobs (one per shader) on a pool of worker threads.
+// Consumers wait on the shaders they need, not on the whole batch: Wait(name) blocks
+// only until that job has finished, and if no worker has picked it up yet the waiting
+// thread runs it itself instead of sitting behind unrelated jobs.
+//
+// Standard library only - the jobs decide what "compile" means (DXC, FXC, cache load).
+
+namespace RayTraceVS::DXEngine
+{
+    class ShaderCompileQueue
+    {
+    public:
+        // Returns true on success. Must be safe to run on any thread.
+        using Job = std::function<bool()>;
+
+        // workerCount 0 = one per hardware thread, minus the thread that waits
+        explicit ShaderCompileQueue(unsigned int workerCount = 0);
+        // Drops jobs that have not started and joins the workers
+        ~ShaderCompileQueue();
+
+        ShaderCompileQueue(const ShaderCompileQueue&) = delete;
+        ShaderCompileQueue& operator=(const ShaderCompileQueue&) = delete;
+
+        // Queues job under name. Returns false (and keeps the existing job) if the name
+        // is already queued, running or finished - call Forget first to resubmit.
+        bool Submit(const std::wstring& name, Job job);
+
+        // True if a job with this name was submitted and not forgotten
+        bool Contains(const std::wstring& name) const;
+
+        // True once the named job has finished (successfully or not). Never blocks.
+        bool IsFinished(const std::wstring& name) const;
+
+        // Blocks until the named job has finished and returns its result.
+        // Returns false immediately for unknown names.
+        bool Wait(const std::wstring& name);
+
+        // Blocks until every submitted job has finished. Returns true if all succeeded.
+        bool WaitAll();
+
+        // Removes finished jobs so the names can be submitted again
+        // (waits for running ones first)
+        void Forget(const std::wstring& name);
+        void ForgetAll();
+
+        size_t GetSubmittedCount() const;
+        size_t GetFinishedCount() const;
+        unsigned int GetWorkerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+    private:
+        enum class JobState
+        {
+            Pending,
+            Running,
+            Finished
+        };
+
+        struct Entry
+        {
+            Job job;
+            JobState state = JobState::Pending;
+            bool result = false;
+        };
+
+        void WorkerLoop();
+        // Runs entry outside the lock and publishes the result. Caller has set it Running.
+        void Run(const std::shared_ptr<Entry>& entry, std::unique_lock<std::mutex>& lock);
+        void WaitFinishedLocked(const std::shared_ptr<Entry>& entry, std::unique_lock<std::mutex>& lock);
+
+        mutable std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable jobFinished;
+
+        std::unordered_map<std::wstring, std::shared_ptr<Entry>> entries;
+        std::deque<std::shared_ptr<Entry>> pending;     // May contain entries already taken by Wait
+        size_t finishedCount = 0;
+        bool stopping = false;
+
+        std::vector<std::thread> workers;
+    };
+}
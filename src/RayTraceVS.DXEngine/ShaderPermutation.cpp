@@ -0,0 +1,83 @@
+#include "ShaderPermutation.h"
+
+namespace RayTraceVS::DXEngine
+{
+    namespace
+    {
+        struct FeatureDefine
+        {
+            ShaderFeature feature;
+            const wchar_t* define;
+            const char* label;
+        };
+
+        // Order defines variant names - changing it renames cached variants
+        const FeatureDefine kFeatureDefines[] = {
+            { ShaderFeature_Dof,         L"DOF",          "DOF" },
+            { ShaderFeature_Caustics,    L"CAUSTICS",     "CAUSTICS" },
+            { ShaderFeature_PhotonDebug, L"PHOTON_DEBUG", "PHOTON_DEBUG" },
+            { ShaderFeature_Meshes,      L"HAS_MESHES",   "HAS_MESHES" },
+            { ShaderFeature_NrdOutput,   L"NRD_OUTPUT",   "NRD_OUTPUT" },
+        };
+    }
+
+    uint32_t SelectShaderFeatures(const ShaderFeatureInputs& inputs)
+    {
+        uint32_t features = ShaderFeature_None;
+
+        // Same threshold as RayGen.hlsl (dofEnabled)
+        if (inputs.apertureSize > 0.001f)
+            features |= ShaderFeature_Dof;
+        // RayGen only gathers when the photon pass produced photons
+        if (inputs.photonMapSize > 0)
+            features |= ShaderFeature_Caustics;
+        if (inputs.photonDebugMode != 0)
+            features |= ShaderFeature_PhotonDebug;
+        if (inputs.meshInstanceCount > 0)
+            features |= ShaderFeature_Meshes;
+        if (inputs.denoiserActive)
+            features |= ShaderFeature_NrdOutput;
+
+        return features;
+    }
+
+    std::vector<std::pair<std::wstring, std::wstring>> GetShaderFeatureDefines(uint32_t features)
+    {
+        std::vector<std::pair<std::wstring, std::wstring>> defines;
+        for (const auto& entry : kFeatureDefines)
+        {
+            if ((features & entry.feature) == 0)
+                defines.emplace_back(entry.define, L"0");
+        }
+        return defines;
+    }
+
+    std::wstring GetShaderVariantName(const std::wstring& shaderName, uint32_t features)
+    {
+        std::wstring name = shaderName;
+        for (const auto& entry : kFeatureDefines)
+        {
+            if ((features & entry.feature) == 0)
+            {
+                name += L"_";
+                name += entry.define;
+                name += L"0";
+            }
+        }
+        return name;
+    }
+
+    std::string DescribeShaderFeatures(uint32_t features)
+    {
+        std::string text;
+        for (const auto& entry : kFeatureDefines)
+        {
+            if ((features & entry.feature) == 0)
+                continue;
+            if (!text.empty())
+                text += "|";
+            text += entry.label;
+        }
+        return text.empty() ? "none" : text;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================
+// Shader permutations
+// ============================================
+//
+// RayGen is compiled in feature-specialized variants: features the current scene does
+// not use are compiled out by defining them to 0 (see "Feature Permutations" in
+// Common.hlsli). A variant is identified by the bit set of features it keeps; the
+// all-features variant is the default build and can render any scene.
+//
+// Standard library only, so the selection logic can be exercised without D3D.
+
+namespace RayTraceVS::DXEngine
+{
+    enum ShaderFeature : uint32_t
+    {
+        ShaderFeature_None        = 0,
+        ShaderFeature_Dof         = 1 << 0,     // DOF: thin-lens depth of field
+        ShaderFeature_Caustics    = 1 << 1,     // CAUSTICS: photon map gathering
+        ShaderFeature_PhotonDebug = 1 << 2,     // PHOTON_DEBUG: photon/material debug views
+        ShaderFeature_Meshes      = 1 << 3,     // HAS_MESHES: triangle mesh instances
+        ShaderFeature_NrdOutput   = 1 << 4,     // NRD_OUTPUT: denoiser G-buffer writes
+        ShaderFeature_All         = (1 << 5) - 1
+    };
+
+    // Per-frame state that decides which features RayGen has to keep
+    struct ShaderFeatureInputs
+    {
+        float apertureSize = 0.0f;      // Scene.ApertureSize
+        uint32_t photonMapSize = 0;     // Scene.PhotonMapSize after the photon pass
+        uint32_t photonDebugMode = 0;   // Scene.PhotonDebugMode
+        size_t meshInstanceCount = 0;
+        bool denoiserActive = false;    // NRD runs this frame and reads the G-buffer
+    };
+
+    // Smallest feature set that renders inputs identically to the full variant
+    uint32_t SelectShaderFeatures(const ShaderFeatureInputs& inputs);
+
+    // True if a variant keeping 'available' can render a frame that needs 'required'
+    inline bool IsShaderFeatureSuperset(uint32_t available, uint32_t required)
+    {
+        return (required & ~available) == 0;
+    }
+
+    // HLSL defines for a variant: one NAME=0 pair per disabled feature
+    // (enabled features keep the defaults from Common.hlsli)
+    std::vector<std::pair<std::wstring, std::wstring>> GetShaderFeatureDefines(uint32_t features);
+
+    // Cache/queue name of a variant: the plain shader name for the full variant (so it
+    // shares the default cache entry), otherwise the disabled features are appended,
+    // e.g. "RayGen_DOF0_NRD_OUTPUT0"
+    std::wstring GetShaderVariantName(const std::wstring& shaderName, uint32_t features);
+
+    // "DOF|CAUSTICS" style list of the enabled features, for logs
+    std::string DescribeShaderFeatures(uint32_t features);
+}
@@ -0,0 +1,120 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+namespace RayTraceVS::DXEngine
+{
+    WorkerPool::WorkerPool(unsigned int workerCount)
+    {
+        if (workerCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        workers.reserve(workerCount);
+        for (unsigned int i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+        }
+        workAvailable.notify_all();
+
+        for (auto& worker : workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    WorkerPool& WorkerPool::GetShared()
+    {
+        // Leaked on purpose: joining threads from static destructors can hang at process
+        // exit (e.g. during DLL unload), and the OS reclaims the threads anyway
+        static WorkerPool* shared = new WorkerPool();
+        return *shared;
+    }
+
+    unsigned int WorkerPool::GetWorkerCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<unsigned int>(workers.size());
+    }
+
+    void WorkerPool::Run(size_t taskCount, unsigned int maxThreads, const Task& task)
+    {
+        if (taskCount == 0)
+            return;
+
+        auto loop = std::make_shared<Loop>();
+        loop->task = &task;
+        loop->taskCount = taskCount;
+
+        size_t helpers = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (maxThreads > 0)
+            {
+                while (workers.size() + 1 < maxThreads)
+                    workers.emplace_back([this]() { WorkerLoop(); });
+                helpers = maxThreads - 1;
+            }
+            else
+            {
+                helpers = workers.size();
+            }
+            // The caller takes one index itself
+            helpers = (std::min)(helpers, taskCount - 1);
+            for (size_t i = 0; i < helpers; i++)
+                pending.push_back(loop);
+        }
+        if (helpers == 1)
+            workAvailable.notify_one();
+        else if (helpers > 1)
+            workAvailable.notify_all();
+
+        Work(*loop);
+
+        std::unique_lock<std::mutex> lock(loop->mutex);
+        loop->done.wait(lock, [&]() { return loop->finishedCount.load() == taskCount; });
+    }
+
+    void WorkerPool::Work(Loop& loop)
+    {
+        for (size_t index = loop.nextIndex++; index < loop.taskCount; index = loop.nextIndex++)
+        {
+            (*loop.task)(index);
+            if (++loop.finishedCount == loop.taskCount)
+            {
+                // Under the mutex, so the waiting caller cannot miss it between check and wait
+                std::lock_guard<std::mutex> lock(loop.mutex);
+                loop.done.notify_all();
+            }
+        }
+    }
+
+    void WorkerPool::WorkerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            workAvailable.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (stopping)
+                return;
+
+            // Entries of loops that have already finished just find no index left
+            std::shared_ptr<Loop> loop = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            Work(*loop);
+            lock.lock();
+        }
+    }
+}
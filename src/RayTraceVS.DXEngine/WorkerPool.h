@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================
+// Worker pool
+// ============================================
+//
+// Persistent worker threads shared by the engine's data-parallel loops (CPU path tracer
+// stages, instance transforms, shader cache scans), so a loop costs a wake-up rather than
+// a thread start per worker. The calling thread always works on its own loop too: a loop
+// finishes even when every worker is busy elsewhere, including a loop started from
+// inside another one.
+//
+// Standard library only.
+
+namespace RayTraceVS::DXEngine
+{
+    class WorkerPool
+    {
+    public:
+        // Must be safe to run on any thread and must not throw
+        using Task = std::function<void(size_t)>;
+
+        // workerCount 0 = one per hardware thread, minus the calling thread
+        explicit WorkerPool(unsigned int workerCount = 0);
+        // Joins the workers; every Run must have returned
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // Process-wide pool, started on first use and never torn down
+        static WorkerPool& GetShared();
+
+        // Runs task(index) for every index in [0, taskCount) on the calling thread and up
+        // to maxThreads - 1 workers (0 = all of them), and returns once all have finished.
+        // Indices are claimed in increasing order. The pool grows if maxThreads asks for
+        // more workers than it has.
+        void Run(size_t taskCount, unsigned int maxThreads, const Task& task);
+
+        unsigned int GetWorkerCount() const;
+
+    private:
+        struct Loop
+        {
+            const Task* task = nullptr;         // Only dereferenced while an index is unclaimed
+            size_t taskCount = 0;
+            std::atomic<size_t> nextIndex{ 0 };
+            std::atomic<size_t> finishedCount{ 0 };
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+
+        void WorkerLoop();
+        // Claims and runs indices until the loop has none left
+        static void Work(Loop& loop);
+
+        mutable std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::deque<std::shared_ptr<Loop>> pending;  // One entry per worker invited to a loop
+        bool stopping = false;
+
+        std::vector<std::thread> workers;
+    };
+
+    // Splits [0, count) into chunkCount fixed ranges (so per-chunk outputs can be merged in a
+    // deterministic order) and runs body(chunk, begin, end) on the shared pool with up to
+    // maxThreads threads (0 = all)
+    template<typename Body>
+    void ParallelChunks(size_t count, size_t chunkCount, unsigned int maxThreads, Body&& body)
+    {
+        if (count == 0 || chunkCount == 0)
+            return;
+
+        WorkerPool::GetShared().Run(chunkCount, maxThreads, [&](size_t chunk)
+        {
+            body(chunk, count * chunk / chunkCount, count * (chunk + 1) / chunkCount);
+        });
+    }
+
+    // Runs fn(i) for every i in [0, count) on the shared pool
+    template<typename Fn>
+    void ParallelFor(size_t count, Fn&& fn, unsigned int maxThreads = 0)
+    {
+        if (count == 0)
+            return;
+
+        WorkerPool::GetShared().Run(count, maxThreads, [&](size_t i) { fn(i); });
+    }
+}
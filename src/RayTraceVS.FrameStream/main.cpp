@@ -0,0 +1,313 @@
+// RayTraceVS.FrameStream - frame channel writer/viewer
+//
+// Standalone client of the shared-memory frame channel (FrameChannel): it needs neither
+// D3D nor the bridge, so the renderer/viewer transport can be exercised on any platform.
+//
+// Usage:
+//   RayTraceVS.FrameStream write NAME [--frames N] [--width W] [--height H] [--slots S]
+//                                     [--format rgba8|rgba32f] [--interval-ms MS]
+//   RayTraceVS.FrameStream view NAME [--frames N] [--ppm out.ppm]
+//   RayTraceVS.FrameStream demo NAME [write options]
+//
+// write creates the channel and publishes --frames frames of a test pattern that encodes
+// the frame index in every pixel (every third frame is a few pixels narrower than the
+// channel, to exercise partial frames). view opens the channel, reads each new frame in
+// place, checks every pixel against the pattern and prints it; frames overwritten while
+// being read are counted and dropped. It exits once frame N has been seen, or after 10 s
+// without a new frame, and fails if no frame arrived or a frame that EndRead accepted did
+// not match its pattern. --ppm saves the last frame. demo runs the writer as a child
+// process of the viewer, streaming between two processes in one command.
+
+#include "FrameChannel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    struct StreamOptions
+    {
+        std::string mode;
+        std::string name;
+        int frames = 120;
+        uint32_t width = 256;
+        uint32_t height = 144;
+        uint32_t slots = 3;
+        FrameFormat format = FrameFormat::Rgba8;
+        int intervalMs = 5;
+        std::string ppmPath;
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr,
+            "Usage: RayTraceVS.FrameStream write NAME [--frames N] [--width W] [--height H] [--slots S]\n"
+            "                                         [--format rgba8|rgba32f] [--interval-ms MS]\n"
+            "       RayTraceVS.FrameStream view NAME [--frames N] [--ppm out.ppm]\n"
+            "       RayTraceVS.FrameStream demo NAME [write options]\n");
+    }
+
+    bool ParseOptions(int argc, char** argv, StreamOptions& options)
+    {
+        if (argc < 3)
+            return false;
+        options.mode = argv[1];
+        options.name = argv[2];
+        if (options.mode != "write" && options.mode != "view" && options.mode != "demo")
+            return false;
+
+        for (int i = 3; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "--frames")              options.frames = atoi(value);
+            else if (arg == "--width")          options.width = static_cast<uint32_t>(atoi(value));
+            else if (arg == "--height")         options.height = static_cast<uint32_t>(atoi(value));
+            else if (arg == "--slots")          options.slots = static_cast<uint32_t>(atoi(value));
+            else if (arg == "--interval-ms")    options.intervalMs = atoi(value);
+            else if (arg == "--ppm")            options.ppmPath = value;
+            else if (arg == "--format")
+            {
+                const std::string format = value;
+                if (format == "rgba8")          options.format = FrameFormat::Rgba8;
+                else if (format == "rgba32f")   options.format = FrameFormat::Rgba32Float;
+                else
+                {
+                    fprintf(stderr, "Unknown format: %s\n", value);
+                    return false;
+                }
+            }
+            else
+            {
+                fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+                return false;
+            }
+        }
+        return options.frames > 0 && options.width > 3 && options.height > 0;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // Test pattern: channel c of pixel (x, y) in frame f is (x + 3y + 7f + c) mod 256,
+    // stored as a byte or as that value / 255 in float
+    uint8_t PatternValue(uint32_t x, uint32_t y, uint64_t frame, uint32_t channel)
+    {
+        return static_cast<uint8_t>(x + 3u * y + 7u * static_cast<uint32_t>(frame) + channel);
+    }
+
+    void FillPattern(const FrameBufferView& view, uint64_t frame)
+    {
+        for (uint32_t y = 0; y < view.height; y++)
+        {
+            uint8_t* row = view.GetRow(y);
+            for (uint32_t x = 0; x < view.width; x++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    if (view.format == FrameFormat::Rgba32Float)
+                        reinterpret_cast<float*>(row)[x * 4 + c] = PatternValue(x, y, frame, c) / 255.0f;
+                    else
+                        row[x * 4 + c] = PatternValue(x, y, frame, c);
+                }
+            }
+        }
+    }
+
+    // Number of pixels that do not match the pattern of frame
+    uint64_t CheckPattern(const FrameBufferView& view, uint64_t frame)
+    {
+        uint64_t mismatches = 0;
+        for (uint32_t y = 0; y < view.height; y++)
+        {
+            const uint8_t* row = view.GetRow(y);
+            for (uint32_t x = 0; x < view.width; x++)
+            {
+                bool match = true;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    if (view.format == FrameFormat::Rgba32Float)
+                        match = match && reinterpret_cast<const float*>(row)[x * 4 + c] == PatternValue(x, y, frame, c) / 255.0f;
+                    else
+                        match = match && row[x * 4 + c] == PatternValue(x, y, frame, c);
+                }
+                mismatches += match ? 0 : 1;
+            }
+        }
+        return mismatches;
+    }
+
+    // Binary PPM of the RGB channels (float frames are clamped to [0, 1])
+    bool SavePpm(const std::string& path, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height,
+        FrameFormat format)
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        fprintf(file, "P6\n%u %u\n255\n", width, height);
+        const uint32_t rowPitch = width * GetFrameFormatBytesPerPixel(format);
+        std::vector<uint8_t> rgb(static_cast<size_t>(width) * 3);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* row = pixels.data() + static_cast<size_t>(y) * rowPitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    if (format == FrameFormat::Rgba32Float)
+                    {
+                        const float value = (std::min)((std::max)(reinterpret_cast<const float*>(row)[x * 4 + c], 0.0f), 1.0f);
+                        rgb[x * 3 + c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+                    }
+                    else
+                    {
+                        rgb[x * 3 + c] = row[x * 4 + c];
+                    }
+                }
+            }
+            fwrite(rgb.data(), 1, rgb.size(), file);
+        }
+        return fclose(file) == 0;
+    }
+
+    int RunWriter(const StreamOptions& options)
+    {
+        FrameChannel channel;
+        if (!channel.Create(options.name, options.width, options.height, options.format, options.slots))
+        {
+            fprintf(stderr, "[write] cannot create frame channel %s\n", options.name.c_str());
+            return 1;
+        }
+
+        for (int frame = 1; frame <= options.frames; frame++)
+        {
+            const uint32_t width = options.width - static_cast<uint32_t>(frame % 3 == 0 ? 3 : 0);
+            FrameBufferView view;
+            if (!channel.BeginWrite(width, options.height, options.format, view))
+            {
+                fprintf(stderr, "[write] BeginWrite failed at frame %d\n", frame);
+                return 1;
+            }
+            FillPattern(view, static_cast<uint64_t>(frame));
+            channel.EndWrite(true);
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+        }
+
+        fprintf(stderr, "[write] published %d frames to %s\n", options.frames, options.name.c_str());
+        // Keep the last frame mapped briefly so a viewer that is just opening still finds it
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return 0;
+    }
+
+    int RunViewer(const StreamOptions& options)
+    {
+        FrameChannel channel;
+        const auto openStart = std::chrono::steady_clock::now();
+        while (!channel.Open(options.name))
+        {
+            if (ElapsedMs(openStart) > 10000.0)
+            {
+                fprintf(stderr, "[view] cannot open frame channel %s\n", options.name.c_str());
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        int received = 0, torn = 0, corrupt = 0;
+        uint64_t lastFrame = 0;
+        std::vector<uint8_t> lastPixels;
+        FrameBufferView lastView;
+        auto lastFrameTime = std::chrono::steady_clock::now();
+        while (lastFrame < static_cast<uint64_t>(options.frames) && ElapsedMs(lastFrameTime) < 10000.0)
+        {
+            FrameBufferView view;
+            uint64_t frameIndex = 0;
+            if (!channel.BeginRead(view, frameIndex))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Read in place, straight from shared memory
+            const uint64_t mismatches = CheckPattern(view, frameIndex);
+            if (!options.ppmPath.empty())
+                lastPixels.assign(view.data, view.data + static_cast<size_t>(view.rowPitch) * view.height);
+            if (!channel.EndRead())
+            {
+                torn++;
+                continue;
+            }
+
+            const double sinceLastMs = ElapsedMs(lastFrameTime);
+            lastFrameTime = std::chrono::steady_clock::now();
+            received++;
+            lastFrame = frameIndex;
+            lastView = view;
+            if (mismatches != 0)
+                corrupt++;
+            fprintf(stderr, "[view] frame %llu: %ux%u format %u, %llu bad pixels (+%.1f ms)\n",
+                static_cast<unsigned long long>(frameIndex), view.width, view.height, static_cast<uint32_t>(view.format),
+                static_cast<unsigned long long>(mismatches), sinceLastMs);
+        }
+
+        fprintf(stderr, "[view] %d frames received, %d discarded (overwritten while reading), %d corrupt, last frame %llu\n",
+            received, torn, corrupt, static_cast<unsigned long long>(lastFrame));
+        if (!options.ppmPath.empty() && received > 0 &&
+            !SavePpm(options.ppmPath, lastPixels, lastView.width, lastView.height, lastView.format))
+        {
+            fprintf(stderr, "[view] cannot write %s\n", options.ppmPath.c_str());
+        }
+        return (received > 0 && corrupt == 0 && lastFrame == static_cast<uint64_t>(options.frames)) ? 0 : 1;
+    }
+
+    // Viewer in this process, writer as a child process running the same executable
+    int RunDemo(const char* executable, int argc, char** argv, const StreamOptions& options)
+    {
+        std::string command = std::string("\"") + executable + "\" write";
+        for (int i = 2; i < argc; i++)
+            command += std::string(" \"") + argv[i] + "\"";
+#ifdef _WIN32
+        // cmd /c strips the first and last quote of the line
+        command = "\"" + command + "\"";
+#endif
+
+        int writerResult = -1;
+        std::thread writer([&]() { writerResult = std::system(command.c_str()); });
+        const int viewerResult = RunViewer(options);
+        writer.join();
+
+        if (writerResult != 0)
+            fprintf(stderr, "[demo] writer process failed (%d)\n", writerResult);
+        return (viewerResult == 0 && writerResult == 0) ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    StreamOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (options.mode == "write")
+        return RunWriter(options);
+    if (options.mode == "view")
+        return RunViewer(options);
+    return RunDemo(argv[0], argc, argv, options);
+}
@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <cmath>
+#include <vcclr.h>
 
 // Declare OutputDebugStringA without including windows.h (avoids C++/CLI conflicts)
 extern "C" __declspec(dllimport) void __stdcall OutputDebugStringA(const char* lpOutputString);
@@ -68,6 +69,7 @@ namespace RayTraceVS::Interop
         , renderWidth(width)
         , renderHeight(height)
         , nativeRenderTarget(nullptr)
+        , nativeFrameSink(nullptr)
     {
         try
         {
@@ -96,6 +98,9 @@ namespace RayTraceVS::Interop
                 throw gcnew System::Exception("Failed to initialize render target");
             }
 
+            // Create frame sink (unconfigured until SetFrameBuffers)
+            nativeFrameSink = Bridge::CreateFrameSink();
+
             isInitialized = true;
         }
         catch (...)
@@ -111,6 +116,12 @@ namespace RayTraceVS::Interop
 
     EngineWrapper::!EngineWrapper()
     {
+        if (nativeFrameSink)
+        {
+            Bridge::DestroyFrameSink(nativeFrameSink);
+            nativeFrameSink = nullptr;
+        }
+
         if (nativeRenderTarget)
         {
             Bridge::DestroyRenderTarget(nativeRenderTarget);
@@ -336,8 +347,16 @@ namespace RayTraceVS::Interop
                 if (cache == nullptr || cache->MeshName == nullptr)
                     continue;
                     
-                Bridge::MeshCacheDataNative nativeCache;
                 std::string meshNameStr = Marshalling::ToNativeString(cache->MeshName);
+                if (!System::String::IsNullOrEmpty(cache->PagedFile))
+                {
+                    pin_ptr<const wchar_t> pagedPath = PtrToStringChars(cache->PagedFile);
+                    if (!Bridge::AddPagedMeshCache(nativeScene, meshNameStr.c_str(), pagedPath, nullptr))
+                        LogError("[EngineWrapper] ERROR: Cannot register paged mesh (file missing or not a .rtvsm)\n");
+                    continue;
+                }
+
+                Bridge::MeshCacheDataNative nativeCache;
                 nativeCache.name = meshNameStr.c_str();
                 
                 // Pin managed arrays to get native pointers
@@ -372,6 +391,7 @@ namespace RayTraceVS::Interop
                 
                 nativeCache.boundsMin = { cache->BoundsMin.X, cache->BoundsMin.Y, cache->BoundsMin.Z };
                 nativeCache.boundsMax = { cache->BoundsMax.X, cache->BoundsMax.Y, cache->BoundsMax.Z };
+                nativeCache.spatialSplits = cache->SpatialSplits ? 1 : 0;
                 
                 Bridge::AddMeshCache(nativeScene, nativeCache);
             }
@@ -474,6 +494,12 @@ namespace RayTraceVS::Interop
             Bridge::CopyRenderTargetToReadback(nativeRenderTarget, nativeContext);
             Bridge::ExecuteCommandList(nativeContext);
             Bridge::WaitForGPU(nativeContext);
+
+            // Resolve into the caller's frame buffers (no-op until SetFrameBuffers)
+            if (nativeFrameSink && !Bridge::ResolveRenderTargetToSink(nativeRenderTarget, nativeFrameSink))
+            {
+                LogDebug("[EngineWrapper::Render] Frame sink not resolved\n");
+            }
             LogDebug("[EngineWrapper::Render] Completed\n");
         }
         catch (System::Exception^)
@@ -488,6 +514,40 @@ namespace RayTraceVS::Interop
         }
     }
 
+    void EngineWrapper::SetEnvironment(System::String^ hdrPath, float intensity, bool lighting)
+    {
+        if (!isInitialized || !nativeScene)
+            return;
+
+        if (!std::isfinite(intensity) || intensity < 0.0f)
+            intensity = 1.0f;
+        if (System::String::IsNullOrEmpty(hdrPath))
+        {
+            Bridge::SetEnvironment(nativeScene, nullptr, intensity, lighting);
+            return;
+        }
+        pin_ptr<const wchar_t> nativePath = PtrToStringChars(hdrPath);
+        Bridge::SetEnvironment(nativeScene, nativePath, intensity, lighting);
+    }
+
+    bool EngineWrapper::SaveSceneSnapshot(System::String^ path)
+    {
+        if (!isInitialized || !nativeScene || System::String::IsNullOrEmpty(path))
+            return false;
+
+        pin_ptr<const wchar_t> nativePath = PtrToStringChars(path);
+        return Bridge::SaveSceneSnapshot(nativeScene, nativePath);
+    }
+
+    bool EngineWrapper::LoadSceneSnapshot(System::String^ path)
+    {
+        if (!isInitialized || !nativeScene || System::String::IsNullOrEmpty(path))
+            return false;
+
+        pin_ptr<const wchar_t> nativePath = PtrToStringChars(path);
+        return Bridge::LoadSceneSnapshot(nativeScene, nativePath);
+    }
+
     System::IntPtr EngineWrapper::GetRenderTargetTexture()
     {
         if (!isInitialized)
@@ -509,8 +569,9 @@ namespace RayTraceVS::Interop
         // Calculate pixel data size
         int dataSize = renderWidth * renderHeight * 4; // RGBA
         
-        // Create managed array
-        array<System::Byte>^ pixelData = gcnew array<System::Byte>(dataSize);
+        // Reuse the managed array across frames (reallocated only when the size changes)
+        if (pixelData == nullptr || pixelData->Length != dataSize)
+            pixelData = gcnew array<System::Byte>(dataSize);
         
         // Pin and get native pointer
         pin_ptr<System::Byte> pinnedData = &pixelData[0];
@@ -535,4 +596,69 @@ namespace RayTraceVS::Interop
         
         return pixelData;
     }
+
+    bool EngineWrapper::SetFrameBuffers(array<System::IntPtr>^ buffers, int rowPitch, bool bgra)
+    {
+        if (!isInitialized || !nativeFrameSink)
+            return false;
+
+        // Detach
+        if (buffers == nullptr || buffers->Length == 0)
+        {
+            return Bridge::ConfigureFrameSink(nativeFrameSink, 0, 0, 0, 0, nullptr, 0);
+        }
+        if (buffers->Length > 3)
+            return false;
+
+        unsigned char* nativeBuffers[3] = {};
+        for (int i = 0; i < buffers->Length; i++)
+        {
+            nativeBuffers[i] = static_cast<unsigned char*>(buffers[i].ToPointer());
+        }
+        const int format = bgra ? 1 : 0;    // FrameFormat::Bgra8 / Rgba8
+        return Bridge::ConfigureFrameSink(nativeFrameSink, renderWidth, renderHeight, format, rowPitch,
+            nativeBuffers, buffers->Length);
+    }
+
+    bool EngineWrapper::AcquireFrame(System::IntPtr% data, int% rowPitch, long long% frameNumber)
+    {
+        data = System::IntPtr::Zero;
+        rowPitch = 0;
+        frameNumber = 0;
+        if (!isInitialized || !nativeFrameSink)
+            return false;
+
+        Bridge::FrameViewNative frame = {};
+        if (!Bridge::AcquireFrame(nativeFrameSink, &frame))
+            return false;
+        data = System::IntPtr(frame.data);
+        rowPitch = frame.rowPitch;
+        frameNumber = static_cast<long long>(frame.frameNumber);
+        return true;
+    }
+
+    void EngineWrapper::ReleaseFrame()
+    {
+        if (nativeFrameSink)
+            Bridge::ReleaseFrame(nativeFrameSink);
+    }
+
+    void EngineWrapper::SetMeshMemoryBudget(long long budgetBytes)
+    {
+        if (nativePipeline)
+            Bridge::SetMeshResidencyBudget(nativePipeline, budgetBytes > 0 ? static_cast<uint64_t>(budgetBytes) : 0);
+    }
+
+    bool EngineWrapper::GetMeshMemoryUsage(long long% residentBytes, long long% budgetBytes, int% residentCount, long long% evictions)
+    {
+        Bridge::ResidencyStatsNative stats = {};
+        if (!nativePipeline || !Bridge::GetMeshResidencyStats(nativePipeline, &stats))
+            return false;
+
+        residentBytes = static_cast<long long>(stats.residentBytes);
+        budgetBytes = static_cast<long long>(stats.budgetBytes);
+        residentCount = stats.residentCount;
+        evictions = static_cast<long long>(stats.evictions);
+        return true;
+    }
 }
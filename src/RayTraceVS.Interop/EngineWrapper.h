@@ -8,6 +8,7 @@ namespace RayTraceVS::DXEngine
     class DXRPipeline;
     class Scene;
     class RenderTarget;
+    class FrameSink;
 }
 
 namespace RayTraceVS::Interop
@@ -48,15 +49,38 @@ namespace RayTraceVS::Interop
             float nrdBypassDistance,
             float nrdBypassBlendRange);
 
+        // Environment map: an equirectangular Radiance .hdr (null or empty = built-in sky).
+        // lighting also samples it as a light on diffuse surfaces. Kept across UpdateScene calls.
+        void SetEnvironment(System::String^ hdrPath, float intensity, bool lighting);
+
+        // Binary scene snapshot (.rtvsb): the scene from the last UpdateScene/LoadSceneSnapshot,
+        // flattened so a render node can load it without evaluating the node graph
+        bool SaveSceneSnapshot(System::String^ path);
+        bool LoadSceneSnapshot(System::String^ path);
+
         // Rendering
         void Render();
 
         // Get render target
         System::IntPtr GetRenderTargetTexture();
         
-        // Get pixel data (RGBA format)
+        // Get pixel data (RGBA format). The returned array is reused by the next call.
         array<System::Byte>^ GetPixelData();
 
+        // Frame sink: 2-3 caller-owned buffers of height * rowPitch bytes (rowPitch >= width * 4).
+        // Once set, Render resolves every frame straight into the next free buffer (BGRA when
+        // bgra is true, else RGBA). Null or an empty array detaches them. The memory must stay
+        // valid until it is detached or the wrapper is disposed.
+        bool SetFrameBuffers(array<System::IntPtr>^ buffers, int rowPitch, bool bgra);
+
+        // Latest resolved frame; the buffer is not written again until ReleaseFrame
+        bool AcquireFrame(System::IntPtr% data, int% rowPitch, long long% frameNumber);
+        void ReleaseFrame();
+
+        // Mesh BLAS cache: BLASes of meshes no instance uses are kept (LRU) up to budgetBytes
+        void SetMeshMemoryBudget(long long budgetBytes);
+        bool GetMeshMemoryUsage(long long% residentBytes, long long% budgetBytes, int% residentCount, long long% evictions);
+
         // Initialization state
         bool IsInitialized() { return isInitialized; }
 
@@ -65,6 +89,8 @@ namespace RayTraceVS::Interop
         RayTraceVS::DXEngine::DXRPipeline* nativePipeline;
         RayTraceVS::DXEngine::Scene* nativeScene;
         RayTraceVS::DXEngine::RenderTarget* nativeRenderTarget;
+        RayTraceVS::DXEngine::FrameSink* nativeFrameSink;
+        array<System::Byte>^ pixelData;
         
         bool isInitialized;
         int renderWidth;
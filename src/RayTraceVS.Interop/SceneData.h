@@ -209,5 +209,17 @@ namespace RayTraceVS::Interop
         /// Bounding box maximum point
         /// </summary>
         property Vector3 BoundsMax;
+
+        /// <summary>
+        /// Build the CPU BVH with spatial splits (for meshes with long thin triangles)
+        /// </summary>
+        property bool SpatialSplits;
+
+        /// <summary>
+        /// Out-of-core geometry: a paged mesh file (.rtvsm). When set, Vertices, Indices, bounds and
+        /// SpatialSplits are ignored; the mesh is registered from the file without loading its
+        /// vertices and only the CPU path tracer renders it
+        /// </summary>
+        property String^ PagedFile;
     };
 }
@@ -0,0 +1,246 @@
+#include "Test.h"
+#include "CpuBvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    struct SliverMesh
+    {
+        std::vector<float> vertices;    // 9 floats per triangle
+        std::vector<AABB> bounds;
+    };
+
+    // Long, thin triangles running diagonally through a 10^3 box: their boxes are mostly
+    // empty space and overlap heavily, the case spatial splits are made for
+    SliverMesh MakeSliverMesh(uint32_t triangleCount)
+    {
+        SliverMesh mesh;
+        uint32_t state = 12345u;
+        auto random = [&state]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / 16777216.0f;
+        };
+
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const float start[3] = { random() * 10.0f, random() * 10.0f, random() * 10.0f };
+            const float direction[3] = { random() < 0.5f ? -1.0f : 1.0f, random() < 0.5f ? -1.0f : 1.0f, random() < 0.5f ? -1.0f : 1.0f };
+            const float length = 4.0f + random() * 4.0f;
+            const float corners[3][3] = {
+                { start[0], start[1], start[2] },
+                { start[0] + direction[0] * length, start[1] + direction[1] * length, start[2] + direction[2] * length },
+                { start[0] + 0.05f, start[1] - 0.05f, start[2] + 0.1f } };
+
+            AABB box = EmptyAABB();
+            for (const auto& corner : corners)
+            {
+                mesh.vertices.insert(mesh.vertices.end(), corner, corner + 3);
+                ExpandAABB(box, { corner[0], corner[1], corner[2], corner[0], corner[1], corner[2] });
+            }
+            mesh.bounds.push_back(box);
+        }
+        return mesh;
+    }
+
+    struct Ray
+    {
+        double origin[3];
+        double direction[3];
+    };
+
+    struct Hit
+    {
+        double t = std::numeric_limits<double>::infinity();
+        uint32_t primitive = CpuBvh::INVALID_INDEX;
+    };
+
+    // Moller-Trumbore; infinity on a miss
+    double IntersectTriangle(const Ray& ray, const float* v)
+    {
+        const double e1[3] = { v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+        const double e2[3] = { v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+        const double* d = ray.direction;
+        const double p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+        const double determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (std::abs(determinant) < 1e-12)
+            return std::numeric_limits<double>::infinity();
+        const double inverse = 1.0 / determinant;
+        const double s[3] = { ray.origin[0] - v[0], ray.origin[1] - v[1], ray.origin[2] - v[2] };
+        const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+        if (u < 0.0 || u > 1.0)
+            return std::numeric_limits<double>::infinity();
+        const double q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+        const double w = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverse;
+        if (w < 0.0 || u + w > 1.0)
+            return std::numeric_limits<double>::infinity();
+        const double t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+        return t > 0.0 ? t : std::numeric_limits<double>::infinity();
+    }
+
+    // Slab test against a box grown by a small margin, so clipped SBVH boxes that end
+    // exactly at a hit point still let the ray in
+    bool IntersectBox(const Ray& ray, const AABB& box, double tMax)
+    {
+        constexpr double MARGIN = 1e-4;
+        const double minimum[3] = { box.MinX - MARGIN, box.MinY - MARGIN, box.MinZ - MARGIN };
+        const double maximum[3] = { box.MaxX + MARGIN, box.MaxY + MARGIN, box.MaxZ + MARGIN };
+        double tNear = 0.0, tFar = tMax;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const double inverse = 1.0 / ray.direction[axis];
+            double t0 = (minimum[axis] - ray.origin[axis]) * inverse;
+            double t1 = (maximum[axis] - ray.origin[axis]) * inverse;
+            if (t0 > t1)
+                std::swap(t0, t1);
+            tNear = (std::max)(tNear, t0);
+            tFar = (std::min)(tFar, t1);
+            if (tNear > tFar)
+                return false;
+        }
+        return true;
+    }
+
+    Hit TraceBvh(const CpuBvh& bvh, const SliverMesh& mesh, const Ray& ray)
+    {
+        Hit hit;
+        const std::vector<BvhNode>& nodes = bvh.GetNodes();
+        const std::vector<uint32_t>& order = bvh.GetPrimitiveOrder();
+        std::vector<uint32_t> stack = { 0 };
+        while (!stack.empty())
+        {
+            const BvhNode& node = nodes[stack.back()];
+            stack.pop_back();
+            if (!IntersectBox(ray, node.bounds, hit.t))
+                continue;
+            if (node.count == 0)
+            {
+                stack.push_back(node.firstOrLeft);
+                stack.push_back(node.firstOrLeft + 1);
+                continue;
+            }
+            for (uint32_t i = node.firstOrLeft; i < node.firstOrLeft + node.count; i++)
+            {
+                const double t = IntersectTriangle(ray, &mesh.vertices[order[i] * 9]);
+                if (t < hit.t)
+                    hit = { t, order[i] };
+            }
+        }
+        return hit;
+    }
+
+    Hit TraceAll(const SliverMesh& mesh, const Ray& ray)
+    {
+        Hit hit;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(mesh.bounds.size()); i++)
+        {
+            const double t = IntersectTriangle(ray, &mesh.vertices[i * 9]);
+            if (t < hit.t)
+                hit = { t, i };
+        }
+        return hit;
+    }
+
+    // Rays from a sphere around the mesh towards random points inside it
+    std::vector<Ray> MakeRays(uint32_t count)
+    {
+        std::vector<Ray> rays;
+        uint32_t state = 777u;
+        auto random = [&state]()
+        {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<double>(state >> 8) / 16777216.0;
+        };
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const double theta = random() * 6.283185307179586;
+            const double z = random() * 2.0 - 1.0;
+            const double r = std::sqrt(1.0 - z * z);
+            Ray ray = { { 5.0 + 20.0 * r * std::cos(theta), 5.0 + 20.0 * r * std::sin(theta), 5.0 + 20.0 * z }, {} };
+            for (int axis = 0; axis < 3; axis++)
+                ray.direction[axis] = random() * 10.0 - ray.origin[axis];
+            rays.push_back(ray);
+        }
+        return rays;
+    }
+}
+
+TEST_CASE("SBVH and binned SAH find the same closest hits")
+{
+    const SliverMesh mesh = MakeSliverMesh(400);
+    CpuBvh binned, spatial;
+    binned.Build(mesh.bounds);
+    spatial.BuildSpatial(mesh.bounds, mesh.vertices);
+    REQUIRE(!binned.HasSpatialSplits());
+    REQUIRE(spatial.HasSpatialSplits());
+    // Spatial splits were actually made, so the comparison covers duplicated references
+    REQUIRE(spatial.GetPrimitiveCount() > mesh.bounds.size());
+
+    int hits = 0;
+    for (const Ray& ray : MakeRays(2000))
+    {
+        const Hit expected = TraceAll(mesh, ray);
+        const Hit fromBinned = TraceBvh(binned, mesh, ray);
+        const Hit fromSpatial = TraceBvh(spatial, mesh, ray);
+        CHECK_EQUAL(fromBinned.primitive, expected.primitive);
+        CHECK_EQUAL(fromSpatial.primitive, expected.primitive);
+        CHECK(fromSpatial.t == fromBinned.t);
+        hits += expected.primitive != CpuBvh::INVALID_INDEX ? 1 : 0;
+    }
+    // The rays exercise the tree rather than all missing
+    CHECK(hits > 200);
+}
+
+TEST_CASE("SBVH references stay within the growth cap")
+{
+    const SliverMesh mesh = MakeSliverMesh(400);
+    for (float growth : { 0.0f, 0.1f, 0.5f, 1.0f })
+    {
+        BvhSpatialSplitSettings settings;
+        settings.maxReferenceGrowth = growth;
+        CpuBvh bvh;
+        bvh.BuildSpatial(mesh.bounds, mesh.vertices, settings);
+        const size_t cap = mesh.bounds.size() + static_cast<size_t>(static_cast<float>(mesh.bounds.size()) * growth);
+        CHECK(bvh.GetPrimitiveCount() >= mesh.bounds.size());
+        CHECK(bvh.GetPrimitiveCount() <= cap);
+
+        // Every primitive is still referenced from at least one leaf
+        std::vector<bool> referenced(mesh.bounds.size(), false);
+        for (uint32_t primitive : bvh.GetPrimitiveOrder())
+            referenced[primitive] = true;
+        CHECK(std::count(referenced.begin(), referenced.end(), false) == 0);
+    }
+}
+
+TEST_CASE("Spatial splits lower the SAH cost of sliver meshes")
+{
+    const SliverMesh mesh = MakeSliverMesh(400);
+    CpuBvh binned, spatial;
+    binned.Build(mesh.bounds);
+    spatial.BuildSpatial(mesh.bounds, mesh.vertices);
+    CHECK(spatial.ComputeSahCost() < binned.ComputeSahCost());
+
+    // Without reference budget the build can only split objects
+    BvhSpatialSplitSettings noGrowth;
+    noGrowth.maxReferenceGrowth = 0.0f;
+    CpuBvh objectOnly;
+    objectOnly.BuildSpatial(mesh.bounds, mesh.vertices, noGrowth);
+    CHECK_EQUAL(objectOnly.GetPrimitiveCount(), mesh.bounds.size());
+    CHECK(spatial.ComputeSahCost() < objectOnly.ComputeSahCost());
+}
+
+TEST_CASE("Refit after BuildSpatial still finds every hit")
+{
+    // Refit puts the full primitive boxes back into the leaves; the hits must not change
+    const SliverMesh mesh = MakeSliverMesh(200);
+    CpuBvh spatial;
+    spatial.BuildSpatial(mesh.bounds, mesh.vertices);
+    spatial.Refit(mesh.bounds);
+    for (const Ray& ray : MakeRays(500))
+        CHECK_EQUAL(TraceBvh(spatial, mesh, ray).primitive, TraceAll(mesh, ray).primitive);
+}
@@ -0,0 +1,127 @@
+#include "Test.h"
+#include "DebugLog.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace RayTraceVS::DXEngine;
+using RayTraceVS::Tests::TemporaryDirectory;
+
+namespace
+{
+    // Points the logger at a fresh file for the lifetime of the object
+    class LogCapture
+    {
+    public:
+        LogCapture()
+        {
+            SetLogFilePath((directory.GetPath() / "debug.log").string().c_str());
+            ClearLogFile();
+            SetLogEnabled(1);
+            SetDebugMode(0);
+        }
+
+        ~LogCapture()
+        {
+            FlushLog();
+            SetLogFilePath(nullptr);
+            SetLogEnabled(0);
+        }
+
+        std::string Read() const
+        {
+            FlushLog();
+            std::ifstream file(directory.GetPath() / "debug.log", std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+    private:
+        TemporaryDirectory directory;
+    };
+
+    bool IsValidUtf8(const std::string& text)
+    {
+        for (size_t i = 0; i < text.size();)
+        {
+            const uint8_t lead = static_cast<uint8_t>(text[i]);
+            const size_t length = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+            if (length == 0 || i + length > text.size())
+                return false;
+            for (size_t k = 1; k < length; k++)
+            {
+                if ((static_cast<uint8_t>(text[i + k]) & 0xC0) != 0x80)
+                    return false;
+            }
+            i += length;
+        }
+        return true;
+    }
+}
+
+TEST_CASE("Deferred log records copy string arguments")
+{
+    LogCapture capture;
+
+    char narrow[] = "narrow-original";
+    std::string owned = "owned-original";
+    LOG_INFOF("[test] %s %s %d", narrow, owned, 42);
+    // The writer formats later; the record must not see these edits
+    memcpy(narrow, "narrow-REWRITES", sizeof(narrow));
+    owned.assign("owned-REWRITES");
+
+    const std::string log = capture.Read();
+    CHECK(log.find("[INFO] [test] narrow-original owned-original 42\n") != std::string::npos);
+    CHECK(log.find("REWRITES") == std::string::npos);
+}
+
+TEST_CASE("Deferred log records store wide strings as UTF-8")
+{
+    LogCapture capture;
+
+    wchar_t buffer[] = L"Env/\u00e9\u65e5\U0001F600.hdr";
+    std::wstring path = L"Scene/\u00e9.rtvs";
+    const wchar_t* literal = L"literal";
+    LOG_WARNF("[test] %s | %s | %s", buffer, path, literal);
+    buffer[0] = L'X';
+    path.assign(L"gone");
+
+    const std::string log = capture.Read();
+    CHECK(log.find("[WARN] [test] Env/\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80.hdr | Scene/\xC3\xA9.rtvs | literal\n") != std::string::npos);
+    CHECK(log.find("gone") == std::string::npos);
+}
+
+TEST_CASE("Long wide strings are truncated at a code point boundary")
+{
+    LogCapture capture;
+
+    const std::wstring longPath(1000, L'\u00e9');
+    LOG_INFOF("[test] %s", longPath);
+
+    const std::string log = capture.Read();
+    const size_t start = log.find("[test] ");
+    REQUIRE(start != std::string::npos);
+    const std::string line = log.substr(start, log.find('\n', start) - start);
+    CHECK(line.size() > 200);
+    CHECK(line.size() < 2000);
+    CHECK(IsValidUtf8(line));
+}
+
+TEST_CASE("Disabled levels are dropped and errors always logged")
+{
+    LogCapture capture;
+
+    SetLogEnabled(0);
+    LOG_INFO("[test] info while disabled");
+    LOG_ERRORF("[test] error %u", 7u);
+    SetLogEnabled(1);
+    LOG_DEBUG("[test] debug without debug mode");
+    SetDebugMode(1);
+    LOG_DEBUGF("[test] debug %s", "enabled");
+    SetDebugMode(0);
+
+    const std::string log = capture.Read();
+    CHECK(log.find("info while disabled") == std::string::npos);
+    CHECK(log.find("[ERROR] [test] error 7\n") != std::string::npos);
+    CHECK(log.find("debug without debug mode") == std::string::npos);
+    CHECK(log.find("[DEBUG] [test] debug enabled\n") != std::string::npos);
+}
@@ -0,0 +1,136 @@
+#include "Test.h"
+#include "FrameChannel.h"
+#include <cstring>
+#include <random>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    // Channel names are system-wide; keep them unique to the test process
+    std::string ChannelName(const char* test)
+    {
+        static const std::string suffix = std::to_string(std::random_device()());
+        return std::string("Tests.") + test + "." + suffix;
+    }
+
+    bool WriteFrame(FrameChannel& channel, uint32_t width, uint32_t height, uint8_t value)
+    {
+        FrameBufferView view;
+        if (!channel.BeginWrite(width, height, FrameFormat::Rgba8, view))
+            return false;
+        for (uint32_t y = 0; y < view.height; y++)
+            std::memset(view.GetRow(y), value, view.width * 4);
+        channel.EndWrite(true);
+        return true;
+    }
+}
+
+TEST_CASE("Frame channel rejects invalid parameters")
+{
+    FrameChannel channel;
+    const std::string name = ChannelName("Invalid");
+    CHECK(!channel.Create(name, 0, 16, FrameFormat::Rgba8, 3));
+    CHECK(!channel.Create(name, 16, 16, FrameFormat::Rgba8, FrameChannel::MIN_SLOTS - 1));
+    CHECK(!channel.Create(name, 16, 16, FrameFormat::Rgba8, FrameChannel::MAX_SLOTS + 1));
+    CHECK(!channel.Create("", 16, 16, FrameFormat::Rgba8, 3));
+    CHECK(!channel.IsOpen());
+    CHECK(!channel.Open(name));
+}
+
+TEST_CASE("Reader sees the latest published frame once, in place")
+{
+    const std::string name = ChannelName("Latest");
+    FrameChannel writer, reader;
+    REQUIRE(writer.Create(name, 8, 4, FrameFormat::Rgba8, 3));
+    REQUIRE(reader.Open(name));
+    CHECK(writer.IsWriter());
+    CHECK(!reader.IsWriter());
+
+    FrameBufferView view;
+    uint64_t frameIndex = 0;
+    CHECK(!reader.BeginRead(view, frameIndex));
+    CHECK_EQUAL(reader.GetLatestFrameIndex(), 0u);
+
+    CHECK(WriteFrame(writer, 8, 4, 11));
+    CHECK(WriteFrame(writer, 6, 2, 22));
+    CHECK_EQUAL(reader.GetLatestFrameIndex(), 2u);
+
+    REQUIRE(reader.BeginRead(view, frameIndex));
+    CHECK_EQUAL(frameIndex, 2u);
+    CHECK_EQUAL(view.width, 6u);
+    CHECK_EQUAL(view.height, 2u);
+    CHECK_EQUAL(view.rowPitch, 24u);
+    CHECK(view.format == FrameFormat::Rgba8);
+    CHECK_EQUAL(static_cast<int>(view.GetRow(1)[23]), 22);
+    CHECK(reader.EndRead());
+
+    // Nothing newer yet
+    CHECK(!reader.BeginRead(view, frameIndex));
+    // Roles are fixed
+    CHECK(!reader.BeginWrite(8, 4, FrameFormat::Rgba8, view));
+    CHECK(!writer.BeginRead(view, frameIndex));
+}
+
+TEST_CASE("Frames larger than a slot are refused")
+{
+    const std::string name = ChannelName("Oversize");
+    FrameChannel writer;
+    REQUIRE(writer.Create(name, 8, 8, FrameFormat::Rgba8, 2));
+    FrameBufferView view;
+    CHECK(!writer.BeginWrite(64, 64, FrameFormat::Rgba8, view));
+    CHECK(writer.BeginWrite(8, 8, FrameFormat::Rgba8, view));
+    writer.EndWrite(false);
+    CHECK_EQUAL(writer.GetLatestFrameIndex(), 0u);
+}
+
+TEST_CASE("EndRead reports frames the writer lapped during the read")
+{
+    const std::string name = ChannelName("Lapped");
+    FrameChannel writer, reader;
+    REQUIRE(writer.Create(name, 4, 4, FrameFormat::Rgba8, 2));
+    REQUIRE(reader.Open(name));
+
+    FrameBufferView view;
+    uint64_t frameIndex = 0;
+    CHECK(WriteFrame(writer, 4, 4, 1));
+    REQUIRE(reader.BeginRead(view, frameIndex));
+    // With two slots, the second write after frame 1 reuses its slot
+    CHECK(WriteFrame(writer, 4, 4, 2));
+    CHECK(reader.EndRead());
+
+    REQUIRE(reader.BeginRead(view, frameIndex));
+    CHECK_EQUAL(frameIndex, 2u);
+    CHECK(WriteFrame(writer, 4, 4, 3));
+    CHECK(WriteFrame(writer, 4, 4, 4));
+    CHECK(!reader.EndRead());
+
+    REQUIRE(reader.BeginRead(view, frameIndex));
+    CHECK_EQUAL(frameIndex, 4u);
+    CHECK_EQUAL(static_cast<int>(view.data[0]), 4);
+    CHECK(reader.EndRead());
+}
+
+TEST_CASE("Reader takes the latest frame while the next one is being written")
+{
+    const std::string name = ChannelName("Writing");
+    FrameChannel writer, reader;
+    REQUIRE(writer.Create(name, 4, 4, FrameFormat::Rgba8, 2));
+    REQUIRE(reader.Open(name));
+
+    FrameBufferView writeView, readView;
+    uint64_t frameIndex = 0;
+    for (uint8_t frame = 1; frame <= 3; frame++)
+    {
+        CHECK(WriteFrame(writer, 4, 4, frame));
+        // The writer fills the oldest slot, never the one holding the latest frame
+        REQUIRE(writer.BeginWrite(4, 4, FrameFormat::Rgba8, writeView));
+        CHECK(writeView.data != nullptr);
+        REQUIRE(reader.BeginRead(readView, frameIndex));
+        CHECK(readView.data != writeView.data);
+        CHECK_EQUAL(static_cast<int>(readView.data[0]), static_cast<int>(frame));
+        CHECK(reader.EndRead());
+        writer.EndWrite(false);
+    }
+    CHECK_EQUAL(writer.GetLatestFrameIndex(), 3u);
+}
@@ -0,0 +1,197 @@
+#include "Test.h"
+#include "FrameSink.h"
+#include <cstdint>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    constexpr uint32_t WIDTH = 4;
+    constexpr uint32_t HEIGHT = 3;
+    constexpr uint32_t ROW_PITCH = 20;     // One pixel of padding per row
+
+    struct SinkBuffers
+    {
+        std::vector<std::vector<uint8_t>> storage;
+        std::vector<uint8_t*> pointers;
+
+        explicit SinkBuffers(uint32_t count)
+            : storage(count, std::vector<uint8_t>(HEIGHT * ROW_PITCH))
+        {
+            for (auto& buffer : storage)
+                pointers.push_back(buffer.data());
+        }
+    };
+
+    // Writes and publishes one frame, tagging its first byte; returns the buffer written
+    uint8_t* WriteFrame(FrameSink& sink, uint8_t tag)
+    {
+        FrameBufferView view;
+        if (!sink.BeginWrite(view))
+            return nullptr;
+        view.GetRow(0)[0] = tag;
+        sink.EndWrite(true);
+        return view.data;
+    }
+}
+
+TEST_CASE("With three buffers the writer never gets the buffer being read")
+{
+    SinkBuffers buffers(3);
+    FrameSink sink;
+    REQUIRE(sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, buffers.pointers.data(), 3));
+
+    FrameBufferView read;
+    uint64_t frameNumber = 0;
+    CHECK(!sink.BeginRead(read, frameNumber));     // Nothing published yet
+
+    REQUIRE(WriteFrame(sink, 1) != nullptr);
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    CHECK_EQUAL(frameNumber, 1u);
+    CHECK_EQUAL(read.GetRow(0)[0], 1);
+
+    // While frame 1 is read, many frames are written: none of them lands in its buffer,
+    // and each one goes to a buffer other than the latest frame's
+    uint8_t* previous = nullptr;
+    for (uint8_t tag = 2; tag < 20; tag++)
+    {
+        uint8_t* written = WriteFrame(sink, tag);
+        REQUIRE(written != nullptr);
+        CHECK(written != read.data);
+        CHECK(written != previous);
+        previous = written;
+    }
+    CHECK_EQUAL(read.GetRow(0)[0], 1);
+    sink.EndRead();
+
+    // The reader then gets the newest frame
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    CHECK_EQUAL(frameNumber, 19u);
+    CHECK_EQUAL(read.GetRow(0)[0], 19);
+    CHECK(read.data == previous);
+    sink.EndRead();
+}
+
+TEST_CASE("With two buffers an unread latest frame is overwritten")
+{
+    SinkBuffers buffers(2);
+    FrameSink sink;
+    REQUIRE(sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, buffers.pointers.data(), 2));
+
+    REQUIRE(WriteFrame(sink, 1) != nullptr);
+    FrameBufferView read;
+    uint64_t frameNumber = 0;
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    CHECK_EQUAL(frameNumber, 1u);
+
+    // Frame 2 takes the only free buffer; frame 3 has nowhere else to go and replaces it
+    uint8_t* second = WriteFrame(sink, 2);
+    uint8_t* third = WriteFrame(sink, 3);
+    REQUIRE(second != nullptr);
+    CHECK(second != read.data);
+    CHECK(third == second);
+    sink.EndRead();
+
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    CHECK_EQUAL(frameNumber, 3u);
+    CHECK_EQUAL(read.GetRow(0)[0], 3);
+
+    // Once read, frame 3 is no longer the only free buffer: the next write goes to the
+    // other one and frame 3 stays readable until that write is published
+    FrameBufferView write;
+    REQUIRE(sink.BeginWrite(write));
+    CHECK(write.data != read.data);
+    sink.EndRead();
+    FrameBufferView unused;
+    REQUIRE(sink.BeginRead(unused, frameNumber));
+    CHECK_EQUAL(frameNumber, 3u);
+    sink.EndRead();
+    CHECK(!sink.BeginWrite(unused));               // One writer at a time
+    sink.EndWrite(false);                           // Not published: frame 3 stays the latest
+    REQUIRE(sink.BeginRead(unused, frameNumber));
+    CHECK_EQUAL(frameNumber, 3u);
+    sink.EndRead();
+}
+
+TEST_CASE("Frame numbers stay stable across repeated reads")
+{
+    SinkBuffers buffers(3);
+    FrameSink sink;
+    REQUIRE(sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, buffers.pointers.data(), 3));
+    REQUIRE(WriteFrame(sink, 7) != nullptr);
+
+    FrameBufferView read;
+    uint64_t frameNumber = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        REQUIRE(sink.BeginRead(read, frameNumber));
+        CHECK_EQUAL(frameNumber, 1u);
+        CHECK_EQUAL(read.GetRow(0)[0], 7);
+        sink.EndRead();
+    }
+
+    // A second BeginRead without EndRead is refused
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    FrameBufferView other;
+    uint64_t otherNumber = 0;
+    CHECK(!sink.BeginRead(other, otherNumber));
+    sink.EndRead();
+
+    REQUIRE(WriteFrame(sink, 8) != nullptr);
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    CHECK_EQUAL(frameNumber, 2u);
+    sink.EndRead();
+}
+
+TEST_CASE("Configure checks its arguments and drops frames in flight")
+{
+    SinkBuffers buffers(3);
+    FrameSink sink;
+    uint8_t* const* pointers = buffers.pointers.data();
+
+    // Row pitch below width * bytes per pixel (16 for float), bad counts, null buffers
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba32Float, ROW_PITCH, pointers, 3));
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, WIDTH * 4 - 1, pointers, 3));
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, pointers, 1));
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, pointers, 4));
+    CHECK(!sink.Configure(0, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, pointers, 3));
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, nullptr, 3));
+    uint8_t* withNull[] = { pointers[0], nullptr };
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, withNull, 2));
+    CHECK(!sink.IsConfigured());
+    FrameBufferView view;
+    CHECK(!sink.BeginWrite(view));
+
+    REQUIRE(sink.Configure(WIDTH, HEIGHT, FrameFormat::Bgra8, WIDTH * 4, pointers, 3));
+    CHECK(sink.IsConfigured());
+    CHECK_EQUAL(sink.GetWidth(), WIDTH);
+    CHECK_EQUAL(sink.GetHeight(), HEIGHT);
+    CHECK(sink.GetFormat() == FrameFormat::Bgra8);
+
+    // A frame being read and one being written when the sink is reconfigured
+    REQUIRE(WriteFrame(sink, 1) != nullptr);
+    FrameBufferView read, write;
+    uint64_t frameNumber = 0;
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    REQUIRE(sink.BeginWrite(write));
+
+    REQUIRE(sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, ROW_PITCH, pointers, 2));
+    CHECK(!sink.BeginRead(read, frameNumber));     // The old latest frame is gone
+    sink.EndWrite(true);                            // Stale: there is no write in flight
+    CHECK(!sink.BeginRead(read, frameNumber));
+    REQUIRE(sink.BeginWrite(write));                // Both buffers are free again
+    CHECK_EQUAL(write.rowPitch, ROW_PITCH);
+    CHECK(write.format == FrameFormat::Rgba8);
+    sink.EndWrite(true);
+    REQUIRE(sink.BeginRead(read, frameNumber));
+    sink.EndRead();
+
+    // A failed Configure leaves the sink unconfigured too
+    CHECK(!sink.Configure(WIDTH, HEIGHT, FrameFormat::Rgba8, 1, pointers, 2));
+    CHECK(!sink.IsConfigured());
+    CHECK(!sink.BeginRead(read, frameNumber));
+
+    sink.Reset();
+    CHECK(!sink.BeginWrite(view));
+}
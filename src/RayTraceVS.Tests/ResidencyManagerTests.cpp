@@ -0,0 +1,133 @@
+#include "Test.h"
+#include "ResidencyManager.h"
+#include <string>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+TEST_CASE("Trim evicts the least recently used entries once over budget")
+{
+    ResidencyManager residency(300);
+    residency.BeginFrame();
+    residency.Add("a", 100);
+    residency.Add("b", 100);
+    residency.Add("c", 100);
+    CHECK(residency.Trim().empty());
+    CHECK_EQUAL(residency.GetStats().residentBytes, 300u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 3u);
+    CHECK_EQUAL(residency.GetStats().misses, 3u);
+
+    // Next frame: a is used again, d is new; b is now the oldest unpinned entry
+    residency.BeginFrame();
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 0u);
+    CHECK(residency.Use("a"));
+    residency.Add("d", 100);
+    CHECK_EQUAL(residency.GetStats().residentBytes, 400u);
+    CHECK_EQUAL(residency.GetStats().peakResidentBytes, 400u);
+    CHECK(residency.Trim() == std::vector<std::string>({ "b" }));
+    CHECK(!residency.Contains("b"));
+    CHECK(residency.Contains("c"));
+
+    const ResidencyStats& stats = residency.GetStats();
+    CHECK_EQUAL(stats.residentBytes, 300u);
+    CHECK_EQUAL(stats.residentCount, 3u);
+    CHECK_EQUAL(stats.evictions, 1u);
+    CHECK_EQUAL(stats.evictedBytes, 100u);
+    CHECK_EQUAL(stats.hits, 1u);
+    CHECK_EQUAL(stats.misses, 4u);
+
+    // A smaller budget takes the rest of the unpinned entries, oldest first
+    residency.SetBudget(0);
+    CHECK(residency.Trim() == std::vector<std::string>({ "c" }));
+    residency.BeginFrame();
+    CHECK(residency.Trim() == std::vector<std::string>({ "a", "d" }));
+    CHECK_EQUAL(residency.GetStats().residentBytes, 0u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 0u);
+    CHECK_EQUAL(residency.GetStats().evictions, 4u);
+    CHECK_EQUAL(residency.GetStats().evictedBytes, 400u);
+    CHECK_EQUAL(residency.GetStats().peakResidentBytes, 400u);
+}
+
+TEST_CASE("Pinned entries survive Trim over budget")
+{
+    ResidencyManager residency(100);
+    residency.BeginFrame();
+    residency.Add("a", 80);
+    residency.Add("b", 80);
+    // Both are used by this frame: nothing can go, the overshoot only shows in the stats
+    CHECK(residency.Trim().empty());
+    CHECK_EQUAL(residency.GetStats().residentBytes, 160u);
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 160u);
+    CHECK_EQUAL(residency.GetStats().pinnedCount, 2u);
+    CHECK_EQUAL(residency.GetStats().evictions, 0u);
+
+    // Using a resident entry pins it once, however often it is used
+    residency.BeginFrame();
+    CHECK(residency.Use("b"));
+    CHECK(residency.Use("b"));
+    CHECK(!residency.Use("missing"));
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 80u);
+    CHECK_EQUAL(residency.GetStats().pinnedCount, 1u);
+    CHECK_EQUAL(residency.GetStats().hits, 2u);
+    CHECK(residency.Trim() == std::vector<std::string>({ "a" }));
+    CHECK(residency.Contains("b"));
+    CHECK_EQUAL(residency.GetStats().residentBytes, 80u);
+}
+
+TEST_CASE("Adding an existing key replaces its size")
+{
+    ResidencyManager residency(1000);
+    residency.BeginFrame();
+    residency.Add("mesh", 100);
+    residency.Add("mesh", 250);
+    CHECK_EQUAL(residency.GetStats().residentBytes, 250u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 1u);
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 250u);
+    CHECK_EQUAL(residency.GetStats().pinnedCount, 1u);
+    CHECK_EQUAL(residency.GetStats().peakResidentBytes, 250u);
+
+    // Rebuilt in a later frame: the entry becomes pinned again with its new size
+    residency.BeginFrame();
+    residency.Add("mesh", 50);
+    CHECK_EQUAL(residency.GetStats().residentBytes, 50u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 1u);
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 50u);
+    CHECK_EQUAL(residency.GetStats().pinnedCount, 1u);
+    CHECK_EQUAL(residency.GetStats().peakResidentBytes, 250u);
+    CHECK_EQUAL(residency.GetStats().misses, 3u);
+}
+
+TEST_CASE("Remove and Clear forget entries and their bytes")
+{
+    ResidencyManager residency(1000);
+    residency.BeginFrame();
+    residency.Add("a", 10);
+    residency.Add("b", 20);
+    residency.BeginFrame();
+    residency.Add("c", 30);
+
+    // Pinned entry: pinned totals drop with it
+    residency.Remove("c");
+    CHECK(!residency.Contains("c"));
+    CHECK_EQUAL(residency.GetStats().residentBytes, 30u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 2u);
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 0u);
+    CHECK_EQUAL(residency.GetStats().pinnedCount, 0u);
+
+    // Unpinned entry, then a key that is not there
+    residency.Remove("a");
+    residency.Remove("a");
+    CHECK_EQUAL(residency.GetStats().residentBytes, 20u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 1u);
+    CHECK_EQUAL(residency.GetStats().evictions, 0u);
+    CHECK(!residency.Use("a"));
+
+    residency.Clear();
+    CHECK(!residency.Contains("b"));
+    CHECK_EQUAL(residency.GetStats().residentBytes, 0u);
+    CHECK_EQUAL(residency.GetStats().residentCount, 0u);
+    CHECK_EQUAL(residency.GetStats().pinnedBytes, 0u);
+    CHECK_EQUAL(residency.GetStats().peakResidentBytes, 60u);
+    CHECK_EQUAL(residency.GetBudget(), 1000u);
+    CHECK(residency.Trim().empty());
+}
@@ -0,0 +1,345 @@
+#include "Test.h"
+#include "Sampler.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    // Numbers of one stream dimension (0 = first Next()) over sequence indices [0, count)
+    std::vector<float> StreamValues(uint32_t x, uint32_t y, uint32_t depth, uint32_t salt, uint32_t dimension, uint32_t count)
+    {
+        std::vector<float> values(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Sampler sampler(x, y, i, depth, salt);
+            for (uint32_t d = 0; d < dimension; d++)
+                sampler.Next();
+            values[i] = sampler.Next();
+        }
+        return values;
+    }
+
+    double Correlation(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        double meanA = 0.0, meanB = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            meanA += a[i];
+            meanB += b[i];
+        }
+        meanA /= static_cast<double>(a.size());
+        meanB /= static_cast<double>(b.size());
+        double covariance = 0.0, varianceA = 0.0, varianceB = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            covariance += (a[i] - meanA) * (b[i] - meanB);
+            varianceA += (a[i] - meanA) * (a[i] - meanA);
+            varianceB += (b[i] - meanB) * (b[i] - meanB);
+        }
+        return covariance / std::sqrt(varianceA * varianceB);
+    }
+
+    // Chi-square of the joint distribution over a 16x16 grid (255 degrees of freedom)
+    double JointChiSquare(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        constexpr int GRID = 16;
+        std::vector<int> cells(GRID * GRID, 0);
+        for (size_t i = 0; i < a.size(); i++)
+            cells[static_cast<int>(a[i] * GRID) * GRID + static_cast<int>(b[i] * GRID)]++;
+        const double expected = static_cast<double>(a.size()) / (GRID * GRID);
+        double chiSquare = 0.0;
+        for (int count : cells)
+            chiSquare += (count - expected) * (count - expected) / expected;
+        return chiSquare;
+    }
+
+    // True if the first 2^k values fall one per stratum of width 2^-k after subtracting
+    // offset (mod 1)
+    bool Stratified(const std::vector<float>& values, uint32_t k, double offset)
+    {
+        const uint32_t strata = 1u << k;
+        std::vector<int> counts(strata, 0);
+        for (uint32_t i = 0; i < strata; i++)
+        {
+            double shifted = values[i] - offset;
+            shifted -= std::floor(shifted);
+            if (++counts[static_cast<uint32_t>(shifted * strata) & (strata - 1)] > 1)
+                return false;
+        }
+        return true;
+    }
+
+    // Whole 1/256 steps that make the first 2^k values stratified for every k < 8
+    std::vector<int> FindShiftSteps(const std::vector<float>& values)
+    {
+        std::vector<int> steps;
+        for (int step = 0; step < 256; step++)
+        {
+            bool all = true;
+            for (uint32_t k = 0; k < 8 && all; k++)
+                all = Stratified(values, k, step / 256.0);
+            if (all)
+                steps.push_back(step);
+        }
+        return steps;
+    }
+
+    // Values minus a whole 1/256 step (mod 1)
+    std::vector<float> Unshift(const std::vector<float>& values, int step)
+    {
+        std::vector<float> unshifted(values.size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            double shifted = values[i] - step / 256.0;
+            shifted -= std::floor(shifted);
+            unshifted[i] = static_cast<float>(shifted);
+        }
+        return unshifted;
+    }
+
+    // True if every cell of the 2^xBits x 2^yBits grid holds exactly one point
+    bool OnePointPerCell(const std::vector<float>& xs, const std::vector<float>& ys, uint32_t xBits, uint32_t yBits)
+    {
+        std::vector<int> cells(size_t(1) << (xBits + yBits), 0);
+        for (size_t i = 0; i < xs.size(); i++)
+        {
+            const size_t cx = static_cast<size_t>(xs[i] * static_cast<float>(1u << xBits));
+            const size_t cy = static_cast<size_t>(ys[i] * static_cast<float>(1u << yBits));
+            if (++cells[(cy << xBits) | cx] > 1)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE("The first 2^k points of every Sobol dimension are stratified")
+{
+    // The per-pixel blue-noise shift moves every point of a stream by the same whole
+    // 1/256 step: from 2^8 points on the strata are exact, below that they are the
+    // strata of a grid shifted by that step
+    for (uint32_t pixel : { 0u, 37u, 255u })
+    {
+        for (uint32_t dimension = 0; dimension < Sampler::SOBOL_DIMENSIONS; dimension++)
+        {
+            const std::vector<float> values = StreamValues(pixel, pixel * 3 + 1, 1, SamplerSalt_Brdf, dimension, 4096);
+            for (float value : values)
+                CHECK(value >= 0.0f && value < 1.0f);
+            for (uint32_t k = 8; k <= 12; k++)
+                CHECK(Stratified(values, k, 0.0));
+            CHECK(!FindShiftSteps(values).empty());
+        }
+    }
+}
+
+TEST_CASE("Dimension pairs of a stream form a (0, m, 2)-net")
+{
+    // Sobol dimensions 0 and 1 are a (0, 2)-sequence: 2^m points put one point in every
+    // elementary interval of area 2^-m, and Owen scrambling keeps that. Each dimension has
+    // its own blue-noise shift, which only lines up with intervals of width 1/256 or less,
+    // so some pair of candidate shifts taken back out must give the net at every shape
+    for (uint32_t pixel : { 12u, 201u })
+    {
+        const std::vector<float> xs = StreamValues(pixel, 34, 0, SamplerSalt_AntiAliasing, 0, 256);
+        const std::vector<float> ys = StreamValues(pixel, 34, 0, SamplerSalt_AntiAliasing, 1, 256);
+        bool net = false;
+        for (int xStep : FindShiftSteps(xs))
+        {
+            const std::vector<float> unshiftedXs = Unshift(xs, xStep);
+            for (int yStep : FindShiftSteps(ys))
+            {
+                const std::vector<float> unshiftedYs = Unshift(ys, yStep);
+                bool all = true;
+                for (uint32_t xBits = 0; xBits <= 8 && all; xBits++)
+                    all = OnePointPerCell(unshiftedXs, unshiftedYs, xBits, 8 - xBits);
+                net = net || all;
+            }
+        }
+        CHECK(net);
+    }
+}
+
+TEST_CASE("Streams of different salts and depths are decorrelated")
+{
+    constexpr uint32_t COUNT = 4096;
+    // Correlation of independent uniform sequences has a standard deviation of 1/64 here
+    constexpr double MAX_CORRELATION = 0.1;
+    // 99.9th percentile of chi-square with 255 degrees of freedom is about 330
+    constexpr double MAX_CHI_SQUARE = 330.0;
+
+    for (uint32_t dimension : { 0u, 3u, Sampler::SOBOL_DIMENSIONS })
+    {
+        for (uint32_t salt = SamplerSalt_AntiAliasing; salt + 1 < SamplerSalt_Count; salt++)
+        {
+            const std::vector<float> a = StreamValues(5, 9, 0, salt, dimension, COUNT);
+            const std::vector<float> b = StreamValues(5, 9, 0, salt + 1, dimension, COUNT);
+            CHECK(std::abs(Correlation(a, b)) < MAX_CORRELATION);
+            CHECK(JointChiSquare(a, b) < MAX_CHI_SQUARE);
+        }
+        for (uint32_t depth = 0; depth < 4; depth++)
+        {
+            const std::vector<float> a = StreamValues(5, 9, depth, SamplerSalt_Brdf, dimension, COUNT);
+            const std::vector<float> b = StreamValues(5, 9, depth + 1, SamplerSalt_Brdf, dimension, COUNT);
+            CHECK(std::abs(Correlation(a, b)) < MAX_CORRELATION);
+            CHECK(JointChiSquare(a, b) < MAX_CHI_SQUARE);
+        }
+    }
+
+    // The dimensions within one stream are decorrelated too
+    const std::vector<float> first = StreamValues(5, 9, 0, SamplerSalt_Brdf, 0, COUNT);
+    const std::vector<float> second = StreamValues(5, 9, 0, SamplerSalt_Brdf, 1, COUNT);
+    CHECK(std::abs(Correlation(first, second)) < MAX_CORRELATION);
+}
+
+TEST_CASE("Pixels of one tile get different points for the same index")
+{
+    // The blue-noise shift tells the pixels of a 16x16 tile apart
+    int repeats = 0;
+    const float reference = Sampler(0, 0, 7, 0, SamplerSalt_AntiAliasing).Next();
+    for (uint32_t y = 0; y < Sampler::RANK_TILE_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < Sampler::RANK_TILE_SIZE; x++)
+        {
+            if ((x != 0 || y != 0) && Sampler(x, y, 7, 0, SamplerSalt_AntiAliasing).Next() == reference)
+                repeats++;
+        }
+    }
+    CHECK_EQUAL(repeats, 0);
+}
+
+// Fixed values: Common.hlsli computes the same numbers (PcgHash, SobolSample,
+// NestedUniformScramble, rng_init / rng_next), so a change here is a change there too
+TEST_CASE("Hash, Sobol and scramble values are pinned")
+{
+    CHECK_EQUAL(Sampler::Hash(0u), 0x07BB2FE2u);
+    CHECK_EQUAL(Sampler::Hash(1u), 0xA8BEEA3Cu);
+    CHECK_EQUAL(Sampler::Hash(0x12345678u), 0x995312E1u);
+    CHECK_EQUAL(Sampler::Hash(0xFFFFFFFFu), 0xE62A4902u);
+
+    CHECK_EQUAL(Sampler::Sobol(0u, 0), 0u);
+    CHECK_EQUAL(Sampler::Sobol(1000u, 0), 0x17C00000u);
+    CHECK_EQUAL(Sampler::Sobol(1000u, 1), 0x29400000u);
+    CHECK_EQUAL(Sampler::Sobol(1000u, 2), 0x73400000u);
+    CHECK_EQUAL(Sampler::Sobol(1000u, 3), 0xE8C00000u);
+    CHECK_EQUAL(Sampler::Sobol(0xABCDEFu, 0), 0xF7B3D500u);
+    CHECK_EQUAL(Sampler::Sobol(0xABCDEFu, 1), 0x8F858300u);
+    CHECK_EQUAL(Sampler::Sobol(0xABCDEFu, 2), 0x3CD24900u);
+    CHECK_EQUAL(Sampler::Sobol(0xABCDEFu, 3), 0xE333C900u);
+    // Index bits past SOBOL_INDEX_BITS are ignored
+    CHECK_EQUAL(Sampler::Sobol(0xFF000000u | 1000u, 2), Sampler::Sobol(1000u, 2));
+
+    CHECK_EQUAL(Sampler::NestedUniformScramble(0u, 0u), 0u);
+    CHECK_EQUAL(Sampler::NestedUniformScramble(0x80000000u, 1u), 0x5336F076u);
+    CHECK_EQUAL(Sampler::NestedUniformScramble(0x12345678u, 0x9E3779B9u), 0xA61C7925u);
+    CHECK_EQUAL(Sampler::NestedUniformScramble(0xDEADBEEFu, 42u), 0x8E7BC124u);
+
+    const float expectedA[] = { 0.314134955f, 0.374415338f, 0.848425984f, 0.000623106956f, 0.957291663f, 0.213095367f };
+    const float expectedB[] = { 0.660975099f, 0.821583867f, 0.752854347f, 0.77177757f, 0.825194001f, 0.543977141f };
+    Sampler a(0, 0, 0, 0, SamplerSalt_AntiAliasing);
+    Sampler b(37, 211, 5, 2, SamplerSalt_Brdf);
+    for (int i = 0; i < 6; i++)
+    {
+        CHECK_EQUAL(a.Next(), expectedA[i]);
+        CHECK_EQUAL(b.Next(), expectedB[i]);
+    }
+}
+
+TEST_CASE("Scrambling keeps the leading bits of a stratum together")
+{
+    // Owen scrambling: bit i of the output depends only on bits i and above of the input
+    for (uint32_t seed : { 1u, 0x9E3779B9u, 0xDEADBEEFu })
+    {
+        for (uint32_t x = 0; x < 256; x++)
+        {
+            const uint32_t high = x << 24;
+            CHECK_EQUAL(Sampler::NestedUniformScramble(high, seed) >> 24,
+                Sampler::NestedUniformScramble(high | 0x00ABCDEFu, seed) >> 24);
+        }
+    }
+}
+
+#ifdef RAYTRACEVS_SHADER_DIR
+namespace
+{
+    std::string ReadCommonHlsli()
+    {
+        std::ifstream file(std::filesystem::path(RAYTRACEVS_SHADER_DIR) / "Common.hlsli", std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // Text from signature to the end of its braced body (or table initializer)
+    std::string ExtractBlock(const std::string& source, const std::string& signature)
+    {
+        const size_t start = source.find(signature);
+        if (start == std::string::npos)
+            return {};
+        size_t position = source.find('{', start);
+        int depth = 0;
+        for (; position < source.size(); position++)
+        {
+            if (source[position] == '{')
+                depth++;
+            else if (source[position] == '}' && --depth == 0)
+                return source.substr(start, position + 1 - start);
+        }
+        return {};
+    }
+
+    // Unsigned integer literals (123u, 0xABCu) in order of appearance
+    std::vector<uint32_t> UnsignedLiterals(const std::string& text)
+    {
+        std::vector<uint32_t> literals;
+        const std::regex literal(R"(\b(0x[0-9A-Fa-f]+|[0-9]+)u\b)");
+        for (auto it = std::sregex_iterator(text.begin(), text.end(), literal); it != std::sregex_iterator(); ++it)
+            literals.push_back(static_cast<uint32_t>(std::stoul((*it)[1].str(), nullptr, 0)));
+        return literals;
+    }
+}
+
+TEST_CASE("Common.hlsli carries the same Sobol table and hash constants")
+{
+    const std::string source = ReadCommonHlsli();
+    REQUIRE(!source.empty());
+
+    const std::vector<uint32_t> directions =
+        UnsignedLiterals(ExtractBlock(source, "static const uint SobolDirections[SOBOL_DIMENSIONS * SOBOL_INDEX_BITS]"));
+    REQUIRE(directions.size() == Sampler::SOBOL_DIMENSIONS * Sampler::SOBOL_INDEX_BITS);
+    for (uint32_t dimension = 0; dimension < Sampler::SOBOL_DIMENSIONS; dimension++)
+    {
+        for (uint32_t bit = 0; bit < Sampler::SOBOL_INDEX_BITS; bit++)
+            CHECK_EQUAL(directions[dimension * Sampler::SOBOL_INDEX_BITS + bit], Sampler::Sobol(1u << bit, dimension));
+    }
+
+    CHECK(UnsignedLiterals(ExtractBlock(source, "uint PcgHash(uint v)")) ==
+        std::vector<uint32_t>({ 747796405u, 2891336453u, 28u, 4u, 277803737u, 22u }));
+    CHECK(UnsignedLiterals(ExtractBlock(source, "uint NestedUniformScramble(uint x, uint seed)")) ==
+        std::vector<uint32_t>({ 0x6C50B47Cu, 0xB82F1E52u, 0xC7AFE638u, 0x8D22F6E6u }));
+    CHECK(UnsignedLiterals(ExtractBlock(source, "RNG rng_init(uint2 pixel, uint sequenceIndex, uint depth, uint salt)")) ==
+        std::vector<uint32_t>({ 0x68E31DA4u, 0x27D4EB2Fu, 1u, 1u, 1973u, 9277u, 26699u, 911u, 0x85EBCA6Bu, 1u }));
+    CHECK(UnsignedLiterals(ExtractBlock(source, "float rng_next(inout RNG r)")) ==
+        std::vector<uint32_t>({ 0x9E3779B9u, 1u }));
+
+    CHECK(source.find("#define SOBOL_DIMENSIONS " + std::to_string(Sampler::SOBOL_DIMENSIONS) + "u") != std::string::npos);
+    CHECK(source.find("#define SOBOL_INDEX_BITS " + std::to_string(Sampler::SOBOL_INDEX_BITS) + "u") != std::string::npos);
+    CHECK(source.find("#define RANK_TILE_SIZE " + std::to_string(Sampler::RANK_TILE_SIZE) + "u") != std::string::npos);
+    const std::pair<const char*, SamplerSalt> salts[] = {
+        { "RNG_SALT_AA", SamplerSalt_AntiAliasing }, { "RNG_SALT_DOF", SamplerSalt_DepthOfField },
+        { "RNG_SALT_LIGHT_PICK", SamplerSalt_LightPick }, { "RNG_SALT_BRDF", SamplerSalt_Brdf },
+        { "RNG_SALT_RR", SamplerSalt_RussianRoulette }, { "RNG_SALT_SHADOW", SamplerSalt_Shadow },
+        { "RNG_SALT_REFLECT", SamplerSalt_Reflect }, { "RNG_SALT_REFRACT", SamplerSalt_Refract },
+        { "RNG_SALT_ENVIRONMENT", SamplerSalt_Environment }, { "RNG_SALT_COUNT", SamplerSalt_Count } };
+    for (const auto& [name, salt] : salts)
+    {
+        const std::string define = std::string("#define ") + name + " " + std::to_string(static_cast<uint32_t>(salt)) + "u";
+        if (source.find(define) == std::string::npos)
+            RayTraceVS::Tests::ReportFailure(__FILE__, __LINE__, "Common.hlsli has no " + define);
+    }
+}
+#endif
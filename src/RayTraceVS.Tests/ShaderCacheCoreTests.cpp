@@ -0,0 +1,367 @@
+#include "Test.h"
+#include "ShaderCacheCore.h"
+#include <algorithm>
+
+using namespace RayTraceVS::DXEngine;
+using RayTraceVS::Tests::TemporaryDirectory;
+
+// ============================================
+// UTF-8
+// ============================================
+
+TEST_CASE("ToUtf8 and FromUtf8 convert non-ASCII text without a locale")
+{
+    const std::wstring wide = L"Sub/\u00e9\u65e5\U0001F600.hlsli";
+    const std::string utf8 = "Sub/\xC3\xA9\xE6\x97\xA5\xF0\x9F\x98\x80.hlsli";
+    CHECK_EQUAL(ToUtf8(wide), utf8);
+    CHECK(FromUtf8(utf8) == wide);
+    CHECK_EQUAL(ToUtf8(L""), "");
+    CHECK(FromUtf8("").empty());
+}
+
+TEST_CASE("FromUtf8 replaces invalid sequences")
+{
+    // Stray continuation, overlong encoding, truncated sequence, invalid lead byte, encoded surrogate
+    CHECK(FromUtf8("a\x80" "b") == L"a\uFFFD" L"b");
+    CHECK(FromUtf8("\xC0\xAF") == L"\uFFFD");
+    CHECK(FromUtf8("\xE6\x97") == L"\uFFFD");
+    CHECK(FromUtf8("\xFC\x80\x80\x80") == L"\uFFFD\uFFFD\uFFFD\uFFFD");
+    CHECK(FromUtf8("\xED\xA0\x80") == L"\uFFFD");
+}
+
+// ============================================
+// SHA-256
+// ============================================
+
+TEST_CASE("Sha256 matches the FIPS 180-4 test vectors")
+{
+    CHECK_EQUAL(Sha256::HashHex("", 0), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK_EQUAL(Sha256::HashHex("abc", 3), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    CHECK_EQUAL(Sha256::HashHex(twoBlocks.data(), twoBlocks.size()),
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    const std::string million(1000000, 'a');
+    CHECK_EQUAL(Sha256::HashHex(million.data(), million.size()),
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE("Sha256 gives the same digest for any split of the input")
+{
+    std::string data;
+    for (int i = 0; i < 1000; i++)
+        data += static_cast<char>(i * 31 + 7);
+    const std::string expected = Sha256::HashHex(data.data(), data.size());
+
+    // Splits around the 55/56/64-byte padding and block boundaries
+    for (size_t chunk : { 1, 3, 55, 56, 63, 64, 65, 127 })
+    {
+        Sha256 sha;
+        for (size_t offset = 0; offset < data.size(); offset += chunk)
+            sha.Update(data.data() + offset, (std::min)(chunk, data.size() - offset));
+        CHECK_EQUAL(sha.FinishHex(), expected);
+    }
+
+    Sha256 reused;
+    reused.Update("garbage", 7);
+    reused.FinishHex();
+    reused.Reset();
+    reused.Update(data.data(), data.size());
+    CHECK_EQUAL(reused.FinishHex(), expected);
+}
+
+TEST_CASE("Sha256 hashes files and reports unreadable ones as empty")
+{
+    TemporaryDirectory directory;
+    const auto file = directory.WriteFile("data.bin", "abc");
+    CHECK_EQUAL(Sha256::HashFileHex(file), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK_EQUAL(Sha256::HashFileHex(directory.GetPath() / "missing.bin"), "");
+}
+
+// ============================================
+// JSON
+// ============================================
+
+TEST_CASE("JsonValue parses nested documents")
+{
+    JsonValue root;
+    std::string error;
+    REQUIRE(JsonValue::Parse(R"( { "a": [1, -2.5e3, true, false, null], "b": { "c": "text" }, "d": {} } )", root, &error));
+    REQUIRE(root.IsObject());
+    CHECK_EQUAL(root.Size(), 3u);
+
+    const JsonValue* a = root.Find("a");
+    REQUIRE(a && a->IsArray());
+    CHECK_EQUAL(a->Size(), 5u);
+    CHECK_EQUAL(a->At(0).AsInt64(), 1);
+    CHECK_EQUAL(a->At(1).AsDouble(), -2500.0);
+    CHECK_EQUAL(a->At(1).AsInt64(), -2500);
+    CHECK(a->At(2).AsBool(false));
+    CHECK(!a->At(3).AsBool(true));
+    CHECK(a->At(4).IsNull());
+    CHECK(a->At(5).IsNull());   // Out of range
+
+    const JsonValue* b = root.Find("b");
+    REQUIRE(b);
+    CHECK_EQUAL(b->Find("c")->AsString(), "text");
+    CHECK(root.Find("missing") == nullptr);
+    CHECK(root.Find("d")->IsObject());
+}
+
+TEST_CASE("JsonValue keeps number literals so 64-bit integers round-trip")
+{
+    JsonValue root;
+    REQUIRE(JsonValue::Parse(R"({"luid": 18446744073709551615, "negative": -9223372036854775808})", root));
+    CHECK_EQUAL(root.Find("luid")->AsUInt64(), UINT64_MAX);
+    CHECK_EQUAL(root.Find("negative")->AsInt64(), INT64_MIN);
+    CHECK_EQUAL(root.Find("negative")->AsUInt64(7), 7u);      // Negative: fallback
+    CHECK_EQUAL(root.Serialize(-1), R"({"luid":18446744073709551615,"negative":-9223372036854775808})");
+
+    CHECK_EQUAL(JsonValue(UINT64_MAX).Serialize(), "18446744073709551615");
+    CHECK_EQUAL(JsonValue("x").AsInt64(5), 5);              // Wrong type: fallback
+}
+
+TEST_CASE("JsonValue decodes escapes to UTF-8 and escapes control characters")
+{
+    JsonValue value;
+    REQUIRE(JsonValue::Parse(R"("q\" b\\ s\/ \n\t \u00e9 \ud83d\ude00")", value));
+    CHECK_EQUAL(value.AsString(), "q\" b\\ s/ \n\t \xC3\xA9 \xF0\x9F\x98\x80");
+
+    CHECK_EQUAL(JsonValue(std::string("a\"b\\c\n\x01")).Serialize(), R"("a\"b\\c\n\u0001")");
+}
+
+TEST_CASE("JsonValue serializes in insertion order and round-trips")
+{
+    JsonValue root = JsonValue::MakeObject();
+    root.Set("z", 1);
+    root.Set("a", "two");
+    JsonValue list = JsonValue::MakeArray();
+    list.Append(true);
+    list.Append(JsonValue());
+    list.Append(0.5);
+    root.Set("list", std::move(list));
+    root.Set("empty", JsonValue::MakeArray());
+    root.Set("z", 3);                                       // Replaces, keeps the position
+
+    CHECK_EQUAL(root.Serialize(-1), R"({"z":3,"a":"two","list":[true,null,0.5],"empty":[]})");
+    CHECK_EQUAL(root.Serialize(2),
+        "{\n  \"z\": 3,\n  \"a\": \"two\",\n  \"list\": [\n    true,\n    null,\n    0.5\n  ],\n  \"empty\": []\n}");
+
+    JsonValue parsed;
+    REQUIRE(JsonValue::Parse(root.Serialize(2), parsed));
+    CHECK_EQUAL(parsed.Serialize(-1), root.Serialize(-1));
+}
+
+TEST_CASE("JsonValue rejects malformed input")
+{
+    const char* invalid[] =
+    {
+        "", "   ", "{", "}", "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "{a:1}", "01", "1.", "-", "1e",
+        "+1", "\"abc", "\"\\x\"", "\"\\u12\"", "\"\\ud800\"", "\"\\udc00\"", "\"tab\there\"", "tru", "nul",
+        "[1] x", "{} {}",
+    };
+    for (const char* text : invalid)
+    {
+        JsonValue value(42);
+        std::string error;
+        if (JsonValue::Parse(text, value, &error))
+        {
+            RayTraceVS::Tests::ReportFailure(__FILE__, __LINE__, std::string("accepted: ") + text);
+            continue;
+        }
+        CHECK(error.find("offset") != std::string::npos);
+        CHECK_EQUAL(value.AsInt64(), 42);                   // Left untouched
+    }
+
+    // Nesting is bounded instead of overflowing the stack
+    JsonValue deep;
+    CHECK(!JsonValue::Parse(std::string(100000, '['), deep));
+    CHECK(JsonValue::Parse(std::string(200, '[') + std::string(200, ']'), deep));
+}
+
+TEST_CASE("Cache metadata round-trips through shader_cache.json")
+{
+    CacheMetadata metadata;
+    metadata.driverVersion = "31.0.15.5222";
+    metadata.adapterLUID = 0x8000000012345678ull;
+    ShaderCacheInfo& rayGen = metadata.shaders[L"RayGen"];
+    rayGen.sourceHash = "aa";
+    rayGen.compiledAt = "2026-01-02T03:04:05";
+    rayGen.dependencies = { { L"Common.hlsli", "bb" }, { L"Sub/\u00e9.hlsli", "cc" } };
+    metadata.shaders[L"Composite"].sourceHash = "dd";
+
+    const std::string json = SerializeCacheMetadata(metadata);
+    // Sorted by shader name, so an unchanged cache writes an identical file
+    CHECK(json.find("\"Composite\"") < json.find("\"RayGen\""));
+
+    CacheMetadata parsed;
+    std::string error;
+    REQUIRE(ParseCacheMetadata(json, parsed, &error));
+    CHECK_EQUAL(parsed.version, CacheMetadata::CURRENT_VERSION);
+    CHECK_EQUAL(parsed.driverVersion, metadata.driverVersion);
+    CHECK_EQUAL(parsed.adapterLUID, metadata.adapterLUID);
+    REQUIRE(parsed.shaders.size() == 2);
+    const ShaderCacheInfo& parsedRayGen = parsed.shaders[L"RayGen"];
+    CHECK_EQUAL(parsedRayGen.sourceHash, "aa");
+    CHECK_EQUAL(parsedRayGen.compiledAt, rayGen.compiledAt);
+    REQUIRE(parsedRayGen.dependencies.size() == 2);
+    CHECK(parsedRayGen.dependencies[1].filename == L"Sub/\u00e9.hlsli");
+    CHECK_EQUAL(parsedRayGen.dependencies[1].hash, "cc");
+    CHECK_EQUAL(SerializeCacheMetadata(parsed), json);
+}
+
+TEST_CASE("Cache metadata parsing rejects non-objects and defaults the version")
+{
+    CacheMetadata metadata;
+    std::string error;
+    CHECK(!ParseCacheMetadata("[1, 2]", metadata, &error));
+    CHECK_EQUAL(error, "Metadata root is not an object");
+    CHECK(!ParseCacheMetadata("{\"version\": ", metadata, &error));
+
+    // Files written before versioning are version 1 and get rebuilt
+    REQUIRE(ParseCacheMetadata("{\"shaders\": {}}", metadata));
+    CHECK_EQUAL(metadata.version, 1);
+}
+
+// ============================================
+// #include graph
+// ============================================
+
+namespace
+{
+    std::vector<std::pair<std::string, bool>> Includes(const std::string& source)
+    {
+        std::vector<std::pair<std::string, bool>> includes;
+        ExtractIncludes(source, includes);
+        return includes;
+    }
+
+    using IncludeList = std::vector<std::pair<std::string, bool>>;
+}
+
+TEST_CASE("ExtractIncludes finds quoted and angled directives")
+{
+    CHECK(Includes("#include \"a.hlsli\"\n#include <b.hlsli>\n") == IncludeList({ { "a.hlsli", true }, { "b.hlsli", false } }));
+    CHECK(Includes("  #  include\t\"sub/c.hlsli\"\r\n") == IncludeList({ { "sub/c.hlsli", true } }));
+    CHECK(Includes("/* lead */ #include \"after_comment.hlsli\"") == IncludeList({ { "after_comment.hlsli", true } }));
+}
+
+TEST_CASE("ExtractIncludes skips commented-out and malformed directives")
+{
+    CHECK(Includes("// #include \"line.hlsli\"\n").empty());
+    CHECK(Includes("/*\n#include \"block.hlsli\"\n*/\n").empty());
+    CHECK(Includes("int x; #include \"mid_line.hlsli\"\n").empty());
+    CHECK(Includes("#include \"unterminated.hlsli\n").empty());
+    CHECK(Includes("#include \"\"\n").empty());
+    CHECK(Includes("#includes \"x\"\n").empty());
+    CHECK(Includes("#pragma once\n#define INCLUDE \"x\"\n").empty());
+}
+
+TEST_CASE("ShaderSourceGraph follows includes transitively")
+{
+    TemporaryDirectory directory;
+    const auto root = directory.WriteFile("RayGen.hlsl", "#include \"Common.hlsli\"\n#include <Lib.hlsli>\n#include \"Missing.hlsli\"\n");
+    const auto common = directory.WriteFile("Common.hlsli", "#include \"Sub/Inner.hlsli\"\n");
+    // Cycle back to Common.hlsli through a parent-relative include
+    const auto inner = directory.WriteFile("Sub/Inner.hlsli", "#include \"../Common.hlsli\"\n");
+    const auto library = directory.WriteFile("include/Lib.hlsli", "// library\n");
+
+    ShaderSourceGraph graph;
+    graph.SetIncludeDirectories({ directory.GetPath() / "include" });
+    graph.Scan({ root });
+
+    CHECK_EQUAL(graph.GetFileCount(), 4u);
+    CHECK(graph.Contains(root));
+    CHECK(graph.Contains(library));
+    CHECK(!graph.Contains(directory.GetPath() / "Missing.hlsli"));
+
+    const std::vector<std::filesystem::path> expected =
+    {
+        ShaderSourceGraph::Normalize(common), ShaderSourceGraph::Normalize(library), ShaderSourceGraph::Normalize(inner)
+    };
+    std::vector<std::filesystem::path> sorted = expected;
+    std::sort(sorted.begin(), sorted.end());
+    CHECK(graph.GetDependencies(root) == sorted);
+    CHECK(graph.GetDependencies(inner) == std::vector<std::filesystem::path>({ ShaderSourceGraph::Normalize(common) }));
+    CHECK(graph.GetDependencies(library).empty());
+
+    CHECK_EQUAL(graph.GetHash(library), Sha256::HashHex("// library\n", 11));
+    CHECK_EQUAL(graph.GetHash(directory.GetPath() / "Missing.hlsli"), "");
+}
+
+TEST_CASE("ShaderSourceGraph resolves quoted includes next to the includer first")
+{
+    TemporaryDirectory directory;
+    const auto root = directory.WriteFile("Shaders/Root.hlsl", "#include \"Shared.hlsli\"\n#include <Local.hlsli>\n");
+    const auto local = directory.WriteFile("Shaders/Shared.hlsli", "local");
+    directory.WriteFile("include/Shared.hlsli", "library");
+    directory.WriteFile("Shaders/Local.hlsli", "angled includes do not look here");
+
+    ShaderSourceGraph graph;
+    graph.SetIncludeDirectories({ directory.GetPath() / "include" });
+    graph.Scan({ root });
+
+    CHECK(graph.GetDependencies(root) == std::vector<std::filesystem::path>({ ShaderSourceGraph::Normalize(local) }));
+}
+
+TEST_CASE("ShaderSourceGraph reads each file once until cleared")
+{
+    TemporaryDirectory directory;
+    const auto root = directory.WriteFile("Root.hlsl", "#include \"A.hlsli\"\n");
+    const auto a = directory.WriteFile("A.hlsli", "one");
+
+    ShaderSourceGraph graph;
+    graph.Scan({ root });
+    const std::string before = graph.GetHash(a);
+    CHECK_EQUAL(before, Sha256::HashHex("one", 3));
+
+    directory.WriteFile("A.hlsli", "two");
+    graph.Scan({ root, a });
+    CHECK_EQUAL(graph.GetHash(a), before);
+
+    graph.Clear();
+    CHECK_EQUAL(graph.GetFileCount(), 0u);
+    graph.Scan({ root });
+    CHECK_EQUAL(graph.GetHash(a), Sha256::HashHex("two", 3));
+}
+
+// ============================================
+// Validation
+// ============================================
+
+TEST_CASE("IsCacheEntryCurrent accepts unchanged sources in any dependency order")
+{
+    ShaderCacheInfo cached;
+    cached.sourceHash = "source";
+    cached.dependencies = { { L"A.hlsli", "a" }, { L"B.hlsli", "b" } };
+
+    std::string reason;
+    CHECK(IsCacheEntryCurrent(cached, "source", { { L"B.hlsli", "b" }, { L"A.hlsli", "a" } }, &reason));
+    CHECK(IsCacheEntryCurrent(cached, "source", { { L"A.hlsli", "a" }, { L"B.hlsli", "b" } }));
+}
+
+TEST_CASE("IsCacheEntryCurrent reports the first difference")
+{
+    ShaderCacheInfo cached;
+    cached.sourceHash = "source";
+    cached.dependencies = { { L"A.hlsli", "a" }, { L"B.hlsli", "b" } };
+
+    auto reasonFor = [&](const std::string& sourceHash, const std::vector<ShaderDependency>& dependencies)
+    {
+        std::string reason;
+        CHECK(!IsCacheEntryCurrent(cached, sourceHash, dependencies, &reason));
+        return reason;
+    };
+
+    const std::vector<ShaderDependency> current = { { L"A.hlsli", "a" }, { L"B.hlsli", "b" } };
+    CHECK_EQUAL(reasonFor("", current), "source unreadable");
+    CHECK_EQUAL(reasonFor("edited", current), "source changed");
+    CHECK_EQUAL(reasonFor("source", { { L"A.hlsli", "a" } }), "dependency set changed");
+    CHECK_EQUAL(reasonFor("source", { { L"A.hlsli", "a" }, { L"B.hlsli", "" } }), "dependency unreadable: B.hlsli");
+    CHECK_EQUAL(reasonFor("source", { { L"A.hlsli", "a" }, { L"C.hlsli", "c" } }), "new dependency: C.hlsli");
+    CHECK_EQUAL(reasonFor("source", { { L"A.hlsli", "a" }, { L"B.hlsli", "edited" } }), "dependency changed: B.hlsli");
+
+    // An empty cached entry (never compiled) is never current
+    CHECK(!IsCacheEntryCurrent(ShaderCacheInfo(), "source", {}));
+}
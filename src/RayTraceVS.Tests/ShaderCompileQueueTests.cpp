@@ -0,0 +1,234 @@
+#include "Test.h"
+#include "ShaderCompileQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    // One-shot gate a job can block on until the test opens it
+    class Gate
+    {
+    public:
+        void Open() { promise.set_value(); }
+        void Wait() const { future.wait(); }
+
+    private:
+        std::promise<void> promise;
+        std::shared_future<void> future = promise.get_future().share();
+    };
+}
+
+TEST_CASE("Submitted jobs all run once and WaitAll reports success")
+{
+    ShaderCompileQueue queue(4);
+    CHECK_EQUAL(queue.GetWorkerCount(), 4u);
+
+    std::atomic<int> runs[32] = {};
+    for (int i = 0; i < 32; i++)
+        CHECK(queue.Submit(L"Shader" + std::to_wstring(i), [&runs, i]() { runs[i]++; return true; }));
+
+    CHECK(queue.WaitAll());
+    CHECK_EQUAL(queue.GetSubmittedCount(), 32u);
+    CHECK_EQUAL(queue.GetFinishedCount(), 32u);
+    for (int i = 0; i < 32; i++)
+        CHECK_EQUAL(runs[i].load(), 1);
+}
+
+TEST_CASE("Submitting a known name keeps the existing job")
+{
+    ShaderCompileQueue queue(1);
+    std::atomic<int> first = 0, second = 0;
+    CHECK(queue.Submit(L"RayGen", [&]() { first++; return true; }));
+    CHECK(!queue.Submit(L"RayGen", [&]() { second++; return false; }));
+    CHECK(queue.Wait(L"RayGen"));
+    // Also refused once finished, until forgotten
+    CHECK(!queue.Submit(L"RayGen", [&]() { second++; return false; }));
+    CHECK(queue.WaitAll());
+    CHECK_EQUAL(first.load(), 1);
+    CHECK_EQUAL(second.load(), 0);
+}
+
+TEST_CASE("Wait returns the job result; failures and exceptions fail WaitAll")
+{
+    ShaderCompileQueue queue(2);
+    CHECK(!queue.Wait(L"Unknown"));
+
+    queue.Submit(L"Good", []() { return true; });
+    queue.Submit(L"Bad", []() { return false; });
+    queue.Submit(L"Throws", []() -> bool { throw std::runtime_error("compiler crashed"); });
+
+    CHECK(queue.Wait(L"Good"));
+    CHECK(!queue.Wait(L"Bad"));
+    CHECK(!queue.Wait(L"Throws"));
+    CHECK(!queue.WaitAll());
+    CHECK(queue.IsFinished(L"Throws"));
+    CHECK_EQUAL(queue.GetFinishedCount(), 3u);
+}
+
+TEST_CASE("Wait runs a job nobody has started on the waiting thread")
+{
+    ShaderCompileQueue queue(1);
+    Gate blockerStarted, releaseBlocker;
+    queue.Submit(L"Blocker", [&]() { blockerStarted.Open(); releaseBlocker.Wait(); return true; });
+    blockerStarted.Wait();      // The only worker is now busy
+
+    std::atomic<int> runs = 0;
+    std::thread::id ranOn;
+    queue.Submit(L"Needed", [&]() { runs++; ranOn = std::this_thread::get_id(); return true; });
+    CHECK(!queue.IsFinished(L"Needed"));
+
+    CHECK(queue.Wait(L"Needed"));
+    CHECK(ranOn == std::this_thread::get_id());
+    CHECK(!queue.IsFinished(L"Blocker"));
+
+    releaseBlocker.Open();
+    CHECK(queue.WaitAll());
+    // The worker later pops the taken-over entry and must skip it
+    queue.Submit(L"After", []() { return true; });
+    CHECK(queue.Wait(L"After"));
+    CHECK_EQUAL(runs.load(), 1);
+}
+
+TEST_CASE("Wait on a running job blocks until it finishes")
+{
+    ShaderCompileQueue queue(1);
+    Gate started;
+    std::atomic<bool> done = false;
+    queue.Submit(L"Slow", [&]()
+    {
+        started.Open();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        done = true;
+        return true;
+    });
+    started.Wait();
+
+    CHECK(queue.Wait(L"Slow"));
+    CHECK(done.load());
+    CHECK(queue.IsFinished(L"Slow"));
+}
+
+TEST_CASE("Forget waits for the job and frees its name")
+{
+    ShaderCompileQueue queue(2);
+    std::atomic<int> runs = 0;
+    queue.Submit(L"Composite", [&]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); runs++; return true; });
+    queue.Submit(L"Other", []() { return true; });
+
+    queue.Forget(L"Composite");
+    CHECK_EQUAL(runs.load(), 1);
+    CHECK(!queue.Contains(L"Composite"));
+    CHECK(!queue.IsFinished(L"Composite"));
+    CHECK(!queue.Wait(L"Composite"));
+    queue.Forget(L"Unknown");
+
+    CHECK(queue.Submit(L"Composite", [&]() { runs++; return false; }));
+    CHECK(!queue.Wait(L"Composite"));
+    CHECK_EQUAL(runs.load(), 2);
+    CHECK(queue.Wait(L"Other"));
+    CHECK_EQUAL(queue.GetSubmittedCount(), 2u);
+    CHECK_EQUAL(queue.GetFinishedCount(), 2u);
+}
+
+TEST_CASE("ForgetAll runs outstanding jobs and clears every name")
+{
+    ShaderCompileQueue queue(2);
+    std::atomic<int> runs = 0;
+    for (int i = 0; i < 8; i++)
+        queue.Submit(L"Shader" + std::to_wstring(i), [&]() { runs++; return true; });
+
+    queue.ForgetAll();
+    CHECK_EQUAL(runs.load(), 8);
+    CHECK_EQUAL(queue.GetSubmittedCount(), 0u);
+    CHECK_EQUAL(queue.GetFinishedCount(), 0u);
+    CHECK(queue.Submit(L"Shader0", []() { return true; }));
+    CHECK(queue.WaitAll());
+}
+
+TEST_CASE("Concurrent waiters see every job run exactly once")
+{
+    ShaderCompileQueue queue(3);
+    constexpr int JOB_COUNT = 200;
+    std::atomic<int> runs[JOB_COUNT] = {};
+    for (int i = 0; i < JOB_COUNT; i++)
+        queue.Submit(L"Job" + std::to_wstring(i), [&runs, i]() { runs[i]++; return i % 7 != 0; });
+
+    std::atomic<int> mismatches = 0;
+    std::vector<std::thread> waiters;
+    for (int t = 0; t < 4; t++)
+    {
+        waiters.emplace_back([&, t]()
+        {
+            // Each waiter walks the jobs from a different end, racing the workers
+            for (int k = 0; k < JOB_COUNT; k++)
+            {
+                const int i = (t % 2 == 0) ? k : JOB_COUNT - 1 - k;
+                if (queue.Wait(L"Job" + std::to_wstring(i)) != (i % 7 != 0))
+                    mismatches++;
+            }
+        });
+    }
+    for (auto& waiter : waiters)
+        waiter.join();
+
+    CHECK_EQUAL(mismatches.load(), 0);
+    CHECK(!queue.WaitAll());
+    for (int i = 0; i < JOB_COUNT; i++)
+        CHECK_EQUAL(runs[i].load(), 1);
+}
+
+TEST_CASE("Destroying the queue drops jobs that have not started")
+{
+    std::atomic<int> runs = 0;
+    Gate started, release;
+    std::thread releaser;
+    {
+        ShaderCompileQueue queue(1);
+        queue.Submit(L"Running", [&]() { started.Open(); release.Wait(); return true; });
+        started.Wait();
+        for (int i = 0; i < 4; i++)
+            queue.Submit(L"Queued" + std::to_wstring(i), [&]() { runs++; return true; });
+
+        // The destructor must be waiting on the worker before the running job ends
+        releaser = std::thread([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(200)); release.Open(); });
+    }
+    releaser.join();
+    CHECK_EQUAL(runs.load(), 0);
+}
+
+#ifdef RAYTRACEVS_DXC_EXECUTABLE
+// Found by CMake (find_program dxc): compiles real HLSL through the queue
+TEST_CASE("DXC compiles shaders submitted to the queue")
+{
+    RayTraceVS::Tests::TemporaryDirectory directory;
+    const auto source = directory.WriteFile("Fill.hlsl",
+        "RWStructuredBuffer<uint> Output : register(u0);\n"
+        "[numthreads(64, 1, 1)]\n"
+        "void main(uint3 id : SV_DispatchThreadID) { Output[id.x] = id.x * 2; }\n");
+    const auto broken = directory.WriteFile("Broken.hlsl", "[numthreads(1, 1, 1)] void main() { undefined(); }\n");
+
+    auto compile = [&](const std::filesystem::path& file, const std::filesystem::path& output)
+    {
+        return [=]()
+        {
+            const std::string command = std::string("\"") + RAYTRACEVS_DXC_EXECUTABLE + "\" -T cs_6_5 -E main -Fo \"" +
+                output.string() + "\" \"" + file.string() + "\" > \"" + output.string() + ".log\" 2>&1";
+            return std::system(command.c_str()) == 0 && std::filesystem::exists(output);
+        };
+    };
+
+    ShaderCompileQueue queue(2);
+    queue.Submit(L"Fill", compile(source, directory.GetPath() / "Fill.cso"));
+    queue.Submit(L"Broken", compile(broken, directory.GetPath() / "Broken.cso"));
+    CHECK(queue.Wait(L"Fill"));
+    CHECK(!queue.Wait(L"Broken"));
+    CHECK(std::filesystem::file_size(directory.GetPath() / "Fill.cso") > 0);
+}
+#endif
@@ -0,0 +1,131 @@
+#include "Test.h"
+#include "ShaderPermutation.h"
+#include "ShaderCacheCore.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+using namespace RayTraceVS::DXEngine;
+
+namespace
+{
+    std::string VariantName(const wchar_t* shaderName, uint32_t features)
+    {
+        return ToUtf8(GetShaderVariantName(shaderName, features));
+    }
+
+    std::string Defines(uint32_t features)
+    {
+        std::string text;
+        for (const auto& [name, value] : GetShaderFeatureDefines(features))
+            text += ToUtf8(name) + "=" + ToUtf8(value) + ";";
+        return text;
+    }
+}
+
+TEST_CASE("Default inputs select no features")
+{
+    CHECK_EQUAL(SelectShaderFeatures(ShaderFeatureInputs()), static_cast<uint32_t>(ShaderFeature_None));
+}
+
+TEST_CASE("Depth of field is kept only above the RayGen aperture threshold")
+{
+    ShaderFeatureInputs inputs;
+    inputs.apertureSize = 0.001f;
+    CHECK_EQUAL(SelectShaderFeatures(inputs), static_cast<uint32_t>(ShaderFeature_None));
+    inputs.apertureSize = std::nextafter(0.001f, 1.0f);
+    CHECK_EQUAL(SelectShaderFeatures(inputs), static_cast<uint32_t>(ShaderFeature_Dof));
+    inputs.apertureSize = 0.5f;
+    CHECK_EQUAL(SelectShaderFeatures(inputs), static_cast<uint32_t>(ShaderFeature_Dof));
+    inputs.apertureSize = -1.0f;
+    CHECK_EQUAL(SelectShaderFeatures(inputs), static_cast<uint32_t>(ShaderFeature_None));
+}
+
+TEST_CASE("Each remaining input maps to its own feature")
+{
+    ShaderFeatureInputs photons;
+    photons.photonMapSize = 1;
+    CHECK_EQUAL(SelectShaderFeatures(photons), static_cast<uint32_t>(ShaderFeature_Caustics));
+
+    ShaderFeatureInputs debug;
+    debug.photonDebugMode = 3;
+    CHECK_EQUAL(SelectShaderFeatures(debug), static_cast<uint32_t>(ShaderFeature_PhotonDebug));
+
+    ShaderFeatureInputs meshes;
+    meshes.meshInstanceCount = 1;
+    CHECK_EQUAL(SelectShaderFeatures(meshes), static_cast<uint32_t>(ShaderFeature_Meshes));
+
+    ShaderFeatureInputs denoiser;
+    denoiser.denoiserActive = true;
+    CHECK_EQUAL(SelectShaderFeatures(denoiser), static_cast<uint32_t>(ShaderFeature_NrdOutput));
+
+    ShaderFeatureInputs all;
+    all.apertureSize = 0.1f;
+    all.photonMapSize = 65536;
+    all.photonDebugMode = 1;
+    all.meshInstanceCount = 12;
+    all.denoiserActive = true;
+    CHECK_EQUAL(SelectShaderFeatures(all), static_cast<uint32_t>(ShaderFeature_All));
+}
+
+TEST_CASE("Feature superset test")
+{
+    CHECK(IsShaderFeatureSuperset(ShaderFeature_All, ShaderFeature_None));
+    CHECK(IsShaderFeatureSuperset(ShaderFeature_All, ShaderFeature_All));
+    CHECK(IsShaderFeatureSuperset(ShaderFeature_None, ShaderFeature_None));
+    CHECK(IsShaderFeatureSuperset(ShaderFeature_Dof | ShaderFeature_Meshes, ShaderFeature_Meshes));
+    CHECK(!IsShaderFeatureSuperset(ShaderFeature_Dof | ShaderFeature_Meshes, ShaderFeature_Caustics));
+    CHECK(!IsShaderFeatureSuperset(ShaderFeature_Dof, ShaderFeature_Dof | ShaderFeature_NrdOutput));
+    CHECK(!IsShaderFeatureSuperset(ShaderFeature_None, ShaderFeature_PhotonDebug));
+}
+
+TEST_CASE("Defines disable exactly the missing features, in variant order")
+{
+    CHECK_EQUAL(Defines(ShaderFeature_All), "");
+    CHECK_EQUAL(Defines(ShaderFeature_None), "DOF=0;CAUSTICS=0;PHOTON_DEBUG=0;HAS_MESHES=0;NRD_OUTPUT=0;");
+    CHECK_EQUAL(Defines(ShaderFeature_Caustics | ShaderFeature_Meshes), "DOF=0;PHOTON_DEBUG=0;NRD_OUTPUT=0;");
+    CHECK_EQUAL(Defines(ShaderFeature_All & ~ShaderFeature_NrdOutput), "NRD_OUTPUT=0;");
+}
+
+// Variant names are shader cache keys: a change here orphans every cached variant
+TEST_CASE("Variant names are stable")
+{
+    CHECK_EQUAL(VariantName(L"RayGen", ShaderFeature_All), "RayGen");
+    CHECK_EQUAL(VariantName(L"RayGen", ShaderFeature_None), "RayGen_DOF0_CAUSTICS0_PHOTON_DEBUG0_HAS_MESHES0_NRD_OUTPUT0");
+    CHECK_EQUAL(VariantName(L"RayGen", ShaderFeature_Dof | ShaderFeature_Caustics | ShaderFeature_PhotonDebug),
+        "RayGen_HAS_MESHES0_NRD_OUTPUT0");
+    CHECK_EQUAL(VariantName(L"RayGen", ShaderFeature_Caustics | ShaderFeature_Meshes),
+        "RayGen_DOF0_PHOTON_DEBUG0_NRD_OUTPUT0");
+    CHECK_EQUAL(VariantName(L"RayGen", ShaderFeature_All & ~ShaderFeature_Dof), "RayGen_DOF0");
+
+    // Every feature set gets its own name
+    std::vector<std::string> names;
+    for (uint32_t features = 0; features <= ShaderFeature_All; features++)
+        names.push_back(VariantName(L"RayGen", features));
+    std::sort(names.begin(), names.end());
+    CHECK(std::adjacent_find(names.begin(), names.end()) == names.end());
+}
+
+TEST_CASE("Feature descriptions list enabled features")
+{
+    CHECK_EQUAL(DescribeShaderFeatures(ShaderFeature_None), "none");
+    CHECK_EQUAL(DescribeShaderFeatures(ShaderFeature_Dof | ShaderFeature_NrdOutput), "DOF|NRD_OUTPUT");
+    CHECK_EQUAL(DescribeShaderFeatures(ShaderFeature_All), "DOF|CAUSTICS|PHOTON_DEBUG|HAS_MESHES|NRD_OUTPUT");
+}
+
+#ifdef RAYTRACEVS_SHADER_DIR
+TEST_CASE("Every feature define has a default in Common.hlsli")
+{
+    std::ifstream file(std::filesystem::path(RAYTRACEVS_SHADER_DIR) / "Common.hlsli", std::ios::binary);
+    REQUIRE(file.is_open());
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    for (const auto& [name, value] : GetShaderFeatureDefines(ShaderFeature_None))
+    {
+        const std::string guard = "#ifndef " + ToUtf8(name);
+        if (source.find(guard) == std::string::npos)
+            RayTraceVS::Tests::ReportFailure(__FILE__, __LINE__, "Common.hlsli has no " + guard);
+    }
+}
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ============================================
+// Minimal unit test harness
+// ============================================
+//
+// TEST_CASE registers a function with the runner in TestMain.cpp. CHECK / CHECK_EQUAL
+// record a failure and carry on; REQUIRE returns from the test case. The executable
+// exits non-zero if any check failed. An optional argument runs only the cases whose
+// name contains it.
+
+namespace RayTraceVS::Tests
+{
+    using TestFunction = void (*)();
+
+    struct TestRegistrar
+    {
+        TestRegistrar(const char* name, TestFunction function);
+    };
+
+    void ReportFailure(const char* file, int line, const std::string& message);
+
+    template<typename A, typename B>
+    void CheckEqual(const A& actual, const B& expected, const char* expression, const char* file, int line)
+    {
+        if (actual == expected)
+            return;
+        std::ostringstream message;
+        message << expression << "\n      actual:   " << actual << "\n      expected: " << expected;
+        ReportFailure(file, line, message.str());
+    }
+
+    // Fresh empty directory under the system temp directory, removed with its contents
+    class TemporaryDirectory
+    {
+    public:
+        TemporaryDirectory();
+        ~TemporaryDirectory();
+        TemporaryDirectory(const TemporaryDirectory&) = delete;
+        TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+        const std::filesystem::path& GetPath() const { return path; }
+        // Writes text to a file relative to the directory, creating parent directories
+        std::filesystem::path WriteFile(const std::filesystem::path& relative, const std::string& text) const;
+
+    private:
+        std::filesystem::path path;
+    };
+}
+
+#define RAYTRACEVS_TEST_CONCAT_INNER(a, b) a##b
+#define RAYTRACEVS_TEST_CONCAT(a, b) RAYTRACEVS_TEST_CONCAT_INNER(a, b)
+
+#define TEST_CASE(name) \
+    static void RAYTRACEVS_TEST_CONCAT(TestCase_, __LINE__)(); \
+    static const RayTraceVS::Tests::TestRegistrar RAYTRACEVS_TEST_CONCAT(TestRegistrar_, __LINE__)( \
+        name, &RAYTRACEVS_TEST_CONCAT(TestCase_, __LINE__)); \
+    static void RAYTRACEVS_TEST_CONCAT(TestCase_, __LINE__)()
+
+#define CHECK(expression) \
+    do \
+    { \
+        if (!(expression)) \
+            RayTraceVS::Tests::ReportFailure(__FILE__, __LINE__, #expression); \
+    } while (0)
+
+#define REQUIRE(expression) \
+    do \
+    { \
+        if (!(expression)) \
+        { \
+            RayTraceVS::Tests::ReportFailure(__FILE__, __LINE__, #expression); \
+            return; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+    RayTraceVS::Tests::CheckEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
@@ -0,0 +1,88 @@
+#include "Test.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace RayTraceVS::Tests
+{
+    namespace
+    {
+        struct TestCase
+        {
+            const char* name;
+            TestFunction function;
+        };
+
+        std::vector<TestCase>& GetTestCases()
+        {
+            static std::vector<TestCase> cases;
+            return cases;
+        }
+
+        int g_Failures = 0;
+    }
+
+    TestRegistrar::TestRegistrar(const char* name, TestFunction function)
+    {
+        GetTestCases().push_back({ name, function });
+    }
+
+    void ReportFailure(const char* file, int line, const std::string& message)
+    {
+        printf("    %s(%d): FAILED %s\n", file, line, message.c_str());
+        g_Failures++;
+    }
+
+    TemporaryDirectory::TemporaryDirectory()
+    {
+        static std::atomic<uint32_t> counter = 0;
+        const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        path = std::filesystem::temp_directory_path() /
+            ("RayTraceVS.Tests." + std::to_string(stamp) + "." + std::to_string(counter++));
+        std::filesystem::create_directories(path);
+    }
+
+    TemporaryDirectory::~TemporaryDirectory()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    std::filesystem::path TemporaryDirectory::WriteFile(const std::filesystem::path& relative, const std::string& text) const
+    {
+        const std::filesystem::path file = path / relative;
+        std::filesystem::create_directories(file.parent_path());
+        std::ofstream out(file, std::ios::binary);
+        out << text;
+        return file;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace RayTraceVS::Tests;
+
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failedCases = 0;
+    for (const TestCase& test : GetTestCases())
+    {
+        if (filter && !strstr(test.name, filter))
+            continue;
+
+        printf("[ RUN  ] %s\n", test.name);
+        fflush(stdout);
+        const int failuresBefore = g_Failures;
+        test.function();
+        const bool passed = g_Failures == failuresBefore;
+        printf("[ %s ] %s\n", passed ? " OK " : "FAIL", test.name);
+        run++;
+        if (!passed)
+            failedCases++;
+    }
+
+    printf("%d test cases, %d failed\n", run, failedCases);
+    return failedCases == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include "Test.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace RayTraceVS::DXEngine;
+
+TEST_CASE("Run calls every index exactly once")
+{
+    WorkerPool pool(3);
+    CHECK_EQUAL(pool.GetWorkerCount(), 3u);
+
+    std::vector<std::atomic<int>> calls(1000);
+    pool.Run(calls.size(), 0, [&](size_t i) { calls[i]++; });
+    for (size_t i = 0; i < calls.size(); i++)
+        CHECK_EQUAL(calls[i].load(), 1);
+
+    // Nothing to do and a single index both return straight away
+    pool.Run(0, 0, [&](size_t) { calls[0]++; });
+    pool.Run(1, 0, [&](size_t i) { calls[i]++; });
+    CHECK_EQUAL(calls[0].load(), 2);
+}
+
+TEST_CASE("maxThreads limits the threads working on a loop")
+{
+    WorkerPool pool(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto record = [&](size_t)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    };
+
+    pool.Run(32, 1, record);
+    CHECK_EQUAL(threads.size(), 1u);
+    CHECK(*threads.begin() == std::this_thread::get_id());
+
+    threads.clear();
+    pool.Run(32, 2, record);
+    CHECK(threads.size() <= 2u);
+}
+
+TEST_CASE("The pool grows when a loop asks for more threads")
+{
+    WorkerPool pool(1);
+    std::atomic<int> running = 0, peak = 0;
+    pool.Run(4, 4, [&](size_t)
+    {
+        const int now = ++running;
+        for (int seen = peak.load(); now > seen && !peak.compare_exchange_weak(seen, now);)
+        {
+        }
+        // Hold every index until all four run at once (or give up after a while)
+        const auto start = std::chrono::steady_clock::now();
+        while (peak.load() < 4 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+            std::this_thread::yield();
+        running--;
+    });
+    CHECK_EQUAL(pool.GetWorkerCount(), 3u);
+    CHECK_EQUAL(peak.load(), 4);
+}
+
+TEST_CASE("A loop started inside a loop finishes even with every worker busy")
+{
+    WorkerPool pool(2);
+    std::atomic<int> inner = 0;
+    pool.Run(3, 0, [&](size_t)
+    {
+        pool.Run(50, 0, [&](size_t) { inner++; });
+    });
+    CHECK_EQUAL(inner.load(), 150);
+}
+
+TEST_CASE("Concurrent callers share the workers")
+{
+    WorkerPool pool(3);
+    std::atomic<long long> sums[4] = {};
+    std::vector<std::thread> callers;
+    for (int c = 0; c < 4; c++)
+    {
+        callers.emplace_back([&, c]()
+        {
+            for (int repeat = 0; repeat < 50; repeat++)
+                pool.Run(100, 0, [&](size_t i) { sums[c] += static_cast<long long>(i); });
+        });
+    }
+    for (auto& caller : callers)
+        caller.join();
+
+    for (int c = 0; c < 4; c++)
+        CHECK_EQUAL(sums[c].load(), 50LL * 4950);
+}
+
+TEST_CASE("ParallelChunks covers the range with fixed, ordered chunks")
+{
+    constexpr size_t COUNT = 1003;
+    constexpr size_t CHUNKS = 10;
+    std::vector<size_t> begins(CHUNKS), ends(CHUNKS);
+    std::vector<std::atomic<int>> covered(COUNT);
+    ParallelChunks(COUNT, CHUNKS, 0, [&](size_t chunk, size_t begin, size_t end)
+    {
+        begins[chunk] = begin;
+        ends[chunk] = end;
+        for (size_t i = begin; i < end; i++)
+            covered[i]++;
+    });
+
+    // Chunk boundaries depend on the counts only, not on which thread ran what
+    for (size_t chunk = 0; chunk < CHUNKS; chunk++)
+    {
+        CHECK_EQUAL(begins[chunk], COUNT * chunk / CHUNKS);
+        CHECK_EQUAL(ends[chunk], COUNT * (chunk + 1) / CHUNKS);
+    }
+    for (size_t i = 0; i < COUNT; i++)
+        CHECK_EQUAL(covered[i].load(), 1);
+
+    int calls = 0;
+    ParallelChunks(0, CHUNKS, 0, [&](size_t, size_t, size_t) { calls++; });
+    ParallelChunks(COUNT, 0, 0, [&](size_t, size_t, size_t) { calls++; });
+    CHECK_EQUAL(calls, 0);
+}
+
+TEST_CASE("ParallelFor runs on the shared pool")
+{
+    std::vector<std::atomic<int>> calls(257);
+    ParallelFor(calls.size(), [&](size_t i) { calls[i]++; });
+    for (size_t i = 0; i < calls.size(); i++)
+        CHECK_EQUAL(calls[i].load(), 1);
+    CHECK(&WorkerPool::GetShared() == &WorkerPool::GetShared());
+}
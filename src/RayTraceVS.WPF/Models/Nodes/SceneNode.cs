@@ -224,7 +224,7 @@ namespace RayTraceVS.WPF.Models.Nodes
         }
 
         /// <summary>
-        /// シャドウ計算する最大ライト数 (パフォーマンス最適化, デフォルト 2)
+        /// 1ヒットあたりにライトBVHからサンプルするライト数 (1-4, デフォルト 2)
         /// </summary>
         private int _maxShadowLights = 2;
         public int MaxShadowLights
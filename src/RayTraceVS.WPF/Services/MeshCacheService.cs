@@ -4,6 +4,8 @@ using System.Diagnostics;
 using System.IO;
 using System.Linq;
 using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Security.Cryptography;
 using System.Text;
 using System.Threading.Tasks;
 using System.Windows;
@@ -23,11 +25,19 @@ namespace RayTraceVS.WPF.Services
         private const string CACHE_MAGIC = "RTVS";
         private const uint CACHE_VERSION = 1;
         private const int FLOATS_PER_VERTEX = 8; // position(3) + padding(1) + normal(3) + padding(1)
+        private const long DEFAULT_MEMORY_BUDGET_BYTES = 1L << 30; // 1GB
 
         // メタデータのみを保持（実際のデータは遅延読み込み）
         private readonly Dictionary<string, MeshMetadata> _meshMetadata = new();
-        // 読み込み済みのメッシュデータをキャッシュ
-        private readonly Dictionary<string, CachedMeshData> _loadedMeshes = new();
+        // 読み込み済みのメッシュデータをキャッシュ（メッシュ名 → 常駐データ）
+        private readonly Dictionary<string, ResidentMesh> _loadedMeshes = new();
+        // 内容（頂点+インデックスのSHA-256）が同一のメッシュは1つのデータを共有する
+        private readonly Dictionary<string, ResidentMesh> _meshesByContentHash = new();
+        // 常駐データのLRU（先頭が最近使われたもの）
+        private readonly LinkedList<ResidentMesh> _residentLru = new();
+        private long _residentBytes;
+        private long _useEpoch = 1;
+        private long _evictionCount;
         private readonly object _loadLock = new();
         private CacheManifest? _manifest;
 
@@ -41,6 +51,26 @@ namespace RayTraceVS.WPF.Services
         /// </summary>
         public static string CacheFolder => Path.Combine(AppDomain.CurrentDomain.BaseDirectory, "Resource", "Model", "Cache");
 
+        /// <summary>
+        /// 読み込み済みメッシュのメモリ予算（バイト）
+        /// 超えた分は現在のシーンで使われていないものから古い順に解放する
+        /// </summary>
+        public long MemoryBudgetBytes { get; set; } = DEFAULT_MEMORY_BUDGET_BYTES;
+
+        /// <summary>
+        /// 読み込み済みメッシュのメモリ使用状況
+        /// </summary>
+        public MeshMemoryStatistics MemoryStatistics
+        {
+            get
+            {
+                lock (_loadLock)
+                {
+                    return new MeshMemoryStatistics(MemoryBudgetBytes, _residentBytes, _residentLru.Count, _loadedMeshes.Count, _evictionCount);
+                }
+            }
+        }
+
         /// <summary>
         /// 利用可能なメッシュ名のリスト（キャッシュ済みのみ）
         /// </summary>
@@ -85,38 +115,130 @@ namespace RayTraceVS.WPF.Services
         /// </summary>
         public CachedMeshData? GetMesh(string meshName)
         {
-            // まず読み込み済みキャッシュをチェック
-            if (_loadedMeshes.TryGetValue(meshName, out var cachedData))
-            {
-                return cachedData;
-            }
-
             // メタデータが存在するかチェック
             if (!_meshMetadata.TryGetValue(meshName, out var metadata))
             {
                 return null;
             }
 
-            // ファイルから読み込み（スレッドセーフ）
+            // LRUを更新するため読み込み済みの場合もロックする
             lock (_loadLock)
             {
-                // ダブルチェック（他のスレッドが読み込み済みかもしれない）
-                if (_loadedMeshes.TryGetValue(meshName, out cachedData))
+                if (_loadedMeshes.TryGetValue(meshName, out var resident))
                 {
-                    return cachedData;
+                    Touch(resident);
+                    return resident.Data;
                 }
 
                 var sw = Stopwatch.StartNew();
                 var meshData = LoadMeshFromCache(metadata.CachePath);
-                if (meshData != null)
+                if (meshData == null)
+                {
+                    return null;
+                }
+
+                resident = ShareIdenticalMesh(meshData);
+                resident.Names.Add(meshName);
+                _loadedMeshes[meshName] = resident;
+                Touch(resident);
+                Debug.WriteLine($"Loaded mesh on demand: {meshName} ({meshData.VertexCount} vertices, {meshData.TriangleCount} triangles) in {sw.ElapsedMilliseconds}ms");
+                return resident.Data;
+            }
+        }
+
+        /// <summary>
+        /// シーン評価の開始：以降にGetMeshされたメッシュは次の評価まで解放しない（使用中として固定）
+        /// </summary>
+        public void BeginSceneEvaluation()
+        {
+            lock (_loadLock)
+            {
+                _useEpoch++;
+            }
+        }
+
+        /// <summary>
+        /// シーン評価の終了：予算を超えていれば、この評価で使われなかったメッシュを古い順に解放する
+        /// </summary>
+        public void EndSceneEvaluation()
+        {
+            lock (_loadLock)
+            {
+                TrimToBudget();
+            }
+        }
+
+        private void Touch(ResidentMesh resident)
+        {
+            resident.LastUseEpoch = _useEpoch;
+            _residentLru.Remove(resident.LruNode);
+            _residentLru.AddFirst(resident.LruNode);
+        }
+
+        private void TrimToBudget()
+        {
+            // 使用中のメッシュはLRUの先頭側に集まるので、末尾から使用中に当たるまで解放する
+            while (_residentBytes > MemoryBudgetBytes && _residentLru.Last is { } node && node.Value.LastUseEpoch != _useEpoch)
+            {
+                var resident = node.Value;
+                foreach (var name in resident.Names)
                 {
-                    _loadedMeshes[meshName] = meshData;
-                    Debug.WriteLine($"Loaded mesh on demand: {meshName} ({meshData.VertexCount} vertices, {meshData.TriangleCount} triangles) in {sw.ElapsedMilliseconds}ms");
+                    _loadedMeshes.Remove(name);
                 }
-                return meshData;
+                _meshesByContentHash.Remove(resident.ContentHash);
+                _residentLru.RemoveLast();
+                _residentBytes -= resident.Bytes;
+                _evictionCount++;
+                Debug.WriteLine($"Evicted mesh: {string.Join(", ", resident.Names)} ({resident.Bytes / (1024 * 1024)}MB), {_residentBytes / (1024 * 1024)}MB resident");
             }
         }
 
+        /// <summary>
+        /// 同じ内容のメッシュが読み込み済みならそのデータを返す（別名のFBXでも配列を共有）
+        /// ネイティブ側もジオメトリを内容で識別するため、BLASやGPUバッファも共有される
+        /// </summary>
+        private ResidentMesh ShareIdenticalMesh(CachedMeshData meshData)
+        {
+            var vertexBytes = MemoryMarshal.AsBytes(meshData.Vertices.AsSpan());
+            var indexBytes = MemoryMarshal.AsBytes(meshData.Indices.AsSpan());
+
+            using var hasher = IncrementalHash.CreateHash(HashAlgorithmName.SHA256);
+            hasher.AppendData(vertexBytes);
+            hasher.AppendData(indexBytes);
+            var contentHash = Convert.ToHexString(hasher.GetHashAndReset());
+
+            if (_meshesByContentHash.TryGetValue(contentHash, out var shared) &&
+                vertexBytes.SequenceEqual(MemoryMarshal.AsBytes(shared.Data.Vertices.AsSpan())) &&
+                indexBytes.SequenceEqual(MemoryMarshal.AsBytes(shared.Data.Indices.AsSpan())))
+            {
+                return shared;
+            }
+
+            var resident = new ResidentMesh(contentHash, meshData, vertexBytes.Length + indexBytes.Length);
+            _meshesByContentHash[contentHash] = resident;
+            _residentLru.AddFirst(resident.LruNode);
+            _residentBytes += resident.Bytes;
+            return resident;
+        }
+
+        private sealed class ResidentMesh
+        {
+            public ResidentMesh(string contentHash, CachedMeshData data, long bytes)
+            {
+                ContentHash = contentHash;
+                Data = data;
+                Bytes = bytes;
+                LruNode = new LinkedListNode<ResidentMesh>(this);
+            }
+
+            public string ContentHash { get; }
+            public CachedMeshData Data { get; }
+            public long Bytes { get; }
+            public List<string> Names { get; } = new();
+            public LinkedListNode<ResidentMesh> LruNode { get; }
+            public long LastUseEpoch { get; set; }
+        }
+
         /// <summary>
         /// メッシュのメタデータを取得（読み込みなし）
         /// </summary>
@@ -760,6 +882,11 @@ namespace RayTraceVS.WPF.Services
         public int IndexCount { get; set; }
     }
 
+    /// <summary>
+    /// 読み込み済みメッシュのメモリ使用状況
+    /// </summary>
+    public record MeshMemoryStatistics(long BudgetBytes, long ResidentBytes, int ResidentMeshes, int LoadedNames, long Evictions);
+
     /// <summary>
     /// メッシュのメタデータ（遅延読み込み用）
     /// ヘッダー情報のみを保持し、実際のデータはGetMesh()時に読み込む
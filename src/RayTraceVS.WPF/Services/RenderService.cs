@@ -1,4 +1,5 @@
 using System;
+using System.Runtime.InteropServices;
 using RayTraceVS.Interop;
 
 namespace RayTraceVS.WPF.Services
@@ -9,12 +10,20 @@ namespace RayTraceVS.WPF.Services
         private bool isInitialized = false;
         private bool disposed = false;
 
+        // エンジンが直接書き込むフレームバッファ（BGRA、トリプルバッファ）
+        private const int FrameBufferCount = 3;
+        private IntPtr[]? frameBuffers;
+
         public bool Initialize(IntPtr windowHandle, int width, int height)
         {
             try
             {
                 engineWrapper = new EngineWrapper(windowHandle, width, height);
                 isInitialized = engineWrapper.IsInitialized();
+                if (isInitialized)
+                {
+                    AllocateFrameBuffers(width, height);
+                }
                 return isInitialized;
             }
             catch (Exception ex)
@@ -103,6 +112,86 @@ namespace RayTraceVS.WPF.Services
             return engineWrapper.GetPixelData();
         }
 
+        /// <summary>
+        /// 最新フレーム（BGRA）を取得する。ReleaseFrame まで data の内容は上書きされない
+        /// </summary>
+        public bool TryAcquireFrame(out IntPtr data, out int rowPitch, out long frameNumber)
+        {
+            data = IntPtr.Zero;
+            rowPitch = 0;
+            frameNumber = 0;
+            if (!isInitialized || engineWrapper == null || frameBuffers == null)
+                return false;
+
+            return engineWrapper.AcquireFrame(ref data, ref rowPitch, ref frameNumber);
+        }
+
+        public void ReleaseFrame()
+        {
+            if (!isInitialized || engineWrapper == null)
+                return;
+
+            engineWrapper.ReleaseFrame();
+        }
+
+        /// <summary>
+        /// 使われなくなったメッシュのBLASを保持するGPUメモリ予算（超えた分は古い順に解放）
+        /// </summary>
+        public void SetMeshMemoryBudget(long budgetBytes)
+        {
+            if (!isInitialized || engineWrapper == null)
+                return;
+
+            engineWrapper.SetMeshMemoryBudget(budgetBytes);
+        }
+
+        public bool TryGetMeshMemoryUsage(out long residentBytes, out long budgetBytes, out int residentCount, out long evictions)
+        {
+            residentBytes = 0;
+            budgetBytes = 0;
+            residentCount = 0;
+            evictions = 0;
+            if (!isInitialized || engineWrapper == null)
+                return false;
+
+            return engineWrapper.GetMeshMemoryUsage(ref residentBytes, ref budgetBytes, ref residentCount, ref evictions);
+        }
+
+        private void AllocateFrameBuffers(int width, int height)
+        {
+            int rowPitch = width * 4;
+            var buffers = new IntPtr[FrameBufferCount];
+            for (int i = 0; i < buffers.Length; i++)
+            {
+                buffers[i] = Marshal.AllocHGlobal(rowPitch * height);
+            }
+
+            if (engineWrapper!.SetFrameBuffers(buffers, rowPitch, true))
+            {
+                frameBuffers = buffers;
+            }
+            else
+            {
+                // フレームシンクが使えない場合は GetPixelData にフォールバック
+                foreach (var buffer in buffers)
+                {
+                    Marshal.FreeHGlobal(buffer);
+                }
+            }
+        }
+
+        private void FreeFrameBuffers()
+        {
+            if (frameBuffers == null)
+                return;
+
+            foreach (var buffer in frameBuffers)
+            {
+                Marshal.FreeHGlobal(buffer);
+            }
+            frameBuffers = null;
+        }
+
         public void Dispose()
         {
             Dispose(true);
@@ -126,6 +215,9 @@ namespace RayTraceVS.WPF.Services
                 }
             }
 
+            // エンジン破棄後にフレームバッファを解放（エンジンが参照しなくなってから）
+            FreeFrameBuffers();
+
             isInitialized = false;
             disposed = true;
         }
@@ -65,6 +65,9 @@ namespace RayTraceVS.WPF.Services
                 AspectRatio = 16.0f / 9.0f
             };
 
+            // この評価で使うメッシュはメモリ予算の解放対象から外す
+            App.MeshCacheService?.BeginSceneEvaluation();
+
             var allNodes = nodeGraph.GetAllNodes();
             var connections = nodeGraph.GetAllConnections();
             
@@ -310,6 +313,8 @@ namespace RayTraceVS.WPF.Services
                 }
             }
 
+            App.MeshCacheService?.EndSceneEvaluation();
+
             return (spheres.ToArray(), planes.ToArray(), boxes.ToArray(), camera, lights.ToArray(), meshInstances.ToArray(), meshCaches.Values.ToArray(), samplesPerPixel, maxBounces, traceRecursionDepth, exposure, toneMapOperator, denoiserStabilization, shadowStrength, shadowAbsorptionScale, enableDenoiser, gamma, lightAttenuationConstant, lightAttenuationLinear, lightAttenuationQuadratic, maxShadowLights, nrdBypassDistance, nrdBypassBlendRange);
         }
 
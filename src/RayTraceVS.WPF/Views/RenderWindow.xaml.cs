@@ -348,19 +348,21 @@ namespace RayTraceVS.WPF.Views
         {
             while (true)
             {
-                byte[]? finalPixelData = null;
+                byte[]? skyPixelData = null;
+                bool frameReady = false;
                 double renderTimeMs = 0;
                 
                 try
                 {
                     // バックグラウンドスレッドで複数パスレンダリング
-                    finalPixelData = await Task.Run(() =>
+                    // 結果はエンジンがフレームバッファに直接書き込む（空シーンのみスカイバッファ）
+                    frameReady = await Task.Run(() =>
                     {
                         for (int i = 0; i < MinRenderPassesForTemporal; i++)
                         {
                             // レンダリング停止チェック
                             if (!isRendering || renderService == null)
-                                return null;
+                                return false;
 
                             // 同じパラメーターでシーン更新＆レンダリング
                             renderService.UpdateScene(
@@ -382,7 +384,8 @@ namespace RayTraceVS.WPF.Views
                                                sceneParams.MeshInstances.Length == 0);
                             if (emptyScene)
                             {
-                                return GetCachedSkyBuffer();
+                                skyPixelData = GetCachedSkyBuffer();
+                                return true;
                             }
                             
                             // レンダリング処理の時間のみを計測
@@ -392,14 +395,25 @@ namespace RayTraceVS.WPF.Views
                             renderTimeMs += _renderStopwatch.Elapsed.TotalMilliseconds;
                         }
                         
-                        // 最後にピクセルデータを取得
-                        return renderService?.GetPixelData();
+                        return renderService != null;
                     });
 
                     // UIスレッドで画面更新
-                    if (finalPixelData != null && isRendering)
+                    if (frameReady && isRendering)
                     {
-                        UpdateDisplay(finalPixelData);
+                        if (skyPixelData != null)
+                        {
+                            UpdateDisplay(skyPixelData);
+                        }
+                        else if (!UpdateDisplayFromFrameBuffer())
+                        {
+                            // フレームバッファ未設定時はピクセルデータを取得
+                            var pixelData = renderService?.GetPixelData();
+                            if (pixelData != null)
+                            {
+                                UpdateDisplay(pixelData);
+                            }
+                        }
                         
                         // 最初のフレームは初期化コストが含まれるためスキップ
                         if (_isFirstRender)
@@ -523,6 +537,44 @@ namespace RayTraceVS.WPF.Views
             }
         }
 
+        /// <summary>
+        /// エンジンが書き込んだ最新フレーム（BGRA）を画面に転送する
+        /// 行単位のコピーのみで、バイト順の変換や配列の確保は行わない
+        /// </summary>
+        private bool UpdateDisplayFromFrameBuffer()
+        {
+            if (renderBitmap == null || renderService == null)
+                return false;
+
+            if (!renderService.TryAcquireFrame(out IntPtr frameData, out int frameRowPitch, out _))
+                return false;
+
+            renderBitmap.Lock();
+            try
+            {
+                unsafe
+                {
+                    byte* pSrc = (byte*)frameData;
+                    byte* pBackBuffer = (byte*)renderBitmap.BackBuffer;
+                    int stride = renderBitmap.BackBufferStride;
+                    int rowSize = RenderWidth * 4;
+
+                    for (int y = 0; y < RenderHeight; y++)
+                    {
+                        Buffer.MemoryCopy(pSrc + (long)y * frameRowPitch, pBackBuffer + (long)y * stride, stride, rowSize);
+                    }
+                }
+                
+                renderBitmap.AddDirtyRect(new Int32Rect(0, 0, RenderWidth, RenderHeight));
+            }
+            finally
+            {
+                renderBitmap.Unlock();
+                renderService.ReleaseFrame();
+            }
+            return true;
+        }
+
         /// <summary>
         /// ウォームアップ用のダミーレンダリングを実行
         /// シェーダーコンパイルやパイプライン初期化を事前に完了させる
@@ -100,7 +100,7 @@ void ClosestHit_Triangle(inout RadiancePayload payload, in BuiltInTriangleInters
     float3 absorption = mat.absorption;
 
     // Debug: visualize material values as grayscale
-    if (payload.depth == 0 && Scene.PhotonDebugMode == 3)
+    if (payload.depth == 0 && ACTIVE_PHOTON_DEBUG_MODE == 3)
     {
         float t = saturate(transmission);
         payload.color = t.xxx;
@@ -108,7 +108,7 @@ void ClosestHit_Triangle(inout RadiancePayload payload, in BuiltInTriangleInters
         payload.specularRadiance = float3(0, 0, 0);
         return;
     }
-    if (payload.depth == 0 && Scene.PhotonDebugMode == 4)
+    if (payload.depth == 0 && ACTIVE_PHOTON_DEBUG_MODE == 4)
     {
         float m = saturate(metallic);
         payload.color = m.xxx;
@@ -17,6 +17,41 @@
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_DIRECTIONAL 2
 
+// Light BVH emitter type constants (must match LightEmitterType in LightBvh.h)
+#define LIGHT_EMITTER_LIGHT 0       // Lights[sourceIndex] (point or directional)
+#define LIGHT_EMITTER_SPHERE 1      // Emissive Spheres[sourceIndex]
+#define LIGHT_EMITTER_BOX 2         // Emissive Boxes[sourceIndex]
+#define LIGHT_EMITTER_INVALID 0xFFFFFFFF
+
+// ============================================
+// Feature Permutations
+// ============================================
+// ShaderCache compiles RayGen variants with the features the current scene does
+// not use defined to 0 (see ShaderPermutation.h). Anything left undefined stays
+// enabled, so the default build handles every scene.
+#ifndef DOF
+#define DOF 1                       // Thin-lens depth of field
+#endif
+#ifndef CAUSTICS
+#define CAUSTICS 1                  // Photon map gathering
+#endif
+#ifndef PHOTON_DEBUG
+#define PHOTON_DEBUG 1              // Scene.PhotonDebugMode visualizations
+#endif
+#ifndef HAS_MESHES
+#define HAS_MESHES 1                // Triangle mesh instances
+#endif
+#ifndef NRD_OUTPUT
+#define NRD_OUTPUT 1                // NRD/SIGMA G-buffer writes
+#endif
+
+// Photon debug mode as seen by the shader; a literal 0 lets the compiler drop the debug paths
+#if PHOTON_DEBUG
+#define ACTIVE_PHOTON_DEBUG_MODE (Scene.PhotonDebugMode)
+#else
+#define ACTIVE_PHOTON_DEBUG_MODE 0u
+#endif
+
 // ============================================
 // Photon Mapping for Caustics
 // ============================================
@@ -284,7 +319,7 @@ struct SceneConstantBuffer
     float ShadowStrength;       // 0.0 = no shadow, 1.0 = normal, >1.0 = darker
     float ShadowAbsorptionScale; // Beer absorption scale for colored transparent shadows
     uint FrameIndex;            // Frame counter for temporal noise variation
-    uint ShadowPadding;         // Padding for 16-byte alignment
+    uint RussianRouletteMinDepth;   // Bounces after which Russian roulette may end a path
     // Light attenuation parameters (physical-based)
     float LightAttenuationConstant;   // Constant term (usually 1.0)
     float LightAttenuationLinear;     // Linear term (distance proportional)
@@ -292,7 +327,17 @@ struct SceneConstantBuffer
     uint MaxShadowLights;             // Maximum lights for shadow calculation (optimization)
     // Mesh instance count
     uint NumMeshInstances;            // Number of FBX mesh instances
-    uint3 MeshPadding;                // Padding for 16-byte alignment
+    // Light BVH (many-light selection)
+    uint NumLightEmitters;            // Entries in LightEmitters (directional first)
+    uint NumDirectionalEmitters;
+    uint LightBvhNodeCount;           // 0 = no bounded emitters
+    float3 AmbientLight;              // Sum of the ambient lights (color * intensity)
+    float AmbientPadding;
+    // Environment map (EnvironmentMap.h)
+    uint EnvironmentWidth;            // Texels of EnvironmentTex (0 = not uploaded)
+    uint EnvironmentHeight;
+    float EnvironmentIntensity;
+    uint EnvironmentLighting;         // 1 = sample the environment as a light on diffuse surfaces
     // Matrices for motion vectors
     float4x4 ViewProjection;
     float4x4 PrevViewProjection;
@@ -378,6 +423,39 @@ struct LightData
     float padding;
 };
 
+// Light BVH emitter (must match C++ GPULightEmitter)
+struct LightEmitter
+{
+    uint type;          // LIGHT_EMITTER_*
+    uint sourceIndex;
+    float power;        // Luminance-weighted power used by the importance estimate
+    float area;         // Surface area (emissive primitives)
+};
+
+// Light BVH node (must match C++ GPULightBvhNode) - 64 bytes
+// Depth-first layout: the first child of an inner node is the next node
+struct LightBvhNode
+{
+    float3 boundsMin;
+    float power;
+    float3 boundsMax;
+    float cosThetaO;    // Cone around coneAxis holding every emitter normal
+    float3 coneAxis;
+    float cosThetaE;    // Emission spread beyond that cone
+    uint secondChildOrEmitter; // Inner: second child, leaf: emitter index
+    uint isLeaf;
+    uint2 padding;
+};
+
+// Environment alias table entry (must match C++ GPUEnvironmentAliasEntry)
+struct EnvironmentAliasEntry
+{
+    float threshold;    // Keep the entry when the in-bucket uniform is below it
+    uint alias;         // Otherwise take this one
+    float pdf;          // Discrete probability within its table
+    float padding;
+};
+
 // ============================================
 // Photon Structure for Caustics
 // ============================================
@@ -519,7 +597,12 @@ StructuredBuffer<uint> MeshIndices : register(t6);                  // 全メッ
 StructuredBuffer<MeshMaterial> MeshMaterials : register(t7);        // インスタンスごとのマテリアル
 StructuredBuffer<MeshInfo> MeshInfos : register(t8);                // メッシュ種類ごとのオフセット情報
 StructuredBuffer<MeshInstanceInfo> MeshInstances : register(t9);    // インスタンスごとの参照情報
-Texture2D<float4> BlueNoiseTex : register(t10);                     // 16x16 RGBA blue noise
+Texture2D<float4> BlueNoiseTex : register(t10);                     // 16x16 blue-noise ranks, one ranking per channel (Sampler.h)
+StructuredBuffer<LightBvhNode> LightBvhNodes : register(t11);       // Light BVH (LightBvh.h)
+StructuredBuffer<LightEmitter> LightEmitters : register(t12);       // Emitters referenced by its leaves
+Texture2D<float4> EnvironmentTex : register(t13);                   // Lat-long environment radiance
+StructuredBuffer<EnvironmentAliasEntry> EnvironmentAlias : register(t14); // Row marginal, then per-row conditionals
+SamplerState EnvironmentSampler : register(s0);                     // Linear, wrap U / clamp V
 
 // Photon map buffer (for caustics)
 RWStructuredBuffer<Photon> PhotonMap : register(u1);
@@ -606,7 +689,7 @@ float FresnelSchlick(float cosTheta, float f0)
 #define PI 3.14159265359
 
 // ============================================
-// RNG (PCG-based) for temporal stability
+// RNG dimension sets (SamplerSalt in Sampler.h)
 // ============================================
 #define RNG_SALT_AA 1u
 #define RNG_SALT_DOF 2u
@@ -616,6 +699,8 @@ float FresnelSchlick(float cosTheta, float f0)
 #define RNG_SALT_SHADOW 6u
 #define RNG_SALT_REFLECT 7u
 #define RNG_SALT_REFRACT 8u
+#define RNG_SALT_ENVIRONMENT 9u
+#define RNG_SALT_COUNT 10u          // Stride between bounces
 
 // GGX Normal Distribution Function (Trowbridge-Reitz)
 float GGX_D(float NdotH, float roughness)
@@ -696,62 +781,55 @@ float3 LambertDiffuse(float3 diffuseColor)
     return diffuseColor / PI;
 }
 
-// Get sky color for background (realistic atmospheric gradient)
-float3 GetSkyColor(float3 direction)
+// Lat-long coordinates of a direction (row 0 at the zenith, as in EnvironmentMap.cpp)
+float2 EnvironmentUv(float3 direction)
 {
     float3 dir = normalize(direction);
-    
-    // Vertical gradient factor (0 = horizon, 1 = zenith)
-    float elevation = dir.y;
-    float t = saturate(elevation);  // 0 at horizon, 1 at zenith
-    float tBelow = saturate(-elevation);  // For below horizon
-    
-    // Sky colors at different elevations
-    float3 zenithColor = float3(0.15, 0.35, 0.75);     // Deep blue at zenith
-    float3 skyMidColor = float3(0.35, 0.55, 0.90);     // Mid sky blue
-    float3 horizonColor = float3(0.70, 0.80, 0.95);    // Light blue-white at horizon
-    float3 horizonGlow = float3(0.95, 0.85, 0.70);     // Warm glow near horizon (atmospheric scattering)
-    float3 groundColor = float3(0.25, 0.28, 0.35);     // Dark blue-gray below horizon
-    
-    float3 skyColor;
-    
-    if (elevation >= 0.0)
-    {
-        // Above horizon - blend from horizon to zenith
-        // Use smoothstep for more natural gradient
-        float horizonFade = smoothstep(0.0, 0.15, t);    // Horizon to low sky
-        float midFade = smoothstep(0.1, 0.5, t);         // Low sky to mid sky
-        float zenithFade = smoothstep(0.4, 1.0, t);      // Mid sky to zenith
-        
-        // Layer the gradients
-        skyColor = horizonColor;
-        
-        // Add warm horizon glow (strongest at horizon, fades quickly)
-        float glowIntensity = 1.0 - smoothstep(0.0, 0.08, t);
-        skyColor = lerp(skyColor, horizonGlow, glowIntensity * 0.4);
-        
-        // Blend to mid sky
-        skyColor = lerp(skyColor, skyMidColor, horizonFade);
-        
-        // Blend to zenith
-        skyColor = lerp(skyColor, zenithColor, zenithFade);
-        
-        // Add subtle atmospheric haze near horizon (exponential falloff)
-        float hazeAmount = exp(-t * 8.0) * 0.3;
-        skyColor = lerp(skyColor, horizonColor, hazeAmount);
-    }
-    else
+    return float2((atan2(dir.z, dir.x) + PI) / (2.0 * PI), acos(clamp(dir.y, -1.0, 1.0)) / PI);
+}
+
+float3 EnvironmentDirection(float2 uv)
+{
+    float phi = uv.x * 2.0 * PI - PI;
+    float theta = uv.y * PI;
+    float sinTheta = sin(theta);
+    return float3(sinTheta * cos(phi), cos(theta), sinTheta * sin(phi));
+}
+
+// Get sky color for background: one fetch from the environment map (an .hdr, or the
+// built-in atmospheric gradient baked into the same table on the CPU)
+float3 GetSkyColor(float3 direction)
+{
+    return EnvironmentTex.SampleLevel(EnvironmentSampler, EnvironmentUv(direction), 0).rgb * Scene.EnvironmentIntensity;
+}
+
+uint SampleEnvironmentAlias(uint offset, uint count, float u)
+{
+    float scaled = u * count;
+    uint index = min((uint)scaled, count - 1);
+    EnvironmentAliasEntry entry = EnvironmentAlias[offset + index];
+    return (scaled - index) < entry.threshold ? index : entry.alias;
+}
+
+// Importance-samples a direction like EnvironmentMap::Sample; pdf is per solid angle (0 = no sample)
+float3 SampleEnvironment(float4 u, out float pdf)
+{
+    uint width = Scene.EnvironmentWidth;
+    uint height = Scene.EnvironmentHeight;
+    pdf = 0.0;
+    if (width == 0 || height == 0)
+        return float3(0, 1, 0);
+
+    uint row = SampleEnvironmentAlias(0, height, u.x);
+    uint column = SampleEnvironmentAlias(height + row * width, width, u.y);
+    float2 uv = float2((column + u.z) / width, (row + u.w) / height);
+    float sinTheta = sin(uv.y * PI);
+    if (sinTheta > 0.0)
     {
-        // Below horizon - blend from horizon to ground
-        float groundFade = smoothstep(0.0, 0.3, tBelow);
-        skyColor = lerp(horizonColor, groundColor, groundFade);
-        
-        // Dim the below-horizon area
-        skyColor *= lerp(0.8, 0.4, groundFade);
+        float pmf = EnvironmentAlias[row].pdf * EnvironmentAlias[height + row * width + column].pdf;
+        pdf = pmf * width * height / (2.0 * PI * PI * sinTheta);
     }
-    
-    // Keep sky intensity; exposure/tone-map handles brightness
-    return skyColor;
+    return EnvironmentDirection(uv);
 }
 
 // ============================================
@@ -777,23 +855,104 @@ uint PcgHash(uint v)
     return (word >> 22u) ^ word;
 }
 
+// ============================================
+// Low-discrepancy sampler (Sampler.h)
+// ============================================
+// A stream is (pixel, sequence index, depth, salt). Its first SOBOL_DIMENSIONS numbers
+// are an Owen-scrambled Sobol point (Burley 2020), shuffled and scrambled per dimension
+// set with seeds shared by a 16x16 tile; pixels of the tile are told apart by a toroidal
+// shift from the blue-noise rank tile, which spreads the error as blue noise. Further
+// numbers come from a PCG chain. The CPU path tracer draws the same numbers.
+#define SOBOL_DIMENSIONS 4u
+#define SOBOL_INDEX_BITS 24u
+#define RANK_TILE_SIZE 16u
+
+// Direction numbers (Joe and Kuo) of the first four dimensions, SOBOL_INDEX_BITS each
+static const uint SobolDirections[SOBOL_DIMENSIONS * SOBOL_INDEX_BITS] =
+{
+    0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+    0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+    0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+    0x80000000u, 0xC0000000u, 0xA0000000u, 0xF0000000u, 0x88000000u, 0xCC000000u, 0xAA000000u, 0xFF000000u,
+    0x80800000u, 0xC0C00000u, 0xA0A00000u, 0xF0F00000u, 0x88880000u, 0xCCCC0000u, 0xAAAA0000u, 0xFFFF0000u,
+    0x80008000u, 0xC000C000u, 0xA000A000u, 0xF000F000u, 0x88008800u, 0xCC00CC00u, 0xAA00AA00u, 0xFF00FF00u,
+    0x80000000u, 0xC0000000u, 0x60000000u, 0x90000000u, 0xE8000000u, 0x5C000000u, 0x8E000000u, 0xC5000000u,
+    0x68800000u, 0x9CC00000u, 0xEE600000u, 0x55900000u, 0x80680000u, 0xC09C0000u, 0x60EE0000u, 0x90550000u,
+    0xE8808000u, 0x5CC0C000u, 0x8E606000u, 0xC5909000u, 0x6868E800u, 0x9C9C5C00u, 0xEEEE8E00u, 0x5555C500u,
+    0x80000000u, 0xC0000000u, 0x20000000u, 0x50000000u, 0xF8000000u, 0x74000000u, 0xA2000000u, 0x93000000u,
+    0xD8800000u, 0x25400000u, 0x59E00000u, 0xE6D00000u, 0x78080000u, 0xB40C0000u, 0x82020000u, 0xC3050000u,
+    0x208F8000u, 0x51474000u, 0xFBEA2000u, 0x75D93000u, 0xA0858800u, 0x914E5400u, 0xDBE79E00u, 0x25DB6D00u
+};
+
+uint SobolSample(uint index, uint dimension)
+{
+    uint result = 0;
+    for (uint bit = 0; index != 0 && bit < SOBOL_INDEX_BITS; bit++, index >>= 1)
+    {
+        if (index & 1u)
+            result ^= SobolDirections[dimension * SOBOL_INDEX_BITS + bit];
+    }
+    return result;
+}
+
+// Owen scrambling: bit-reversed Laine-Karras permutation
+uint NestedUniformScramble(uint x, uint seed)
+{
+    x = reversebits(x);
+    x += seed;
+    x ^= x * 0x6C50B47Cu;
+    x ^= x * 0xB82F1E52u;
+    x ^= x * 0xC7AFE638u;
+    x ^= x * 0x8D22F6E6u;
+    return reversebits(x);
+}
+
 struct RNG
 {
-    uint state;
+    uint index;         // Shuffled sequence index
+    uint seed;          // Scramble seed of the dimension set
+    uint dimension;     // Next Sobol dimension, then the PCG chain
+    uint state;         // PCG chain beyond SOBOL_DIMENSIONS
+    uint4 shift;        // Blue-noise rank shift per Sobol dimension (fixed point)
 };
 
-RNG rng_init(uint2 pixel, uint frame, uint sample, uint salt)
+// sequenceIndex = FrameIndex * samplesPerPixel + sample
+RNG rng_init(uint2 pixel, uint sequenceIndex, uint depth, uint salt)
 {
-    uint s = pixel.x * 1973u + pixel.y * 9277u + frame * 26699u + sample * 31837u + salt * 911u;
+    uint dimensionSet = depth * RNG_SALT_COUNT + salt;
+    uint2 tile = pixel / RANK_TILE_SIZE;
+    uint tileSeed = PcgHash(tile.x ^ PcgHash(tile.y + 0x68E31DA4u));
+
     RNG r;
-    r.state = PcgHash(s);
+    r.seed = PcgHash(tileSeed ^ PcgHash(dimensionSet + 0x27D4EB2Fu));
+    r.index = NestedUniformScramble(sequenceIndex, r.seed) & ((1u << SOBOL_INDEX_BITS) - 1u);
+    r.dimension = 0;
+    r.state = PcgHash(pixel.x * 1973u + pixel.y * 9277u + sequenceIndex * 26699u + dimensionSet * 911u);
+
+    // Each dimension set reads the rank tile at its own toroidal offset
+    uint offset = PcgHash(dimensionSet * 0x85EBCA6Bu);
+    uint2 texel = (pixel + uint2(offset, offset >> 4)) & (RANK_TILE_SIZE - 1u);
+    uint4 rank = (uint4)round(BlueNoiseTex.Load(int3(texel, 0)) * 255.0);
+    r.shift = rank << 24;
     return r;
 }
 
 float rng_next(inout RNG r)
 {
-    r.state = PcgHash(r.state);
-    return (r.state >> 8) * (1.0 / 16777216.0);
+    uint bits;
+    if (r.dimension < SOBOL_DIMENSIONS)
+    {
+        // Toroidal shift in fixed point, so the result never rounds up to 1
+        uint dimensionSeed = PcgHash(r.seed ^ (0x9E3779B9u * (r.dimension + 1u)));
+        bits = NestedUniformScramble(SobolSample(r.index, r.dimension), dimensionSeed) + r.shift[r.dimension];
+        r.dimension++;
+    }
+    else
+    {
+        r.state = PcgHash(r.state);
+        bits = r.state;
+    }
+    return (bits >> 8) * (1.0 / 16777216.0);
 }
 
 // ============================================
@@ -967,115 +1126,185 @@ float3 GatherPhotons(float3 position, float3 normal, float radius)
 }
 
 // ============================================
-// Light Contribution Estimation (for shadow optimization)
+// Light BVH Sampling (many-light selection)
 // ============================================
+// Mirrors LightBvh::Sample in LightBvh.cpp. Directional lights are a short flat list in
+// front of the tree; the tree is walked from the root, choosing each child with probability
+// proportional to its estimated contribution, so a pick costs O(log N) and its probability
+// is exact. One uniform number drives the whole walk.
 
-// Light info structure for dominant light selection
-struct LightInfo
+#define MAX_LIGHT_SAMPLES 4         // Upper bound of Scene.MaxShadowLights
+
+// cos(max(0, a - b)) from the cosines and sines of a and b
+float LightCosSubClamped(float sinA, float cosA, float sinB, float cosB)
 {
-    uint index;
-    float contribution;
-};
+    return (cosA > cosB) ? 1.0 : cosA * cosB + sinA * sinB;
+}
 
-// Estimate light contribution without tracing shadow rays (fast)
-// Used to select dominant lights for shadow calculation
-float EstimateLightContribution(float3 hitPos, float3 normal, LightData light)
+// sin(max(0, a - b))
+float LightSinSubClamped(float sinA, float cosA, float sinB, float cosB)
 {
-    if (light.type == LIGHT_TYPE_AMBIENT)
-        return light.intensity * Luminance(light.color.rgb) * 0.5; // Lower weight for ambient
-    
-    float3 L;
-    float attenuation = 1.0;
-    
-    if (light.type == LIGHT_TYPE_DIRECTIONAL)
-    {
-        L = normalize(-light.position);
-    }
-    else // LIGHT_TYPE_POINT
+    return (cosA > cosB) ? 0.0 : sinA * cosB - cosA * sinB;
+}
+
+// Upper estimate of what a node can contribute to a point (power, orientation cone,
+// receiver normal and distance to its bounds)
+float LightNodeImportance(LightBvhNode node, float3 hitPos, float3 normal)
+{
+    if (node.power <= 0.0)
+        return 0.0;
+
+    float3 center = (node.boundsMin + node.boundsMax) * 0.5;
+    float radius = length(node.boundsMax - node.boundsMin) * 0.5;
+    float3 offset = hitPos - center;
+    float dist = length(offset);
+
+    // Angle subtended by the node's bounding sphere
+    float sinThetaB = 1.0;
+    float cosThetaB = -1.0;
+    if (dist > radius)
     {
-        float3 toLight = light.position - hitPos;
-        float dist = length(toLight);
-        L = toLight / max(dist, 0.001);
-        attenuation = ComputeAttenuationFromScene(dist);
+        sinThetaB = radius / dist;
+        cosThetaB = sqrt(max(0.0, 1.0 - sinThetaB * sinThetaB));
     }
-    
-    float NdotL = max(dot(normal, L), 0.0);
-    return NdotL * attenuation * light.intensity * Luminance(light.color.rgb);
+    float3 toPoint = dist > 0.0 ? offset / dist : node.coneAxis;
+
+    // Emission term: angle between the cone and the point, minus the cone and the bounds
+    float cosThetaW = dot(node.coneAxis, toPoint);
+    float sinThetaW = sqrt(max(0.0, 1.0 - cosThetaW * cosThetaW));
+    float sinThetaO = sqrt(max(0.0, 1.0 - node.cosThetaO * node.cosThetaO));
+    float cosThetaX = LightCosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float sinThetaX = LightSinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float cosThetaP = LightCosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= node.cosThetaE)
+        return 0.0;
+
+    // Receiver term: the most favourable incidence over the bounds
+    float cosThetaI = -dot(normal, toPoint);
+    float sinThetaI = sqrt(max(0.0, 1.0 - cosThetaI * cosThetaI));
+    float cosThetaIP = LightCosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    if (cosThetaIP <= 0.0)
+        return 0.0;
+
+    return node.power * cosThetaP * cosThetaIP * ComputeAttenuationFromScene(max(dist, radius));
 }
 
-// Select top N dominant lights based on estimated contribution
-// Returns number of lights selected (up to maxLights)
-uint SelectDominantLights(float3 hitPos, float3 normal, out LightInfo topLights[2])
+float DirectionalEmitterImportance(LightEmitter emitter, float3 normal)
 {
-    // Initialize
-    topLights[0].index = 0;
-    topLights[0].contribution = -1.0;
-    topLights[1].index = 0;
-    topLights[1].contribution = -1.0;
-    
-    uint maxShadowLights = min(Scene.MaxShadowLights, 2u);
-    if (maxShadowLights == 0) maxShadowLights = 2; // Default fallback
-    
-    uint selectedCount = 0;
-    
+    float3 toLight = normalize(-Lights[emitter.sourceIndex].position);
+    return emitter.power * max(dot(normal, toLight), 0.0);
+}
+
+// Picks one emitter for a shading point; u in [0, 1). Returns LIGHT_EMITTER_INVALID when
+// nothing can reach the point, otherwise pmf is the probability of the pick.
+uint SampleLightEmitter(float3 hitPos, float3 normal, float u, out float pmf)
+{
+    pmf = 0.0;
+    float directionalTotal = 0.0;
     [loop]
-    for (uint li = 0; li < Scene.NumLights && li < 8; li++)
+    for (uint i = 0; i < Scene.NumDirectionalEmitters; i++)
     {
-        LightData light = Lights[li];
-        if (light.type == LIGHT_TYPE_AMBIENT)
-            continue;
-        
-        float contribution = EstimateLightContribution(hitPos, normal, light);
-        
-        // Insert into sorted list (top 2)
-        if (contribution > topLights[0].contribution)
+        directionalTotal += DirectionalEmitterImportance(LightEmitters[i], normal);
+    }
+    float treeImportance = (Scene.LightBvhNodeCount > 0) ? LightNodeImportance(LightBvhNodes[0], hitPos, normal) : 0.0;
+    float total = directionalTotal + treeImportance;
+    if (total <= 0.0)
+        return LIGHT_EMITTER_INVALID;
+
+    float directionalProbability = directionalTotal / total;
+    if (u < directionalProbability)
+    {
+        // Directional lights, proportional to their importance
+        float target = min(u / directionalProbability, 0.99999994) * directionalTotal;
+        [loop]
+        for (uint d = 0; d < Scene.NumDirectionalEmitters; d++)
         {
-            topLights[1] = topLights[0];
-            topLights[0].index = li;
-            topLights[0].contribution = contribution;
-            selectedCount = min(selectedCount + 1, maxShadowLights);
+            float importance = DirectionalEmitterImportance(LightEmitters[d], normal);
+            if (target < importance || d + 1 == Scene.NumDirectionalEmitters)
+            {
+                pmf = importance / total;
+                return importance > 0.0 ? d : LIGHT_EMITTER_INVALID;
+            }
+            target -= importance;
         }
-        else if (contribution > topLights[1].contribution && maxShadowLights > 1)
+        return LIGHT_EMITTER_INVALID;
+    }
+
+    // Tree descent: u is rescaled at every level
+    u = min((u - directionalProbability) / (1.0 - directionalProbability), 0.99999994);
+    pmf = 1.0 - directionalProbability;
+    uint nodeIndex = 0;
+    [loop]
+    while (LightBvhNodes[nodeIndex].isLeaf == 0)
+    {
+        uint first = nodeIndex + 1;
+        uint second = LightBvhNodes[nodeIndex].secondChildOrEmitter;
+        float importanceFirst = LightNodeImportance(LightBvhNodes[first], hitPos, normal);
+        float importanceSecond = LightNodeImportance(LightBvhNodes[second], hitPos, normal);
+        float sum = importanceFirst + importanceSecond;
+        if (sum <= 0.0)
+        {
+            pmf = 0.0;
+            return LIGHT_EMITTER_INVALID;
+        }
+
+        float probabilityFirst = importanceFirst / sum;
+        if (u < probabilityFirst)
+        {
+            u = min(u / probabilityFirst, 0.99999994);
+            pmf *= probabilityFirst;
+            nodeIndex = first;
+        }
+        else
         {
-            topLights[1].index = li;
-            topLights[1].contribution = contribution;
-            selectedCount = min(selectedCount + 1, maxShadowLights);
+            u = min((u - probabilityFirst) / (1.0 - probabilityFirst), 0.99999994);
+            pmf *= 1.0 - probabilityFirst;
+            nodeIndex = second;
         }
     }
-    
-    return selectedCount;
+    return LightBvhNodes[nodeIndex].secondChildOrEmitter;
 }
 
-// Check if light index is in the top lights list
-bool IsInTopLights(uint lightIndex, LightInfo topLights[2], uint topCount)
+// Chooses the emitters whose light is evaluated at a hit. With no more emitters than the
+// budget (Scene.MaxShadowLights, 0 = 2) every one is taken with weight 1; otherwise the
+// budget is spent on stratified light BVH samples weighted by 1 / (pmf * budget), so the
+// estimate stays unbiased and the cost does not grow with the number of lights.
+uint SelectLightEmitters(float3 hitPos, float3 normal, inout uint seed,
+    out uint emitters[MAX_LIGHT_SAMPLES], out float weights[MAX_LIGHT_SAMPLES])
 {
-    for (uint i = 0; i < topCount; i++)
+    [unroll]
+    for (uint k = 0; k < MAX_LIGHT_SAMPLES; k++)
     {
-        if (topLights[i].index == lightIndex && topLights[i].contribution > 0.0)
-            return true;
+        emitters[k] = LIGHT_EMITTER_INVALID;
+        weights[k] = 0.0;
     }
-    return false;
-}
 
-// Compute shadow sample count based on light importance
-// Higher contribution lights get more samples
-uint ComputeShadowSamples(LightData light, LightInfo topLights[2], uint lightIndex)
-{
-    uint baseSamples = clamp((uint)light.softShadowSamples, 1, 16);
-    
-    // If this is the primary light, use full samples
-    if (topLights[0].index == lightIndex)
-        return baseSamples;
-    
-    // Secondary lights get reduced samples (importance sampling)
-    if (topLights[1].index == lightIndex)
+    uint budget = (Scene.MaxShadowLights == 0) ? 2u : min(Scene.MaxShadowLights, (uint)MAX_LIGHT_SAMPLES);
+    if (Scene.NumLightEmitters <= budget)
     {
-        float ratio = topLights[1].contribution / max(topLights[0].contribution, 0.001);
-        uint reducedSamples = max(1u, (uint)(baseSamples * ratio));
-        return min(reducedSamples, baseSamples / 2 + 1);
+        [loop]
+        for (uint e = 0; e < Scene.NumLightEmitters; e++)
+        {
+            emitters[e] = e;
+            weights[e] = 1.0;
+        }
+        return Scene.NumLightEmitters;
     }
-    
-    return 1; // Fallback to single sample
+
+    uint count = 0;
+    float jitter = RandomFloat(seed);
+    [loop]
+    for (uint s = 0; s < budget; s++)
+    {
+        float pmf;
+        uint emitter = SampleLightEmitter(hitPos, normal, (s + jitter) / budget, pmf);
+        if (emitter == LIGHT_EMITTER_INVALID || pmf <= 0.0)
+            continue;
+        emitters[count] = emitter;
+        weights[count] = 1.0 / (pmf * budget);
+        count++;
+    }
+    return count;
 }
 
 // ============================================
@@ -1152,7 +1381,7 @@ float3 GetShadowAbsorption(uint objectType, uint objectIndex)
     {
         return Boxes[objectIndex].absorption;
     }
-    if (objectType == OBJECT_TYPE_MESH)
+    if (HAS_MESHES && objectType == OBJECT_TYPE_MESH)
     {
         MeshInstanceInfo instInfo = MeshInstances[objectIndex];
         MeshMaterial mat = MeshMaterials[instInfo.materialIndex];
@@ -1356,6 +1585,129 @@ SoftShadowResult CalculateSoftShadow(float3 hitPos, float3 normal, LightData lig
     }
 }
 
+// Direct light from one selected emitter. Returns false when it cannot light the point;
+// otherwise L is the direction to the light sample, radiance the unshadowed incident
+// radiance scaled by the selection weight, and shadow its visibility.
+// Emissive surfaces are sampled uniformly by area (for spheres, the half facing the point,
+// the only part it can see) and fall off physically with 1/d^2.
+bool EvaluateLightEmitter(uint emitterIndex, float weight, float3 hitPos, float3 normal, inout uint seed,
+    out float3 L, out float3 radiance, out SoftShadowResult shadow)
+{
+    L = normal;
+    radiance = float3(0, 0, 0);
+    shadow.visibility = 1.0;
+    shadow.penumbra = 0.0;
+    shadow.occluderDistance = NRD_FP16_MAX;
+    shadow.shadowColor = float3(1, 1, 1);
+
+    LightEmitter emitter = LightEmitters[emitterIndex];
+    if (emitter.type == LIGHT_EMITTER_LIGHT)
+    {
+        LightData light = Lights[emitter.sourceIndex];
+        float attenuation = 1.0;
+        if (light.type == LIGHT_TYPE_DIRECTIONAL)
+        {
+            L = normalize(-light.position);
+        }
+        else
+        {
+            float3 toLight = light.position - hitPos;
+            float lightDist = length(toLight);
+            L = toLight / max(lightDist, 1e-4);
+            // P1-1: Physical-based attenuation
+            attenuation = ComputeAttenuationFromScene(lightDist);
+        }
+        if (dot(normal, L) <= 0.0)
+            return false;
+
+        shadow = CalculateSoftShadow(hitPos, normal, light, seed);
+        radiance = light.color.rgb * light.intensity * attenuation * weight;
+        return true;
+    }
+
+    float3 samplePos;
+    float3 sampleNormal;
+    float3 emission;
+    float area;
+    if (emitter.type == LIGHT_EMITTER_SPHERE)
+    {
+        SphereData sphere = Spheres[emitter.sourceIndex];
+        float3 axis = hitPos - sphere.center;
+        if (dot(axis, axis) <= sphere.radius * sphere.radius)
+            return false;
+        sampleNormal = RandomInHemisphere(normalize(axis), seed);
+        samplePos = sphere.center + sampleNormal * sphere.radius;
+        emission = sphere.emission;
+        area = 2.0 * PI * sphere.radius * sphere.radius;
+    }
+    else // LIGHT_EMITTER_BOX
+    {
+        BoxData box = Boxes[emitter.sourceIndex];
+        // Face pair by area, then side and position on the face
+        float3 faceArea = float3(box.size.y * box.size.z, box.size.z * box.size.x, box.size.x * box.size.y);
+        float pick = RandomFloat(seed) * (faceArea.x + faceArea.y + faceArea.z);
+        float side = RandomFloat(seed) < 0.5 ? -1.0 : 1.0;
+        float2 uv = float2(RandomFloat(seed), RandomFloat(seed)) * 2.0 - 1.0;
+        float3 local;
+        if (pick < faceArea.x)
+        {
+            local = float3(side, uv.x, uv.y) * box.size;
+            sampleNormal = box.axisX * side;
+        }
+        else if (pick < faceArea.x + faceArea.y)
+        {
+            local = float3(uv.x, side, uv.y) * box.size;
+            sampleNormal = box.axisY * side;
+        }
+        else
+        {
+            local = float3(uv.x, uv.y, side) * box.size;
+            sampleNormal = box.axisZ * side;
+        }
+        samplePos = box.center + box.axisX * local.x + box.axisY * local.y + box.axisZ * local.z;
+        emission = box.emission;
+        area = 8.0 * (faceArea.x + faceArea.y + faceArea.z);
+    }
+
+    float3 toSample = samplePos - hitPos;
+    float sampleDist = length(toSample);
+    L = toSample / max(sampleDist, 1e-4);
+    float cosLight = -dot(sampleNormal, L);
+    if (cosLight <= 0.0 || dot(normal, L) <= 0.0)
+        return false;
+
+    // Stop short of the emitter itself
+    float occluderDistance;
+    float3 sampleShadowColor;
+    shadow.visibility = TraceSingleShadowRay(hitPos + normal * 0.001, L, sampleDist * 0.999 - 0.001, occluderDistance, sampleShadowColor);
+    shadow.occluderDistance = shadow.visibility < 0.99 ? occluderDistance : NRD_FP16_MAX;
+    shadow.shadowColor = sampleShadowColor;
+    radiance = emission * (cosLight * area / max(sampleDist * sampleDist, 1e-4)) * weight;
+    return true;
+}
+
+// One importance-sampled environment direction for the diffuse lobe. radiance is already
+// divided by the sampling pdf and shadowed; false when the direction is below the surface.
+bool EvaluateEnvironmentLight(float3 hitPos, float3 normal, inout RNG rng, out float3 L, out float3 radiance)
+{
+    radiance = float3(0, 0, 0);
+    float4 u;
+    u.x = rng_next(rng);
+    u.y = rng_next(rng);
+    u.z = rng_next(rng);
+    u.w = rng_next(rng);
+    float pdf;
+    L = SampleEnvironment(u, pdf);
+    if (pdf <= 0.0 || dot(normal, L) <= 0.0)
+        return false;
+
+    float occluderDistance;
+    float3 shadowColor;
+    float visibility = TraceSingleShadowRay(hitPos + normal * 0.001, L, 10000.0, occluderDistance, shadowColor);
+    radiance = GetSkyColor(L) * shadowColor * (visibility / pdf);
+    return true;
+}
+
 // Select a primary light for SIGMA shadow denoising
 bool GetPrimaryShadowForSigma(float3 hitPos, float3 normal, inout uint seed, out SoftShadowResult result)
 {
@@ -1,34 +1,24 @@
 // Full RayGen shader with multi-sampling and DoF
 #include "Common.hlsli"
 
-uint RngSampleIndex(uint sampleIndex, uint depth)
-{
-    return sampleIndex + depth * 4096u;
-}
-
-float4 SampleBlueNoise(uint2 pixel, uint frame, uint sampleIndex)
-{
-    uint blueNoiseFrame = frame;
-    uint2 offset = uint2(blueNoiseFrame * 3u + sampleIndex * 11u, blueNoiseFrame * 5u + sampleIndex * 7u);
-    uint2 p = (pixel + offset) & 15u; // 16x16 tile
-    return BlueNoiseTex.Load(int3(p, 0));
-}
-
 // PerturbReflection is now in Common.hlsli (P1-3: code deduplication)
 
 // Generate random offset for anti-aliasing
-float2 RandomInPixel(uint2 pixel, uint sampleIndex)
+float2 RandomInPixel(uint2 pixel, uint sequenceIndex)
 {
-    float4 bn = SampleBlueNoise(pixel, Scene.FrameIndex, sampleIndex);
-    return bn.xy;
+    RNG rng = rng_init(pixel, sequenceIndex, 0, RNG_SALT_AA);
+    float2 u;
+    u.x = rng_next(rng);
+    u.y = rng_next(rng);
+    return u;
 }
 
 // Generate random point on disk for DoF
-float2 RandomOnDisk(uint2 pixel, uint sampleIndex)
+float2 RandomOnDisk(uint2 pixel, uint sequenceIndex)
 {
-    float4 bn = SampleBlueNoise(pixel, Scene.FrameIndex, sampleIndex);
-    float r = sqrt(bn.z);
-    float theta = bn.w * 6.28318530718;
+    RNG rng = rng_init(pixel, sequenceIndex, 0, RNG_SALT_DOF);
+    float r = sqrt(rng_next(rng));
+    float theta = rng_next(rng) * 6.28318530718;
     return float2(r * cos(theta), r * sin(theta));
 }
 
@@ -63,7 +53,7 @@ void RayGen()
     // DoFパラメータ
     float apertureSize = Scene.ApertureSize;
     float focusDistance = Scene.FocusDistance;
-    bool dofEnabled = apertureSize > 0.001;
+    bool dofEnabled = DOF && apertureSize > 0.001;
     
     // サンプル数を取得（最小1、最大64）
     uint sampleCount = clamp(Scene.SamplesPerPixel, 1, 64);
@@ -106,8 +96,11 @@ void RayGen()
     
     for (uint s = 0; s < sampleCount; s++)
     {
+        // Position of this sample in the pixel's low-discrepancy sequence
+        uint sequenceIndex = Scene.FrameIndex * sampleCount + s;
+
         // ピクセル内のランダムオフセット（アンチエイリアシング）
-        float2 offset = (sampleCount > 1) ? RandomInPixel(launchIndex, s) : float2(0.5, 0.5);
+        float2 offset = (sampleCount > 1) ? RandomInPixel(launchIndex, sequenceIndex) : float2(0.5, 0.5);
         
         // NDC座標計算（-1 to 1）
         float2 pixelCenter = (float2)launchIndex + offset;
@@ -130,7 +123,7 @@ void RayGen()
             float3 focusPoint = cameraPos + rayDir * focusDistance;
             
             // アパーチャ上のランダムな点
-            float2 diskOffset = RandomOnDisk(launchIndex, s) * apertureSize;
+            float2 diskOffset = RandomOnDisk(launchIndex, sequenceIndex) * apertureSize;
             rayOrigin = cameraPos + cameraRight * diskOffset.x + cameraUp * diskOffset.y;
             
             // 新しいレイ方向（フォーカス点に向かう）
@@ -140,7 +133,6 @@ void RayGen()
         // ============================================
         // WorkItem queue (per-pixel, stored in UAV)
         // ============================================
-        const float throughputThreshold = 0.01;
         uint pixelIndex = launchIndex.y * launchDim.x + launchIndex.x;
         uint baseIndex = pixelIndex * WORK_QUEUE_STRIDE;
         uint queueCount = 0;
@@ -192,11 +184,23 @@ void RayGen()
                 continue;
             }
             
+            // Russian roulette: from RussianRouletteMinDepth on, a path whose throughput is below 1
+            // survives with probability equal to its largest component and is scaled back up, so
+            // the image is unchanged in expectation. The glass lobe choice draws the next number.
+            RNG rrRng = rng_init(launchIndex, sequenceIndex, state.depth, RNG_SALT_RR);
             float maxThroughput = max(state.throughput.r, max(state.throughput.g, state.throughput.b));
-            if (maxThroughput < throughputThreshold && (state.pathFlags & PATH_FLAG_SPECULAR) == 0)
+            if (maxThroughput <= 0.0)
             {
                 continue;
             }
+            if (state.depth >= Scene.RussianRouletteMinDepth && maxThroughput < 1.0)
+            {
+                if (rng_next(rrRng) >= maxThroughput)
+                {
+                    continue;
+                }
+                state.throughput /= maxThroughput;
+            }
             
             // レイディスクリプタ
             RayDesc ray;
@@ -269,12 +273,11 @@ void RayGen()
             float specular = st.x;
             float transmission = st.y;
             float ior = io.x;
-            uint rngSampleIndex = RngSampleIndex(s, payload.depth);
-            RNG shadowRng = rng_init(launchIndex, Scene.FrameIndex, rngSampleIndex, RNG_SALT_SHADOW);
+            RNG shadowRng = rng_init(launchIndex, sequenceIndex, payload.depth, RNG_SALT_SHADOW);
             uint seed = shadowRng.state;
             
             // Shade in RayGen to keep TraceRay calls centralized here.
-            if (payload.hit && !(payload.depth == 0 && (Scene.PhotonDebugMode == 3 || Scene.PhotonDebugMode == 4)))
+            if (payload.hit && !(payload.depth == 0 && (ACTIVE_PHOTON_DEBUG_MODE == 3 || ACTIVE_PHOTON_DEBUG_MODE == 4)))
             {
                 float3 V = -state.direction;
                 float3 baseColor = payload.albedo;
@@ -290,14 +293,19 @@ void RayGen()
                         float f0FromIor = pow((ior - 1.0) / (ior + 1.0), 2.0);
                         float specularBlend = saturate(specular);
                         float f0 = lerp(f0FromIor, specularBlend, specularBlend);
-                        for (uint li = 0; li < Scene.NumLights; li++)
+                        uint highlightEmitters[MAX_LIGHT_SAMPLES];
+                        float highlightWeights[MAX_LIGHT_SAMPLES];
+                        uint highlightCount = SelectLightEmitters(hitPosition, N, seed, highlightEmitters, highlightWeights);
+                        for (uint hl = 0; hl < highlightCount; hl++)
                         {
-                            LightData light = Lights[li];
-                            if (light.type == LIGHT_TYPE_AMBIENT)
+                            // Emissive surfaces are seen directly by the reflection ray
+                            LightEmitter emitter = LightEmitters[highlightEmitters[hl]];
+                            if (emitter.type != LIGHT_EMITTER_LIGHT)
                                 continue;
+                            LightData light = Lights[emitter.sourceIndex];
 
                             float3 lightDir;
-                            float attenuation = 1.0;
+                            float attenuation = highlightWeights[hl];
                             if (light.type == LIGHT_TYPE_DIRECTIONAL)
                             {
                                 lightDir = normalize(-light.position);
@@ -307,7 +315,7 @@ void RayGen()
                                 lightDir = normalize(light.position - hitPosition);
                                 float lightDist = length(light.position - hitPosition);
                                 // P1-1: Physical-based attenuation
-                                attenuation = ComputeAttenuationFromScene(lightDist);
+                                attenuation *= ComputeAttenuationFromScene(lightDist);
                             }
 
                             float ndotl = max(0.0, dot(N, lightDir));
@@ -348,103 +356,61 @@ void RayGen()
                     bestShadowForSigma.shadowColor = float3(1, 1, 1);
                     float bestShadowWeight = -1.0;
 
-                    if (Scene.NumLights > 0)
+                    if (Scene.NumLights > 0 || Scene.NumLightEmitters > 0)
                     {
-                        // P0-1 Optimization: Select dominant lights for shadow calculation
-                        // Only trace shadow rays for the most influential lights
-                        LightInfo topLights[2];
-                        uint topCount = SelectDominantLights(hitPosition, N, topLights);
-                        
-                        for (uint li = 0; li < Scene.NumLights; li++)
-                        {
-                            LightData light = Lights[li];
-                            if (light.type == LIGHT_TYPE_AMBIENT)
-                            {
-                                ambient += light.color.rgb * light.intensity * lerp(diffuseColor, baseColor * 0.3, metallic);
-                                continue;
-                            }
+                        ambient = Scene.AmbientLight * lerp(diffuseColor, baseColor * 0.3, metallic);
 
+                        // Light BVH selection: a fixed number of emitters per hit, each weighted by
+                        // its selection probability, however many lights the scene has
+                        uint selectedEmitters[MAX_LIGHT_SAMPLES];
+                        float selectionWeights[MAX_LIGHT_SAMPLES];
+                        uint selectedCount = SelectLightEmitters(hitPosition, N, seed, selectedEmitters, selectionWeights);
+
+                        for (uint ls = 0; ls < selectedCount; ls++)
+                        {
                             float3 L;
-                            float attenuation = 1.0;
-                            if (light.type == LIGHT_TYPE_DIRECTIONAL)
-                            {
-                                L = normalize(-light.position);
-                            }
-                            else
-                            {
-                                L = normalize(light.position - hitPosition);
-                                float lightDist = length(light.position - hitPosition);
-                                // P1-1: Physical-based attenuation
-                                attenuation = ComputeAttenuationFromScene(lightDist);
-                            }
+                            float3 lightRadiance;
+                            SoftShadowResult shadow;
+                            if (!EvaluateLightEmitter(selectedEmitters[ls], selectionWeights[ls], hitPosition, N, seed, L, lightRadiance, shadow))
+                                continue;
+                            float NdotL = dot(N, L);
 
-                            float NdotL = max(dot(N, L), 0.0);
-                            if (NdotL > 0.0)
+                            if (payload.depth == 0)
                             {
-                                // P0-1 Optimization: Only calculate shadows for dominant lights
-                                SoftShadowResult shadow;
-                                bool isTopLight = IsInTopLights(li, topLights, topCount);
-                                
-                                if (isTopLight)
+                                float weight = NdotL * Luminance(lightRadiance);
+                                if (weight > bestShadowWeight)
                                 {
-                                    // Dominant light: calculate shadow with importance-based sample count
-                                    if (light.radius > 0.001)
-                                    {
-                                        // Soft shadow with adaptive samples
-                                        uint samples = ComputeShadowSamples(light, topLights, li);
-                                        // Temporarily override softShadowSamples for this calculation
-                                        LightData adjustedLight = light;
-                                        adjustedLight.softShadowSamples = (float)samples;
-                                        shadow = CalculateSoftShadow(hitPosition, N, adjustedLight, seed);
-                                    }
-                                    else
-                                    {
-                                        // Hard shadow (single ray)
-                                        shadow = CalculateSoftShadow(hitPosition, N, light, seed);
-                                    }
-                                }
-                                else
-                                {
-                                    // Non-dominant light: skip shadow calculation (direct light only)
-                                    shadow.visibility = 1.0;
-                                    shadow.penumbra = 0.0;
-                                    shadow.occluderDistance = NRD_FP16_MAX;
-                                    shadow.shadowColor = float3(1, 1, 1);
-                                }
-                                
-                                if (payload.depth == 0)
-                                {
-                                    float weight = NdotL * attenuation * light.intensity;
-                                    if (weight > bestShadowWeight)
-                                    {
-                                        bestShadowWeight = weight;
-                                        bestShadowForSigma = shadow;
-                                    }
+                                    bestShadowWeight = weight;
+                                    bestShadowForSigma = shadow;
                                 }
+                            }
 
-                                // Apply shadow to radiance (shadow baked into lighting)
-                                float shadowAmount = 1.0 - shadow.visibility;
-                                shadowAmount *= Scene.ShadowStrength;
-                                shadowAmount = saturate(shadowAmount);
-                                float adjustedVisibility = 1.0 - shadowAmount;
-                                float3 shadowColor = shadow.shadowColor;
+                            // Apply shadow to radiance (shadow baked into lighting)
+                            float shadowAmount = 1.0 - shadow.visibility;
+                            shadowAmount *= Scene.ShadowStrength;
+                            shadowAmount = saturate(shadowAmount);
+                            float adjustedVisibility = 1.0 - shadowAmount;
+                            float3 shadowColor = shadow.shadowColor;
 
-                                float3 radiance = light.color.rgb * light.intensity * attenuation * adjustedVisibility * shadowColor;
+                            float3 radiance = lightRadiance * adjustedVisibility * shadowColor;
 
-                                float3 H = normalize(V + L);
-                                float NdotV = max(dot(N, V), 0.001);
-                                float NdotH = max(dot(N, H), 0.0);
-                                float VdotH = max(dot(V, H), 0.0);
+                            float3 H = normalize(V + L);
+                            float NdotV = max(dot(N, V), 0.001);
+                            float NdotH = max(dot(N, H), 0.0);
+                            float VdotH = max(dot(V, H), 0.0);
 
-                                float3 F = Fresnel_Schlick3(VdotH, F0);
-                                float D = GGX_D(NdotH, max(roughness, 0.04));
-                                float G = Smith_G(NdotV, NdotL, roughness);
-                                float3 specBRDF = (D * G * F) / (4.0 * NdotV * NdotL + 0.001);
+                            float3 F = Fresnel_Schlick3(VdotH, F0);
+                            float D = GGX_D(NdotH, max(roughness, 0.04));
+                            float G = Smith_G(NdotV, NdotL, roughness);
+                            float3 specBRDF = (D * G * F) / (4.0 * NdotV * NdotL + 0.001);
 
-                                float3 kD = (1.0 - F) * (1.0 - metallic);
-                                float3 diffBRDF = kD * diffuseColor / PI;
+                            float3 kD = (1.0 - F) * (1.0 - metallic);
+                            float3 diffBRDF = kD * diffuseColor / PI;
 
-                                directDiffuse += diffBRDF * radiance * NdotL;
+                            directDiffuse += diffBRDF * radiance * NdotL;
+                            // Emissive surfaces are seen directly by the reflection ray; only lights add a highlight
+                            if (LightEmitters[selectedEmitters[ls]].type == LIGHT_EMITTER_LIGHT)
+                            {
                                 directSpecular += specBRDF * radiance * NdotL;
                             }
                         }
@@ -499,14 +465,26 @@ void RayGen()
 
                         ambient = lerp(diffuseColor, baseColor * 0.3, metallic) * 0.2;
                     }
+
+                    // Environment light: one importance-sampled direction for the diffuse lobe
+                    if (Scene.EnvironmentLighting != 0 && metallic < 1.0)
+                    {
+                        float3 envL;
+                        float3 envRadiance;
+                        RNG environmentRng = rng_init(launchIndex, sequenceIndex, payload.depth, RNG_SALT_ENVIRONMENT);
+                        if (EvaluateEnvironmentLight(hitPosition, N, environmentRng, envL, envRadiance))
+                        {
+                            directDiffuse += diffuseColor / PI * envRadiance * dot(N, envL);
+                        }
+                    }
                     float reflectionWeight = metallic * (1.0 - roughness * 0.5);
                     float directWeight = 1.0 - reflectionWeight * 0.5;
 
                     float3 photonCaustic = float3(0, 0, 0);
-                    if (payload.depth == 0 && metallic < 0.5 && transmission <= 0.01 && Scene.PhotonMapSize > 0)
+                    if (CAUSTICS && payload.depth == 0 && metallic < 0.5 && transmission <= 0.01 && Scene.PhotonMapSize > 0)
                     {
                         photonCaustic = GatherPhotons(hitPosition, N, Scene.PhotonRadius);
-                        if (Scene.PhotonDebugMode > 0)
+                        if (ACTIVE_PHOTON_DEBUG_MODE > 0)
                         {
                             float3 debugColor = photonCaustic * Scene.PhotonDebugScale;
                             payload.color = debugColor;
@@ -518,7 +496,7 @@ void RayGen()
                         }
                     }
 
-                    if (Scene.PhotonDebugMode == 0)
+                    if (ACTIVE_PHOTON_DEBUG_MODE == 0)
                     {
                         float3 finalColor = ambient
                                           + directDiffuse * directWeight
@@ -612,12 +590,11 @@ void RayGen()
                     
                     if (roughness > 0.01 && state.depth == 0)
                     {
-                        uint localSampleIndex = RngSampleIndex(s, state.depth);
-                        RNG reflectRng = rng_init(launchIndex, Scene.FrameIndex, localSampleIndex, RNG_SALT_REFLECT);
+                        RNG reflectRng = rng_init(launchIndex, sequenceIndex, state.depth, RNG_SALT_REFLECT);
                         reflectDir = PerturbReflection(reflectDir, N, roughness, reflectRng);
                         if (!tir)
                         {
-                            RNG refractRng = rng_init(launchIndex, Scene.FrameIndex, localSampleIndex, RNG_SALT_REFRACT);
+                            RNG refractRng = rng_init(launchIndex, sequenceIndex, state.depth, RNG_SALT_REFRACT);
                             refractDir = PerturbReflection(refractDir, -N, roughness, refractRng);
                         }
                     }
@@ -685,7 +662,6 @@ void RayGen()
                     
                     if (useRR)
                     {
-                        RNG rrRng = rng_init(launchIndex, Scene.FrameIndex, RngSampleIndex(s, state.depth), RNG_SALT_RR);
                         float rr = rng_next(rrRng);
                         bool chooseReflect = tir || (rr < (reflectWeight / max(weightSum, 1e-6)));
                         float chosenWeight = chooseReflect ? reflectWeight : refractWeight;
@@ -730,14 +706,10 @@ void RayGen()
                         child.skipObjectType = chooseReflect ? payload.hitObjectType : OBJECT_TYPE_INVALID;
                         child.skipObjectIndex = chooseReflect ? payload.hitObjectIndex : 0;
                         
-                        float maxChildThroughput = max(child.throughput.r, max(child.throughput.g, child.throughput.b));
-                        if (maxChildThroughput >= throughputThreshold || (child.pathFlags & PATH_FLAG_SPECULAR) != 0)
+                        if (queueCount < WORK_QUEUE_STRIDE)
                         {
-                            if (queueCount < WORK_QUEUE_STRIDE)
-                            {
-                                WorkQueue[baseIndex + queueCount++] = child;
-                                WorkQueueCount[pixelIndex] = queueCount;
-                            }
+                            WorkQueue[baseIndex + queueCount++] = child;
+                            WorkQueueCount[pixelIndex] = queueCount;
                         }
                     }
                     else
@@ -807,7 +779,7 @@ void RayGen()
                 {
                     float3 F0 = lerp(0.04.xxx, baseColor, metallic);
                     float3 reflectDir = reflect(state.direction, N);
-                    RNG reflectRng = rng_init(launchIndex, Scene.FrameIndex, RngSampleIndex(s, state.depth), RNG_SALT_REFLECT);
+                    RNG reflectRng = rng_init(launchIndex, sequenceIndex, state.depth, RNG_SALT_REFLECT);
                     float3 perturbedDir = PerturbReflection(reflectDir, N, roughness, reflectRng);
                     
                     float NdotV = saturate(dot(N, -state.direction));
@@ -834,14 +806,10 @@ void RayGen()
                     reflectChild.skipObjectIndex = reflectInside ? 0 : payload.hitObjectIndex;
                     reflectChild.mediumEta = state.mediumEta;
                     
-                    float maxChildThroughput = max(reflectChild.throughput.r, max(reflectChild.throughput.g, reflectChild.throughput.b));
-                    if (maxChildThroughput >= throughputThreshold || (reflectChild.pathFlags & PATH_FLAG_SPECULAR) != 0)
+                    if (queueCount < WORK_QUEUE_STRIDE)
                     {
-                        if (queueCount < WORK_QUEUE_STRIDE)
-                        {
-                            WorkQueue[baseIndex + queueCount++] = reflectChild;
-                            WorkQueueCount[pixelIndex] = queueCount;
-                        }
+                        WorkQueue[baseIndex + queueCount++] = reflectChild;
+                        WorkQueueCount[pixelIndex] = queueCount;
                     }
                 }
             }
@@ -856,12 +824,13 @@ void RayGen()
     float invSampleCount = 1.0 / float(sampleCount);
     float avgBounce = accumulatedBounce * invSampleCount;
 
-    if (Scene.PhotonDebugMode == 2)
+    if (ACTIVE_PHOTON_DEBUG_MODE == 2)
     {
         float bounceRatio = (maxBounces > 0) ? saturate(avgBounce / (float)maxBounces) : 0.0;
         float3 debugColor = bounceRatio.xxx;
         
         RenderTarget[launchIndex] = float4(debugColor, 1.0);
+#if NRD_OUTPUT
         GBuffer_DiffuseRadianceHitDist[launchIndex] = float4(debugColor, 0.0);
         GBuffer_SpecularRadianceHitDist[launchIndex] = float4(0, 0, 0, 0.0);
         GBuffer_NormalRoughness[launchIndex] = NRD_FrontEnd_PackNormalAndRoughness(float3(0, 1, 0), 1.0);
@@ -870,15 +839,17 @@ void RayGen()
         GBuffer_ShadowData[launchIndex] = float2(NRD_FP16_MAX, 1.0);
         GBuffer_ShadowTranslucency[launchIndex] = SIGMA_FrontEnd_PackTranslucency(NRD_FP16_MAX, float3(0, 0, 0));
         GBuffer_MotionVectors[launchIndex] = float2(0, 0);
+#endif
         return;
     }
     
-    if (Scene.PhotonDebugMode == 1)
+    if (ACTIVE_PHOTON_DEBUG_MODE == 1)
     {
         float3 secondaryColor = (accumulatedColor - accumulatedPrimaryColor) * invSampleCount;
         secondaryColor = max(secondaryColor, 0.0);
         
         RenderTarget[launchIndex] = float4(secondaryColor, 1.0);
+#if NRD_OUTPUT
         GBuffer_DiffuseRadianceHitDist[launchIndex] = float4(secondaryColor, 0.0);
         GBuffer_SpecularRadianceHitDist[launchIndex] = float4(0, 0, 0, 0.0);
         GBuffer_NormalRoughness[launchIndex] = NRD_FrontEnd_PackNormalAndRoughness(float3(0, 1, 0), 1.0);
@@ -887,12 +858,14 @@ void RayGen()
         GBuffer_ShadowData[launchIndex] = float2(NRD_FP16_MAX, 1.0);
         GBuffer_ShadowTranslucency[launchIndex] = SIGMA_FrontEnd_PackTranslucency(NRD_FP16_MAX, float3(0, 0, 0));
         GBuffer_MotionVectors[launchIndex] = float2(0, 0);
+#endif
         return;
     }
 
     float3 finalColor = accumulatedColor * invSampleCount;
     RenderTarget[launchIndex] = float4(finalColor, 1.0);
-    
+
+#if NRD_OUTPUT
     // For primary normal/roughness/albedo, use hit data if available, else defaults
     float3 worldNormal = anyHit ? primaryNormal : float3(0, 1, 0);
     float outRoughness = anyHit ? primaryRoughness : 1.0;
@@ -1042,4 +1015,5 @@ void RayGen()
     // Note: No damping applied - correct pixel-space motion for NRD
     // If stabilization is needed, adjust NRD settings (maxAccumulatedFrameNum, etc.)
     GBuffer_MotionVectors[launchIndex] = nrdInputs.motionVector;
+#endif
 }